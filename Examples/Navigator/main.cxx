@@ -32,7 +32,14 @@ int main(int, char** )
 
   while( !application->HasQuitted() )
   {
-    Fl::wait(0.001);
+    // Block until a GUI event arrives or the next pulse is due, instead of
+    // polling the pulse generators
+    double timeToNextPulse = igstk::PulseGenerator::GetTimeToNextPulse();
+    if( timeToNextPulse < 0.0 || timeToNextPulse > 100.0 )
+      {
+      timeToNextPulse = 100.0;
+      }
+    Fl::wait( timeToNextPulse / 1000.0 );
     igstk::PulseGenerator::CheckTimeouts();
   } 
 
@@ -32,8 +32,7 @@ int main( int argc, char *argv[] )
     b->StartTracking();
     while( 1 ) 
     {
-      igstk::PulseGenerator::Sleep( 10 );
-      igstk::PulseGenerator::CheckTimeouts();
+      igstk::PulseGenerator::WaitForPulses( 100 );
     }
     return EXIT_SUCCESS;
   }
@@ -0,0 +1,499 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    RenderingBenchmark.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// 
+//  Measure the rendering performance of View2D and View3D without a display.
+//
+//  The views are rendered offscreen through an OffScreenWidget. A CT volume,
+//  a mesh and a tube tree can be loaded, and a needle attached to a simulated
+//  tracker keeps moving during the measurements. Every scenario renders a
+//  fixed number of frames as fast as possible and reports the sustained frame
+//  rate together with the average cost of the representation updates and of
+//  the VTK rendering, as measured by the View frame timing.
+//
+//  Usage:
+//    RenderingBenchmark [-ct dicomDirectory] [-mesh meshFile.msh]
+//                       [-tubes tubeFile.tre] [-frames numberOfFrames]
+//                       [-size width height]
+//
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug 
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "igstkConfigure.h"
+#include "igstkRealTimeClock.h"
+#include "igstkPulseGenerator.h"
+#include "igstkView2D.h"
+#include "igstkView3D.h"
+#include "igstkOffScreenWidget.h"
+#include "igstkAxesObject.h"
+#include "igstkCylinderObject.h"
+#include "igstkCylinderObjectRepresentation.h"
+#include "igstkCTImageReader.h"
+#include "igstkCTImageSpatialObjectRepresentation.h"
+#include "igstkMeshReader.h"
+#include "igstkMeshObjectRepresentation.h"
+#include "igstkTubeReader.h"
+#include "igstkTubeObjectRepresentation.h"
+#include "igstkCircularSimulatedTracker.h"
+#include "igstkSimulatedTrackerTool.h"
+
+
+namespace RenderingBenchmark
+{
+
+igstkObserverObjectMacro( CTImage,
+    ::igstk::CTImageReader::ImageModifiedEvent, ::igstk::CTImageSpatialObject )
+
+igstkObserverObjectMacro( MeshObject,
+    ::igstk::MeshReader::MeshModifiedEvent, ::igstk::MeshObject )
+
+igstkObserverObjectMacro( TubeObject,
+    ::igstk::TubeReader::TubeModifiedEvent, ::igstk::TubeObject )
+
+igstkObserverMacro( SliceBounds, ::igstk::IntegerBoundsEvent,
+                    ::igstk::EventHelperType::IntegerBoundsType )
+
+/** Accumulate the frame timing reported by a View */
+class FrameTimingAccumulator : public ::itk::Command 
+{
+public:
+  typedef  FrameTimingAccumulator     Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+  itkNewMacro( Self );
+
+  void Reset()
+    {
+    m_Frames = 0;
+    m_LatencySamples = 0;
+    m_UpdateTime = 0.0;
+    m_RenderTime = 0.0;
+    m_Latency = 0.0;
+    }
+
+  void Execute( itk::Object * caller, const itk::EventObject & event )
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+
+  void Execute( const itk::Object * itkNotUsed(caller), 
+                const itk::EventObject & event )
+    {
+    const ::igstk::ViewFrameTimingEvent * timingEvent =
+      dynamic_cast< const ::igstk::ViewFrameTimingEvent * >( &event );
+    if( !timingEvent )
+      {
+      return;
+      }
+
+    const ::igstk::ViewFrameTimingType & timing = timingEvent->Get();
+    m_Frames++;
+    m_UpdateTime += timing.UpdateTime;
+    m_RenderTime += timing.RenderTime;
+    if( timing.TransformToDisplayLatency >= 0.0 )
+      {
+      m_LatencySamples++;
+      m_Latency += timing.TransformToDisplayLatency;
+      }
+    }
+
+  unsigned long  m_Frames;
+  unsigned long  m_LatencySamples;
+  double         m_UpdateTime;
+  double         m_RenderTime;
+  double         m_Latency;
+
+protected:
+  FrameTimingAccumulator() 
+    {
+    this->Reset();
+    }
+};
+
+
+/** Create the representation of the middle slice of a CT image */
+::igstk::CTImageSpatialObjectRepresentation::Pointer CreateSlice( 
+  ::igstk::CTImageSpatialObject * ctImage,
+  ::igstk::CTImageSpatialObjectRepresentation::OrientationType orientation )
+{
+  typedef ::igstk::CTImageSpatialObjectRepresentation  RepresentationType;
+
+  RepresentationType::Pointer slice = RepresentationType::New();
+  slice->RequestSetImageSpatialObject( ctImage );
+  slice->RequestSetOrientation( orientation );
+
+  SliceBoundsObserver::Pointer boundsObserver = SliceBoundsObserver::New();
+  slice->AddObserver( ::igstk::IntegerBoundsEvent(), boundsObserver );
+  slice->RequestGetSliceNumberBounds();
+  if( boundsObserver->GotSliceBounds() )
+    {
+    const ::igstk::EventHelperType::IntegerBoundsType bounds = 
+                                         boundsObserver->GetSliceBounds();
+    slice->RequestSetSliceNumber( ( bounds.minimum + bounds.maximum ) / 2 );
+    }
+
+  return slice;
+}
+
+
+/** A named set of representations displayed in one type of view */
+struct Scenario
+{
+  std::string                                        m_Name;
+  bool                                               m_Use3DView;
+  std::vector< ::igstk::ObjectRepresentation::Pointer > m_Objects;
+};
+
+}
+
+
+int main( int argc, char * argv[] )
+{
+  typedef RenderingBenchmark::Scenario                ScenarioType;
+  typedef RenderingBenchmark::FrameTimingAccumulator  AccumulatorType;
+  typedef igstk::ObjectRepresentation::Pointer        RepresentationPointer;
+
+  std::string   ctDirectory;
+  std::string   meshFileName;
+  std::string   tubeFileName;
+  unsigned int  numberOfFrames = 300;
+  int           width  = 512;
+  int           height = 512;
+
+  for( int i = 1; i < argc; i++ )
+    {
+    if( !strcmp( argv[i], "-ct" ) && i + 1 < argc )
+      {
+      ctDirectory = argv[++i];
+      }
+    else if( !strcmp( argv[i], "-mesh" ) && i + 1 < argc )
+      {
+      meshFileName = argv[++i];
+      }
+    else if( !strcmp( argv[i], "-tubes" ) && i + 1 < argc )
+      {
+      tubeFileName = argv[++i];
+      }
+    else if( !strcmp( argv[i], "-frames" ) && i + 1 < argc )
+      {
+      numberOfFrames = atoi( argv[++i] );
+      }
+    else if( !strcmp( argv[i], "-size" ) && i + 2 < argc )
+      {
+      width  = atoi( argv[++i] );
+      height = atoi( argv[++i] );
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0] 
+                << " [-ct dicomDirectory] [-mesh meshFile.msh]"
+                << " [-tubes tubeFile.tre] [-frames numberOfFrames]"
+                << " [-size width height]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  igstk::RealTimeClock::Initialize();
+
+  igstk::AxesObject::Pointer world = igstk::AxesObject::New();
+
+  igstk::Transform identity;
+  identity.SetToIdentity( igstk::TimeStamp::GetLongestPossibleTime() );
+
+  //
+  // Simulated tracker moving a needle on a circle
+  //
+  igstk::CircularSimulatedTracker::Pointer tracker = 
+                                     igstk::CircularSimulatedTracker::New();
+  tracker->RequestOpen();
+  tracker->SetRadius( 50.0 );
+  tracker->SetAngularSpeed( 45.0 );
+  tracker->RequestSetFrequency( 60.0 );
+  tracker->RequestSetTransformAndParent( identity, world );
+
+  igstk::SimulatedTrackerTool::Pointer trackerTool = 
+                                        igstk::SimulatedTrackerTool::New();
+  trackerTool->RequestSetName( "Needle" );
+  trackerTool->RequestConfigure();
+  trackerTool->RequestAttachToTracker( tracker );
+
+  igstk::CylinderObject::Pointer needle = igstk::CylinderObject::New();
+  needle->SetRadius( 1.0 );
+  needle->SetHeight( 150.0 );
+  needle->RequestSetTransformAndParent( identity, trackerTool );
+
+  std::vector< ScenarioType > scenarios;
+
+  ScenarioType needleScenario;
+  needleScenario.m_Name = "Needle3D";
+  needleScenario.m_Use3DView = true;
+  igstk::CylinderObjectRepresentation::Pointer needleRepresentation =
+                                  igstk::CylinderObjectRepresentation::New();
+  needleRepresentation->RequestSetCylinderObject( needle );
+  needleScenario.m_Objects.push_back( needleRepresentation.GetPointer() );
+  scenarios.push_back( needleScenario );
+
+  ScenarioType allScenario;
+  allScenario.m_Name = "All3D";
+  allScenario.m_Use3DView = true;
+  allScenario.m_Objects.push_back( needleRepresentation->Copy().GetPointer() );
+
+  //
+  // CT volume, shown as one axial slice in 2D and three slices in 3D
+  //
+  if( !ctDirectory.empty() )
+    {
+    igstk::CTImageReader::Pointer reader = igstk::CTImageReader::New();
+    RenderingBenchmark::CTImageObserver::Pointer ctObserver =
+                                RenderingBenchmark::CTImageObserver::New();
+    reader->AddObserver( igstk::CTImageReader::ImageModifiedEvent(), 
+                         ctObserver );
+    reader->RequestSetDirectory( ctDirectory );
+    reader->RequestReadImage();
+    reader->RequestGetImage();
+
+    if( !ctObserver->GotCTImage() )
+      {
+      std::cerr << "Could not read the CT image in " << ctDirectory 
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    igstk::CTImageSpatialObject::Pointer ctImage = ctObserver->GetCTImage();
+    ctImage->RequestSetTransformAndParent( identity, world );
+
+    typedef igstk::CTImageSpatialObjectRepresentation  CTRepresentationType;
+
+    ScenarioType ct2DScenario;
+    ct2DScenario.m_Name = "CTAxial2D";
+    ct2DScenario.m_Use3DView = false;
+
+    ScenarioType ct3DScenario;
+    ct3DScenario.m_Name = "CTSlices3D";
+    ct3DScenario.m_Use3DView = true;
+
+    const CTRepresentationType::OrientationType orientations[3] = 
+      { CTRepresentationType::Axial, 
+        CTRepresentationType::Sagittal,
+        CTRepresentationType::Coronal };
+
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      // The copies of CT representations do not keep the image, so each
+      // scenario gets its own representations.
+      ct3DScenario.m_Objects.push_back( 
+        RenderingBenchmark::CreateSlice( ctImage, orientations[i] )
+                                                           .GetPointer() );
+      allScenario.m_Objects.push_back( 
+        RenderingBenchmark::CreateSlice( ctImage, orientations[i] )
+                                                           .GetPointer() );
+      }
+
+    ct2DScenario.m_Objects.push_back( 
+      RenderingBenchmark::CreateSlice( ctImage, CTRepresentationType::Axial )
+                                                           .GetPointer() );
+
+    scenarios.push_back( ct2DScenario );
+    scenarios.push_back( ct3DScenario );
+    }
+
+  //
+  // Surface mesh
+  //
+  if( !meshFileName.empty() )
+    {
+    igstk::MeshReader::Pointer reader = igstk::MeshReader::New();
+    RenderingBenchmark::MeshObjectObserver::Pointer meshObserver =
+                             RenderingBenchmark::MeshObjectObserver::New();
+    reader->AddObserver( igstk::MeshReader::MeshModifiedEvent(), 
+                         meshObserver );
+    reader->RequestSetFileName( meshFileName );
+    reader->RequestReadObject();
+    reader->RequestGetOutput();
+
+    if( !meshObserver->GotMeshObject() )
+      {
+      std::cerr << "Could not read the mesh " << meshFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    igstk::MeshObject::Pointer mesh = meshObserver->GetMeshObject();
+    mesh->RequestSetTransformAndParent( identity, world );
+
+    igstk::MeshObjectRepresentation::Pointer meshRepresentation =
+                                     igstk::MeshObjectRepresentation::New();
+    meshRepresentation->RequestSetMeshObject( mesh );
+    meshRepresentation->SetColor( 0.9, 0.7, 0.6 );
+
+    ScenarioType meshScenario;
+    meshScenario.m_Name = "Mesh3D";
+    meshScenario.m_Use3DView = true;
+    meshScenario.m_Objects.push_back( meshRepresentation.GetPointer() );
+    scenarios.push_back( meshScenario );
+
+    allScenario.m_Objects.push_back( 
+                                  meshRepresentation->Copy().GetPointer() );
+    }
+
+  //
+  // Vessel tree
+  //
+  if( !tubeFileName.empty() )
+    {
+    igstk::TubeReader::Pointer reader = igstk::TubeReader::New();
+    RenderingBenchmark::TubeObjectObserver::Pointer tubeObserver =
+                             RenderingBenchmark::TubeObjectObserver::New();
+    reader->AddObserver( igstk::TubeReader::TubeModifiedEvent(), 
+                         tubeObserver );
+    reader->RequestSetFileName( tubeFileName );
+    reader->RequestReadObject();
+    reader->RequestGetOutput();
+
+    if( !tubeObserver->GotTubeObject() )
+      {
+      std::cerr << "Could not read the tubes " << tubeFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    igstk::TubeObject::Pointer tubes = tubeObserver->GetTubeObject();
+    tubes->RequestSetTransformAndParent( identity, world );
+
+    igstk::TubeObjectRepresentation::Pointer tubeRepresentation =
+                                     igstk::TubeObjectRepresentation::New();
+    tubeRepresentation->RequestSetTubeObject( tubes );
+    tubeRepresentation->SetColor( 0.8, 0.1, 0.1 );
+
+    ScenarioType tubeScenario;
+    tubeScenario.m_Name = "Tubes3D";
+    tubeScenario.m_Use3DView = true;
+    tubeScenario.m_Objects.push_back( tubeRepresentation.GetPointer() );
+    scenarios.push_back( tubeScenario );
+
+    allScenario.m_Objects.push_back( 
+                                  tubeRepresentation->Copy().GetPointer() );
+    }
+
+  if( allScenario.m_Objects.size() > 1 )
+    {
+    scenarios.push_back( allScenario );
+    }
+
+  tracker->RequestStartTracking();
+
+  std::cout << std::setw(12) << "Scenario" 
+            << std::setw(10) << "Frames"
+            << std::setw(10) << "FPS"
+            << std::setw(12) << "Update(ms)"
+            << std::setw(12) << "Render(ms)"
+            << std::setw(13) << "Latency(ms)" << std::endl;
+
+  std::cout.setf( std::ios::fixed );
+  std::cout.precision( 2 );
+
+  for( unsigned int s = 0; s < scenarios.size(); s++ )
+    {
+    const ScenarioType & scenario = scenarios[s];
+
+    igstk::View::Pointer view;
+    if( scenario.m_Use3DView )
+      {
+      view = igstk::View3D::New().GetPointer();
+      }
+    else
+      {
+      view = igstk::View2D::New().GetPointer();
+      }
+
+    view->RequestSetTransformAndParent( identity, world );
+
+    igstk::OffScreenWidget::Pointer widget = igstk::OffScreenWidget::New();
+    widget->RequestSetSize( width, height );
+    widget->RequestSetView( view );
+
+    for( unsigned int i = 0; i < scenario.m_Objects.size(); i++ )
+      {
+      view->RequestAddObject( scenario.m_Objects[i] );
+      }
+
+    view->RequestResetCamera();
+    view->SetFrameTimingEnabled( true );
+
+    AccumulatorType::Pointer accumulator = AccumulatorType::New();
+    view->AddObserver( igstk::ViewFrameTimingEvent(), accumulator );
+
+    // Let the first frames build the VTK pipelines and the display lists
+    for( unsigned int i = 0; i < 10; i++ )
+      {
+      igstk::PulseGenerator::CheckTimeouts();
+      widget->RequestRender();
+      }
+
+    accumulator->Reset();
+
+    const double startTime = igstk::RealTimeClock::GetTimeStamp();
+
+    for( unsigned int i = 0; i < numberOfFrames; i++ )
+      {
+      // Keep the tracker updates flowing
+      igstk::PulseGenerator::CheckTimeouts();
+      widget->RequestRender();
+      }
+
+    const double elapsed = igstk::RealTimeClock::GetTimeStamp() - startTime;
+
+    const double frames = accumulator->m_Frames > 0 ? 
+                          accumulator->m_Frames : 1.0;
+
+    std::cout << std::setw(12) << scenario.m_Name
+              << std::setw(10) << accumulator->m_Frames
+              << std::setw(10) << accumulator->m_Frames * 1000.0 / elapsed
+              << std::setw(12) << accumulator->m_UpdateTime / frames
+              << std::setw(12) << accumulator->m_RenderTime / frames;
+
+    if( accumulator->m_LatencySamples > 0 )
+      {
+      std::cout << std::setw(13) 
+                << accumulator->m_Latency / accumulator->m_LatencySamples;
+      }
+    else
+      {
+      std::cout << std::setw(13) << "-";
+      }
+    std::cout << std::endl;
+
+    for( unsigned int i = 0; i < scenario.m_Objects.size(); i++ )
+      {
+      view->RequestRemoveObject( scenario.m_Objects[i] );
+      }
+    }
+
+  tracker->RequestStopTracking();
+  tracker->RequestClose();
+
+  return EXIT_SUCCESS;
+}
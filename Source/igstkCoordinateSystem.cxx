@@ -19,6 +19,7 @@
 #include "igstkCoordinateSystemTransformToResult.h"
 #include "igstkCoordinateSystemTransformToErrorResult.h"
 #include "igstkCoordinateSystemSetTransformResult.h"
+#include "igstkTransformBatch.h"
 
 namespace igstk
 { 
@@ -373,7 +374,7 @@ void CoordinateSystem
   payload.Initialize(transform, this, this);
 
   CoordinateSystemTransformToEvent event;
-  event.Set(payload);
+  event.SetReference( payload );
 
   this->InvokeEvent( event );
 }
@@ -442,7 +443,7 @@ void CoordinateSystem
                      m_LowestCommonAncestor);
 
   CoordinateSystemTransformToEvent event;
-  event.Set( payload );
+  event.SetReference( payload );
 
   this->InvokeEvent( event );
 }
@@ -451,19 +452,40 @@ Transform
 CoordinateSystem::
 ComputeTransformTo(const CoordinateSystem* ancestor) const
 {
+  Transform identity;
+  identity.SetToIdentity(igstk::TimeStamp::GetLongestPossibleTime());
   if ( ancestor == this )
     {
-    Transform identity;
-    identity.SetToIdentity(igstk::TimeStamp::GetLongestPossibleTime());
     return identity;
     }
-  else
+
+  // Compose the transforms to the parents, from this coordinate system up
+  // to the ancestor, as poses. The errors add up and the validity is the
+  // overlap of the validities, as in Transform::TransformCompose().
+  Pose pose;
+  TransformBatch::ExportPose( this->m_TransformToParent, pose );
+  Transform::ErrorType error = this->m_TransformToParent.GetError();
+  TimeStamp timeStamp = this->m_TransformToParent.GetTimeStamp();
+
+  for( const CoordinateSystem * system = this->m_Parent;
+       system != ancestor;
+       system = system->m_Parent )
     {
-    Transform result = Transform::TransformCompose( 
-      this->m_Parent->ComputeTransformTo(ancestor),
-      this->m_TransformToParent);
-    return result;
+    const Transform & transformToParent = system->m_TransformToParent;
+    Pose parentPose;
+    TransformBatch::ExportPose( transformToParent, parentPose );
+    TransformBatch::Compose( parentPose, &pose, &pose, 1 );
+    error += transformToParent.GetError();
+    timeStamp = TimeStamp::ComputeOverlap( transformToParent.GetTimeStamp(),
+                                           timeStamp );
     }
+
+  Transform result;
+  TransformBatch::ImportPose( pose, error + identity.GetError(),
+                              TimeStamp::ComputeOverlap(
+                                identity.GetTimeStamp(), timeStamp ),
+                              result );
+  return result;
 }
 
 void CoordinateSystem
@@ -533,7 +555,7 @@ void CoordinateSystem
                      true);
 
   CoordinateSystemSetTransformEvent event;
-  event.Set( payload );
+  event.SetReference( payload );
 
   this->InvokeEvent( event );
 }
@@ -739,7 +761,7 @@ CoordinateSystem
                      false);
 
   CoordinateSystemSetTransformEvent event;
-  event.Set( payload );
+  event.SetReference( payload );
   
   // We set the parent to be NULL.
   this->m_Parent = NULL; 
@@ -20,11 +20,17 @@
 #include "igstkImageReader.h"
 
 #include "igstkEvents.h"
+#include "igstkPulseGenerator.h"
+#include "igstkMemoryMappedImageContainer.h"
 
 #include "itkImageSeriesReader.h"
 #include "itkEventObject.h"
 #include "itkGDCMImageIO.h"
 #include "itkGDCMSeriesFileNames.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
+
+#include <vector>
 
 
 namespace igstk
@@ -65,6 +71,11 @@ igstkEventMacro(DICOMImageSeriesFileNamesGeneratingErrorEvent,
 //Image reading error
 igstkEventMacro(DICOMImageReadingErrorEvent,
               DICOMImageReaderErrorEvent );
+
+// Progressive loading events. The payload of the refinement event is the
+// fraction of the slices that have been decoded.
+igstkEventMacro( DICOMImageRefinedEvent, DoubleTypeEvent );
+igstkEventMacro( DICOMImageLoadingCompletedEvent, IGSTKEvent );
   
 
 /** \class DICOMImageReader
@@ -74,6 +85,30 @@ igstkEventMacro(DICOMImageReadingErrorEvent,
  * This class should not be instantiated directly, instead the derived 
  * classes that are specific to particular image modalities should be used.
  *
+ * The slices of the series are parsed and decoded by several threads, each
+ * one pulling the next slice to read until all of them are copied into the
+ * volume. The progress and abort callbacks are still honored.
+ *
+ * When a cache directory is set, the assembled volume is stored there after
+ * being read, keyed by the UID of the series. The volume is written as raw
+ * pixels in native byte order, which can be memory mapped, next to a small
+ * text header with its geometry, the DICOM tags used by this reader and the
+ * name, size and modification time of every file of the series. Reading the
+ * same series again loads the volume from the cache in a single block, as
+ * long as none of its files has changed.
+ *
+ * In progressive mode, RequestReadImage() only decodes every few slices,
+ * given by the preview slice stride, and fills the slices in between with
+ * the nearest decoded one. The image is then available with its final
+ * geometry while a background thread decodes the remaining slices, halving
+ * the stride at every level. Each level is published on the pulses of the
+ * reader, which requires the application to call
+ * PulseGenerator::CheckTimeouts(): the slices decoded by the thread are
+ * copied into the image from the pulse, so that the representations never
+ * read pixels being written, and refresh on their next render, and a
+ * DICOMImageRefinedEvent is sent. DICOMImageLoadingCompletedEvent is sent
+ * when all the slices are decoded.
+ *
  * \image html  igstkDICOMImageReader.png  
  *           "DICOM Image Reader State Machine Diagram" 
  *
@@ -113,6 +148,40 @@ public:
   /** This method request image read */
   void RequestReadImage();
 
+  /** Number of threads decoding the slices. The default is the global
+   *  default number of threads of ITK. */
+  igstkSetMacro( NumberOfThreads, unsigned int );
+  igstkGetMacro( NumberOfThreads, unsigned int );
+
+  /** Directory holding the cached volumes. The cache is disabled when the
+   *  name is empty, which is the default. */
+  igstkSetMacro( CacheDirectory, DirectoryNameType );
+  igstkGetMacro( CacheDirectory, DirectoryNameType );
+
+  /** Keep the pixels of the volume in the raw file of the cache, mapped in
+   *  memory, instead of in the heap. The operating system then loads the
+   *  pages of the volume as they are accessed and can release them under
+   *  memory pressure without swapping. Requires a cache directory. Default
+   *  is false. */
+  igstkSetMacro( MemoryMappedCache, bool );
+  igstkGetMacro( MemoryMappedCache, bool );
+
+  /** Returns true if the last image read was loaded from the cache */
+  bool ImageLoadedFromCache() const { return m_ImageLoadedFromCache; }
+
+  /** Publish a coarse image as soon as possible and refine it in the
+   *  background. Default is false. */
+  igstkSetMacro( ProgressiveLoading, bool );
+  igstkGetMacro( ProgressiveLoading, bool );
+
+  /** Spacing between the slices decoded for the first image published in
+   *  progressive mode. Default is 8. */
+  igstkSetMacro( PreviewSliceStride, unsigned int );
+  igstkGetMacro( PreviewSliceStride, unsigned int );
+
+  /** Returns true while slices are decoded in the background */
+  bool ImageRefinementInProgress() const { return m_Refining; }
+
   /** This function should be used to request modality info */
   void RequestGetModalityInformation();
 
@@ -299,6 +368,93 @@ private:
 
   /** Variable to hold image reading error information */
   std::string             m_ImageReadingErrorInformation;
+
+  /** UID of the series being read */
+  DICOMInformationType    m_SeriesUID;
+
+  /** Assembled volume */
+  typename ImageType::Pointer   m_Image;
+
+  unsigned int            m_NumberOfThreads;
+  DirectoryNameType       m_CacheDirectory;
+  bool                    m_ImageLoadedFromCache;
+  bool                    m_MemoryMappedCache;
+
+  typedef MemoryMappedImageContainer< 
+    typename ImageType::PixelContainer::ElementIdentifier,
+    typename ImageType::PixelType >                MappedContainerType;
+
+  /** State shared with the threads loading the slices */
+  typedef typename ImageType::PointType     PointType;
+  std::vector< PointType >      m_SliceOrigins;
+  std::vector< unsigned char >  m_SliceDecoded;
+  std::vector< unsigned int >   m_SliceQueue;
+  unsigned int                  m_NextSlice;
+  unsigned int                  m_NumberOfLoadedSlices;
+  std::string                   m_SliceErrorInformation;
+  itk::SimpleFastMutexLock      m_SliceLock;
+
+  /** Read the series with several threads. Throws an exception on failure.
+   *  The tags of the first slice are left in the dictionary of m_ImageIO. */
+  void ReadSeries();
+
+  /** Read slices until there are no more left. Called by every thread. */
+  void ReadSlices( unsigned int threadId );
+
+  static ITK_THREAD_RETURN_TYPE ReadSlicesThreaderCallback( void * arg );
+
+  /** Decode, with several threads, the slices at multiples of the stride
+   *  and the last slice */
+  void ReadSliceLevel( unsigned int stride );
+
+  /** Copy the nearest decoded slice into the slices not decoded yet */
+  void FillMissingSlices();
+
+  /** Copy the staged slices of a refinement level into the image */
+  void PublishStagedSlices();
+
+  /** Progressive loading. The refinement thread decodes the remaining
+   *  levels into m_StagedSlices, in the order of m_SliceQueue, and waits
+   *  for the pulse callback to copy them into the image, which the
+   *  representations read from the thread of the application. */
+  bool                          m_ProgressiveLoading;
+  unsigned int                  m_PreviewSliceStride;
+  unsigned int                  m_RefinementStride;
+  bool                          m_RefinementAvailable;
+  bool                          m_RefinementFinished;
+  bool                          m_StopRefinement;
+  bool                          m_Refining;
+  std::vector< typename ImageType::PixelType >  m_StagedSlices;
+  itk::MultiThreader::Pointer   m_RefinementThreader;
+  int                           m_RefinementThreadID;
+
+  typedef itk::SimpleMemberCommand< Self >  PulseObserverType;
+
+  PulseGenerator::Pointer                   m_PulseGenerator;
+  typename PulseObserverType::Pointer       m_PulseObserver;
+
+  void RefineSeries();
+
+  static ITK_THREAD_RETURN_TYPE RefinementThreadFunction( void * pInfo );
+
+  void RefinementPulseCallback();
+
+  /** Stop and join the refinement thread */
+  void StopRefinement();
+
+  /** Size, modification time and name of a file of the series, used to
+   *  detect changes of the series since it was cached */
+  std::string GetFileSignature( const std::string & fileName ) const;
+
+  /** Name of a file of the cache for the current series */
+  std::string GetCacheFileName( const char * extension ) const;
+
+  /** Load the current series from the cache. Returns false if it is not
+   *  cached or if any of its files has changed since. */
+  bool ReadCachedImage( itk::MetaDataDictionary & dict );
+
+  /** Store the current volume and the tags of dict in the cache */
+  void WriteCachedImage( const itk::MetaDataDictionary & dict );
 };
 
 } // end namespace igstk
@@ -21,6 +21,13 @@
 
 #include "itksys/SystemTools.hxx"
 #include "itksys/Directory.hxx"
+#include "itkByteSwapper.h"
+#include "itkMetaDataObject.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
 
 namespace igstk
 { 
@@ -416,6 +423,29 @@ DICOMImageReader<TPixelType>::DICOMImageReader() : m_StateMachine(this)
 
   // Initialize the booleas for the preconditions of the unsafe Get macros 
   m_FileSuccessfullyRead = false;
+  m_ImageLoadedFromCache = false;
+  m_MemoryMappedCache = false;
+
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_NextSlice = 0;
+  m_NumberOfLoadedSlices = 0;
+
+  m_ProgressiveLoading = false;
+  m_PreviewSliceStride = 8;
+  m_RefinementStride = 1;
+  m_RefinementAvailable = false;
+  m_RefinementFinished = false;
+  m_StopRefinement = false;
+  m_Refining = false;
+  m_RefinementThreader = itk::MultiThreader::New();
+  m_RefinementThreadID = -1;
+
+  m_PulseGenerator = PulseGenerator::New();
+  m_PulseObserver = PulseObserverType::New();
+  m_PulseObserver->SetCallbackFunction( this,
+                                        & Self::RefinementPulseCallback );
+  m_PulseGenerator->AddObserver( PulseEvent(), m_PulseObserver );
+  m_PulseGenerator->RequestSetFrequency( 20 );
 
   // Create the DICOM GDCM file reader
   m_FileNames = itk::GDCMSeriesFileNames::New();
@@ -446,7 +476,8 @@ DICOMImageReader<TPixelType>::DICOMImageReader() : m_StateMachine(this)
 template <class TPixelType>
 DICOMImageReader<TPixelType>::~DICOMImageReader()  
 {
-
+  // Do not leave the refinement thread running on a destroyed object
+  this->StopRefinement();
 }
 
 template <class TImageSpatialObject>
@@ -580,6 +611,8 @@ void DICOMImageReader<TPixelType>::ReadDirectoryFileNamesProcessing()
   igstkLogMacro( DEBUG, "igstk::DICOMImageReader will open seriesUID: " 
                                           << seriesUID.front().c_str() << "\n");
                             
+  m_SeriesUID = seriesUID.front();
+
   m_ImageSeriesReader->SetFileNames( m_FileNames->GetFileNames( 
                                                  seriesUID.front().c_str() )  );
   
@@ -596,26 +629,45 @@ void DICOMImageReader<TPixelType>::AttemptReadImageProcessing()
   igstkLogMacro( DEBUG, 
                  "igstk::DICOMImageReader::AttemptReadImage called...\n" );
 
-  try
+  m_ImageLoadedFromCache = false;
+
+  itk::MetaDataDictionary cachedDictionary;
+
+  if( !m_CacheDirectory.empty() && this->ReadCachedImage( cachedDictionary ) )
     {
-    m_ImageSeriesReader->UpdateLargestPossibleRegion();
-    m_ImageSeriesReader->Update();
+    igstkLogMacro( DEBUG, 
+    "igstk::DICOMImageReader - Image loaded from the cache.\n" );
+    m_ImageLoadedFromCache = true;
     }
-  catch( itk::ExceptionObject & excp )
+  else
     {
-    igstkLogMacro( DEBUG, 
-    "igstk::DICOMImageReader - Failed to update image series reader.\n" );
-    this->m_ImageReadingErrorInformation = excp.GetDescription();
-    igstkLogMacro( DEBUG,"ITK Exception:"+ m_ImageReadingErrorInformation );
-    this->m_StateMachine.PushInput( this->m_ImageReadingErrorInput );
-    this->m_StateMachine.ProcessInputs();
-    return;
+    try
+      {
+      this->ReadSeries();
+      }
+    catch( itk::ExceptionObject & excp )
+      {
+      igstkLogMacro( DEBUG, 
+      "igstk::DICOMImageReader - Failed to read the image series.\n" );
+      this->m_ImageReadingErrorInformation = excp.GetDescription();
+      igstkLogMacro( DEBUG,"ITK Exception:"+ m_ImageReadingErrorInformation );
+      this->m_StateMachine.PushInput( this->m_ImageReadingErrorInput );
+      this->m_StateMachine.ProcessInputs();
+      return;
+      }
+
+    // A progressive read is cached once all its slices are decoded
+    if( !m_CacheDirectory.empty() && !m_Refining )
+      {
+      this->WriteCachedImage( m_ImageIO->GetMetaDataDictionary() );
+      }
     }
 
   // Check if the DICOM image has a gantry tilt or not 
   std::string tagkey;
 
-  itk::MetaDataDictionary & dict = m_ImageIO->GetMetaDataDictionary();
+  itk::MetaDataDictionary & dict = m_ImageLoadedFromCache ? 
+                     cachedDictionary : m_ImageIO->GetMetaDataDictionary();
  
   tagkey = "0018|1120";
 
@@ -702,6 +754,862 @@ void DICOMImageReader<TPixelType>::AttemptReadImageProcessing()
   m_FileSuccessfullyRead = true;
 }
 
+/** Read the slices of the series with several threads */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::ReadSeries()
+{
+  typedef typename ImageSeriesReaderType::FileNamesContainer 
+                                                         FileNamesContainer;
+  const FileNamesContainer & fileNames = m_ImageSeriesReader->GetFileNames();
+  const unsigned int numberOfSlices = 
+                               static_cast< unsigned int >( fileNames.size() );
+
+  if( numberOfSlices == 0 )
+    {
+    throw itk::ExceptionObject( __FILE__, __LINE__, 
+                                "The series does not have any file",
+                                ITK_LOCATION );
+    }
+
+  // The first slice gives the size and the in-plane geometry of the volume,
+  // and leaves its tags in the dictionary of m_ImageIO.
+  m_ImageFileReader->SetFileName( fileNames[0] );
+  m_ImageFileReader->UpdateLargestPossibleRegion();
+
+  typename ImageType::Pointer firstSlice = m_ImageFileReader->GetOutput();
+  firstSlice->DisconnectPipeline();
+
+  if( numberOfSlices == 1 )
+    {
+    m_Image = firstSlice;
+    m_ImageSeriesReader->UpdateProgress( 1.0 );
+    return;
+    }
+
+  typename ImageType::SizeType size = 
+                               firstSlice->GetLargestPossibleRegion().GetSize();
+  if( size[2] != 1 )
+    {
+    throw itk::ExceptionObject( __FILE__, __LINE__, 
+                                "The series contains multi-frame files",
+                                ITK_LOCATION );
+    }
+  size[2] = numberOfSlices;
+
+  typename ImageType::RegionType region;
+  region.SetSize( size );
+
+  m_Image = ImageType::New();
+  m_Image->SetRegions( region );
+  m_Image->SetSpacing( firstSlice->GetSpacing() );
+  m_Image->SetOrigin( firstSlice->GetOrigin() );
+  m_Image->SetDirection( firstSlice->GetDirection() );
+
+  // With a memory mapped cache the slices are decoded straight into the raw
+  // file of the cache. The header is removed until the volume is complete.
+  bool mapped = false;
+  if( m_MemoryMappedCache && !m_CacheDirectory.empty() )
+    {
+    const std::string headerFileName = this->GetCacheFileName( ".hdr" );
+    const std::string rawFileName = this->GetCacheFileName( ".raw" );
+
+    itksys::SystemTools::MakeDirectory( m_CacheDirectory.c_str() );
+    itksys::SystemTools::RemoveFile( headerFileName.c_str() );
+
+    // Other readers may still map the previous file, it is unlinked rather
+    // than truncated under them.
+    itksys::SystemTools::RemoveFile( rawFileName.c_str() );
+
+    typename MappedContainerType::Pointer container = 
+                                                  MappedContainerType::New();
+    if( container->CreateFile( rawFileName, region.GetNumberOfPixels() ) )
+      {
+      m_Image->SetPixelContainer( container );
+      mapped = true;
+      }
+    else
+      {
+      igstkLogMacro( WARNING, 
+          "igstk::DICOMImageReader - Failed to map the cached volume "
+          << rawFileName << ", the volume is loaded in memory.\n" );
+      }
+    }
+
+  if( !mapped )
+    {
+    m_Image->Allocate();
+    }
+
+  const unsigned long slicePixels = size[0] * size[1];
+  std::copy( firstSlice->GetBufferPointer(), 
+             firstSlice->GetBufferPointer() + slicePixels, 
+             m_Image->GetBufferPointer() );
+
+  m_SliceOrigins.assign( numberOfSlices, firstSlice->GetOrigin() );
+  m_SliceDecoded.assign( numberOfSlices, 0 );
+  m_SliceDecoded[0] = 1;
+  m_NumberOfLoadedSlices = 1;
+  m_SliceErrorInformation = "";
+
+  // In progressive mode only every few slices are decoded before returning,
+  // the rest is decoded by the refinement thread.
+  unsigned int stride = 1;
+  if( m_ProgressiveLoading )
+    {
+    stride = std::max( 1u, m_PreviewSliceStride );
+    }
+
+  this->ReadSliceLevel( stride );
+
+  if( !m_SliceErrorInformation.empty() )
+    {
+    m_Image = NULL;
+    throw itk::ExceptionObject( __FILE__, __LINE__, 
+                                m_SliceErrorInformation.c_str(),
+                                ITK_LOCATION );
+    }
+
+  if( m_ImageSeriesReader->GetAbortGenerateData() )
+    {
+    m_Image = NULL;
+    m_ImageSeriesReader->InvokeEvent( itk::AbortEvent() );
+    throw itk::ProcessAborted( __FILE__, __LINE__ );
+    }
+
+  // Spacing and direction across the slices are taken from the positions of
+  // the first and the last slices, as the image series reader does. Both
+  // are part of every level.
+  typename ImageType::PointType::VectorType sliceVector = 
+                     m_SliceOrigins[numberOfSlices-1] - m_SliceOrigins[0];
+  const double sliceDistance = sliceVector.GetNorm();
+
+  if( sliceDistance > 1e-6 )
+    {
+    typename ImageType::SpacingType spacing = m_Image->GetSpacing();
+    typename ImageType::DirectionType direction = m_Image->GetDirection();
+
+    spacing[2] = sliceDistance / ( numberOfSlices - 1 );
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      direction[i][2] = sliceVector[i] / sliceDistance;
+      }
+
+    m_Image->SetSpacing( spacing );
+    m_Image->SetDirection( direction );
+    }
+
+  if( stride == 1 )
+    {
+    m_ImageSeriesReader->UpdateProgress( 1.0 );
+    return;
+    }
+
+  this->FillMissingSlices();
+
+  m_RefinementStride = stride;
+  m_RefinementAvailable = false;
+  m_RefinementFinished = false;
+  m_StopRefinement = false;
+
+  m_Refining = true;
+  m_RefinementThreadID = m_RefinementThreader->SpawnThread( 
+                                            RefinementThreadFunction, this );
+  m_PulseGenerator->RequestStart();
+}
+
+/** Decode the slices at multiples of the stride, and the last one */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::ReadSliceLevel( unsigned int stride )
+{
+  const unsigned int numberOfSlices = 
+                  static_cast< unsigned int >( m_SliceDecoded.size() );
+
+  m_SliceQueue.clear();
+  for( unsigned int slice = 0; slice < numberOfSlices; slice++ )
+    {
+    if( !m_SliceDecoded[slice] && 
+        ( slice % stride == 0 || slice == numberOfSlices - 1 ) )
+      {
+      m_SliceQueue.push_back( slice );
+      }
+    }
+
+  if( m_SliceQueue.empty() )
+    {
+    return;
+    }
+
+  m_NextSlice = 0;
+
+  // The image is published while refining, the slices are decoded aside
+  if( m_Refining )
+    {
+    const typename ImageType::SizeType size = 
+                                  m_Image->GetLargestPossibleRegion().GetSize();
+    m_StagedSlices.resize( m_SliceQueue.size() * size[0] * size[1] );
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( std::max( 1u, 
+       std::min( m_NumberOfThreads, 
+                 static_cast< unsigned int >( m_SliceQueue.size() ) ) ) );
+  threader->SetSingleMethod( ReadSlicesThreaderCallback, this );
+  threader->SingleMethodExecute();
+}
+
+/** Copy the nearest decoded slice into every slice not decoded yet */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::FillMissingSlices()
+{
+  typedef typename ImageType::PixelType                  PixelType;
+
+  const int numberOfSlices = static_cast< int >( m_SliceDecoded.size() );
+  const typename ImageType::SizeType size = 
+                                  m_Image->GetLargestPossibleRegion().GetSize();
+  const unsigned long slicePixels = size[0] * size[1];
+  PixelType * buffer = m_Image->GetBufferPointer();
+
+  int previous = 0;
+  for( int slice = 0; slice < numberOfSlices; slice++ )
+    {
+    if( m_SliceDecoded[slice] )
+      {
+      previous = slice;
+      continue;
+      }
+
+    int next = slice + 1;
+    while( next < numberOfSlices && !m_SliceDecoded[next] )
+      {
+      next++;
+      }
+
+    const int source = 
+      ( next < numberOfSlices && next - slice < slice - previous ) ? next 
+                                                                  : previous;
+
+    std::copy( buffer + source * slicePixels, 
+               buffer + ( source + 1 ) * slicePixels,
+               buffer + slice * slicePixels );
+    }
+}
+
+/** Copy the slices decoded by a refinement level into the image, and
+ *  the nearest decoded slice into the slices still missing. Called from
+ *  the thread of the application while the refinement thread waits. */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::PublishStagedSlices()
+{
+  const typename ImageType::SizeType size = 
+                                  m_Image->GetLargestPossibleRegion().GetSize();
+  const unsigned long slicePixels = size[0] * size[1];
+  typename ImageType::PixelType * buffer = m_Image->GetBufferPointer();
+
+  const unsigned int numberOfQueuedSlices = 
+                          static_cast< unsigned int >( m_SliceQueue.size() );
+  for( unsigned int i = 0; i < numberOfQueuedSlices; i++ )
+    {
+    const unsigned int slice = m_SliceQueue[i];
+    if( m_SliceDecoded[slice] )
+      {
+      std::copy( &m_StagedSlices[0] + i * slicePixels,
+                 &m_StagedSlices[0] + ( i + 1 ) * slicePixels,
+                 buffer + slice * slicePixels );
+      }
+    }
+
+  if( m_RefinementStride > 1 )
+    {
+    this->FillMissingSlices();
+    }
+}
+
+/** Read slices until all of them are taken. Every thread decodes with its
+ *  own reader and image IO. */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::ReadSlices( unsigned int threadId )
+{
+  typedef typename ImageSeriesReaderType::FileNamesContainer 
+                                                         FileNamesContainer;
+  typedef typename ImageType::PixelType                  PixelType;
+
+  const FileNamesContainer & fileNames = m_ImageSeriesReader->GetFileNames();
+  const unsigned int numberOfSlices = 
+                               static_cast< unsigned int >( fileNames.size() );
+  const unsigned int numberOfQueuedSlices = 
+                          static_cast< unsigned int >( m_SliceQueue.size() );
+
+  itk::GDCMImageIO::Pointer imageIO = itk::GDCMImageIO::New();
+  imageIO->SetGlobalWarningDisplay( this->GetGlobalWarningDisplay() );
+
+  typename ImageReaderType::Pointer reader = ImageReaderType::New();
+  reader->SetImageIO( imageIO );
+
+  const typename ImageType::SizeType size = 
+                                  m_Image->GetLargestPossibleRegion().GetSize();
+  const unsigned long slicePixels = size[0] * size[1];
+  PixelType * buffer = m_Image->GetBufferPointer();
+
+  while( true )
+    {
+    m_SliceLock.Lock();
+    const bool stop = !m_SliceErrorInformation.empty() ||
+                      m_StopRefinement ||
+                      m_ImageSeriesReader->GetAbortGenerateData() ||
+                      m_NextSlice >= numberOfQueuedSlices;
+    unsigned int slice = 0;
+    unsigned int queuedSlice = 0;
+    if( !stop )
+      {
+      queuedSlice = m_NextSlice++;
+      slice = m_SliceQueue[queuedSlice];
+      }
+    m_SliceLock.Unlock();
+
+    if( stop )
+      {
+      break;
+      }
+
+    std::string errorInformation;
+
+    try
+      {
+      reader->SetFileName( fileNames[slice] );
+      reader->UpdateLargestPossibleRegion();
+      }
+    catch( itk::ExceptionObject & excp )
+      {
+      errorInformation = excp.GetDescription();
+      }
+
+    const ImageType * image = reader->GetOutput();
+
+    if( errorInformation.empty() )
+      {
+      const typename ImageType::SizeType sliceSize = 
+                                   image->GetLargestPossibleRegion().GetSize();
+      if( sliceSize[0] != size[0] || sliceSize[1] != size[1] || 
+          sliceSize[2] != 1 )
+        {
+        errorInformation = "The slices of the series have different sizes";
+        }
+      }
+
+    if( !errorInformation.empty() )
+      {
+      m_SliceLock.Lock();
+      if( m_SliceErrorInformation.empty() )
+        {
+        m_SliceErrorInformation = errorInformation;
+        }
+      m_SliceLock.Unlock();
+      break;
+      }
+
+    PixelType * destination = m_Refining ? 
+      &m_StagedSlices[0] + queuedSlice * slicePixels :
+      buffer + slice * slicePixels;
+    std::copy( image->GetBufferPointer(), 
+               image->GetBufferPointer() + slicePixels,
+               destination );
+
+    m_SliceOrigins[slice] = image->GetOrigin();
+    m_SliceDecoded[slice] = 1;
+
+    m_SliceLock.Lock();
+    const unsigned int loadedSlices = ++m_NumberOfLoadedSlices;
+    m_SliceLock.Unlock();
+
+    // Progress is reported by the calling thread only, like ITK filters do.
+    // While refining in the background, it is reported on the pulses.
+    if( threadId == 0 && !m_Refining )
+      {
+      m_ImageSeriesReader->UpdateProgress( 
+                   static_cast< float >( loadedSlices ) / numberOfSlices );
+      }
+    }
+}
+
+template <class TPixelType>
+ITK_THREAD_RETURN_TYPE
+DICOMImageReader<TPixelType>::ReadSlicesThreaderCallback( void * arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct  ThreadInfoType;
+  ThreadInfoType * info = static_cast< ThreadInfoType * >( arg );
+  Self * self = static_cast< Self * >( info->UserData );
+
+  self->ReadSlices( info->ThreadID );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Decode the remaining slices level by level, halving the stride. Runs in
+ *  the refinement thread. */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::RefineSeries()
+{
+  unsigned int stride = m_RefinementStride;
+
+  while( stride > 1 )
+    {
+    stride /= 2;
+
+    this->ReadSliceLevel( stride );
+
+    m_SliceLock.Lock();
+    const bool stop = !m_SliceErrorInformation.empty() || m_StopRefinement ||
+                      m_ImageSeriesReader->GetAbortGenerateData();
+    m_SliceLock.Unlock();
+
+    if( stop )
+      {
+      break;
+      }
+
+    m_SliceLock.Lock();
+    m_RefinementStride = stride;
+    m_RefinementAvailable = true;
+    m_SliceLock.Unlock();
+
+    // The staged slices are reused by the next level once the pulse
+    // callback copied them into the image
+    bool published = false;
+    while( !published )
+      {
+      itksys::SystemTools::Delay( 1 );
+      m_SliceLock.Lock();
+      published = !m_RefinementAvailable || m_StopRefinement;
+      m_SliceLock.Unlock();
+      }
+    }
+
+  m_SliceLock.Lock();
+  m_RefinementFinished = true;
+  m_SliceLock.Unlock();
+}
+
+template <class TPixelType>
+ITK_THREAD_RETURN_TYPE
+DICOMImageReader<TPixelType>::RefinementThreadFunction( void * pInfo )
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfoStruct = 
+    ( struct itk::MultiThreader::ThreadInfoStruct* ) pInfo;
+
+  Self * self = static_cast< Self * >( pInfoStruct->UserData );
+
+  self->RefineSeries();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Publish the refinements of the image. Called on the pulses, in the
+ *  thread of the application. */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::RefinementPulseCallback()
+{
+  if( !m_Refining )
+    {
+    return;
+    }
+
+  m_SliceLock.Lock();
+  const bool available = m_RefinementAvailable;
+  const bool finished = m_RefinementFinished;
+  const unsigned int loadedSlices = m_NumberOfLoadedSlices;
+  const std::string errorInformation = m_SliceErrorInformation;
+  m_SliceLock.Unlock();
+
+  const double fraction = 
+    static_cast< double >( loadedSlices ) / m_SliceDecoded.size();
+
+  m_ImageSeriesReader->UpdateProgress( static_cast< float >( fraction ) );
+
+  if( available )
+    {
+    // The refinement thread waits while the slices are copied
+    this->PublishStagedSlices();
+
+    m_SliceLock.Lock();
+    m_RefinementAvailable = false;
+    m_SliceLock.Unlock();
+
+    // The pixels changed in place, this brings the VTK pipelines of the
+    // representations up to date on their next render.
+    m_Image->Modified();
+    this->Superclass::ConnectImage();
+
+    DICOMImageRefinedEvent event;
+    event.Set( fraction );
+    this->InvokeEvent( event );
+    }
+
+  if( !finished )
+    {
+    return;
+    }
+
+  this->StopRefinement();
+
+  if( !errorInformation.empty() )
+    {
+    this->m_ImageReadingErrorInformation = errorInformation;
+    DICOMImageReadingErrorEvent event;
+    event.Set( errorInformation );
+    this->InvokeEvent( event );
+    return;
+    }
+
+  if( loadedSlices < m_SliceDecoded.size() )
+    {
+    // Aborted
+    return;
+    }
+
+  if( !m_CacheDirectory.empty() )
+    {
+    this->WriteCachedImage( m_ImageIO->GetMetaDataDictionary() );
+    }
+
+  this->InvokeEvent( DICOMImageLoadingCompletedEvent() );
+}
+
+/** Stop and join the refinement thread */
+template <class TPixelType>
+void DICOMImageReader<TPixelType>::StopRefinement()
+{
+  m_PulseGenerator->RequestStop();
+
+  if( !m_Refining )
+    {
+    return;
+    }
+
+  m_SliceLock.Lock();
+  m_StopRefinement = true;
+  m_SliceLock.Unlock();
+
+  m_RefinementThreader->TerminateThread( m_RefinementThreadID );
+  m_Refining = false;
+
+  std::vector< typename ImageType::PixelType >().swap( m_StagedSlices );
+}
+
+/** Signature of a file of the series */
+template <class TPixelType>
+std::string
+DICOMImageReader<TPixelType>
+::GetFileSignature( const std::string & fileName ) const
+{
+  std::ostringstream signature;
+  signature << itksys::SystemTools::FileLength( fileName.c_str() ) << " "
+            << itksys::SystemTools::ModifiedTime( fileName.c_str() ) << " "
+            << itksys::SystemTools::GetFilenameName( fileName );
+  return signature.str();
+}
+
+/** Name of a file of the cache */
+template <class TPixelType>
+std::string
+DICOMImageReader<TPixelType>
+::GetCacheFileName( const char * extension ) const
+{
+  std::string name = m_SeriesUID;
+  for( std::string::size_type i = 0; i < name.size(); i++ )
+    {
+    if( !isalnum( name[i] ) && name[i] != '.' && name[i] != '-' )
+      {
+      name[i] = '_';
+      }
+    }
+  return m_CacheDirectory + "/" + name + extension;
+}
+
+/** Load the volume from the cache */
+template <class TPixelType>
+bool
+DICOMImageReader<TPixelType>
+::ReadCachedImage( itk::MetaDataDictionary & dict )
+{
+  typedef typename ImageType::PixelType  PixelType;
+
+  std::ifstream header( this->GetCacheFileName( ".hdr" ).c_str() );
+  if( !header )
+    {
+    return false;
+    }
+
+  std::string key;
+  unsigned int version = 0;
+  header >> key >> version;
+  if( key != "IGSTKVolumeCache" || version != 1 )
+    {
+    return false;
+    }
+
+  std::string seriesUID;
+  unsigned int pixelSize = 0;
+  int bigEndian = -1;
+  typename ImageType::SizeType size;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType origin;
+  typename ImageType::DirectionType direction;
+  std::vector< std::string > files;
+
+  size.Fill( 0 );
+
+  while( header >> key )
+    {
+    if( key == "SeriesUID" )
+      {
+      header >> seriesUID;
+      }
+    else if( key == "PixelSize" )
+      {
+      header >> pixelSize;
+      }
+    else if( key == "BigEndian" )
+      {
+      header >> bigEndian;
+      }
+    else if( key == "Size" )
+      {
+      header >> size[0] >> size[1] >> size[2];
+      }
+    else if( key == "Spacing" )
+      {
+      header >> spacing[0] >> spacing[1] >> spacing[2];
+      }
+    else if( key == "Origin" )
+      {
+      header >> origin[0] >> origin[1] >> origin[2];
+      }
+    else if( key == "Direction" )
+      {
+      for( unsigned int i = 0; i < 3; i++ )
+        {
+        for( unsigned int j = 0; j < 3; j++ )
+          {
+          header >> direction[i][j];
+          }
+        }
+      }
+    else if( key == "Tag" )
+      {
+      std::string tag;
+      std::string value;
+      header >> tag;
+      std::getline( header, value );
+      if( !value.empty() && value[0] == ' ' )
+        {
+        value.erase( 0, 1 );
+        }
+      itk::EncapsulateMetaData< std::string >( dict, tag, value );
+      }
+    else if( key == "File" )
+      {
+      std::string file;
+      std::getline( header, file );
+      if( !file.empty() && file[0] == ' ' )
+        {
+        file.erase( 0, 1 );
+        }
+      files.push_back( file );
+      }
+    else
+      {
+      return false;
+      }
+    }
+
+  if( seriesUID != m_SeriesUID || pixelSize != sizeof( PixelType ) ||
+      bigEndian != ( itk::ByteSwapper< int >::SystemIsBigEndian() ? 1 : 0 ) )
+    {
+    return false;
+    }
+
+  // The series must not have changed since it was cached
+  const std::vector< std::string > & fileNames = 
+                                          m_ImageSeriesReader->GetFileNames();
+  if( files.size() != fileNames.size() )
+    {
+    return false;
+    }
+  for( unsigned int i = 0; i < fileNames.size(); i++ )
+    {
+    if( files[i] != this->GetFileSignature( fileNames[i] ) )
+      {
+      return false;
+      }
+    }
+
+  const std::string rawFileName = this->GetCacheFileName( ".raw" );
+  const unsigned long numberOfBytes = 
+                        size[0] * size[1] * size[2] * sizeof( PixelType );
+  if( numberOfBytes == 0 || 
+      itksys::SystemTools::FileLength( rawFileName.c_str() ) != numberOfBytes )
+    {
+    return false;
+    }
+
+  typename ImageType::RegionType region;
+  region.SetSize( size );
+
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->SetDirection( direction );
+
+  // A mapped volume is copy-on-write, so the cache is never modified through
+  // the image.
+  typename MappedContainerType::Pointer container;
+  if( m_MemoryMappedCache )
+    {
+    container = MappedContainerType::New();
+    if( !container->MapFile( rawFileName, true ) )
+      {
+      container = NULL;
+      }
+    }
+
+  if( container )
+    {
+    image->SetPixelContainer( container );
+    }
+  else
+    {
+    image->Allocate();
+
+    std::ifstream raw( rawFileName.c_str(), std::ios::binary );
+    raw.read( reinterpret_cast< char * >( image->GetBufferPointer() ),
+              numberOfBytes );
+    if( !raw )
+      {
+      return false;
+      }
+    }
+
+  m_Image = image;
+  m_ImageSeriesReader->UpdateProgress( 1.0 );
+
+  return true;
+}
+
+/** Store the volume in the cache */
+template <class TPixelType>
+void
+DICOMImageReader<TPixelType>
+::WriteCachedImage( const itk::MetaDataDictionary & dict )
+{
+  typedef typename ImageType::PixelType  PixelType;
+
+  const std::string headerFileName = this->GetCacheFileName( ".hdr" );
+  const std::string rawFileName = this->GetCacheFileName( ".raw" );
+
+  itksys::SystemTools::MakeDirectory( m_CacheDirectory.c_str() );
+
+  // The header is written last, so that an interrupted write never leaves a
+  // header describing an incomplete volume.
+  itksys::SystemTools::RemoveFile( headerFileName.c_str() );
+
+  const typename ImageType::SizeType size = 
+                                  m_Image->GetLargestPossibleRegion().GetSize();
+  const unsigned long numberOfBytes = 
+                        size[0] * size[1] * size[2] * sizeof( PixelType );
+
+  // A volume decoded into the mapped raw file only needs to reach the disk
+  MappedContainerType * mappedContainer = 
+    dynamic_cast< MappedContainerType * >( m_Image->GetPixelContainer() );
+
+  if( mappedContainer && mappedContainer->IsFileShared() &&
+      mappedContainer->GetFileName() == rawFileName )
+    {
+    if( !mappedContainer->Flush() )
+      {
+      igstkLogMacro( WARNING, 
+          "igstk::DICOMImageReader - Failed to write the cached volume "
+          << rawFileName << "\n" );
+      return;
+      }
+    }
+  else
+    {
+    // Other readers may map the previous file, it is unlinked rather than
+    // truncated under them.
+    itksys::SystemTools::RemoveFile( rawFileName.c_str() );
+
+    std::ofstream raw( rawFileName.c_str(), std::ios::binary );
+    raw.write( reinterpret_cast< const char * >( m_Image->GetBufferPointer() ),
+               numberOfBytes );
+    raw.close();
+    if( raw.fail() )
+      {
+      igstkLogMacro( WARNING, 
+          "igstk::DICOMImageReader - Failed to write the cached volume "
+          << rawFileName << "\n" );
+      return;
+      }
+    }
+
+  std::ofstream header( headerFileName.c_str() );
+  header.precision( 17 );
+
+  header << "IGSTKVolumeCache 1\n";
+  header << "SeriesUID " << m_SeriesUID << "\n";
+  header << "PixelSize " << sizeof( PixelType ) << "\n";
+  header << "BigEndian " 
+         << ( itk::ByteSwapper< int >::SystemIsBigEndian() ? 1 : 0 ) << "\n";
+  header << "Size " << size[0] << " " << size[1] << " " << size[2] << "\n";
+
+  const typename ImageType::SpacingType & spacing = m_Image->GetSpacing();
+  header << "Spacing " << spacing[0] << " " << spacing[1] << " " 
+         << spacing[2] << "\n";
+
+  const typename ImageType::PointType & origin = m_Image->GetOrigin();
+  header << "Origin " << origin[0] << " " << origin[1] << " " 
+         << origin[2] << "\n";
+
+  const typename ImageType::DirectionType & direction = 
+                                                    m_Image->GetDirection();
+  header << "Direction";
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    for( unsigned int j = 0; j < 3; j++ )
+      {
+      header << " " << direction[i][j];
+      }
+    }
+  header << "\n";
+
+  // Tags checked by the reader
+  const char * tags[] = { "0018|1120", "0008|0060", "0010|0010", "0010|0020" };
+  for( unsigned int t = 0; t < 4; t++ )
+    {
+    std::string value;
+    if( itk::ExposeMetaData< std::string >( dict, tags[t], value ) )
+      {
+      header << "Tag " << tags[t] << " " << value << "\n";
+      }
+    }
+
+  const std::vector< std::string > & fileNames = 
+                                          m_ImageSeriesReader->GetFileNames();
+  for( unsigned int i = 0; i < fileNames.size(); i++ )
+    {
+    header << "File " << this->GetFileSignature( fileNames[i] ) << "\n";
+    }
+
+  header.close();
+  if( header.fail() )
+    {
+    itksys::SystemTools::RemoveFile( headerFileName.c_str() );
+    igstkLogMacro( WARNING, 
+        "igstk::DICOMImageReader - Failed to write the cache header "
+        << headerFileName << "\n" );
+    }
+}
+
 /* This function reports invalid requests */
 template <class TPixelType>
 void
@@ -720,6 +1628,8 @@ DICOMImageReader<TPixelType>::ResetReaderProcessing()
 {
   igstkLogMacro( DEBUG, "igstk::DICOMImageReader::ResetReader called...\n" );
 
+  this->StopRefinement();
+
   m_FileSuccessfullyRead = false;
 }
 
@@ -802,6 +1712,9 @@ DICOMImageReader<TPixelType>::ReportImageReadingErrorProcessing()
   igstkLogMacro( DEBUG, 
             "igstk::DICOMImageReader::ReportImageReadingError: called...\n");
 
+  // The image may have been rejected after a progressive read started
+  this->StopRefinement();
+
   DICOMImageReadingErrorEvent event;
   event.Set ( this->m_ImageReadingErrorInformation );
   this->InvokeEvent( event );
@@ -866,11 +1779,7 @@ template <class TPixelType>
 const typename DICOMImageReader< TPixelType >::ImageType *
 DICOMImageReader<TPixelType>::GetITKImage() const
 {
-  if(m_ImageSeriesReader->GetFileNames().size()>1)
-    {
-    return m_ImageSeriesReader->GetOutput();
-    }
-  return m_ImageFileReader->GetOutput();
+  return m_Image;
 }
 
 /** Check modality type */
@@ -895,6 +1804,14 @@ void DICOMImageReader<TPixelType>
 ::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
+  os << indent << "SeriesUID: " << m_SeriesUID << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "CacheDirectory: " << m_CacheDirectory << std::endl;
+  os << indent << "ImageLoadedFromCache: " << m_ImageLoadedFromCache 
+     << std::endl;
+  os << indent << "MemoryMappedCache: " << m_MemoryMappedCache << std::endl;
+  os << indent << "ProgressiveLoading: " << m_ProgressiveLoading << std::endl;
+  os << indent << "PreviewSliceStride: " << m_PreviewSliceStride << std::endl;
 }
 
 } // end namespace igstk
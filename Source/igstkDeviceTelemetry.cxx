@@ -0,0 +1,388 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkDeviceTelemetry.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkDeviceTelemetry.h"
+
+#include <cmath>
+
+namespace igstk
+{
+
+namespace
+{
+/** Weight of a new interval or latency in the moving averages, which then
+ *  cover about the last 16 samples */
+const double MovingAverageWeight = 1.0 / 16.0;
+}
+
+/** Constructor */
+DeviceTelemetryReport::DeviceTelemetryReport()
+{
+  m_Time = 0.0;
+  m_NominalFrequency = 0.0;
+  m_DeviceRate = 0.0;
+  m_UpdateRate = 0.0;
+  m_NumberOfDeviceSamples = 0;
+  m_NumberOfDeviceErrors = 0;
+  m_NumberOfUpdates = 0;
+  m_NumberOfUpdateErrors = 0;
+  m_NumberOfMissedUpdates = 0;
+  m_JitterBinWidth = 0.0;
+  for( unsigned int i = 0; i < NumberOfJitterBins; i++ )
+    {
+    m_JitterHistogram[i] = 0;
+    }
+  m_LastLatency = 0.0;
+  m_MeanLatency = 0.0;
+  m_MaximumLatency = 0.0;
+}
+
+
+void
+DeviceTelemetryReport::Print( std::ostream & os ) const
+{
+  os << "Time: " << m_Time << std::endl;
+  os << "NominalFrequency: " << m_NominalFrequency << std::endl;
+  os << "DeviceRate: " << m_DeviceRate << std::endl;
+  os << "UpdateRate: " << m_UpdateRate << std::endl;
+  os << "NumberOfDeviceSamples: " << m_NumberOfDeviceSamples << std::endl;
+  os << "NumberOfDeviceErrors: " << m_NumberOfDeviceErrors << std::endl;
+  os << "NumberOfUpdates: " << m_NumberOfUpdates << std::endl;
+  os << "NumberOfUpdateErrors: " << m_NumberOfUpdateErrors << std::endl;
+  os << "NumberOfMissedUpdates: " << m_NumberOfMissedUpdates << std::endl;
+  os << "JitterBinWidth: " << m_JitterBinWidth << std::endl;
+  os << "JitterHistogram:";
+  for( unsigned int i = 0; i < NumberOfJitterBins; i++ )
+    {
+    os << " " << m_JitterHistogram[i];
+    }
+  os << std::endl;
+  os << "LastLatency: " << m_LastLatency << std::endl;
+  os << "MeanLatency: " << m_MeanLatency << std::endl;
+  os << "MaximumLatency: " << m_MaximumLatency << std::endl;
+  for( unsigned int i = 0; i < m_ToolIdentifiers.size(); i++ )
+    {
+    os << "ToolVisibilityRatio " << m_ToolIdentifiers[i] << ": "
+       << m_ToolVisibilityRatios[i] << std::endl;
+    }
+}
+
+
+std::ostream& operator<<( std::ostream& os,
+                          const DeviceTelemetryReport & report )
+{
+  report.Print( os );
+  return os;
+}
+
+
+/** Constructor */
+DeviceTelemetry::DeviceTelemetry()
+{
+  m_ReportPeriod = 1000.0;
+  m_JitterBinWidth = 1.0;
+  m_NominalFrequency = 0.0;
+  this->InternalReset();
+}
+
+/** Destructor */
+DeviceTelemetry::~DeviceTelemetry()
+{
+}
+
+
+void
+DeviceTelemetry::InternalReset()
+{
+  m_NextReportTime = -1.0;
+  m_NumberOfDeviceSamples = 0;
+  m_NumberOfDeviceErrors = 0;
+  m_NumberOfUpdates = 0;
+  m_NumberOfUpdateErrors = 0;
+  m_NumberOfMissedUpdates = 0;
+  for( unsigned int i = 0; i < ReportType::NumberOfJitterBins; i++ )
+    {
+    m_JitterHistogram[i] = 0;
+    }
+  m_LastDeviceSampleTime = -1.0;
+  m_LastUpdateTime = -1.0;
+  m_MeanDeviceInterval = 0.0;
+  m_MeanUpdateInterval = 0.0;
+  m_LastLatency = 0.0;
+  m_MeanLatency = 0.0;
+  m_MaximumLatency = 0.0;
+  for( unsigned int i = 0; i < m_ToolIdentifiers.size(); i++ )
+    {
+    m_NumberOfToolUpdates[i] = 0;
+    m_NumberOfToolVisibleUpdates[i] = 0;
+    }
+}
+
+
+void
+DeviceTelemetry::Reset()
+{
+  m_Mutex.Lock();
+  this->InternalReset();
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::SetNominalFrequency( double frequency )
+{
+  m_Mutex.Lock();
+  m_NominalFrequency = frequency;
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::AddTool( const std::string & identifier )
+{
+  m_Mutex.Lock();
+  m_ToolIdentifiers.push_back( identifier );
+  m_NumberOfToolUpdates.push_back( 0 );
+  m_NumberOfToolVisibleUpdates.push_back( 0 );
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::RemoveTool( unsigned int index )
+{
+  m_Mutex.Lock();
+  if( index < m_ToolIdentifiers.size() )
+    {
+    m_ToolIdentifiers[index] = m_ToolIdentifiers.back();
+    m_ToolIdentifiers.pop_back();
+    m_NumberOfToolUpdates[index] = m_NumberOfToolUpdates.back();
+    m_NumberOfToolUpdates.pop_back();
+    m_NumberOfToolVisibleUpdates[index] = m_NumberOfToolVisibleUpdates.back();
+    m_NumberOfToolVisibleUpdates.pop_back();
+    }
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::RecordDeviceSample( TimePeriodType time, bool success )
+{
+  m_Mutex.Lock();
+
+  m_NumberOfDeviceSamples++;
+  if( !success )
+    {
+    m_NumberOfDeviceErrors++;
+    }
+
+  if( m_LastDeviceSampleTime >= 0.0 )
+    {
+    const TimePeriodType interval = time - m_LastDeviceSampleTime;
+    m_MeanDeviceInterval = ( m_NumberOfDeviceSamples == 2 ) ? interval :
+      m_MeanDeviceInterval +
+      MovingAverageWeight * ( interval - m_MeanDeviceInterval );
+    }
+  m_LastDeviceSampleTime = time;
+
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::RecordUpdate( TimePeriodType time, bool success )
+{
+  m_Mutex.Lock();
+
+  m_NumberOfUpdates++;
+  if( !success )
+    {
+    m_NumberOfUpdateErrors++;
+    }
+
+  if( m_LastUpdateTime >= 0.0 )
+    {
+    const TimePeriodType interval = time - m_LastUpdateTime;
+    m_MeanUpdateInterval = ( m_NumberOfUpdates == 2 ) ? interval :
+      m_MeanUpdateInterval +
+      MovingAverageWeight * ( interval - m_MeanUpdateInterval );
+
+    // Without a nominal frequency, the jitter is the difference to the
+    // mean interval
+    TimePeriodType period = m_MeanUpdateInterval;
+    if( m_NominalFrequency > 0.0 )
+      {
+      period = 1000.0 / m_NominalFrequency;
+      if( interval > 1.5 * period )
+        {
+        m_NumberOfMissedUpdates +=
+          static_cast< unsigned long >( interval / period + 0.5 ) - 1;
+        }
+      }
+
+    unsigned int bin = ReportType::NumberOfJitterBins - 1;
+    if( m_JitterBinWidth > 0.0 )
+      {
+      const double jitterBin =
+        std::fabs( interval - period ) / m_JitterBinWidth;
+      if( jitterBin < bin )
+        {
+        bin = static_cast< unsigned int >( jitterBin );
+        }
+      }
+    m_JitterHistogram[ bin ]++;
+    }
+  m_LastUpdateTime = time;
+
+  if( success && m_LastDeviceSampleTime >= 0.0 )
+    {
+    m_LastLatency = time - m_LastDeviceSampleTime;
+    m_MeanLatency = ( m_NumberOfUpdates - m_NumberOfUpdateErrors == 1 ) ?
+      m_LastLatency :
+      m_MeanLatency + MovingAverageWeight * ( m_LastLatency - m_MeanLatency );
+    if( m_LastLatency > m_MaximumLatency )
+      {
+      m_MaximumLatency = m_LastLatency;
+      }
+    }
+
+  m_Mutex.Unlock();
+}
+
+
+void
+DeviceTelemetry::RecordToolUpdates( const unsigned char * updated,
+                                    unsigned int numberOfTools )
+{
+  m_Mutex.Lock();
+
+  const unsigned int numberOfKnownTools =
+    static_cast< unsigned int >( m_ToolIdentifiers.size() );
+  if( numberOfTools > numberOfKnownTools )
+    {
+    numberOfTools = numberOfKnownTools;
+    }
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    m_NumberOfToolUpdates[i]++;
+    if( updated[i] )
+      {
+      m_NumberOfToolVisibleUpdates[i]++;
+      }
+    }
+
+  m_Mutex.Unlock();
+}
+
+
+bool
+DeviceTelemetry::IsReportDue( TimePeriodType time )
+{
+  if( m_ReportPeriod <= 0.0 )
+    {
+    return false;
+    }
+
+  m_Mutex.Lock();
+
+  bool due = false;
+  if( m_NextReportTime < 0.0 )
+    {
+    m_NextReportTime = time + m_ReportPeriod;
+    }
+  else if( time >= m_NextReportTime )
+    {
+    due = true;
+    m_NextReportTime += m_ReportPeriod;
+    if( m_NextReportTime <= time )
+      {
+      m_NextReportTime = time + m_ReportPeriod;
+      }
+    }
+
+  m_Mutex.Unlock();
+  return due;
+}
+
+
+void
+DeviceTelemetry::GetReport( ReportType & report ) const
+{
+  m_Mutex.Lock();
+
+  report.m_Time = m_LastUpdateTime;
+  report.m_NominalFrequency = m_NominalFrequency;
+  report.m_DeviceRate = ( m_MeanDeviceInterval > 0.0 ) ?
+    1000.0 / m_MeanDeviceInterval : 0.0;
+  report.m_UpdateRate = ( m_MeanUpdateInterval > 0.0 ) ?
+    1000.0 / m_MeanUpdateInterval : 0.0;
+  report.m_NumberOfDeviceSamples = m_NumberOfDeviceSamples;
+  report.m_NumberOfDeviceErrors = m_NumberOfDeviceErrors;
+  report.m_NumberOfUpdates = m_NumberOfUpdates;
+  report.m_NumberOfUpdateErrors = m_NumberOfUpdateErrors;
+  report.m_NumberOfMissedUpdates = m_NumberOfMissedUpdates;
+  report.m_JitterBinWidth = m_JitterBinWidth;
+  for( unsigned int i = 0; i < ReportType::NumberOfJitterBins; i++ )
+    {
+    report.m_JitterHistogram[i] = m_JitterHistogram[i];
+    }
+  report.m_LastLatency = m_LastLatency;
+  report.m_MeanLatency = m_MeanLatency;
+  report.m_MaximumLatency = m_MaximumLatency;
+
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_ToolIdentifiers.size() );
+  report.m_ToolIdentifiers = m_ToolIdentifiers;
+  report.m_ToolVisibilityRatios.resize( numberOfTools );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    report.m_ToolVisibilityRatios[i] = ( m_NumberOfToolUpdates[i] > 0 ) ?
+      static_cast< double >( m_NumberOfToolVisibleUpdates[i] ) /
+      m_NumberOfToolUpdates[i] : 0.0;
+    }
+
+  m_Mutex.Unlock();
+}
+
+
+/** Print Self function */
+void
+DeviceTelemetry::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "ReportPeriod: " << m_ReportPeriod << std::endl;
+  os << indent << "JitterBinWidth: " << m_JitterBinWidth << std::endl;
+
+  ReportType report;
+  this->GetReport( report );
+  os << indent << "NumberOfDeviceSamples: "
+     << report.m_NumberOfDeviceSamples << std::endl;
+  os << indent << "NumberOfDeviceErrors: "
+     << report.m_NumberOfDeviceErrors << std::endl;
+  os << indent << "NumberOfUpdates: " << report.m_NumberOfUpdates << std::endl;
+  os << indent << "NumberOfUpdateErrors: "
+     << report.m_NumberOfUpdateErrors << std::endl;
+  os << indent << "UpdateRate: " << report.m_UpdateRate << std::endl;
+}
+
+} // end namespace igstk
@@ -0,0 +1,219 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkDeviceTelemetry.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkDeviceTelemetry_h
+#define __igstkDeviceTelemetry_h
+
+#include "igstkMacros.h"
+#include "igstkEvents.h"
+#include "igstkTimeStamp.h"
+
+#include "itkObject.h"
+#include "itkMutexLock.h"
+
+#include <string>
+#include <vector>
+
+
+namespace igstk
+{
+
+/** \class DeviceTelemetryReport
+ * \brief State of the acquisition of a Tracker or a VideoImager.
+ *
+ * The counters are accumulated since the device started tracking or
+ * imaging. The rates and the mean latency are averaged over the last
+ * samples, the maximum latency since the start.
+ *
+ * The jitter histogram counts the intervals between updates by their
+ * difference to the period of the device: the bin i counts the
+ * differences from i to i+1 times JitterBinWidth, the last bin the larger
+ * ones.
+ *
+ * \ingroup Object
+ */
+class DeviceTelemetryReport
+{
+public:
+
+  typedef TimeStamp::TimePeriodType     TimePeriodType;
+
+  enum { NumberOfJitterBins = 16 };
+
+  DeviceTelemetryReport();
+
+  /** Time of the report [milliseconds] */
+  TimePeriodType             m_Time;
+
+  /** Frequency requested from the device [Hz] */
+  double                     m_NominalFrequency;
+
+  /** Rates of the samples read from the device, and of the updates
+   *  reported to the observers [Hz] */
+  double                     m_DeviceRate;
+  double                     m_UpdateRate;
+
+  unsigned long              m_NumberOfDeviceSamples;
+  unsigned long              m_NumberOfDeviceErrors;
+  unsigned long              m_NumberOfUpdates;
+  unsigned long              m_NumberOfUpdateErrors;
+
+  /** Updates expected at the nominal frequency that did not happen */
+  unsigned long              m_NumberOfMissedUpdates;
+
+  /** Histogram of the jitter of the updates, with bins in milliseconds */
+  double                     m_JitterBinWidth;
+  unsigned long              m_JitterHistogram[ NumberOfJitterBins ];
+
+  /** Time from the reading of a sample from the device to the end of the
+   *  update that reported it [milliseconds] */
+  TimePeriodType             m_LastLatency;
+  TimePeriodType             m_MeanLatency;
+  TimePeriodType             m_MaximumLatency;
+
+  /** Tools, with the fraction of the updates since they were attached in
+   *  which they were visible */
+  std::vector< std::string > m_ToolIdentifiers;
+  std::vector< double >      m_ToolVisibilityRatios;
+
+  /** Print the report in a stream, one value per line */
+  void Print( std::ostream & os ) const;
+};
+
+std::ostream& operator<<( std::ostream& os,
+                          const DeviceTelemetryReport & report );
+
+igstkLoadedEventMacro( DeviceTelemetryEvent, IGSTKEvent,
+                       DeviceTelemetryReport );
+
+
+/** \class DeviceTelemetry
+ * \brief Health and throughput of the acquisition of a device.
+ *
+ * Each Tracker and VideoImager owns a telemetry object, returned by its
+ * GetTelemetry() method. The device records the samples read by its
+ * acquisition thread, the updates of its event loop and the visibility of
+ * its tools. The state can be read at any time from any thread with
+ * GetReport(), and the device invokes a DeviceTelemetryEvent carrying the
+ * report every ReportPeriod milliseconds while it is tracking or imaging.
+ *
+ * \ingroup Object
+ */
+class DeviceTelemetry : public ::itk::Object
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( DeviceTelemetry, ::itk::Object )
+  igstkNewMacro( Self );
+
+  typedef DeviceTelemetryReport                ReportType;
+  typedef ReportType::TimePeriodType           TimePeriodType;
+
+  /** Period of the telemetry events, or zero to not invoke them
+   *  [milliseconds]. The default is 1000. */
+  igstkSetMacro( ReportPeriod, TimePeriodType );
+  igstkGetMacro( ReportPeriod, TimePeriodType );
+
+  /** Width of the bins of the jitter histogram [milliseconds] */
+  igstkSetMacro( JitterBinWidth, double );
+  igstkGetMacro( JitterBinWidth, double );
+
+  /** Frequency requested from the device [Hz] */
+  void SetNominalFrequency( double frequency );
+
+  /** Copy the current state */
+  void GetReport( ReportType & report ) const;
+
+  /** Methods used by the devices. */
+
+  /** Clear the counters and the rates, when tracking or imaging starts */
+  void Reset();
+
+  /** Add a tool after the others, and remove the tool at an index, which
+   *  is replaced by the last tool */
+  void AddTool( const std::string & identifier );
+  void RemoveTool( unsigned int index );
+
+  /** Record a sample read from the device */
+  void RecordDeviceSample( TimePeriodType time, bool success );
+
+  /** Record an update reported to the observers, and which tools it
+   *  found, in the order in which they were added */
+  void RecordUpdate( TimePeriodType time, bool success );
+  void RecordToolUpdates( const unsigned char * updated,
+                          unsigned int numberOfTools );
+
+  /** Whether a telemetry event should be invoked at that time */
+  bool IsReportDue( TimePeriodType time );
+
+protected:
+
+  DeviceTelemetry(void);
+  virtual ~DeviceTelemetry(void);
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  DeviceTelemetry(const Self&);     //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  /** Clear the counters. Called with m_Mutex locked. */
+  void InternalReset();
+
+  TimePeriodType                  m_ReportPeriod;
+  double                          m_JitterBinWidth;
+
+  /** Protects the state, which is written from the acquisition thread and
+   *  from the event loop, and read from any thread */
+  mutable itk::SimpleMutexLock    m_Mutex;
+
+  double                          m_NominalFrequency;
+  TimePeriodType                  m_NextReportTime;
+
+  unsigned long                   m_NumberOfDeviceSamples;
+  unsigned long                   m_NumberOfDeviceErrors;
+  unsigned long                   m_NumberOfUpdates;
+  unsigned long                   m_NumberOfUpdateErrors;
+  unsigned long                   m_NumberOfMissedUpdates;
+  unsigned long                   m_JitterHistogram[
+                                    ReportType::NumberOfJitterBins ];
+
+  /** Times of the last sample and update, negative before the first */
+  TimePeriodType                  m_LastDeviceSampleTime;
+  TimePeriodType                  m_LastUpdateTime;
+
+  /** Moving averages of the intervals and of the latency */
+  TimePeriodType                  m_MeanDeviceInterval;
+  TimePeriodType                  m_MeanUpdateInterval;
+  TimePeriodType                  m_LastLatency;
+  TimePeriodType                  m_MeanLatency;
+  TimePeriodType                  m_MaximumLatency;
+
+  /** Tools, one array per field */
+  std::vector< std::string >      m_ToolIdentifiers;
+  std::vector< unsigned long >    m_NumberOfToolUpdates;
+  std::vector< unsigned long >    m_NumberOfToolVisibleUpdates;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkDeviceTelemetry_h
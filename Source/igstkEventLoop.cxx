@@ -0,0 +1,368 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventLoop.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkEventLoop.h"
+#include "igstkRealTimeClock.h"
+
+#if defined (_WIN32) || defined (WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace igstk
+{
+
+/** Constructor */
+EventLoop::EventLoop()
+{
+  m_LockOwner = 0;
+  m_LockCount = 0;
+  m_Threader = itk::MultiThreader::New();
+  m_ThreadID = -1;
+  m_RunningInThread = false;
+  m_StopRequested = false;
+  m_InvokingPostedCalls = false;
+}
+
+/** Destructor */
+EventLoop::~EventLoop()
+{
+  this->StopThread();
+}
+
+
+/** The main loop is created on first use, so that pulse generators can be
+ * created during the initialization of static objects. */
+EventLoop *
+EventLoop::GetMainLoop()
+{
+  static Pointer mainLoop = Self::New();
+  return mainLoop;
+}
+
+
+unsigned long
+EventLoop::GetCurrentThreadIdentifier()
+{
+#if defined (_WIN32) || defined (WIN32)
+  return static_cast< unsigned long >( ::GetCurrentThreadId() );
+#else
+  // pthread_t is an integer or a pointer depending on the platform
+  return (unsigned long)( pthread_self() );
+#endif
+}
+
+
+void
+EventLoop::Lock()
+{
+  const unsigned long thread = GetCurrentThreadIdentifier();
+
+  // Only the owner of the lock can find its own identifier here
+  if( m_LockCount > 0 && m_LockOwner == thread )
+    {
+    m_LockCount++;
+    return;
+    }
+
+  m_Mutex.Lock();
+  m_LockOwner = thread;
+  m_LockCount = 1;
+}
+
+
+void
+EventLoop::Unlock()
+{
+  if( --m_LockCount == 0 )
+    {
+    m_LockOwner = 0;
+    m_Mutex.Unlock();
+    }
+}
+
+
+void
+EventLoop::AddTimeout( double deadline, HandlerType handler, void * data )
+{
+  // Adding the next timeout re-arms the timer, which wakes up the thread
+  // waiting in WaitForEvents()
+  this->Lock();
+  m_Scheduler.AddTimeout( deadline, handler, data );
+  this->WakeUpForPostedCalls();
+  this->Unlock();
+}
+
+
+void
+EventLoop::RemoveTimeout( HandlerType handler, void * data )
+{
+  this->Lock();
+  m_Scheduler.RemoveTimeout( handler, data );
+  this->WakeUpForPostedCalls();
+
+  // The posted calls being invoked by this thread
+  PostedCallContainer::iterator it = m_InvokedCalls.begin();
+  for( ; it != m_InvokedCalls.end(); ++it )
+    {
+    if( it->m_Handler == handler && ( data == NULL || it->m_Data == data ) )
+      {
+      it->m_Handler = NULL;
+      }
+    }
+
+  m_PostedCallsMutex.Lock();
+  PostedCallContainer::iterator last = m_PostedCalls.begin();
+  for( it = m_PostedCalls.begin(); it != m_PostedCalls.end(); ++it )
+    {
+    if( it->m_Handler != handler || ( data != NULL && it->m_Data != data ) )
+      {
+      *last++ = *it;
+      }
+    }
+  m_PostedCalls.erase( last, m_PostedCalls.end() );
+  m_PostedCallsMutex.Unlock();
+
+  this->Unlock();
+}
+
+
+void
+EventLoop::PostCall( HandlerType handler, void * data )
+{
+  PostedCall call;
+  call.m_Handler = handler;
+  call.m_Data = data;
+
+  m_PostedCallsMutex.Lock();
+  m_PostedCalls.push_back( call );
+  m_PostedCallsMutex.Unlock();
+
+  // Only the timer descriptor is touched, the loop is not locked
+  m_Scheduler.WakeUp();
+}
+
+
+bool
+EventLoop::HasPostedCalls()
+{
+  m_PostedCallsMutex.Lock();
+  const bool posted = !m_PostedCalls.empty();
+  m_PostedCallsMutex.Unlock();
+  return posted;
+}
+
+
+void
+EventLoop::WakeUpForPostedCalls()
+{
+  // The calls are added to the container before the timer is woken up, so
+  // any call missed here wakes up the timer after it was re-armed
+  if( this->HasPostedCalls() )
+    {
+    m_Scheduler.WakeUp();
+    }
+}
+
+
+unsigned int
+EventLoop::InvokePostedCalls()
+{
+  // Handlers processing the events again do not invoke the calls twice
+  if( m_InvokingPostedCalls )
+    {
+    return 0;
+    }
+
+  m_PostedCallsMutex.Lock();
+  m_InvokedCalls.swap( m_PostedCalls );
+  m_PostedCallsMutex.Unlock();
+
+  m_InvokingPostedCalls = true;
+  unsigned int numberOfInvocations = 0;
+  for( unsigned int i = 0; i < m_InvokedCalls.size(); i++ )
+    {
+    if( m_InvokedCalls[i].m_Handler )
+      {
+      m_InvokedCalls[i].m_Handler( m_InvokedCalls[i].m_Data );
+      numberOfInvocations++;
+      }
+    }
+  m_InvokedCalls.clear();
+  m_InvokingPostedCalls = false;
+
+  return numberOfInvocations;
+}
+
+
+unsigned int
+EventLoop::ProcessEvents()
+{
+  this->Lock();
+  unsigned int numberOfInvocations = this->InvokePostedCalls();
+  numberOfInvocations += m_Scheduler.InvokeTimeouts();
+  this->WakeUpForPostedCalls();
+  this->Unlock();
+  return numberOfInvocations;
+}
+
+
+double
+EventLoop::GetTimeToNextEvent()
+{
+  if( this->HasPostedCalls() )
+    {
+    return 0.0;
+    }
+
+  this->Lock();
+  const double delay =
+    m_Scheduler.GetTimeToNextTimeout( RealTimeClock::GetTimeStamp() );
+  this->Unlock();
+  return delay;
+}
+
+
+void
+EventLoop::WaitForEvents( double maximumMilliseconds )
+{
+  const double start = RealTimeClock::GetTimeStamp();
+
+  while( true )
+    {
+    this->Lock();
+    const double now = RealTimeClock::GetTimeStamp();
+    double delay = m_Scheduler.GetTimeToNextTimeout( now );
+    const int descriptor = m_Scheduler.GetFileDescriptor();
+    this->Unlock();
+
+    if( this->HasPostedCalls() )
+      {
+      return;
+      }
+
+    const double remaining = maximumMilliseconds - ( now - start );
+    if( delay < 0.0 || delay > remaining )
+      {
+      delay = remaining;
+      }
+    if( delay <= 0.0 )
+      {
+      return;
+      }
+
+    // The timer is re-armed when another thread adds an earlier timeout,
+    // and woken up when it posts a call
+    if( descriptor >= 0 )
+      {
+      m_Scheduler.WaitForTimer( delay );
+      return;
+      }
+
+    // Without timer, the timeouts added and the calls posted by other
+    // threads are noticed between short sleeps
+    m_Scheduler.WaitForTimer( ( delay < 1.0 ) ? delay : 1.0 );
+    }
+}
+
+
+int
+EventLoop::GetFileDescriptor()
+{
+  this->Lock();
+  const int descriptor = m_Scheduler.GetFileDescriptor();
+  this->Unlock();
+  return descriptor;
+}
+
+
+void
+EventLoop::StartThread()
+{
+  if( m_RunningInThread )
+    {
+    return;
+    }
+
+  m_StopRequested = false;
+  m_RunningInThread = true;
+  m_ThreadID = m_Threader->SpawnThread( ThreadFunction, this );
+}
+
+
+void
+EventLoop::StopThread()
+{
+  if( !m_RunningInThread )
+    {
+    return;
+    }
+
+  m_StopRequested = true;
+  this->PostCall( Self::WakeUp, this );
+  m_Threader->TerminateThread( m_ThreadID );
+  this->RemoveTimeout( Self::WakeUp, this );
+
+  m_ThreadID = -1;
+  m_RunningInThread = false;
+}
+
+
+void
+EventLoop::WakeUp( void * )
+{
+}
+
+
+/** Thread function of the loop */
+ITK_THREAD_RETURN_TYPE
+EventLoop::ThreadFunction( void * pInfoStruct )
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo =
+    (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+
+  if( pInfo == NULL || pInfo->UserData == NULL )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  Self * eventLoop = (Self*)pInfo->UserData;
+
+  while( !eventLoop->m_StopRequested )
+    {
+    eventLoop->WaitForEvents( 100.0 );
+    eventLoop->ProcessEvents();
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/** Print Self function */
+void
+EventLoop::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "RunningInThread: " << m_RunningInThread << std::endl;
+  os << indent << "NumberOfTimeouts: "
+     << m_Scheduler.GetNumberOfTimeouts() << std::endl;
+  os << indent << "NumberOfPostedCalls: "
+     << m_PostedCalls.size() << std::endl;
+}
+
+} // end namespace igstk
@@ -0,0 +1,175 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventLoop.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkEventLoop_h
+#define __igstkEventLoop_h
+
+#include "igstkMacros.h"
+#include "igstkTimeoutScheduler.h"
+
+#include "itkObject.h"
+#include "itkMutexLock.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+namespace igstk
+{
+
+/** \class EventLoop
+ * \brief Invokes timeouts and posted calls from a single thread.
+ *
+ * PulseGenerators schedule their pulses in an event loop. By default this
+ * is the main loop returned by GetMainLoop(), which the GUI of the
+ * application drives through PulseGenerator::CheckTimeouts(). Other event
+ * loops can run in a thread of their own, started with StartThread(), so
+ * that for example the pulses of a Tracker, and the observers of its
+ * events, do not wait for the rendering of the GUI thread.
+ *
+ * All the methods can be called from any thread. Calls to be made from the
+ * thread of the loop are posted with PostCall(). The timeouts are invoked
+ * while the loop is locked, so that the objects bound to a loop can
+ * serialize their requests with the invocations by calling Lock() and
+ * Unlock(). The lock is recursive, the handlers can use the loop. Posting
+ * a call does not take this lock, it never waits for the handlers being
+ * invoked.
+ *
+ * \ingroup Object
+ */
+class EventLoop : public ::itk::Object
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( EventLoop, ::itk::Object )
+  igstkNewMacro( Self );
+
+  typedef TimeoutScheduler::TimeoutHandler    HandlerType;
+
+  /** Event loop of the main thread, used by default by the pulse
+   *  generators */
+  static EventLoop * GetMainLoop();
+
+  /** Schedule a call to the handler at a time of the RealTimeClock, in
+   *  milliseconds */
+  void AddTimeout( double deadline, HandlerType handler, void * data );
+
+  /** Remove the timeouts and posted calls of a handler with the given data,
+   *  or all those of the handler if data is NULL. When this returns, the
+   *  handler is not being invoked by another thread. */
+  void RemoveTimeout( HandlerType handler, void * data );
+
+  /** Call the handler from the loop as soon as possible. The calls posted
+   *  by a thread are invoked in the order of posting, before the timeouts
+   *  that are due. This does not wait for the handlers being invoked. */
+  void PostCall( HandlerType handler, void * data );
+
+  /** Invoke the timeouts that are due and the posted calls. Returns the
+   *  number of handlers called. */
+  unsigned int ProcessEvents();
+
+  /** Milliseconds until the next timeout is due, zero if a timeout is due,
+   *  and a negative value if there is no timeout */
+  double GetTimeToNextEvent();
+
+  /** Block until a timeout is due, or at most the given number of
+   *  milliseconds. Timeouts added by other threads end the wait. */
+  void WaitForEvents( double maximumMilliseconds );
+
+  /** File descriptor that becomes readable when timeouts are due. Returns
+   *  -1 on the platforms without timerfd. */
+  int GetFileDescriptor();
+
+  /** Start a thread that waits for and processes the events of this loop
+   *  until StopThread() is called */
+  void StartThread();
+
+  /** Stop the thread of the loop and wait for its termination. This must
+   *  not be called from the handlers of the loop. */
+  void StopThread();
+
+  /** Whether the loop is run by its own thread */
+  igstkGetMacro( RunningInThread, bool );
+
+  /** Exclude the invocation of the handlers. Calls can be nested. */
+  void Lock();
+  void Unlock();
+
+protected:
+
+  EventLoop(void);
+  virtual ~EventLoop(void);
+
+  /** Print the object information. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  EventLoop(const Self&);           //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  /** Function run by the thread of the loop */
+  static ITK_THREAD_RETURN_TYPE ThreadFunction( void * pInfoStruct );
+
+  /** Posted to wake up the thread of the loop */
+  static void WakeUp( void * );
+
+  /** Identifier of the calling thread */
+  static unsigned long GetCurrentThreadIdentifier();
+
+  /** Invoke the calls posted so far. Called with the loop locked. */
+  unsigned int InvokePostedCalls();
+
+  /** Whether calls are waiting to be invoked */
+  bool HasPostedCalls();
+
+  /** Re-arming the timer for the next timeout can cancel the wake up of a
+   *  call posted meanwhile. Called after the timeouts are changed. */
+  void WakeUpForPostedCalls();
+
+  struct PostedCall
+    {
+    HandlerType   m_Handler;
+    void *        m_Data;
+    };
+  typedef std::vector< PostedCall >   PostedCallContainer;
+
+  TimeoutScheduler              m_Scheduler;
+
+  /** Calls posted by any thread, protected by their own lock */
+  itk::SimpleMutexLock          m_PostedCallsMutex;
+  PostedCallContainer           m_PostedCalls;
+
+  /** Calls being invoked. Those removed meanwhile have a NULL handler. */
+  PostedCallContainer           m_InvokedCalls;
+  bool                          m_InvokingPostedCalls;
+
+  itk::SimpleMutexLock          m_Mutex;
+  volatile unsigned long        m_LockOwner;
+  volatile unsigned int         m_LockCount;
+
+  itk::MultiThreader::Pointer   m_Threader;
+  int                           m_ThreadID;
+  bool                          m_RunningInThread;
+  volatile bool                 m_StopRequested;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkEventLoop_h
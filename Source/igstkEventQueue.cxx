@@ -0,0 +1,430 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventQueue.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkEventQueue.h"
+
+#include <algorithm>
+
+namespace igstk
+{
+
+/** Constructor */
+EventQueue::EventQueue()
+{
+  m_EventLoop = EventLoop::GetMainLoop();
+  m_SourceEventLoop = EventLoop::GetMainLoop();
+  m_DeliveryPosted = false;
+  m_NextTag = 1;
+  m_MaximumQueueSize = 1000;
+  m_NumberOfDeliveredEvents = 0;
+  m_NumberOfCoalescedEvents = 0;
+  m_NumberOfDroppedEvents = 0;
+}
+
+/** Destructor */
+EventQueue::~EventQueue()
+{
+  // No event is queued once the receptors are removed. Removing the
+  // delivery then waits for a delivery in progress.
+  for( unsigned int i = 0; i < m_Subscriptions.size(); i++ )
+    {
+    Subscription * subscription = m_Subscriptions[i];
+    if( !subscription->m_Removed )
+      {
+      EventLoop * sourceLoop = subscription->m_SourceEventLoop;
+      sourceLoop->Lock();
+      subscription->m_Source->RemoveObserver( subscription->m_SourceTag );
+      sourceLoop->Unlock();
+      }
+    }
+
+  m_EventLoop->RemoveTimeout( Self::DeliverEventsGlobal, this );
+
+  for( unsigned int i = 0; i < m_Subscriptions.size(); i++ )
+    {
+    delete m_Subscriptions[i];
+    }
+
+  for( unsigned int i = 0; i < m_QueuedEvents.size(); i++ )
+    {
+    delete m_QueuedEvents[i].m_Event;
+    }
+}
+
+
+void
+EventQueue::SetEventLoop( EventLoop * eventLoop )
+{
+  EventLoop::Pointer newLoop =
+    eventLoop ? eventLoop : EventLoop::GetMainLoop();
+  if( newLoop == m_EventLoop )
+    {
+    return;
+    }
+
+  // Move a pending delivery to the new loop
+  m_EventLoop->RemoveTimeout( Self::DeliverEventsGlobal, this );
+
+  m_Mutex.Lock();
+  m_EventLoop = newLoop;
+  const bool post = m_DeliveryPosted;
+  m_Mutex.Unlock();
+
+  if( post )
+    {
+    newLoop->PostCall( Self::DeliverEventsGlobal, this );
+    }
+}
+
+
+EventLoop *
+EventQueue::GetEventLoop() const
+{
+  return m_EventLoop;
+}
+
+
+void
+EventQueue::SetSourceEventLoop( EventLoop * eventLoop )
+{
+  m_SourceEventLoop = eventLoop ? eventLoop : EventLoop::GetMainLoop();
+}
+
+
+EventLoop *
+EventQueue::GetSourceEventLoop() const
+{
+  return m_SourceEventLoop;
+}
+
+
+unsigned long
+EventQueue::AddEventObserver( const SourceType * source,
+                              const EventType & event,
+                              CommandType * command,
+                              bool coalesce )
+{
+  return this->AddObserverWithCopy( source, event, command, coalesce,
+                                    &Self::CopyEvent );
+}
+
+
+unsigned long
+EventQueue::AddObserverWithCopy( const SourceType * source,
+                                 const EventType & event,
+                                 CommandType * command,
+                                 bool coalesce,
+                                 EventCopyFunction copy )
+{
+  if( !source || !command )
+    {
+    return 0;
+    }
+
+  Subscription * subscription = new Subscription;
+  subscription->m_Source = source;
+  subscription->m_SourceEventLoop = m_SourceEventLoop;
+  subscription->m_SourceTag = 0;
+  subscription->m_Command = command;
+  subscription->m_Copy = copy;
+  subscription->m_Coalesce = coalesce;
+  subscription->m_Removed = false;
+  subscription->m_QueuedIndex = -1;
+  subscription->m_NumberOfQueuedEvents = 0;
+
+  m_Mutex.Lock();
+  subscription->m_Tag = m_NextTag++;
+  m_Subscriptions.push_back( subscription );
+  m_Mutex.Unlock();
+
+  Receptor::Pointer receptor = Receptor::New();
+  receptor->Set( this, subscription );
+
+  // The source does not invoke its events meanwhile
+  EventLoop * sourceLoop = subscription->m_SourceEventLoop;
+  sourceLoop->Lock();
+  subscription->m_SourceTag = source->AddObserver( event, receptor );
+  sourceLoop->Unlock();
+
+  return subscription->m_Tag;
+}
+
+
+void
+EventQueue::RemoveEventObserver( unsigned long tag )
+{
+  // The observers are not called meanwhile
+  EventLoop::Pointer eventLoop = m_EventLoop;
+  eventLoop->Lock();
+
+  m_Mutex.Lock();
+  Subscription * subscription = NULL;
+  for( unsigned int i = 0; i < m_Subscriptions.size(); i++ )
+    {
+    if( m_Subscriptions[i]->m_Tag == tag && !m_Subscriptions[i]->m_Removed )
+      {
+      subscription = m_Subscriptions[i];
+      }
+    }
+  m_Mutex.Unlock();
+
+  if( subscription )
+    {
+    // The source does not invoke its events meanwhile
+    EventLoop * sourceLoop = subscription->m_SourceEventLoop;
+    sourceLoop->Lock();
+    subscription->m_Source->RemoveObserver( subscription->m_SourceTag );
+    sourceLoop->Unlock();
+
+    m_Mutex.Lock();
+    subscription->m_Removed = true;
+    this->ReleaseSubscription( subscription );
+    m_Mutex.Unlock();
+    }
+
+  eventLoop->Unlock();
+}
+
+
+void
+EventQueue::ReleaseSubscription( Subscription * subscription )
+{
+  if( subscription->m_Removed && subscription->m_NumberOfQueuedEvents == 0 )
+    {
+    m_Subscriptions.erase( std::find( m_Subscriptions.begin(),
+                                      m_Subscriptions.end(),
+                                      subscription ) );
+    delete subscription;
+    }
+}
+
+
+EventQueue::EventType *
+EventQueue::CopyEvent( const EventType & event )
+{
+  return event.MakeObject();
+}
+
+
+void
+EventQueue::QueueEvent( Subscription * subscription, const EventType & event )
+{
+  // The copy is made before locking the queue
+  EventType * copy = subscription->m_Copy( event );
+  EventType * discarded = NULL;
+
+  m_Mutex.Lock();
+
+  if( subscription->m_Removed )
+    {
+    discarded = copy;
+    }
+  else if( subscription->m_QueuedIndex >= 0 )
+    {
+    // Replace the event that was not delivered yet
+    QueuedEvent & queued = m_QueuedEvents[ subscription->m_QueuedIndex ];
+    discarded = queued.m_Event;
+    queued.m_Event = copy;
+    m_NumberOfCoalescedEvents++;
+    }
+  else if( !subscription->m_Coalesce &&
+           m_QueuedEvents.size() >= m_MaximumQueueSize )
+    {
+    discarded = copy;
+    m_NumberOfDroppedEvents++;
+    }
+  else
+    {
+    QueuedEvent queued;
+    queued.m_Subscription = subscription;
+    queued.m_Event = copy;
+    if( subscription->m_Coalesce )
+      {
+      subscription->m_QueuedIndex =
+        static_cast< int >( m_QueuedEvents.size() );
+      }
+    subscription->m_NumberOfQueuedEvents++;
+    m_QueuedEvents.push_back( queued );
+    }
+
+  // A single delivery is posted at a time, so that the loop is not
+  // flooded when its thread lags
+  const bool post = !m_DeliveryPosted && !m_QueuedEvents.empty();
+  if( post )
+    {
+    m_DeliveryPosted = true;
+    }
+  EventLoop::Pointer eventLoop = m_EventLoop;
+
+  m_Mutex.Unlock();
+
+  delete discarded;
+
+  if( post )
+    {
+    eventLoop->PostCall( Self::DeliverEventsGlobal, this );
+    }
+}
+
+
+void
+EventQueue::DeliverEventsGlobal( void * data )
+{
+  static_cast< Self * >( data )->DeliverEvents();
+}
+
+
+void
+EventQueue::DeliverEvents()
+{
+  // Take the queued events. The events invoked meanwhile are delivered by
+  // the next call.
+  m_Mutex.Lock();
+  m_DeliveredEvents.swap( m_QueuedEvents );
+  for( unsigned int i = 0; i < m_DeliveredEvents.size(); i++ )
+    {
+    m_DeliveredEvents[i].m_Subscription->m_QueuedIndex = -1;
+    }
+  m_Mutex.Unlock();
+
+  // Observers removed by a previous one are not called. The removal waits
+  // for the loop, so the flag does not change from other threads here.
+  unsigned long numberOfDeliveredEvents = 0;
+  for( unsigned int i = 0; i < m_DeliveredEvents.size(); i++ )
+    {
+    const Subscription * subscription = m_DeliveredEvents[i].m_Subscription;
+    if( !subscription->m_Removed )
+      {
+      numberOfDeliveredEvents++;
+      const ::itk::Object * source = subscription->m_Source.GetPointer();
+      subscription->m_Command->Execute( source,
+                                        *m_DeliveredEvents[i].m_Event );
+      }
+    }
+
+  m_Mutex.Lock();
+  for( unsigned int i = 0; i < m_DeliveredEvents.size(); i++ )
+    {
+    Subscription * subscription = m_DeliveredEvents[i].m_Subscription;
+    delete m_DeliveredEvents[i].m_Event;
+    subscription->m_NumberOfQueuedEvents--;
+    this->ReleaseSubscription( subscription );
+    }
+  m_NumberOfDeliveredEvents += numberOfDeliveredEvents;
+  m_DeliveredEvents.clear();
+
+  const bool post = !m_QueuedEvents.empty();
+  m_DeliveryPosted = post;
+  EventLoop::Pointer eventLoop = m_EventLoop;
+  m_Mutex.Unlock();
+
+  // Posted calls are invoked by the next processing of the loop, the other
+  // handlers of the loop are invoked meanwhile
+  if( post )
+    {
+    eventLoop->PostCall( Self::DeliverEventsGlobal, this );
+    }
+}
+
+
+unsigned long
+EventQueue::GetNumberOfDeliveredEvents() const
+{
+  m_Mutex.Lock();
+  const unsigned long number = m_NumberOfDeliveredEvents;
+  m_Mutex.Unlock();
+  return number;
+}
+
+
+unsigned long
+EventQueue::GetNumberOfCoalescedEvents() const
+{
+  m_Mutex.Lock();
+  const unsigned long number = m_NumberOfCoalescedEvents;
+  m_Mutex.Unlock();
+  return number;
+}
+
+
+unsigned long
+EventQueue::GetNumberOfDroppedEvents() const
+{
+  m_Mutex.Lock();
+  const unsigned long number = m_NumberOfDroppedEvents;
+  m_Mutex.Unlock();
+  return number;
+}
+
+
+/** Receptor */
+EventQueue::Receptor::Receptor()
+{
+  m_Queue = NULL;
+  m_Subscription = NULL;
+}
+
+
+void
+EventQueue::Receptor::Set( EventQueue * queue, Subscription * subscription )
+{
+  m_Queue = queue;
+  m_Subscription = subscription;
+}
+
+
+void
+EventQueue::Receptor::Execute( ::itk::Object * caller,
+                               const EventType & event )
+{
+  this->Execute( (const ::itk::Object *)caller, event );
+}
+
+
+void
+EventQueue::Receptor::Execute( const ::itk::Object *,
+                               const EventType & event )
+{
+  m_Queue->QueueEvent( m_Subscription, event );
+}
+
+
+/** Print Self function */
+void
+EventQueue::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfObservers: " << m_Subscriptions.size()
+     << std::endl;
+  os << indent << "SourceEventLoop: " << m_SourceEventLoop.GetPointer()
+     << std::endl;
+  os << indent << "MaximumQueueSize: " << m_MaximumQueueSize << std::endl;
+  os << indent << "NumberOfDeliveredEvents: "
+     << m_NumberOfDeliveredEvents << std::endl;
+  os << indent << "NumberOfCoalescedEvents: "
+     << m_NumberOfCoalescedEvents << std::endl;
+  os << indent << "NumberOfDroppedEvents: "
+     << m_NumberOfDroppedEvents << std::endl;
+}
+
+} // end namespace igstk
@@ -0,0 +1,246 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventQueue.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkEventQueue_h
+#define __igstkEventQueue_h
+
+#include "igstkMacros.h"
+#include "igstkObject.h"
+#include "igstkEventLoop.h"
+
+#include "itkObject.h"
+#include "itkCommand.h"
+#include "itkMutexLock.h"
+
+#include <vector>
+
+
+namespace igstk
+{
+
+/** \class EventQueue
+ * \brief Delivers the events of objects to observers in another thread.
+ *
+ * The events of a Tracker or of its tools are invoked by the thread of the
+ * pulse generator of the Tracker. An observer added through an EventQueue
+ * is instead called from the thread of the event loop of the queue, by
+ * default the main loop. The events are copied, with their payload, when
+ * they are invoked, and delivered in order of invocation. The thread that
+ * invokes the events only waits for the copy to be queued, never for the
+ * observers, so that a slow observer, for example one writing to a file,
+ * delays neither the tracking nor the other observers of the sources.
+ *
+ * When an observer is added with coalescing, at most one event is queued
+ * for it: an event invoked before the previous one was delivered replaces
+ * it. An observer of the transforms of a tool then receives the newest
+ * transform of the tool, however late its thread is. Without coalescing,
+ * the events invoked while MaximumQueueSize events are queued are dropped.
+ *
+ * \code
+ *   EventQueue::Pointer queue = EventQueue::New();
+ *   queue->SetEventLoop( loggerLoop );
+ *   queue->AddLoadedEventObserver( trackerTool,
+ *     CoordinateSystemTransformToEvent(), loggerCommand, true );
+ * \endcode
+ *
+ * The observers are called with the source of the event as caller. The
+ * sources are referenced until their observers are removed.
+ *
+ * Observers can be added and removed from any thread. The observers of
+ * the sources are changed while the source event loop is locked, and the
+ * sources must invoke their events only from the handlers of that loop,
+ * as a Tracker bound to it with RequestSetEventLoop() does for its events
+ * and for those of its tools. The source event loop is the main loop
+ * unless SetSourceEventLoop() selects another one. Removing an observer
+ * also locks the event loop of the queue, so that the command is not
+ * being called when RemoveEventObserver() returns.
+ *
+ * \ingroup Object
+ */
+class EventQueue : public ::itk::Object
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( EventQueue, ::itk::Object )
+  igstkNewMacro( Self );
+
+  typedef ::igstk::Object         SourceType;
+  typedef ::itk::EventObject      EventType;
+  typedef ::itk::Command          CommandType;
+
+  /** Function copying an event with its payload */
+  typedef EventType * (*EventCopyFunction)( const EventType & event );
+
+  /** Event loop from the thread of which the observers are called. NULL
+   *  selects the main loop. It should be set before adding observers. */
+  void SetEventLoop( EventLoop * eventLoop );
+  EventLoop * GetEventLoop() const;
+
+  /** Event loop from the thread of which the sources invoke their events.
+   *  NULL selects the main loop. It applies to the observers added
+   *  afterwards. */
+  void SetSourceEventLoop( EventLoop * eventLoop );
+  EventLoop * GetSourceEventLoop() const;
+
+  /** Call the command when the source invokes events of the given type,
+   *  which do not carry a payload. Returns a tag for
+   *  RemoveEventObserver(). */
+  unsigned long AddEventObserver( const SourceType * source,
+                                  const EventType & event,
+                                  CommandType * command,
+                                  bool coalesce );
+
+  /** Call the command when the source invokes events of the given type,
+   *  with a copy of their payload made by Get() and Set(). The copies have
+   *  the type TEvent, even if the source invoked a subclass of it. */
+  template < class TEvent >
+  unsigned long AddLoadedEventObserver( const SourceType * source,
+                                        const TEvent & event,
+                                        CommandType * command,
+                                        bool coalesce )
+    {
+    return this->AddObserverWithCopy( source, event, command, coalesce,
+                                      &Self::CopyLoadedEvent< TEvent > );
+    }
+
+  /** Remove an observer. The events queued for it are not delivered, and
+   *  the command is not called once this returns. This must not be called
+   *  while the source event loop is locked by another thread that waits
+   *  for the event loop of the queue. */
+  void RemoveEventObserver( unsigned long tag );
+
+  /** Maximum number of events queued for the observers without
+   *  coalescing */
+  igstkSetMacro( MaximumQueueSize, unsigned int );
+  igstkGetMacro( MaximumQueueSize, unsigned int );
+
+  /** Statistics of the queue, since its creation */
+  unsigned long GetNumberOfDeliveredEvents() const;
+  unsigned long GetNumberOfCoalescedEvents() const;
+  unsigned long GetNumberOfDroppedEvents() const;
+
+protected:
+
+  EventQueue(void);
+  virtual ~EventQueue(void);
+
+  /** Print the object information. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  EventQueue(const Self&);          //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  /** An observer, and the source it observes */
+  struct Subscription
+    {
+    unsigned long               m_Tag;
+    SourceType::ConstPointer    m_Source;
+    EventLoop::Pointer          m_SourceEventLoop;
+    unsigned long               m_SourceTag;
+    CommandType::Pointer        m_Command;
+    EventCopyFunction           m_Copy;
+    bool                        m_Coalesce;
+    bool                        m_Removed;
+    /** Index of the queued event replaced by coalescing, or -1 */
+    int                         m_QueuedIndex;
+    unsigned int                m_NumberOfQueuedEvents;
+    };
+
+  struct QueuedEvent
+    {
+    Subscription *   m_Subscription;
+    EventType *      m_Event;
+    };
+
+  typedef std::vector< Subscription * >   SubscriptionContainer;
+  typedef std::vector< QueuedEvent >      QueuedEventContainer;
+
+  /** Observer added to the sources, queueing their events */
+  class Receptor;
+  friend class Receptor;
+  class Receptor : public CommandType
+    {
+  public:
+    typedef Receptor                      Self;
+    typedef ::itk::SmartPointer< Self >   Pointer;
+    itkNewMacro( Self );
+
+    void Set( EventQueue * queue, Subscription * subscription );
+    void Execute( ::itk::Object * caller, const EventType & event );
+    void Execute( const ::itk::Object * caller, const EventType & event );
+
+  protected:
+    Receptor();
+
+  private:
+    EventQueue *     m_Queue;
+    Subscription *   m_Subscription;
+    };
+
+  unsigned long AddObserverWithCopy( const SourceType * source,
+                                     const EventType & event,
+                                     CommandType * command,
+                                     bool coalesce,
+                                     EventCopyFunction copy );
+
+  template < class TEvent >
+  static EventType * CopyLoadedEvent( const EventType & event )
+    {
+    TEvent * copy = new TEvent;
+    copy->Set( static_cast< const TEvent & >( event ).Get() );
+    return copy;
+    }
+
+  static EventType * CopyEvent( const EventType & event );
+
+  /** Called by the receptors, from the thread invoking the events */
+  void QueueEvent( Subscription * subscription, const EventType & event );
+
+  /** Posted to the event loop to deliver the queued events */
+  static void DeliverEventsGlobal( void * data );
+  void DeliverEvents();
+
+  /** Delete a subscription if no event is queued for it. Called with
+   *  m_Mutex locked. */
+  void ReleaseSubscription( Subscription * subscription );
+
+  EventLoop::Pointer              m_EventLoop;
+  EventLoop::Pointer              m_SourceEventLoop;
+
+  /** Protects the queue, the counters and the subscriptions. It is only
+   *  held to add or take events, not while the observers are called. */
+  mutable itk::SimpleMutexLock    m_Mutex;
+  SubscriptionContainer           m_Subscriptions;
+  QueuedEventContainer            m_QueuedEvents;
+  QueuedEventContainer            m_DeliveredEvents;
+  bool                            m_DeliveryPosted;
+
+  unsigned long                   m_NextTag;
+  unsigned int                    m_MaximumQueueSize;
+  unsigned long                   m_NumberOfDeliveredEvents;
+  unsigned long                   m_NumberOfCoalescedEvents;
+  unsigned long                   m_NumberOfDroppedEvents;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkEventQueue_h
@@ -30,6 +30,9 @@ namespace igstk
 #define igstkEventMacro( classname, superclassname ) \
             itkEventMacro( classname, superclassname )
 
+/** Events with a payload copied by Set(). SetReference() passes a payload
+ *  without copying it, in which case the payload must not be destroyed
+ *  before the invocation of the event returns. */
 #define igstkLoadedEventMacro( name, superclass, payloadtype ) \
 class  name : public superclass \
 { \
@@ -37,21 +40,24 @@ public:  \
   typedef name        Self; \
   typedef superclass  Superclass; \
   typedef payloadtype PayloadType; \
-  name() {} \
+  name() : m_PayloadReference( 0 ) {} \
   virtual ~name() {} \
   virtual const char * GetEventName() const { return #name; } \
   virtual bool CheckEvent(const ::itk::EventObject* e) const \
     { return dynamic_cast<const Self*>(e); } \
   virtual ::itk::EventObject* MakeObject() const \
     { return new Self; } \
-  name(const Self&s) :superclass(s){}; \
+  name(const Self&s) :superclass(s), m_PayloadReference( 0 ) {}; \
   const PayloadType & Get() const \
-    { return m_Payload; }  \
+    { return m_PayloadReference ? *m_PayloadReference : m_Payload; }  \
   void Set( const payloadtype & _var ) \
-    { m_Payload = _var; }  \
+    { m_Payload = _var; m_PayloadReference = 0; }  \
+  void SetReference( const payloadtype & _var ) \
+    { m_PayloadReference = &_var; }  \
 private: \
   void operator=(const Self&);  \
-  PayloadType  m_Payload; \
+  PayloadType          m_Payload; \
+  const PayloadType *  m_PayloadReference; \
 };
 
 namespace EventHelperType 
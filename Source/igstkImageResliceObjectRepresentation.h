@@ -27,8 +27,9 @@ class vtkImageMapToColors;
 class vtkPlaneSource;
 class vtkPlane;
 class vtkImageSlice;
-class vtkImageResliceMapper;
+class vtkImageSliceMapper;
 class vtkImageProperty;
+class vtkMatrix4x4;
 
 namespace igstk
 {
@@ -41,6 +42,11 @@ namespace igstk
  * 
  * \brief This class represents an oblique image object. 
  * 
+ * The slice is requested from the ResliceCache, so that the copies of this
+ * representation in several views, and the representations of other
+ * layers resliced by the same plane, share a single reslicing of the image.
+ * The slice is displayed in the plane by placing its actor.
+ *
  * \ingroup ObjectRepresentation
  */
 template < class TImageSpatialObject >
@@ -126,9 +132,14 @@ private:
   vtkPlaneSource        *m_PlaneSource;
   vtkPlane              *m_Plane;
   vtkImageSlice         *m_ImageSlice;
-  vtkImageResliceMapper *m_ImageResliceMapper;
+  vtkImageSliceMapper   *m_ImageSliceMapper;
   vtkImageProperty      *m_ImageProperty;
 
+  /** Placement of the shared slice in the image coordinate system, and
+   *  modification time of the plane it was computed for */
+  vtkMatrix4x4          *m_SliceAxes;
+  unsigned long          m_SlicePlaneMTime;
+
   int    m_ResliceInterpolate;
 
   /** Variables that store window and level values for 2D image display */
@@ -146,6 +157,9 @@ private:
   /** Update the visual representation with changes in the geometry */
   virtual void UpdateRepresentationProcessing();
 
+  /** Get the slice of the current plane from the cache and place it */
+  void UpdateSlice();
+
   /** Null operation for State Machine transition */
   void NoProcessing(); 
 
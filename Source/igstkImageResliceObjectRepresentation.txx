@@ -20,6 +20,7 @@
 #include "igstkImageResliceObjectRepresentation.h"
 
 #include "igstkEvents.h"
+#include "igstkResliceCache.h"
 
 #include <vtkImageData.h>
 #include <vtkTransform.h>
@@ -28,9 +29,10 @@
 #include <vtkCamera.h>
 #include <vtkMath.h>
 #include <vtkImageMapToColors.h>
-#include <vtkImageResliceMapper.h>
+#include <vtkImageSliceMapper.h>
 #include <vtkImageProperty.h>
 #include <vtkImageSlice.h>
+#include <vtkMatrix4x4.h>
 
 namespace igstk
 {
@@ -50,6 +52,10 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
 
   // Create classes for displaying images
   m_ImageSlice = vtkImageSlice::New();
+  m_ImageSliceMapper = NULL;
+
+  m_SliceAxes = vtkMatrix4x4::New();
+  m_SlicePlaneMTime = 0;
  
   // Setting of vtkImageProperty
 	m_ImageProperty = vtkImageProperty::New();
@@ -155,6 +161,14 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
     m_ImageProperty = NULL;
     }
 
+  if ( m_ImageSliceMapper != NULL )
+    {
+    m_ImageSliceMapper->Delete();
+    m_ImageSliceMapper = NULL;
+    }
+
+  m_SliceAxes->Delete();
+
   if ( m_PlaneSource != NULL )
     {
     m_PlaneSource->Delete();
@@ -169,6 +183,7 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
 
   if ( m_ImageData )
     {
+    ResliceCache::Unsubscribe( m_ImageData, this );
     m_ImageData = NULL;
     }
 }
@@ -437,6 +452,8 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
 
   m_ImageSpatialObject->RemoveObserver( obsId );
 
+  ResliceCache::Subscribe( m_ImageData );
+
   m_ImageData->UpdateInformation();
   
   double range[2];
@@ -529,7 +546,8 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
   igstkLogMacro( DEBUG, "igstk::ImageResliceObjectRepresentation::\
                          UpdateRepresentationProcessing called...\n");
 
-  m_ReslicePlaneSpatialObject->RequestComputeReslicingPlane();
+  m_ReslicePlaneSpatialObject->RequestComputeReslicingPlane( 
+                                                   this->GetRenderTimeStamp() );
 
   m_ReslicerPlaneCenterObserver->Reset();
   m_ReslicerPlaneNormalObserver->Reset();  
@@ -562,7 +580,49 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
   else
     return;
 
-  m_ImageResliceMapper->SetSlicePlane(m_Plane);
+  this->UpdateSlice();
+}
+
+/** Get the slice from the cache and place it in the plane */
+template < class TImageSpatialObject >
+void
+ImageResliceObjectRepresentation< TImageSpatialObject >
+::UpdateSlice()
+{
+  if( !m_ImageData || !m_ImageSliceMapper )
+    {
+    return;
+    }
+
+  vtkImageData * slice = ResliceCache::GetSlice( m_ImageData,
+                                                 m_Plane->GetOrigin(),
+                                                 m_Plane->GetNormal(),
+                                                 m_ResliceInterpolate,
+                                                 m_SliceAxes,
+                                                 this );
+  if( !slice )
+    {
+    return;
+    }
+
+  if( m_ImageSliceMapper->GetInput() != slice )
+    {
+    m_ImageSliceMapper->SetInput( slice );
+    }
+
+  // Moving the actor modifies the scene, so it is only done when the plane
+  // has changed
+  if( m_Plane->GetMTime() == m_SlicePlaneMTime )
+    {
+    return;
+    }
+  m_SlicePlaneMTime = m_Plane->GetMTime();
+
+  vtkTransform * placement = vtkTransform::New();
+  placement->SetMatrix( m_SliceAxes );
+  m_ImageSlice->SetOrientation( placement->GetOrientation() );
+  m_ImageSlice->SetPosition( placement->GetPosition() );
+  placement->Delete();
 }
 
 /** Create the vtk Actors */
@@ -606,14 +666,19 @@ ImageResliceObjectRepresentation< TImageSpatialObject >
 {
   this->SetResliceInterpolate(m_ResliceInterpolate);
 
-  // Setting of vtkImageResliceMapper
-	m_ImageResliceMapper = vtkImageResliceMapper::New();
-  m_ImageResliceMapper->SetInput(m_ImageData);
-  m_ImageResliceMapper->SetSlicePlane(m_Plane);
-  m_ImageResliceMapper->BorderOn();
+  // The mapper displays the slice shared through the ResliceCache
+  if( m_ImageSliceMapper != NULL )
+    {
+    m_ImageSliceMapper->Delete();
+    }
+  m_ImageSliceMapper = vtkImageSliceMapper::New();
+  m_ImageSliceMapper->BorderOn();
+
+  m_ImageSlice->SetMapper(m_ImageSliceMapper);
+  m_ImageSlice->SetProperty(m_ImageProperty);
 
-	m_ImageSlice->SetMapper(m_ImageResliceMapper);
-	m_ImageSlice->SetProperty(m_ImageProperty);
+  m_SlicePlaneMTime = 0;
+  this->UpdateSlice();
 }
 
 template < class TImageSpatialObject >
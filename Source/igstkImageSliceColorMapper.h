@@ -0,0 +1,147 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkImageSliceColorMapper.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkImageSliceColorMapper_h
+#define __igstkImageSliceColorMapper_h
+
+#include <list>
+#include <vector>
+
+namespace igstk
+{
+
+/** \class ImageSliceColorMapper
+ * \brief Maps orthogonal slices of a volume to RGBA through a window/level
+ * table.
+ *
+ * Only the requested slice is mapped. The window and level are applied
+ * through a table of packed RGBA values that covers every value of 8 and 16
+ * bit pixel types, so that mapping a pixel is a single lookup. Other pixel
+ * types use a table of 4096 entries spanning the window.
+ *
+ * Axial slices are read in place from the volume. Sagittal and coronal
+ * slices are gathered from strided memory, and the last gathered slices are
+ * kept in a cache, so that window/level changes and going back and forth
+ * between slices do not read the volume again.
+ *
+ * The volume buffer is not owned. SetVolume() must be called again when the
+ * buffer or its content changes, which also empties the cache.
+ *
+ * \ingroup ObjectRepresentation
+ */
+template < class TPixelType >
+class ImageSliceColorMapper
+{
+
+public:
+
+  typedef TPixelType          PixelType;
+
+  /** Packed RGBA value, in the byte order of the output */
+  typedef unsigned int        RGBAType;
+
+  /** Axis normal to the slices. Sagittal slices are normal to X, coronal
+   *  slices to Y and axial slices to Z. */
+  typedef enum
+    {
+    Sagittal = 0,
+    Coronal = 1,
+    Axial = 2
+    }
+  AxisType;
+
+  ImageSliceColorMapper();
+
+  /** Set the volume, stored with X varying fastest */
+  void SetVolume( const PixelType * buffer, const int dimensions[3] );
+
+  /** Values from level - window/2 to level + window/2 are mapped linearly
+   *  from black to the color. */
+  void SetWindowLevel( double window, double level );
+
+  /** Color of the brightest value, components in [0,1] */
+  void SetColor( double red, double green, double blue, double opacity );
+
+  /** Number of sagittal and coronal slices kept in the cache. Default is
+   *  16. */
+  void SetCacheSize( unsigned int numberOfSlices );
+  unsigned int GetCacheSize() const { return m_CacheSize; }
+
+  /** Width and height of the slices normal to an axis */
+  void GetSliceSize( AxisType axis, int & width, int & height ) const;
+
+  /** Map a slice to width * height RGBA values, with the first in-plane
+   *  axis varying fastest. Returns false if there is no volume or the slice
+   *  is out of range. */
+  bool MapSlice( AxisType axis, int slice, unsigned char * rgba );
+
+  /** Statistics of the cache */
+  unsigned long GetNumberOfCacheHits() const { return m_CacheHits; }
+  unsigned long GetNumberOfCacheMisses() const { return m_CacheMisses; }
+
+private:
+
+  /** Table over the whole range of the pixel type when it is small enough */
+  static bool UseDenseTable();
+
+  void ComputeTable();
+
+  /** Pixels of a slice, read in place or from the cache */
+  const PixelType * GetSlicePixels( AxisType axis, int slice );
+
+  /** Gather a sagittal or coronal slice */
+  void ExtractSlice( AxisType axis, int slice, PixelType * pixels ) const;
+
+  void MapPixels( const PixelType * pixels, unsigned int numberOfPixels,
+                  RGBAType * rgba ) const;
+
+  const PixelType *       m_Volume;
+  int                     m_Dimensions[3];
+
+  double                  m_Window;
+  double                  m_Level;
+  double                  m_Color[4];
+
+  std::vector< RGBAType > m_Table;
+  bool                    m_TableModified;
+
+  /** Sparse table parameters */
+  double                  m_TableLower;
+  double                  m_TableScale;
+
+  struct CachedSlice
+    {
+    AxisType                  m_Axis;
+    int                       m_Slice;
+    std::vector< PixelType >  m_Pixels;
+    };
+
+  /** Most recently used first */
+  std::list< CachedSlice >  m_Cache;
+  unsigned int              m_CacheSize;
+  unsigned long             m_CacheHits;
+  unsigned long             m_CacheMisses;
+
+};
+
+} // end namespace igstk
+
+#ifndef IGSTK_MANUAL_INSTANTIATION
+#include "igstkImageSliceColorMapper.txx"
+#endif
+
+#endif // __igstkImageSliceColorMapper_h
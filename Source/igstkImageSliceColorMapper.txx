@@ -0,0 +1,371 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkImageSliceColorMapper.txx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkImageSliceColorMapper_txx
+#define __igstkImageSliceColorMapper_txx
+
+#include "igstkImageSliceColorMapper.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace igstk
+{
+
+/** Number of entries of the table spanning the window, for the pixel types
+ *  that are not covered entirely */
+static const unsigned int ImageSliceColorMapperSparseTableSize = 4096;
+
+/** Constructor */
+template < class TPixelType >
+ImageSliceColorMapper< TPixelType >
+::ImageSliceColorMapper()
+{
+  m_Volume = NULL;
+  m_Dimensions[0] = 0;
+  m_Dimensions[1] = 0;
+  m_Dimensions[2] = 0;
+
+  m_Window = 2000.0;
+  m_Level = 0.0;
+  m_Color[0] = 1.0;
+  m_Color[1] = 1.0;
+  m_Color[2] = 1.0;
+  m_Color[3] = 1.0;
+
+  m_TableModified = true;
+  m_TableLower = 0.0;
+  m_TableScale = 1.0;
+
+  m_CacheSize = 16;
+  m_CacheHits = 0;
+  m_CacheMisses = 0;
+}
+
+/** Set the volume */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::SetVolume( const PixelType * buffer, const int dimensions[3] )
+{
+  m_Volume = buffer;
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    m_Dimensions[i] = buffer ? std::max( dimensions[i], 0 ) : 0;
+    }
+  m_Cache.clear();
+}
+
+/** Set the window and level */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::SetWindowLevel( double window, double level )
+{
+  if( window != m_Window || level != m_Level )
+    {
+    m_Window = window;
+    m_Level = level;
+    m_TableModified = true;
+    }
+}
+
+/** Set the color */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::SetColor( double red, double green, double blue, double opacity )
+{
+  const double color[4] = { red, green, blue, opacity };
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    if( color[i] != m_Color[i] )
+      {
+      m_Color[i] = color[i];
+      m_TableModified = true;
+      }
+    }
+}
+
+/** Set the size of the cache */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::SetCacheSize( unsigned int numberOfSlices )
+{
+  m_CacheSize = numberOfSlices;
+  while( m_Cache.size() > std::max( m_CacheSize, 1u ) )
+    {
+    m_Cache.pop_back();
+    }
+}
+
+/** Size of the slices */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::GetSliceSize( AxisType axis, int & width, int & height ) const
+{
+  switch( axis )
+    {
+    case Sagittal:
+      width = m_Dimensions[1];
+      height = m_Dimensions[2];
+      break;
+    case Coronal:
+      width = m_Dimensions[0];
+      height = m_Dimensions[2];
+      break;
+    case Axial:
+    default:
+      width = m_Dimensions[0];
+      height = m_Dimensions[1];
+      break;
+    }
+}
+
+/** 8 and 16 bit integers are mapped with a table over their whole range */
+template < class TPixelType >
+bool
+ImageSliceColorMapper< TPixelType >
+::UseDenseTable()
+{
+  return std::numeric_limits< PixelType >::is_integer && 
+         sizeof( PixelType ) <= 2;
+}
+
+/** Compute the RGBA table for the window, the level and the color */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::ComputeTable()
+{
+  unsigned char bytes[4];
+  bytes[3] = static_cast< unsigned char >( 
+              255.0 * std::min( std::max( m_Color[3], 0.0 ), 1.0 ) + 0.5 );
+
+  double lower = m_Level - m_Window / 2.0;
+  double firstValue;
+  double valueStep;
+  unsigned int tableSize;
+
+  if( UseDenseTable() )
+    {
+    firstValue = static_cast< double >( 
+                                  std::numeric_limits< PixelType >::min() );
+    tableSize = static_cast< unsigned int >( 
+        static_cast< double >( std::numeric_limits< PixelType >::max() ) - 
+                                                            firstValue + 1.0 );
+    valueStep = 1.0;
+    }
+  else
+    {
+    // The entries sample the window, values outside are clamped
+    tableSize = ImageSliceColorMapperSparseTableSize;
+    firstValue = lower;
+    valueStep = m_Window > 0.0 ? m_Window / ( tableSize - 1 ) : 0.0;
+    m_TableLower = lower;
+    m_TableScale = m_Window > 0.0 ? ( tableSize - 1 ) / m_Window : 1e30;
+    }
+
+  m_Table.resize( tableSize );
+
+  for( unsigned int i = 0; i < tableSize; i++ )
+    {
+    const double value = firstValue + i * valueStep;
+
+    // A null window is a threshold at the level
+    double intensity;
+    if( m_Window > 0.0 )
+      {
+      intensity = ( value - lower ) / m_Window;
+      intensity = std::min( std::max( intensity, 0.0 ), 1.0 );
+      }
+    else if( UseDenseTable() )
+      {
+      intensity = ( value >= m_Level ) ? 1.0 : 0.0;
+      }
+    else
+      {
+      intensity = ( i > 0 ) ? 1.0 : 0.0;
+      }
+
+    for( unsigned int c = 0; c < 3; c++ )
+      {
+      bytes[c] = static_cast< unsigned char >( 
+        255.0 * intensity * std::min( std::max( m_Color[c], 0.0 ), 1.0 ) 
+                                                                      + 0.5 );
+      }
+    std::memcpy( &m_Table[i], bytes, sizeof( RGBAType ) );
+    }
+
+  m_TableModified = false;
+}
+
+/** Gather a sagittal or coronal slice */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::ExtractSlice( AxisType axis, int slice, PixelType * pixels ) const
+{
+  const std::size_t dx = m_Dimensions[0];
+  const std::size_t dy = m_Dimensions[1];
+  const std::size_t dz = m_Dimensions[2];
+
+  if( axis == Sagittal )
+    {
+    for( std::size_t z = 0; z < dz; z++ )
+      {
+      const PixelType * in = m_Volume + z * dx * dy + slice;
+      PixelType * out = pixels + z * dy;
+      for( std::size_t y = 0; y < dy; y++ )
+        {
+        out[y] = in[y * dx];
+        }
+      }
+    }
+  else
+    {
+    // Coronal rows are contiguous in the volume
+    for( std::size_t z = 0; z < dz; z++ )
+      {
+      const PixelType * in = m_Volume + ( z * dy + slice ) * dx;
+      std::copy( in, in + dx, pixels + z * dx );
+      }
+    }
+}
+
+/** Pixels of a slice */
+template < class TPixelType >
+const typename ImageSliceColorMapper< TPixelType >::PixelType *
+ImageSliceColorMapper< TPixelType >
+::GetSlicePixels( AxisType axis, int slice )
+{
+  if( axis == Axial )
+    {
+    return m_Volume + static_cast< std::size_t >( slice ) * 
+                                           m_Dimensions[0] * m_Dimensions[1];
+    }
+
+  typename std::list< CachedSlice >::iterator it = m_Cache.begin();
+  while( it != m_Cache.end() )
+    {
+    if( it->m_Axis == axis && it->m_Slice == slice )
+      {
+      m_CacheHits++;
+      m_Cache.splice( m_Cache.begin(), m_Cache, it );
+      return &m_Cache.front().m_Pixels[0];
+      }
+    ++it;
+    }
+
+  m_CacheMisses++;
+
+  int width;
+  int height;
+  this->GetSliceSize( axis, width, height );
+
+  // Without a cache the slice is still kept until the next call. When the
+  // cache is full the storage of the least recently used slice is reused.
+  const unsigned int capacity = std::max( m_CacheSize, 1u );
+  if( m_Cache.size() >= capacity )
+    {
+    m_Cache.splice( m_Cache.begin(), m_Cache, --m_Cache.end() );
+    }
+  else
+    {
+    m_Cache.push_front( CachedSlice() );
+    }
+
+  CachedSlice & cached = m_Cache.front();
+  cached.m_Axis = axis;
+  cached.m_Slice = slice;
+  cached.m_Pixels.resize( static_cast< std::size_t >( width ) * height );
+
+  this->ExtractSlice( axis, slice, &cached.m_Pixels[0] );
+
+  return &cached.m_Pixels[0];
+}
+
+/** Map pixels through the table, one lookup per pixel. */
+template < class TPixelType >
+void
+ImageSliceColorMapper< TPixelType >
+::MapPixels( const PixelType * pixels, unsigned int numberOfPixels,
+             RGBAType * rgba ) const
+{
+  const RGBAType * table = &m_Table[0];
+
+  if( UseDenseTable() )
+    {
+    const int offset = 
+          static_cast< int >( std::numeric_limits< PixelType >::min() );
+    for( unsigned int i = 0; i < numberOfPixels; i++ )
+      {
+      rgba[i] = table[ static_cast< int >( pixels[i] ) - offset ];
+      }
+    }
+  else
+    {
+    const double lower = m_TableLower;
+    const double scale = m_TableScale;
+    const double last = static_cast< double >( m_Table.size() - 1 );
+    for( unsigned int i = 0; i < numberOfPixels; i++ )
+      {
+      double index = ( static_cast< double >( pixels[i] ) - lower ) * scale;
+      // Written so that NaN maps to the first entry
+      index = ( index > 0.0 ) ? index : 0.0;
+      index = ( index < last ) ? index : last;
+      rgba[i] = table[ static_cast< unsigned int >( index + 0.5 ) ];
+      }
+    }
+}
+
+/** Map a slice */
+template < class TPixelType >
+bool
+ImageSliceColorMapper< TPixelType >
+::MapSlice( AxisType axis, int slice, unsigned char * rgba )
+{
+  if( !m_Volume || slice < 0 || slice >= m_Dimensions[axis] )
+    {
+    return false;
+    }
+
+  if( m_TableModified )
+    {
+    this->ComputeTable();
+    }
+
+  int width;
+  int height;
+  this->GetSliceSize( axis, width, height );
+
+  const PixelType * pixels = this->GetSlicePixels( axis, slice );
+
+  // The output of VTK is allocated with new[], suitably aligned for the
+  // packed values.
+  this->MapPixels( pixels, static_cast< unsigned int >( width * height ),
+                   reinterpret_cast< RGBAType * >( rgba ) );
+
+  return true;
+}
+
+} // end namespace igstk
+
+#endif
@@ -47,6 +47,10 @@ class UltrasoundImageSimulatorToImageSpatialObject;
  * The ITK and VTK layers are concealed in order to enforce the safety of the
  * IGSTK layer.
  *
+ * The VTK importer reads the buffer of the ITK image without copying it, so
+ * an image whose pixels are memory mapped, see MemoryMappedImageContainer,
+ * stays out of core for both layers.
+ *
  * \ingroup Object
  */
 template < class TPixelType, unsigned int TDimension >
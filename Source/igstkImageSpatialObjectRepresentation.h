@@ -21,10 +21,9 @@
 #include "igstkObjectRepresentation.h"
 #include "igstkImageSpatialObject.h"
 #include "igstkStateMachine.h"
+#include "igstkImageSliceColorMapper.h"
 
 #include "vtkImageActor.h"
-#include "vtkLookupTable.h"
-#include "vtkImageMapToColors.h"
 
 namespace igstk
 {
@@ -38,6 +37,11 @@ namespace igstk
  * You can select the orientation of the slice to be Axial, Sagittal or Coronal.
  * The number of the slice to be rendered can also be selected, as well as 
  * values of opacity, window and level.
+ *
+ * Only the displayed slice is mapped to colors, through a window/level table
+ * computed once per window/level change. Sagittal and coronal slices read
+ * from the volume are cached, so that dragging the window/level and
+ * scrolling back and forth do not read the volume again.
  * 
  *\image html igstkImageSpatialObjectRepresentation.png "State Machine Diagram"
  *
@@ -95,6 +99,10 @@ public:
 
   /** Set the opacity */
   void SetOpacity(float alpha);
+
+  /** Number of sagittal and coronal slices kept in memory for window/level
+   *  changes. Default is 16. */
+  void SetSliceCacheSize( unsigned int numberOfSlices );
   
   /** Print the object information in a stream. */
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const; 
@@ -138,8 +146,19 @@ private:
   /** VTK classes that support display of an image */
   vtkImageData                         * m_ImageData;
   vtkImageActor                        * m_ImageActor;
-  vtkLookupTable                       * m_LUT;
-  vtkImageMapToColors                  * m_MapColors;
+
+  /** Colors of the displayed slice, and the engine computing them */
+  typedef typename ImageSpatialObjectType::ImageType::PixelType  PixelType;
+  typedef ImageSliceColorMapper< PixelType >     SliceColorMapperType;
+
+  vtkImageData                         * m_SliceImage;
+  SliceColorMapperType                   m_SliceColorMapper;
+  int                                    m_SliceExtent[6];
+  bool                                   m_SliceModified;
+
+  /** Volume last given to the mapper */
+  const void                           * m_VolumePointer;
+  unsigned long                          m_VolumeMTime;
 
   /** Variables that store window and level values for 2D image display */
   double                                 m_Level;
@@ -174,6 +193,10 @@ private:
 
   /** Connect VTK pipeline */
   void ConnectVTKPipelineProcessing();
+
+  /** Map the current slice, if the volume, the slice, the orientation or
+   *  the colors changed since the last call */
+  void UpdateSlice();
     
 private:
 
@@ -28,7 +28,9 @@
 #include "vtkPolyDataMapper.h"
 #include "vtkProperty.h"
 #include "vtkImageData.h"
-#include "vtkMath.h"
+#include "vtkPointData.h"
+
+#include <algorithm>
 
 namespace igstk
 {
@@ -49,13 +51,22 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
   m_ImageActor = vtkImageActor::New();
   this->AddActor( m_ImageActor );
 
-  m_MapColors  = vtkImageMapToColors::New();
-  m_LUT        = vtkLookupTable::New();
   m_ImageData  = NULL;
+  m_SliceImage = vtkImageData::New();
+
+  for( unsigned int i = 0; i < 6; i++ )
+    {
+    m_SliceExtent[i] = 0;
+    }
+  m_SliceNumber = 0;
+  m_SliceModified = true;
+  m_VolumePointer = NULL;
+  m_VolumeMTime = 0;
 
   // Set default values for window and level
   m_Level = 0;
   m_Window = 2000;
+  m_SliceColorMapper.SetWindowLevel( m_Window, m_Level );
   
   // Create the observer to VTK image events 
   m_VTKImageObserver = VTKImageObserver::New();
@@ -184,19 +195,10 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
   this->DeleteActors();
 
 
-  if( m_MapColors )
-    {
-    m_MapColors->SetLookupTable( NULL );
-    m_MapColors->SetInput( NULL );
-    m_MapColors->Delete();
-    m_MapColors = NULL;
-    }
-
-    
-  if( m_LUT )
+  if( m_SliceImage )
     {
-    m_LUT->Delete();
-    m_LUT = NULL;
+    m_SliceImage->Delete();
+    m_SliceImage = NULL;
     }
 }
 
@@ -269,7 +271,7 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
   igstkLogMacro( DEBUG, "igstk::ImageSpatialObjectRepresentation\
                         ::SetOrientationProcessing called...\n");
   m_Orientation = m_OrientationToBeSet;
- 
+  m_SliceModified = true;
 }
   
 
@@ -348,25 +350,9 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
 
   m_SliceNumber = m_SliceNumberToBeSet;
 
-  int ext[6];
-  m_ImageData->GetExtent( ext );
-
-  switch( m_Orientation )
-    {
-    case Axial:
-      m_ImageActor->SetDisplayExtent( ext[0], ext[1], ext[2], 
-                                      ext[3], m_SliceNumber, m_SliceNumber );
-      break;
-    case Sagittal:
-      m_ImageActor->SetDisplayExtent( m_SliceNumber, m_SliceNumber, 
-                                      ext[2], ext[3], ext[4], ext[5] );
-      break;
-    case Coronal:
-      m_ImageActor->SetDisplayExtent( ext[0], ext[1], m_SliceNumber, 
-                                      m_SliceNumber, ext[4], ext[5] );
-      break;
-    }
-
+  // The slice is mapped on the next update of the representation, so that
+  // fast scrolling maps at most one slice per frame.
+  m_SliceModified = true;
 }
 
 
@@ -381,7 +367,19 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
   m_Window = window;
   m_Level = level;
 
-  m_LUT->SetTableRange ( (m_Level - m_Window/2.0), (m_Level + m_Window/2.0) );
+  // Only the table is computed here, the slice is mapped on the next update
+  // of the representation.
+  m_SliceColorMapper.SetWindowLevel( m_Window, m_Level );
+  m_SliceModified = true;
+}
+
+/** Set the number of slices kept in memory */
+template < class TImageSpatialObject >
+void 
+ImageSpatialObjectRepresentation< TImageSpatialObject >
+::SetSliceCacheSize( unsigned int numberOfSlices )
+{
+  m_SliceColorMapper.SetCacheSize( numberOfSlices );
 }
 
 /** Null Operation for a State Machine Transition */
@@ -428,7 +426,8 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
       {
       this->m_ImageData->Update();
       }
-    this->m_MapColors->SetInput( this->m_ImageData );
+    this->m_VolumePointer = NULL;
+    this->m_SliceModified = true;
     }
 
   this->m_ImageTransformObserver->Reset();
@@ -452,7 +451,8 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
     imageTransformMatrix->Delete();
     }
 
-  this->m_ImageActor->SetInput( this->m_MapColors->GetOutput() );
+  this->m_ImageActor->SetInput( this->m_SliceImage );
+  this->UpdateSlice();
 }
 
 
@@ -463,6 +463,15 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
 ::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "Window: " << m_Window << std::endl;
+  os << indent << "Level: " << m_Level << std::endl;
+  os << indent << "SliceCacheSize: " 
+     << m_SliceColorMapper.GetCacheSize() << std::endl;
+  os << indent << "SliceCacheHits: " 
+     << m_SliceColorMapper.GetNumberOfCacheHits() << std::endl;
+  os << indent << "SliceCacheMisses: " 
+     << m_SliceColorMapper.GetNumberOfCacheMisses() << std::endl;
 }
 
 
@@ -475,10 +484,98 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
 {
   igstkLogMacro( DEBUG, "igstk::ImageSpatialObjectRepresentation\
                        ::UpdateRepresentationProcessing called...\n");
-  if( m_ImageData )
+  this->UpdateSlice();
+}
+
+
+/** Map the displayed slice */
+template < class TImageSpatialObject >
+void
+ImageSpatialObjectRepresentation< TImageSpatialObject >
+::UpdateSlice()
+{
+  if( !m_ImageData || !m_ImageActor )
+    {
+    return;
+    }
+
+  // Brings in the changes of the ITK image, e.g. during progressive loading
+  m_ImageData->Update();
+
+  if( m_ImageData->GetNumberOfScalarComponents() != 1 ||
+      m_ImageData->GetScalarSize() != sizeof( PixelType ) )
     {
-    m_MapColors->SetInput( m_ImageData );
+    igstkLogMacro( DEBUG, "igstk::ImageSpatialObjectRepresentation\
+                          ::UpdateSlice unexpected scalar type\n");
+    return;
     }
+
+  int ext[6];
+  m_ImageData->GetExtent( ext );
+
+  const void * volume = m_ImageData->GetScalarPointer();
+  if( volume != m_VolumePointer || m_ImageData->GetMTime() != m_VolumeMTime )
+    {
+    const int dimensions[3] = { ext[1] - ext[0] + 1,
+                                ext[3] - ext[2] + 1,
+                                ext[5] - ext[4] + 1 };
+    m_SliceColorMapper.SetVolume( static_cast< const PixelType * >( volume ),
+                                  dimensions );
+    m_VolumePointer = volume;
+    m_VolumeMTime = m_ImageData->GetMTime();
+    m_SliceModified = true;
+    }
+
+  if( !m_SliceModified )
+    {
+    return;
+    }
+
+  typename SliceColorMapperType::AxisType axis = SliceColorMapperType::Axial;
+  switch( m_Orientation )
+    {
+    case Axial:
+      axis = SliceColorMapperType::Axial;
+      break;
+    case Sagittal:
+      axis = SliceColorMapperType::Sagittal;
+      break;
+    case Coronal:
+      axis = SliceColorMapperType::Coronal;
+      break;
+    }
+
+  int slice = static_cast< int >( m_SliceNumber );
+  slice = std::max( std::min( slice, ext[2*axis+1] ), ext[2*axis] );
+
+  int sliceExtent[6];
+  std::copy( ext, ext + 6, sliceExtent );
+  sliceExtent[2*axis] = slice;
+  sliceExtent[2*axis+1] = slice;
+
+  // The slice image has the geometry of the volume, so the actor places it
+  // exactly where the slice of the volume would be.
+  if( !std::equal( sliceExtent, sliceExtent + 6, m_SliceExtent ) ||
+      !m_SliceImage->GetPointData()->GetScalars() )
+    {
+    m_SliceImage->SetScalarTypeToUnsignedChar();
+    m_SliceImage->SetNumberOfScalarComponents( 4 );
+    m_SliceImage->SetExtent( sliceExtent );
+    m_SliceImage->SetWholeExtent( sliceExtent );
+    m_SliceImage->AllocateScalars();
+    std::copy( sliceExtent, sliceExtent + 6, m_SliceExtent );
+    }
+  m_SliceImage->SetSpacing( m_ImageData->GetSpacing() );
+  m_SliceImage->SetOrigin( m_ImageData->GetOrigin() );
+
+  unsigned char * rgba = 
+    static_cast< unsigned char * >( m_SliceImage->GetScalarPointer() );
+  m_SliceColorMapper.MapSlice( axis, slice - ext[2*axis], rgba );
+  m_SliceImage->Modified();
+
+  m_ImageActor->SetDisplayExtent( sliceExtent );
+
+  m_SliceModified = false;
 }
 
 
@@ -500,24 +597,11 @@ ImageSpatialObjectRepresentation< TImageSpatialObject >
     
   this->AddActor( m_ImageActor );
 
-  //convert RGB to HSV
-  double hue = 0.0;
-  double saturation = 0.0;
-  double value = 1.0;
-
-  vtkMath::RGBToHSV( this->GetRed(),
-                     this->GetGreen(),
-                     this->GetBlue(),
-                     &hue,&saturation,&value );
-
-  m_LUT->SetTableRange ( (m_Level - m_Window/2.0), (m_Level + m_Window/2.0) );
-  m_LUT->SetSaturationRange (saturation, saturation);
-  m_LUT->SetAlphaRange (m_Opacity, m_Opacity);
-  m_LUT->SetHueRange (hue, hue);
-  m_LUT->SetValueRange (0, value);
-  m_LUT->SetRampToLinear();
-
-  m_MapColors->SetLookupTable( m_LUT );
+  // The values of the window are ramped linearly from black to the color
+  m_SliceColorMapper.SetWindowLevel( m_Window, m_Level );
+  m_SliceColorMapper.SetColor( this->GetRed(), this->GetGreen(), 
+                               this->GetBlue(), m_Opacity );
+  m_SliceModified = true;
 
   igstkPushInputMacro( ConnectVTKPipeline );
   m_StateMachine.ProcessInputs(); 
@@ -614,9 +698,9 @@ void
 ImageSpatialObjectRepresentation< TImageSpatialObject >
 ::ConnectVTKPipelineProcessing() 
 {
-  m_MapColors->SetInput( m_ImageData );
-  m_ImageActor->SetInput( m_MapColors->GetOutput() );
+  m_ImageActor->SetInput( m_SliceImage );
   m_ImageActor->InterpolateOn();
+  this->UpdateSlice();
 }
 
 /** Set the opacity */
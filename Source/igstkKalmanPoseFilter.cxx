@@ -0,0 +1,204 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkKalmanPoseFilter.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkKalmanPoseFilter.h"
+
+#include <cmath>
+
+namespace igstk
+{
+
+/** Constructor */
+KalmanPoseFilter::KalmanPoseFilter()
+{
+  m_ProcessNoise = 1000.0;
+  m_MeasurementNoise = 0.25;
+  m_RotationProcessNoise = 1.0;
+  m_RotationMeasurementNoise = 2.5e-5;
+
+  TransformBatch::SetToIdentity( m_Estimate );
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    m_Velocity[k] = 0.0;
+    m_AngularVelocity[k] = 0.0;
+    }
+  for( unsigned int k = 0; k < 6; k++ )
+    {
+    InitializeAxis( m_Axes[k], 0.0, 0.0 );
+    }
+  m_PreviousTime = 0.0;
+}
+
+/** Destructor */
+KalmanPoseFilter::~KalmanPoseFilter()
+{
+}
+
+
+void
+KalmanPoseFilter::InitializeAxis( Axis & axis, double measurementNoise,
+                                  double velocityVariance )
+{
+  axis.m_PositionVariance = measurementNoise;
+  axis.m_Covariance = 0.0;
+  axis.m_VelocityVariance = velocityVariance;
+}
+
+
+void
+KalmanPoseFilter::PredictAxis( Axis & axis, double period,
+                               double processNoise )
+{
+  // P = F P F' + Q, with F = [ 1 T ; 0 1 ] and the noise of a constant
+  // velocity model with white accelerations
+  const double period2 = period * period;
+  axis.m_PositionVariance += period * ( 2.0 * axis.m_Covariance +
+                                        period * axis.m_VelocityVariance ) +
+                             processNoise * period2 * period / 3.0;
+  axis.m_Covariance += period * axis.m_VelocityVariance +
+                       processNoise * period2 / 2.0;
+  axis.m_VelocityVariance += processNoise * period;
+}
+
+
+void
+KalmanPoseFilter::CorrectAxis( Axis & axis, double innovation,
+                               double measurementNoise,
+                               double & positionCorrection,
+                               double & velocityCorrection )
+{
+  const double innovationVariance =
+    axis.m_PositionVariance + measurementNoise;
+  const double positionGain = axis.m_PositionVariance / innovationVariance;
+  const double velocityGain = axis.m_Covariance / innovationVariance;
+
+  positionCorrection = positionGain * innovation;
+  velocityCorrection = velocityGain * innovation;
+
+  axis.m_VelocityVariance -= velocityGain * axis.m_Covariance;
+  axis.m_PositionVariance *= 1.0 - positionGain;
+  axis.m_Covariance *= 1.0 - positionGain;
+}
+
+
+void
+KalmanPoseFilter::InternalFilterPose( Pose & pose, TimePeriodType time,
+                                      bool firstPose )
+{
+  if( firstPose )
+    {
+    // The velocities are unknown: about 100 mm/s and 1 rad/s
+    m_Estimate = pose;
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      m_Velocity[k] = 0.0;
+      m_AngularVelocity[k] = 0.0;
+      InitializeAxis( m_Axes[k], m_MeasurementNoise, 1.0e4 );
+      InitializeAxis( m_Axes[k + 3], m_RotationMeasurementNoise, 1.0 );
+      }
+    m_PreviousTime = time;
+    return;
+    }
+
+  double period = ( time - m_PreviousTime ) / 1000.0;
+  if( period < 0.0 )
+    {
+    period = 0.0;
+    }
+  m_PreviousTime = time;
+
+  // Prediction
+  double rotationStep[3];
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    m_Estimate.m_Translation[k] += m_Velocity[k] * period;
+    rotationStep[k] = m_AngularVelocity[k] * period;
+    PredictAxis( m_Axes[k], period, m_ProcessNoise );
+    PredictAxis( m_Axes[k + 3], period, m_RotationProcessNoise );
+    }
+  double step[4];
+  VectorToRotation( rotationStep, step );
+  MultiplyRotations( m_Estimate.m_Rotation, step, m_Estimate.m_Rotation );
+
+  // Correction of the translation
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    double positionCorrection;
+    double velocityCorrection;
+    CorrectAxis( m_Axes[k],
+                 pose.m_Translation[k] - m_Estimate.m_Translation[k],
+                 m_MeasurementNoise, positionCorrection, velocityCorrection );
+    m_Estimate.m_Translation[k] += positionCorrection;
+    m_Velocity[k] += velocityCorrection;
+    }
+
+  // Correction of the rotation, by the rotation from the predicted to the
+  // measured rotation in the coordinate system of the tool
+  double inverse[4];
+  InvertRotation( m_Estimate.m_Rotation, inverse );
+  double difference[4];
+  MultiplyRotations( inverse, pose.m_Rotation, difference );
+  double innovation[3];
+  RotationToVector( difference, innovation );
+
+  double rotationCorrection[3];
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    double velocityCorrection;
+    CorrectAxis( m_Axes[k + 3], innovation[k], m_RotationMeasurementNoise,
+                 rotationCorrection[k], velocityCorrection );
+    m_AngularVelocity[k] += velocityCorrection;
+    }
+  VectorToRotation( rotationCorrection, step );
+  MultiplyRotations( m_Estimate.m_Rotation, step, m_Estimate.m_Rotation );
+
+  // The products of versors drift away from the unit norm
+  double norm = 0.0;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    norm += m_Estimate.m_Rotation[k] * m_Estimate.m_Rotation[k];
+    }
+  norm = std::sqrt( norm );
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    m_Estimate.m_Rotation[k] /= norm;
+    }
+
+  pose = m_Estimate;
+}
+
+
+/** Print Self function */
+void
+KalmanPoseFilter::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "ProcessNoise: " << m_ProcessNoise << std::endl;
+  os << indent << "MeasurementNoise: " << m_MeasurementNoise << std::endl;
+  os << indent << "RotationProcessNoise: "
+     << m_RotationProcessNoise << std::endl;
+  os << indent << "RotationMeasurementNoise: "
+     << m_RotationMeasurementNoise << std::endl;
+}
+
+} // end namespace igstk
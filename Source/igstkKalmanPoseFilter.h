@@ -0,0 +1,117 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkKalmanPoseFilter.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkKalmanPoseFilter_h
+#define __igstkKalmanPoseFilter_h
+
+#include "igstkPoseFilter.h"
+
+
+namespace igstk
+{
+
+/** \class KalmanPoseFilter
+ * \brief Kalman filter of the poses, for a tool moving at constant
+ *  velocity.
+ *
+ * The filter estimates the pose of the tool and its linear and angular
+ * velocities. Each pose is predicted from the previous estimate and
+ * velocities, then corrected by the measured pose. The rotation is
+ * corrected by the rotation vector from the predicted to the measured
+ * rotation, in the coordinate system of the tool, so that the estimate
+ * stays a versor.
+ *
+ * The six axes are filtered independently. ProcessNoise is the spectral
+ * density of the accelerations of the tool: a larger value follows the
+ * motions more closely. MeasurementNoise is the variance of the jitter of
+ * the measured poses: a larger value smooths more.
+ *
+ * \ingroup Object
+ */
+class KalmanPoseFilter : public PoseFilter
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( KalmanPoseFilter, PoseFilter )
+  igstkNewMacro( Self );
+
+  /** Variances of the translations [mm^2/s^3] and [mm^2] */
+  igstkSetMacro( ProcessNoise, double );
+  igstkGetMacro( ProcessNoise, double );
+  igstkSetMacro( MeasurementNoise, double );
+  igstkGetMacro( MeasurementNoise, double );
+
+  /** Variances of the rotations [rad^2/s^3] and [rad^2] */
+  igstkSetMacro( RotationProcessNoise, double );
+  igstkGetMacro( RotationProcessNoise, double );
+  igstkSetMacro( RotationMeasurementNoise, double );
+  igstkGetMacro( RotationMeasurementNoise, double );
+
+protected:
+
+  KalmanPoseFilter(void);
+  virtual ~KalmanPoseFilter(void);
+
+  virtual void InternalFilterPose( Pose & pose, TimePeriodType time,
+                                   bool firstPose );
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  KalmanPoseFilter(const Self&);    //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  /** State of one axis: the covariance of its position and velocity */
+  struct Axis
+    {
+    double m_PositionVariance;
+    double m_Covariance;
+    double m_VelocityVariance;
+    };
+
+  static void InitializeAxis( Axis & axis, double measurementNoise,
+                              double velocityVariance );
+  static void PredictAxis( Axis & axis, double period, double processNoise );
+
+  /** Correct an axis with the difference between the measured and the
+   *  predicted position, returning the corrections of the position and of
+   *  the velocity */
+  static void CorrectAxis( Axis & axis, double innovation,
+                           double measurementNoise,
+                           double & positionCorrection,
+                           double & velocityCorrection );
+
+  double           m_ProcessNoise;
+  double           m_MeasurementNoise;
+  double           m_RotationProcessNoise;
+  double           m_RotationMeasurementNoise;
+
+  Pose             m_Estimate;
+  double           m_Velocity[3];
+  double           m_AngularVelocity[3];
+  Axis             m_Axes[6];
+  TimePeriodType   m_PreviousTime;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkKalmanPoseFilter_h
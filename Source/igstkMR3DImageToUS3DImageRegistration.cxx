@@ -22,13 +22,18 @@
 #include "igstkMR3DImageToUS3DImageRegistration.h"
 #include "itkVersorRigid3DTransform.h"
 
-#include "itkImageRegistrationMethod.h"
+#include "itkMultiResolutionImageRegistrationMethod.h"
+#include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkMeanSquaresImageToImageMetric.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkRegularStepGradientDescentOptimizer.h"
+#include "itkCastImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 #include "itkImageFileWriter.h"
 
+#include <algorithm>
+
 namespace igstk
 {
 
@@ -83,6 +88,13 @@ private:
   LoggerType::Pointer    m_Logger; 
 };
 
+/** Seed used for sampling the fixed image, so that the results of a
+ *  registration are reproducible */
+const int SamplingSeed = 121212;
+
+/** Rate at which the progress of an asynchronous registration is reported */
+const double ProgressReportRate = 20.0;
+
 }
 
 /** Constructor */
@@ -91,11 +103,56 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
 {
   m_InitialTransform.SetToIdentity(10000);
 
+  m_NumberOfLevels = 3;
+  m_SamplingStrategy = RandomSampling;
+  m_SamplingPercentage = 0.1;
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_MaximumNumberOfIterations = 100;
+  m_MaximumStepLength = 4.0;
+  m_MinimumStepLength = 0.001;
+  m_TrackingNumberOfIterations = 20;
+  m_TrackingStepLength = 0.5;
+  m_TrackingSearchRadius = 5.0;
+
+  m_UltrasoundProbe = 0;
+  m_ProbeTransformValid = false;
+  m_ProbeTransformAtRegistrationValid = false;
+  m_PreviousSolutionAvailable = false;
+  m_TrackingRun = false;
+  m_OutsideSearchWindow = false;
+
+  m_TrackingFixedSource = 0;
+  m_TrackingFixedSourceMTime = 0;
+  m_TrackingMovingSource = 0;
+  m_TrackingMovingSourceMTime = 0;
+
+  m_ProgressLevel = 0;
+  m_ProgressIteration = 0;
+  m_ProgressMetricValue = 0.0;
+  m_ProgressUpdated = false;
+  m_StopRequested = false;
+  m_RegistrationFinished = false;
+  m_RegistrationSucceeded = false;
+  m_CurrentLevel = 0;
+
+  m_Threader = itk::MultiThreader::New();
+  m_ThreadID = -1;
+  m_ThreadRunning = false;
+
+  m_PulseGenerator = PulseGenerator::New();
+  m_PulseObserver = PulseObserverType::New();
+  m_PulseObserver->SetCallbackFunction( this,
+                  & MR3DImageToUS3DImageRegistration::PulseCallback );
+  m_PulseGenerator->AddObserver( PulseEvent(), m_PulseObserver );
+  m_PulseGenerator->RequestSetFrequency(
+          MR3DImageToUS3DImageRegistrationHelper::ProgressReportRate );
+
   // Set the state descriptors
   igstkAddStateMacro( Idle );
   igstkAddStateMacro( MRImageSet );
   igstkAddStateMacro( USImageSet );
   igstkAddStateMacro( ImagesSet );
+  igstkAddStateMacro( CalculatingRegistration );
   igstkAddStateMacro( RegistrationCalculated );
 
   // Set the input descriptors 
@@ -103,8 +160,15 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
   igstkAddInputMacro( ValidMovingMR3D );
   igstkAddInputMacro( ValidFixedUS3D );
   igstkAddInputMacro( ValidRegistration);
+  igstkAddInputMacro( InvalidRegistration);
+  igstkAddInputMacro( InvalidRegistrationUpdate);
   igstkAddInputMacro( ResetRegistration );
   igstkAddInputMacro( CalculateRegistration );
+  igstkAddInputMacro( StartRegistration );
+  igstkAddInputMacro( UpdateRegistration );
+  igstkAddInputMacro( StartRegistrationUpdate );
+  igstkAddInputMacro( StopRegistration );
+  igstkAddInputMacro( CheckRegistration );
   igstkAddInputMacro( RequestRegistrationTransform );
   igstkAddInputMacro( MRImageTransform );
   igstkAddInputMacro( USImageTransform  );
@@ -115,6 +179,8 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
   igstkAddTransitionMacro( Idle, ValidFixedUS3D, USImageSet, SetFixedUS3D );
   igstkAddTransitionMacro( Idle, CalculateRegistration, Idle, No );
   igstkAddTransitionMacro( Idle, CalculateRegistration, Idle, No );
+  igstkAddTransitionMacro( Idle, UpdateRegistration, Idle, No );
+  igstkAddTransitionMacro( Idle, StartRegistrationUpdate, Idle, No );
 
   // Add transition for MRImageSet state
   igstkAddTransitionMacro( MRImageSet, ResetRegistration, Idle, Reset );
@@ -124,6 +190,10 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
                            ImagesSet, SetFixedUS3D );
   igstkAddTransitionMacro( MRImageSet, CalculateRegistration, 
                            MRImageSet, No );
+  igstkAddTransitionMacro( MRImageSet, UpdateRegistration, 
+                           MRImageSet, No );
+  igstkAddTransitionMacro( MRImageSet, StartRegistrationUpdate, 
+                           MRImageSet, No );
   igstkAddTransitionMacro( MRImageSet, RequestRegistrationTransform, 
                            MRImageSet, No );
 
@@ -135,6 +205,10 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
                            USImageSet, SetFixedUS3D );
   igstkAddTransitionMacro( USImageSet, CalculateRegistration, 
                            USImageSet, No );
+  igstkAddTransitionMacro( USImageSet, UpdateRegistration, 
+                           USImageSet, No );
+  igstkAddTransitionMacro( USImageSet, StartRegistrationUpdate, 
+                           USImageSet, No );
   igstkAddTransitionMacro( USImageSet, RequestRegistrationTransform, 
                            USImageSet, No );
 
@@ -148,6 +222,18 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
                            ImagesSet, CalculateRegistration );
   igstkAddTransitionMacro( ImagesSet, ValidRegistration, 
                            RegistrationCalculated, No );
+  igstkAddTransitionMacro( ImagesSet, InvalidRegistration, 
+                           ImagesSet, ReportRegistrationFailure );
+  igstkAddTransitionMacro( ImagesSet, StartRegistration, 
+                           CalculatingRegistration, StartRegistration );
+  igstkAddTransitionMacro( ImagesSet, StopRegistration, 
+                           ImagesSet, No );
+  igstkAddTransitionMacro( ImagesSet, UpdateRegistration, 
+                           ImagesSet, UpdateRegistration );
+  igstkAddTransitionMacro( ImagesSet, StartRegistrationUpdate, 
+                           CalculatingRegistration, StartRegistrationUpdate );
+  igstkAddTransitionMacro( ImagesSet, InvalidRegistrationUpdate, 
+                           ImagesSet, ReportRegistrationFailure );
   igstkAddTransitionMacro( ImagesSet, RequestRegistrationTransform, 
                            ImagesSet, No );
   igstkAddTransitionMacro( ImagesSet, MRImageTransform,
@@ -164,11 +250,61 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
                            ImagesSet, SetFixedUS3D );
   igstkAddTransitionMacro( RegistrationCalculated, CalculateRegistration, 
                            RegistrationCalculated, CalculateRegistration );
+  igstkAddTransitionMacro( RegistrationCalculated, ValidRegistration, 
+                           RegistrationCalculated, No );
+  igstkAddTransitionMacro( RegistrationCalculated, InvalidRegistration, 
+                           ImagesSet, ReportRegistrationFailure );
+  igstkAddTransitionMacro( RegistrationCalculated, StartRegistration, 
+                           CalculatingRegistration, StartRegistration );
+  igstkAddTransitionMacro( RegistrationCalculated, StopRegistration, 
+                           RegistrationCalculated, No );
+  igstkAddTransitionMacro( RegistrationCalculated, UpdateRegistration, 
+                           RegistrationCalculated, UpdateRegistration );
+  igstkAddTransitionMacro( RegistrationCalculated, StartRegistrationUpdate, 
+                           CalculatingRegistration, StartRegistrationUpdate );
+  igstkAddTransitionMacro( RegistrationCalculated, 
+                           InvalidRegistrationUpdate, 
+                           RegistrationCalculated, ReportRegistrationFailure );
   igstkAddTransitionMacro( RegistrationCalculated, 
                            RequestRegistrationTransform, 
                            RegistrationCalculated, 
                            ReportRegistrationTransform );
 
+  // Add transition for CalculatingRegistration state
+  igstkAddTransitionMacro( CalculatingRegistration, CheckRegistration, 
+                           CalculatingRegistration, CheckRegistration );
+  igstkAddTransitionMacro( CalculatingRegistration, StopRegistration, 
+                           CalculatingRegistration, StopRegistration );
+  igstkAddTransitionMacro( CalculatingRegistration, ValidRegistration, 
+                           RegistrationCalculated, 
+                           ReportRegistrationCompleted );
+  igstkAddTransitionMacro( CalculatingRegistration, InvalidRegistration, 
+                           ImagesSet, ReportRegistrationFailure );
+  igstkAddTransitionMacro( CalculatingRegistration, 
+                           InvalidRegistrationUpdate, 
+                           RegistrationCalculated, ReportRegistrationFailure );
+  igstkAddTransitionMacro( CalculatingRegistration, ResetRegistration, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, ValidMovingMR3D, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, ValidFixedUS3D, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, CalculateRegistration, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, StartRegistration, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, UpdateRegistration, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, StartRegistrationUpdate, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, 
+                           RequestRegistrationTransform, 
+                           CalculatingRegistration, ReportInvalidRequest );
+  igstkAddTransitionMacro( CalculatingRegistration, MRImageTransform,
+                           CalculatingRegistration, No );
+  igstkAddTransitionMacro( CalculatingRegistration, USImageTransform,
+                           CalculatingRegistration, No );
+
   // Select the initial state of the state machine
   igstkSetInitialStateMacro( Idle );
 
@@ -183,6 +319,18 @@ MR3DImageToUS3DImageRegistration::MR3DImageToUS3DImageRegistration() :
 /** Destructor */
 MR3DImageToUS3DImageRegistration::~MR3DImageToUS3DImageRegistration()
 {
+  this->m_PulseGenerator->RequestStop();
+
+  // Do not leave the thread running on a destroyed object
+  if( this->m_ThreadRunning )
+    {
+    this->m_ProgressLock.Lock();
+    this->m_StopRequested = true;
+    this->m_ProgressLock.Unlock();
+
+    this->m_Threader->TerminateThread( this->m_ThreadID );
+    this->m_ThreadRunning = false;
+    }
 }
 
 /** Print Self function */
@@ -190,6 +338,27 @@ void MR3DImageToUS3DImageRegistration
 ::PrintSelf( std::ostream& os, itk::Indent indent ) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfLevels: " << this->m_NumberOfLevels << std::endl;
+  os << indent << "SamplingStrategy: " << this->m_SamplingStrategy 
+     << std::endl;
+  os << indent << "SamplingPercentage: " << this->m_SamplingPercentage 
+     << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "MaximumNumberOfIterations: " 
+     << this->m_MaximumNumberOfIterations << std::endl;
+  os << indent << "MaximumStepLength: " << this->m_MaximumStepLength 
+     << std::endl;
+  os << indent << "MinimumStepLength: " << this->m_MinimumStepLength 
+     << std::endl;
+  os << indent << "TrackingNumberOfIterations: " 
+     << this->m_TrackingNumberOfIterations << std::endl;
+  os << indent << "TrackingStepLength: " << this->m_TrackingStepLength 
+     << std::endl;
+  os << indent << "TrackingSearchRadius: " << this->m_TrackingSearchRadius 
+     << std::endl;
+  os << indent << "ValidMR3DImageToUS3DImageRegistration: " 
+     << this->m_ValidMR3DImageToUS3DImageRegistration << std::endl;
 }
 
 
@@ -257,6 +426,18 @@ void MR3DImageToUS3DImageRegistration::ResetProcessing()
   this->m_USFixedImage = 0;
   this->m_MRMovingImageToBeSet = 0;
   this->m_MRMovingImage = 0;
+
+  // Forget the previous solution and the tracking pipeline
+  this->m_PreviousSolutionAvailable = false;
+  this->m_ProbeTransformAtRegistrationValid = false;
+  this->m_TrackingFixedSource = 0;
+  this->m_TrackingMovingSource = 0;
+  this->m_TrackingFixedImage = 0;
+  this->m_TrackingMovingImage = 0;
+  this->m_TrackingMetric = 0;
+  this->m_TrackingInterpolator = 0;
+  this->m_TrackingOptimizer = 0;
+  this->m_TrackingTransform = 0;
 }
 
 
@@ -277,101 +458,265 @@ void MR3DImageToUS3DImageRegistration::CalculateRegistrationProcessing()
   igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
                         ::CalculateRegistrationProcessing called...\n" );
 
+  if( !this->PrepareRegistration() )
+    {
+    this->m_ValidMR3DImageToUS3DImageRegistration = false;
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationInput );
+    this->m_StateMachine.ProcessInputs();
+    return;
+    }
+
+  this->m_TrackingRun = false;
+  this->m_StopRequested = false;
+  this->m_ProgressUpdated = false;
+
+  if( !this->ExecuteRegistration() )
+    {
+    igstkLogMacro( CRITICAL, "igstk::MR3DImageToUS3DImageRegistration" 
+                             << this->m_ErrorDescription << "\n" );
+    this->m_ValidMR3DImageToUS3DImageRegistration = false;
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationInput );
+    this->m_StateMachine.ProcessInputs();
+    return;
+    }
+
+  this->AcceptRegistrationResult();
+
+  this->m_StateMachine.PushInput( this->m_ValidRegistrationInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Refine the registration in tracking mode */
+void MR3DImageToUS3DImageRegistration::UpdateRegistrationProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::UpdateRegistrationProcessing called...\n" );
+
+  if( !this->PrepareRegistration() || !this->PrepareTrackingRegistration() )
+    {
+    this->ReportRegistrationFailureProcessing();
+    return;
+    }
+
+  this->m_TrackingRun = true;
+  this->m_StopRequested = false;
+  this->m_ProgressUpdated = false;
+
+  if( !this->ExecuteTrackingRegistration() )
+    {
+    igstkLogMacro( WARNING, "igstk::MR3DImageToUS3DImageRegistration" 
+                             << this->m_ErrorDescription << "\n" );
+    this->ReportRegistrationFailureProcessing();
+    return;
+    }
+
+  this->AcceptRegistrationResult();
+
+  this->m_StateMachine.PushInput( this->m_ValidRegistrationInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Start the registration thread */
+void MR3DImageToUS3DImageRegistration::StartRegistrationProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::StartRegistrationProcessing called...\n" );
+
+  this->m_ValidMR3DImageToUS3DImageRegistration = false;
+
+  if( !this->PrepareRegistration() )
+    {
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationInput );
+    this->m_StateMachine.ProcessInputs();
+    return;
+    }
+
+  this->m_TrackingRun = false;
+
+  this->m_ProgressLock.Lock();
+  this->m_StopRequested = false;
+  this->m_ProgressUpdated = false;
+  this->m_RegistrationFinished = false;
+  this->m_RegistrationSucceeded = false;
+  this->m_ProgressLock.Unlock();
+
+  this->m_ThreadRunning = true;
+  this->m_ThreadID = this->m_Threader->SpawnThread( 
+                                       RegistrationThreadFunction, this );
+
+  this->m_PulseGenerator->RequestStart();
+}
+
+/** Start the registration thread in tracking mode */
+void MR3DImageToUS3DImageRegistration::StartRegistrationUpdateProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::StartRegistrationUpdateProcessing called...\n" );
+
+  if( !this->PrepareRegistration() || !this->PrepareTrackingRegistration() )
+    {
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationUpdateInput );
+    this->m_StateMachine.ProcessInputs();
+    return;
+    }
+
+  this->m_TrackingRun = true;
+
+  this->m_ProgressLock.Lock();
+  this->m_StopRequested = false;
+  this->m_ProgressUpdated = false;
+  this->m_RegistrationFinished = false;
+  this->m_RegistrationSucceeded = false;
+  this->m_ProgressLock.Unlock();
+
+  this->m_ThreadRunning = true;
+  this->m_ThreadID = this->m_Threader->SpawnThread( 
+                                       RegistrationThreadFunction, this );
+
+  this->m_PulseGenerator->RequestStart();
+}
+
+/** Ask the registration thread to stop */
+void MR3DImageToUS3DImageRegistration::StopRegistrationProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::StopRegistrationProcessing called...\n" );
+
+  this->m_ProgressLock.Lock();
+  this->m_StopRequested = true;
+  this->m_ProgressLock.Unlock();
+}
+
+/** Report the progress of the registration thread and collect its result
+ *  once it has finished */
+void MR3DImageToUS3DImageRegistration::CheckRegistrationProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::CheckRegistrationProcessing called...\n" );
+
+  this->ReportProgress();
+
+  this->m_ProgressLock.Lock();
+  const bool finished = this->m_RegistrationFinished;
+  const bool succeeded = this->m_RegistrationSucceeded;
+  this->m_ProgressLock.Unlock();
+
+  if( !finished )
+    {
+    return;
+    }
+
+  this->m_PulseGenerator->RequestStop();
+
+  // The thread has returned from ExecuteRegistration(), this only joins it
+  this->m_Threader->TerminateThread( this->m_ThreadID );
+  this->m_ThreadRunning = false;
+
+  if( succeeded )
+    {
+    this->AcceptRegistrationResult();
+    this->m_StateMachine.PushInput( this->m_ValidRegistrationInput );
+    }
+  else if( this->m_TrackingRun && 
+           this->m_ValidMR3DImageToUS3DImageRegistration )
+    {
+    // The registration that was being refined is still valid
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationUpdateInput );
+    }
+  else
+    {
+    this->m_StateMachine.PushInput( this->m_InvalidRegistrationInput );
+    }
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Report the end of a successful registration */
+void MR3DImageToUS3DImageRegistration::ReportRegistrationCompletedProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::ReportRegistrationCompletedProcessing called...\n" );
+
+  CompletedEvent event;
+  this->InvokeEvent( event );
+}
+
+/** Report the end of a failed or cancelled registration */
+void MR3DImageToUS3DImageRegistration::ReportRegistrationFailureProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::ReportRegistrationFailureProcessing called...\n" );
+
+  ImageRegistrationFailureEvent event;
+  event.Set( this->m_ErrorDescription );
+  this->InvokeEvent( event );
+}
+
+/** Report a request that cannot be served while registering */
+void MR3DImageToUS3DImageRegistration::ReportInvalidRequestProcessing()
+{
+  igstkLogMacro( WARNING, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::ReportInvalidRequestProcessing called...\n" );
+
+  InvalidRequestErrorEvent event;
+  this->InvokeEvent( event );
+}
+
+/** Get the images and the initial parameters from the spatial objects */
+bool MR3DImageToUS3DImageRegistration::PrepareRegistration()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::PrepareRegistration called...\n" );
+
+  // The observers are removed once used, since tracking updates go through
+  // this method repeatedly.
+  unsigned long tag;
 
   // Get the pointer to the ITK US image
   ITKUSImageObserver::Pointer usImageObserver = ITKUSImageObserver::New();
-  this->m_USFixedImage->AddObserver(
+  tag = this->m_USFixedImage->AddObserver(
                   USImageObject::ITKImageModifiedEvent(),usImageObserver);
 
   usImageObserver->Reset();
   this->m_USFixedImage->RequestGetITKImage();
+  this->m_USFixedImage->RemoveObserver( tag );
 
   if( !usImageObserver->GotITKUSImage() )
     {
     igstkLogMacro( CRITICAL, "igstk::MR3DImageToUS3DImageRegistration\
                                No US Image!\n" );
-    return;
+    this->m_ErrorDescription = "The US image is not available";
+    return false;
     }
 
-
   // Get the pointer to the ITK MR image
   ITKMRImageObserver::Pointer mrImageObserver = ITKMRImageObserver::New(); 
-  this->m_MRMovingImage->AddObserver(
+  tag = this->m_MRMovingImage->AddObserver(
              MRImageSpatialObject::ITKImageModifiedEvent(),mrImageObserver);
 
   mrImageObserver->Reset();
   this->m_MRMovingImage->RequestGetITKImage();
+  this->m_MRMovingImage->RemoveObserver( tag );
 
   if(!mrImageObserver->GotITKMRImage())
     {
     igstkLogMacro( CRITICAL, "igstk::MR3DImageToUS3DImageRegistration\
                                No US Image!\n" );
-    return;
+    this->m_ErrorDescription = "The MR image is not available";
+    return false;
     }
-  
-  // Fixed Image Type
-  typedef USImageObject::ImageType            FixedImageType;
-  
-  // Moving Image Type
-  typedef MRImageSpatialObject::ImageType     MovingImageType;
- 
-  // Transform Type
-  typedef itk::VersorRigid3DTransform< double > VersorRigidTransformType;
-
-  // Optimizer Type
-  typedef itk::RegularStepGradientDescentOptimizer       OptimizerType;
-
-  // Metric Type
-  typedef itk::MeanSquaresImageToImageMetric< 
-                                    FixedImageType, 
-                                    MovingImageType >    MetricType;
-
-  // Interpolation technique
-  typedef itk:: LinearInterpolateImageFunction< 
-                                    MovingImageType,
-                                    double          >    InterpolatorType;
-
-  // Registration Method
-  typedef itk::ImageRegistrationMethod< 
-                                    FixedImageType, 
-                                    MovingImageType >    RegistrationType;
-
-
-  MetricType::Pointer         metric        = MetricType::New();
-
-  VersorRigidTransformType::Pointer    transform   = 
-                                VersorRigidTransformType::New();
-
-  OptimizerType::Pointer      optimizer     = OptimizerType::New();
-  FixedImageType::Pointer     fixedImage    = FixedImageType::New();  
-  MovingImageType::Pointer    movingImage   = MovingImageType::New();  
-  InterpolatorType::Pointer   interpolator  = InterpolatorType::New();
-  RegistrationType::Pointer   registration  = RegistrationType::New();
-  
-  typedef MR3DImageToUS3DImageRegistrationHelper::CommandIterationUpdate 
-                                                                 ObserverType;
-    
-  ObserverType::Pointer observer = ObserverType::New();
 
-  observer->SetLogger( this->GetLogger() );
-
-  optimizer->AddObserver( itk::IterationEvent(), observer );
- 
-  registration->SetMetric(        metric        );
-  registration->SetOptimizer(     optimizer     );
-  registration->SetTransform(     transform     );
-  registration->SetFixedImage( usImageObserver->GetITKUSImage() );
-  registration->SetMovingImage( mrImageObserver->GetITKMRImage() );
-  registration->SetInterpolator(  interpolator  );
+  this->m_FixedITKImage = usImageObserver->GetITKUSImage();
+  this->m_MovingITKImage = mrImageObserver->GetITKMRImage();
 
   // Here we should get the transforms of the images and use it to initialize
   // the registration
   USImageTransformObserver::Pointer usTransformObserver 
                                     = USImageTransformObserver::New();
-  m_USFixedImage->AddObserver( CoordinateSystemTransformToEvent(),
+  tag = m_USFixedImage->AddObserver( CoordinateSystemTransformToEvent(),
                                            usTransformObserver );
 
   m_USFixedImage->RequestGetImageTransform();
+  m_USFixedImage->RemoveObserver( tag );
 
   Transform usTransform;
   if( usTransformObserver->GotUSImageTransform() )
@@ -386,19 +731,190 @@ void MR3DImageToUS3DImageRegistration::CalculateRegistrationProcessing()
         << " Observer did not receive expected Transform\n" );
     }
 
-  typedef RegistrationType::ParametersType ParametersType;
-  ParametersType initialParameters( transform->GetNumberOfParameters() );
-  initialParameters.Fill(0);
-  initialParameters[0] = m_InitialTransform.GetRotation().GetX();
-  initialParameters[1] = m_InitialTransform.GetRotation().GetY();
-  initialParameters[2] = m_InitialTransform.GetRotation().GetZ();
-  initialParameters[3] = usTransform.GetTranslation()[0]
+  this->m_InitialParameters.SetSize( 6 );
+  this->m_InitialParameters.Fill(0);
+  this->m_InitialParameters[0] = m_InitialTransform.GetRotation().GetX();
+  this->m_InitialParameters[1] = m_InitialTransform.GetRotation().GetY();
+  this->m_InitialParameters[2] = m_InitialTransform.GetRotation().GetZ();
+  this->m_InitialParameters[3] = usTransform.GetTranslation()[0]
                                       +m_InitialTransform.GetTranslation()[0];
-  initialParameters[4] = usTransform.GetTranslation()[1]
+  this->m_InitialParameters[4] = usTransform.GetTranslation()[1]
                                       +m_InitialTransform.GetTranslation()[1];
-  initialParameters[5] = usTransform.GetTranslation()[2]
+  this->m_InitialParameters[5] = usTransform.GetTranslation()[2]
                                       +m_InitialTransform.GetTranslation()[2];
 
+  // Pose of the probe with respect to the MR image, used to initialize the
+  // next tracking update
+  this->m_ProbeTransformValid = false;
+  if( this->m_UltrasoundProbe )
+    {
+    ProbeTransformObserver::Pointer probeTransformObserver 
+                                    = ProbeTransformObserver::New();
+    tag = this->m_UltrasoundProbe->AddObserver( 
+                CoordinateSystemTransformToEvent(), probeTransformObserver );
+
+    this->m_UltrasoundProbe->RequestComputeTransformTo( 
+                                                   this->m_MRMovingImage );
+    this->m_UltrasoundProbe->RemoveObserver( tag );
+
+    if( probeTransformObserver->GotProbeTransform() )
+      {
+      this->m_ProbeTransform = 
+          probeTransformObserver->GetProbeTransform().GetTransform();
+      this->m_ProbeTransformValid = true;
+      }
+    }
+
+  return true;
+}
+
+/** Compute the starting point of a tracking update */
+bool MR3DImageToUS3DImageRegistration::PrepareTrackingRegistration()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::PrepareTrackingRegistration called...\n" );
+
+  if( !this->m_PreviousSolutionAvailable )
+    {
+    this->m_ErrorDescription = "There is no registration to update";
+    return false;
+    }
+
+  this->m_SeedParameters = this->m_FinalParameters;
+
+  if( !this->m_ProbeTransformValid || 
+      !this->m_ProbeTransformAtRegistrationValid )
+    {
+    return true;
+    }
+
+  // The ultrasound image moves with the probe, so the displacement of the
+  // probe since the previous solution is applied to that solution:
+  // seed = (P_now * P_previous^(-1)) * previous
+  Transform displacement = Transform::TransformCompose( 
+                           this->m_ProbeTransform,
+                           this->m_ProbeTransformAtRegistration.GetInverse() );
+
+  VersorType::VectorType right;
+  VectorType translation;
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    right[i] = this->m_FinalParameters[i];
+    translation[i] = this->m_FinalParameters[i+3];
+    }
+
+  VersorType rotation;
+  rotation.Set( right );
+
+  rotation = displacement.GetRotation() * rotation;
+  translation = displacement.GetRotation().Transform( translation );
+  translation += displacement.GetTranslation();
+
+  // The transform parameters only hold the right part of the versor, which
+  // assumes a positive scalar part
+  if( rotation.GetW() < 0.0 )
+    {
+    rotation.Set( -rotation.GetX(), -rotation.GetY(), 
+                  -rotation.GetZ(), -rotation.GetW() );
+    }
+
+  this->m_SeedParameters[0] = rotation.GetX();
+  this->m_SeedParameters[1] = rotation.GetY();
+  this->m_SeedParameters[2] = rotation.GetZ();
+  this->m_SeedParameters[3] = translation[0];
+  this->m_SeedParameters[4] = translation[1];
+  this->m_SeedParameters[5] = translation[2];
+
+  return true;
+}
+
+/** Store the result of a successful registration */
+void MR3DImageToUS3DImageRegistration::AcceptRegistrationResult()
+{
+  this->m_RegistrationTransform = 
+           this->ComputeRegistrationTransform( this->m_FinalParameters );
+  this->m_ValidMR3DImageToUS3DImageRegistration = true;
+  this->m_PreviousSolutionAvailable = true;
+
+  this->m_ProbeTransformAtRegistration = this->m_ProbeTransform;
+  this->m_ProbeTransformAtRegistrationValid = this->m_ProbeTransformValid;
+}
+
+/** Run the optimization */
+bool MR3DImageToUS3DImageRegistration::ExecuteRegistration()
+{
+  using namespace MR3DImageToUS3DImageRegistrationHelper;
+
+  typedef itk::CastImageFilter< USImageType, 
+                                InternalImageType >  FixedCasterType;
+  typedef itk::CastImageFilter< MRImageSpatialObject::ImageType, 
+                                InternalImageType >  MovingCasterType;
+
+  FixedCasterType::Pointer    fixedCaster   = FixedCasterType::New();
+  MovingCasterType::Pointer   movingCaster  = MovingCasterType::New();
+
+  MetricType::Pointer         metric        = MetricType::New();
+
+  VersorRigidTransformType::Pointer    transform   = 
+                                VersorRigidTransformType::New();
+
+  OptimizerType::Pointer      optimizer     = OptimizerType::New();
+  InterpolatorType::Pointer   interpolator  = InterpolatorType::New();
+  RegistrationType::Pointer   registration  = RegistrationType::New();
+  PyramidType::Pointer        fixedPyramid  = PyramidType::New();
+  PyramidType::Pointer        movingPyramid = PyramidType::New();
+
+  fixedCaster->SetInput( this->m_FixedITKImage );
+  movingCaster->SetInput( this->m_MovingITKImage );
+
+  try
+    {
+    fixedCaster->Update();
+    movingCaster->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    this->m_ErrorDescription = excp.GetDescription();
+    return false;
+    }
+
+  metric->SetNumberOfThreads( this->m_NumberOfThreads );
+
+  // The logger is not thread safe, iterations are only logged when running
+  // in the thread of the caller.
+  if( !this->m_ThreadRunning )
+    {
+    typedef MR3DImageToUS3DImageRegistrationHelper::CommandIterationUpdate 
+                                                                 ObserverType;
+    ObserverType::Pointer observer = ObserverType::New();
+    observer->SetLogger( this->GetLogger() );
+    optimizer->AddObserver( itk::IterationEvent(), observer );
+    }
+
+  RegistrationCommandType::Pointer iterationCommand = 
+                                         RegistrationCommandType::New();
+  iterationCommand->SetCallbackFunction( this, 
+                 & MR3DImageToUS3DImageRegistration::IterationCallback );
+  optimizer->AddObserver( itk::IterationEvent(), iterationCommand );
+
+  RegistrationCommandType::Pointer levelCommand = 
+                                         RegistrationCommandType::New();
+  levelCommand->SetCallbackFunction( this, 
+                 & MR3DImageToUS3DImageRegistration::LevelCallback );
+  registration->AddObserver( itk::IterationEvent(), levelCommand );
+
+  registration->SetMetric(        metric        );
+  registration->SetOptimizer(     optimizer     );
+  registration->SetTransform(     transform     );
+  registration->SetInterpolator(  interpolator  );
+  registration->SetFixedImagePyramid( fixedPyramid );
+  registration->SetMovingImagePyramid( movingPyramid );
+  registration->SetFixedImage( fixedCaster->GetOutput() );
+  registration->SetMovingImage( movingCaster->GetOutput() );
+  registration->SetFixedImageRegion( 
+                         fixedCaster->GetOutput()->GetBufferedRegion() );
+  registration->SetNumberOfLevels( this->m_NumberOfLevels );
+
   typedef OptimizerType::ScalesType ParameterScalesType;
   ParameterScalesType scales( transform->GetNumberOfParameters());
   scales.Fill(1000);
@@ -407,18 +923,386 @@ void MR3DImageToUS3DImageRegistration::CalculateRegistrationProcessing()
   scales[2] = 1000000000;
 
   optimizer->SetScales(scales);
+  optimizer->SetNumberOfIterations( this->m_MaximumNumberOfIterations );
+  optimizer->SetMinimumStepLength( this->m_MinimumStepLength );
+
+  RegistrationType::ParametersType initialParameters( 
+                                    transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < initialParameters.Size(); i++ )
+    {
+    initialParameters[i] = this->m_InitialParameters[i];
+    }
   registration->SetInitialTransformParameters( initialParameters );
+
   try
     {
-	    registration->Update();
+    registration->Update();
     }
   catch( itk::ExceptionObject & excp )
     {
-    igstkLogMacro( CRITICAL, "igstk::MR3DImageToUS3DImageRegistration" 
-                             << excp.GetDescription() << "\n" );
+    this->m_ErrorDescription = excp.GetDescription();
+    return false;
+    }
+
+  this->m_ProgressLock.Lock();
+  const bool stopped = this->m_StopRequested;
+  this->m_ProgressLock.Unlock();
+
+  if( stopped )
+    {
+    this->m_ErrorDescription = "The registration was stopped";
+    return false;
+    }
+
+  this->m_FinalParameters = registration->GetLastTransformParameters();
+
+  return true;
+}
+
+/** Run the optimization of a tracking update */
+bool MR3DImageToUS3DImageRegistration::ExecuteTrackingRegistration()
+{
+  using namespace MR3DImageToUS3DImageRegistrationHelper;
+
+  const bool fixedChanged = 
+    this->m_FixedITKImage.GetPointer() != this->m_TrackingFixedSource ||
+    this->m_FixedITKImage->GetMTime() != this->m_TrackingFixedSourceMTime;
+
+  const bool movingChanged = 
+    this->m_MovingITKImage.GetPointer() != this->m_TrackingMovingSource ||
+    this->m_MovingITKImage->GetMTime() != this->m_TrackingMovingSourceMTime;
+
+  OptimizerType::ParametersType seed( 6 );
+  for( unsigned int i = 0; i < seed.Size(); i++ )
+    {
+    seed[i] = this->m_SeedParameters[i];
+    }
+
+  try
+    {
+    if( fixedChanged )
+      {
+      typedef itk::CastImageFilter< USImageType, 
+                                    InternalImageType >  FixedCasterType;
+      FixedCasterType::Pointer fixedCaster = FixedCasterType::New();
+      fixedCaster->SetInput( this->m_FixedITKImage );
+      fixedCaster->Update();
+      this->m_TrackingFixedImage = fixedCaster->GetOutput();
+      this->m_TrackingFixedImage->DisconnectPipeline();
+      }
+
+    if( movingChanged )
+      {
+      typedef itk::CastImageFilter< MRImageSpatialObject::ImageType, 
+                                    InternalImageType >  MovingCasterType;
+      MovingCasterType::Pointer movingCaster = MovingCasterType::New();
+      movingCaster->SetInput( this->m_MovingITKImage );
+      movingCaster->Update();
+      this->m_TrackingMovingImage = movingCaster->GetOutput();
+      this->m_TrackingMovingImage->DisconnectPipeline();
+      }
+
+    // The metric samples the fixed image and computes the gradient of the
+    // moving image when initialized, so this is only done when one of the
+    // images has changed.
+    if( fixedChanged || movingChanged || this->m_TrackingMetric.IsNull() )
+      {
+      this->m_TrackingTransform = VersorRigidTransformType::New();
+      this->m_TrackingInterpolator = InterpolatorType::New();
+      this->m_TrackingMetric = MetricType::New();
+      this->m_TrackingOptimizer = OptimizerType::New();
+
+      this->m_TrackingMetric->SetNumberOfThreads( this->m_NumberOfThreads );
+      this->m_TrackingMetric->SetTransform( this->m_TrackingTransform );
+      this->m_TrackingMetric->SetInterpolator( this->m_TrackingInterpolator );
+      this->m_TrackingMetric->SetFixedImage( this->m_TrackingFixedImage );
+      this->m_TrackingMetric->SetMovingImage( this->m_TrackingMovingImage );
+      this->m_TrackingMetric->SetFixedImageRegion( 
+                     this->m_TrackingFixedImage->GetBufferedRegion() );
+      this->ConfigureMetricSampling( this->m_TrackingMetric, 
+                     this->m_TrackingFixedImage->GetBufferedRegion(),
+                     SamplingSeed );
+
+      this->m_TrackingTransform->SetParameters( seed );
+      this->m_TrackingMetric->Initialize();
+
+      typedef OptimizerType::ScalesType ParameterScalesType;
+      ParameterScalesType scales( 
+                     this->m_TrackingTransform->GetNumberOfParameters() );
+      scales.Fill(1000);
+      scales[0] = 1000000000;
+      scales[1] = 1000000000;
+      scales[2] = 1000000000;
+
+      this->m_TrackingOptimizer->SetScales( scales );
+      this->m_TrackingOptimizer->SetCostFunction( this->m_TrackingMetric );
+
+      RegistrationCommandType::Pointer iterationCommand = 
+                                             RegistrationCommandType::New();
+      iterationCommand->SetCallbackFunction( this, 
+                   & MR3DImageToUS3DImageRegistration::IterationCallback );
+      this->m_TrackingOptimizer->AddObserver( itk::IterationEvent(), 
+                                              iterationCommand );
+
+      this->m_TrackingFixedSource = this->m_FixedITKImage;
+      this->m_TrackingFixedSourceMTime = this->m_FixedITKImage->GetMTime();
+      this->m_TrackingMovingSource = this->m_MovingITKImage;
+      this->m_TrackingMovingSourceMTime = this->m_MovingITKImage->GetMTime();
+      }
+
+    this->m_CurrentLevel = 0;
+    this->m_OutsideSearchWindow = false;
+
+    this->m_TrackingOptimizer->SetInitialPosition( seed );
+    this->m_TrackingOptimizer->SetMaximumStepLength( 
+                                         this->m_TrackingStepLength );
+    this->m_TrackingOptimizer->SetMinimumStepLength( 
+                                         this->m_MinimumStepLength );
+    this->m_TrackingOptimizer->SetNumberOfIterations( 
+                                         this->m_TrackingNumberOfIterations );
+    this->m_TrackingOptimizer->StartOptimization();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    // Rebuild everything on the next update
+    this->m_TrackingMetric = 0;
+    this->m_ErrorDescription = excp.GetDescription();
+    return false;
+    }
+
+  this->m_ProgressLock.Lock();
+  const bool stopped = this->m_StopRequested;
+  this->m_ProgressLock.Unlock();
+
+  if( stopped )
+    {
+    this->m_ErrorDescription = "The registration was stopped";
+    return false;
+    }
+
+  if( this->m_OutsideSearchWindow )
+    {
+    this->m_ErrorDescription = 
+                  "The registration update left the search window";
+    return false;
+    }
+
+  this->m_FinalParameters = this->m_TrackingOptimizer->GetCurrentPosition();
+
+  return true;
+}
+
+/** Configure the optimizer and the metric sampling for the next level */
+void MR3DImageToUS3DImageRegistration::LevelCallback( 
+                  itk::Object * caller, const itk::EventObject & event )
+{
+  using namespace MR3DImageToUS3DImageRegistrationHelper;
+
+  RegistrationType * registration = 
+                                dynamic_cast< RegistrationType * >( caller );
+
+  if( !registration || !itk::IterationEvent().CheckEvent( &event ) )
+    {
+    return;
+    }
+
+  this->m_ProgressLock.Lock();
+  const bool stopped = this->m_StopRequested;
+  this->m_ProgressLock.Unlock();
+
+  if( stopped )
+    {
+    registration->StopRegistration();
+    return;
+    }
+
+  const unsigned int level = registration->GetCurrentLevel();
+  this->m_CurrentLevel = level;
+
+  // Steps shrink with the voxels of the pyramid
+  OptimizerType * optimizer = 
+                dynamic_cast< OptimizerType * >( registration->GetOptimizer() );
+  const double stepLength = 
+               this->m_MaximumStepLength / static_cast<double>( 1 << level );
+  optimizer->SetMaximumStepLength( 
+               std::max( stepLength, 2.0 * this->m_MinimumStepLength ) );
+
+  MetricType * metric = 
+                dynamic_cast< MetricType * >( registration->GetMetric() );
+
+  PyramidType * pyramid = registration->GetFixedImagePyramid();
+  pyramid->UpdateOutputInformation();
+
+  this->ConfigureMetricSampling( metric, 
+                   pyramid->GetOutput( level )->GetLargestPossibleRegion(),
+                   SamplingSeed + level );
+}
+
+/** Select the voxels of the fixed image used by the metric */
+void MR3DImageToUS3DImageRegistration::ConfigureMetricSampling( 
+                          MetricType * metric,
+                          const InternalImageType::RegionType & region,
+                          int seed ) const
+{
+  if( this->m_SamplingStrategy == FullSampling )
+    {
+    metric->SetUseFixedImageIndexes( false );
+    metric->SetUseAllPixels( true );
+    return;
+    }
+
+  const unsigned long numberOfPixels = region.GetNumberOfPixels();
+
+  unsigned long numberOfSamples = static_cast< unsigned long >( 
+                            this->m_SamplingPercentage * numberOfPixels );
+  numberOfSamples = std::max( numberOfSamples, 1ul );
+  numberOfSamples = std::min( numberOfSamples, numberOfPixels );
+
+  metric->SetUseAllPixels( false );
+
+  if( this->m_SamplingStrategy == RandomSampling )
+    {
+    metric->SetUseFixedImageIndexes( false );
+    metric->SetNumberOfSpatialSamples( numberOfSamples );
+    metric->ReinitializeSeed( seed );
     return;
     }
-  ParametersType params = registration->GetLastTransformParameters();
+
+  // Stratified sampling: one voxel drawn at random in every cell of a grid
+  // holding about numberOfSamples cells.
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator  
+                                                            GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( seed );
+
+  const double cellSize = vcl_pow( static_cast<double>( numberOfPixels ) / 
+                                   numberOfSamples, 1.0 / 3.0 );
+
+  InternalImageType::SizeType   cells;
+  for( unsigned int d = 0; d < 3; d++ )
+    {
+    cells[d] = static_cast< unsigned long >( 
+                 vcl_ceil( region.GetSize()[d] / cellSize ) );
+    }
+
+  MetricType::FixedImageIndexContainer indexes;
+  indexes.reserve( cells[0] * cells[1] * cells[2] );
+
+  InternalImageType::IndexType  index;
+  for( unsigned long k = 0; k < cells[2]; k++ )
+    {
+    for( unsigned long j = 0; j < cells[1]; j++ )
+      {
+      for( unsigned long i = 0; i < cells[0]; i++ )
+        {
+        const unsigned long cell[3] = { i, j, k };
+        for( unsigned int d = 0; d < 3; d++ )
+          {
+          const double first = cell[d] * cellSize;
+          const double last = std::min( first + cellSize, 
+                 static_cast<double>( region.GetSize()[d] ) ) - 1.0;
+          index[d] = region.GetIndex()[d] + static_cast< long >( 
+                 vnl_math_rnd( generator->GetUniformVariate( first, 
+                                            std::max( first, last ) ) ) );
+          }
+        indexes.push_back( index );
+        }
+      }
+    }
+
+  metric->SetFixedImageIndexes( indexes );
+  metric->SetUseFixedImageIndexes( true );
+}
+
+/** Store the current position of the optimizer */
+void MR3DImageToUS3DImageRegistration::IterationCallback( 
+                  itk::Object * caller, const itk::EventObject & event )
+{
+  using namespace MR3DImageToUS3DImageRegistrationHelper;
+
+  OptimizerType * optimizer = dynamic_cast< OptimizerType * >( caller );
+
+  if( !optimizer || !itk::IterationEvent().CheckEvent( &event ) )
+    {
+    return;
+    }
+
+  this->m_ProgressLock.Lock();
+  this->m_ProgressLevel = this->m_CurrentLevel;
+  this->m_ProgressIteration = optimizer->GetCurrentIteration();
+  this->m_ProgressMetricValue = optimizer->GetValue();
+  this->m_ProgressParameters = optimizer->GetCurrentPosition();
+  this->m_ProgressUpdated = true;
+  const bool stopped = this->m_StopRequested;
+  this->m_ProgressLock.Unlock();
+
+  if( stopped )
+    {
+    optimizer->StopOptimization();
+    }
+
+  // A tracking update is only a local refinement, it gives up when the
+  // translation leaves the search window around its starting point.
+  if( this->m_TrackingRun )
+    {
+    double distance2 = 0.0;
+    for( unsigned int i = 3; i < 6; i++ )
+      {
+      const double delta = optimizer->GetCurrentPosition()[i] - 
+                           this->m_SeedParameters[i];
+      distance2 += delta * delta;
+      }
+    if( distance2 > 
+        this->m_TrackingSearchRadius * this->m_TrackingSearchRadius )
+      {
+      this->m_OutsideSearchWindow = true;
+      optimizer->StopOptimization();
+      }
+    }
+
+  // In the thread of the caller the progress can be reported right away
+  if( !this->m_ThreadRunning )
+    {
+    this->ReportProgress();
+    }
+}
+
+/** Invoke an ImageRegistrationProgressEvent for the last iteration */
+void MR3DImageToUS3DImageRegistration::ReportProgress()
+{
+  ImageRegistrationProgressType progress;
+  ParametersType parameters;
+
+  this->m_ProgressLock.Lock();
+  const bool updated = this->m_ProgressUpdated;
+  progress.Level = this->m_ProgressLevel;
+  progress.Iteration = this->m_ProgressIteration;
+  progress.MetricValue = this->m_ProgressMetricValue;
+  if( updated )
+    {
+    parameters = this->m_ProgressParameters;
+    }
+  this->m_ProgressUpdated = false;
+  this->m_ProgressLock.Unlock();
+
+  if( !updated )
+    {
+    return;
+    }
+
+  progress.CurrentTransform = this->ComputeRegistrationTransform( parameters );
+
+  ImageRegistrationProgressEvent event;
+  event.Set( progress );
+  this->InvokeEvent( event );
+}
+
+/** Convert optimizer parameters into the registration transform */
+MR3DImageToUS3DImageRegistration::TransformType 
+MR3DImageToUS3DImageRegistration::ComputeRegistrationTransform( 
+                                  const ParametersType & finalparams ) const
+{
+  const ParametersType & initialParameters = this->m_InitialParameters;
 
   // Reset the calibration transform (rotation and translation)
   VersorType quaternion;
@@ -428,8 +1312,6 @@ void MR3DImageToUS3DImageRegistration::CalculateRegistrationProcessing()
 
   VersorType::VectorType axis;
 
-  ParametersType finalparams = params;
-  
   // We have the following transforms:
   // 1) Transform found by optimization of the metric (we'll call it "C")
   // 2) The initial transform (we'll call it "A")
@@ -492,11 +1374,89 @@ void MR3DImageToUS3DImageRegistration::CalculateRegistrationProcessing()
   translation -= initTranslation;
 
   // Create the transform
-  this->m_RegistrationTransform.SetTranslationAndRotation( translation, 
-                                                          quaternion, 
-                                                          0.1, 1000);
+  TransformType transform;
+  transform.SetTranslationAndRotation( translation, quaternion, 0.1, 1000);
 
-  this->m_StateMachine.PushInput( this->m_ValidRegistrationInput );
+  return transform;
+}
+
+/** Poll the registration thread */
+void MR3DImageToUS3DImageRegistration::PulseCallback()
+{
+  this->m_StateMachine.PushInput( this->m_CheckRegistrationInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Thread function running the registration */
+ITK_THREAD_RETURN_TYPE 
+MR3DImageToUS3DImageRegistration::RegistrationThreadFunction( void * pInfo )
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfoStruct = 
+    ( struct itk::MultiThreader::ThreadInfoStruct* ) pInfo;
+
+  Self * self = static_cast< Self * >( pInfoStruct->UserData );
+
+  const bool succeeded = self->m_TrackingRun ? 
+                         self->ExecuteTrackingRegistration() :
+                         self->ExecuteRegistration();
+
+  self->m_ProgressLock.Lock();
+  self->m_RegistrationSucceeded = succeeded;
+  self->m_RegistrationFinished = true;
+  self->m_ProgressLock.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Method to invoke the calculation in a separate thread */
+void MR3DImageToUS3DImageRegistration::RequestStartRegistration()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::RequestStartRegistration called...\n" );
+
+  this->m_StateMachine.PushInput( this->m_StartRegistrationInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Method to refine the registration in tracking mode */
+void MR3DImageToUS3DImageRegistration::RequestUpdateRegistration()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::RequestUpdateRegistration called...\n" );
+
+  this->m_StateMachine.PushInput( this->m_UpdateRegistrationInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Method to refine the registration in tracking mode in a separate 
+ *  thread */
+void MR3DImageToUS3DImageRegistration::RequestStartRegistrationUpdate()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::RequestStartRegistrationUpdate called...\n" );
+
+  this->m_StateMachine.PushInput( this->m_StartRegistrationUpdateInput );
+  this->m_StateMachine.ProcessInputs();
+}
+
+/** Set the probe whose displacement initializes the tracking updates */
+void MR3DImageToUS3DImageRegistration
+::SetUltrasoundProbe( UltrasoundProbeObject * probe )
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::SetUltrasoundProbe called...\n" );
+
+  this->m_UltrasoundProbe = probe;
+  this->m_ProbeTransformAtRegistrationValid = false;
+}
+
+/** Method to cancel the calculation running in a separate thread */
+void MR3DImageToUS3DImageRegistration::RequestStopRegistration()
+{
+  igstkLogMacro( DEBUG, "igstk::MR3DImageToUS3DImageRegistration\
+                        ::RequestStopRegistration called...\n" );
+
+  this->m_StateMachine.PushInput( this->m_StopRegistrationInput );
   this->m_StateMachine.ProcessInputs();
 }
 
@@ -551,6 +1511,7 @@ void MR3DImageToUS3DImageRegistration::SetFixedUS3DProcessing()
                         ::RequestReset called...\n" );
 
   this->m_USFixedImage = this->m_USFixedImageToBeSet;
+  this->m_ValidMR3DImageToUS3DImageRegistration = false;
 }
 
 /** Set the 3D moving MR image */
@@ -560,6 +1521,7 @@ void MR3DImageToUS3DImageRegistration::SetMovingMR3DProcessing()
                         ::RequestReset called...\n" );
 
   this->m_MRMovingImage = this->m_MRMovingImageToBeSet;
+  this->m_ValidMR3DImageToUS3DImageRegistration = false;
 }
 
 
@@ -31,13 +31,44 @@
 #include "igstkMacros.h"
 #include "igstkUSImageObject.h"
 #include "igstkMRImageSpatialObject.h"
+#include "igstkUltrasoundProbeObject.h"
+#include "igstkPulseGenerator.h"
 #include "itkImage.h"
 #include "itkIndex.h"
+#include "itkArray.h"
+#include "itkVersorRigid3DTransform.h"
+#include "itkMultiResolutionImageRegistrationMethod.h"
+#include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkMeanSquaresImageToImageMetric.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkRegularStepGradientDescentOptimizer.h"
 #include "itkVectorContainer.h"
+#include "itkCommand.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
 
 namespace igstk
 {
 
+/** Progress of an image registration, reported after every iteration of the
+ *  optimizer. CurrentTransform is the registration transform that would be
+ *  returned if the optimization stopped at this iteration. */
+struct ImageRegistrationProgressType
+{
+  unsigned int  Level;
+  unsigned int  Iteration;
+  double        MetricValue;
+  Transform     CurrentTransform;
+};
+
+igstkLoadedEventMacro( ImageRegistrationProgressEvent, IGSTKEvent,
+                       ImageRegistrationProgressType );
+
+/** Invoked when a registration ends without a valid transform, either
+ *  because it was stopped or because the optimization failed. */
+igstkEventMacro( ImageRegistrationFailureEvent, IGSTKErrorWithStringEvent );
+
+
 /** \class MR3DImageToUS3DImageRegistration
  * 
  * \brief This class registers a 3D MR image with a 3D Utrasound image.
@@ -48,6 +79,20 @@ namespace igstk
  * between the two images is a mean square.  The optimizer used in this class
  * is a regular step gradient descent optimizer.
  *
+ * The registration runs coarse to fine over an image pyramid of
+ * NumberOfLevels levels. At every level the metric is evaluated on a subset
+ * of the fixed image voxels, drawn either at random or on a jittered grid
+ * (SamplingStrategy, SamplingPercentage), and the evaluation is split among
+ * NumberOfThreads threads.
+ *
+ * RequestCalculateRegistration() blocks until the optimizer converges.
+ * RequestStartRegistration() runs the same computation in a separate thread
+ * and returns immediately. While it runs, ImageRegistrationProgressEvents
+ * carrying the intermediate transforms are invoked from the thread that
+ * calls PulseGenerator::CheckTimeouts(), and RequestStopRegistration()
+ * cancels it. The end of the computation is signaled by a CompletedEvent or
+ * by an ImageRegistrationFailureEvent.
+ *
  * \image html  igstkMR3DImageToUS3DImageRegistration.png
  *             "MR to UltraSound Image Registration State Machine Diagram"
  * \image latex igstkMR3DImageToUS3DImageRegistration.eps
@@ -67,6 +112,14 @@ public:
   /** Typedefs for the internal computation */
   typedef Transform                            TransformType;
 
+  /** Selection of the fixed image voxels used to evaluate the metric */
+  typedef enum
+    {
+    FullSampling = 0,
+    RandomSampling,
+    StratifiedSampling
+    } SamplingStrategyType;
+
 public:
 
   /** Method to check whether a valid calibration is calculated */
@@ -87,9 +140,77 @@ public:
   /** Method invoked by the user to start the registration */
   void RequestCalculateRegistration(); 
 
+  /** Method invoked by the user to start the registration in a separate
+   *  thread */
+  void RequestStartRegistration(); 
+
+  /** Method invoked by the user to cancel a registration started with
+   *  RequestStartRegistration() or RequestStartRegistrationUpdate() */
+  void RequestStopRegistration(); 
+
+  /** Method invoked by the user to refine the current registration in
+   *  tracking mode. It blocks until the update is done. */
+  void RequestUpdateRegistration(); 
+
+  /** Method invoked by the user to refine the current registration in
+   *  tracking mode in a separate thread */
+  void RequestStartRegistrationUpdate(); 
+
+  /** Set the probe carrying the ultrasound transducer. Its displacement
+   *  with respect to the MR image between two registrations is used to
+   *  initialize the tracking updates. */
+  void SetUltrasoundProbe( UltrasoundProbeObject * probe );
+
   /** Request to get the final transformation */
   void RequestGetRegistrationTransform(); 
 
+  /** Number of levels of the image pyramid. Default is 3. */
+  igstkSetMacro( NumberOfLevels, unsigned int );
+  igstkGetMacro( NumberOfLevels, unsigned int );
+
+  /** Voxels of the fixed image used by the metric. Default is
+   *  RandomSampling. */
+  igstkSetMacro( SamplingStrategy, SamplingStrategyType );
+  igstkGetMacro( SamplingStrategy, SamplingStrategyType );
+
+  /** Fraction of the fixed image voxels used by the metric at every level
+   *  when sampling is not FullSampling. Default is 0.1. */
+  igstkSetMacro( SamplingPercentage, double );
+  igstkGetMacro( SamplingPercentage, double );
+
+  /** Number of threads evaluating the metric */
+  igstkSetMacro( NumberOfThreads, unsigned int );
+  igstkGetMacro( NumberOfThreads, unsigned int );
+
+  /** Maximum number of optimizer iterations at every level. Default is
+   *  100. */
+  igstkSetMacro( MaximumNumberOfIterations, unsigned int );
+  igstkGetMacro( MaximumNumberOfIterations, unsigned int );
+
+  /** Step length of the optimizer at the coarsest level, in millimeters.
+   *  It is halved at every following level. Default is 4.0. */
+  igstkSetMacro( MaximumStepLength, double );
+  igstkGetMacro( MaximumStepLength, double );
+
+  /** Step length at which the optimizer stops. Default is 0.001. */
+  igstkSetMacro( MinimumStepLength, double );
+  igstkGetMacro( MinimumStepLength, double );
+
+  /** Maximum number of optimizer iterations of a tracking update. Default
+   *  is 20. */
+  igstkSetMacro( TrackingNumberOfIterations, unsigned int );
+  igstkGetMacro( TrackingNumberOfIterations, unsigned int );
+
+  /** Initial step length of a tracking update, in millimeters. Default is
+   *  0.5. */
+  igstkSetMacro( TrackingStepLength, double );
+  igstkGetMacro( TrackingStepLength, double );
+
+  /** Largest translation allowed during a tracking update, in millimeters.
+   *  Default is 5.0. */
+  igstkSetMacro( TrackingSearchRadius, double );
+  igstkGetMacro( TrackingSearchRadius, double );
+
   /** Request to set the initial transformation */
   igstkSetMacro( InitialTransform, TransformType );
   igstkGetMacro( InitialTransform, TransformType );
@@ -125,6 +246,33 @@ protected:
   typedef itk::VectorContainer<int,VectorType> InputVectorContainerType;
   typedef InputVectorContainerType::Pointer    InputVectorContainerPointerType;
 
+  typedef itk::Array< double >                 ParametersType;
+
+  /** Types of the ITK registration components. The images are cast to
+   *  float so that the pyramid and the metric do not lose precision on the
+   *  integer input types. */
+  typedef itk::Image< float, 3 >                      InternalImageType;
+
+  typedef itk::VersorRigid3DTransform< double >       VersorRigidTransformType;
+
+  typedef itk::RegularStepGradientDescentOptimizer    OptimizerType;
+
+  typedef itk::MeanSquaresImageToImageMetric< 
+                                    InternalImageType, 
+                                    InternalImageType >  MetricType;
+
+  typedef itk::LinearInterpolateImageFunction< 
+                                    InternalImageType,
+                                    double          >    InterpolatorType;
+
+  typedef itk::MultiResolutionImageRegistrationMethod< 
+                                    InternalImageType, 
+                                    InternalImageType >  RegistrationType;
+
+  typedef itk::MultiResolutionPyramidImageFilter<
+                                    InternalImageType,
+                                    InternalImageType >  PyramidType;
+
 protected:
 
   /** Constructor */
@@ -154,9 +302,82 @@ private:
   /** Compute the registration transform */
   void CalculateRegistrationProcessing();
 
+  /** Start the registration thread */
+  void StartRegistrationProcessing();
+
+  /** Refine the registration in tracking mode */
+  void UpdateRegistrationProcessing();
+
+  /** Start the registration thread in tracking mode */
+  void StartRegistrationUpdateProcessing();
+
+  /** Ask the registration thread to stop */
+  void StopRegistrationProcessing();
+
+  /** Report the progress of the registration thread and collect its
+   *  result once it has finished */
+  void CheckRegistrationProcessing();
+
+  /** Report the end of a successful registration */
+  void ReportRegistrationCompletedProcessing();
+
+  /** Report the end of a failed or cancelled registration */
+  void ReportRegistrationFailureProcessing();
+
+  /** Report a request that cannot be served while registering */
+  void ReportInvalidRequestProcessing();
+
   /** Return the final transformation as an event */
   void ReportRegistrationTransformProcessing();
 
+  /** Get the images and the initial parameters from the spatial objects.
+   *  Must be called from the thread that owns them. */
+  bool PrepareRegistration();
+
+  /** Compute the starting point of a tracking update from the previous
+   *  solution and the displacement of the probe */
+  bool PrepareTrackingRegistration();
+
+  /** Run the optimization. Only uses the ITK images and the parameters
+   *  collected by PrepareRegistration(), so it may run in any thread. */
+  bool ExecuteRegistration();
+
+  /** Run the optimization of a tracking update. Same threading constraints
+   *  as ExecuteRegistration(). */
+  bool ExecuteTrackingRegistration();
+
+  /** Select the voxels of the fixed image used by the metric */
+  void ConfigureMetricSampling( MetricType * metric,
+                                const InternalImageType::RegionType & region,
+                                int seed ) const;
+
+  /** Store the result of a successful registration */
+  void AcceptRegistrationResult();
+
+  /** Convert optimizer parameters into the registration transform */
+  TransformType ComputeRegistrationTransform(
+                                   const ParametersType & parameters ) const;
+
+  /** Invoke an ImageRegistrationProgressEvent if the optimizer has moved
+   *  since the last call */
+  void ReportProgress();
+
+  /** Callback invoked at the start of every level of the pyramid */
+  void LevelCallback( itk::Object * caller, const itk::EventObject & event );
+
+  /** Callback invoked at every iteration of the optimizer */
+  void IterationCallback( itk::Object * caller,
+                          const itk::EventObject & event );
+
+  /** Callback invoked by the pulse generator while registering */
+  void PulseCallback();
+
+  /** Thread function running ExecuteRegistration() */
+  static ITK_THREAD_RETURN_TYPE RegistrationThreadFunction( void * pInfo );
+
+  typedef itk::MemberCommand< Self >           RegistrationCommandType;
+  typedef itk::SimpleMemberCommand< Self >     PulseObserverType;
+
   /** Observers for internal events */
   typedef USImageObject::ImageType             USImageType;
   typedef USImageObject::ITKImageModifiedEvent USITKImageModifiedEvent;
@@ -171,6 +392,8 @@ private:
                      CoordinateSystemTransformToResult )
   igstkObserverMacro(MRImageTransform,CoordinateSystemTransformToEvent,
                      CoordinateSystemTransformToResult )
+  igstkObserverMacro(ProbeTransform,CoordinateSystemTransformToEvent,
+                     CoordinateSystemTransformToResult )
 
 
 private:
@@ -180,6 +403,7 @@ private:
   igstkDeclareStateMacro( MRImageSet );
   igstkDeclareStateMacro( USImageSet );
   igstkDeclareStateMacro( ImagesSet );
+  igstkDeclareStateMacro( CalculatingRegistration ); 
   igstkDeclareStateMacro( RegistrationCalculated ); 
 
   /** List of Inputs */
@@ -189,7 +413,14 @@ private:
   igstkDeclareInputMacro( MRImageTransform );
   igstkDeclareInputMacro( USImageTransform  );
   igstkDeclareInputMacro( ValidRegistration );
+  igstkDeclareInputMacro( InvalidRegistration );
+  igstkDeclareInputMacro( InvalidRegistrationUpdate );
   igstkDeclareInputMacro( CalculateRegistration );
+  igstkDeclareInputMacro( StartRegistration );
+  igstkDeclareInputMacro( UpdateRegistration );
+  igstkDeclareInputMacro( StartRegistrationUpdate );
+  igstkDeclareInputMacro( StopRegistration );
+  igstkDeclareInputMacro( CheckRegistration );
   igstkDeclareInputMacro( RequestRegistrationTransform );
 
   
@@ -214,6 +445,77 @@ private:
   MRImageSpatialObject*    m_MRMovingImage;
   TransformType            m_InitialTransform;
 
+  /** Parameters of the optimization */
+  unsigned int             m_NumberOfLevels;
+  SamplingStrategyType     m_SamplingStrategy;
+  double                   m_SamplingPercentage;
+  unsigned int             m_NumberOfThreads;
+  unsigned int             m_MaximumNumberOfIterations;
+  double                   m_MaximumStepLength;
+  double                   m_MinimumStepLength;
+  unsigned int             m_TrackingNumberOfIterations;
+  double                   m_TrackingStepLength;
+  double                   m_TrackingSearchRadius;
+
+  /** Inputs of ExecuteRegistration(), set by PrepareRegistration() */
+  USImageType::ConstPointer                     m_FixedITKImage;
+  MRImageSpatialObject::ImageType::ConstPointer m_MovingITKImage;
+  ParametersType                                m_InitialParameters;
+
+  /** Outputs of ExecuteRegistration(). m_FinalParameters also holds the
+   *  previous solution used by the tracking updates. */
+  ParametersType           m_FinalParameters;
+  std::string              m_ErrorDescription;
+  bool                     m_PreviousSolutionAvailable;
+
+  /** Tracking mode state */
+  UltrasoundProbeObject*   m_UltrasoundProbe;
+  Transform                m_ProbeTransform;
+  bool                     m_ProbeTransformValid;
+  Transform                m_ProbeTransformAtRegistration;
+  bool                     m_ProbeTransformAtRegistrationValid;
+  ParametersType           m_SeedParameters;
+  bool                     m_TrackingRun;
+  bool                     m_OutsideSearchWindow;
+
+  /** ITK components kept between tracking updates, together with the
+   *  images they were initialized from */
+  InternalImageType::Pointer          m_TrackingFixedImage;
+  InternalImageType::Pointer          m_TrackingMovingImage;
+  const USImageType *                 m_TrackingFixedSource;
+  unsigned long                       m_TrackingFixedSourceMTime;
+  const MRImageSpatialObject::ImageType * m_TrackingMovingSource;
+  unsigned long                       m_TrackingMovingSourceMTime;
+  MetricType::Pointer                 m_TrackingMetric;
+  InterpolatorType::Pointer           m_TrackingInterpolator;
+  OptimizerType::Pointer              m_TrackingOptimizer;
+  VersorRigidTransformType::Pointer   m_TrackingTransform;
+
+  /** State shared with the registration thread. Protected by
+   *  m_ProgressLock. */
+  itk::SimpleMutexLock     m_ProgressLock;
+  unsigned int             m_ProgressLevel;
+  unsigned int             m_ProgressIteration;
+  double                   m_ProgressMetricValue;
+  ParametersType           m_ProgressParameters;
+  bool                     m_ProgressUpdated;
+  bool                     m_StopRequested;
+  bool                     m_RegistrationFinished;
+  bool                     m_RegistrationSucceeded;
+
+  /** Level of the pyramid being optimized. Only used by the thread running
+   *  ExecuteRegistration(). */
+  unsigned int             m_CurrentLevel;
+
+  /** Thread running the asynchronous registration */
+  itk::MultiThreader::Pointer  m_Threader;
+  int                          m_ThreadID;
+  bool                         m_ThreadRunning;
+
+  /** Pulse generator polling the registration thread */
+  PulseGenerator::Pointer      m_PulseGenerator;
+  PulseObserverType::Pointer   m_PulseObserver;
+
 };
 
 }
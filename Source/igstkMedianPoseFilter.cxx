@@ -0,0 +1,148 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMedianPoseFilter.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkMedianPoseFilter.h"
+
+#include <algorithm>
+
+namespace igstk
+{
+
+/** Constructor */
+MedianPoseFilter::MedianPoseFilter()
+{
+  m_WindowSize = 5;
+  for( unsigned int i = 0; i < MaximumWindowSize; i++ )
+    {
+    TransformBatch::SetToIdentity( m_Window[i] );
+    }
+  m_NumberOfPoses = 0;
+  m_NextPose = 0;
+}
+
+/** Destructor */
+MedianPoseFilter::~MedianPoseFilter()
+{
+}
+
+
+void
+MedianPoseFilter::SetWindowSize( unsigned int windowSize )
+{
+  windowSize = std::max( 1u, std::min( windowSize,
+    static_cast< unsigned int >( MaximumWindowSize ) ) );
+  if( windowSize == m_WindowSize )
+    {
+    return;
+    }
+
+  // Keep the last poses that fit in the new window, the oldest first, so
+  // that the circular buffer starts at the beginning of the window
+  const unsigned int numberOfPoses = std::min( m_NumberOfPoses, windowSize );
+  Pose poses[ MaximumWindowSize ];
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    poses[i] = m_Window[ ( m_NextPose + m_WindowSize - numberOfPoses + i ) %
+                         m_WindowSize ];
+    }
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    m_Window[i] = poses[i];
+    }
+
+  m_WindowSize = windowSize;
+  m_NumberOfPoses = numberOfPoses;
+  m_NextPose = numberOfPoses % windowSize;
+}
+
+
+void
+MedianPoseFilter::InternalFilterPose( Pose & pose, TimePeriodType,
+                                      bool firstPose )
+{
+  if( firstPose )
+    {
+    m_NumberOfPoses = 0;
+    m_NextPose = 0;
+    }
+
+  m_Window[ m_NextPose ] = pose;
+  m_NextPose = ( m_NextPose + 1 ) % m_WindowSize;
+  if( m_NumberOfPoses < m_WindowSize )
+    {
+    m_NumberOfPoses++;
+    }
+
+  const unsigned int middle = m_NumberOfPoses / 2;
+  double values[ MaximumWindowSize ];
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    for( unsigned int i = 0; i < m_NumberOfPoses; i++ )
+      {
+      values[i] = m_Window[i].m_Translation[k];
+      }
+    std::nth_element( values, values + middle, values + m_NumberOfPoses );
+    double median = values[middle];
+    if( m_NumberOfPoses % 2 == 0 )
+      {
+      median = 0.5 * ( median +
+        *std::max_element( values, values + middle ) );
+      }
+    pose.m_Translation[k] = median;
+    }
+
+  // Rotation with the smallest sum of angles to the other rotations
+  unsigned int closest = 0;
+  double smallestSum = 0.0;
+  for( unsigned int i = 0; i < m_NumberOfPoses; i++ )
+    {
+    double sum = 0.0;
+    for( unsigned int j = 0; j < m_NumberOfPoses; j++ )
+      {
+      if( j != i )
+        {
+        sum += ComputeAngle( m_Window[i].m_Rotation, m_Window[j].m_Rotation );
+        }
+      }
+    if( i == 0 || sum < smallestSum )
+      {
+      closest = i;
+      smallestSum = sum;
+      }
+    }
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    pose.m_Rotation[k] = m_Window[ closest ].m_Rotation[k];
+    }
+}
+
+
+/** Print Self function */
+void
+MedianPoseFilter::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "WindowSize: " << m_WindowSize << std::endl;
+}
+
+} // end namespace igstk
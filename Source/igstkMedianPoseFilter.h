@@ -0,0 +1,83 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMedianPoseFilter.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkMedianPoseFilter_h
+#define __igstkMedianPoseFilter_h
+
+#include "igstkPoseFilter.h"
+
+
+namespace igstk
+{
+
+/** \class MedianPoseFilter
+ * \brief Median of the last poses of a tool.
+ *
+ * The translation of the output is the median, on each axis, of the
+ * translations of the last WindowSize poses. Its rotation is the rotation
+ * of these poses which is the closest to the others, as the median of
+ * rotations is not defined. Isolated outliers are then discarded, at the
+ * cost of a lag of half the window.
+ *
+ * \ingroup Object
+ */
+class MedianPoseFilter : public PoseFilter
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( MedianPoseFilter, PoseFilter )
+  igstkNewMacro( Self );
+
+  /** Largest number of poses of the window */
+  enum { MaximumWindowSize = 15 };
+
+  /** Number of poses of the window, between 1 and MaximumWindowSize. An
+   *  odd number avoids averaging two translations. The last poses that fit
+   *  in the new window are kept. */
+  void SetWindowSize( unsigned int windowSize );
+  igstkGetMacro( WindowSize, unsigned int );
+
+protected:
+
+  MedianPoseFilter(void);
+  virtual ~MedianPoseFilter(void);
+
+  virtual void InternalFilterPose( Pose & pose, TimePeriodType time,
+                                   bool firstPose );
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  MedianPoseFilter(const Self&);    //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  unsigned int     m_WindowSize;
+
+  /** Last poses, in a circular buffer */
+  Pose             m_Window[ MaximumWindowSize ];
+  unsigned int     m_NumberOfPoses;
+  unsigned int     m_NextPose;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkMedianPoseFilter_h
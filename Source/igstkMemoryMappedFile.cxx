@@ -0,0 +1,227 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMemoryMappedFile.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkMemoryMappedFile.h"
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // defined(WIN32) || defined(_WIN32)
+
+namespace igstk
+{
+
+MemoryMappedFile::MemoryMappedFile()
+{
+  m_Pointer = NULL;
+  m_Size = 0;
+
+#if defined(WIN32) || defined(_WIN32)
+  m_File = INVALID_HANDLE_VALUE;
+  m_Mapping = NULL;
+#else
+  m_File = -1;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Close();
+}
+
+bool MemoryMappedFile::Open( const std::string & fileName, bool copyOnWrite )
+{
+  this->Close();
+
+#if defined(WIN32) || defined(_WIN32)
+
+  const DWORD access = copyOnWrite ? GENERIC_READ
+                                   : GENERIC_READ | GENERIC_WRITE;
+
+  m_File = ::CreateFileA( fileName.c_str(), access, FILE_SHARE_READ, NULL,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if( m_File == INVALID_HANDLE_VALUE )
+    {
+    return false;
+    }
+
+  LARGE_INTEGER size;
+  if( !::GetFileSizeEx( m_File, &size ) )
+    {
+    this->Close();
+    return false;
+    }
+  m_Size = static_cast< SizeType >( size.QuadPart );
+
+#else
+
+  m_File = ::open( fileName.c_str(), copyOnWrite ? O_RDONLY : O_RDWR );
+  if( m_File < 0 )
+    {
+    return false;
+    }
+
+  struct stat status;
+  if( ::fstat( m_File, &status ) != 0 )
+    {
+    this->Close();
+    return false;
+    }
+  m_Size = static_cast< SizeType >( status.st_size );
+
+#endif
+
+  return this->Map( !copyOnWrite );
+}
+
+bool MemoryMappedFile::Create( const std::string & fileName, SizeType size )
+{
+  this->Close();
+
+  m_Size = size;
+
+#if defined(WIN32) || defined(_WIN32)
+
+  // The mapping extends the file to its size
+  m_File = ::CreateFileA( fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                          NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+  if( m_File == INVALID_HANDLE_VALUE )
+    {
+    return false;
+    }
+
+#else
+
+  m_File = ::open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( m_File < 0 )
+    {
+    return false;
+    }
+
+  if( ::ftruncate( m_File, static_cast< off_t >( size ) ) != 0 )
+    {
+    this->Close();
+    return false;
+    }
+
+#endif
+
+  return this->Map( true );
+}
+
+bool MemoryMappedFile::Map( bool shared )
+{
+  if( m_Size == 0 )
+    {
+    this->Close();
+    return false;
+    }
+
+#if defined(WIN32) || defined(_WIN32)
+
+  const unsigned __int64 size = m_Size;
+
+  m_Mapping = ::CreateFileMappingA( m_File, NULL,
+                                    shared ? PAGE_READWRITE : PAGE_WRITECOPY,
+                                    static_cast< DWORD >( size >> 32 ),
+                                    static_cast< DWORD >( size & 0xffffffff ),
+                                    NULL );
+  if( m_Mapping == NULL )
+    {
+    this->Close();
+    return false;
+    }
+
+  m_Pointer = ::MapViewOfFile( m_Mapping,
+                               shared ? FILE_MAP_WRITE : FILE_MAP_COPY,
+                               0, 0, 0 );
+
+#else
+
+  void * pointer = ::mmap( NULL, m_Size, PROT_READ | PROT_WRITE,
+                           shared ? MAP_SHARED : MAP_PRIVATE, m_File, 0 );
+
+  m_Pointer = ( pointer == MAP_FAILED ) ? NULL : pointer;
+
+#endif
+
+  if( m_Pointer == NULL )
+    {
+    this->Close();
+    return false;
+    }
+
+  return true;
+}
+
+bool MemoryMappedFile::Flush()
+{
+  if( m_Pointer == NULL )
+    {
+    return false;
+    }
+
+#if defined(WIN32) || defined(_WIN32)
+  return ::FlushViewOfFile( m_Pointer, 0 ) && ::FlushFileBuffers( m_File );
+#else
+  return ::msync( m_Pointer, m_Size, MS_SYNC ) == 0;
+#endif
+}
+
+void MemoryMappedFile::Close()
+{
+#if defined(WIN32) || defined(_WIN32)
+
+  if( m_Pointer != NULL )
+    {
+    ::UnmapViewOfFile( m_Pointer );
+    }
+  if( m_Mapping != NULL )
+    {
+    ::CloseHandle( m_Mapping );
+    m_Mapping = NULL;
+    }
+  if( m_File != INVALID_HANDLE_VALUE )
+    {
+    ::CloseHandle( m_File );
+    m_File = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+  if( m_Pointer != NULL )
+    {
+    ::munmap( m_Pointer, m_Size );
+    }
+  if( m_File >= 0 )
+    {
+    ::close( m_File );
+    m_File = -1;
+    }
+
+#endif
+
+  m_Pointer = NULL;
+  m_Size = 0;
+}
+
+} // end of namespace igstk
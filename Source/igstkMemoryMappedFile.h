@@ -0,0 +1,97 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMemoryMappedFile.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkMemoryMappedFile_h
+#define __igstkMemoryMappedFile_h
+
+#include <cstddef>
+#include <string>
+
+namespace igstk
+{
+
+/** \class MemoryMappedFile
+ * \brief Maps a file in the address space of the process.
+ *
+ * The pages of a mapped file are read from the disk when they are first
+ * accessed, and can be dropped by the operating system under memory
+ * pressure without going to the swap, since the file itself backs them.
+ * This is used for holding large images out of core.
+ *
+ * A file can be mapped either shared, where writes to the memory reach the
+ * file, or copy-on-write, where they stay private to the process and the
+ * file is never modified.
+ *
+ * \ingroup Object
+ */
+class MemoryMappedFile
+{
+
+public:
+
+  typedef std::size_t   SizeType;
+
+  MemoryMappedFile();
+
+  /** The file is unmapped on destruction */
+  ~MemoryMappedFile();
+
+  /** Map the whole of an existing file. Returns false on failure. */
+  bool Open( const std::string & fileName, bool copyOnWrite );
+
+  /** Create a file of the given size, replacing any existing one, and map
+   *  it shared. Returns false on failure. */
+  bool Create( const std::string & fileName, SizeType size );
+
+  /** Write the modified pages of a shared mapping to the file */
+  bool Flush();
+
+  /** Unmap the file */
+  void Close();
+
+  /** Start of the mapping, or NULL if no file is mapped */
+  void * GetPointer() const { return m_Pointer; }
+
+  /** Size of the mapping in bytes */
+  SizeType GetSize() const { return m_Size; }
+
+  bool IsOpen() const { return m_Pointer != NULL; }
+
+private:
+
+  MemoryMappedFile(const MemoryMappedFile &); //purposely not implemented
+  void operator=(const MemoryMappedFile &);   //purposely not implemented
+
+  /** Map the file opened in m_File */
+  bool Map( bool shared );
+
+  void *        m_Pointer;
+  SizeType      m_Size;
+
+  /** Platform handles of the file and of the mapping */
+#if defined(WIN32) || defined(_WIN32)
+  void *        m_File;
+  void *        m_Mapping;
+#else
+  int           m_File;
+#endif
+
+};
+
+} // end of namespace igstk
+
+#endif  // __igstkMemoryMappedFile_h
@@ -0,0 +1,110 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMemoryMappedImageContainer.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkMemoryMappedImageContainer_h
+#define __igstkMemoryMappedImageContainer_h
+
+#include "igstkMemoryMappedFile.h"
+
+#include "itkImportImageContainer.h"
+
+namespace igstk
+{
+
+/** \class MemoryMappedImageContainer
+ * \brief Pixel container of an itk::Image backed by a memory mapped file.
+ *
+ * The container gives the image a buffer that lives in a raw file instead of
+ * in the heap. The image is used as any other itk::Image, and the VTK
+ * importer of the ImageSpatialObject reads the same buffer, so a volume
+ * larger than the physical memory only needs the pages currently in use.
+ *
+ * The raw file holds the pixels in the native byte order, without header,
+ * as written by the volume cache of the DICOMImageReader.
+ *
+ * \ingroup Object
+ */
+template < typename TElementIdentifier, typename TElement >
+class MemoryMappedImageContainer
+: public itk::ImportImageContainer< TElementIdentifier, TElement >
+{
+
+public:
+
+  typedef MemoryMappedImageContainer                       Self;
+  typedef itk::ImportImageContainer< TElementIdentifier, 
+                                     TElement >            Superclass;
+  typedef itk::SmartPointer< Self >                        Pointer;
+  typedef itk::SmartPointer< const Self >                  ConstPointer;
+
+  typedef TElementIdentifier                               ElementIdentifier;
+  typedef TElement                                         Element;
+
+  itkNewMacro( Self );
+
+  itkTypeMacro( MemoryMappedImageContainer, ImportImageContainer );
+
+  /** Map an existing raw file. With copyOnWrite the pixels can be modified
+   *  without changing the file. Returns false if the file can not be mapped
+   *  or does not hold a whole number of elements. */
+  bool MapFile( const std::string & fileName, bool copyOnWrite );
+
+  /** Create a raw file holding numberOfElements pixels and map it. Pixels
+   *  written to the container are written to the file. */
+  bool CreateFile( const std::string & fileName, 
+                   ElementIdentifier numberOfElements );
+
+  /** Write the modified pixels to the file */
+  bool Flush();
+
+  /** Name of the mapped file, empty if none is mapped */
+  const std::string & GetFileName() const { return m_FileName; }
+
+  /** Whether the pixels are written to the file */
+  bool IsFileShared() const { return m_File.IsOpen() && !m_CopyOnWrite; }
+
+protected:
+
+  MemoryMappedImageContainer();
+  ~MemoryMappedImageContainer();
+
+  void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  MemoryMappedImageContainer(const Self&); //purposely not implemented
+  void operator=(const Self&);             //purposely not implemented
+
+  /** Hand the mapping to the superclass */
+  void ImportMapping();
+
+  /** Release the mapping, dropping the pointer of the superclass first */
+  void Unmap();
+
+  MemoryMappedFile    m_File;
+  std::string         m_FileName;
+  bool                m_CopyOnWrite;
+
+};
+
+} // end of namespace igstk
+
+#ifndef IGSTK_MANUAL_INSTANTIATION
+#include "igstkMemoryMappedImageContainer.txx"
+#endif
+
+#endif  // __igstkMemoryMappedImageContainer_h
@@ -0,0 +1,148 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMemoryMappedImageContainer.txx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkMemoryMappedImageContainer_txx
+#define __igstkMemoryMappedImageContainer_txx
+
+#include "igstkMemoryMappedImageContainer.h"
+
+namespace igstk
+{
+
+/** Constructor */
+template < typename TElementIdentifier, typename TElement >
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::MemoryMappedImageContainer()
+{
+  m_CopyOnWrite = true;
+}
+
+/** Destructor */
+template < typename TElementIdentifier, typename TElement >
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::~MemoryMappedImageContainer()
+{
+  this->Unmap();
+}
+
+/** Map an existing raw file */
+template < typename TElementIdentifier, typename TElement >
+bool
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::MapFile( const std::string & fileName, bool copyOnWrite )
+{
+  this->Unmap();
+
+  if( !m_File.Open( fileName, copyOnWrite ) )
+    {
+    return false;
+    }
+
+  if( m_File.GetSize() % sizeof( Element ) != 0 )
+    {
+    m_File.Close();
+    return false;
+    }
+
+  m_FileName = fileName;
+  m_CopyOnWrite = copyOnWrite;
+  this->ImportMapping();
+
+  return true;
+}
+
+/** Create a raw file and map it */
+template < typename TElementIdentifier, typename TElement >
+bool
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::CreateFile( const std::string & fileName, 
+              ElementIdentifier numberOfElements )
+{
+  this->Unmap();
+
+  const MemoryMappedFile::SizeType size = 
+     static_cast< MemoryMappedFile::SizeType >( numberOfElements ) * 
+                                                           sizeof( Element );
+
+  if( !m_File.Create( fileName, size ) )
+    {
+    return false;
+    }
+
+  m_FileName = fileName;
+  m_CopyOnWrite = false;
+  this->ImportMapping();
+
+  return true;
+}
+
+/** Write the modified pixels to the file */
+template < typename TElementIdentifier, typename TElement >
+bool
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::Flush()
+{
+  if( !this->IsFileShared() )
+    {
+    return false;
+    }
+  return m_File.Flush();
+}
+
+/** Hand the mapping to the superclass */
+template < typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::ImportMapping()
+{
+  // The container never frees the mapping, Unmap() does
+  this->SetImportPointer( static_cast< Element * >( m_File.GetPointer() ),
+                   static_cast< ElementIdentifier >( 
+                                    m_File.GetSize() / sizeof( Element ) ),
+                   false );
+}
+
+/** Release the mapping */
+template < typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::Unmap()
+{
+  if( m_File.IsOpen() )
+    {
+    this->SetImportPointer( NULL, 0, false );
+    m_File.Close();
+    }
+  m_FileName = "";
+}
+
+/** Print Self function */
+template < typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImageContainer< TElementIdentifier, TElement >
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "CopyOnWrite: " << m_CopyOnWrite << std::endl;
+  os << indent << "MappedBytes: " << m_File.GetSize() << std::endl;
+}
+
+} // end namespace igstk
+
+#endif
@@ -19,23 +19,55 @@
 
 #include "igstkMeshResliceObjectRepresentation.h"
 #include "igstkEvents.h"
+#include "igstkResliceCache.h"
 
 #include <vtkPolyDataMapper.h>
 #include <vtkActor.h>
 #include <vtkProperty.h>
 #include <vtkPolyData.h>
 #include <vtkPoints.h>
-#include <vtkIdList.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkPlane.h>
-#include <vtkCutter.h>
 #include <vtkProperty.h>
 
+#include <map>
+
 
 namespace igstk
 { 
 
+namespace
+{
+
+/** VTK grids of the mesh objects, shared by their reslice representations */
+struct MeshResliceGrid
+{
+  vtkUnstructuredGrid *  m_Grid;
+  unsigned int           m_References;
+};
+
+typedef std::map< const MeshObject *, MeshResliceGrid >  MeshResliceGridMapType;
+
+MeshResliceGridMapType & GetMeshResliceGrids()
+{
+  static MeshResliceGridMapType grids;
+  return grids;
+}
+
+void ReleaseMeshResliceGrid( const MeshObject * mesh )
+{
+  MeshResliceGridMapType & grids = GetMeshResliceGrids();
+  MeshResliceGridMapType::iterator it = grids.find( mesh );
+  if( it != grids.end() && --it->second.m_References == 0 )
+    {
+    it->second.m_Grid->Delete();
+    grids.erase( it );
+    }
+}
+
+} // end anonymous namespace
+
 /** Constructor */
 
 MeshResliceObjectRepresentation
@@ -111,7 +143,9 @@ MeshResliceObjectRepresentation
 
   m_LineWidth = 1.0;
 
-  m_Cutter = vtkCutter::New();
+  m_MeshGrid = NULL;
+  m_ContourMapper = NULL;
+
   m_ReslicerPlaneCenterObserver = ReslicerPlaneCenterObserver::New();
   m_ReslicerPlaneNormalObserver = ReslicerPlaneNormalObserver::New();
   
@@ -131,8 +165,18 @@ MeshResliceObjectRepresentation
   this->DeleteActors();
   
   m_Plane->Delete();
-  m_Cutter->Delete();
   m_ContourProperty->Delete();
+
+  if( m_ContourMapper )
+    {
+    m_ContourMapper->Delete();
+    }
+
+  if( m_MeshGrid )
+    {
+    ResliceCache::Unsubscribe( m_MeshGrid, this );
+    ReleaseMeshResliceGrid( m_MeshObject );
+    }
 }
 
 
@@ -232,7 +276,8 @@ void MeshResliceObjectRepresentation
 {
   igstkLogMacro( DEBUG, "UpdateRepresentationProcessing called ....\n");
 
-  m_ReslicePlaneSpatialObject->RequestComputeReslicingPlane();
+  m_ReslicePlaneSpatialObject->RequestComputeReslicingPlane( 
+                                                   this->GetRenderTimeStamp() );
 
   m_ReslicerPlaneCenterObserver->Reset();
   m_ReslicerPlaneNormalObserver->Reset();
@@ -256,16 +301,64 @@ void MeshResliceObjectRepresentation
 
   m_Plane->SetNormal( normal[0], normal[1], normal[2] );
   m_Plane->SetOrigin( center[0], center[1], center[2] );
+
+  this->UpdateContour();
 }
 
-/** Create the vtk Actors */
+/** Get the contour of the current plane from the cache */
 
 void MeshResliceObjectRepresentation
-::CreateActors()
+::UpdateContour()
 {
-  // to avoid duplicates we clean the previous actors
-  this->DeleteActors();
+  if( !m_MeshGrid || !m_ContourMapper )
+    {
+    return;
+    }
+
+  vtkPolyData * contour = ResliceCache::GetCut( m_MeshGrid,
+                                                m_Plane->GetOrigin(),
+                                                m_Plane->GetNormal(),
+                                                this );
+
+  if( contour && m_ContourMapper->GetInput() != contour )
+    {
+    m_ContourMapper->SetInput( contour );
+    }
+}
 
+/** Get the shared grid of the mesh object */
+
+void MeshResliceObjectRepresentation
+::AcquireMeshGrid()
+{
+  if( m_MeshGrid || !m_MeshObject )
+    {
+    return;
+    }
+
+  MeshResliceGridMapType & grids = GetMeshResliceGrids();
+  MeshResliceGridMapType::iterator it = grids.find( m_MeshObject );
+
+  if( it == grids.end() )
+    {
+    MeshResliceGrid grid;
+    grid.m_Grid = this->CreateMeshGrid();
+    grid.m_References = 0;
+    it = grids.insert( 
+      MeshResliceGridMapType::value_type( m_MeshObject, grid ) ).first;
+    }
+
+  it->second.m_References++;
+
+  m_MeshGrid = it->second.m_Grid;
+  ResliceCache::Subscribe( m_MeshGrid );
+}
+
+/** Convert the mesh object to a VTK grid */
+
+vtkUnstructuredGrid * MeshResliceObjectRepresentation
+::CreateMeshGrid()
+{
   vtkUnstructuredGrid* polyData = vtkUnstructuredGrid::New();
   vtkPoints* polyPoints = vtkPoints::New();
 
@@ -287,18 +380,19 @@ void MeshResliceObjectRepresentation
   unsigned long nCells = cells->size();
     
   polyData->Allocate(nCells);
+
+  // The point ids of the supported cells fit in a fixed array
+  vtkIdType pts[4];
     
   for(;it_cells != cells->End();it_cells++)
     {
-    vtkIdList* pts = vtkIdList::New();
     MeshObjectType::CellTraits::PointIdConstIterator itptids 
                                       = (*it_cells)->Value()->GetPointIds();
     unsigned int id =0;
     const unsigned long ptsSize = (*it_cells)->Value()->GetNumberOfPoints();
-    pts->SetNumberOfIds(ptsSize);
-    while(itptids != (*it_cells)->Value()->PointIdsEnd())
+    while(itptids != (*it_cells)->Value()->PointIdsEnd() && id < 4)
       {
-      pts->SetId(id,*itptids);
+      pts[id] = *itptids;
       itptids++;
       id++;
       }
@@ -306,47 +400,58 @@ void MeshResliceObjectRepresentation
     switch( ptsSize )
       {
       case 2: 
-        polyData->InsertNextCell( VTK_LINE, pts );
+        polyData->InsertNextCell( VTK_LINE, 2, pts );
         break;
       case 3: 
-        polyData->InsertNextCell( VTK_TRIANGLE, pts );
+        polyData->InsertNextCell( VTK_TRIANGLE, 3, pts );
         break;
       case 4: 
-        polyData->InsertNextCell( VTK_TETRA, pts );
+        polyData->InsertNextCell( VTK_TETRA, 4, pts );
         break;
       default:
         igstkLogMacro( CRITICAL, "MeshResliceObjectRepresentation: "
             << "Don't know how to represent cells of size "
             << ptsSize << " \n" );
       }
-    pts->Delete();
     }
 
   polyData->SetPoints(polyPoints);
 
-  m_Cutter->SetInput(polyData);
-  m_Cutter->SetCutFunction(m_Plane);
+  polyPoints->Delete();
+
+  return polyData;
+}
+
+/** Create the vtk Actors */
+
+void MeshResliceObjectRepresentation
+::CreateActors()
+{
+  // to avoid duplicates we clean the previous actors
+  this->DeleteActors();
+
+  this->AcquireMeshGrid();
 
   vtkActor* contourActor = vtkActor::New();
-  vtkPolyDataMapper* contourMapper = vtkPolyDataMapper::New();
-  contourMapper->SetResolveCoincidentTopologyToPolygonOffset();
-  contourMapper->SetResolveCoincidentTopologyPolygonOffsetParameters(10,10);
+
+  if( m_ContourMapper )
+    {
+    m_ContourMapper->Delete();
+    }
+  m_ContourMapper = vtkPolyDataMapper::New();
+  m_ContourMapper->SetResolveCoincidentTopologyToPolygonOffset();
+  m_ContourMapper->SetResolveCoincidentTopologyPolygonOffsetParameters(10,10);
 
   m_ContourProperty->SetColor(this->GetRed(),
                               this->GetGreen(),
                               this->GetBlue());
 
-  contourMapper->SetInput(m_Cutter->GetOutput());
-  contourActor->SetMapper(contourMapper);
+  contourActor->SetMapper(m_ContourMapper);
   contourActor->SetProperty(m_ContourProperty);
 
-  contourMapper->Delete();
-
   this->AddActor( contourActor );
 
-  polyPoints->Delete();
-  polyData->Delete();
-
+  this->UpdateContour();
 }
 
 /** Create a copy of the current object representation */
@@ -26,8 +26,9 @@
 #include "igstkReslicerPlaneSpatialObject.h"
 
 class vtkPlane;
-class vtkCutter;
 class vtkProperty;
+class vtkPolyDataMapper;
+class vtkUnstructuredGrid;
 
 namespace igstk
 {
@@ -36,6 +37,10 @@ namespace igstk
  * 
  * \brief This class represents a Mesh object.
  * 
+ * The mesh is converted once to a VTK grid shared by all the reslice
+ * representations of the same MeshObject, and the contour is requested from
+ * the ResliceCache, so that the copies of this representation in several
+ * views cut the mesh only once per plane.
  *
  * \ingroup ObjectRepresentation
  */
@@ -129,6 +134,15 @@ private:
   /** Set reslice plane spatial object processing */
   void SetReslicePlaneSpatialObjectProcessing();
 
+  /** Convert the mesh object to a VTK grid */
+  vtkUnstructuredGrid * CreateMeshGrid();
+
+  /** Get the shared grid of the mesh object, creating it if needed */
+  void AcquireMeshGrid();
+
+  /** Get the contour of the current plane from the cache */
+  void UpdateContour();
+
 private:
 
   /** Inputs to the State Machine */
@@ -155,9 +169,13 @@ private:
 
   /** Plane defining the contour */
   vtkPlane*    m_Plane;
-  vtkCutter*   m_Cutter;
   vtkProperty* m_ContourProperty;
 
+  /** Grid shared with the other representations of the mesh object, and
+   *  mapper of the contour */
+  vtkUnstructuredGrid* m_MeshGrid;
+  vtkPolyDataMapper*   m_ContourMapper;
+
   //vtkTubeFilter* m_Tuber;
   double       m_LineWidth;
 };
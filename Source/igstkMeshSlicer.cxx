@@ -0,0 +1,358 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMeshSlicer.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkMeshSlicer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace igstk
+{
+
+namespace
+{
+
+/** Orders cells by the center of their bounds along an axis */
+class MeshSlicerCenterLess
+{
+public:
+  MeshSlicerCenterLess( const double * bounds, unsigned int axis )
+    {
+    m_Bounds = bounds;
+    m_Axis = axis;
+    }
+
+  bool operator()( MeshSlicer::IdType cell1, MeshSlicer::IdType cell2 ) const
+    {
+    return m_Bounds[ 6 * cell1 + m_Axis ] + m_Bounds[ 6 * cell1 + m_Axis + 3 ]
+         < m_Bounds[ 6 * cell2 + m_Axis ] + m_Bounds[ 6 * cell2 + m_Axis + 3 ];
+    }
+
+private:
+  const double *  m_Bounds;
+  unsigned int    m_Axis;
+};
+
+}
+
+MeshSlicer::MeshSlicer()
+{
+  m_LeafSize = 8;
+  m_NumberOfVisitedCells = 0;
+}
+
+void MeshSlicer::Clear()
+{
+  m_Points.clear();
+  m_CellPoints.clear();
+  m_CellSizes.clear();
+  m_CellBounds.clear();
+  m_Nodes.clear();
+  m_CellOrder.clear();
+  m_ContourPoints.clear();
+  m_VertexPoints.clear();
+  m_NumberOfVisitedCells = 0;
+}
+
+void MeshSlicer::SetPoints( const double * coordinates,
+                            IdType numberOfPoints )
+{
+  m_Points.assign( coordinates, coordinates + 3 * numberOfPoints );
+}
+
+bool MeshSlicer::AddCell( const IdType * pointIds,
+                          unsigned int numberOfPoints )
+{
+  if( numberOfPoints < 2 || numberOfPoints > 4 )
+    {
+    return false;
+    }
+
+  for( unsigned int i = 0; i < numberOfPoints; i++ )
+    {
+    if( pointIds[i] >= this->GetNumberOfPoints() )
+      {
+      return false;
+      }
+    }
+
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    m_CellPoints.push_back( pointIds[ std::min( i, numberOfPoints - 1 ) ] );
+    }
+  m_CellSizes.push_back( static_cast< unsigned char >( numberOfPoints ) );
+
+  return true;
+}
+
+void MeshSlicer::SetLeafSize( unsigned int leafSize )
+{
+  m_LeafSize = std::max( leafSize, 1u );
+}
+
+void MeshSlicer::Build()
+{
+  const IdType numberOfCells = this->GetNumberOfCells();
+
+  m_CellBounds.resize( 6 * numberOfCells );
+  m_CellOrder.resize( numberOfCells );
+
+  for( IdType cell = 0; cell < numberOfCells; cell++ )
+    {
+    double * bounds = &m_CellBounds[ 6 * cell ];
+    for( unsigned int i = 0; i < 4; i++ )
+      {
+      const double * point = &m_Points[ 3 * m_CellPoints[ 4 * cell + i ] ];
+      for( unsigned int axis = 0; axis < 3; axis++ )
+        {
+        const double coordinate = point[axis];
+        if( i == 0 || coordinate < bounds[axis] )
+          {
+          bounds[axis] = coordinate;
+          }
+        if( i == 0 || coordinate > bounds[axis + 3] )
+          {
+          bounds[axis + 3] = coordinate;
+          }
+        }
+      }
+    m_CellOrder[cell] = cell;
+    }
+
+  m_Nodes.clear();
+  if( numberOfCells > 0 )
+    {
+    m_Nodes.reserve( 2 * ( numberOfCells / m_LeafSize + 1 ) );
+    this->BuildNode( 0, numberOfCells );
+    }
+
+  // The bounds of the cells are not needed by the cuts
+  std::vector< double >().swap( m_CellBounds );
+}
+
+MeshSlicer::IdType MeshSlicer::BuildNode( IdType first, IdType count )
+{
+  const IdType index = static_cast< IdType >( m_Nodes.size() );
+  m_Nodes.push_back( Node() );
+
+  Node node;
+  for( IdType i = first; i < first + count; i++ )
+    {
+    const double * bounds = &m_CellBounds[ 6 * m_CellOrder[i] ];
+    for( unsigned int axis = 0; axis < 3; axis++ )
+      {
+      if( i == first || bounds[axis] < node.m_Minimum[axis] )
+        {
+        node.m_Minimum[axis] = bounds[axis];
+        }
+      if( i == first || bounds[axis + 3] > node.m_Maximum[axis] )
+        {
+        node.m_Maximum[axis] = bounds[axis + 3];
+        }
+      }
+    }
+
+  if( count <= m_LeafSize )
+    {
+    node.m_First = first;
+    node.m_Count = count;
+    m_Nodes[index] = node;
+    return index;
+    }
+
+  // Split at the median of the longest axis
+  unsigned int axis = 0;
+  for( unsigned int i = 1; i < 3; i++ )
+    {
+    if( node.m_Maximum[i] - node.m_Minimum[i] >
+        node.m_Maximum[axis] - node.m_Minimum[axis] )
+      {
+      axis = i;
+      }
+    }
+
+  const IdType half = count / 2;
+  std::nth_element( m_CellOrder.begin() + first,
+                    m_CellOrder.begin() + first + half,
+                    m_CellOrder.begin() + first + count,
+                    MeshSlicerCenterLess( &m_CellBounds[0], axis ) );
+
+  node.m_Count = 0;
+  this->BuildNode( first, half );
+  node.m_First = this->BuildNode( first + half, count - half );
+
+  m_Nodes[index] = node;
+  return index;
+}
+
+MeshSlicer::IdType MeshSlicer::Cut( const double center[3],
+                                    const double normal[3] )
+{
+  m_ContourPoints.clear();
+  m_VertexPoints.clear();
+  m_NumberOfVisitedCells = 0;
+
+  if( m_Nodes.empty() )
+    {
+    return 0;
+    }
+
+  const double offset = normal[0] * center[0] + normal[1] * center[1] +
+                        normal[2] * center[2];
+
+  m_Stack.clear();
+  m_Stack.push_back( 0 );
+
+  while( !m_Stack.empty() )
+    {
+    const IdType index = m_Stack.back();
+    const Node & node = m_Nodes[index];
+    m_Stack.pop_back();
+
+    // Distance from the center of the box to the plane, against the
+    // projection of its half diagonal on the normal
+    double distance = -offset;
+    double radius = 0.0;
+    for( unsigned int axis = 0; axis < 3; axis++ )
+      {
+      distance += normal[axis] *
+        0.5 * ( node.m_Minimum[axis] + node.m_Maximum[axis] );
+      radius += fabs( normal[axis] ) *
+        0.5 * ( node.m_Maximum[axis] - node.m_Minimum[axis] );
+      }
+
+    if( fabs( distance ) > radius )
+      {
+      continue;
+      }
+
+    if( node.m_Count > 0 )
+      {
+      for( IdType i = node.m_First; i < node.m_First + node.m_Count; i++ )
+        {
+        this->CutCell( m_CellOrder[i], normal, offset );
+        }
+      m_NumberOfVisitedCells += node.m_Count;
+      }
+    else
+      {
+      m_Stack.push_back( index + 1 );
+      m_Stack.push_back( node.m_First );
+      }
+    }
+
+  return this->GetNumberOfSegments();
+}
+
+void MeshSlicer::CutCell( IdType cell, const double normal[3],
+                          double offset )
+{
+  const unsigned int size = m_CellSizes[cell];
+
+  const double * points[4];
+  double distances[4];
+  unsigned int above[4];
+  unsigned int below[4];
+  unsigned int numberOfAbove = 0;
+  unsigned int numberOfBelow = 0;
+
+  for( unsigned int i = 0; i < size; i++ )
+    {
+    points[i] = &m_Points[ 3 * m_CellPoints[ 4 * cell + i ] ];
+    distances[i] = normal[0] * points[i][0] + normal[1] * points[i][1] +
+                   normal[2] * points[i][2] - offset;
+    if( distances[i] >= 0.0 )
+      {
+      above[ numberOfAbove++ ] = i;
+      }
+    else
+      {
+      below[ numberOfBelow++ ] = i;
+      }
+    }
+
+  if( numberOfAbove == 0 || numberOfBelow == 0 )
+    {
+    return;
+    }
+
+  // A line that crosses the plane leaves a vertex
+  if( size == 2 )
+    {
+    AddEdgePoint( m_VertexPoints, points[0], distances[0],
+                  points[1], distances[1] );
+    return;
+    }
+
+  // One point alone on its side: the section is a segment for a triangle,
+  // a triangle for a tetrahedron
+  const unsigned int * alone = ( numberOfAbove == 1 ) ? above : below;
+  const unsigned int * others = ( numberOfAbove == 1 ) ? below : above;
+  const unsigned int numberOfOthers =
+    ( numberOfAbove == 1 ) ? numberOfBelow : numberOfAbove;
+
+  if( numberOfAbove == 1 || numberOfBelow == 1 )
+    {
+    const unsigned int a = alone[0];
+    for( unsigned int i = 0; i < numberOfOthers; i++ )
+      {
+      const unsigned int b = others[i];
+      const unsigned int c = others[ ( i + 1 ) % numberOfOthers ];
+      AddEdgePoint( m_ContourPoints, points[a], distances[a],
+                    points[b], distances[b] );
+      AddEdgePoint( m_ContourPoints, points[a], distances[a],
+                    points[c], distances[c] );
+      if( numberOfOthers == 2 )
+        {
+        break;
+        }
+      }
+    return;
+    }
+
+  // Two points on each side of a tetrahedron: the section is the
+  // quadrilateral of the four edges that cross the plane
+  const unsigned int a1 = above[0];
+  const unsigned int a2 = above[1];
+  const unsigned int b1 = below[0];
+  const unsigned int b2 = below[1];
+
+  const unsigned int cycle[4][2] = { { a1, b1 }, { a1, b2 },
+                                     { a2, b2 }, { a2, b1 } };
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    const unsigned int * edge1 = cycle[i];
+    const unsigned int * edge2 = cycle[ ( i + 1 ) % 4 ];
+    AddEdgePoint( m_ContourPoints, points[ edge1[0] ], distances[ edge1[0] ],
+                  points[ edge1[1] ], distances[ edge1[1] ] );
+    AddEdgePoint( m_ContourPoints, points[ edge2[0] ], distances[ edge2[0] ],
+                  points[ edge2[1] ], distances[ edge2[1] ] );
+    }
+}
+
+void MeshSlicer::AddEdgePoint( std::vector< double > & output,
+                               const double * point1, double distance1,
+                               const double * point2, double distance2 )
+{
+  const double t = distance1 / ( distance1 - distance2 );
+  for( unsigned int axis = 0; axis < 3; axis++ )
+    {
+    output.push_back( point1[axis] + t * ( point2[axis] - point1[axis] ) );
+    }
+}
+
+} // end namespace igstk
@@ -0,0 +1,166 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMeshSlicer.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkMeshSlicer_h
+#define __igstkMeshSlicer_h
+
+#include <vector>
+
+namespace igstk
+{
+
+/** \class MeshSlicer
+ * \brief Cuts a mesh of tetrahedra and triangles by planes.
+ *
+ * A bounding volume hierarchy of the cells is built once, and each cut
+ * only visits the cells whose bounding boxes straddle the plane. Moving
+ * the plane, for instance when it follows a tracked needle, costs in
+ * proportion to the size of the contour rather than to the size of the
+ * mesh.
+ *
+ * The contour is produced as independent line segments, two points per
+ * segment, in buffers that are reused from one cut to the next. A
+ * tetrahedron contributes the edges of its triangular or quadrilateral
+ * section, a triangle contributes one segment. A line that crosses the
+ * plane contributes its intersection point, kept apart from the segments
+ * as vtkCutter outputs it as a vertex.
+ *
+ * \ingroup Object
+ */
+class MeshSlicer
+{
+
+public:
+
+  typedef unsigned int   IdType;
+
+  MeshSlicer();
+
+  /** Remove the points and the cells */
+  void Clear();
+
+  /** Copy the coordinates of the points, three values per point */
+  void SetPoints( const double * coordinates, IdType numberOfPoints );
+
+  /** Add a cell of two, three or four points, after the points are set.
+   *  Returns false for the other sizes and for invalid point ids, and the
+   *  cell is ignored. */
+  bool AddCell( const IdType * pointIds, unsigned int numberOfPoints );
+
+  /** Build the hierarchy. Must be called after the cells are added */
+  void Build();
+
+  /** Cut the mesh by the plane defined by a point and a normal. Returns the
+   *  number of segments of the contour, the vertices of the lines are
+   *  counted by GetNumberOfVertices(). */
+  IdType Cut( const double center[3], const double normal[3] );
+
+  /** Coordinates of the points of the last contour, two points per
+   *  segment */
+  const std::vector< double > & GetContourPoints() const
+    {
+    return m_ContourPoints;
+    }
+
+  IdType GetNumberOfSegments() const
+    {
+    return static_cast< IdType >( m_ContourPoints.size() / 6 );
+    }
+
+  /** Coordinates of the intersections of the lines with the plane in the
+   *  last cut, one point per vertex */
+  const std::vector< double > & GetVertexPoints() const
+    {
+    return m_VertexPoints;
+    }
+
+  IdType GetNumberOfVertices() const
+    {
+    return static_cast< IdType >( m_VertexPoints.size() / 3 );
+    }
+
+  IdType GetNumberOfPoints() const
+    {
+    return static_cast< IdType >( m_Points.size() / 3 );
+    }
+
+  IdType GetNumberOfCells() const
+    {
+    return static_cast< IdType >( m_CellSizes.size() );
+    }
+
+  /** Number of cells tested by the last cut */
+  IdType GetNumberOfVisitedCells() const
+    {
+    return m_NumberOfVisitedCells;
+    }
+
+  /** Set/Get the maximum number of cells in a leaf of the hierarchy. The
+   *  default is 8 */
+  void SetLeafSize( unsigned int leafSize );
+  unsigned int GetLeafSize() const
+    {
+    return m_LeafSize;
+    }
+
+private:
+
+  /** Node of the hierarchy. A leaf holds a range of m_CellOrder. The first
+   *  child of an inner node follows it, and m_First is its second child. */
+  struct Node
+    {
+    double        m_Minimum[3];
+    double        m_Maximum[3];
+    IdType        m_First;
+    IdType        m_Count;
+    };
+
+  /** Build the subtree of a range of m_CellOrder, and return its index */
+  IdType BuildNode( IdType first, IdType count );
+
+  /** Add the contour of a cell */
+  void CutCell( IdType cell, const double normal[3], double offset );
+
+  /** Add the intersection of an edge with the plane to a list of points */
+  static void AddEdgePoint( std::vector< double > & output,
+                            const double * point1, double distance1,
+                            const double * point2, double distance2 );
+
+  std::vector< double >         m_Points;
+
+  /** Four point ids per cell, and number of points of the cells */
+  std::vector< IdType >         m_CellPoints;
+  std::vector< unsigned char >  m_CellSizes;
+
+  /** Bounds of the cells, used while building */
+  std::vector< double >         m_CellBounds;
+
+  std::vector< Node >           m_Nodes;
+  std::vector< IdType >         m_CellOrder;
+  std::vector< IdType >         m_Stack;
+
+  std::vector< double >         m_ContourPoints;
+  std::vector< double >         m_VertexPoints;
+
+  unsigned int                  m_LeafSize;
+  IdType                        m_NumberOfVisitedCells;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkMeshSlicer_h
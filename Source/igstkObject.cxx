@@ -31,11 +31,32 @@ Object::Object()
   m_ObservedObjectDeleteReceptor = DeleteEventCommandType::New();
   m_ObservedObjectDeleteReceptor->SetCallbackFunction( 
     this, &igstk::Object::ObservedObjectDeleteProcessing );
+#if defined(IGSTK_USE_FastEventDispatch)
+  m_DispatchTable = new DispatchTable;
+  m_DispatchTable->m_LastEventType = NULL;
+  m_DispatchTable->m_LastObservers = NULL;
+  m_DispatchTable->m_NumberOfInvocations = 0;
+  m_InvocationDepth = 0;
+  m_NumberOfMarkedObservers = 0;
+#endif
 }
 
 Object::~Object()
 {
   this->RemoveFromObservedObjects();
+#if defined(IGSTK_USE_FastEventDispatch)
+  ObserverContainer::iterator observer = m_Observers.begin();
+  while( observer != m_Observers.end() )
+    {
+    delete observer->m_Event;
+    ++observer;
+    }
+  delete m_DispatchTable;
+  for( unsigned int i = 0; i < m_RetiredDispatchTables.size(); i++ )
+    {
+    delete m_RetiredDispatchTables[i];
+    }
+#endif
 }
 
 
@@ -56,11 +77,251 @@ Object::SetLogger( LoggerType * logger)
 void 
 Object::RemoveObserver( unsigned long tag ) const
 { 
+#if defined(IGSTK_USE_FastEventDispatch)
+  m_ObserversLock.Lock();
+#endif
+
   Object * nonConstObject = const_cast< Object * >( this );
   nonConstObject->Superclass::RemoveObserver( tag );
+
+#if defined(IGSTK_USE_FastEventDispatch)
+  ObserverContainer::iterator observer = m_Observers.begin();
+  while( observer != m_Observers.end() )
+    {
+    if( observer->m_Tag == tag && !observer->m_Removed )
+      {
+      observer->m_Removed = true;
+      m_NumberOfMarkedObservers++;
+      this->ObserversModified();
+      break;
+      }
+    ++observer;
+    }
+  m_ObserversLock.Unlock();
+#endif
+}
+
+
+#if defined(IGSTK_USE_FastEventDispatch)
+
+unsigned long
+Object::AddObserver( const EventType & event, ::itk::Command * command ) const
+{
+  m_ObserversLock.Lock();
+
+  const unsigned long tag = this->Superclass::AddObserver( event, command );
+
+  Observer observer;
+  observer.m_Tag = tag;
+  observer.m_Event = event.MakeObject();
+  observer.m_Command = command;
+  observer.m_Removed = false;
+  m_Observers.push_back( observer );
+
+  this->ObserversModified();
+
+  m_ObserversLock.Unlock();
+
+  return tag;
+}
+
+
+void
+Object::RemoveAllObservers()
+{
+  m_ObserversLock.Lock();
+
+  this->Superclass::RemoveAllObservers();
+
+  ObserverContainer::iterator observer = m_Observers.begin();
+  while( observer != m_Observers.end() )
+    {
+    if( !observer->m_Removed )
+      {
+      observer->m_Removed = true;
+      m_NumberOfMarkedObservers++;
+      }
+    ++observer;
+    }
+  this->ObserversModified();
+
+  m_ObserversLock.Unlock();
+}
+
+
+void
+Object::InvokeEvent( const EventType & event )
+{
+  DispatchTable * table;
+  const ObserverListType & observers = this->BeginInvocation( event, table );
+  const unsigned int numberOfObservers = 
+    static_cast< unsigned int >( observers.size() );
+
+  for( unsigned int i = 0; i < numberOfObservers; i++ )
+    {
+    // Observers removed by the previous ones, or by other threads, are
+    // skipped
+    if( !this->IsObserverRemoved( observers[i] ) )
+      {
+      observers[i]->m_Command->Execute( this, event );
+      }
+    }
+
+  this->EndInvocation( table );
 }
 
 
+void
+Object::InvokeEvent( const EventType & event ) const
+{
+  DispatchTable * table;
+  const ObserverListType & observers = this->BeginInvocation( event, table );
+  const unsigned int numberOfObservers = 
+    static_cast< unsigned int >( observers.size() );
+
+  for( unsigned int i = 0; i < numberOfObservers; i++ )
+    {
+    if( !this->IsObserverRemoved( observers[i] ) )
+      {
+      observers[i]->m_Command->Execute( this, event );
+      }
+    }
+
+  this->EndInvocation( table );
+}
+
+
+const Object::ObserverListType &
+Object::BeginInvocation( const EventType & event,
+                         DispatchTable * & table ) const
+{
+  m_ObserversLock.Lock();
+
+  // The lists of the table are not changed while it is in use, adding a
+  // list does not move the others
+  table = m_DispatchTable;
+  table->m_NumberOfInvocations++;
+  m_InvocationDepth++;
+
+  const std::type_info * eventType = &typeid( event );
+  if( eventType == table->m_LastEventType )
+    {
+    const ObserverListType & observers = *table->m_LastObservers;
+    m_ObserversLock.Unlock();
+    return observers;
+    }
+
+  ObserverListMapType::iterator entry = table->m_Lists.find( eventType );
+  if( entry == table->m_Lists.end() )
+    {
+    // The observers are selected as in itk::Object, by checking the event
+    // they observe, but only once for each type of event
+    entry = table->m_Lists.insert( 
+      ObserverListMapType::value_type( eventType, ObserverListType() ) ).first;
+
+    ObserverContainer::const_iterator observer = m_Observers.begin();
+    while( observer != m_Observers.end() )
+      {
+      if( !observer->m_Removed && observer->m_Event->CheckEvent( &event ) )
+        {
+        entry->second.push_back( &( *observer ) );
+        }
+      ++observer;
+      }
+    }
+
+  table->m_LastEventType = eventType;
+  table->m_LastObservers = &( entry->second );
+
+  m_ObserversLock.Unlock();
+
+  return entry->second;
+}
+
+
+void
+Object::EndInvocation( DispatchTable * table ) const
+{
+  m_ObserversLock.Lock();
+
+  table->m_NumberOfInvocations--;
+  m_InvocationDepth--;
+
+  // A table replaced while in use is deleted by its last invocation
+  if( table != m_DispatchTable && table->m_NumberOfInvocations == 0 )
+    {
+    m_RetiredDispatchTables.erase( std::find( m_RetiredDispatchTables.begin(),
+      m_RetiredDispatchTables.end(), table ) );
+    delete table;
+    }
+
+  this->RemoveMarkedObservers();
+
+  m_ObserversLock.Unlock();
+}
+
+
+bool
+Object::IsObserverRemoved( const Observer * observer ) const
+{
+  m_ObserversLock.Lock();
+  const bool removed = observer->m_Removed;
+  m_ObserversLock.Unlock();
+  return removed;
+}
+
+
+void
+Object::ObserversModified() const
+{
+  // The lists in use are kept until their invocations are done, and the
+  // next invocations use new lists
+  if( m_DispatchTable->m_NumberOfInvocations > 0 )
+    {
+    m_RetiredDispatchTables.push_back( m_DispatchTable );
+    m_DispatchTable = new DispatchTable;
+    m_DispatchTable->m_NumberOfInvocations = 0;
+    }
+  else
+    {
+    m_DispatchTable->m_Lists.clear();
+    }
+  m_DispatchTable->m_LastEventType = NULL;
+  m_DispatchTable->m_LastObservers = NULL;
+
+  this->RemoveMarkedObservers();
+}
+
+
+void
+Object::RemoveMarkedObservers() const
+{
+  // The lists of the invocations in progress may point to them
+  if( m_InvocationDepth > 0 || m_NumberOfMarkedObservers == 0 )
+    {
+    return;
+    }
+
+  ObserverContainer::iterator observer = m_Observers.begin();
+  while( observer != m_Observers.end() )
+    {
+    if( observer->m_Removed )
+      {
+      delete observer->m_Event;
+      observer = m_Observers.erase( observer );
+      }
+    else
+      {
+      ++observer;
+      }
+    }
+  m_NumberOfMarkedObservers = 0;
+}
+
+#endif
+
+
+
 void
 Object::RegisterObservedObject( 
   const ObservedObjectType * object, unsigned long tag )
@@ -19,10 +19,18 @@
 
 
 #include "itkObject.h"
+#include "itkCommand.h"
 #include "itkLogger.h"
+#include "itkMutexLock.h"
 
 #include "igstkLogger.h"
 #include "igstkMacros.h"
+#include "igstkConfigure.h"
+
+#include <list>
+#include <map>
+#include <typeinfo>
+#include <vector>
 
 
 namespace igstk
@@ -35,6 +43,20 @@ namespace igstk
  *  introducion additional elemets that are common to IGSTK
  *  Objects.
  *
+ *  When IGSTK_USE_FastEventDispatch is enabled, this class keeps its own
+ *  copy of the observers, and InvokeEvent() calls the observers of an
+ *  event type from a list built on the first invocation of that type,
+ *  instead of checking the event of every observer at every invocation.
+ *  The lists are rebuilt after observers are added or removed. The
+ *  observers must be added with the methods of this class, not through a
+ *  pointer to itk::Object, to be called by InvokeEvent().
+ *
+ *  The observers and their lists are protected by a lock, which is not
+ *  held while the observers are called. Events can thus be invoked, and
+ *  observers added and removed, from several threads. An invocation calls
+ *  the observers of the lists in use when it started, minus those removed
+ *  since then.
+ *
  */
 
 class Object  : public ::itk::Object
@@ -60,6 +82,19 @@ public:
 
   void RemoveObserver(unsigned long tag) const;
 
+#if defined(IGSTK_USE_FastEventDispatch)
+  /** Add an observer. The observer is also registered with itk::Object, so
+   *  that the events invoked by ITK, such as DeleteEvent, still reach it. */
+  unsigned long AddObserver( const ::itk::EventObject & event,
+                             ::itk::Command * command ) const;
+
+  void RemoveAllObservers();
+
+  /** Call the observers of the event */
+  void InvokeEvent( const ::itk::EventObject & event );
+  void InvokeEvent( const ::itk::EventObject & event ) const;
+#endif
+
 protected: 
 
   LoggerType * GetLogger() const;
@@ -97,6 +132,75 @@ private:
   ObservedObjectPairContainer                 m_ObservedObjectPairContainer;
   DeleteEventCommandType::Pointer             m_ObservedObjectDeleteReceptor;
 
+#if defined(IGSTK_USE_FastEventDispatch)
+
+  struct Observer
+    {
+    unsigned long            m_Tag;
+    EventType *              m_Event;
+    ::itk::Command::Pointer  m_Command;
+    bool                     m_Removed;
+    };
+
+  typedef std::list< Observer >            ObserverContainer;
+  typedef std::vector< const Observer * >  ObserverListType;
+
+  /** Order of the types of the invoked events */
+  struct EventTypeLess
+    {
+    bool operator()( const std::type_info * a, const std::type_info * b ) const
+      {
+      return a->before( *b ) != 0;
+      }
+    };
+
+  typedef std::map< const std::type_info *, ObserverListType, EventTypeLess >
+                                                           ObserverListMapType;
+
+  /** Lists of the observers of each type of event invoked so far. A table
+   *  is replaced, rather than changed, when the observers are modified
+   *  while invocations use it, and deleted when they are done. */
+  struct DispatchTable
+    {
+    ObserverListMapType        m_Lists;
+
+    /** Last event type looked up, to skip the search in the table when
+     *  the same event is invoked repeatedly */
+    const std::type_info *     m_LastEventType;
+    const ObserverListType *   m_LastObservers;
+
+    /** Number of invocations using the lists */
+    unsigned int               m_NumberOfInvocations;
+    };
+
+  /** Start an invocation: get the observers of the type of the event, and
+   *  the table holding them until EndInvocation() */
+  const ObserverListType & BeginInvocation( const EventType & event,
+                                            DispatchTable * & table ) const;
+  void EndInvocation( DispatchTable * table ) const;
+
+  /** Whether an observer was removed since the invocation started */
+  bool IsObserverRemoved( const Observer * observer ) const;
+
+  /** Called with the lock held when observers were added or removed */
+  void ObserversModified() const;
+
+  /** Remove the observers marked as removed, unless events are being
+   *  invoked. Called with the lock held. */
+  void RemoveMarkedObservers() const;
+
+  mutable ::itk::SimpleMutexLock      m_ObserversLock;
+  mutable ObserverContainer           m_Observers;
+  mutable DispatchTable *             m_DispatchTable;
+  mutable std::vector< DispatchTable * > m_RetiredDispatchTables;
+
+  /** Number of invocations in progress, during which the observers are
+   *  only marked as removed */
+  mutable unsigned int                m_InvocationDepth;
+  mutable unsigned int                m_NumberOfMarkedObservers;
+
+#endif
+
   /** This method is called when an object we are observing is deleted.
    *  It removes the object being deleted (caller) from our internal list
    *  of observed objects. We use the internal list to remove our observers
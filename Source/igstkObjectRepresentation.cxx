@@ -51,6 +51,7 @@ ObjectRepresentation::ObjectRepresentation():
   this->m_Color[2] = 1.0;
   this->m_Opacity = 1.0;
   this->m_SpatialObject = NULL;
+  this->m_ActorsTransformUpToDate = false;
 
   igstkAddInputMacro( ValidSpatialObject );
   igstkAddInputMacro( NullSpatialObject  );
@@ -214,6 +215,9 @@ void ObjectRepresentation::AddActor( vtkProp * actor )
   // Initialize objects based on the visibility state machine.
   this->RequestSetActorVisibility( actor );
   this->m_Actors.push_back( actor );
+
+  // The new actor has not received the current transform yet
+  this->m_ActorsTransformUpToDate = false;
 }
 
 /** Empty the list of actors */
@@ -340,15 +344,56 @@ void ObjectRepresentation::RequestGetTransformProcessing()
 }
 
 
+/** Start time of the transform currently used by the representation */
+TimeStamp::TimePeriodType ObjectRepresentation::GetTransformStartTime() const
+{
+  return this->m_SpatialObjectTransform.GetStartTime();
+}
+
+
+/** Exact comparison of the rotation and translation of two transforms. Time
+ *  stamps and error values are ignored. */
+static bool HaveSameGeometry( const Transform & t1, const Transform & t2 )
+{
+  const Transform::VersorType & r1 = t1.GetRotation();
+  const Transform::VersorType & r2 = t2.GetRotation();
+
+  if( r1.GetX() != r2.GetX() || r1.GetY() != r2.GetY() ||
+      r1.GetZ() != r2.GetZ() || r1.GetW() != r2.GetW() )
+    {
+    return false;
+    }
+
+  const Transform::VectorType & p1 = t1.GetTranslation();
+  const Transform::VectorType & p2 = t2.GetTranslation();
+
+  return ( p1[0] == p2[0] && p1[1] == p2[1] && p1[2] == p2[2] );
+}
+
+
 /** Receive the Transform from the SpatialObject via a transduction macro. */
 void ObjectRepresentation::ReceiveSpatialObjectTransformProcessing()
 {
-  this->m_SpatialObjectTransform = 
+  const Transform & receivedTransform =
     this->m_SpatialObjectTransformInputToBeSet.GetTransform();
 
+  const bool sameGeometry = this->m_ActorsTransformUpToDate &&
+    HaveSameGeometry( receivedTransform, this->m_SpatialObjectTransform );
+
+  this->m_SpatialObjectTransform = receivedTransform;
+
   igstkLogMacro( DEBUG, 
     "Received SpatialObject Transform " << this->m_SpatialObjectTransform );
 
+  // The time stamp is always refreshed, but the actors are only touched when
+  // the geometry changed. Setting a new user matrix modifies the actors, and
+  // the View uses their modification time for skipping unchanged frames.
+  if( sameGeometry )
+    {
+    this->RequestVerifyTimeStampAndUpdateVisibility();
+    return;
+    }
+
   vtkMatrix4x4* vtkMatrix = vtkMatrix4x4::New();
 
   this->m_SpatialObjectTransform.ExportTransform( *vtkMatrix );
@@ -363,6 +408,8 @@ void ObjectRepresentation::ReceiveSpatialObjectTransformProcessing()
 
   vtkMatrix->Delete();
 
+  this->m_ActorsTransformUpToDate = true;
+
   this->RequestVerifyTimeStampAndUpdateVisibility();
 }
 
@@ -111,6 +111,11 @@ public:
     const TimeStamp & time, 
     const CoordinateSystem* cs );
 
+  /** Start time of the last transform received from the spatial object. For
+   * tracked objects this is the time at which the tracker measurement was
+   * processed, and the View uses it for estimating the display latency. */
+  TimeStamp::TimePeriodType GetTransformStartTime() const;
+
 protected:
 
   ObjectRepresentation( void );
@@ -229,6 +234,11 @@ private:
   /** Used to store an actor for visibility state machine processing. */
   vtkProp *                               m_VisibilitySetActor;
 
+  /** True when the user matrix of every actor already holds the geometry of
+   *  m_SpatialObjectTransform. Used for not touching (and therefore not
+   *  modifying) the actors when the same transform is received again. */
+  bool                                    m_ActorsTransformUpToDate;
+
   /** Inputs to the State Machine */
   igstkDeclareInputMacro( NullSpatialObject );
   igstkDeclareInputMacro( ValidSpatialObject );
@@ -0,0 +1,218 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOffScreenWidget.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// Disabling warning C4355: 'this' : used in base member initializer list
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4355 )
+#endif
+
+#include "igstkOffScreenWidget.h"
+
+#include "vtkRenderer.h"
+#include "vtkRenderWindowInteractor.h"
+#include "vtkRenderWindow.h"
+
+namespace igstk
+{
+
+/** Constructor */
+OffScreenWidget::OffScreenWidget() : 
+m_StateMachine(this), m_ProxyView(this)
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::Constructor() called ...\n");
+
+  this->m_Renderer = NULL;
+  this->m_RenderWindowInteractor = NULL;
+
+  this->m_Width  = 512;
+  this->m_Height = 512;
+  this->m_WidthToBeSet  = 512;
+  this->m_HeightToBeSet = 512;
+
+  igstkAddInputMacro( ValidView );
+  igstkAddInputMacro( InValidView );
+  igstkAddInputMacro( ValidSize );
+  igstkAddInputMacro( InValidSize );
+  igstkAddInputMacro( Render );
+
+  igstkAddStateMacro( Idle );
+  igstkAddStateMacro( ViewConnected );
+
+  igstkAddTransitionMacro( Idle, ValidView, 
+                           ViewConnected, ConnectView );
+  igstkAddTransitionMacro( Idle, InValidView, 
+                           Idle, ReportInvalidRequest );
+  igstkAddTransitionMacro( Idle, ValidSize, 
+                           Idle, SetSize );
+  igstkAddTransitionMacro( Idle, InValidSize, 
+                           Idle, ReportInvalidRequest );
+  igstkAddTransitionMacro( Idle, Render, 
+                           Idle, ReportInvalidRequest );
+
+  igstkAddTransitionMacro( ViewConnected, ValidView, 
+                           ViewConnected, ReportInvalidViewConnected );
+  igstkAddTransitionMacro( ViewConnected, InValidView, 
+                           ViewConnected, ReportInvalidRequest );
+  igstkAddTransitionMacro( ViewConnected, ValidSize, 
+                           ViewConnected, ReportInvalidRequest );
+  igstkAddTransitionMacro( ViewConnected, InValidSize, 
+                           ViewConnected, ReportInvalidRequest );
+  igstkAddTransitionMacro( ViewConnected, Render, 
+                           ViewConnected, Render );
+
+  igstkSetInitialStateMacro( Idle );
+  m_StateMachine.SetReadyToRun();
+}
+
+/** Destructor */
+OffScreenWidget::~OffScreenWidget()
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::Destructor() called ...\n");
+
+  if ( ! this->m_View.IsNull() )
+    {
+    this->m_View->RequestStop();
+    }
+}
+
+/** Set VTK renderer */
+void OffScreenWidget::SetRenderer( vtkRenderer * renderer )
+{
+  this->m_Renderer = renderer;
+
+  // This must happen before anything is rendered, otherwise VTK creates an
+  // on-screen window.
+  vtkRenderWindow * renderWindow = renderer->GetRenderWindow();
+  if( renderWindow != NULL )
+    {
+    renderWindow->SetOffScreenRendering( 1 );
+    }
+}
+
+/** Set VTK render window interactor */
+void OffScreenWidget::SetRenderWindowInteractor( 
+                                     vtkRenderWindowInteractor * interactor )
+{
+  this->m_RenderWindowInteractor = interactor;
+}
+
+/** Request set size */
+void OffScreenWidget::RequestSetSize( int width, int height )
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::RequestSetSize called ...\n");
+
+  this->m_WidthToBeSet  = width;
+  this->m_HeightToBeSet = height;
+
+  if( width > 0 && height > 0 )
+    {
+    igstkPushInputMacro( ValidSize );
+    }
+  else
+    {
+    igstkPushInputMacro( InValidSize );
+    }
+
+  m_StateMachine.ProcessInputs();
+}
+
+/** Store the size */
+void OffScreenWidget::SetSizeProcessing()
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::SetSizeProcessing called ...\n");
+
+  this->m_Width  = this->m_WidthToBeSet;
+  this->m_Height = this->m_HeightToBeSet;
+}
+
+/** Request set View */
+void OffScreenWidget::RequestSetView( const ViewType* view )
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::RequestSetView called ...\n");
+
+  if ( view == NULL )
+    {
+    igstkPushInputMacro( InValidView );
+    }
+  else
+    {
+    this->m_ViewToBeSet = const_cast< ViewType*  >( view );
+    igstkPushInputMacro( ValidView );
+    }
+
+  m_StateMachine.ProcessInputs();
+}
+
+/** Connect view  */
+void OffScreenWidget::ConnectViewProcessing( )
+{
+  igstkLogMacro( DEBUG, 
+                 "igstkOffScreenWidget::ConnectViewProcessing called ...\n");
+
+  this->m_View = this->m_ViewToBeSet;
+  this->m_ViewToBeSet = NULL;
+
+  // The View only accepts a new size before its interactor is initialized
+  this->m_ProxyView.SetRenderWindowSize( this->m_View, 
+                                         this->m_Width, this->m_Height );
+
+  this->m_ProxyView.Connect( this->m_View );
+}
+
+/** Request render */
+void OffScreenWidget::RequestRender()
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::RequestRender called ...\n");
+
+  igstkPushInputMacro( Render );
+  m_StateMachine.ProcessInputs();
+}
+
+/** Render the view */
+void OffScreenWidget::RenderProcessing()
+{
+  igstkLogMacro( DEBUG, "igstkOffScreenWidget::RenderProcessing called ...\n");
+
+  this->m_ProxyView.RefreshRender( this->m_View );
+}
+
+/** Report any invalid request to the logger */
+void OffScreenWidget::ReportInvalidRequestProcessing()
+{
+  igstkLogMacro( WARNING, "ReportInvalidRequestProcessing() called ...\n");
+}
+
+/** Report that a view is already connected */
+void OffScreenWidget::ReportInvalidViewConnectedProcessing()
+{
+  igstkLogMacro( WARNING, 
+       "ReportInvalidViewConnectedProcessing() called ...\n"
+       << "A view is already connected to this widget\n" );
+}
+
+/** Print object information */
+void OffScreenWidget::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Width: "  << this->m_Width  << std::endl;
+  os << indent << "Height: " << this->m_Height << std::endl;
+  os << indent << "Renderer Pointer: " << this->m_Renderer << std::endl;
+  os << indent << "RenderWindowInteractor Pointer: " 
+               << this->m_RenderWindowInteractor << std::endl;
+}
+
+} // end namespace igstk
@@ -0,0 +1,150 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOffScreenWidget.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __igstkOffScreenWidget_h
+#define __igstkOffScreenWidget_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4018 )
+//Warning about: identifier was truncated to '255' characters in the debug
+//information (MVC6.0 Debug)
+#pragma warning( disable : 4284 )
+#endif
+
+class vtkRenderer;
+class vtkRenderWindowInteractor;
+
+// IGSTK headers
+#include "igstkObject.h"
+#include "igstkView.h"
+#include "igstkViewProxy.h"
+
+namespace igstk {
+/** \class OffScreenWidget
+ * 
+ * \brief Render an IGSTK View without a window on the screen.
+ * 
+ * This class plays the role of FLTKWidget and QTWidget for applications
+ * that do not have a display, such as benchmarks and tests running on
+ * headless machines. The render window of the View is switched to offscreen
+ * rendering, so the scene is rendered in memory by the OpenGL implementation
+ * VTK was built with (for example a software Mesa library). Screenshots can
+ * be taken as usual with View::RequestSaveScreenShot().
+ *
+ * The View can be refreshed by its pulse generator after RequestStart(), or
+ * rendered synchronously with RequestRender(), which is convenient for
+ * measuring how fast frames can be produced.
+ *
+ * The size of the offscreen buffer must be set before the View is connected.
+ *
+ * \sa FLTKWidget
+ * \sa QTWidget
+ * \sa View
+ *
+ * \ingroup View
+ */
+class OffScreenWidget : public Object
+{
+
+public:
+    
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( OffScreenWidget, Object );
+
+  typedef View                ViewType;
+
+  /** Set the size of the offscreen buffer. Default is 512x512. */
+  void RequestSetSize( int width, int height );
+
+  /** Set view */
+  void RequestSetView( const ViewType * view );
+
+  /** Update the representations and render the view once */
+  void RequestRender();
+
+  typedef ViewProxy< OffScreenWidget > ProxyType;
+
+  friend class ViewProxy< OffScreenWidget >;
+
+protected:
+
+  OffScreenWidget( void );
+  virtual ~OffScreenWidget( void );
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  OffScreenWidget(const Self&);   //purposely not implemented
+  void operator=(const Self&);   //purposely not implemented
+
+  /** Report any invalid request to the logger */
+  void ReportInvalidRequestProcessing();
+
+  /** Report Invalid view connected */
+  void ReportInvalidViewConnectedProcessing();
+
+  /** Process a valid view component that is connected to the widget */ 
+  void ConnectViewProcessing();
+
+  /** Store the size of the offscreen buffer */
+  void SetSizeProcessing();
+
+  /** Render the view */
+  void RenderProcessing();
+
+  /** Set VTK renderer. This method is used in
+   *  Connect() method in ViewProxy */
+  void SetRenderer( vtkRenderer * renderer );
+
+  /** Set VTK render window interactor. this method
+    * is used in connect() method in ViewProxy class */
+  void SetRenderWindowInteractor( vtkRenderWindowInteractor * interactor );
+
+private:
+
+  ViewType::Pointer               m_View; 
+
+  ViewType::Pointer               m_ViewToBeSet; 
+
+  ProxyType                       m_ProxyView;
+
+  vtkRenderer                   * m_Renderer; 
+
+  vtkRenderWindowInteractor     * m_RenderWindowInteractor; 
+
+  int                             m_Width;
+  int                             m_Height;
+  int                             m_WidthToBeSet;
+  int                             m_HeightToBeSet;
+
+  /** States for the State Machine */
+  igstkDeclareStateMacro( Idle );
+  igstkDeclareStateMacro( ViewConnected );
+
+  /** Inputs to the State machine */
+  igstkDeclareInputMacro( ValidView );
+  igstkDeclareInputMacro( InValidView );
+  igstkDeclareInputMacro( ValidSize );
+  igstkDeclareInputMacro( InValidSize );
+  igstkDeclareInputMacro( Render );
+
+};
+
+} // end namespace igstk
+
+#endif
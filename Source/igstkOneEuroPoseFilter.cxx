@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOneEuroPoseFilter.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkOneEuroPoseFilter.h"
+
+#include "vnl/vnl_math.h"
+
+#include <cmath>
+
+namespace igstk
+{
+
+/** Constructor */
+OneEuroPoseFilter::OneEuroPoseFilter()
+{
+  m_MinimumCutoffFrequency = 1.0;
+  m_TranslationBeta = 0.05;
+  m_RotationBeta = 2.0;
+  m_DerivativeCutoffFrequency = 1.0;
+
+  TransformBatch::SetToIdentity( m_PreviousPose );
+  m_PreviousTime = 0.0;
+  m_TranslationSpeed = 0.0;
+  m_RotationSpeed = 0.0;
+}
+
+/** Destructor */
+OneEuroPoseFilter::~OneEuroPoseFilter()
+{
+}
+
+
+double
+OneEuroPoseFilter::ComputeSmoothingFactor( double cutoffFrequency,
+                                           double period )
+{
+  const double timeConstant = 1.0 / ( 2.0 * vnl_math::pi * cutoffFrequency );
+  return 1.0 / ( 1.0 + timeConstant / period );
+}
+
+
+void
+OneEuroPoseFilter::InternalFilterPose( Pose & pose, TimePeriodType time,
+                                       bool firstPose )
+{
+  if( firstPose )
+    {
+    m_PreviousPose = pose;
+    m_PreviousTime = time;
+    m_TranslationSpeed = 0.0;
+    m_RotationSpeed = 0.0;
+    return;
+    }
+
+  // Poses reported at the same time are weighted as if 1 ms apart
+  double period = ( time - m_PreviousTime ) / 1000.0;
+  if( period <= 0.0 )
+    {
+    period = 0.001;
+    }
+
+  const double derivativeFactor =
+    ComputeSmoothingFactor( m_DerivativeCutoffFrequency, period );
+
+  // Translation
+  double squaredDistance = 0.0;
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    const double difference =
+      pose.m_Translation[k] - m_PreviousPose.m_Translation[k];
+    squaredDistance += difference * difference;
+    }
+  const double translationSpeed = std::sqrt( squaredDistance ) / period;
+  m_TranslationSpeed +=
+    derivativeFactor * ( translationSpeed - m_TranslationSpeed );
+
+  const double translationFactor = ComputeSmoothingFactor(
+    m_MinimumCutoffFrequency + m_TranslationBeta * m_TranslationSpeed,
+    period );
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    pose.m_Translation[k] = m_PreviousPose.m_Translation[k] +
+      translationFactor *
+      ( pose.m_Translation[k] - m_PreviousPose.m_Translation[k] );
+    }
+
+  // Rotation
+  const double rotationSpeed =
+    ComputeAngle( m_PreviousPose.m_Rotation, pose.m_Rotation ) / period;
+  m_RotationSpeed += derivativeFactor * ( rotationSpeed - m_RotationSpeed );
+
+  const double rotationFactor = ComputeSmoothingFactor(
+    m_MinimumCutoffFrequency + m_RotationBeta * m_RotationSpeed, period );
+  InterpolateRotations( m_PreviousPose.m_Rotation, pose.m_Rotation,
+                        rotationFactor, pose.m_Rotation );
+
+  m_PreviousPose = pose;
+  m_PreviousTime = time;
+}
+
+
+/** Print Self function */
+void
+OneEuroPoseFilter::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "MinimumCutoffFrequency: "
+     << m_MinimumCutoffFrequency << std::endl;
+  os << indent << "TranslationBeta: " << m_TranslationBeta << std::endl;
+  os << indent << "RotationBeta: " << m_RotationBeta << std::endl;
+  os << indent << "DerivativeCutoffFrequency: "
+     << m_DerivativeCutoffFrequency << std::endl;
+}
+
+} // end namespace igstk
@@ -0,0 +1,100 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOneEuroPoseFilter.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkOneEuroPoseFilter_h
+#define __igstkOneEuroPoseFilter_h
+
+#include "igstkPoseFilter.h"
+
+
+namespace igstk
+{
+
+/** \class OneEuroPoseFilter
+ * \brief Low-pass filter of the poses, with a cutoff frequency that
+ *  increases with the speed of the tool.
+ *
+ * This is the 1 Euro filter of Casiez et al., applied to the translation
+ * and, through spherical interpolation, to the rotation of the poses.
+ * When the tool is held still, the poses are filtered at
+ * MinimumCutoffFrequency, which removes the jitter. When it moves, the
+ * cutoff frequency increases by TranslationBeta for each millimeter per
+ * second, and by RotationBeta for each radian per second, which limits the
+ * lag. The speeds are themselves filtered at DerivativeCutoffFrequency.
+ *
+ * \ingroup Object
+ */
+class OneEuroPoseFilter : public PoseFilter
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( OneEuroPoseFilter, PoseFilter )
+  igstkNewMacro( Self );
+
+  /** Cutoff frequency when the tool does not move [Hz] */
+  igstkSetMacro( MinimumCutoffFrequency, double );
+  igstkGetMacro( MinimumCutoffFrequency, double );
+
+  /** Increase of the cutoff frequency with the speed of the tool
+   *  [Hz per mm/s] and [Hz per rad/s] */
+  igstkSetMacro( TranslationBeta, double );
+  igstkGetMacro( TranslationBeta, double );
+  igstkSetMacro( RotationBeta, double );
+  igstkGetMacro( RotationBeta, double );
+
+  /** Cutoff frequency of the filter of the speeds [Hz] */
+  igstkSetMacro( DerivativeCutoffFrequency, double );
+  igstkGetMacro( DerivativeCutoffFrequency, double );
+
+protected:
+
+  OneEuroPoseFilter(void);
+  virtual ~OneEuroPoseFilter(void);
+
+  virtual void InternalFilterPose( Pose & pose, TimePeriodType time,
+                                   bool firstPose );
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  OneEuroPoseFilter(const Self&);   //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  /** Weight of the new value in an exponential smoothing at the given
+   *  cutoff frequency, for samples separated by the given period [s] */
+  static double ComputeSmoothingFactor( double cutoffFrequency,
+                                        double period );
+
+  double           m_MinimumCutoffFrequency;
+  double           m_TranslationBeta;
+  double           m_RotationBeta;
+  double           m_DerivativeCutoffFrequency;
+
+  Pose             m_PreviousPose;
+  TimePeriodType   m_PreviousTime;
+  double           m_TranslationSpeed;
+  double           m_RotationSpeed;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkOneEuroPoseFilter_h
@@ -29,9 +29,12 @@
 
 #include "vtkImageData.h"
 
+#include "igtl_image.h"
+
 #include <itksys/SystemTools.hxx>
 
 #include <sstream>
+#include <algorithm>
 
 namespace igstk
 {
@@ -46,11 +49,28 @@ OpenIGTLinkVideoImager::OpenIGTLinkVideoImager(void):m_StateMachine(this)
   // with the imager to the main thread.
   m_BufferLock = itk::MutexLock::New();
 
+  // The message objects are allocated once and reused for every frame.
+  m_HeaderMsg = igtl::MessageHeader::New();
+  m_ImgMsg = igtl::ImageMessage::New();
+
+  m_CRCCheck = true;
+  m_ReceiveTimeout = 100;
+  m_HeaderBytesReceived = 0;
+  m_PendingBodyBytes = 0;
 }
 
 /** Destructor */
 OpenIGTLinkVideoImager::~OpenIGTLinkVideoImager(void)
 {
+  typedef VideoImagerToolFrameContainerType::iterator InputIterator;
+  InputIterator inputItr = this->m_ToolFrameBuffer.begin();
+  InputIterator inputEnd = this->m_ToolFrameBuffer.end();
+
+  while( inputItr != inputEnd )
+    {
+    delete inputItr->second;
+    ++inputItr;
+    }
 }
 
 OpenIGTLinkVideoImager::ResultType OpenIGTLinkVideoImager::InternalOpen( void )
@@ -150,6 +170,12 @@ OpenIGTLinkVideoImager::InternalStartImaging( void )
   }
   else
   {
+    // Receive calls return after m_ReceiveTimeout instead of blocking
+    // the imaging thread when the sender stalls.
+    m_Socket->SetTimeout( m_ReceiveTimeout );
+    m_HeaderBytesReceived = 0;
+    m_PendingBodyBytes = 0;
+
     igstk::DoubleTypeEvent evt;
     evt.Set( 1.0 );
     this->InvokeEvent( evt );
@@ -189,11 +215,9 @@ OpenIGTLinkVideoImager::InternalUpdateStatus()
   // continuously in the Imaging state.  This method is called from
   // the main thread, while InternalThreadedUpdateStatus is called
   // from the thread that actually communicates with the device.
-  // A shared memory buffer is used to transfer information between
-  // the threads, and it must be locked when either thread is
-  // accessing it.
-  m_BufferLock->Lock();
-
+  // Frames are handed over through a triple buffer, so the lock is
+  // only held while the buffer pointers are swapped. The copy into
+  // the imager tool frame is done with the lock released.
   typedef VideoImagerToolFrameContainerType::const_iterator InputConstIterator;
 
   InputConstIterator inputItr = this->m_ToolFrameBuffer.begin();
@@ -202,43 +226,61 @@ OpenIGTLinkVideoImager::InternalUpdateStatus()
   VideoImagerToolsContainerType imagerToolContainer =
     this->GetVideoImagerToolContainer();
 
-  unsigned int toolId = 0;
-
   while( inputItr != inputEnd )
     {
-    // only report tools that have useful data
-    if (! this->m_ToolStatusContainer[inputItr->first])
-    {
-      igstkLogMacro( DEBUG, "igstk::OpenIGTLinkVideoImager"
-      << "::InternalUpdateStatus: tool "
-      << inputItr->first << " is not available\n");
-      // report to the imager tool that the imager is not available
-      this->ReportImagingToolNotAvailable(
-        imagerToolContainer[inputItr->first]);
+    FrameBuffer * buffer = inputItr->second;
 
+    m_BufferLock->Lock();
+    const bool newFrameReady = buffer->m_NewFrameReady;
+    if( newFrameReady )
+      {
+      std::swap( buffer->m_Front, buffer->m_Ready );
+      buffer->m_NewFrameReady = false;
+      }
+    const int toolStatus = this->m_ToolStatusContainer[inputItr->first];
+    m_BufferLock->Unlock();
+
+    if( !newFrameReady )
+      {
+      // only report tools that have useful data
+      if( !toolStatus )
+        {
+        igstkLogMacro( DEBUG, "igstk::OpenIGTLinkVideoImager"
+        << "::InternalUpdateStatus: tool "
+        << inputItr->first << " is not available\n");
+        // report to the imager tool that the imager is not available
+        this->ReportImagingToolNotAvailable(
+          imagerToolContainer[inputItr->first]);
+        }
       ++inputItr;
       continue;
-    }
+      }
+
+    FrameType* frame = this->GetVideoImagerToolFrame(
+                                          imagerToolContainer[inputItr->first] );
+
+    memcpy( frame->GetImagePtr(), &(*buffer->m_Front)[0],
+            buffer->m_Front->size() );
+
+    //update frame validity time
+    frame->SetTimeToExpiration( this->GetValidityTime() );
 
     // report to the imager tool that the tool is Streaming
     this->ReportImagingToolStreaming(imagerToolContainer[inputItr->first]);
 
     this->SetVideoImagerToolFrame(
-      imagerToolContainer[inputItr->first], (inputItr->second) );
+      imagerToolContainer[inputItr->first], frame );
 
     this->SetVideoImagerToolUpdate(
       imagerToolContainer[inputItr->first], true );
 
     ++inputItr;
-    ++toolId;
     }
 
-  m_BufferLock->Unlock();
-
   return SUCCESS;
 }
 
-/** Update the shared memory buffer and the tool's internal frame.
+/** Update the shared memory buffer with the next frame received.
  * This function is called by the thread that communicates with the imager
  * while the imager is in the Imaging state. */
 OpenIGTLinkVideoImager::ResultType
@@ -247,118 +289,259 @@ OpenIGTLinkVideoImager::InternalThreadedUpdateStatus( void )
   igstkLogMacro( DEBUG,
     "igstk::OpenIGTLinkVideoImager::InternalThreadedUpdateStatus called ...\n");
 
-  igstkLogMacro( DEBUG, "InternalThreadedUpdateStatus entered" );
+  if( this->m_Socket.IsNull() )
+    {
+    return FAILURE;
+    }
 
-  // Lock the buffer that this method shares with InternalUpdateStatus
-  m_BufferLock->Lock();
+  // Discard the rest of a message interrupted by a timeout, so that the
+  // next bytes read are a message header.
+  if( !this->SkipPendingBytes() )
+    {
+    igstkLogMacro( DEBUG, "Timeout while discarding an incomplete message" );
+    return FAILURE;
+    }
 
-  //reset the status of all the tracker tools
-  typedef VideoImagerToolFrameContainerType::const_iterator InputConstIterator;
-  InputConstIterator inputItr = this->m_ToolFrameBuffer.begin();
-  InputConstIterator inputEnd = this->m_ToolFrameBuffer.end();
+  // Receive the generic header into the reused message, completing the
+  // header received in part by the previous update if any.
+  if( m_HeaderBytesReceived == 0 )
+    {
+    m_HeaderMsg->InitPack();
+    }
+  const int headerSize = static_cast< int >( m_HeaderMsg->GetPackSize() );
+  unsigned char * header =
+    static_cast< unsigned char * >( m_HeaderMsg->GetPackPointer() );
+  m_HeaderBytesReceived += this->ReceiveAvailable(
+    header + m_HeaderBytesReceived, headerSize - m_HeaderBytesReceived );
+  if( m_HeaderBytesReceived < headerSize )
+    {
+    // Nothing, or only part of the header, arrived within the timeout.
+    igstkLogMacro( DEBUG, "Timeout while waiting for a message header" );
+    return FAILURE;
+    }
+  m_HeaderBytesReceived = 0;
 
-  while( inputItr != inputEnd )
+  // Deserialize the header
+  m_HeaderMsg->Unpack();
+
+  // Check if an imager tool was added with this device name, and keep its
+  // buffer from being deleted while the frame is received into it.
+  FrameBuffer * buffer = NULL;
+  std::string toolIdentifier = "Camera";
+
+  m_BufferLock->Lock();
+  VideoImagerToolFrameContainerType::iterator deviceItr =
+                            this->m_ToolFrameBuffer.find( toolIdentifier );
+  if( deviceItr != this->m_ToolFrameBuffer.end() &&
+      strcmp( m_HeaderMsg->GetDeviceType(), "IMAGE" ) == 0 )
     {
-    this->m_ToolStatusContainer[inputItr->first] = 0;
-    ++inputItr;
+    buffer = deviceItr->second;
+    buffer->m_InUse = true;
     }
+  m_BufferLock->Unlock();
+
+  if( buffer == NULL )
+    {
+    m_PendingBodyBytes =
+      static_cast< int >( m_HeaderMsg->GetBodySizeToRead() );
+    this->SkipPendingBytes();
+    return SUCCESS;
+    }
+
+  ResultType result = FAILURE;
 
   try
     {
-    m_HeaderMsg = igtl::MessageHeader::New();
-    // Initialize receive buffer
-    m_HeaderMsg->InitPack();
-    // Receive generic header from the socket
-    int r = 0;
-    r = this->m_Socket->Receive(m_HeaderMsg->GetPackPointer(),
-                                                    m_HeaderMsg->GetPackSize());
-    if (r != m_HeaderMsg->GetPackSize())
+    VideoImagerToolsContainerType imagerToolContainer =
+      this->GetVideoImagerToolContainer();
+
+    unsigned int frameDims[3] = { 0, 0, 0 };
+    VideoImagerToolsContainerType::iterator toolItr =
+      imagerToolContainer.find( toolIdentifier );
+    if( toolItr != imagerToolContainer.end() )
       {
-      igstkLogMacro( CRITICAL, "Error in pack size" );
-      m_BufferLock->Unlock();
-      return FAILURE;
+      toolItr->second->GetFrameDimensions( frameDims );
       }
 
-    igstkLogMacro( DEBUG, "InternalThreadedUpdateStatus Receive passed" );
-    // Deserialize the header
-    m_HeaderMsg->Unpack();
-    // Check data type and receive data body
-    if (strcmp(m_HeaderMsg->GetDeviceType(), "IMAGE") == 0)
+    result = this->ReceiveImageBody( *buffer->m_Back,
+                                  frameDims[0] * frameDims[1] * frameDims[2] );
+    }
+  catch(...)
+    {
+    igstkLogMacro( CRITICAL, "Unknown error catched" );
+    result = FAILURE;
+    }
+
+  // Publish the frame. Only pointers are exchanged while holding the lock.
+  m_BufferLock->Lock();
+  buffer->m_InUse = false;
+  if( buffer->m_Removed )
+    {
+    // The tool was removed while the frame was being received
+    delete buffer;
+    }
+  else
+    {
+    if( result == SUCCESS )
       {
-      // Create a message buffer to receive transform data
-      igtl::ImageMessage::Pointer imgMsg;
-      imgMsg = igtl::ImageMessage::New();
+      std::swap( buffer->m_Back, buffer->m_Ready );
+      buffer->m_NewFrameReady = true;
+      }
+    this->m_ToolStatusContainer[toolIdentifier] = ( result == SUCCESS );
+    }
+  m_BufferLock->Unlock();
+
+  return result;
+}
 
-      imgMsg->SetMessageHeader(m_HeaderMsg);
-      imgMsg->AllocatePack();
+/** Receive the body of the IMAGE message whose header is in m_HeaderMsg.
+ * When the CRC check is disabled, the pixel data is received directly into
+ * the given buffer. Otherwise the body goes through m_ImgMsg so that it can
+ * be verified before being copied. A body that is not received completely
+ * leaves its remaining bytes in m_PendingBodyBytes. */
+OpenIGTLinkVideoImager::ResultType
+OpenIGTLinkVideoImager
+::ReceiveImageBody( std::vector< unsigned char > & pixels,
+                    unsigned int expectedSize )
+{
+  // AllocatePack() only reallocates when the body size changes
+  m_ImgMsg->SetMessageHeader( m_HeaderMsg );
+  m_ImgMsg->AllocatePack();
 
-      // Receive transform data from the socket
-      this->m_Socket->Receive(imgMsg->GetPackBodyPointer(),
-                                                     imgMsg->GetPackBodySize());
+  const int bodySize = static_cast< int >( m_ImgMsg->GetPackBodySize() );
 
-      // Deserialize the transform data
-      // If you want to skip CRC check, call Unpack() without argument.
-      int c = imgMsg->Unpack(1);
+  if( expectedSize == 0 )
+    {
+    igstkLogMacro( CRITICAL, "Frame dimensions of the imager tool not set" );
+    m_PendingBodyBytes = bodySize;
+    this->SkipPendingBytes();
+    return FAILURE;
+    }
 
-      if (!(c & igtl::MessageHeader::UNPACK_BODY)) // if CRC check is OK
-        {
-        igstkLogMacro( CRITICAL, "Error in CRC check while unpacking" );
-        m_BufferLock->Unlock();
-        return FAILURE;
-        }
+  if( pixels.size() != expectedSize )
+    {
+    pixels.resize( expectedSize );
+    }
 
-      // Check if an imager tool was added with this device name
-      typedef VideoImagerToolFrameContainerType::iterator InputIterator;
-      InputIterator deviceItr =
-            this->m_ToolFrameBuffer.find("Camera");
+  if( m_CRCCheck || bodySize < IGTL_IMAGE_HEADER_SIZE )
+    {
+    int r = this->ReceiveAvailable( m_ImgMsg->GetPackBodyPointer(),
+                                    bodySize );
+    if( r != bodySize )
+      {
+      igstkLogMacro( CRITICAL, "Error receiving image message body" );
+      m_PendingBodyBytes = bodySize - r;
+      return FAILURE;
+      }
 
-      if( deviceItr != this->m_ToolFrameBuffer.end() )
-        {
-        // create the frame
-        VideoImagerToolsContainerType imagerToolContainer =
-        this->GetVideoImagerToolContainer();
-
-        FrameType* frame = new FrameType();
-        frame = this->GetVideoImagerToolFrame(
-                                        imagerToolContainer[deviceItr->first] );
-
-        unsigned int frameDims[3];
-        imagerToolContainer[deviceItr->first]->GetFrameDimensions(frameDims);
-        int toolSize = frameDims[0] * frameDims[1] * frameDims[2];
-        int fsize = imgMsg->GetImageSize();
-        if (fsize != toolSize)
-          {
-          igstkLogMacro( CRITICAL,
-                           "Incoming image size does not match with expected" );
-          m_BufferLock->Unlock();
-          return FAILURE;
-          }
-
-        memcpy(frame->GetImagePtr(),
-        imgMsg->GetScalarPointer(),frameDims[0]*frameDims[1]*frameDims[2]);
-
-        //update frame validity time
-        frame->SetTimeToExpiration(this->GetValidityTime());
-
-        this->m_ToolFrameBuffer[ deviceItr->first ] = frame;
-        this->m_ToolStatusContainer[ deviceItr->first ] = 1;
-        }
-      m_BufferLock->Unlock();
-      return SUCCESS;
+    int c = m_ImgMsg->Unpack( m_CRCCheck ? 1 : 0 );
+
+    if( !( c & igtl::MessageHeader::UNPACK_BODY ) )
+      {
+      igstkLogMacro( CRITICAL, "Error in CRC check while unpacking" );
+      return FAILURE;
       }
-    else
+
+    if( m_ImgMsg->GetImageSize() != static_cast<int>( expectedSize ) )
       {
-      this->m_Communication->Skip(m_HeaderMsg->GetBodySizeToRead(), 0);
-      m_BufferLock->Unlock();
-      return SUCCESS;
+      igstkLogMacro( CRITICAL,
+                       "Incoming image size does not match with expected" );
+      return FAILURE;
       }
+
+    memcpy( &pixels[0], m_ImgMsg->GetScalarPointer(), expectedSize );
+    return SUCCESS;
     }
-  catch(...)
+
+  // Receive the image header alone, then the pixels straight into the
+  // frame buffer.
+  int r = this->ReceiveAvailable( m_ImgMsg->GetPackBodyPointer(),
+                                  IGTL_IMAGE_HEADER_SIZE );
+  if( r != IGTL_IMAGE_HEADER_SIZE )
     {
-    igstkLogMacro( CRITICAL, "Unknown error catched" );
-    m_BufferLock->Unlock();
+    igstkLogMacro( CRITICAL, "Error receiving image header" );
+    m_PendingBodyBytes = bodySize - r;
+    return FAILURE;
+    }
+
+  igtl_image_header imageHeader;
+  memcpy( &imageHeader, m_ImgMsg->GetPackBodyPointer(),
+          IGTL_IMAGE_HEADER_SIZE );
+  igtl_image_convert_byte_order( &imageHeader );
+
+  const int dataSize = bodySize - IGTL_IMAGE_HEADER_SIZE;
+
+  if( igtl_image_get_data_size( &imageHeader ) != expectedSize ||
+      dataSize != static_cast<int>( expectedSize ) )
+    {
+    igstkLogMacro( CRITICAL,
+                     "Incoming image size does not match with expected" );
+    m_PendingBodyBytes = dataSize;
+    this->SkipPendingBytes();
+    return FAILURE;
+    }
+
+  r = this->ReceiveAvailable( &pixels[0], dataSize );
+  if( r != dataSize )
+    {
+    igstkLogMacro( CRITICAL, "Error receiving image data" );
+    m_PendingBodyBytes = dataSize - r;
     return FAILURE;
     }
+
+  return SUCCESS;
+}
+
+/** Receive bytes until length bytes are received or the socket times out.
+ * The socket is read without its readFully option, which does not report
+ * the bytes it received before a timeout. */
+int OpenIGTLinkVideoImager::ReceiveAvailable( void * data, int length )
+{
+  char * pointer = static_cast< char * >( data );
+  int total = 0;
+  while( total < length )
+    {
+    const int r = this->m_Socket->Receive( pointer + total,
+                                           length - total, 0 );
+    if( r <= 0 )
+      {
+      // Timeout or connection closed
+      break;
+      }
+    total += r;
+    }
+  return total;
+}
+
+/** Discard the rest of a message that was not received completely. */
+bool OpenIGTLinkVideoImager::SkipPendingBytes()
+{
+  unsigned char block[256];
+  while( m_PendingBodyBytes > 0 )
+    {
+    const int length =
+      std::min( m_PendingBodyBytes, static_cast< int >( sizeof( block ) ) );
+    const int r = this->ReceiveAvailable( block, length );
+    m_PendingBodyBytes -= r;
+    if( r < length )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+/** Delete a frame buffer, unless the imaging thread is receiving into it */
+void OpenIGTLinkVideoImager::ReleaseFrameBuffer( FrameBuffer * buffer )
+{
+  if( buffer->m_InUse )
+    {
+    buffer->m_Removed = true;
+    }
+  else
+    {
+    delete buffer;
+    }
 }
 
 OpenIGTLinkVideoImager::ResultType
@@ -377,11 +560,24 @@ AddVideoImagerToolToInternalDataContainers(
   const std::string imagerToolIdentifier =
                     imagerTool->GetVideoImagerToolIdentifier();
 
-  // igtl::ImageMessage::Pointer imgMsg;
-  igstk::Frame* frame = new igstk::Frame();
+  FrameBuffer * buffer = new FrameBuffer;
+  buffer->m_Back  = &buffer->m_Storage[0];
+  buffer->m_Ready = &buffer->m_Storage[1];
+  buffer->m_Front = &buffer->m_Storage[2];
+  buffer->m_NewFrameReady = false;
+  buffer->m_InUse = false;
+  buffer->m_Removed = false;
 
-  this->m_ToolFrameBuffer[ imagerToolIdentifier ] = frame;
+  m_BufferLock->Lock();
+  VideoImagerToolFrameContainerType::iterator itr =
+                   this->m_ToolFrameBuffer.find( imagerToolIdentifier );
+  if( itr != this->m_ToolFrameBuffer.end() )
+    {
+    ReleaseFrameBuffer( itr->second );
+    }
+  this->m_ToolFrameBuffer[ imagerToolIdentifier ] = buffer;
   this->m_ToolStatusContainer[ imagerToolIdentifier ] = 0;
+  m_BufferLock->Unlock();
 
   return SUCCESS;
 }
@@ -399,10 +595,17 @@ RemoveVideoImagerToolFromInternalDataContainers
                       imagerTool->GetVideoImagerToolIdentifier();
 
   // remove the tool from the frame buffer container
-  //this->m_ToolTransformBuffer.erase( imagerToolIdentifier );
+  m_BufferLock->Lock();
   this->m_ToolStatusContainer.erase( imagerToolIdentifier );
 
-  this->m_ToolFrameBuffer.erase( imagerToolIdentifier );
+  VideoImagerToolFrameContainerType::iterator itr =
+                   this->m_ToolFrameBuffer.find( imagerToolIdentifier );
+  if( itr != this->m_ToolFrameBuffer.end() )
+    {
+    ReleaseFrameBuffer( itr->second );
+    this->m_ToolFrameBuffer.erase( itr );
+    }
+  m_BufferLock->Unlock();
 
   return SUCCESS;
 }
@@ -427,6 +630,8 @@ void OpenIGTLinkVideoImager
   Superclass::PrintSelf(os, indent);
 
   os << indent << " output Open IGTLink parameters " << std::endl;
+  os << indent << "CRCCheck: " << m_CRCCheck << std::endl;
+  os << indent << "ReceiveTimeout: " << m_ReceiveTimeout << std::endl;
 }
 
 } // end of namespace igstk
@@ -31,6 +31,7 @@
 #include "igtlImageMessage.h"
 
 #include <map>
+#include <vector>
 
 class vtkImageData;
 
@@ -56,6 +57,19 @@ public:
     * object to the tracker object. */
   void SetCommunication( CommunicationType *communication );
 
+  /** Enable or disable the CRC check of incoming IMAGE messages. When the
+   *  check is disabled the pixel data is received directly into the frame
+   *  buffer, without going through the message buffer. Default is enabled. */
+  igstkSetMacro( CRCCheck, bool );
+  igstkGetMacro( CRCCheck, bool );
+
+  /** Time in milliseconds that the imaging thread waits for data on the
+   *  socket before giving up on the current update. This bounds the time
+   *  the main thread can be kept waiting for the next frame when the
+   *  connection stalls. Default is 100 ms. */
+  igstkSetMacro( ReceiveTimeout, unsigned int );
+  igstkGetMacro( ReceiveTimeout, unsigned int );
+
 protected:
 
   OpenIGTLinkVideoImager(void);
@@ -115,11 +129,50 @@ private:
       template matching tolerance, extrapolate frame etc */
   bool Initialize();
 
-  /** A mutex for multithreaded access to the buffer arrays */
+  /** Receive the body of an IMAGE message into the back buffer of the
+   *  given frame buffer. */
+  ResultType ReceiveImageBody( std::vector< unsigned char > & pixels,
+                               unsigned int expectedSize );
+
+  /** Receive up to length bytes, stopping at the receive timeout. Returns
+   *  the number of bytes received. */
+  int ReceiveAvailable( void * data, int length );
+
+  /** Discard the bytes left on the socket by a message that was not read
+   *  completely. Returns false if the timeout expired before all of them
+   *  were discarded. */
+  bool SkipPendingBytes();
+
+  /** A mutex for multithreaded access to the buffer arrays. It is only held
+   *  while frame buffer pointers are being swapped. */
   itk::MutexLock::Pointer  m_BufferLock;
 
-  /** A buffer to hold frames */
-  typedef std::map< std::string, igstk::Frame* >
+  /** Triple buffer used for handing frames from the imaging thread to the
+   *  main thread. The imaging thread receives into m_Back and publishes it
+   *  as m_Ready; the main thread takes m_Ready over as m_Front. The storage
+   *  is reused for every frame.
+   *
+   *  m_InUse is set while the imaging thread receives into m_Back without
+   *  holding the lock. A buffer removed in the meantime is only flagged as
+   *  m_Removed, and the imaging thread deletes it when it is done. */
+  struct FrameBuffer
+    {
+    typedef std::vector< unsigned char > PixelContainerType;
+
+    PixelContainerType    m_Storage[3];
+    PixelContainerType *  m_Back;
+    PixelContainerType *  m_Ready;
+    PixelContainerType *  m_Front;
+    bool                  m_NewFrameReady;
+    bool                  m_InUse;
+    bool                  m_Removed;
+    };
+
+  /** Delete a frame buffer taken out of m_ToolFrameBuffer, or leave it to
+   *  the imaging thread if it is in use. Called with m_BufferLock held. */
+  static void ReleaseFrameBuffer( FrameBuffer * buffer );
+
+  typedef std::map< std::string, FrameBuffer* >
                                              VideoImagerToolFrameContainerType;
 
   VideoImagerToolFrameContainerType          m_ToolFrameBuffer;
@@ -132,6 +185,16 @@ private:
   igtl::MessageHeader::Pointer   m_HeaderMsg;
   igtl::ImageMessage::Pointer    m_ImgMsg;
   igtl::Socket::Pointer          m_Socket;
+
+  bool                           m_CRCCheck;
+  unsigned int                   m_ReceiveTimeout;
+
+  /** State of a message interrupted by the receive timeout, only used by
+   *  the imaging thread. A header is completed by the next update, while
+   *  the rest of a body is discarded so that the stream stays aligned on
+   *  message boundaries. */
+  int                            m_HeaderBytesReceived;
+  int                            m_PendingBodyBytes;
 };
 
 }
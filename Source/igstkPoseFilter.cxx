@@ -0,0 +1,229 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkPoseFilter.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkPoseFilter.h"
+
+#include <cmath>
+
+namespace igstk
+{
+
+/** Constructor */
+PoseFilter::PoseFilter()
+{
+  m_MaximumTranslationJump = 0.0;
+  m_MaximumRotationJump = 0.0;
+  m_MaximumNumberOfRejectedPoses = 5;
+  m_NumberOfRejectedPoses = 0;
+  m_HasOutput = false;
+  TransformBatch::SetToIdentity( m_Output );
+  m_NumberOfConsecutiveRejections = 0;
+}
+
+/** Destructor */
+PoseFilter::~PoseFilter()
+{
+}
+
+
+bool
+PoseFilter::FilterPose( Pose & pose, TimePeriodType time )
+{
+  bool firstPose = !m_HasOutput;
+
+  if( m_HasOutput )
+    {
+    bool jump = false;
+    if( m_MaximumTranslationJump > 0.0 )
+      {
+      double squaredDistance = 0.0;
+      for( unsigned int k = 0; k < 3; k++ )
+        {
+        const double difference =
+          pose.m_Translation[k] - m_Output.m_Translation[k];
+        squaredDistance += difference * difference;
+        }
+      jump = ( squaredDistance >
+               m_MaximumTranslationJump * m_MaximumTranslationJump );
+      }
+    if( !jump && m_MaximumRotationJump > 0.0 )
+      {
+      jump = ( ComputeAngle( m_Output.m_Rotation, pose.m_Rotation ) >
+               m_MaximumRotationJump );
+      }
+
+    if( jump )
+      {
+      m_NumberOfConsecutiveRejections++;
+      if( m_NumberOfConsecutiveRejections <= m_MaximumNumberOfRejectedPoses )
+        {
+        m_NumberOfRejectedPoses++;
+        pose = m_Output;
+        return false;
+        }
+      // The tool stays away from the previous output: it actually moved
+      firstPose = true;
+      }
+    }
+
+  m_NumberOfConsecutiveRejections = 0;
+  this->InternalFilterPose( pose, time, firstPose );
+  m_Output = pose;
+  m_HasOutput = true;
+  return true;
+}
+
+
+void
+PoseFilter::Reset()
+{
+  m_HasOutput = false;
+  m_NumberOfConsecutiveRejections = 0;
+}
+
+
+double
+PoseFilter::ComputeAngle( const double first[4], const double second[4] )
+{
+  double inverse[4];
+  InvertRotation( first, inverse );
+  double difference[4];
+  MultiplyRotations( inverse, second, difference );
+
+  const double sine = std::sqrt( difference[0] * difference[0] +
+                                 difference[1] * difference[1] +
+                                 difference[2] * difference[2] );
+  return 2.0 * std::atan2( sine, std::fabs( difference[3] ) );
+}
+
+
+void
+PoseFilter::MultiplyRotations( const double first[4],
+                               const double second[4],
+                               double result[4] )
+{
+  // As itk::Versor::operator*()
+  const double x = first[3] * second[0] + first[0] * second[3] +
+                   first[1] * second[2] - first[2] * second[1];
+  const double y = first[3] * second[1] + first[1] * second[3] +
+                   first[2] * second[0] - first[0] * second[2];
+  const double z = first[3] * second[2] + first[2] * second[3] +
+                   first[0] * second[1] - first[1] * second[0];
+  const double w = first[3] * second[3] - first[0] * second[0] -
+                   first[1] * second[1] - first[2] * second[2];
+  result[0] = x;
+  result[1] = y;
+  result[2] = z;
+  result[3] = w;
+}
+
+
+void
+PoseFilter::InvertRotation( const double rotation[4], double result[4] )
+{
+  result[0] = -rotation[0];
+  result[1] = -rotation[1];
+  result[2] = -rotation[2];
+  result[3] = rotation[3];
+}
+
+
+void
+PoseFilter::RotationToVector( const double rotation[4], double vector[3] )
+{
+  // The versor and its opposite are the same rotation, the one with a
+  // positive W has the smallest angle
+  const double sign = ( rotation[3] < 0.0 ) ? -1.0 : 1.0;
+  const double sine = std::sqrt( rotation[0] * rotation[0] +
+                                 rotation[1] * rotation[1] +
+                                 rotation[2] * rotation[2] );
+  const double angle = 2.0 * std::atan2( sine, sign * rotation[3] );
+
+  const double scale = ( sine > 1e-12 ) ? sign * angle / sine : sign * 2.0;
+  vector[0] = rotation[0] * scale;
+  vector[1] = rotation[1] * scale;
+  vector[2] = rotation[2] * scale;
+}
+
+
+void
+PoseFilter::VectorToRotation( const double vector[3], double rotation[4] )
+{
+  const double angle = std::sqrt( vector[0] * vector[0] +
+                                  vector[1] * vector[1] +
+                                  vector[2] * vector[2] );
+  if( angle < 1e-12 )
+    {
+    rotation[0] = 0.5 * vector[0];
+    rotation[1] = 0.5 * vector[1];
+    rotation[2] = 0.5 * vector[2];
+    rotation[3] = 1.0;
+    return;
+    }
+
+  const double scale = std::sin( 0.5 * angle ) / angle;
+  rotation[0] = vector[0] * scale;
+  rotation[1] = vector[1] * scale;
+  rotation[2] = vector[2] * scale;
+  rotation[3] = std::cos( 0.5 * angle );
+}
+
+
+void
+PoseFilter::InterpolateRotations( const double first[4],
+                                  const double second[4],
+                                  double weight, double result[4] )
+{
+  double inverse[4];
+  InvertRotation( first, inverse );
+  double difference[4];
+  MultiplyRotations( inverse, second, difference );
+
+  double vector[3];
+  RotationToVector( difference, vector );
+  vector[0] *= weight;
+  vector[1] *= weight;
+  vector[2] *= weight;
+
+  double step[4];
+  VectorToRotation( vector, step );
+  MultiplyRotations( first, step, result );
+}
+
+
+/** Print Self function */
+void
+PoseFilter::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumTranslationJump: "
+     << m_MaximumTranslationJump << std::endl;
+  os << indent << "MaximumRotationJump: "
+     << m_MaximumRotationJump << std::endl;
+  os << indent << "MaximumNumberOfRejectedPoses: "
+     << m_MaximumNumberOfRejectedPoses << std::endl;
+  os << indent << "NumberOfRejectedPoses: "
+     << m_NumberOfRejectedPoses << std::endl;
+}
+
+} // end namespace igstk
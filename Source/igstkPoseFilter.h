@@ -0,0 +1,143 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkPoseFilter.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkPoseFilter_h
+#define __igstkPoseFilter_h
+
+#include "igstkMacros.h"
+#include "igstkTransformBatch.h"
+
+#include "itkObject.h"
+
+
+namespace igstk
+{
+
+/** \class PoseFilter
+ * \brief Base class of the filters of the poses measured for a tracker tool.
+ *
+ * A pose filter is set on a TrackerTool with SetPoseFilter(). The Tracker
+ * then passes the raw transform of the tool through the filter at each of
+ * its updates, before it is composed with the calibration transform, from
+ * the thread of the event loop of the tracker. The poses are thus filtered
+ * at the rate of the updates, with their time. A sample of the device
+ * repeated by several updates is filtered once. The subclasses smooth the
+ * poses and keep their state in members of fixed size.
+ *
+ * Before smoothing, the filter rejects the poses that moved by more than
+ * MaximumTranslationJump or MaximumRotationJump from the previous output.
+ * A rejected pose is replaced by the previous output, and the Tracker does
+ * not update the tool with it. After
+ * MaximumNumberOfRejectedPoses consecutive rejections, the tool is
+ * considered to have actually moved and the filter starts again from the
+ * new pose. The limits are disabled when they are zero, the default.
+ *
+ * \sa OneEuroPoseFilter KalmanPoseFilter MedianPoseFilter
+ *
+ * \ingroup Object
+ */
+class PoseFilter : public ::itk::Object
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassBasicTraitsMacro( PoseFilter, ::itk::Object )
+
+  typedef TimeStamp::TimePeriodType     TimePeriodType;
+
+  /** Filter a pose measured at the given time, in milliseconds. Returns
+   *  false if the pose was rejected, and then replaced by the previous
+   *  output. */
+  bool FilterPose( Pose & pose, TimePeriodType time );
+
+  /** Forget the previous poses. The next pose is output as it is. */
+  void Reset();
+
+  /** Largest distance between a pose and the previous output, in
+   *  millimeters, or zero to accept any distance */
+  igstkSetMacro( MaximumTranslationJump, double );
+  igstkGetMacro( MaximumTranslationJump, double );
+
+  /** Largest rotation between a pose and the previous output, in
+   *  radians, or zero to accept any rotation */
+  igstkSetMacro( MaximumRotationJump, double );
+  igstkGetMacro( MaximumRotationJump, double );
+
+  /** Number of consecutive poses rejected before the filter restarts from
+   *  the new pose */
+  igstkSetMacro( MaximumNumberOfRejectedPoses, unsigned int );
+  igstkGetMacro( MaximumNumberOfRejectedPoses, unsigned int );
+
+  /** Number of poses rejected since the creation of the filter */
+  igstkGetMacro( NumberOfRejectedPoses, unsigned long );
+
+protected:
+
+  PoseFilter(void);
+  virtual ~PoseFilter(void);
+
+  /** Smooth an accepted pose. The first pose after a reset is passed with
+   *  firstPose set, and must be output as it is. */
+  virtual void InternalFilterPose( Pose & pose, TimePeriodType time,
+                                   bool firstPose ) = 0;
+
+  /** Angle, in radians, of the rotation between two versors */
+  static double ComputeAngle( const double first[4],
+                              const double second[4] );
+
+  /** Product of two versors: first * second */
+  static void MultiplyRotations( const double first[4],
+                                 const double second[4],
+                                 double result[4] );
+
+  /** Conjugate of a versor, which is its inverse */
+  static void InvertRotation( const double rotation[4], double result[4] );
+
+  /** Rotation vector, of the length of the angle, of a versor, and versor
+   *  of a rotation vector */
+  static void RotationToVector( const double rotation[4], double vector[3] );
+  static void VectorToRotation( const double vector[3], double rotation[4] );
+
+  /** Spherical interpolation between two versors, through the shortest
+   *  path. A weight of zero gives the first versor. */
+  static void InterpolateRotations( const double first[4],
+                                    const double second[4],
+                                    double weight, double result[4] );
+
+  /** Print the object information in a stream. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  PoseFilter(const Self&);          //purposely not implemented
+  void operator=(const Self&);      //purposely not implemented
+
+  double           m_MaximumTranslationJump;
+  double           m_MaximumRotationJump;
+  unsigned int     m_MaximumNumberOfRejectedPoses;
+  unsigned long    m_NumberOfRejectedPoses;
+
+  bool             m_HasOutput;
+  Pose             m_Output;
+  unsigned int     m_NumberOfConsecutiveRejections;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkPoseFilter_h
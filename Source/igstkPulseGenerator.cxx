@@ -41,28 +41,14 @@ namespace igstk
 //
 double PulseGenerator::m_MaximumFrequency = 10000.0; // 10 KHz
 
-PulseGenerator::Timeout * PulseGenerator::m_FirstTimeout = 0;
-
-PulseGenerator::Timeout * PulseGenerator::m_FreeTimeout  = 0;
-
-unsigned int PulseGenerator::m_FreeTimeoutCount = 0;
-
-unsigned int PulseGenerator::m_NumberOfPulseGenerators = 0;
-
-char PulseGenerator::m_ResetClock = 1;
-
-double PulseGenerator::m_MissedTimeoutBy = 0.0;
-
-double PulseGenerator::m_PreviousClock = 0.0;
-
 
 /** Constructor */
 PulseGenerator::PulseGenerator():m_StateMachine(this)
 {
-
-  this->m_NumberOfPulseGeneratorsLock.Lock();
-  this->m_NumberOfPulseGenerators++;
-  this->m_NumberOfPulseGeneratorsLock.Unlock();
+  this->m_PulseLateness = 0.0;
+  this->m_NextPulseTime = 0.0;
+  this->m_TimerActive = false;
+  this->m_EventLoop = EventLoop::GetMainLoop();
 
   igstkAddInputMacro( ValidFrequency );
   igstkAddInputMacro( InvalidLowFrequency );
@@ -71,6 +57,8 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
   igstkAddInputMacro( Start );
   igstkAddInputMacro( Pulse );
   igstkAddInputMacro( EventReturn );
+  igstkAddInputMacro( ValidEventLoop );
+  igstkAddInputMacro( InvalidEventLoop );
 
   igstkAddStateMacro( Initial  );
   igstkAddStateMacro( Stopped  );
@@ -92,6 +80,10 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
                            Initial, ReportErrorCondition );
   igstkAddTransitionMacro( Initial, EventReturn,
                            Initial, ReportErrorCondition );
+  igstkAddTransitionMacro( Initial, ValidEventLoop,
+                           Initial, SetEventLoop );
+  igstkAddTransitionMacro( Initial, InvalidEventLoop,
+                           Initial, ReportErrorCondition );
   
   igstkAddTransitionMacro( Stopped, ValidFrequency, 
                            Stopped,  SetFrequency );
@@ -107,6 +99,10 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
                            Stopped, ReportErrorCondition );
   igstkAddTransitionMacro( Stopped, EventReturn, 
                            Stopped, ReportErrorCondition );
+  igstkAddTransitionMacro( Stopped, ValidEventLoop,
+                           Stopped, SetEventLoop );
+  igstkAddTransitionMacro( Stopped, InvalidEventLoop,
+                           Stopped, ReportErrorCondition );
  
   igstkAddTransitionMacro( Pulsing, ValidFrequency, 
                            Pulsing,  SetFrequency );
@@ -122,6 +118,10 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
                            WaitingEventReturn, EmitPulse );
   igstkAddTransitionMacro( Pulsing, EventReturn, 
                            Stopped, ReportErrorCondition );
+  igstkAddTransitionMacro( Pulsing, ValidEventLoop,
+                           Pulsing, MoveTimerToEventLoop );
+  igstkAddTransitionMacro( Pulsing, InvalidEventLoop,
+                           Pulsing, ReportErrorCondition );
 
   igstkAddTransitionMacro( WaitingEventReturn, ValidFrequency,
                            WaitingEventReturn,  SetFrequency );
@@ -137,6 +137,11 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
                            WaitingEventReturn, ReportMissedPulse );
   igstkAddTransitionMacro( WaitingEventReturn, EventReturn, 
                            Pulsing, No );
+  // The next pulse is scheduled in the new loop once the observers return
+  igstkAddTransitionMacro( WaitingEventReturn, ValidEventLoop,
+                           WaitingEventReturn, SetEventLoop );
+  igstkAddTransitionMacro( WaitingEventReturn, InvalidEventLoop,
+                           WaitingEventReturn, ReportErrorCondition );
  
   igstkSetInitialStateMacro( Initial );
 
@@ -146,25 +151,10 @@ PulseGenerator::PulseGenerator():m_StateMachine(this)
 
 PulseGenerator::~PulseGenerator()
 {
-  this->m_NumberOfPulseGeneratorsLock.Lock();
-  this->m_NumberOfPulseGenerators--;
-
-  if( m_NumberOfPulseGenerators == 0 )
-    {
-    // Release any pending Timeouts.
-    Timeout * t = m_FreeTimeout;
-
-    while( t ) 
-      {
-      m_FreeTimeout  = t->next;
-      --m_FreeTimeoutCount;
-      Timeout * tt = t;
-      t = t->next;
-      delete tt;
-      }
-    }
-  
-  this->m_NumberOfPulseGeneratorsLock.Unlock();
+  // Release the pending pulse, if any. This waits for the pulse being
+  // emitted by the thread of the loop.
+  this->m_EventLoop->RemoveTimeout( 
+    ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
 }
 
 
@@ -173,24 +163,49 @@ PulseGenerator::RequestSetFrequency( double frequency )
 {
   igstkLogMacro( DEBUG, "RequestSetFrequency() called ...\n");
 
+  EventLoop::Pointer eventLoop = this->m_EventLoop;
+  eventLoop->Lock();
+
   m_FrequencyToBeSet = frequency;
   if( frequency <= 0.0 )
     {
     igstkPushInputMacro( InvalidLowFrequency );
-    m_StateMachine.ProcessInputs();
-    return;
     }
- 
-  if( frequency >= m_MaximumFrequency )
+  else if( frequency >= m_MaximumFrequency )
     {
     igstkPushInputMacro( InvalidHighFrequency );
-    m_StateMachine.ProcessInputs();
-    return;
     }
+  else
+    {
+    igstkPushInputMacro( ValidFrequency );
+    }
+  m_StateMachine.ProcessInputs();
 
-  igstkPushInputMacro( ValidFrequency );
+  eventLoop->Unlock();
+}
+
+
+void
+PulseGenerator::RequestSetEventLoop( EventLoop * eventLoop )
+{
+  igstkLogMacro( DEBUG, "RequestSetEventLoop() called ...\n");
+
+  // Lock the current loop, the new one is locked when the pulse is moved
+  EventLoop::Pointer currentEventLoop = this->m_EventLoop;
+  currentEventLoop->Lock();
+
+  m_EventLoopToBeSet = eventLoop;
+  if( !eventLoop )
+    {
+    igstkPushInputMacro( InvalidEventLoop );
+    }
+  else
+    {
+    igstkPushInputMacro( ValidEventLoop );
+    }
   m_StateMachine.ProcessInputs();
 
+  currentEventLoop->Unlock();
 }
 
 
@@ -198,8 +213,11 @@ void
 PulseGenerator::RequestStart()
 {
   igstkLogMacro( DEBUG, "RequestStart() called ...\n");
+  EventLoop::Pointer eventLoop = this->m_EventLoop;
+  eventLoop->Lock();
   igstkPushInputMacro( Start );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
  
 
@@ -207,8 +225,11 @@ void
 PulseGenerator::RequestStop()
 {
   igstkLogMacro( DEBUG, "RequestStop() called ...\n");
+  EventLoop::Pointer eventLoop = this->m_EventLoop;
+  eventLoop->Lock();
   igstkPushInputMacro( Stop );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
  
 
@@ -228,11 +249,34 @@ PulseGenerator::SetFrequencyProcessing()
 }
 
 
+void
+PulseGenerator::SetEventLoopProcessing()
+{
+  igstkLogMacro( DEBUG, "SetEventLoopProcessing() called ...\n");
+  this->m_EventLoop = this->m_EventLoopToBeSet;
+  this->m_EventLoopToBeSet = NULL;
+}
+
+
+void
+PulseGenerator::MoveTimerToEventLoopProcessing()
+{
+  igstkLogMacro( DEBUG, "MoveTimerToEventLoopProcessing() called ...\n");
+  this->m_EventLoop->RemoveTimeout( 
+    ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
+  this->m_EventLoopToBeSet->AddTimeout( this->m_NextPulseTime, 
+    ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
+  this->SetEventLoopProcessing();
+}
+
+
 void
 PulseGenerator::SetTimerProcessing()
 {
   igstkLogMacro( DEBUG, "SetTimerProcessing() called ...\n");
-  this->AddTimeout( m_Period, 
+  this->m_NextPulseTime = RealTimeClock::GetTimeStamp() + m_Period;
+  this->m_TimerActive = true;
+  this->m_EventLoop->AddTimeout( this->m_NextPulseTime, 
      ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
 }
 
@@ -241,7 +285,8 @@ void
 PulseGenerator::StopPulsesProcessing()
 {
   igstkLogMacro( DEBUG, "StopPulsesProcessing() called ...\n");
-  this->RemoveTimeout( 
+  this->m_TimerActive = false;
+  this->m_EventLoop->RemoveTimeout( 
     ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
 }
 
@@ -265,6 +310,9 @@ PulseGenerator::CallbackTimer()
   
   igstkLogMacro( DEBUG, "CallbackTimer() called ...\n");
 
+  const double pulseTime = RealTimeClock::GetTimeStamp();
+  this->m_PulseLateness = pulseTime - this->m_NextPulseTime;
+
   // Process this pulse
   igstkPushInputMacro( Pulse );
   m_StateMachine.ProcessInputs();
@@ -276,11 +324,22 @@ PulseGenerator::CallbackTimer()
   igstkPushInputMacro( EventReturn );
   m_StateMachine.ProcessInputs();
 
-  // Set the timer for the next pulse. It is rescheduled at the end of 
-  // the CallbackTimer()just in case the previous two ProcessInputs() 
-  // calls takes a significant amount of time and risk to make the 
-  // PulseGenerator to miss a timer pulse.
-  RepeatTimeout( m_Period, 
+  // The observers may have stopped the pulses
+  if( !this->m_TimerActive )
+    {
+    return;
+    }
+
+  // Set the timer for the next pulse one period after the scheduled time of
+  // this one, so that the lateness of a pulse does not delay the following
+  // ones. After a stall of more than a period the missed pulses are not
+  // caught up, the next one is a full period after this one.
+  this->m_NextPulseTime += m_Period;
+  if( this->m_NextPulseTime < pulseTime )
+    {
+    this->m_NextPulseTime = pulseTime + m_Period;
+    }
+  this->m_EventLoop->AddTimeout( this->m_NextPulseTime, 
             ::igstk::PulseGenerator::CallbackTimerGlobal, (void *)this );
 }
 
@@ -321,131 +380,32 @@ PulseGenerator
   #endif
 }
 
-void 
-PulseGenerator
-::AddTimeout(double time, TimeoutHandler cb, void* data)
-{
-  ElapseTimeouts();
-  RepeatTimeout(time, cb, data);
-}
-
 void PulseGenerator
-::RepeatTimeout(double time, TimeoutHandler cb, void *argp) 
+::CheckTimeouts() 
 {
-
-  time += m_MissedTimeoutBy; 
-  
-  if (time < -0.05)
-    {
-    time = 0;
-    }
-
-  Timeout * t = m_FreeTimeout;
-
-  if( t ) 
-    {
-    m_FreeTimeout  = t->next;
-    --m_FreeTimeoutCount;
-    }
-  else 
-    {
-    t = new Timeout;
-    }
-  
-  t->time = time;
-  t->cb = cb;
-  t->arg = argp;
-  
-  // insert-sort the new timeout:
-  Timeout ** p = &m_FirstTimeout; 
-
-  while( *p && (*p)->time <= time ) 
-    {
-    p = &((*p)->next);
-    }
-
-  t->next = *p;
-  *p = t;
+  EventLoop::GetMainLoop()->ProcessEvents();
 }
 
-void PulseGenerator
-::RemoveTimeout( TimeoutHandler cb, void *argp) 
-{
-  // This version removes all matching timeouts, not just the first one.
-  for( Timeout ** p = & m_FirstTimeout; *p; ) 
-    {
-    Timeout * t = *p;
-    if(t->cb == cb && (t->arg == argp || !argp))
-      {
-      *p = t->next;
-      t->next = m_FreeTimeout;
-      m_FreeTimeout  = t;
-      } 
-    else 
-      {
-      p = &(t->next);
-      }
-    }
-}
 
-void PulseGenerator
-::CheckTimeouts() 
+double PulseGenerator
+::GetTimeToNextPulse() 
 {
-  ElapseTimeouts();
-  InvokeTimeoutActions();
+  return EventLoop::GetMainLoop()->GetTimeToNextEvent();
 }
 
 
 void PulseGenerator
-::ElapseTimeouts() 
+::WaitForPulses( double maximumMilliseconds ) 
 {
-  const double newclock = RealTimeClock::GetTimeStamp();
-  const double elapsed = newclock - m_PreviousClock;
-  m_PreviousClock = newclock;
-  
-  if( m_ResetClock ) 
-    {
-    m_ResetClock = 0;
-    } 
-  else 
-    {
-    if( elapsed > 0.0 ) 
-      {
-      for( Timeout * t = m_FirstTimeout; t; t = t->next ) 
-        {
-        t->time -= elapsed;
-        }
-      }
-    }
+  EventLoop::GetMainLoop()->WaitForEvents( maximumMilliseconds );
+  EventLoop::GetMainLoop()->ProcessEvents();
 }
 
 
-void PulseGenerator
-::InvokeTimeoutActions() 
+int PulseGenerator
+::GetTimerFileDescriptor() 
 {
-  // flag for preventing this method from being 
-  // invoked from any of the timeout callbacks.
-  static bool isReentrant = false;
-
-  if( isReentrant )
-    {
-    return;
-    }
-
-  isReentrant = true;
-
-  Timeout * t = m_FirstTimeout;
-
-  while( t && t->time < 0.0 ) 
-    {
-    m_FirstTimeout = t->next;
-    (t->cb)(t->arg);
-    Timeout * tt = t;
-    t = t->next;
-    delete tt;
-    }
-
-  isReentrant = false;
+  return EventLoop::GetMainLoop()->GetFileDescriptor();
 }
 
 /** Print Self function */
@@ -454,6 +414,9 @@ void PulseGenerator::PrintSelf( std::ostream& os, itk::Indent indent ) const
   Superclass::PrintSelf(os, indent);
   os << indent << "Frequency: " << m_Frequency << std::endl;
   os << indent << "Period: " << m_Period << std::endl;
+  os << indent << "PulseLateness: " << m_PulseLateness << std::endl;
+  os << indent << "NextPulseTime: " << m_NextPulseTime << std::endl;
+  os << indent << "EventLoop: " << m_EventLoop.GetPointer() << std::endl;
 }
 
 }
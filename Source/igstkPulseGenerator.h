@@ -22,6 +22,7 @@
 #include "igstkObject.h"
 #include "igstkMacros.h"
 #include "igstkStateMachine.h"
+#include "igstkEventLoop.h"
 
 
 namespace igstk
@@ -38,6 +39,12 @@ namespace igstk
  *  functions of the platform. In most cases you should not expect precision
  *  below the millisecond range. 
  *
+ *  The pulses are scheduled in an EventLoop, by default the main loop that
+ *  is driven by CheckTimeouts(). A pulse generator bound to another loop
+ *  with RequestSetEventLoop() emits its pulses from the thread of that
+ *  loop. The requests can be made from any thread: they are processed while
+ *  the loop is locked, so they never run concurrently with a pulse.
+ *
  *
  *  \image html  igstkPulseGenerator.png  
  *                                      "PulseGenerator State Machine Diagram"
@@ -70,13 +77,43 @@ public:
    * not be honored depending on the current state of the StateMachine. */
   void RequestStop();
 
+  /** Request to schedule the pulses in the given event loop, instead of
+   * the main loop. The pulses being generated are moved to the new loop. */
+  void RequestSetEventLoop( EventLoop * eventLoop );
+
+  /** Return the event loop in which the pulses are scheduled */
+  EventLoop * GetEventLoop() const
+    {
+    return m_EventLoop;
+    }
+
   /** Return the value set for the frequency of this pulse generator */
   igstkGetMacro( Frequency, double );
+
+  /** Delay in milliseconds between the scheduled time of the current (or
+   * last) pulse and the time at which it was actually emitted. */
+  igstkGetMacro( PulseLateness, double );
       
   /** Method to be called from the main event loop in order to keep the timers
-   * counting */
+   * counting. It emits the pulses of the generators bound to the main loop. */
   static void CheckTimeouts();
 
+  /** Milliseconds until the next pulse of the main loop is due, zero if a
+   * pulse is due, and a negative value if no pulse generator of the main
+   * loop is running. Event loops can wait for this time instead of polling
+   * CheckTimeouts() at a high rate. */
+  static double GetTimeToNextPulse();
+
+  /** Block until the next pulse is due, or at most the given number of
+   * milliseconds, then emit the pulses that are due. This can replace the
+   * calls to Sleep() and CheckTimeouts() of a main loop without GUI. */
+  static void WaitForPulses( double maximumMilliseconds );
+
+  /** File descriptor that becomes readable when pulses are due, to be
+   * watched by the main loop of the application, after which it must call
+   * CheckTimeouts(). Returns -1 on the platforms without timerfd. */
+  static int GetTimerFileDescriptor();
+
   /** Sleep for a number of milliseconds */
   static void Sleep( unsigned int milliseconds );
 
@@ -99,6 +136,7 @@ private:
   double          m_Frequency;
   double          m_FrequencyToBeSet;
   double          m_Period; // helper varable = 1 / frequency
+  double          m_PulseLateness;
 
   /** Inputs to the State Machine */
   igstkDeclareInputMacro( ValidFrequency );
@@ -108,6 +146,8 @@ private:
   igstkDeclareInputMacro( Start );
   igstkDeclareInputMacro( Pulse );
   igstkDeclareInputMacro( EventReturn );
+  igstkDeclareInputMacro( ValidEventLoop );
+  igstkDeclareInputMacro( InvalidEventLoop );
 
   /** States for the State Machine */
   igstkDeclareStateMacro( Initial );
@@ -117,6 +157,11 @@ private:
 
   /** Methods to be called only by the State Machine */
   void SetFrequencyProcessing();
+
+  /** Use the new event loop. MoveTimerToEventLoopProcessing() also moves
+   * the scheduled pulse from the previous loop. */
+  void SetEventLoopProcessing();
+  void MoveTimerToEventLoopProcessing();
   
   /** Report an error condition. For example unexpected inputs */
   void ReportErrorConditionProcessing();
@@ -136,8 +181,8 @@ private:
   /** Callback function for the timer */
   void CallbackTimer();
 
-  /** Program the timer for triggering a callback. At m_Period seconds from
-   * now. */
+  /** Program the timer for triggering a callback. At m_Period milliseconds
+   * from now. */
   void SetTimerProcessing();
 
   /** Send a pulse. This method will notify observers. */
@@ -152,44 +197,16 @@ private:
 
 private:
 
-  /** Types and methods needed for supporting timers */
-
-  struct Timeout 
-    {
-    double time;
-    void (*cb)(void*);
-    void* arg;
-    Timeout* next;
-    };
-
-  typedef void (*TimeoutHandler)(void*);
+  /** Event loop in which the pulses are scheduled */
+  EventLoop::Pointer  m_EventLoop;
+  EventLoop::Pointer  m_EventLoopToBeSet;
 
-  static void AddTimeout(double time, TimeoutHandler cb, void* data);
+  /** Time of the RealTimeClock at which the next pulse is scheduled */
+  double          m_NextPulseTime;
 
-  static void RepeatTimeout(double time, TimeoutHandler cb, void *argp);
-
-  static void RemoveTimeout( TimeoutHandler cb, void *argp);
-
-  static void ElapseTimeouts();
-
-  static void InvokeTimeoutActions();
-
-
-  static double       m_PreviousClock;
-
-  static Timeout *    m_FirstTimeout;
-
-  static Timeout *    m_FreeTimeout;
-
-  static unsigned int m_FreeTimeoutCount;
-
-  static unsigned int m_NumberOfPulseGenerators;
-
-  mutable itk::SimpleFastMutexLock m_NumberOfPulseGeneratorsLock;
-
-  static char         m_ResetClock;
-  
-  static double       m_MissedTimeoutBy;
+  /** Whether the timer is programmed. The observers of a pulse may stop
+   * the pulse generator, in which case the next pulse is not scheduled. */
+  bool            m_TimerActive;
 
 };
 
@@ -0,0 +1,744 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkResliceCache.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkResliceCache.h"
+#include "igstkMeshSlicer.h"
+
+#include <vtkDataSet.h>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPlane.h>
+#include <vtkCutter.h>
+#include <vtkImageReslice.h>
+#include <vtkMath.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkCellType.h>
+
+#include <cstring>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
+#include <cmath>
+
+namespace igstk
+{
+
+namespace
+{
+
+/** Output of one dataset for one plane */
+struct ResliceCacheEntry
+{
+  double              m_Center[3];
+  double              m_Normal[3];
+  int                 m_Interpolation;
+
+  /** Cut of a mesh by the MeshSlicer, and modification time of the mesh
+   *  it was computed for */
+  vtkPolyData       * m_Contour;
+  unsigned long       m_ContourMTime;
+
+  /** Cut of a dataset with other cells */
+  vtkPlane          * m_Plane;
+  vtkCutter         * m_Cutter;
+
+  /** Slice of an image */
+  vtkImageReslice   * m_Reslice;
+  vtkMatrix4x4      * m_Axes;
+
+  /** Number of clients displaying the output. The entry is not recycled
+   *  for another plane while a client displays it. */
+  unsigned int        m_Clients;
+
+  ResliceCacheEntry()
+    {
+    m_Contour = NULL;
+    m_ContourMTime = 0;
+    m_Plane = NULL;
+    m_Cutter = NULL;
+    m_Reslice = NULL;
+    m_Axes = NULL;
+    m_Clients = 0;
+    }
+
+  ~ResliceCacheEntry()
+    {
+    if( m_Contour )
+      {
+      m_Contour->Delete();
+      }
+    if( m_Cutter )
+      {
+      m_Cutter->Delete();
+      m_Plane->Delete();
+      }
+    if( m_Reslice )
+      {
+      m_Reslice->Delete();
+      m_Axes->Delete();
+      }
+    }
+
+  bool Matches( const double center[3], const double normal[3],
+                int interpolation ) const
+    {
+    return m_Center[0] == center[0] && m_Center[1] == center[1] &&
+           m_Center[2] == center[2] && m_Normal[0] == normal[0] &&
+           m_Normal[1] == normal[1] && m_Normal[2] == normal[2] &&
+           m_Interpolation == interpolation;
+    }
+};
+
+/** Outputs of one dataset, the most recently used first */
+typedef std::list< ResliceCacheEntry * >   ResliceCacheEntryListType;
+
+/** Entry displayed by each client */
+typedef std::map< const void *, ResliceCacheEntry * >
+                                                  ResliceCacheClientMapType;
+
+struct ResliceCacheInput
+{
+  unsigned int                 m_Subscribers;
+  ResliceCacheEntryListType    m_Entries;
+  ResliceCacheClientMapType    m_ClientEntries;
+
+  /** Hierarchy of the cells of a mesh, built on the first cut, and
+   *  modification time of the mesh it was built for */
+  MeshSlicer *                 m_Slicer;
+  unsigned long                m_SlicerMTime;
+  bool                         m_SlicerSupported;
+
+  /** Delete the outputs */
+  void Release()
+    {
+    while( !m_Entries.empty() )
+      {
+      delete m_Entries.back();
+      m_Entries.pop_back();
+      }
+    m_ClientEntries.clear();
+    delete m_Slicer;
+    m_Slicer = NULL;
+    }
+
+  /** Forget the entry displayed by a client */
+  void ReleaseClient( const void * client )
+    {
+    ResliceCacheClientMapType::iterator it = m_ClientEntries.find( client );
+    if( it != m_ClientEntries.end() )
+      {
+      it->second->m_Clients--;
+      m_ClientEntries.erase( it );
+      }
+    }
+};
+
+typedef std::map< vtkDataObject *, ResliceCacheInput >
+                                                  ResliceCacheInputMapType;
+
+struct ResliceCacheRegistry
+{
+  ResliceCacheInputMapType  m_Inputs;
+  unsigned int              m_NumberOfPlanesPerInput;
+  unsigned long             m_NumberOfRequests;
+  unsigned long             m_NumberOfComputations;
+
+  ResliceCacheRegistry()
+    {
+    m_NumberOfPlanesPerInput = 8;
+    m_NumberOfRequests = 0;
+    m_NumberOfComputations = 0;
+    }
+
+  ~ResliceCacheRegistry()
+    {
+    ResliceCacheInputMapType::iterator it = m_Inputs.begin();
+    while( it != m_Inputs.end() )
+      {
+      it->second.Release();
+      ++it;
+      }
+    }
+
+  /** Delete the least recently used entries beyond the given number,
+   *  except the most recent one and those displayed by a client */
+  static void ReleaseEntries( ResliceCacheEntryListType & entries,
+                              unsigned int numberOfEntries )
+    {
+    if( entries.empty() )
+      {
+      return;
+      }
+    ResliceCacheEntryListType::iterator first = entries.begin();
+    ++first;
+    ResliceCacheEntryListType::iterator it = entries.end();
+    while( entries.size() > numberOfEntries && it != first )
+      {
+      --it;
+      if( (*it)->m_Clients == 0 )
+        {
+        delete *it;
+        it = entries.erase( it );
+        }
+      }
+    }
+};
+
+ResliceCacheRegistry & GetResliceCacheRegistry()
+{
+  static ResliceCacheRegistry registry;
+  return registry;
+}
+
+/** Find the entry of a plane, or recycle the least recently used one that
+ *  no other client displays. The entry is moved at the front of the list
+ *  and recorded as the one displayed by the client. Returns NULL if the
+ *  input has no subscriber. */
+ResliceCacheEntry * FindResliceCacheEntry( vtkDataObject * input,
+                                           const double center[3],
+                                           const double normal[3],
+                                           int interpolation,
+                                           const void * client,
+                                           bool & found )
+{
+  ResliceCacheRegistry & registry = GetResliceCacheRegistry();
+
+  registry.m_NumberOfRequests++;
+
+  ResliceCacheInputMapType::iterator inputIt = registry.m_Inputs.find( input );
+  if( inputIt == registry.m_Inputs.end() )
+    {
+    return NULL;
+    }
+
+  ResliceCacheInput & record = inputIt->second;
+  ResliceCacheEntryListType & entries = record.m_Entries;
+
+  ResliceCacheEntryListType::iterator it = entries.begin();
+  while( it != entries.end() &&
+         !(*it)->Matches( center, normal, interpolation ) )
+    {
+    ++it;
+    }
+
+  found = ( it != entries.end() );
+
+  // The output the client displayed so far is replaced by the one it
+  // requests now, and can be recycled for it
+  record.ReleaseClient( client );
+
+  const unsigned int capacity =
+    registry.m_NumberOfPlanesPerInput > 0 ?
+    registry.m_NumberOfPlanesPerInput : 1;
+
+  if( !found )
+    {
+    // The outputs displayed by other clients are never recycled. When they
+    // all are, the list grows beyond its capacity until they are released.
+    if( entries.size() >= capacity )
+      {
+      ResliceCacheEntryListType::iterator candidate = entries.end();
+      while( candidate != entries.begin() )
+        {
+        --candidate;
+        if( (*candidate)->m_Clients == 0 )
+          {
+          it = candidate;
+          break;
+          }
+        }
+      }
+    if( it == entries.end() )
+      {
+      entries.push_back( new ResliceCacheEntry );
+      it = entries.end();
+      --it;
+      }
+    }
+
+  entries.splice( entries.begin(), entries, it );
+
+  ResliceCacheEntry * entry = entries.front();
+
+  if( client )
+    {
+    entry->m_Clients++;
+    record.m_ClientEntries[ client ] = entry;
+    }
+
+  ResliceCacheRegistry::ReleaseEntries( entries, capacity );
+
+  if( !found )
+    {
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      entry->m_Center[i] = center[i];
+      entry->m_Normal[i] = normal[i];
+      }
+    entry->m_Interpolation = interpolation;
+    }
+
+  return entry;
+}
+
+/** Build the hierarchy of the cells of a mesh. Returns false if the mesh
+ *  has cells that the MeshSlicer does not handle. */
+bool BuildResliceCacheSlicer( vtkDataSet * input, MeshSlicer * slicer )
+{
+  slicer->Clear();
+
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  std::vector< double > coordinates( 3 * numberOfPoints + 3 );
+  for( vtkIdType i = 0; i < numberOfPoints; i++ )
+    {
+    input->GetPoint( i, &coordinates[ 3 * i ] );
+    }
+  slicer->SetPoints( &coordinates[0],
+                     static_cast< MeshSlicer::IdType >( numberOfPoints ) );
+
+  vtkIdList * cellPoints = vtkIdList::New();
+  bool supported = true;
+
+  const vtkIdType numberOfCells = input->GetNumberOfCells();
+  for( vtkIdType cell = 0; cell < numberOfCells && supported; cell++ )
+    {
+    const int type = input->GetCellType( cell );
+    if( type != VTK_LINE && type != VTK_TRIANGLE && type != VTK_TETRA )
+      {
+      supported = false;
+      break;
+      }
+
+    input->GetCellPoints( cell, cellPoints );
+
+    MeshSlicer::IdType ids[4];
+    const unsigned int size =
+      static_cast< unsigned int >( cellPoints->GetNumberOfIds() );
+    for( unsigned int i = 0; i < size && i < 4; i++ )
+      {
+      ids[i] = static_cast< MeshSlicer::IdType >( cellPoints->GetId( i ) );
+      }
+    supported = slicer->AddCell( ids, size );
+    }
+
+  cellPoints->Delete();
+
+  if( supported )
+    {
+    slicer->Build();
+    }
+  else
+    {
+    slicer->Clear();
+    }
+
+  return supported;
+}
+
+/** Copy the contour of the slicer to the output of an entry */
+void CopyResliceCacheContour( const MeshSlicer * slicer,
+                              ResliceCacheEntry * entry )
+{
+  if( !entry->m_Contour )
+    {
+    vtkPoints * points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    vtkCellArray * lines = vtkCellArray::New();
+    vtkCellArray * verts = vtkCellArray::New();
+    entry->m_Contour = vtkPolyData::New();
+    entry->m_Contour->SetPoints( points );
+    entry->m_Contour->SetLines( lines );
+    entry->m_Contour->SetVerts( verts );
+    points->Delete();
+    lines->Delete();
+    verts->Delete();
+    }
+
+  const MeshSlicer::IdType numberOfSegments = slicer->GetNumberOfSegments();
+  const MeshSlicer::IdType numberOfVertices = slicer->GetNumberOfVertices();
+
+  // The arrays keep their memory when the contour shrinks. The points of
+  // the vertices follow those of the segments.
+  vtkPoints * points = entry->m_Contour->GetPoints();
+  points->SetNumberOfPoints( 2 * numberOfSegments + numberOfVertices );
+  if( numberOfSegments > 0 )
+    {
+    memcpy( points->GetVoidPointer( 0 ), &slicer->GetContourPoints()[0],
+            6 * numberOfSegments * sizeof( double ) );
+    }
+  if( numberOfVertices > 0 )
+    {
+    memcpy( points->GetVoidPointer( 6 * numberOfSegments ),
+            &slicer->GetVertexPoints()[0],
+            3 * numberOfVertices * sizeof( double ) );
+    }
+  points->Modified();
+
+  // The connectivity is written in the array of the cells themselves:
+  // SetCells() ignores the array it already holds, and would keep the
+  // number of cells of the first contour
+  vtkCellArray * cells = entry->m_Contour->GetLines();
+  vtkIdTypeArray * lines = cells->GetData();
+  lines->SetNumberOfValues( 3 * numberOfSegments );
+  vtkIdType * line = lines->GetPointer( 0 );
+  for( MeshSlicer::IdType segment = 0; segment < numberOfSegments; segment++ )
+    {
+    *line++ = 2;
+    *line++ = 2 * segment;
+    *line++ = 2 * segment + 1;
+    }
+  lines->Modified();
+  cells->SetNumberOfCells( numberOfSegments );
+  cells->Modified();
+
+  cells = entry->m_Contour->GetVerts();
+  vtkIdTypeArray * verts = cells->GetData();
+  verts->SetNumberOfValues( 2 * numberOfVertices );
+  vtkIdType * vert = verts->GetPointer( 0 );
+  for( MeshSlicer::IdType vertex = 0; vertex < numberOfVertices; vertex++ )
+    {
+    *vert++ = 1;
+    *vert++ = 2 * numberOfSegments + vertex;
+    }
+  verts->Modified();
+  cells->SetNumberOfCells( numberOfVertices );
+  cells->Modified();
+
+  // The cell links of the previous contour are stale
+  entry->m_Contour->DeleteCells();
+  entry->m_Contour->Modified();
+}
+
+/** Update a filter, and count the update if it executed */
+void UpdateResliceCacheOutput( vtkAlgorithm * filter, vtkDataObject * output )
+{
+  const unsigned long updateTime = output->GetUpdateTime();
+
+  filter->Update();
+
+  if( output->GetUpdateTime() != updateTime )
+    {
+    GetResliceCacheRegistry().m_NumberOfComputations++;
+    }
+}
+
+/** Place the slice of an image in the plane, and size it to cover the
+ *  image */
+void ComputeResliceCacheSliceGeometry( vtkImageData * input,
+                                       ResliceCacheEntry * entry )
+{
+  double normal[3];
+  normal[0] = entry->m_Normal[0];
+  normal[1] = entry->m_Normal[1];
+  normal[2] = entry->m_Normal[2];
+  if( vtkMath::Normalize( normal ) == 0.0 )
+    {
+    normal[0] = 0.0;
+    normal[1] = 0.0;
+    normal[2] = 1.0;
+    }
+
+  // The first axis of the slice is the image axis closest to the plane, so
+  // that orthogonal planes sample the image on its own grid
+  unsigned int closest = 0;
+  for( unsigned int i = 1; i < 3; i++ )
+    {
+    if( fabs( normal[i] ) < fabs( normal[closest] ) )
+      {
+      closest = i;
+      }
+    }
+
+  double axis1[3];
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    axis1[i] = -normal[closest] * normal[i];
+    }
+  axis1[closest] += 1.0;
+  vtkMath::Normalize( axis1 );
+
+  double axis2[3];
+  vtkMath::Cross( normal, axis1, axis2 );
+
+  entry->m_Axes->Identity();
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    entry->m_Axes->SetElement( i, 0, axis1[i] );
+    entry->m_Axes->SetElement( i, 1, axis2[i] );
+    entry->m_Axes->SetElement( i, 2, normal[i] );
+    entry->m_Axes->SetElement( i, 3, entry->m_Center[i] );
+    }
+  entry->m_Axes->Modified();
+
+  input->UpdateInformation();
+
+  double origin[3];
+  double spacing[3];
+  int extent[6];
+  input->GetOrigin( origin );
+  input->GetSpacing( spacing );
+  input->GetWholeExtent( extent );
+
+  double sliceSpacing = fabs( spacing[0] );
+  for( unsigned int i = 1; i < 3; i++ )
+    {
+    if( fabs( spacing[i] ) < sliceSpacing )
+      {
+      sliceSpacing = fabs( spacing[i] );
+      }
+    }
+  if( sliceSpacing <= 0.0 )
+    {
+    sliceSpacing = 1.0;
+    }
+
+  // Project the corners of the image on the axes of the slice
+  double range1[2];
+  double range2[2];
+  for( unsigned int corner = 0; corner < 8; corner++ )
+    {
+    double point[3];
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      const int index = extent[ 2 * i + ( ( corner >> i ) & 1 ) ];
+      point[i] = origin[i] + spacing[i] * index - entry->m_Center[i];
+      }
+    const double projection1 = vtkMath::Dot( point, axis1 );
+    const double projection2 = vtkMath::Dot( point, axis2 );
+    if( corner == 0 )
+      {
+      range1[0] = range1[1] = projection1;
+      range2[0] = range2[1] = projection2;
+      }
+    range1[0] = std::min( range1[0], projection1 );
+    range1[1] = std::max( range1[1], projection1 );
+    range2[0] = std::min( range2[0], projection2 );
+    range2[1] = std::max( range2[1], projection2 );
+    }
+
+  double scalarRange[2];
+  input->GetScalarRange( scalarRange );
+
+  vtkImageReslice * reslice = entry->m_Reslice;
+  switch( entry->m_Interpolation )
+    {
+    case 1:
+      reslice->SetInterpolationModeToLinear();
+      break;
+    case 2:
+      reslice->SetInterpolationModeToCubic();
+      break;
+    default:
+      reslice->SetInterpolationModeToNearest();
+      break;
+    }
+  reslice->SetOutputSpacing( sliceSpacing, sliceSpacing, sliceSpacing );
+  reslice->SetOutputOrigin( 0.0, 0.0, 0.0 );
+  reslice->SetOutputExtent(
+    static_cast< int >( floor( range1[0] / sliceSpacing ) ),
+    static_cast< int >( ceil( range1[1] / sliceSpacing ) ),
+    static_cast< int >( floor( range2[0] / sliceSpacing ) ),
+    static_cast< int >( ceil( range2[1] / sliceSpacing ) ),
+    0, 0 );
+  reslice->SetBackgroundLevel( scalarRange[0] );
+}
+
+} // end anonymous namespace
+
+
+void ResliceCache::Subscribe( vtkDataObject * input )
+{
+  if( !input )
+    {
+    return;
+    }
+
+  ResliceCacheInputMapType & inputs = GetResliceCacheRegistry().m_Inputs;
+
+  ResliceCacheInputMapType::iterator it = inputs.find( input );
+  if( it == inputs.end() )
+    {
+    ResliceCacheInput newInput;
+    newInput.m_Subscribers = 0;
+    newInput.m_Slicer = NULL;
+    newInput.m_SlicerMTime = 0;
+    newInput.m_SlicerSupported = true;
+    it = inputs.insert(
+      ResliceCacheInputMapType::value_type( input, newInput ) ).first;
+    }
+
+  it->second.m_Subscribers++;
+}
+
+void ResliceCache::Unsubscribe( vtkDataObject * input, const void * client )
+{
+  ResliceCacheInputMapType & inputs = GetResliceCacheRegistry().m_Inputs;
+
+  ResliceCacheInputMapType::iterator it = inputs.find( input );
+  if( it == inputs.end() )
+    {
+    return;
+    }
+
+  it->second.ReleaseClient( client );
+
+  if( --it->second.m_Subscribers == 0 )
+    {
+    it->second.Release();
+    inputs.erase( it );
+    }
+}
+
+vtkPolyData * ResliceCache::GetCut( vtkDataSet * input,
+                                    const double center[3],
+                                    const double normal[3],
+                                    const void * client )
+{
+  // Cuts are told apart from slices by a negative interpolation
+  bool found = false;
+  ResliceCacheEntry * entry =
+    FindResliceCacheEntry( input, center, normal, -1, client, found );
+
+  if( !entry )
+    {
+    return NULL;
+    }
+
+  ResliceCacheRegistry & registry = GetResliceCacheRegistry();
+  ResliceCacheInput & record = registry.m_Inputs[ input ];
+
+  // Meshes of tetrahedra and triangles are cut through the hierarchy of
+  // their cells, which is rebuilt when they are modified
+  const unsigned long inputMTime = input->GetMTime();
+
+  if( record.m_SlicerSupported &&
+      ( !record.m_Slicer || record.m_SlicerMTime != inputMTime ) )
+    {
+    if( !record.m_Slicer )
+      {
+      record.m_Slicer = new MeshSlicer;
+      }
+    record.m_SlicerSupported =
+      BuildResliceCacheSlicer( input, record.m_Slicer );
+    record.m_SlicerMTime = inputMTime;
+    }
+
+  if( record.m_SlicerSupported )
+    {
+    if( !found || !entry->m_Contour || entry->m_ContourMTime != inputMTime )
+      {
+      record.m_Slicer->Cut( entry->m_Center, entry->m_Normal );
+      CopyResliceCacheContour( record.m_Slicer, entry );
+      entry->m_ContourMTime = inputMTime;
+      registry.m_NumberOfComputations++;
+      }
+    return entry->m_Contour;
+    }
+
+  if( !entry->m_Cutter )
+    {
+    entry->m_Plane = vtkPlane::New();
+    entry->m_Cutter = vtkCutter::New();
+    entry->m_Cutter->SetInput( input );
+    entry->m_Cutter->SetCutFunction( entry->m_Plane );
+    }
+
+  if( !found )
+    {
+    entry->m_Plane->SetOrigin( entry->m_Center );
+    entry->m_Plane->SetNormal( entry->m_Normal );
+    }
+
+  UpdateResliceCacheOutput( entry->m_Cutter, entry->m_Cutter->GetOutput() );
+
+  return entry->m_Cutter->GetOutput();
+}
+
+vtkImageData * ResliceCache::GetSlice( vtkImageData * input,
+                                       const double center[3],
+                                       const double normal[3],
+                                       int interpolation,
+                                       vtkMatrix4x4 * sliceAxes,
+                                       const void * client )
+{
+  bool found = false;
+  ResliceCacheEntry * entry = FindResliceCacheEntry( input, center, normal,
+                                                     interpolation, client,
+                                                     found );
+
+  if( !entry )
+    {
+    return NULL;
+    }
+
+  if( !entry->m_Reslice )
+    {
+    entry->m_Axes = vtkMatrix4x4::New();
+    entry->m_Reslice = vtkImageReslice::New();
+    entry->m_Reslice->SetInput( input );
+    entry->m_Reslice->SetResliceAxes( entry->m_Axes );
+    entry->m_Reslice->SetOutputDimensionality( 2 );
+    }
+
+  if( !found )
+    {
+    ComputeResliceCacheSliceGeometry( input, entry );
+    }
+
+  UpdateResliceCacheOutput( entry->m_Reslice, entry->m_Reslice->GetOutput() );
+
+  if( sliceAxes )
+    {
+    sliceAxes->DeepCopy( entry->m_Axes );
+    }
+
+  return entry->m_Reslice->GetOutput();
+}
+
+void ResliceCache::SetNumberOfPlanesPerInput( unsigned int numberOfPlanes )
+{
+  GetResliceCacheRegistry().m_NumberOfPlanesPerInput = numberOfPlanes;
+}
+
+unsigned int ResliceCache::GetNumberOfPlanesPerInput()
+{
+  return GetResliceCacheRegistry().m_NumberOfPlanesPerInput;
+}
+
+unsigned long ResliceCache::GetNumberOfRequests()
+{
+  return GetResliceCacheRegistry().m_NumberOfRequests;
+}
+
+unsigned long ResliceCache::GetNumberOfComputations()
+{
+  return GetResliceCacheRegistry().m_NumberOfComputations;
+}
+
+unsigned int ResliceCache::GetNumberOfInputs()
+{
+  return static_cast< unsigned int >(
+    GetResliceCacheRegistry().m_Inputs.size() );
+}
+
+} // end namespace igstk
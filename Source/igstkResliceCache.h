@@ -0,0 +1,118 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkResliceCache.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkResliceCache_h
+#define __igstkResliceCache_h
+
+class vtkDataObject;
+class vtkDataSet;
+class vtkImageData;
+class vtkPolyData;
+class vtkMatrix4x4;
+
+namespace igstk
+{
+
+/** \class ResliceCache
+ * \brief Shares the slices of images and the cuts of meshes among the
+ * representations that display the same data on the same plane.
+ *
+ * Every view holds its own copy of the reslice representations, and the
+ * layers of a view (an image, an overlay, a mesh) are often resliced by the
+ * same ReslicerPlaneSpatialObject. The cache computes the slice or the cut
+ * of a dataset once for each distinct plane, and hands the same output to
+ * all the representations that request it. An output is recomputed only
+ * when the plane moves or when its input is modified.
+ *
+ * The representations subscribe to a dataset before requesting slices of
+ * it, and unsubscribe when they are done with it. The outputs of a dataset
+ * are released when its last subscriber leaves. For each dataset, the
+ * outputs of the most recently requested planes are kept, so that
+ * alternating between a few planes does not recompute them.
+ *
+ * Each request names its client, usually the representation itself. The
+ * output last handed to a client is never recycled for another plane
+ * while the client displays it; it is released for recycling when the
+ * client requests another plane or unsubscribes. The number of planes
+ * kept for a dataset may thus exceed GetNumberOfPlanesPerInput() while
+ * more clients than that display different planes of it.
+ *
+ * The cache is meant to be used from the thread that renders the views.
+ *
+ * \ingroup ObjectRepresentation
+ */
+class ResliceCache
+{
+
+public:
+
+  /** Register a representation that will request slices of the dataset */
+  static void Subscribe( vtkDataObject * input );
+
+  /** Unregister a representation, and release the output it displayed.
+   *  The outputs of the dataset are released when the last subscriber
+   *  leaves. */
+  static void Unsubscribe( vtkDataObject * input, const void * client );
+
+  /** Cut a dataset by the plane defined by a point and a normal. Meshes of
+   *  tetrahedra, triangles and lines are cut through a MeshSlicer built
+   *  once per version of the mesh, which produces independent segments,
+   *  and a vertex where a line crosses the plane.
+   *  Other datasets go through a vtkCutter. The polylines are owned by the
+   *  cache, and keep the cut of this plane until the client requests
+   *  another plane or unsubscribes. Returns NULL if the dataset has no
+   *  subscriber. */
+  static vtkPolyData * GetCut( vtkDataSet * input,
+                               const double center[3],
+                               const double normal[3],
+                               const void * client );
+
+  /** Reslice an image by the plane defined by a point and a normal, with
+   *  nearest, linear or cubic interpolation (0, 1 or 2). The slice is a 2D
+   *  image in plane coordinates, and sliceAxes is filled with the matrix
+   *  that places it in the image coordinate system. The slice is owned by
+   *  the cache, and keeps this plane until the client requests another
+   *  plane or unsubscribes. Returns NULL if the image has no subscriber. */
+  static vtkImageData * GetSlice( vtkImageData * input,
+                                  const double center[3],
+                                  const double normal[3],
+                                  int interpolation,
+                                  vtkMatrix4x4 * sliceAxes,
+                                  const void * client );
+
+  /** Set/Get the number of planes kept for each dataset. The default is 8 */
+  static void SetNumberOfPlanesPerInput( unsigned int numberOfPlanes );
+  static unsigned int GetNumberOfPlanesPerInput();
+
+  /** Number of slices and cuts requested, and number actually computed */
+  static unsigned long GetNumberOfRequests();
+  static unsigned long GetNumberOfComputations();
+
+  /** Number of datasets that have subscribers */
+  static unsigned int GetNumberOfInputs();
+
+private:
+
+  ResliceCache();                     //purposely not implemented
+  ResliceCache(const ResliceCache &); //purposely not implemented
+  void operator=(const ResliceCache &);   //purposely not implemented
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkResliceCache_h
@@ -57,6 +57,10 @@ ReslicerPlaneSpatialObject
 
   m_CursorPositionSetFlag = false;
 
+  m_PlaneComputed = false;
+  m_PlaneComputationTime = 0.0;
+  m_RenderTimeToBeSetFlag = false;
+
   //List of states
   igstkAddStateMacro( Initial );
   igstkAddStateMacro( ReslicingModeSet );
@@ -767,6 +771,8 @@ ReslicerPlaneSpatialObject
 
   //turn on the flag
   m_CursorPositionSetFlag = true;
+
+  m_PlaneComputed = false;
 }
 
 void 
@@ -776,6 +782,7 @@ ReslicerPlaneSpatialObject
   igstkLogMacro( DEBUG,"igstk::ReslicerPlaneSpatialObject\
                        ::SetReslicingModeProcessing called...\n");
   m_ReslicingMode = m_ReslicingModeToBeSet;
+  m_PlaneComputed = false;
 }
 
 void 
@@ -847,6 +854,7 @@ ReslicerPlaneSpatialObject
   igstkLogMacro( DEBUG,"igstk::ReslicerPlaneSpatialObject\
                        ::SetOrientationTypeProcessing called...\n");
   m_OrientationType = m_OrientationTypeToBeSet;
+  m_PlaneComputed = false;
 }
 
 void
@@ -941,6 +949,7 @@ ReslicerPlaneSpatialObject
   m_PlaneCenter[1] = m_ToolPosition[1];
   m_PlaneCenter[2] = m_ToolPosition[2];
 
+  m_PlaneComputed = false;
 }
 
 void 
@@ -992,6 +1001,7 @@ ReslicerPlaneSpatialObject
   this->ObserveToolTransformWRTImageCoordinateSystemInput( 
                                                     this->m_ToolSpatialObject );
   m_ToolSpatialObjectSet = true;
+  m_PlaneComputed = false;
 }
 
 void 
@@ -1058,16 +1068,54 @@ ReslicerPlaneSpatialObject
   igstkLogMacro( DEBUG,"igstk::ReslicerPlaneSpatialObject\
                        ::RequestComputeReslicingPlane called...\n");
 
+  m_RenderTimeToBeSetFlag = false;
+
   igstkPushInputMacro( ComputeReslicePlane );
   m_StateMachine.ProcessInputs();
 
 }
 
+/** Request compute reslicing plane for a render */
+void
+ReslicerPlaneSpatialObject
+::RequestComputeReslicingPlane( const TimeStamp & renderTime )
+{
+  igstkLogMacro( DEBUG,"igstk::ReslicerPlaneSpatialObject\
+                       ::RequestComputeReslicingPlane called...\n");
+
+  m_RenderTimeToBeSet = renderTime;
+  m_RenderTimeToBeSetFlag = true;
+
+  igstkPushInputMacro( ComputeReslicePlane );
+  m_StateMachine.ProcessInputs();
+}
+
 /** Compute reslicing plane */
 void
 ReslicerPlaneSpatialObject
 ::ComputeReslicePlaneProcessing()
 {
+  TimeStamp::TimePeriodType computationTime;
+
+  if( m_RenderTimeToBeSetFlag )
+    {
+    computationTime = m_RenderTimeToBeSet.GetStartTime();
+
+    // Reuse the plane computed for a render of the same tick
+    const TimeStamp::TimePeriodType tolerance = 0.5 *
+      ( m_RenderTimeToBeSet.GetExpirationTime() - computationTime );
+
+    if( m_PlaneComputed &&
+        fabs( computationTime - m_PlaneComputationTime ) <= tolerance )
+      {
+      return;
+      }
+    }
+  else
+    {
+    computationTime = RealTimeClock::GetTimeStamp();
+    }
+
   //Update the tool transform if tool spatial object provided
   if ( m_ToolSpatialObject ) 
     {
@@ -1094,6 +1142,9 @@ ReslicerPlaneSpatialObject
     default:
       break;
     }  
+
+  m_PlaneComputed = true;
+  m_PlaneComputationTime = computationTime;
 } 
 
 /**Compute orthgonal reslicing plane */
@@ -1468,6 +1519,9 @@ ReslicerPlaneSpatialObject
   os << indent << "Plane center" << std::endl;
   os << indent << m_PlaneCenter[0] << " " << m_PlaneCenter[1] << " " 
                                         << m_PlaneCenter[2] << " " << std::endl;
+  os << indent << "Plane computed at" << std::endl;
+  os << indent << m_PlaneComputed << " " << m_PlaneComputationTime 
+                                                               << std::endl;
   os << indent << "Tool spatial object set?" << std::endl;
   os << indent << m_ToolSpatialObjectSet << std::endl;
   os << indent << "Tool position" << std::endl;
@@ -136,6 +136,12 @@ public:
   /** Request compute reslicing plane */
   void RequestComputeReslicingPlane(); 
 
+  /** Request compute reslicing plane for a render. The plane computed for a
+   *  render that started less than half a render period before is reused,
+   *  so that the representations of all the views refreshed in the same
+   *  tick share one computation. */
+  void RequestComputeReslicingPlane( const TimeStamp & renderTime ); 
+
   /** Retrieve current orientation mode*/
   OrientationType GetOrientationType() const;
 
@@ -285,6 +291,13 @@ private:
   VectorType                        m_PlaneNormal;
   VectorType                        m_PlaneCenter;
 
+  /** Render start time for which the plane was last computed. The flag is
+   *  cleared by any change of the plane definition. */
+  bool                              m_PlaneComputed;
+  TimeStamp::TimePeriodType         m_PlaneComputationTime;
+  TimeStamp                         m_RenderTimeToBeSet;
+  bool                              m_RenderTimeToBeSetFlag;
+
   // Event macro setup to receive the tool spatial object transform
   // with respect to the reference spatial object coordinate system
   igstkLoadedEventTransductionMacro( CoordinateSystemTransformTo, 
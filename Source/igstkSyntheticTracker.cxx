@@ -0,0 +1,714 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkSyntheticTracker.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in
+// the debug information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkSyntheticTracker.h"
+#include "igstkPulseGenerator.h"
+#include "igstkRealTimeClock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace igstk
+{
+
+namespace
+{
+const double TwoPi = 6.283185307179586;
+}
+
+SyntheticTracker::ParametricTrajectory::ParametricTrajectory()
+{
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    m_Center[i] = 0.0;
+    m_Amplitude[i] = 0.0;
+    m_Frequency[i] = 0.0;
+    m_Phase[i] = 0.0;
+    m_RotationAxis[i] = 0.0;
+    }
+  m_RotationAxis[2] = 1.0;
+  m_AngularSpeed = 0.0;
+}
+
+SyntheticTracker::SyntheticTracker():m_StateMachine(this)
+{
+  m_SampleRate = 1000.0;
+  m_Latency = 0.0;
+  m_TranslationNoise = 0.0;
+  m_RotationNoise = 0.0;
+  m_DropoutRate = 0.0;
+  m_DropoutLength = 1;
+  m_Seed = 0;
+  m_PreciseTiming = false;
+
+  m_StartTime = 0.0;
+  m_NextSampleIndex = 0;
+
+  m_BufferLock = itk::MutexLock::New();
+
+  // The samples are produced by the tracking thread
+  this->SetThreadingEnabled( true );
+}
+
+SyntheticTracker::~SyntheticTracker()
+{
+}
+
+void SyntheticTracker::SetSampleRate( double sampleRate )
+{
+  if( sampleRate <= 0.0 )
+    {
+    igstkLogMacro( WARNING, "SyntheticTracker::SetSampleRate: the rate "
+                   "must be positive.\n" );
+    return;
+    }
+  m_SampleRate = sampleRate;
+}
+
+void SyntheticTracker::SetDropoutLength( unsigned int numberOfSamples )
+{
+  m_DropoutLength = ( numberOfSamples > 0 ) ? numberOfSamples : 1;
+}
+
+void SyntheticTracker::SetToolParametricTrajectory(
+  const std::string & identifier, const ParametricTrajectory & trajectory )
+{
+  Trajectory & toolTrajectory = m_Trajectories[identifier];
+  toolTrajectory.m_Parametric = trajectory;
+  toolTrajectory.m_Times.clear();
+  toolTrajectory.m_Poses.clear();
+
+  m_BufferLock->Lock();
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_Tools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    if( m_Tools[i]->GetTrackerToolIdentifier() == identifier )
+      {
+      m_ToolTrajectories[i] = toolTrajectory;
+      }
+    }
+  m_BufferLock->Unlock();
+}
+
+void SyntheticTracker::SetToolRecordedTrajectory(
+  const std::string & identifier,
+  const std::vector< TimePeriodType > & times,
+  const std::vector< Pose > & poses )
+{
+  if( times.size() != poses.size() )
+    {
+    igstkLogMacro( WARNING, "SyntheticTracker::SetToolRecordedTrajectory: "
+                   "the numbers of times and poses differ.\n" );
+    return;
+    }
+  for( unsigned int i = 1; i < times.size(); i++ )
+    {
+    if( times[i] <= times[i - 1] )
+      {
+      igstkLogMacro( WARNING, "SyntheticTracker::SetToolRecordedTrajectory:"
+                     " the times are not increasing.\n" );
+      return;
+      }
+    }
+
+  Trajectory toolTrajectory;
+  if( poses.empty() )
+    {
+    m_Trajectories.erase( identifier );
+    this->GetToolTrajectory( identifier, toolTrajectory );
+    }
+  else
+    {
+    toolTrajectory.m_Times = times;
+    toolTrajectory.m_Poses = poses;
+    m_Trajectories[identifier] = toolTrajectory;
+    }
+
+  m_BufferLock->Lock();
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_Tools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    if( m_Tools[i]->GetTrackerToolIdentifier() == identifier )
+      {
+      m_ToolTrajectories[i] = toolTrajectory;
+      }
+    }
+  m_BufferLock->Unlock();
+}
+
+bool SyntheticTracker::ReadRecordedTrajectory( std::istream & is,
+                                       std::vector< TimePeriodType > & times,
+                                       std::vector< Pose > & poses )
+{
+  times.clear();
+  poses.clear();
+
+  std::string line;
+  while( std::getline( is, line ) )
+    {
+    const std::string::size_type first = line.find_first_not_of( " \t\r" );
+    if( first == std::string::npos || line[first] == '#' )
+      {
+      continue;
+      }
+
+    std::istringstream fields( line );
+    TimePeriodType time;
+    Pose pose;
+    fields >> time
+           >> pose.m_Translation[0] >> pose.m_Translation[1]
+           >> pose.m_Translation[2]
+           >> pose.m_Rotation[0] >> pose.m_Rotation[1]
+           >> pose.m_Rotation[2] >> pose.m_Rotation[3];
+    if( fields.fail() )
+      {
+      return false;
+      }
+
+    const double norm = std::sqrt(
+      pose.m_Rotation[0] * pose.m_Rotation[0] +
+      pose.m_Rotation[1] * pose.m_Rotation[1] +
+      pose.m_Rotation[2] * pose.m_Rotation[2] +
+      pose.m_Rotation[3] * pose.m_Rotation[3] );
+    if( norm == 0.0 )
+      {
+      return false;
+      }
+    for( unsigned int k = 0; k < 4; k++ )
+      {
+      pose.m_Rotation[k] /= norm;
+      }
+
+    times.push_back( time );
+    poses.push_back( pose );
+    }
+  return true;
+}
+
+bool SyntheticTracker::ComputeToolPose( const std::string & identifier,
+                                        unsigned long sampleIndex,
+                                        Pose & pose ) const
+{
+  Trajectory trajectory;
+  this->GetToolTrajectory( identifier, trajectory );
+  return this->ComputeSample( trajectory, HashString( identifier ),
+                              sampleIndex, pose );
+}
+
+unsigned long SyntheticTracker::GetNumberOfSamples() const
+{
+  m_BufferLock->Lock();
+  const unsigned long numberOfSamples = m_NextSampleIndex;
+  m_BufferLock->Unlock();
+  return numberOfSamples;
+}
+
+void SyntheticTracker::GetToolTrajectory( const std::string & identifier,
+                                          Trajectory & trajectory ) const
+{
+  TrajectoryContainerType::const_iterator it =
+    m_Trajectories.find( identifier );
+  if( it != m_Trajectories.end() )
+    {
+    trajectory = it->second;
+    return;
+    }
+
+  // Default trajectory drawn from the identifier, independent of the seed
+  const unsigned int key = HashString( identifier );
+  double values[16];
+  for( unsigned int i = 0; i < 16; i++ )
+    {
+    values[i] = Hash( key + i ) / 4294967296.0;
+    }
+
+  ParametricTrajectory & parametric = trajectory.m_Parametric;
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    parametric.m_Center[k] = 200.0 * values[k] - 100.0;
+    parametric.m_Amplitude[k] = 5.0 + 45.0 * values[3 + k];
+    parametric.m_Frequency[k] = 0.1 + 0.9 * values[6 + k];
+    parametric.m_Phase[k] = TwoPi * values[9 + k];
+    parametric.m_RotationAxis[k] = values[12 + k] - 0.5;
+    }
+  parametric.m_AngularSpeed = 0.1 + 0.9 * values[15];
+  trajectory.m_Times.clear();
+  trajectory.m_Poses.clear();
+}
+
+void SyntheticTracker::ComputeTrajectoryPose( const Trajectory & trajectory,
+                                              TimePeriodType time,
+                                              Pose & pose )
+{
+  const unsigned int numberOfPoses =
+    static_cast< unsigned int >( trajectory.m_Poses.size() );
+
+  if( numberOfPoses == 0 )
+    {
+    const ParametricTrajectory & parametric = trajectory.m_Parametric;
+    const double seconds = time / 1000.0;
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      pose.m_Translation[k] = parametric.m_Center[k] +
+        parametric.m_Amplitude[k] *
+        std::sin( TwoPi * parametric.m_Frequency[k] * seconds +
+                  parametric.m_Phase[k] );
+      }
+
+    const double * axis = parametric.m_RotationAxis;
+    const double norm =
+      std::sqrt( axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] );
+    if( norm == 0.0 )
+      {
+      pose.m_Rotation[0] = 0.0;
+      pose.m_Rotation[1] = 0.0;
+      pose.m_Rotation[2] = 0.0;
+      pose.m_Rotation[3] = 1.0;
+      return;
+      }
+    const double halfAngle = 0.5 * parametric.m_AngularSpeed * seconds;
+    const double sine = std::sin( halfAngle ) / norm;
+    pose.m_Rotation[0] = axis[0] * sine;
+    pose.m_Rotation[1] = axis[1] * sine;
+    pose.m_Rotation[2] = axis[2] * sine;
+    pose.m_Rotation[3] = std::cos( halfAngle );
+    return;
+    }
+
+  if( numberOfPoses == 1 )
+    {
+    pose = trajectory.m_Poses[0];
+    return;
+    }
+
+  // The recorded poses are played in a loop
+  const std::vector< TimePeriodType > & times = trajectory.m_Times;
+  const TimePeriodType duration = times.back() - times.front();
+  TimePeriodType loopTime = std::fmod( time, duration );
+  if( loopTime < 0.0 )
+    {
+    loopTime += duration;
+    }
+  loopTime += times.front();
+
+  const unsigned int next = static_cast< unsigned int >(
+    std::upper_bound( times.begin(), times.end(), loopTime ) -
+    times.begin() );
+  if( next >= numberOfPoses )
+    {
+    pose = trajectory.m_Poses.back();
+    return;
+    }
+  if( next == 0 )
+    {
+    pose = trajectory.m_Poses.front();
+    return;
+    }
+
+  const Pose & before = trajectory.m_Poses[next - 1];
+  const Pose & after = trajectory.m_Poses[next];
+  const double t =
+    ( loopTime - times[next - 1] ) / ( times[next] - times[next - 1] );
+
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    pose.m_Translation[k] = ( 1.0 - t ) * before.m_Translation[k] +
+                            t * after.m_Translation[k];
+    }
+
+  // Spherical interpolation along the shortest arc
+  double cosine = 0.0;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    cosine += before.m_Rotation[k] * after.m_Rotation[k];
+    }
+  const double sign = ( cosine < 0.0 ) ? -1.0 : 1.0;
+  cosine *= sign;
+
+  double weightBefore = 1.0 - t;
+  double weightAfter = t;
+  if( cosine < 0.9999 )
+    {
+    const double angle = std::acos( cosine );
+    const double sine = std::sin( angle );
+    weightBefore = std::sin( ( 1.0 - t ) * angle ) / sine;
+    weightAfter = std::sin( t * angle ) / sine;
+    }
+  double norm = 0.0;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    pose.m_Rotation[k] = weightBefore * before.m_Rotation[k] +
+                         weightAfter * sign * after.m_Rotation[k];
+    norm += pose.m_Rotation[k] * pose.m_Rotation[k];
+    }
+  norm = std::sqrt( norm );
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    pose.m_Rotation[k] /= norm;
+    }
+}
+
+bool SyntheticTracker::ComputeSample( const Trajectory & trajectory,
+                                      unsigned int key,
+                                      unsigned long sampleIndex,
+                                      Pose & pose ) const
+{
+  // The dropouts are drawn once per block of samples
+  if( m_DropoutRate > 0.0 &&
+      this->ComputeUniform( key, sampleIndex / m_DropoutLength, 0 ) <
+      m_DropoutRate )
+    {
+    return false;
+    }
+
+  const TimePeriodType sampleTime = sampleIndex * 1000.0 / m_SampleRate;
+  ComputeTrajectoryPose( trajectory, sampleTime - m_Latency, pose );
+
+  if( m_TranslationNoise > 0.0 )
+    {
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      pose.m_Translation[k] += m_TranslationNoise *
+        this->ComputeGaussian( key, sampleIndex, 1 + k );
+      }
+    }
+
+  if( m_RotationNoise > 0.0 )
+    {
+    // Rotate by a small rotation vector
+    double vector[3];
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      vector[k] = m_RotationNoise *
+        this->ComputeGaussian( key, sampleIndex, 4 + k );
+      }
+    const double angle = std::sqrt( vector[0] * vector[0] +
+                                    vector[1] * vector[1] +
+                                    vector[2] * vector[2] );
+    if( angle > 0.0 )
+      {
+      const double sine = std::sin( 0.5 * angle ) / angle;
+      const double x = vector[0] * sine;
+      const double y = vector[1] * sine;
+      const double z = vector[2] * sine;
+      const double w = std::cos( 0.5 * angle );
+
+      const double * r = pose.m_Rotation;
+      const double rx = r[3] * x + r[0] * w + r[1] * z - r[2] * y;
+      const double ry = r[3] * y + r[1] * w + r[2] * x - r[0] * z;
+      const double rz = r[3] * z + r[2] * w + r[0] * y - r[1] * x;
+      const double rw = r[3] * w - r[0] * x - r[1] * y - r[2] * z;
+      const double norm = std::sqrt( rx * rx + ry * ry + rz * rz + rw * rw );
+      pose.m_Rotation[0] = rx / norm;
+      pose.m_Rotation[1] = ry / norm;
+      pose.m_Rotation[2] = rz / norm;
+      pose.m_Rotation[3] = rw / norm;
+      }
+    }
+
+  return true;
+}
+
+unsigned int SyntheticTracker::Hash( unsigned int value )
+{
+  value ^= value >> 16;
+  value *= 0x7feb352dU;
+  value ^= value >> 15;
+  value *= 0x846ca68bU;
+  value ^= value >> 16;
+  return value;
+}
+
+unsigned int SyntheticTracker::HashString( const std::string & text )
+{
+  // FNV-1a
+  unsigned int value = 2166136261U;
+  for( std::string::size_type i = 0; i < text.size(); i++ )
+    {
+    value ^= static_cast< unsigned char >( text[i] );
+    value *= 16777619U;
+    }
+  return value;
+}
+
+double SyntheticTracker::ComputeUniform( unsigned int key,
+                                         unsigned long index,
+                                         unsigned int stream ) const
+{
+  unsigned int value = Hash( m_Seed + 0x9e3779b9U * stream );
+  value = Hash( value ^ key );
+  value = Hash( value ^ static_cast< unsigned int >( index & 0xffffffffUL ) );
+  value = Hash( value ^ static_cast< unsigned int >( ( index >> 16 ) >> 16 ) );
+
+  // In ]0,1[
+  return ( value + 0.5 ) / 4294967296.0;
+}
+
+double SyntheticTracker::ComputeGaussian( unsigned int key,
+                                          unsigned long index,
+                                          unsigned int stream ) const
+{
+  // Box-Muller transform of two uniform numbers
+  const double u1 = this->ComputeUniform( key, index, 2 * stream + 1 );
+  const double u2 = this->ComputeUniform( key, index, 2 * stream + 2 );
+  return std::sqrt( -2.0 * std::log( u1 ) ) * std::cos( TwoPi * u2 );
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalOpen( void )
+{
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalStartTracking( void )
+{
+  m_BufferLock->Lock();
+  m_StartTime = RealTimeClock::GetTimeStamp();
+  m_NextSampleIndex = 0;
+  std::fill( m_ToolReportedVisible.begin(), m_ToolReportedVisible.end(), 0 );
+  std::fill( m_SampleVisible.begin(), m_SampleVisible.end(), 0 );
+  m_BufferLock->Unlock();
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalReset( void )
+{
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalStopTracking( void )
+{
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalClose( void )
+{
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType
+SyntheticTracker
+::VerifyTrackerToolInformation( const TrackerToolType * itkNotUsed(trackerTool))
+{
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType
+SyntheticTracker::InternalThreadedUpdateStatus( void )
+{
+  const double period = 1000.0 / m_SampleRate;
+
+  m_BufferLock->Lock();
+  unsigned long sampleIndex = m_NextSampleIndex;
+  m_BufferLock->Unlock();
+
+  // Wait for the time of the sample. The sleep is rounded up to whole
+  // milliseconds, unless the last one is spun on the clock. The tracker
+  // falls back to the latest sample when it is late.
+  TimePeriodType now = RealTimeClock::GetTimeStamp();
+  const TimePeriodType dueTime = m_StartTime + sampleIndex * period;
+  if( now < dueTime )
+    {
+    if( this->GetThreadingEnabled() )
+      {
+      const TimePeriodType wait = dueTime - now;
+      if( m_PreciseTiming )
+        {
+        if( wait >= 1.0 )
+          {
+          PulseGenerator::Sleep( static_cast< unsigned int >( wait ) );
+          }
+        while( RealTimeClock::GetTimeStamp() < dueTime )
+          {
+          }
+        }
+      else
+        {
+        PulseGenerator::Sleep(
+          static_cast< unsigned int >( std::ceil( wait ) ) );
+        }
+      }
+    }
+  else
+    {
+    const unsigned long lateIndex =
+      static_cast< unsigned long >( ( now - m_StartTime ) / period );
+    sampleIndex = std::max( sampleIndex, lateIndex );
+    }
+
+  m_BufferLock->Lock();
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_Tools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    m_SampleVisible[i] = this->ComputeSample(
+      m_ToolTrajectories[i], m_ToolKeys[i], sampleIndex, m_SamplePoses[i] );
+    }
+  m_NextSampleIndex = sampleIndex + 1;
+  m_BufferLock->Unlock();
+
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType SyntheticTracker::InternalUpdateStatus( void )
+{
+  igstkLogMacro( DEBUG, "SyntheticTracker::InternalUpdateStatus called ...\n");
+
+  m_BufferLock->Lock();
+
+  TimeStamp timeStamp;
+  timeStamp.SetStartTimeNowAndExpireAfter( this->GetValidityTime() );
+
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_Tools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    TrackerToolType * trackerTool = m_Tools[i];
+
+    if( !m_SampleVisible[i] )
+      {
+      if( m_ToolReportedVisible[i] )
+        {
+        this->ReportTrackingToolNotAvailable( trackerTool );
+        m_ToolReportedVisible[i] = 0;
+        }
+      continue;
+      }
+
+    if( !m_ToolReportedVisible[i] )
+      {
+      this->ReportTrackingToolVisible( trackerTool );
+      m_ToolReportedVisible[i] = 1;
+      }
+
+    TransformType transform;
+    TransformBatch::ImportPose( m_SamplePoses[i], 0.0, timeStamp,
+                                transform );
+    this->SetTrackerToolRawTransform( trackerTool, transform );
+    this->SetTrackerToolTransformUpdate( trackerTool, true );
+    }
+
+  m_BufferLock->Unlock();
+
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType
+SyntheticTracker
+::RemoveTrackerToolFromInternalDataContainers
+( const TrackerToolType * trackerTool )
+{
+  m_BufferLock->Lock();
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_Tools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    if( m_Tools[i] != trackerTool )
+      {
+      continue;
+      }
+
+    // The last tool takes the place of the removed one
+    const unsigned int last = numberOfTools - 1;
+    m_Tools[i] = m_Tools[last];
+    m_ToolKeys[i] = m_ToolKeys[last];
+    m_ToolTrajectories[i] = m_ToolTrajectories[last];
+    m_ToolReportedVisible[i] = m_ToolReportedVisible[last];
+    m_SamplePoses[i] = m_SamplePoses[last];
+    m_SampleVisible[i] = m_SampleVisible[last];
+
+    m_Tools.pop_back();
+    m_ToolKeys.pop_back();
+    m_ToolTrajectories.pop_back();
+    m_ToolReportedVisible.pop_back();
+    m_SamplePoses.pop_back();
+    m_SampleVisible.pop_back();
+    break;
+    }
+  m_BufferLock->Unlock();
+
+  return SUCCESS;
+}
+
+SyntheticTracker::ResultType
+SyntheticTracker
+::AddTrackerToolToInternalDataContainers
+( const TrackerToolType * trackerTool )
+{
+  if( trackerTool == NULL )
+    {
+    return FAILURE;
+    }
+
+  const std::string identifier = trackerTool->GetTrackerToolIdentifier();
+
+  // The tool is reported to through its entry in the container of the
+  // tracker, which is not const
+  const TrackerToolsContainerType & trackerTools =
+    this->GetTrackerToolContainer();
+  TrackerToolsContainerType::const_iterator it =
+    trackerTools.find( identifier );
+  if( it == trackerTools.end() )
+    {
+    return FAILURE;
+    }
+
+  Trajectory trajectory;
+  this->GetToolTrajectory( identifier, trajectory );
+
+  Pose pose;
+  TransformBatch::SetToIdentity( pose );
+
+  m_BufferLock->Lock();
+  m_Tools.push_back( it->second );
+  m_ToolKeys.push_back( HashString( identifier ) );
+  m_ToolTrajectories.push_back( trajectory );
+  m_ToolReportedVisible.push_back( 0 );
+  m_SamplePoses.push_back( pose );
+  m_SampleVisible.push_back( 0 );
+  m_BufferLock->Unlock();
+
+  return SUCCESS;
+}
+
+/** Print Self function */
+void SyntheticTracker::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "SampleRate: " << m_SampleRate << std::endl;
+  os << indent << "Latency: " << m_Latency << std::endl;
+  os << indent << "TranslationNoise: " << m_TranslationNoise << std::endl;
+  os << indent << "RotationNoise: " << m_RotationNoise << std::endl;
+  os << indent << "DropoutRate: " << m_DropoutRate << std::endl;
+  os << indent << "DropoutLength: " << m_DropoutLength << std::endl;
+  os << indent << "Seed: " << m_Seed << std::endl;
+  os << indent << "PreciseTiming: " << m_PreciseTiming << std::endl;
+  os << indent << "Number of trajectories: " << m_Trajectories.size()
+     << std::endl;
+  os << indent << "Number of tools: " << m_Tools.size() << std::endl;
+}
+
+}
@@ -0,0 +1,246 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkSyntheticTracker.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkSyntheticTracker_h
+#define __igstkSyntheticTracker_h
+
+#include "igstkTracker.h"
+#include "igstkTransformBatch.h"
+
+#include "itkMutexLock.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace igstk
+{
+
+/** \class SyntheticTracker
+ *  \brief A tracker generating deterministic poses for any number of
+ *  tools, for load and scaling tests.
+ *
+ *  The tracker runs through the threaded path of Tracker: its tracking
+ *  thread produces a sample of all the tools SampleRate times per second,
+ *  up to several kHz, and the updates of the tracker, at the frequency set
+ *  by RequestSetFrequency(), report the last sample. Any configured
+ *  TrackerTool can be attached, for example a SimulatedTrackerTool.
+ *
+ *  Each tool follows a trajectory, set for its identifier before or after
+ *  it is attached:
+ *  - a parametric trajectory, a sinusoid around a center on each axis and
+ *    a rotation at constant speed around an axis,
+ *  - or a recorded trajectory, a sequence of timed poses played in a loop
+ *    and interpolated between the poses.
+ *  The tools without trajectory follow a parametric trajectory derived
+ *  from their identifier.
+ *
+ *  The samples are deterministic: the pose of a tool in the sample k, as
+ *  returned by ComputeToolPose(), only depends on k, on the identifier of
+ *  the tool, on its trajectory and on the parameters below. Which samples
+ *  are reported by the updates depends on the timing of the threads.
+ *  - Latency delays the trajectories: the sample k reports the pose of
+ *    the tool Latency milliseconds before the time of the sample.
+ *  - Gaussian noise of TranslationNoise millimeters and RotationNoise
+ *    radians, on each axis, is added to the poses.
+ *  - DropoutRate is the fraction of the samples in which a tool is not
+ *    visible, in bursts of DropoutLength samples.
+ *  - Seed selects the noise and the dropouts.
+ *
+ *  The parameters should be set while the tracker is not tracking.
+ *
+ *  \ingroup Trackers
+ */
+class SyntheticTracker : public Tracker
+{
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( SyntheticTracker, Tracker )
+
+  typedef Superclass::TransformType           TransformType;
+  typedef TransformType::TimePeriodType       TimePeriodType;
+
+  /** Trajectory made of a sinusoid on each axis, of the given amplitude
+   *  [mm], frequency [Hz] and phase [rad], around a center, and of a
+   *  rotation at constant speed [rad/s] around an axis. */
+  struct ParametricTrajectory
+    {
+    ParametricTrajectory();
+
+    double    m_Center[3];
+    double    m_Amplitude[3];
+    double    m_Frequency[3];
+    double    m_Phase[3];
+    double    m_RotationAxis[3];
+    double    m_AngularSpeed;
+    };
+
+  /** Set the trajectory of a tool. The times of a recorded trajectory are
+   *  in milliseconds from its start, and increasing. A recorded
+   *  trajectory without poses removes the trajectory of the tool. */
+  void SetToolParametricTrajectory( const std::string & identifier,
+                                    const ParametricTrajectory & trajectory );
+  void SetToolRecordedTrajectory( const std::string & identifier,
+                                  const std::vector< TimePeriodType > & times,
+                                  const std::vector< Pose > & poses );
+
+  /** Read a recorded trajectory from a stream with a pose per line:
+   *  time [ms], X, Y, Z, and the versor X, Y, Z, W. Empty lines and lines
+   *  starting with '#' are skipped. Returns false on a malformed line. */
+  static bool ReadRecordedTrajectory( std::istream & is,
+                                      std::vector< TimePeriodType > & times,
+                                      std::vector< Pose > & poses );
+
+  /** Number of samples per second of the tracking thread */
+  void SetSampleRate( double sampleRate );
+  igstkGetMacro( SampleRate, double );
+
+  /** Delay of the poses [milliseconds] */
+  igstkSetMacro( Latency, TimePeriodType );
+  igstkGetMacro( Latency, TimePeriodType );
+
+  /** Standard deviations of the noise [mm] and [rad] */
+  igstkSetMacro( TranslationNoise, double );
+  igstkGetMacro( TranslationNoise, double );
+  igstkSetMacro( RotationNoise, double );
+  igstkGetMacro( RotationNoise, double );
+
+  /** Fraction of the samples in which a tool is not visible, between 0
+   *  and 1, and length of the dropouts in samples */
+  igstkSetMacro( DropoutRate, double );
+  igstkGetMacro( DropoutRate, double );
+  void SetDropoutLength( unsigned int numberOfSamples );
+  igstkGetMacro( DropoutLength, unsigned int );
+
+  /** Seed of the noise and of the dropouts */
+  igstkSetMacro( Seed, unsigned int );
+  igstkGetMacro( Seed, unsigned int );
+
+  /** Whether the tracking thread spins on the clock for the last
+   *  millisecond before a sample, so that it is produced at its time
+   *  rather than up to a millisecond late. Off by default, since the
+   *  thread then keeps a processor busy at high sample rates. */
+  igstkSetMacro( PreciseTiming, bool );
+  igstkGetMacro( PreciseTiming, bool );
+
+  /** Pose of a tool in a sample, returns false if the tool is not
+   *  visible in the sample */
+  bool ComputeToolPose( const std::string & identifier,
+                        unsigned long sampleIndex, Pose & pose ) const;
+
+  /** Number of samples produced since tracking started */
+  unsigned long GetNumberOfSamples() const;
+
+protected:
+
+  SyntheticTracker();
+  virtual ~SyntheticTracker();
+
+  typedef Tracker::ResultType                 ResultType;
+
+  virtual ResultType InternalOpen( void );
+  virtual ResultType InternalStartTracking( void );
+  virtual ResultType InternalReset( void );
+  virtual ResultType InternalStopTracking( void );
+  virtual ResultType InternalClose( void );
+
+  /** Verify tracker tool information */
+  virtual ResultType VerifyTrackerToolInformation( const TrackerToolType * );
+
+  virtual ResultType RemoveTrackerToolFromInternalDataContainers(
+                                                 const TrackerToolType * );
+  virtual ResultType AddTrackerToolToInternalDataContainers(
+                                                 const TrackerToolType * );
+
+  /** Report the last sample to the tools */
+  virtual ResultType InternalUpdateStatus( void );
+
+  /** Wait for the time of the next sample and produce it */
+  virtual ResultType InternalThreadedUpdateStatus( void );
+
+  /** Print object information */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+private:
+
+  SyntheticTracker(const Self&);  //purposely not implemented
+  void operator=(const Self&);    //purposely not implemented
+
+  /** Parametric or recorded trajectory */
+  struct Trajectory
+    {
+    ParametricTrajectory              m_Parametric;
+    std::vector< TimePeriodType >     m_Times;
+    std::vector< Pose >               m_Poses;
+    };
+
+  typedef std::map< std::string, Trajectory >   TrajectoryContainerType;
+
+  /** Trajectory of a tool, the default one if none was set */
+  void GetToolTrajectory( const std::string & identifier,
+                          Trajectory & trajectory ) const;
+
+  static void ComputeTrajectoryPose( const Trajectory & trajectory,
+                                     TimePeriodType time, Pose & pose );
+
+  /** Pose of a tool of the given key in a sample */
+  bool ComputeSample( const Trajectory & trajectory, unsigned int key,
+                      unsigned long sampleIndex, Pose & pose ) const;
+
+  /** Deterministic random numbers */
+  static unsigned int Hash( unsigned int value );
+  static unsigned int HashString( const std::string & text );
+  double ComputeUniform( unsigned int key, unsigned long index,
+                         unsigned int stream ) const;
+  double ComputeGaussian( unsigned int key, unsigned long index,
+                          unsigned int stream ) const;
+
+  double                            m_SampleRate;
+  TimePeriodType                    m_Latency;
+  double                            m_TranslationNoise;
+  double                            m_RotationNoise;
+  double                            m_DropoutRate;
+  unsigned int                      m_DropoutLength;
+  unsigned int                      m_Seed;
+  bool                              m_PreciseTiming;
+
+  TrajectoryContainerType           m_Trajectories;
+
+  /** Protects the tools and the last sample, shared by the tracking
+   *  thread and the updates */
+  itk::MutexLock::Pointer           m_BufferLock;
+
+  /** Attached tools, one array per field */
+  std::vector< TrackerToolType * >  m_Tools;
+  std::vector< unsigned int >       m_ToolKeys;
+  std::vector< Trajectory >         m_ToolTrajectories;
+  std::vector< unsigned char >      m_ToolReportedVisible;
+
+  /** Last sample */
+  std::vector< Pose >               m_SamplePoses;
+  std::vector< unsigned char >      m_SampleVisible;
+
+  /** Time at which tracking started, and index of the next sample */
+  TimePeriodType                    m_StartTime;
+  unsigned long                     m_NextSampleIndex;
+};
+
+}
+
+#endif //__igstkSyntheticTracker_h
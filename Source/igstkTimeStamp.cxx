@@ -84,6 +84,15 @@ TimeStamp
 }
 
 
+void
+TimeStamp
+::SetStartTimeAndExpireAfter( double startTime, double millisecondsToExpire )
+{
+  this->m_StartTime      = startTime;
+  this->m_ExpirationTime = startTime + millisecondsToExpire;
+}
+
+
 double 
 TimeStamp
 ::GetStartTime() const 
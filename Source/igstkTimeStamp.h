@@ -82,6 +82,13 @@ public:
    * number of millisecondsToExpire argument provided by the user */
   void SetStartTimeNowAndExpireAfter( TimePeriodType millisecondsToExpire);
 
+  /** This method sets the StartTime to a time previously read from the
+   * RealTimeClock, so that several stamps can share one reading of the
+   * clock. The ExpirationTime is set to the StartTime plus the number of
+   * millisecondsToExpire. */
+  void SetStartTimeAndExpireAfter( TimePeriodType startTime,
+                                   TimePeriodType millisecondsToExpire );
+
   
   /** Returns the time in milliseconds at which this stamp started to be valid.
    * This is the time at which the SetStartTimeNowAndExpireAfter() was invoked
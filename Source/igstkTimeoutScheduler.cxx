@@ -0,0 +1,354 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTimeoutScheduler.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkTimeoutScheduler.h"
+#include "igstkRealTimeClock.h"
+#include "igstkConfigure.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined (_WIN32) || defined (WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_SYS_TIMERFD_H)
+#include <sys/timerfd.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#endif
+
+namespace igstk
+{
+
+TimeoutScheduler::TimeoutScheduler()
+{
+  m_Invoking = false;
+  m_NumberOfAdditions = 0;
+  m_TimerDescriptor = -1;
+  m_PollDescriptor = -1;
+}
+
+TimeoutScheduler::~TimeoutScheduler()
+{
+#if !defined (_WIN32) && !defined (WIN32)
+  if( m_PollDescriptor >= 0 )
+    {
+    close( m_PollDescriptor );
+    }
+  if( m_TimerDescriptor >= 0 )
+    {
+    close( m_TimerDescriptor );
+    }
+#endif
+}
+
+void TimeoutScheduler::AddTimeout( double deadline, TimeoutHandler handler,
+                                   void * data )
+{
+  Timeout timeout;
+  timeout.m_Deadline = deadline;
+  timeout.m_Handler = handler;
+  timeout.m_Data = data;
+  timeout.m_Order = m_NumberOfAdditions++;
+
+  // The timeouts added by the handlers are set aside until the due
+  // timeouts have been invoked
+  if( m_Invoking )
+    {
+    m_AddedTimeouts.push_back( timeout );
+    return;
+    }
+
+  m_Heap.push_back( timeout );
+  if( this->SiftUp( static_cast< unsigned int >( m_Heap.size() ) - 1 ) == 0 )
+    {
+    this->UpdateTimer();
+    }
+}
+
+void TimeoutScheduler::RemoveTimeout( TimeoutHandler handler, void * data )
+{
+  bool removed = false;
+  unsigned int index = 0;
+  while( index < m_Heap.size() )
+    {
+    if( m_Heap[index].m_Handler == handler &&
+        ( m_Heap[index].m_Data == data || !data ) )
+      {
+      this->RemoveAt( index );
+      removed = true;
+      }
+    else
+      {
+      index++;
+      }
+    }
+
+  std::vector< Timeout >::iterator added = m_AddedTimeouts.begin();
+  while( added != m_AddedTimeouts.end() )
+    {
+    if( added->m_Handler == handler && ( added->m_Data == data || !data ) )
+      {
+      added = m_AddedTimeouts.erase( added );
+      }
+    else
+      {
+      ++added;
+      }
+    }
+
+  if( removed && !m_Invoking )
+    {
+    this->UpdateTimer();
+    }
+}
+
+unsigned int TimeoutScheduler::InvokeTimeouts()
+{
+  return this->InvokeTimeouts( RealTimeClock::GetTimeStamp() );
+}
+
+unsigned int TimeoutScheduler::InvokeTimeouts( double currentTime )
+{
+  // Prevent this method from being invoked from any of the handlers
+  if( m_Invoking )
+    {
+    return 0;
+    }
+
+  m_Invoking = true;
+
+  unsigned int numberOfInvocations = 0;
+  while( !m_Heap.empty() && m_Heap[0].m_Deadline <= currentTime )
+    {
+    const Timeout timeout = m_Heap[0];
+    this->RemoveAt( 0 );
+    timeout.m_Handler( timeout.m_Data );
+    numberOfInvocations++;
+    }
+
+  for( unsigned int i = 0; i < m_AddedTimeouts.size(); i++ )
+    {
+    m_Heap.push_back( m_AddedTimeouts[i] );
+    this->SiftUp( static_cast< unsigned int >( m_Heap.size() ) - 1 );
+    }
+  m_AddedTimeouts.clear();
+
+  m_Invoking = false;
+
+  this->UpdateTimer();
+
+  return numberOfInvocations;
+}
+
+double TimeoutScheduler::GetNextDeadline() const
+{
+  return m_Heap.empty() ? 0.0 : m_Heap[0].m_Deadline;
+}
+
+double TimeoutScheduler::GetTimeToNextTimeout( double currentTime ) const
+{
+  if( m_Heap.empty() )
+    {
+    return -1.0;
+    }
+  const double delay = m_Heap[0].m_Deadline - currentTime;
+  return ( delay > 0.0 ) ? delay : 0.0;
+}
+
+void TimeoutScheduler::WaitForTimeouts( double maximumDelay )
+{
+  double delay =
+    this->GetTimeToNextTimeout( RealTimeClock::GetTimeStamp() );
+  if( delay < 0.0 || delay > maximumDelay )
+    {
+    delay = maximumDelay;
+    }
+  if( delay > 0.0 )
+    {
+    this->GetFileDescriptor();
+    this->WaitForTimer( delay );
+    }
+}
+
+void TimeoutScheduler::WaitForTimer( double delay )
+{
+  if( delay <= 0.0 )
+    {
+    return;
+    }
+
+#if defined(HAVE_SYS_TIMERFD_H) && defined(HAVE_SYS_EPOLL_H)
+  const int timer = m_TimerDescriptor;
+  if( timer >= 0 && m_PollDescriptor < 0 )
+    {
+    m_PollDescriptor = epoll_create( 1 );
+    if( m_PollDescriptor >= 0 )
+      {
+      struct epoll_event event;
+      memset( &event, 0, sizeof( event ) );
+      event.events = EPOLLIN;
+      event.data.fd = timer;
+      if( epoll_ctl( m_PollDescriptor, EPOLL_CTL_ADD, timer, &event ) != 0 )
+        {
+        close( m_PollDescriptor );
+        m_PollDescriptor = -1;
+        }
+      }
+    }
+
+  if( m_PollDescriptor >= 0 )
+    {
+    // The timer wakes up at the deadline with a sub-millisecond precision,
+    // the timeout of epoll_wait() only bounds the wait.
+    struct epoll_event event;
+    epoll_wait( m_PollDescriptor, &event, 1,
+                static_cast< int >( ceil( delay ) ) );
+    return;
+    }
+#endif
+
+#if defined (_WIN32) || defined (WIN32)
+  ::Sleep( static_cast< DWORD >( delay ) );
+#else
+  usleep( static_cast< useconds_t >( delay * 1000.0 ) );
+#endif
+}
+
+int TimeoutScheduler::GetFileDescriptor()
+{
+#if defined(HAVE_SYS_TIMERFD_H)
+  if( m_TimerDescriptor < 0 )
+    {
+    m_TimerDescriptor = timerfd_create( CLOCK_MONOTONIC,
+                                        TFD_NONBLOCK | TFD_CLOEXEC );
+    this->UpdateTimer();
+    }
+#endif
+  return m_TimerDescriptor;
+}
+
+void TimeoutScheduler::WakeUp()
+{
+#if defined(HAVE_SYS_TIMERFD_H)
+  const int timer = m_TimerDescriptor;
+  if( timer >= 0 )
+    {
+    struct itimerspec value;
+    memset( &value, 0, sizeof( value ) );
+    value.it_value.tv_nsec = 1;
+    timerfd_settime( timer, 0, &value, NULL );
+    }
+#endif
+}
+
+void TimeoutScheduler::UpdateTimer()
+{
+#if defined(HAVE_SYS_TIMERFD_H)
+  if( m_TimerDescriptor < 0 )
+    {
+    return;
+    }
+
+  // Arming the timer also clears its expirations, so that the descriptor
+  // is not readable until the next deadline.
+  struct itimerspec value;
+  memset( &value, 0, sizeof( value ) );
+  if( !m_Heap.empty() )
+    {
+    double delay = m_Heap[0].m_Deadline - RealTimeClock::GetTimeStamp();
+    if( delay < 0.001 )
+      {
+      // A null value would disarm the timer
+      delay = 0.001;
+      }
+    value.it_value.tv_sec = static_cast< time_t >( delay / 1000.0 );
+    value.it_value.tv_nsec = static_cast< long >(
+      ( delay - 1000.0 * value.it_value.tv_sec ) * 1000000.0 );
+    }
+  timerfd_settime( m_TimerDescriptor, 0, &value, NULL );
+#endif
+}
+
+unsigned int TimeoutScheduler::SiftUp( unsigned int index )
+{
+  const Timeout timeout = m_Heap[index];
+  while( index > 0 )
+    {
+    const unsigned int parent = ( index - 1 ) / 2;
+    if( !IsEarlier( timeout, m_Heap[parent] ) )
+      {
+      break;
+      }
+    m_Heap[index] = m_Heap[parent];
+    index = parent;
+    }
+  m_Heap[index] = timeout;
+  return index;
+}
+
+void TimeoutScheduler::SiftDown( unsigned int index )
+{
+  const unsigned int size = static_cast< unsigned int >( m_Heap.size() );
+  const Timeout timeout = m_Heap[index];
+  while( 2 * index + 1 < size )
+    {
+    unsigned int child = 2 * index + 1;
+    if( child + 1 < size &&
+        IsEarlier( m_Heap[child + 1], m_Heap[child] ) )
+      {
+      child++;
+      }
+    if( !IsEarlier( m_Heap[child], timeout ) )
+      {
+      break;
+      }
+    m_Heap[index] = m_Heap[child];
+    index = child;
+    }
+  m_Heap[index] = timeout;
+}
+
+void TimeoutScheduler::RemoveAt( unsigned int index )
+{
+  const unsigned int last = static_cast< unsigned int >( m_Heap.size() ) - 1;
+  if( index != last )
+    {
+    m_Heap[index] = m_Heap[last];
+    m_Heap.pop_back();
+    if( index > 0 &&
+        IsEarlier( m_Heap[index], m_Heap[ ( index - 1 ) / 2 ] ) )
+      {
+      this->SiftUp( index );
+      }
+    else
+      {
+      this->SiftDown( index );
+      }
+    }
+  else
+    {
+    m_Heap.pop_back();
+    }
+}
+
+} // end namespace igstk
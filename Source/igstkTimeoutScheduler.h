@@ -0,0 +1,156 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTimeoutScheduler.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkTimeoutScheduler_h
+#define __igstkTimeoutScheduler_h
+
+#include <vector>
+
+namespace igstk
+{
+
+/** \class TimeoutScheduler
+ * \brief Calls functions at given times of the RealTimeClock.
+ *
+ * The timeouts are kept in a binary heap ordered by deadline. Adding a
+ * timeout and invoking the next one cost a logarithm of the number of
+ * timeouts, and finding the next deadline is immediate. The deadlines are
+ * absolute times in milliseconds, so that nothing is updated while the
+ * time passes. The timeouts are stored by value in a vector whose capacity
+ * is kept, so that no memory is allocated once the scheduler has reached
+ * its usual number of timeouts. Timeouts with the same deadline are invoked
+ * in the order in which they were added.
+ *
+ * Instead of polling InvokeTimeouts() at a high rate, an event loop can
+ * block until the next deadline, either with WaitForTimeouts() or by
+ * watching the file descriptor returned by GetFileDescriptor(). On Linux,
+ * the descriptor is a timerfd armed to the next deadline, which becomes
+ * readable when timeouts are due. It can be added to an epoll set, or to
+ * the descriptors watched by a GUI toolkit.
+ *
+ * \ingroup Object
+ */
+class TimeoutScheduler
+{
+
+public:
+
+  typedef void (*TimeoutHandler)( void * );
+
+  TimeoutScheduler();
+  ~TimeoutScheduler();
+
+  /** Schedule a call to the handler at a time of the RealTimeClock, in
+   *  milliseconds */
+  void AddTimeout( double deadline, TimeoutHandler handler, void * data );
+
+  /** Remove the timeouts of a handler with the given data, or all the
+   *  timeouts of the handler if data is NULL */
+  void RemoveTimeout( TimeoutHandler handler, void * data );
+
+  /** Call the handlers whose deadline is before the given time, in order of
+   *  deadline, and remove their timeouts. Timeouts added by the handlers
+   *  are only invoked by the next call. Returns the number of handlers
+   *  called. Calls from the handlers themselves do nothing. */
+  unsigned int InvokeTimeouts( double currentTime );
+
+  /** Same as above at the current time of the RealTimeClock */
+  unsigned int InvokeTimeouts();
+
+  /** Deadline of the next timeout. Only valid if there are timeouts */
+  double GetNextDeadline() const;
+
+  /** Milliseconds from the given time to the next deadline, zero if the
+   *  next timeout is due, and a negative value if there is no timeout */
+  double GetTimeToNextTimeout( double currentTime ) const;
+
+  unsigned int GetNumberOfTimeouts() const
+    {
+    return static_cast< unsigned int >( m_Heap.size() );
+    }
+
+  /** Block until the next timeout is due, or at most the given number of
+   *  milliseconds. The timeouts are not invoked. */
+  void WaitForTimeouts( double maximumDelay );
+
+  /** Block on the timer file descriptor for at most the given number of
+   *  milliseconds, or sleep for that time where there is no descriptor.
+   *  The timeouts are not accessed, so another thread may add timeouts
+   *  during the wait, in which case the timer wakes up at the new deadline
+   *  once GetFileDescriptor() has been called. */
+  void WaitForTimer( double delay );
+
+  /** File descriptor that becomes readable when timeouts are due. Returns
+   *  -1 where timerfd is not available. */
+  int GetFileDescriptor();
+
+  /** Make the file descriptor readable now, so that a thread waiting in
+   *  WaitForTimer() returns. Only the descriptor is accessed, so this can
+   *  be called from any thread. The timer is armed to the next deadline
+   *  again by the next change of the timeouts. */
+  void WakeUp();
+
+private:
+
+  TimeoutScheduler(const TimeoutScheduler &);  //purposely not implemented
+  void operator=(const TimeoutScheduler &);    //purposely not implemented
+
+  struct Timeout
+    {
+    double          m_Deadline;
+    TimeoutHandler  m_Handler;
+    void *          m_Data;
+    unsigned long   m_Order;
+    };
+
+  /** Whether a timeout is due before another one */
+  static bool IsEarlier( const Timeout & timeout, const Timeout & other )
+    {
+    return timeout.m_Deadline < other.m_Deadline ||
+           ( timeout.m_Deadline == other.m_Deadline &&
+             timeout.m_Order < other.m_Order );
+    }
+
+  /** Restore the order of the heap around a moved timeout. SiftUp()
+   *  returns the new index of the timeout. */
+  unsigned int SiftUp( unsigned int index );
+  void SiftDown( unsigned int index );
+
+  /** Remove a timeout from the heap */
+  void RemoveAt( unsigned int index );
+
+  /** Arm the timer file descriptor to the next deadline */
+  void UpdateTimer();
+
+  std::vector< Timeout >    m_Heap;
+
+  /** Timeouts added by the handlers being invoked */
+  std::vector< Timeout >    m_AddedTimeouts;
+
+  bool                      m_Invoking;
+
+  /** Number of timeouts added, used to order timeouts of equal deadline */
+  unsigned long             m_NumberOfAdditions;
+
+  int                       m_TimerDescriptor;
+  int                       m_PollDescriptor;
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkTimeoutScheduler_h
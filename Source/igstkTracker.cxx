@@ -22,12 +22,45 @@
 #endif
 
 #include "igstkTracker.h"
+#include "igstkRealTimeClock.h"
+
+#include <algorithm>
+#include <limits>
 
 #define NON_FLICKERING_CONSTANT 20
 
 namespace igstk
 {
 
+/** Move the last element of a state array to a removed slot */
+template < class TValue >
+static void RemoveSlotFromArray( std::vector< TValue > & values,
+                                 unsigned int slot )
+{
+  values[slot] = values.back();
+  values.pop_back();
+}
+
+/** Pose different from any measured one, NaN being unequal to itself */
+static Pose UnknownPose()
+{
+  Pose pose;
+  std::fill( pose.m_Rotation, pose.m_Rotation + 4,
+             std::numeric_limits< double >::quiet_NaN() );
+  std::fill( pose.m_Translation, pose.m_Translation + 3,
+             std::numeric_limits< double >::quiet_NaN() );
+  return pose;
+}
+
+/** Whether two poses are the same sample of a device */
+static bool IsSamePose( const Pose & pose1, const Pose & pose2 )
+{
+  return std::equal( pose1.m_Rotation, pose1.m_Rotation + 4,
+                     pose2.m_Rotation ) &&
+         std::equal( pose1.m_Translation, pose1.m_Translation + 3,
+                     pose2.m_Translation );
+}
+
 
 /** Constructor */
 Tracker::Tracker(void) :  m_StateMachine( this ) 
@@ -301,6 +334,9 @@ Tracker::Tracker(void) :  m_StateMachine( this )
   const double DEFAULT_REFRESH_RATE = 30.0;
   m_PulseGenerator->RequestSetFrequency( DEFAULT_REFRESH_RATE );
 
+  m_Telemetry = DeviceTelemetry::New();
+  m_Telemetry->SetNominalFrequency( DEFAULT_REFRESH_RATE );
+
   // This is the time period for which transformation should be
   // considered valid.  After this time, they expire.  This time
   // is in milliseconds. The default validity time is computed 
@@ -314,6 +350,9 @@ Tracker::Tracker(void) :  m_StateMachine( this )
   // By default, the reference is not used
   m_ApplyingReferenceTool = false;
 
+  m_ReportingTransforms = false;
+  m_PublishingTransforms = false;
+
   m_ConditionNextTransformReceived = itk::ConditionVariable::New();
   m_Threader = itk::MultiThreader::New();
   m_ThreadingEnabled = false;
@@ -323,6 +362,7 @@ Tracker::Tracker(void) :  m_StateMachine( this )
 /** Destructor */
 Tracker::~Tracker(void)
 {
+  EventLoop::GetMainLoop()->RemoveTimeout( PublishTransforms, this );
 }
 
 /** This method sets the reference tool. */
@@ -364,8 +404,11 @@ void Tracker::RequestSetReferenceTool( TrackerToolType * trackerTool )
 void Tracker::RequestOpen( void )
 {
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestOpen called...\n");
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
   igstkPushInputMacro( EstablishCommunication );
   this->m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
 
 
@@ -373,8 +416,11 @@ void Tracker::RequestOpen( void )
 void Tracker::RequestClose( void )
 {
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestClose called ...\n");
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
   igstkPushInputMacro( CloseCommunication );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
 
 /** The "RequestReset" tracker method should be used to the tracker
@@ -382,8 +428,11 @@ void Tracker::RequestClose( void )
 void Tracker::RequestReset( void )
 {
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestReset called ...\n");
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
   igstkPushInputMacro( Reset );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
 
 
@@ -392,8 +441,11 @@ void Tracker::RequestReset( void )
 void Tracker::RequestStartTracking( void )
 {
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestStartTracking called ...\n");
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
   igstkPushInputMacro( StartTracking );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
 
 
@@ -401,8 +453,11 @@ void Tracker::RequestStartTracking( void )
 void Tracker::RequestStopTracking( void )
 {
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestStopTracking called ...\n");
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
   igstkPushInputMacro( StopTracking );
   m_StateMachine.ProcessInputs();
+  eventLoop->Unlock();
 }
 
 
@@ -416,6 +471,19 @@ void Tracker::UpdateStatus( void )
 }
 
 
+/** Update the status of the tools synchronously */
+void Tracker::RequestUpdateStatus( void )
+{
+  igstkLogMacro( DEBUG, "igstk::Tracker::RequestUpdateStatus called ...\n");
+
+  // Not while a pulse updates the status
+  EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
+  this->UpdateStatus();
+  eventLoop->Unlock();
+}
+
+
 /** The "RequestSetFrequency" method is used for defining the rate at which 
  * Transforms are queried from the Tracker device */
 void Tracker::RequestSetFrequency( double frequencyInHz )
@@ -423,12 +491,24 @@ void Tracker::RequestSetFrequency( double frequencyInHz )
   igstkLogMacro( DEBUG, "igstk::Tracker::RequestSetFrequency called ...\n");
   if( this->ValidateSpecifiedFrequency( frequencyInHz ) )
     {
+    EventLoop::Pointer eventLoop = m_PulseGenerator->GetEventLoop();
+    eventLoop->Lock();
     this->m_FrequencyToBeSet = frequencyInHz;
     igstkPushInputMacro( ValidFrequency );
     m_StateMachine.ProcessInputs();
+    eventLoop->Unlock();
     }
 }
 
+
+/** The "RequestSetEventLoop" method moves the updates of the tracker to
+ * another event loop */
+void Tracker::RequestSetEventLoop( EventLoop * eventLoop )
+{
+  igstkLogMacro( DEBUG, "igstk::Tracker::RequestSetEventLoop called ...\n");
+  m_PulseGenerator->RequestSetEventLoop( eventLoop );
+}
+
 /** The "ValidateFrequency" method checks if the specified frequency is 
  * valid for the tracking device that is being used. This method is to be 
  * overridden in the derived tracking-device specific classes to take 
@@ -574,10 +654,25 @@ void Tracker::StartTrackingSuccessProcessing( void )
   while( inputItr != inputEnd )
     {
     (inputItr->second)->RequestReportTrackingStarted();
+
+    // The poses filtered before are too old
+    PoseFilter * filter = (inputItr->second)->m_PoseFilter;
+    const int slot = (inputItr->second)->m_TrackerToolSlot;
+    if( filter )
+      {
+      filter->Reset();
+      }
+    if( slot >= 0 && slot < static_cast< int >( m_ToolSlots.size() ) )
+      {
+      m_UnfilteredPoses[slot] = UnknownPose();
+      m_RawPoseRejected[slot] = 0;
+      }
     ++inputItr;
     }
 
 
+  m_Telemetry->Reset();
+
   // going from AttemptingToTrackState to TrackingState
   this->EnterTrackingStateProcessing();
 
@@ -600,8 +695,14 @@ void Tracker::AttachingTrackerToolSuccessProcessing( void )
   igstkLogMacro( DEBUG, "igstk::Tracker::AttachingTrackerToolSuccessProcessing "
                  "called ...\n");
 
-  m_TrackerTools[ m_TrackerToolToBeAttached->GetTrackerToolIdentifier() ] 
-                                   = m_TrackerToolToBeAttached; 
+  TrackerToolType * & trackerToolEntry =
+    m_TrackerTools[ m_TrackerToolToBeAttached->GetTrackerToolIdentifier() ];
+  if( trackerToolEntry && trackerToolEntry != m_TrackerToolToBeAttached )
+    {
+    this->RemoveTrackerToolSlot( trackerToolEntry );
+    }
+  trackerToolEntry = m_TrackerToolToBeAttached;
+  this->AddTrackerToolSlot( m_TrackerToolToBeAttached );
 
   // report to the tracker tool that the attachment has been 
   // successful
@@ -742,15 +843,12 @@ void Tracker::AttemptToUpdateStatusProcessing( void )
 
   // Set all tools to "not updated"
   //
-  typedef TrackerToolsContainerType::iterator  InputConstIterator;
-
-  InputConstIterator inputItr = m_TrackerTools.begin();
-  InputConstIterator inputEnd = m_TrackerTools.end();
-
-  while( inputItr != inputEnd )
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_ToolSlots.size() );
+  for( unsigned int slot = 0; slot < numberOfTools; slot++ )
     {
-    (inputItr->second)->SetUpdated(false);
-    ++inputItr;
+    m_ToolSlots[slot]->SetUpdated( false );
+    m_ToolUpdated[slot] = 0;
     }
  
   // wait for a new transform to be available, it would be nice if
@@ -763,7 +861,9 @@ void Tracker::AttemptToUpdateStatusProcessing( void )
     }
   else
     {
-    this->InternalThreadedUpdateStatus();
+    ResultType deviceResult = this->InternalThreadedUpdateStatus();
+    m_Telemetry->RecordDeviceSample( RealTimeClock::GetTimeStamp(),
+                                     deviceResult == SUCCESS );
     }
 
   ResultType result = this->InternalUpdateStatus();
@@ -779,76 +879,123 @@ void Tracker::UpdateStatusSuccessProcessing( void )
   igstkLogMacro( DEBUG, "igstk::Tracker::UpdateStatusSuccessProcessing "
                  "called ...\n");
 
-  typedef TrackerToolsContainerType::iterator  InputConstIterator;
-
-  InputConstIterator inputItr = m_TrackerTools.begin();
-  InputConstIterator inputEnd = m_TrackerTools.end();
+  // The tools whose pose was rejected by their filter are not updated
+  const unsigned int numberOfSlots =
+    static_cast< unsigned int >( m_ToolSlots.size() );
+  for( unsigned int slot = 0; slot < numberOfSlots; slot++ )
+    {
+    if( m_ToolUpdated[slot] && m_RawPoseRejected[slot] && m_ToolSlots[slot] )
+      {
+      m_ToolSlots[slot]->SetUpdated( false );
+      }
+    }
 
-  while( inputItr != inputEnd )
+  // The tools are only updated along with the reference tool
+  m_UpdatedSlots.clear();
+  if( !m_ApplyingReferenceTool || m_ReferenceTool->GetUpdated() )
     {
-    if ( (inputItr->second)->GetUpdated() &&
-           ( !m_ApplyingReferenceTool || m_ReferenceTool->GetUpdated() ) ) 
+    const unsigned int numberOfTools =
+      static_cast< unsigned int >( m_ToolSlots.size() );
+    for( unsigned int slot = 0; slot < numberOfTools; slot++ )
       {
-      const TransformType transform = (inputItr->second)->GetRawTransform();
+      if( m_ToolUpdated[slot] && !m_RawPoseRejected[slot] )
+        {
+        m_UpdatedSlots.push_back( slot );
+        }
+      }
+    }
 
-      const double timeToExpiration = transform.GetExpirationTime() - 
-                                      transform.GetStartTime();
+  // Compose the raw and calibration transforms of all the tools in one
+  // batch, which costs less than selecting the updated ones. The raw
+  // transforms are valid from the time of this update, read once for all
+  // of them.
+  const unsigned int numberOfUpdatedTools =
+    static_cast< unsigned int >( m_UpdatedSlots.size() );
+  if( numberOfUpdatedTools > 0 )
+    {
+    const unsigned int numberOfTools =
+      static_cast< unsigned int >( m_RawPoses.size() );
+    TransformBatch::Compose( &m_RawPoses[0], &m_CalibrationPoses[0],
+                             &m_CalibratedPoses[0], numberOfTools );
+    }
 
-      TransformType::VersorType rotationRaw;
-      TransformType::VectorType translationRaw;
+  const TimePeriodType now = RealTimeClock::GetTimeStamp();
+  for( unsigned int i = 0; i < numberOfUpdatedTools; i++ )
+    {
+    const unsigned int slot = m_UpdatedSlots[i];
 
-      translationRaw = transform.GetTranslation();
-      rotationRaw    = transform.GetRotation();
+    m_RawTimeStamps[slot].SetStartTimeAndExpireAfter(
+      now, m_RawValidityPeriods[slot] );
+    m_CalibratedErrors[slot] = m_RawErrors[slot] + m_CalibrationErrors[slot];
+    m_CalibratedTimeStamps[slot] = TimeStamp::ComputeOverlap(
+      m_RawTimeStamps[slot], m_CalibrationTimeStamps[slot] );
+    }
 
-      TransformType toolRawTransform;
-      toolRawTransform.SetTranslationAndRotation( translationRaw, rotationRaw,
-                        transform.GetError(),
-                        timeToExpiration );
+  // Report the transforms to the tools. The slots keep their place until
+  // the report is done. Outside of the main loop, the coordinate systems
+  // of the tools are set from the main loop.
+  const bool publishing =
+    m_PulseGenerator->GetEventLoop() != EventLoop::GetMainLoop();
+  m_ReportingTransforms = true;
+  for( unsigned int i = 0; i < numberOfUpdatedTools; i++ )
+    {
+    const unsigned int slot = m_UpdatedSlots[i];
 
-      (inputItr->second)->SetRawTransform( toolRawTransform );
- 
-      TransformType toolCalibrationTransform
-        = (inputItr->second)->GetCalibrationTransform();
-      
+    // The observers of the previous tools may have removed this one
+    TrackerToolType * trackerTool = m_ToolSlots[slot];
+    if( !trackerTool )
+      {
+      continue;
+      }
 
-      TransformType toolCalibratedTransform;
-      toolCalibratedTransform =
-         toolCalibratedTransform.TransformCompose( 
-            toolRawTransform, toolCalibrationTransform );
-
-      (inputItr->second)->SetCalibratedTransform( toolCalibratedTransform );
-
-      //throw an event
-      (inputItr->second)->InvokeEvent( TrackerToolTransformUpdateEvent() );
-        
-      // if a reference tracker tool has been specified, then if the tracker
-      // tool that is being updated is the selected reference tracker tool,
-      // then update the transform that is from the tracker to the
-      // reference tracker tool. Otherwise, update the transform from the
-      // tracker tool to the tracker. 
-      if( m_ApplyingReferenceTool )
-        {
-        if ( (inputItr->first) == m_ReferenceTool->GetTrackerToolIdentifier())
-          {
-          this->RequestSetTransformAndParent( 
-            toolCalibratedTransform.GetInverse(), inputItr->second );
-          }
-        else
-          {
-          (inputItr->second)->RequestSetTransformAndParent( 
-            toolCalibratedTransform, this );
-          }
-        }
-      else
-        {
-        (inputItr->second)->RequestSetTransformAndParent( 
-            toolCalibratedTransform, this );
-        }
+    TransformType toolRawTransform;
+    TransformBatch::ImportPose( m_RawPoses[slot], m_RawErrors[slot],
+                                m_RawTimeStamps[slot], toolRawTransform );
+    trackerTool->SetRawTransform( toolRawTransform );
+
+    TransformType toolCalibratedTransform;
+    TransformBatch::ImportPose( m_CalibratedPoses[slot],
+                                m_CalibratedErrors[slot],
+                                m_CalibratedTimeStamps[slot],
+                                toolCalibratedTransform );
+    trackerTool->SetCalibratedTransform( toolCalibratedTransform );
+
+    //throw an event
+    trackerTool->InvokeEvent( TrackerToolTransformUpdateEvent() );
+
+    if( publishing )
+      {
+      this->PublishTransform( trackerTool, toolCalibratedTransform );
+      }
+    else
+      {
+      this->SetToolCoordinateSystemTransform( trackerTool,
+                                              toolCalibratedTransform );
       }
-    ++inputItr;
+    }
+
+  // The main loop sets the transforms posted by this update
+  if( publishing && !m_PublishingTransforms &&
+      !m_PublishedTransforms.empty() )
+    {
+    m_PublishingTransforms = true;
+    EventLoop::GetMainLoop()->PostCall( PublishTransforms, this );
     }
 
   this->InvokeEvent( TrackerUpdateStatusEvent() );  
+
+  m_ReportingTransforms = false;
+  this->RemoveEmptyTrackerToolSlots();
+
+  // The latency includes the observers of the transforms
+  const TimePeriodType updateTime = RealTimeClock::GetTimeStamp();
+  m_Telemetry->RecordUpdate( updateTime, true );
+  if( !m_ToolUpdated.empty() )
+    {
+    m_Telemetry->RecordToolUpdates( &m_ToolUpdated[0],
+      static_cast< unsigned int >( m_ToolUpdated.size() ) );
+    }
+  this->ReportTelemetry( updateTime );
 }
 
 /** This method is called when a UpdateStatus failed */
@@ -858,6 +1005,29 @@ void Tracker::UpdateStatusFailureProcessing( void )
                  "called ...\n");
 
   this->InvokeEvent( TrackerUpdateStatusErrorEvent() );  
+
+  const TimePeriodType updateTime = RealTimeClock::GetTimeStamp();
+  m_Telemetry->RecordUpdate( updateTime, false );
+  this->ReportTelemetry( updateTime );
+}
+
+/** Invoke a telemetry event at the period of the telemetry */
+void Tracker::ReportTelemetry( TimePeriodType time )
+{
+  if( m_Telemetry->IsReportDue( time ) )
+    {
+    DeviceTelemetryReport report;
+    m_Telemetry->GetReport( report );
+
+    DeviceTelemetryEvent event;
+    event.SetReference( report );
+    this->InvokeEvent( event );
+    }
+}
+
+DeviceTelemetry * Tracker::GetTelemetry() const
+{
+  return m_Telemetry;
 }
 
 
@@ -906,6 +1076,7 @@ void Tracker::DetachAllTrackerToolsFromTracker()
   while( inputItr != inputEnd )
     {
     this->RemoveTrackerToolFromInternalDataContainers( inputItr->second ); 
+    this->RemoveTrackerToolSlot( inputItr->second );
     ++inputItr;
     }
 
@@ -972,6 +1143,8 @@ void Tracker::PrintSelf( std::ostream& os, itk::Indent indent ) const
     }
 
   os << indent << "ValidityTime: " << this->m_ValidityTime << std::endl;
+  os << indent << "Telemetry: " << std::endl;
+  this->m_Telemetry->Print( os, indent.GetNextIndent() );
   os << indent << "CoordinateSystemDelegator: ";
   this->m_CoordinateSystemDelegator->PrintSelf( os, indent );
 }
@@ -985,6 +1158,7 @@ void Tracker::SetFrequencyProcessing( void )
                  "igstk::Tracker::SetFrequencyProcessing called ...\n");
 
   this->m_PulseGenerator->RequestSetFrequency( this->m_FrequencyToBeSet );
+  this->m_Telemetry->SetNominalFrequency( this->m_FrequencyToBeSet );
 
   //Set the validity time of the transforms based on the tracker frequency
   //Add a constant to avoid any flickering effect
@@ -1035,9 +1209,230 @@ RequestRemoveTool( TrackerToolType * trackerTool )
 {
   this->m_TrackerTools.erase( trackerTool->GetTrackerToolIdentifier() );
   this->RemoveTrackerToolFromInternalDataContainers( trackerTool ); 
+  this->RemoveTrackerToolSlot( trackerTool );
   return SUCCESS;
 }
 
+/** Add a slot to the state arrays for an attached tool */
+void
+Tracker::AddTrackerToolSlot( TrackerToolType * trackerTool )
+{
+  if( trackerTool->m_TrackerToolSlot >= 0 )
+    {
+    return;
+    }
+
+  trackerTool->m_TrackerToolSlot = static_cast< int >( m_ToolSlots.size() );
+  m_ToolSlots.push_back( trackerTool );
+  m_Telemetry->AddTool( trackerTool->GetTrackerToolIdentifier() );
+
+  const TransformType & rawTransform = trackerTool->GetRawTransform();
+  Pose rawPose;
+  TransformBatch::ExportPose( rawTransform, rawPose );
+  m_RawPoses.push_back( rawPose );
+  m_RawErrors.push_back( rawTransform.GetError() );
+  m_RawValidityPeriods.push_back( rawTransform.GetExpirationTime() -
+                                  rawTransform.GetStartTime() );
+  m_ToolUpdated.push_back( trackerTool->GetUpdated() );
+  m_UnfilteredPoses.push_back( UnknownPose() );
+  m_RawPoseRejected.push_back( 0 );
+
+  const TransformType & calibrationTransform =
+    trackerTool->GetCalibrationTransform();
+  Pose calibrationPose;
+  TransformBatch::ExportPose( calibrationTransform, calibrationPose );
+  m_CalibrationPoses.push_back( calibrationPose );
+  m_CalibrationErrors.push_back( calibrationTransform.GetError() );
+  m_CalibrationTimeStamps.push_back( calibrationTransform.GetTimeStamp() );
+
+  m_RawTimeStamps.push_back( TimeStamp() );
+  m_CalibratedPoses.push_back( calibrationPose );
+  m_CalibratedErrors.push_back( ErrorType() );
+  m_CalibratedTimeStamps.push_back( TimeStamp() );
+}
+
+/** Remove the slot of a tool, or empty it while the transforms are
+ *  reported */
+void
+Tracker::RemoveTrackerToolSlot( TrackerToolType * trackerTool )
+{
+  const int slot = trackerTool->m_TrackerToolSlot;
+  if( slot < 0 || slot >= static_cast< int >( m_ToolSlots.size() ) ||
+      m_ToolSlots[slot] != trackerTool )
+    {
+    return;
+    }
+
+  trackerTool->m_TrackerToolSlot = -1;
+
+  if( m_ReportingTransforms )
+    {
+    m_ToolSlots[slot] = NULL;
+    m_EmptySlots.push_back( static_cast< unsigned int >( slot ) );
+    }
+  else
+    {
+    this->RemoveSlot( slot );
+    }
+}
+
+/** Remove the slots emptied while the transforms were reported */
+void
+Tracker::RemoveEmptyTrackerToolSlots()
+{
+  // From the last one, so that the slots moved in their place are not
+  // empty ones
+  std::sort( m_EmptySlots.begin(), m_EmptySlots.end() );
+  while( !m_EmptySlots.empty() )
+    {
+    this->RemoveSlot( m_EmptySlots.back() );
+    m_EmptySlots.pop_back();
+    }
+}
+
+/** Remove a slot, moving the last slot in its place */
+void
+Tracker::RemoveSlot( unsigned int slot )
+{
+  if( m_ToolSlots.back() )
+    {
+    m_ToolSlots.back()->m_TrackerToolSlot = slot;
+    }
+  m_Telemetry->RemoveTool( slot );
+
+  RemoveSlotFromArray( m_ToolSlots, slot );
+  RemoveSlotFromArray( m_RawPoses, slot );
+  RemoveSlotFromArray( m_RawErrors, slot );
+  RemoveSlotFromArray( m_RawValidityPeriods, slot );
+  RemoveSlotFromArray( m_ToolUpdated, slot );
+  RemoveSlotFromArray( m_UnfilteredPoses, slot );
+  RemoveSlotFromArray( m_RawPoseRejected, slot );
+  RemoveSlotFromArray( m_CalibrationPoses, slot );
+  RemoveSlotFromArray( m_CalibrationErrors, slot );
+  RemoveSlotFromArray( m_CalibrationTimeStamps, slot );
+  RemoveSlotFromArray( m_RawTimeStamps, slot );
+  RemoveSlotFromArray( m_CalibratedPoses, slot );
+  RemoveSlotFromArray( m_CalibratedErrors, slot );
+  RemoveSlotFromArray( m_CalibratedTimeStamps, slot );
+}
+
+/** Copy the calibration transform of a tool to its slot */
+void
+Tracker::SetTrackerToolCalibrationTransform( TrackerToolType * trackerTool,
+                                             const TransformType & transform )
+{
+  // Not while the transforms are composed by the event loop
+  EventLoop * eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
+
+  const int slot = trackerTool->m_TrackerToolSlot;
+  if( slot >= 0 && slot < static_cast< int >( m_ToolSlots.size() ) )
+    {
+    TransformBatch::ExportPose( transform, m_CalibrationPoses[slot] );
+    m_CalibrationErrors[slot] = transform.GetError();
+    m_CalibrationTimeStamps[slot] = transform.GetTimeStamp();
+    }
+
+  eventLoop->Unlock();
+}
+
+/** Replace the pose filter of a tool */
+void
+Tracker::SetTrackerToolPoseFilter( TrackerToolType * trackerTool,
+                                   PoseFilter * filter )
+{
+  // Not while a raw transform of the tool is filtered
+  EventLoop * eventLoop = m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
+
+  trackerTool->m_PoseFilter = filter;
+
+  // The next sample is filtered by the new filter
+  const int slot = trackerTool->m_TrackerToolSlot;
+  if( slot >= 0 && slot < static_cast< int >( m_ToolSlots.size() ) )
+    {
+    m_UnfilteredPoses[slot] = UnknownPose();
+    m_RawPoseRejected[slot] = 0;
+    }
+
+  eventLoop->Unlock();
+}
+
+/** Set the coordinate system of a tool from its calibrated transform */
+void
+Tracker::SetToolCoordinateSystemTransform( TrackerToolType * trackerTool,
+                                           const TransformType & transform )
+{
+  // if a reference tracker tool has been specified, then if the tracker
+  // tool that is being updated is the selected reference tracker tool,
+  // then update the transform that is from the tracker to the
+  // reference tracker tool. Otherwise, update the transform from the
+  // tracker tool to the tracker. 
+  if( m_ApplyingReferenceTool && trackerTool == m_ReferenceTool )
+    {
+    this->RequestSetTransformAndParent( transform.GetInverse(), trackerTool );
+    }
+  else
+    {
+    trackerTool->RequestSetTransformAndParent( transform, this );
+    }
+}
+
+/** Keep the last transform of a tool for the main loop */
+void
+Tracker::PublishTransform( TrackerToolType * trackerTool,
+                           const TransformType & transform )
+{
+  const unsigned int numberOfTransforms =
+    static_cast< unsigned int >( m_PublishedTransforms.size() );
+  for( unsigned int i = 0; i < numberOfTransforms; i++ )
+    {
+    if( m_PublishedTransforms[i].m_TrackerTool == trackerTool )
+      {
+      m_PublishedTransforms[i].m_Transform = transform;
+      return;
+      }
+    }
+
+  PublishedTransform published;
+  published.m_TrackerTool = trackerTool;
+  published.m_Transform = transform;
+  m_PublishedTransforms.push_back( published );
+}
+
+/** Set the coordinate systems of the tools from the main loop */
+void
+Tracker::PublishTransforms( void * data )
+{
+  Self * tracker = static_cast< Self * >( data );
+
+  // Not while the tracker updates or removes the tools
+  EventLoop::Pointer eventLoop = tracker->m_PulseGenerator->GetEventLoop();
+  eventLoop->Lock();
+
+  std::vector< PublishedTransform > publishedTransforms;
+  publishedTransforms.swap( tracker->m_PublishedTransforms );
+  tracker->m_PublishingTransforms = false;
+
+  const unsigned int numberOfTransforms =
+    static_cast< unsigned int >( publishedTransforms.size() );
+  for( unsigned int i = 0; i < numberOfTransforms; i++ )
+    {
+    // The tools removed meanwhile keep their coordinate system
+    TrackerToolType * trackerTool = publishedTransforms[i].m_TrackerTool;
+    const int slot = trackerTool->m_TrackerToolSlot;
+    if( slot >= 0 &&
+        slot < static_cast< int >( tracker->m_ToolSlots.size() ) &&
+        tracker->m_ToolSlots[slot] == trackerTool )
+      {
+      tracker->SetToolCoordinateSystemTransform(
+        trackerTool, publishedTransforms[i].m_Transform );
+      }
+    }
+
+  eventLoop->Unlock();
+}
+
 const Tracker::TrackerToolsContainerType &
 Tracker::GetTrackerToolContainer() const
 {
@@ -1070,6 +1465,8 @@ ITK_THREAD_RETURN_TYPE Tracker::TrackingThreadFunction(void* pInfoStruct)
   while ( activeFlag )
     {
     ResultType result = pTracker->InternalThreadedUpdateStatus();
+    pTracker->m_Telemetry->RecordDeviceSample( RealTimeClock::GetTimeStamp(),
+                                               result == SUCCESS );
     pTracker->m_ConditionNextTransformReceived->Signal();
     
     totalCount++;
@@ -1116,7 +1513,59 @@ Tracker::SetTrackerToolRawTransform(
 {
   igstkLogMacro( DEBUG, 
     "igstk::Tracker::SetTrackerToolRawTransform called...\n");
-  trackerTool->SetRawTransform( transform );
+
+  Pose pose;
+  TransformBatch::ExportPose( transform, pose );
+
+  const int slot = trackerTool->m_TrackerToolSlot;
+  PoseFilter * filter = trackerTool->m_PoseFilter;
+  if( filter && slot >= 0 )
+    {
+    // The trackers report the last sample of the device at every update,
+    // which is filtered only once: a repeated sample keeps the previous
+    // output, or its rejection.
+    if( !IsSamePose( pose, m_UnfilteredPoses[slot] ) )
+      {
+      m_UnfilteredPoses[slot] = pose;
+      m_RawPoseRejected[slot] =
+        !filter->FilterPose( pose, transform.GetStartTime() );
+      if( m_RawPoseRejected[slot] )
+        {
+        igstkLogMacro( DEBUG, "igstk::Tracker::SetTrackerToolRawTransform: "
+                       "pose of " << trackerTool->GetTrackerToolIdentifier()
+                       << " rejected\n" );
+        }
+      }
+    else
+      {
+      pose = m_RawPoses[slot];
+      }
+
+    // A rejected pose is not reported: the tool keeps its previous
+    // transform until it expires
+    if( m_RawPoseRejected[slot] )
+      {
+      return;
+      }
+
+    // The filtered transform keeps the error and validity of the measure
+    TransformType filteredTransform;
+    TransformBatch::ImportPose( pose, transform.GetError(),
+                                transform.GetTimeStamp(), filteredTransform );
+    trackerTool->SetRawTransform( filteredTransform );
+    }
+  else
+    {
+    trackerTool->SetRawTransform( transform );
+    }
+
+  if( slot >= 0 )
+    {
+    m_RawPoses[slot] = pose;
+    m_RawErrors[slot] = transform.GetError();
+    m_RawValidityPeriods[slot] = transform.GetExpirationTime() -
+                                 transform.GetStartTime();
+    }
 }
 
 /** Turn on/off update flag of the tracker tool */
@@ -1127,6 +1576,12 @@ Tracker::SetTrackerToolTransformUpdate(
   igstkLogMacro( DEBUG, 
      "igstk::Tracker::SetTrackerToolTransformUpdate called...\n");
   trackerTool->SetUpdated( flag ); 
+
+  const int slot = trackerTool->m_TrackerToolSlot;
+  if( slot >= 0 )
+    {
+    m_ToolUpdated[slot] = flag;
+    }
 }
 
 /** Report invalid request */
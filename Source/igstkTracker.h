@@ -28,7 +28,9 @@
 #include "igstkObject.h"
 #include "igstkStateMachine.h"
 #include "igstkTransform.h"
+#include "igstkTransformBatch.h"
 #include "igstkPulseGenerator.h"
+#include "igstkDeviceTelemetry.h"
 #include "igstkTrackerTool.h"
 
 #include "igstkCoordinateSystemInterfaceMacros.h"
@@ -84,6 +86,23 @@ igstkEventMacro( TrackerToolTransformUpdateEvent,          TrackerEvent);
  *  simulation of a particular device 
  *  (See SerialCommunicationSimulator).
  *
+ *  The state of the attached tools is kept in arrays with one slot per
+ *  tool, in the order of attachment, so that each update composes the
+ *  raw and calibration transforms of all the updated tools in a single
+ *  pass. The identifiers of the tools are only used to attach and remove
+ *  them. The tools are then updated, and their events invoked, in the
+ *  order of attachment.
+ *
+ *  The updates are driven by a PulseGenerator. Binding the tracker to an
+ *  EventLoop run by its own thread, with RequestSetEventLoop(), moves the
+ *  updates and the events of the tracker and of its tools out of the GUI
+ *  thread. The requests of this class lock the event loop, so they can be
+ *  made from the GUI thread while the tracker is updated by the loop.
+ *  The coordinate systems of the tools, which the views read from the GUI
+ *  thread, are still set from the main loop: the last transform of each
+ *  tool is posted to it, so that the TrackerToolTransformUpdateEvent
+ *  observers may run before the coordinate system of the tool is updated.
+ *
  *  The following diagram illustrates the state machine of 
  *  the tracker class
  *
@@ -135,6 +154,12 @@ public:
    * follow, then you will start receiving transforms with repeated values. */
   void RequestSetFrequency( double frequencyInHz );
 
+  /** The "RequestSetEventLoop" method defines the event loop from which the
+   * tracker is updated. By default this is the main loop of the
+   * application. From another loop, the coordinate systems of the tools
+   * are still set from the main loop. */
+  void RequestSetEventLoop( EventLoop * eventLoop );
+
   /** Set a reference tracker tool */
   void RequestSetReferenceTool( TrackerToolType * trackerTool );
 
@@ -144,6 +169,11 @@ public:
   /** GetThreadingEnabled(bool) : get m_ThreadingEnabled value  */
   igstkGetMacro( ThreadingEnabled, bool );
 
+  /** Telemetry of the tracker: rates, errors, jitter, latency and
+   *  visibility of the tools. While tracking, the tracker invokes a
+   *  DeviceTelemetryEvent every report period of the telemetry. */
+  DeviceTelemetry * GetTelemetry() const;
+
 protected:
 
   Tracker(void);
@@ -202,6 +232,11 @@ protected:
       and responsible for device-specific processing */
   virtual ResultType InternalThreadedUpdateStatus( void ) = 0;
 
+  /** Update the status of the tools at once, as a pulse of the event loop
+   *  would, from the thread of the caller. Meant for the trackers driven
+   *  without pulse generator, such as the ones of benchmarks and tests. */
+  void RequestUpdateStatus( void );
+
   /** Print the object information in a stream. */
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const; 
 
@@ -299,6 +334,93 @@ private:
   bool                                m_ApplyingReferenceTool;
   TrackerToolPointer                  m_ReferenceTool;
 
+  /** State of the attached tools, one array per field and one slot per
+   *  tool. The arrays are written by SetTrackerToolRawTransform() and
+   *  SetTrackerToolTransformUpdate(), and by the tools when their
+   *  calibration changes. */
+  typedef TransformType::ErrorType                   ErrorType;
+
+  std::vector< TrackerToolType * >    m_ToolSlots;
+  std::vector< Pose >                 m_RawPoses;
+  std::vector< ErrorType >            m_RawErrors;
+  std::vector< TimePeriodType >       m_RawValidityPeriods;
+  std::vector< Pose >                 m_CalibrationPoses;
+  std::vector< ErrorType >            m_CalibrationErrors;
+  std::vector< TimeStamp >            m_CalibrationTimeStamps;
+
+  /** Updated flags of the slots. They are set along with the flags of the
+   *  tools by SetTrackerToolTransformUpdate(), which the trackers call
+   *  from const methods, hence mutable. */
+  mutable std::vector< unsigned char > m_ToolUpdated;
+
+  /** Last sample passed to the pose filter of each slot, so that the
+   *  samples repeated by the updates are filtered once, and whether the
+   *  filter rejected it */
+  std::vector< Pose >                 m_UnfilteredPoses;
+  std::vector< unsigned char >        m_RawPoseRejected;
+
+  /** Results of the composition. The poses of all the slots are composed
+   *  by TransformBatch, the other fields only for the slots updated by
+   *  the last update. */
+  std::vector< unsigned int >         m_UpdatedSlots;
+  std::vector< TimeStamp >            m_RawTimeStamps;
+  std::vector< Pose >                 m_CalibratedPoses;
+  std::vector< ErrorType >            m_CalibratedErrors;
+  std::vector< TimeStamp >            m_CalibratedTimeStamps;
+
+  /** Add a slot for an attached tool, and remove it. The last slot is
+   *  moved to the removed one. While the transforms are reported, the
+   *  observers of which can remove tools, the slots keep their place:
+   *  the slot of a removed tool is emptied, and removed by
+   *  RemoveEmptyTrackerToolSlots() once the report is done. */
+  void AddTrackerToolSlot( TrackerToolType * trackerTool );
+  void RemoveTrackerToolSlot( TrackerToolType * trackerTool );
+  void RemoveSlot( unsigned int slot );
+  void RemoveEmptyTrackerToolSlots();
+
+  bool                                m_ReportingTransforms;
+  std::vector< unsigned int >         m_EmptySlots;
+
+  /** Transforms of the coordinate systems of the tools computed by the
+   *  updates made from an event loop other than the main one. They are
+   *  set from the main loop, which reads the coordinate systems to render
+   *  them, by PublishTransforms(). Only the last transform of each tool is
+   *  kept until then. Protected by the lock of the event loop of the
+   *  tracker. */
+  struct PublishedTransform
+    {
+    TrackerToolPointer                m_TrackerTool;
+    TransformType                     m_Transform;
+    };
+  std::vector< PublishedTransform >   m_PublishedTransforms;
+  bool                                m_PublishingTransforms;
+
+  /** Keep the transform of a tool until the main loop sets it */
+  void PublishTransform( TrackerToolType * trackerTool,
+                         const TransformType & transform );
+
+  /** Set the transform of the coordinate system of a tool to the tracker,
+   *  or of the tracker to the reference tool */
+  void SetToolCoordinateSystemTransform( TrackerToolType * trackerTool,
+                                         const TransformType & transform );
+
+  /** Called from the main loop to set the published transforms */
+  static void PublishTransforms( void * tracker );
+
+  /** Invoke a DeviceTelemetryEvent if one is due */
+  void ReportTelemetry( TimePeriodType time );
+
+  /** Health and throughput of the tracking */
+  DeviceTelemetry::Pointer            m_Telemetry;
+
+  /** Called by the tools when their calibration transform is set */
+  void SetTrackerToolCalibrationTransform( TrackerToolType * trackerTool,
+                                           const TransformType & transform );
+
+  /** Called by the tools when their pose filter is set */
+  void SetTrackerToolPoseFilter( TrackerToolType * trackerTool,
+                                 PoseFilter * filter );
+
   /** Validity time, and its default value [milliseconds] */
   TimePeriodType                      m_ValidityTime;
 
@@ -0,0 +1,560 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTrackerObserverToOpenIGTLinkBroadcaster.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// Disabling warning C4355: 'this' : used in base member initializer list
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4355 )
+#endif
+
+#include "igstkTrackerObserverToOpenIGTLinkBroadcaster.h"
+
+#include "igstkEvents.h"
+
+namespace igstk
+{
+
+/** Constructor */
+TrackerObserverToOpenIGTLinkBroadcaster::
+TrackerObserverToOpenIGTLinkBroadcaster():m_StateMachine(this)
+{
+  this->m_ToolObserver = ObserverType::New();
+  this->m_ToolObserver->SetCallbackFunction( this,
+                                     &Self::StoreToolTransform );
+
+  this->m_TrackerObserver = ObserverType::New();
+  this->m_TrackerObserver->SetCallbackFunction( this,
+                                     &Self::EnqueueBatch );
+
+  this->m_QueueCondition = itk::ConditionVariable::New();
+
+  this->m_MaximumQueueSize = 16;
+  this->m_DropPolicy = DropOldest;
+  this->m_NumberOfDroppedBatches = 0;
+  this->m_NumberOfSentBatches = 0;
+
+  this->m_Running = false;
+  this->m_StopRequested = false;
+
+  this->m_Threader = itk::MultiThreader::New();
+  this->m_ThreadID = -1;
+
+  this->m_TrackingDataMessage = igtl::TrackingDataMessage::New();
+  this->m_TrackingDataMessage->SetDeviceName("Tracker");
+
+  this->m_PortToBeAdded = 0;
+
+  // Set the state descriptors
+  igstkAddStateMacro( Idle );
+  igstkAddStateMacro( Broadcasting );
+
+  // Set the input descriptors
+  igstkAddInputMacro( SetTracker );
+  igstkAddInputMacro( AddTrackerTool );
+  igstkAddInputMacro( AddSubscriber );
+  igstkAddInputMacro( SetDeviceName );
+  igstkAddInputMacro( Start );
+  igstkAddInputMacro( Stop );
+
+  // The broadcast is configured while idle
+  igstkAddTransitionMacro( Idle, SetTracker, Idle, SetTracker );
+  igstkAddTransitionMacro( Idle, AddTrackerTool, Idle, AddTrackerTool );
+  igstkAddTransitionMacro( Idle, AddSubscriber, Idle, AddSubscriber );
+  igstkAddTransitionMacro( Idle, SetDeviceName, Idle, SetDeviceName );
+  igstkAddTransitionMacro( Idle, Start, Broadcasting, Start );
+  igstkAddTransitionMacro( Idle, Stop, Idle, No );
+
+  // The tools, the subscribers and the message are shared with the writer
+  // thread while broadcasting
+  igstkAddTransitionMacro( Broadcasting, SetTracker,
+                           Broadcasting, ReportInvalidRequest );
+  igstkAddTransitionMacro( Broadcasting, AddTrackerTool,
+                           Broadcasting, ReportInvalidRequest );
+  igstkAddTransitionMacro( Broadcasting, AddSubscriber,
+                           Broadcasting, ReportInvalidRequest );
+  igstkAddTransitionMacro( Broadcasting, SetDeviceName,
+                           Broadcasting, ReportInvalidRequest );
+  igstkAddTransitionMacro( Broadcasting, Start, Broadcasting, No );
+  igstkAddTransitionMacro( Broadcasting, Stop, Idle, Stop );
+
+  // Select the initial state of the state machine
+  igstkSetInitialStateMacro( Idle );
+
+  // Finish the programming and get ready to run
+  m_StateMachine.SetReadyToRun();
+}
+
+TrackerObserverToOpenIGTLinkBroadcaster::
+~TrackerObserverToOpenIGTLinkBroadcaster()
+{
+  this->RequestStop();
+
+  while( !this->m_Queue.empty() )
+    {
+    delete this->m_Queue.front();
+    this->m_Queue.pop_front();
+    }
+
+  for( unsigned int i = 0; i < this->m_FreeBatches.size(); i++ )
+    {
+    delete this->m_FreeBatches[i];
+    }
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestSetTracker(
+                                                      const Tracker * tracker )
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestSetTracker called...\n" );
+  this->m_TrackerToBeSet = tracker;
+  igstkPushInputMacro( SetTracker );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestAddTrackerTool(
+                   const TrackerTool * trackerTool, const char * elementName )
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestAddTrackerTool called...\n" );
+  this->m_TrackerToolToBeAdded = trackerTool;
+  this->m_ElementNameToBeAdded = elementName;
+  igstkPushInputMacro( AddTrackerTool );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestAddSubscriber(
+                                          const char * hostname, int port )
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestAddSubscriber called...\n" );
+  this->m_HostNameToBeAdded = hostname;
+  this->m_PortToBeAdded = port;
+  igstkPushInputMacro( AddSubscriber );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestSetDeviceName(
+                                                   const char * devicename )
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestSetDeviceName called...\n" );
+  this->m_DeviceNameToBeSet = devicename;
+  igstkPushInputMacro( SetDeviceName );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestStart()
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestStart called...\n" );
+  igstkPushInputMacro( Start );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::RequestStop()
+{
+  igstkLogMacro( DEBUG, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "RequestStop called...\n" );
+  igstkPushInputMacro( Stop );
+  this->m_StateMachine.ProcessInputs();
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::SetTrackerProcessing()
+{
+  this->m_Tracker = this->m_TrackerToBeSet;
+  this->m_Tracker->AddObserver( TrackerUpdateStatusEvent(),
+                                this->m_TrackerObserver );
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::AddTrackerToolProcessing()
+{
+  ToolEntry entry;
+  entry.m_TrackerTool = this->m_TrackerToolToBeAdded;
+  entry.m_ElementName = this->m_ElementNameToBeAdded;
+  entry.m_Pose.m_ToolIndex = this->m_Tools.size();
+  entry.m_Updated = false;
+  this->m_Tools.push_back( entry );
+
+  this->m_TrackerToolToBeAdded->AddObserver(
+    TrackerToolTransformUpdateEvent(), this->m_ToolObserver );
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::AddSubscriberProcessing()
+{
+  Subscriber subscriber;
+  subscriber.m_HostName = this->m_HostNameToBeAdded;
+  subscriber.m_Port = this->m_PortToBeAdded;
+  subscriber.m_Socket = igtl::ClientSocket::New();
+  subscriber.m_Connected = false;
+  this->m_Subscribers.push_back( subscriber );
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::SetDeviceNameProcessing()
+{
+  this->m_TrackingDataMessage->SetDeviceName(
+    this->m_DeviceNameToBeSet.c_str() );
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::StartProcessing()
+{
+  for( unsigned int i = 0; i < this->m_Subscribers.size(); i++ )
+    {
+    Subscriber & subscriber = this->m_Subscribers[i];
+    char * hostname = const_cast< char * >( subscriber.m_HostName.c_str() );
+    int r = subscriber.m_Socket->ConnectToServer( hostname,
+                                                  subscriber.m_Port );
+    subscriber.m_Connected = ( r == 0 );
+    if( !subscriber.m_Connected )
+      {
+      igstkLogMacro( WARNING, "Cannot connect to subscriber "
+                     << subscriber.m_HostName << ":"
+                     << subscriber.m_Port << "\n" );
+      }
+    }
+
+  // One element per tool, created once and updated for every message
+  this->m_Elements.clear();
+  for( unsigned int i = 0; i < this->m_Tools.size(); i++ )
+    {
+    igtl::TrackingDataElement::Pointer element =
+                                          igtl::TrackingDataElement::New();
+    element->SetName( this->m_Tools[i].m_ElementName.c_str() );
+    element->SetType( igtl::TrackingDataElement::TYPE_6D );
+    this->m_Elements.push_back( element );
+    }
+
+  this->m_StopRequested = false;
+  this->m_Running = true;
+  this->m_ThreadID = this->m_Threader->SpawnThread( WriterThreadFunction,
+                                                    this );
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::StopProcessing()
+{
+  this->m_QueueLock.Lock();
+  this->m_StopRequested = true;
+  this->m_QueueLock.Unlock();
+  this->m_QueueCondition->Broadcast();
+
+  this->m_Threader->TerminateThread( this->m_ThreadID );
+  this->m_Running = false;
+
+  for( unsigned int i = 0; i < this->m_Subscribers.size(); i++ )
+    {
+    if( this->m_Subscribers[i].m_Connected )
+      {
+      this->m_Subscribers[i].m_Socket->CloseSocket();
+      this->m_Subscribers[i].m_Connected = false;
+      }
+    }
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::NoProcessing()
+{
+}
+
+
+void
+TrackerObserverToOpenIGTLinkBroadcaster::ReportInvalidRequestProcessing()
+{
+  igstkLogMacro( WARNING, "igstk::TrackerObserverToOpenIGTLinkBroadcaster::"
+                 "ReportInvalidRequestProcessing: the broadcast cannot be "
+                 "changed while it runs\n" );
+}
+
+
+unsigned long
+TrackerObserverToOpenIGTLinkBroadcaster::GetNumberOfDroppedBatches() const
+{
+  TrackerObserverToOpenIGTLinkBroadcaster * self =
+    const_cast< TrackerObserverToOpenIGTLinkBroadcaster * >( this );
+  self->m_QueueLock.Lock();
+  const unsigned long dropped = this->m_NumberOfDroppedBatches;
+  self->m_QueueLock.Unlock();
+  return dropped;
+}
+
+
+unsigned long
+TrackerObserverToOpenIGTLinkBroadcaster::GetNumberOfSentBatches() const
+{
+  TrackerObserverToOpenIGTLinkBroadcaster * self =
+    const_cast< TrackerObserverToOpenIGTLinkBroadcaster * >( this );
+  self->m_QueueLock.Lock();
+  const unsigned long sent = this->m_NumberOfSentBatches;
+  self->m_QueueLock.Unlock();
+  return sent;
+}
+
+
+/** Keep the latest transform of a tool until the end of the tracker cycle */
+void
+TrackerObserverToOpenIGTLinkBroadcaster::StoreToolTransform(
+              itk::Object * caller, const itk::EventObject & event )
+{
+  if( !TrackerToolTransformUpdateEvent().CheckEvent( &event ) )
+    {
+    return;
+    }
+
+  for( unsigned int i = 0; i < this->m_Tools.size(); i++ )
+    {
+    ToolEntry & entry = this->m_Tools[i];
+
+    if( entry.m_TrackerTool.GetPointer() != caller )
+      {
+      continue;
+      }
+
+    // Set before the event, from the event loop of the tracker
+    const Transform & transform =
+      entry.m_TrackerTool->GetCalibratedTransform();
+
+    const Transform::VersorType::MatrixType rotation =
+                                   transform.GetRotation().GetMatrix();
+    const Transform::VectorType translation = transform.GetTranslation();
+
+    for( unsigned int r = 0; r < 3; r++ )
+      {
+      for( unsigned int c = 0; c < 3; c++ )
+        {
+        entry.m_Pose.m_Matrix[r][c] = static_cast<float>( rotation[r][c] );
+        }
+      entry.m_Pose.m_Matrix[r][3] = static_cast<float>( translation[r] );
+      }
+
+    entry.m_Updated = true;
+    break;
+    }
+}
+
+
+/** Hand the tools updated in this tracker cycle over to the writer thread */
+void
+TrackerObserverToOpenIGTLinkBroadcaster::EnqueueBatch(
+              itk::Object * itkNotUsed(caller),
+              const itk::EventObject & itkNotUsed(event) )
+{
+  if( !this->m_Running )
+    {
+    return;
+    }
+
+  this->m_QueueLock.Lock();
+
+  BatchType * batch = NULL;
+
+  if( this->m_Queue.size() >= this->m_MaximumQueueSize )
+    {
+    this->m_NumberOfDroppedBatches++;
+    if( this->m_DropPolicy == DropNewest || this->m_Queue.empty() )
+      {
+      this->m_QueueLock.Unlock();
+      for( unsigned int i = 0; i < this->m_Tools.size(); i++ )
+        {
+        this->m_Tools[i].m_Updated = false;
+        }
+      return;
+      }
+    batch = this->m_Queue.front();
+    this->m_Queue.pop_front();
+    }
+  else if( !this->m_FreeBatches.empty() )
+    {
+    batch = this->m_FreeBatches.back();
+    this->m_FreeBatches.pop_back();
+    }
+  else
+    {
+    batch = new BatchType;
+    batch->reserve( this->m_Tools.size() );
+    }
+
+  this->m_QueueLock.Unlock();
+
+  // The batch is not shared while it is being filled
+  batch->clear();
+  for( unsigned int i = 0; i < this->m_Tools.size(); i++ )
+    {
+    if( this->m_Tools[i].m_Updated )
+      {
+      batch->push_back( this->m_Tools[i].m_Pose );
+      this->m_Tools[i].m_Updated = false;
+      }
+    }
+
+  this->m_QueueLock.Lock();
+  if( batch->empty() )
+    {
+    this->m_FreeBatches.push_back( batch );
+    this->m_QueueLock.Unlock();
+    return;
+    }
+  this->m_Queue.push_back( batch );
+  this->m_QueueLock.Unlock();
+
+  this->m_QueueCondition->Signal();
+}
+
+
+/** Thread function for sending the batches */
+ITK_THREAD_RETURN_TYPE
+TrackerObserverToOpenIGTLinkBroadcaster::WriterThreadFunction(
+                                                          void * pInfoStruct )
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo =
+    (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+
+  if( pInfo == NULL )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  if( pInfo->UserData == NULL )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  Self * broadcaster = (Self*)pInfo->UserData;
+
+  while( true )
+    {
+    broadcaster->m_QueueLock.Lock();
+    while( broadcaster->m_Queue.empty() && !broadcaster->m_StopRequested )
+      {
+      broadcaster->m_QueueCondition->Wait( &broadcaster->m_QueueLock );
+      }
+
+    if( broadcaster->m_StopRequested )
+      {
+      broadcaster->m_QueueLock.Unlock();
+      break;
+      }
+
+    BatchType * batch = broadcaster->m_Queue.front();
+    broadcaster->m_Queue.pop_front();
+    broadcaster->m_QueueLock.Unlock();
+
+    broadcaster->SendBatch( *batch );
+
+    broadcaster->m_QueueLock.Lock();
+    broadcaster->m_FreeBatches.push_back( batch );
+    broadcaster->m_NumberOfSentBatches++;
+    broadcaster->m_QueueLock.Unlock();
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/** Pack a batch and send it. Called only from the writer thread. */
+void
+TrackerObserverToOpenIGTLinkBroadcaster::SendBatch( const BatchType & batch )
+{
+  this->m_TrackingDataMessage->ClearTrackingDataElements();
+
+  for( unsigned int i = 0; i < batch.size(); i++ )
+    {
+    const ToolPose & pose = batch[i];
+
+    igtl::Matrix4x4 matrix;
+    for( unsigned int r = 0; r < 3; r++ )
+      {
+      for( unsigned int c = 0; c < 4; c++ )
+        {
+        matrix[r][c] = pose.m_Matrix[r][c];
+        }
+      }
+    matrix[3][0] = 0.0;
+    matrix[3][1] = 0.0;
+    matrix[3][2] = 0.0;
+    matrix[3][3] = 1.0;
+
+    igtl::TrackingDataElement::Pointer element =
+                                         this->m_Elements[pose.m_ToolIndex];
+    element->SetMatrix( matrix );
+    this->m_TrackingDataMessage->AddTrackingDataElement( element );
+    }
+
+  this->m_TrackingDataMessage->Pack();
+
+  for( unsigned int i = 0; i < this->m_Subscribers.size(); i++ )
+    {
+    Subscriber & subscriber = this->m_Subscribers[i];
+    if( !subscriber.m_Connected )
+      {
+      continue;
+      }
+
+    int r = subscriber.m_Socket->Send(
+                       this->m_TrackingDataMessage->GetPackPointer(),
+                       this->m_TrackingDataMessage->GetPackSize() );
+    if( r == 0 )
+      {
+      // The subscriber went away, stop sending to it.
+      subscriber.m_Socket->CloseSocket();
+      subscriber.m_Connected = false;
+      }
+    }
+}
+
+
+/** Print Self function */
+void TrackerObserverToOpenIGTLinkBroadcaster::PrintSelf(
+                                   std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Number of tools: " << this->m_Tools.size() << std::endl;
+  for( unsigned int i = 0; i < this->m_Subscribers.size(); i++ )
+    {
+    os << indent << "Subscriber: " << this->m_Subscribers[i].m_HostName
+       << ":" << this->m_Subscribers[i].m_Port << std::endl;
+    }
+  os << indent << "MaximumQueueSize: " << this->m_MaximumQueueSize
+     << std::endl;
+  os << indent << "DropPolicy: " << this->m_DropPolicy << std::endl;
+  os << indent << "NumberOfDroppedBatches: "
+     << this->m_NumberOfDroppedBatches << std::endl;
+  os << indent << "NumberOfSentBatches: "
+     << this->m_NumberOfSentBatches << std::endl;
+}
+
+}
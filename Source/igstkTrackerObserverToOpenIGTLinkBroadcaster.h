@@ -0,0 +1,237 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTrackerObserverToOpenIGTLinkBroadcaster.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkTrackerObserverToOpenIGTLinkBroadcaster_h
+#define __igstkTrackerObserverToOpenIGTLinkBroadcaster_h
+
+#include "igstkObject.h"
+#include "igstkMacros.h"
+#include "igstkStateMachine.h"
+#include "igstkTracker.h"
+#include "igstkTrackerTool.h"
+
+#include "itkMultiThreader.h"
+#include "itkConditionVariable.h"
+#include "itkMutexLock.h"
+
+#include "igtlOSUtil.h"
+#include "igtlTrackingDataMessage.h"
+#include "igtlClientSocket.h"
+
+#include <deque>
+#include <vector>
+
+
+namespace igstk
+{
+/** \class TrackerObserverToOpenIGTLinkBroadcaster
+ *
+ *  \brief This class observes a Tracker and broadcasts the transforms of all
+ *  its tools through OpenIGTLink TDATA (tracking data) messages.
+ *
+ *  Transforms of the tools registered with RequestAddTrackerTool() are
+ *  collected while the tracker updates, and every TrackerUpdateStatusEvent
+ *  produces a single TDATA message holding all the tools updated in that
+ *  cycle. The messages are packed and sent by a dedicated writer thread, so
+ *  the thread that fires the tracker events never blocks on the network.
+ *
+ *  Pending batches are held in a queue of bounded size. When the writer
+ *  thread falls behind, either the oldest or the newest batch is dropped,
+ *  depending on the drop policy. Every batch is sent to all the subscribers
+ *  added with RequestAddSubscriber().
+ *
+ */
+
+class TrackerObserverToOpenIGTLinkBroadcaster  : public Object
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( TrackerObserverToOpenIGTLinkBroadcaster,
+                                 Object )
+
+public:
+
+  /** Policy applied when a batch arrives and the queue is full */
+  typedef enum
+    {
+    DropOldest = 0,
+    DropNewest
+    } DropPolicyType;
+
+  /** Set the tracker whose update cycles delimit the batches */
+  void RequestSetTracker( const Tracker * tracker );
+
+  /** Add a tool to the broadcast. The transform of the tool is sent in the
+   *  TDATA element with the given name. */
+  void RequestAddTrackerTool( const TrackerTool * trackerTool,
+                              const char * elementName );
+
+  /** Add a subscriber. A connection is opened to hostname:port when the
+   *  broadcast starts. */
+  void RequestAddSubscriber( const char * hostname, int port );
+
+  /** Set the device name used in the TDATA messages */
+  void RequestSetDeviceName( const char * devicename );
+
+  /** Maximum number of batches waiting to be sent. Default is 16. */
+  igstkSetMacro( MaximumQueueSize, unsigned int );
+  igstkGetMacro( MaximumQueueSize, unsigned int );
+
+  /** Policy applied when the queue is full. Default is DropOldest. */
+  igstkSetMacro( DropPolicy, DropPolicyType );
+  igstkGetMacro( DropPolicy, DropPolicyType );
+
+  /** Connect to the subscribers and start the writer thread */
+  void RequestStart();
+
+  /** Stop the writer thread and close the connections */
+  void RequestStop();
+
+  /** Number of batches dropped because the queue was full */
+  unsigned long GetNumberOfDroppedBatches() const;
+
+  /** Number of TDATA messages sent */
+  unsigned long GetNumberOfSentBatches() const;
+
+protected:
+
+  /** Constructor is protected in order to enforce
+   *  the use of the New() operator */
+  TrackerObserverToOpenIGTLinkBroadcaster(void);
+
+  virtual ~TrackerObserverToOpenIGTLinkBroadcaster(void);
+
+  /** Print the object information. */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+  void StoreToolTransform(
+    itk::Object * caller, const itk::EventObject & event );
+
+  void EnqueueBatch(
+    itk::Object * caller, const itk::EventObject & event );
+
+  typedef itk::MemberCommand< TrackerObserverToOpenIGTLinkBroadcaster >
+                                                                   ObserverType;
+
+private:
+
+  TrackerObserverToOpenIGTLinkBroadcaster(const Self&); //purposely not
+                                                        //implemented
+  void operator=(const Self&);   //purposely not implemented
+
+  /** Pose of one tool, stored as the upper 3x4 part of the matrix */
+  struct ToolPose
+    {
+    unsigned int  m_ToolIndex;
+    float         m_Matrix[3][4];
+    };
+
+  typedef std::vector< ToolPose >    BatchType;
+
+  /** Per tool bookkeeping. Only touched from the tracker event thread. */
+  struct ToolEntry
+    {
+    TrackerTool::ConstPointer  m_TrackerTool;
+    std::string                m_ElementName;
+    ToolPose                   m_Pose;
+    bool                       m_Updated;
+    };
+
+  struct Subscriber
+    {
+    std::string                  m_HostName;
+    int                          m_Port;
+    igtl::ClientSocket::Pointer  m_Socket;
+    bool                         m_Connected;
+    };
+
+  /** List of states */
+  igstkDeclareStateMacro( Idle );
+  igstkDeclareStateMacro( Broadcasting );
+
+  /** List of inputs */
+  igstkDeclareInputMacro( SetTracker );
+  igstkDeclareInputMacro( AddTrackerTool );
+  igstkDeclareInputMacro( AddSubscriber );
+  igstkDeclareInputMacro( SetDeviceName );
+  igstkDeclareInputMacro( Start );
+  igstkDeclareInputMacro( Stop );
+
+  /** Methods invoked by the state machine */
+  void SetTrackerProcessing();
+  void AddTrackerToolProcessing();
+  void AddSubscriberProcessing();
+  void SetDeviceNameProcessing();
+  void StartProcessing();
+  void StopProcessing();
+  void NoProcessing();
+  void ReportInvalidRequestProcessing();
+
+  /** Arguments of the requests, used by the state machine */
+  Tracker::ConstPointer       m_TrackerToBeSet;
+  TrackerTool::ConstPointer   m_TrackerToolToBeAdded;
+  std::string                 m_ElementNameToBeAdded;
+  std::string                 m_HostNameToBeAdded;
+  int                         m_PortToBeAdded;
+  std::string                 m_DeviceNameToBeSet;
+
+  /** Thread function for sending the batches */
+  static ITK_THREAD_RETURN_TYPE WriterThreadFunction( void * pInfoStruct );
+
+  /** Pack a batch into the TDATA message and send it to every subscriber */
+  void SendBatch( const BatchType & batch );
+
+  ObserverType::Pointer       m_ToolObserver;
+
+  ObserverType::Pointer       m_TrackerObserver;
+
+  Tracker::ConstPointer       m_Tracker;
+
+  std::vector< ToolEntry >    m_Tools;
+
+  std::vector< Subscriber >   m_Subscribers;
+
+  /** Queue of batches shared with the writer thread. Batches are recycled
+   *  through m_FreeBatches to avoid allocations once running. */
+  std::deque< BatchType * >   m_Queue;
+  std::vector< BatchType * >  m_FreeBatches;
+
+  itk::SimpleMutexLock             m_QueueLock;
+  itk::ConditionVariable::Pointer  m_QueueCondition;
+
+  unsigned int                m_MaximumQueueSize;
+  DropPolicyType              m_DropPolicy;
+  unsigned long               m_NumberOfDroppedBatches;
+  unsigned long               m_NumberOfSentBatches;
+
+  bool                        m_Running;
+  bool                        m_StopRequested;
+
+  itk::MultiThreader::Pointer m_Threader;
+  int                         m_ThreadID;
+
+  /** Used only by the writer thread */
+  igtl::TrackingDataMessage::Pointer                  m_TrackingDataMessage;
+  std::vector< igtl::TrackingDataElement::Pointer >   m_Elements;
+
+};
+
+} // end of namespace igstk
+
+#endif //__igstk_TrackerObserverToOpenIGTLinkBroadcaster_h_
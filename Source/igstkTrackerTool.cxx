@@ -39,6 +39,7 @@ TrackerTool::TrackerTool(void):m_StateMachine(this)
   this->m_CalibrationTransform.SetToIdentity( longestPossibleTime );  
 
   this->m_Updated = false; // not yet updated
+  this->m_TrackerToolSlot = -1;
 
   // States
   igstkAddStateMacro( Idle );
@@ -483,6 +484,39 @@ void
 TrackerTool::SetCalibrationTransform( const TransformType & transform )
 {
   this->m_CalibrationTransform = transform;
+
+  // The tracker keeps its own copy for composing the transforms
+  if( this->m_TrackerToolSlot >= 0 )
+    {
+    this->m_TrackerToAttachTo->SetTrackerToolCalibrationTransform( this,
+                                                                 transform );
+    }
+}
+
+/** Method to set the filter of the raw transforms */
+void
+TrackerTool::SetPoseFilter( PoseFilter * filter )
+{
+  if( filter )
+    {
+    filter->Reset();
+    }
+
+  // The tracker may be filtering a transform of the tool
+  if( this->m_TrackerToolSlot >= 0 )
+    {
+    this->m_TrackerToAttachTo->SetTrackerToolPoseFilter( this, filter );
+    }
+  else
+    {
+    this->m_PoseFilter = filter;
+    }
+}
+
+PoseFilter *
+TrackerTool::GetPoseFilter() const
+{
+  return this->m_PoseFilter;
 }
 
 /** Method to set the raw transform for the tracker tool
@@ -508,7 +542,7 @@ TrackerTool::SetCalibratedTransform( const TransformType & transform )
     this->m_TrackerToAttachTo);
 
   CoordinateSystemTransformToEvent  transformEvent;
-  transformEvent.Set( transformCarrier );
+  transformEvent.SetReference( transformCarrier );
 
   this->InvokeEvent( transformEvent );
 }
@@ -523,6 +557,15 @@ void TrackerTool::PrintSelf( std::ostream& os, itk::Indent indent ) const
                << this->m_CalibrationTransform << std::endl;
   os << indent << "Calibrated raw transform: "
                << this->m_CalibratedTransform << std::endl;
+  os << indent << "PoseFilter: ";
+  if( this->m_PoseFilter )
+    {
+    os << this->m_PoseFilter->GetNameOfClass() << std::endl;
+    }
+  else
+    {
+    os << "NULL" << std::endl;
+    }
   os << indent << "CoordinateSystemDelegator: ";
   this->m_CoordinateSystemDelegator->PrintSelf( os, indent );
 
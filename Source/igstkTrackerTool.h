@@ -20,6 +20,7 @@
 
 #include "igstkObject.h"
 #include "igstkTransform.h"
+#include "igstkPoseFilter.h"
 #include "igstkMacros.h"
 #include "igstkStateMachine.h"
 #include "igstkCoordinateSystemInterfaceMacros.h"
@@ -89,6 +90,22 @@ public:
   /**  Set the calibration transform for this tool. */
   void SetCalibrationTransform( const TransformType & );
 
+  /** Set the filter of the raw transforms of this tool, or NULL to use
+   *  them as they are measured. The filter is reset, and is then used by
+   *  the tracker from its event loop, once per update of the tracker and
+   *  with the time of the update. The last sample of the device, reported
+   *  again by the updates until the next one arrives, is filtered once.
+   *  When the filter rejects a sample, the tool is not updated and keeps
+   *  its previous transform until it expires. */
+  void SetPoseFilter( PoseFilter * filter );
+  PoseFilter * GetPoseFilter() const;
+
+  /** Get the calibrated transform of the last update of the tracker. It is
+   *  meant for the observers of TrackerToolTransformUpdateEvent, invoked
+   *  from the event loop of the tracker before the coordinate system of
+   *  the tool is set. */
+  igstkGetMacro( CalibratedTransform, TransformType );
+
   /** Get whether the tool was updated during tracker UpdateStatus() */
   igstkGetMacro( Updated, bool );
  
@@ -238,6 +255,9 @@ private:
   /** Calibration transform for the tool */
   TransformType                 m_CalibrationTransform; 
 
+  /** Filter of the raw transforms */
+  PoseFilter::Pointer           m_PoseFilter;
+
   /** Calibrated raw transform for the tool */
   TransformType                 m_CalibratedTransform; 
 
@@ -253,6 +273,10 @@ private:
   /** Tracker to which the tool will be attached to */
   Tracker        * m_TrackerToAttachTo;
 
+  /** Index of the tool in the state arrays of the tracker it is attached
+   *  to, or -1 while it is not attached */
+  int                m_TrackerToolSlot;
+
   /** Define the coordinate system interface 
    */
   igstkCoordinateSystemClassInterfaceMacro();
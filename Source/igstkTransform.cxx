@@ -44,7 +44,8 @@ Transform
 
 Transform 
 Transform
-::TransformCompose( Transform leftTransform, Transform rightTransform )
+::TransformCompose( const Transform & leftTransform,
+                    const Transform & rightTransform )
 {
   VersorType rotation;
   VectorType translation;
@@ -99,6 +100,21 @@ Transform
 }
 
 
+void 
+Transform
+::SetTranslationAndRotation(
+          const  VectorType & translation,
+          const  VersorType & rotation,
+          TransformBase::ErrorType errorValue,
+          const  TimeStamp & timeStamp )
+{
+  m_TimeStamp   = timeStamp;
+  m_Translation = translation;
+  m_Rotation    = rotation;
+  m_Error       = errorValue;
+}
+
+
 void 
 Transform
 ::SetTranslation(
@@ -70,8 +70,8 @@ public:
   virtual ~Transform();
 
   /** Transform composition method */
-  static Transform TransformCompose( Transform leftTransform, 
-                                     Transform rightTransform );
+  static Transform TransformCompose( const Transform & leftTransform, 
+                                     const Transform & rightTransform );
 
   /** Assign the values of one transform to another */
   const Transform & operator=( const Transform & inputTransform );
@@ -86,6 +86,14 @@ public:
           TransformBase::ErrorType errorValue,
           TimeStamp::TimePeriodType millisecondsToExpiration );
 
+  /** Set Translation and Rotation simultaneously, with the validity period
+   * of the given time stamp instead of a period starting now. */
+  void SetTranslationAndRotation(
+          const  VectorType & translation,
+          const  VersorType & rotation,
+          TransformBase::ErrorType errorValue,
+          const  TimeStamp & timeStamp );
+
 
   /** Set only Rotation. This method should be used when the transform
    * represents only a rotation. Internally the translational part of the
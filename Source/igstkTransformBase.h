@@ -76,6 +76,15 @@ public:
   TimePeriodType GetExpirationTime() const;
 
 
+  /** Returns the time stamp holding the validity period of this
+   * transformation.
+   *
+   * \sa TimeStamp 
+   *
+   * */
+  igstkGetMacro( TimeStamp, TimeStamp );
+
+
   /** Returns the validity status of the transform at the time passed as
    * argument. The transform values should not be used in a scene if the time
    * when the scene is to be rendered returned 'false' when passed to this
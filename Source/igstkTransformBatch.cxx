@@ -0,0 +1,545 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTransformBatch.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include "igstkTransformBatch.h"
+
+// The instructions are selected when compiling, from the flags given to
+// the compiler, for example -mavx
+#if defined(__AVX__)
+#define IGSTK_TRANSFORM_BATCH_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+      ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define IGSTK_TRANSFORM_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace igstk
+{
+
+namespace
+{
+
+/** Number of values between two consecutive poses or points. The values
+ *  of a pose are accessed in order: the rotation, then the translation. */
+const unsigned int PoseStride = sizeof( Pose ) / sizeof( double );
+const unsigned int PointStride = 3;
+
+/** Fails to compile if the compiler pads the poses */
+typedef char PoseHasNoPadding[
+  sizeof( Pose ) == 7 * sizeof( double ) ? 1 : -1 ];
+
+/** The kernels are written once for groups of values, one value of each
+ *  pose or point of the group. A group holds a single value when no vector
+ *  instruction is available, and to process the last poses. */
+struct ScalarLanes
+{
+  enum { Size = 1 };
+
+  static ScalarLanes Load( const double * first, unsigned int )
+    {
+    ScalarLanes lanes;
+    lanes.m_Value = *first;
+    return lanes;
+    }
+
+  static ScalarLanes Broadcast( double value )
+    {
+    ScalarLanes lanes;
+    lanes.m_Value = value;
+    return lanes;
+    }
+
+  void Store( double * first, unsigned int ) const
+    {
+    *first = m_Value;
+    }
+
+  double m_Value;
+};
+
+inline ScalarLanes operator+( const ScalarLanes & a, const ScalarLanes & b )
+{
+  return ScalarLanes::Broadcast( a.m_Value + b.m_Value );
+}
+
+inline ScalarLanes operator-( const ScalarLanes & a, const ScalarLanes & b )
+{
+  return ScalarLanes::Broadcast( a.m_Value - b.m_Value );
+}
+
+inline ScalarLanes operator*( const ScalarLanes & a, const ScalarLanes & b )
+{
+  return ScalarLanes::Broadcast( a.m_Value * b.m_Value );
+}
+
+inline ScalarLanes operator-( const ScalarLanes & a )
+{
+  return ScalarLanes::Broadcast( -a.m_Value );
+}
+
+#if defined(IGSTK_TRANSFORM_BATCH_SSE2)
+
+/** Two poses or points at a time */
+struct VectorLanes
+{
+  enum { Size = 2 };
+
+  static VectorLanes Load( const double * first, unsigned int stride )
+    {
+    VectorLanes lanes;
+    lanes.m_Value = _mm_loadh_pd( _mm_load_sd( first ), first + stride );
+    return lanes;
+    }
+
+  static VectorLanes Broadcast( double value )
+    {
+    VectorLanes lanes;
+    lanes.m_Value = _mm_set1_pd( value );
+    return lanes;
+    }
+
+  void Store( double * first, unsigned int stride ) const
+    {
+    _mm_storel_pd( first, m_Value );
+    _mm_storeh_pd( first + stride, m_Value );
+    }
+
+  static VectorLanes Make( __m128d value )
+    {
+    VectorLanes lanes;
+    lanes.m_Value = value;
+    return lanes;
+    }
+
+  __m128d m_Value;
+};
+
+inline VectorLanes operator+( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm_add_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator-( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm_sub_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator*( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm_mul_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator-( const VectorLanes & a )
+{
+  return VectorLanes::Make( _mm_xor_pd( a.m_Value, _mm_set1_pd( -0.0 ) ) );
+}
+
+#endif
+
+#if defined(IGSTK_TRANSFORM_BATCH_AVX)
+
+/** Four poses or points at a time */
+struct VectorLanes
+{
+  enum { Size = 4 };
+
+  static VectorLanes Load( const double * first, unsigned int stride )
+    {
+    const __m128d low =
+      _mm_loadh_pd( _mm_load_sd( first ), first + stride );
+    const __m128d high =
+      _mm_loadh_pd( _mm_load_sd( first + 2 * stride ), first + 3 * stride );
+    VectorLanes lanes;
+    lanes.m_Value =
+      _mm256_insertf128_pd( _mm256_castpd128_pd256( low ), high, 1 );
+    return lanes;
+    }
+
+  static VectorLanes Broadcast( double value )
+    {
+    VectorLanes lanes;
+    lanes.m_Value = _mm256_set1_pd( value );
+    return lanes;
+    }
+
+  void Store( double * first, unsigned int stride ) const
+    {
+    const __m128d low = _mm256_castpd256_pd128( m_Value );
+    const __m128d high = _mm256_extractf128_pd( m_Value, 1 );
+    _mm_storel_pd( first, low );
+    _mm_storeh_pd( first + stride, low );
+    _mm_storel_pd( first + 2 * stride, high );
+    _mm_storeh_pd( first + 3 * stride, high );
+    }
+
+  static VectorLanes Make( __m256d value )
+    {
+    VectorLanes lanes;
+    lanes.m_Value = value;
+    return lanes;
+    }
+
+  __m256d m_Value;
+};
+
+inline VectorLanes operator+( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm256_add_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator-( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm256_sub_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator*( const VectorLanes & a, const VectorLanes & b )
+{
+  return VectorLanes::Make( _mm256_mul_pd( a.m_Value, b.m_Value ) );
+}
+
+inline VectorLanes operator-( const VectorLanes & a )
+{
+  return VectorLanes::Make(
+    _mm256_xor_pd( a.m_Value, _mm256_set1_pd( -0.0 ) ) );
+}
+
+#endif
+
+/** Rotation matrix of a versor, computed as by itk::Versor::Transform() */
+template < class TLanes >
+inline void ComputeRotationMatrix( const TLanes & x, const TLanes & y,
+                                   const TLanes & z, const TLanes & w,
+                                   TLanes matrix[9] )
+{
+  const TLanes one = TLanes::Broadcast( 1.0 );
+  const TLanes two = TLanes::Broadcast( 2.0 );
+
+  const TLanes xx = x * x;
+  const TLanes yy = y * y;
+  const TLanes zz = z * z;
+  const TLanes xy = x * y;
+  const TLanes xz = x * z;
+  const TLanes xw = x * w;
+  const TLanes yz = y * z;
+  const TLanes yw = y * w;
+  const TLanes zw = z * w;
+
+  matrix[0] = one - two * ( yy + zz );
+  matrix[1] = two * ( xy - zw );
+  matrix[2] = two * ( xz + yw );
+  matrix[3] = two * ( xy + zw );
+  matrix[4] = one - two * ( xx + zz );
+  matrix[5] = two * ( yz - xw );
+  matrix[6] = two * ( xz - yw );
+  matrix[7] = two * ( yz + xw );
+  matrix[8] = one - two * ( xx + yy );
+}
+
+template < class TLanes >
+inline void Rotate( const TLanes matrix[9], const TLanes vector[3],
+                    TLanes result[3] )
+{
+  result[0] = matrix[0] * vector[0] + matrix[1] * vector[1] +
+              matrix[2] * vector[2];
+  result[1] = matrix[3] * vector[0] + matrix[4] * vector[1] +
+              matrix[5] * vector[2];
+  result[2] = matrix[6] * vector[0] + matrix[7] * vector[1] +
+              matrix[8] * vector[2];
+}
+
+/** Compose the poses from first, by groups of TLanes::Size. The left pose
+ *  is the same for all when leftStep is zero. Returns the index of the
+ *  first pose left. */
+template < class TLanes >
+unsigned int ComposeGroups( const Pose * left, unsigned int leftStep,
+                            const Pose * right, Pose * result,
+                            unsigned int first, unsigned int numberOfPoses )
+{
+  const unsigned int leftStride = leftStep * PoseStride;
+
+  unsigned int i = first;
+  for( ; i + TLanes::Size <= numberOfPoses; i += TLanes::Size )
+    {
+    const double * l =
+      reinterpret_cast< const double * >( left + i * leftStep );
+    const double * r = reinterpret_cast< const double * >( right + i );
+
+    const TLanes lx = TLanes::Load( l, leftStride );
+    const TLanes ly = TLanes::Load( l + 1, leftStride );
+    const TLanes lz = TLanes::Load( l + 2, leftStride );
+    const TLanes lw = TLanes::Load( l + 3, leftStride );
+    TLanes leftTranslation[3];
+    leftTranslation[0] = TLanes::Load( l + 4, leftStride );
+    leftTranslation[1] = TLanes::Load( l + 5, leftStride );
+    leftTranslation[2] = TLanes::Load( l + 6, leftStride );
+
+    const TLanes rx = TLanes::Load( r, PoseStride );
+    const TLanes ry = TLanes::Load( r + 1, PoseStride );
+    const TLanes rz = TLanes::Load( r + 2, PoseStride );
+    const TLanes rw = TLanes::Load( r + 3, PoseStride );
+    TLanes rightTranslation[3];
+    rightTranslation[0] = TLanes::Load( r + 4, PoseStride );
+    rightTranslation[1] = TLanes::Load( r + 5, PoseStride );
+    rightTranslation[2] = TLanes::Load( r + 6, PoseStride );
+
+    // Product of the versors, as itk::Versor::operator*()
+    const TLanes x = lw * rx + lx * rw + ly * rz - lz * ry;
+    const TLanes y = lw * ry + ly * rw + lz * rx - lx * rz;
+    const TLanes z = lw * rz + lz * rw + lx * ry - ly * rx;
+    const TLanes w = lw * rw - lx * rx - ly * ry - lz * rz;
+
+    TLanes matrix[9];
+    ComputeRotationMatrix( lx, ly, lz, lw, matrix );
+    TLanes translation[3];
+    Rotate( matrix, rightTranslation, translation );
+
+    double * out = reinterpret_cast< double * >( result + i );
+    x.Store( out, PoseStride );
+    y.Store( out + 1, PoseStride );
+    z.Store( out + 2, PoseStride );
+    w.Store( out + 3, PoseStride );
+    ( translation[0] + leftTranslation[0] ).Store( out + 4, PoseStride );
+    ( translation[1] + leftTranslation[1] ).Store( out + 5, PoseStride );
+    ( translation[2] + leftTranslation[2] ).Store( out + 6, PoseStride );
+    }
+
+  return i;
+}
+
+template < class TLanes >
+unsigned int InvertGroups( const Pose * poses, Pose * result,
+                           unsigned int first, unsigned int numberOfPoses )
+{
+  unsigned int i = first;
+  for( ; i + TLanes::Size <= numberOfPoses; i += TLanes::Size )
+    {
+    const double * p = reinterpret_cast< const double * >( poses + i );
+
+    // Conjugate of the versor, as itk::Versor::GetConjugate()
+    const TLanes x = -TLanes::Load( p, PoseStride );
+    const TLanes y = -TLanes::Load( p + 1, PoseStride );
+    const TLanes z = -TLanes::Load( p + 2, PoseStride );
+    const TLanes w = TLanes::Load( p + 3, PoseStride );
+    TLanes negatedTranslation[3];
+    negatedTranslation[0] = -TLanes::Load( p + 4, PoseStride );
+    negatedTranslation[1] = -TLanes::Load( p + 5, PoseStride );
+    negatedTranslation[2] = -TLanes::Load( p + 6, PoseStride );
+
+    TLanes matrix[9];
+    ComputeRotationMatrix( x, y, z, w, matrix );
+    TLanes translation[3];
+    Rotate( matrix, negatedTranslation, translation );
+
+    double * out = reinterpret_cast< double * >( result + i );
+    x.Store( out, PoseStride );
+    y.Store( out + 1, PoseStride );
+    z.Store( out + 2, PoseStride );
+    w.Store( out + 3, PoseStride );
+    translation[0].Store( out + 4, PoseStride );
+    translation[1].Store( out + 5, PoseStride );
+    translation[2].Store( out + 6, PoseStride );
+    }
+
+  return i;
+}
+
+template < class TLanes >
+unsigned int TransformPointGroups( const double rotationMatrix[9],
+                                   const double translationVector[3],
+                                   const double * points, double * result,
+                                   unsigned int first,
+                                   unsigned int numberOfPoints )
+{
+  TLanes matrix[9];
+  for( unsigned int k = 0; k < 9; k++ )
+    {
+    matrix[k] = TLanes::Broadcast( rotationMatrix[k] );
+    }
+  TLanes translation[3];
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    translation[k] = TLanes::Broadcast( translationVector[k] );
+    }
+
+  unsigned int i = first;
+  for( ; i + TLanes::Size <= numberOfPoints; i += TLanes::Size )
+    {
+    const double * p = points + i * PointStride;
+    TLanes point[3];
+    point[0] = TLanes::Load( p, PointStride );
+    point[1] = TLanes::Load( p + 1, PointStride );
+    point[2] = TLanes::Load( p + 2, PointStride );
+
+    TLanes rotated[3];
+    Rotate( matrix, point, rotated );
+
+    double * out = result + i * PointStride;
+    ( rotated[0] + translation[0] ).Store( out, PointStride );
+    ( rotated[1] + translation[1] ).Store( out + 1, PointStride );
+    ( rotated[2] + translation[2] ).Store( out + 2, PointStride );
+    }
+
+  return i;
+}
+
+} // end anonymous namespace
+
+
+void
+TransformBatch::ExportPose( const Transform & transform, Pose & pose )
+{
+  const VersorType & rotation = transform.GetRotation();
+  pose.m_Rotation[0] = rotation.GetX();
+  pose.m_Rotation[1] = rotation.GetY();
+  pose.m_Rotation[2] = rotation.GetZ();
+  pose.m_Rotation[3] = rotation.GetW();
+
+  const VectorType & translation = transform.GetTranslation();
+  pose.m_Translation[0] = translation[0];
+  pose.m_Translation[1] = translation[1];
+  pose.m_Translation[2] = translation[2];
+}
+
+
+void
+TransformBatch::ImportPose( const Pose & pose, ErrorType error,
+                            const TimeStamp & timeStamp,
+                            Transform & transform )
+{
+  // The components are copied as they are, the versor is not normalized
+  // again
+  VersorType rotation;
+  rotation.Set( VersorType::VnlQuaternionType( pose.m_Rotation[0],
+                                               pose.m_Rotation[1],
+                                               pose.m_Rotation[2],
+                                               pose.m_Rotation[3] ) );
+
+  VectorType translation;
+  translation[0] = pose.m_Translation[0];
+  translation[1] = pose.m_Translation[1];
+  translation[2] = pose.m_Translation[2];
+
+  transform.SetTranslationAndRotation( translation, rotation, error,
+                                       timeStamp );
+}
+
+
+void
+TransformBatch::SetToIdentity( Pose & pose )
+{
+  pose.m_Rotation[0] = 0.0;
+  pose.m_Rotation[1] = 0.0;
+  pose.m_Rotation[2] = 0.0;
+  pose.m_Rotation[3] = 1.0;
+  pose.m_Translation[0] = 0.0;
+  pose.m_Translation[1] = 0.0;
+  pose.m_Translation[2] = 0.0;
+}
+
+
+void
+TransformBatch::Compose( const Pose * left, const Pose * right,
+                         Pose * result, unsigned int numberOfPoses )
+{
+  unsigned int i = 0;
+#if defined(IGSTK_TRANSFORM_BATCH_SSE2) || defined(IGSTK_TRANSFORM_BATCH_AVX)
+  i = ComposeGroups< VectorLanes >( left, 1, right, result, i,
+                                    numberOfPoses );
+#endif
+  ComposeGroups< ScalarLanes >( left, 1, right, result, i, numberOfPoses );
+}
+
+
+void
+TransformBatch::Compose( const Pose & left, const Pose * right,
+                         Pose * result, unsigned int numberOfPoses )
+{
+  // The left pose may be one of the results
+  const Pose leftCopy = left;
+
+  unsigned int i = 0;
+#if defined(IGSTK_TRANSFORM_BATCH_SSE2) || defined(IGSTK_TRANSFORM_BATCH_AVX)
+  i = ComposeGroups< VectorLanes >( &leftCopy, 0, right, result, i,
+                                    numberOfPoses );
+#endif
+  ComposeGroups< ScalarLanes >( &leftCopy, 0, right, result, i,
+                                numberOfPoses );
+}
+
+
+void
+TransformBatch::Invert( const Pose * poses, Pose * result,
+                        unsigned int numberOfPoses )
+{
+  unsigned int i = 0;
+#if defined(IGSTK_TRANSFORM_BATCH_SSE2) || defined(IGSTK_TRANSFORM_BATCH_AVX)
+  i = InvertGroups< VectorLanes >( poses, result, i, numberOfPoses );
+#endif
+  InvertGroups< ScalarLanes >( poses, result, i, numberOfPoses );
+}
+
+
+void
+TransformBatch::TransformPoints( const Pose & pose, const double * points,
+                                 double * result,
+                                 unsigned int numberOfPoints )
+{
+  // The matrix is computed once for all the points
+  ScalarLanes matrix[9];
+  ComputeRotationMatrix( ScalarLanes::Broadcast( pose.m_Rotation[0] ),
+                         ScalarLanes::Broadcast( pose.m_Rotation[1] ),
+                         ScalarLanes::Broadcast( pose.m_Rotation[2] ),
+                         ScalarLanes::Broadcast( pose.m_Rotation[3] ),
+                         matrix );
+  double rotationMatrix[9];
+  for( unsigned int k = 0; k < 9; k++ )
+    {
+    rotationMatrix[k] = matrix[k].m_Value;
+    }
+
+  unsigned int i = 0;
+#if defined(IGSTK_TRANSFORM_BATCH_SSE2) || defined(IGSTK_TRANSFORM_BATCH_AVX)
+  i = TransformPointGroups< VectorLanes >( rotationMatrix,
+                                           pose.m_Translation,
+                                           points, result, i,
+                                           numberOfPoints );
+#endif
+  TransformPointGroups< ScalarLanes >( rotationMatrix, pose.m_Translation,
+                                       points, result, i, numberOfPoints );
+}
+
+
+const char *
+TransformBatch::GetInstructionSet()
+{
+#if defined(IGSTK_TRANSFORM_BATCH_AVX)
+  return "AVX";
+#elif defined(IGSTK_TRANSFORM_BATCH_SSE2)
+  return "SSE2";
+#else
+  return "Scalar";
+#endif
+}
+
+} // end namespace igstk
@@ -0,0 +1,123 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTransformBatch.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkTransformBatch_h
+#define __igstkTransformBatch_h
+
+#include "igstkTransform.h"
+
+namespace igstk
+{
+
+/** \class Pose
+ * \brief Rigid transform stored as plain values.
+ *
+ * A Pose holds the rotation and the translation of a Transform, without
+ * its time stamp and error, so that arrays of poses can be processed by
+ * the kernels of TransformBatch and copied as raw memory. The rotation is
+ * a unit quaternion stored in the order of itk::Versor: X, Y, Z, W.
+ *
+ * \sa TransformBatch
+ *
+ * \ingroup Object
+ */
+struct Pose
+{
+  double m_Rotation[4];
+  double m_Translation[3];
+};
+
+
+/** \class TransformBatch
+ * \brief Composes, inverts and applies rigid transforms in batches.
+ *
+ * The methods of this class process arrays of poses, or of points, with
+ * the same arithmetic as Transform::TransformCompose(), Transform::
+ * GetInverse() and itk::Versor::Transform(). Several poses or points are
+ * processed at once with the AVX or SSE2 instructions, when the library
+ * is compiled for a processor that has them, and one at a time otherwise.
+ *
+ * The time stamps and errors of the transforms are not part of the poses.
+ * Callers combine them as TransformCompose() does when they need them.
+ *
+ * \code
+ *   TransformBatch::Compose( referenceToWorld, toolToReference,
+ *                            toolToWorld, numberOfTools );
+ *   TransformBatch::TransformPoints( toolToWorld[0], tipPoints,
+ *                                    worldPoints, numberOfPoints );
+ * \endcode
+ *
+ * \sa Pose Transform
+ *
+ * \ingroup Object
+ */
+class TransformBatch
+{
+
+public:
+
+  typedef Transform::VectorType         VectorType;
+  typedef Transform::VersorType         VersorType;
+  typedef Transform::ErrorType          ErrorType;
+
+  /** Copy the rotation and translation of a transform to a pose */
+  static void ExportPose( const Transform & transform, Pose & pose );
+
+  /** Set a transform from a pose, with the given error and time stamp */
+  static void ImportPose( const Pose & pose, ErrorType error,
+                          const TimeStamp & timeStamp,
+                          Transform & transform );
+
+  /** Set a pose to the identity */
+  static void SetToIdentity( Pose & pose );
+
+  /** result[i] = left[i] composed with right[i], as
+   *  Transform::TransformCompose( left[i], right[i] ). The result can be
+   *  stored in place of one of the operands. */
+  static void Compose( const Pose * left, const Pose * right,
+                       Pose * result, unsigned int numberOfPoses );
+
+  /** result[i] = left composed with right[i]. Used to move many poses to
+   *  the same parent coordinate system. */
+  static void Compose( const Pose & left, const Pose * right,
+                       Pose * result, unsigned int numberOfPoses );
+
+  /** result[i] = inverse of poses[i], as Transform::GetInverse(). The
+   *  result can be stored in place of the poses. */
+  static void Invert( const Pose * poses, Pose * result,
+                      unsigned int numberOfPoses );
+
+  /** Apply a pose to points stored as consecutive x, y, z coordinates.
+   *  The result can be stored in place of the points. */
+  static void TransformPoints( const Pose & pose, const double * points,
+                               double * result, unsigned int numberOfPoints );
+
+  /** Name of the instructions used by the kernels: "AVX", "SSE2" or
+   *  "Scalar" */
+  static const char * GetInstructionSet();
+
+private:
+
+  TransformBatch();                         //purposely not implemented
+  TransformBatch(const TransformBatch &);   //purposely not implemented
+  void operator=(const TransformBatch &);   //purposely not implemented
+
+};
+
+} // end namespace igstk
+
+#endif // __igstkTransformBatch_h
@@ -23,9 +23,11 @@
 #include "igstkStateMachine.h"
 
 
-#include "vtkImageReslice.h"
-#include "itkVTKImageImport.h"
-#include "vtkImageExport.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+class vtkImageData;
 
 namespace igstk
 {
@@ -79,6 +81,17 @@ public:
  * provide a simulation of Ultrasound images by reading a CT or MR image and
  * extracting an slice from it. 
  *
+ * The slice is sampled with trilinear interpolation by several threads,
+ * four pixels at a time when SSE2 is enabled in the compiler, directly into
+ * an 8-bit image that is reused from one reslicing to the next. By default
+ * the intensities of every slice are rescaled to the full 8-bit range. When
+ * a fixed intensity window is given with SetIntensityWindow(), they are
+ * scaled and clamped as they are sampled, which avoids a second pass over
+ * the slice.
+ *
+ * The simulated image can optionally be restricted to the fan of a convex
+ * probe, darkened with depth, and modulated by a speckle pattern.
+ *
  * \warning This class should ONLY be used for testing purposes, and not as
  * part of a final application.
  *
@@ -110,6 +123,34 @@ public:
   /** Request reslice a 3D image */
   void RequestReslice();
 
+  /** Request to map the intensities in [minimum,maximum] of the 3D image
+   *  linearly to [0,255], clamping the others. The request is ignored
+   *  unless minimum is smaller than maximum. */
+  void RequestSetIntensityWindow( double minimum, double maximum );
+
+  /** Request to rescale the intensities of every slice to [0,255]. This is
+   *  the default. */
+  void RequestSetAutomaticIntensityWindow();
+
+  /** Request to only keep the pixels inside a fan with its apex at the
+   *  center of the first row of the image, opening by angle degrees and
+   *  reaching depth millimeters. A depth of zero reaches the bottom of the
+   *  image. */
+  void RequestSetFanMask( bool enabled, double angle, double depth );
+
+  /** Request the attenuation of the intensity with depth, in 1/mm. Default
+   *  is 0. Negative coefficients are ignored. */
+  void RequestSetAttenuationCoefficient( double coefficient );
+
+  /** Request the amount of multiplicative speckle, between 0 (none, the
+   *  default) and 1 (fully developed speckle). Other amounts are
+   *  ignored. */
+  void RequestSetSpeckleAmount( double amount );
+
+  /** Number of threads used for reslicing */
+  igstkSetMacro( NumberOfThreads, unsigned int );
+  igstkGetMacro( NumberOfThreads, unsigned int );
+
   /** Print the object information in a stream. */
   virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const; 
 
@@ -149,21 +190,59 @@ private:
   ImageGeometricModelConstPointer       m_ImageGeometricModel;
   ImageGeometricModelConstPointer       m_ImageGeometricModelToAdd;
     
-  /** VTK classes that support display of an image */
+  /** VTK image holding the 3D image */
   vtkImageData                         * m_ImageData;
-  vtkImageData                         * m_ReslicedImageData;
-  vtkImageReslice                      * m_ImageReslice;
-
-  typedef itk::VTKImageImport<MRImageType> VTKImageImporterType;
-
-  typename VTKImageImporterType::Pointer  m_VTKImageImporter;
 
   TransformType                           m_Transform;
   TransformType                           m_TransformToBeSet;
 
   USImageObject::Pointer                  m_USImage;
   USImageType::Pointer                    m_RescaledUSImage;
-  vtkImageExport*                         m_VTKExporter;
+
+  typedef typename MRImageType::PixelType  MRPixelType;
+
+  /** Intensity mapping */
+  bool                                    m_AutomaticIntensityWindow;
+  double                                  m_IntensityMinimum;
+  double                                  m_IntensityMaximum;
+
+  /** Parameters waiting for the state machine */
+  double                                  m_IntensityMinimumToBeSet;
+  double                                  m_IntensityMaximumToBeSet;
+  bool                                    m_FanMaskEnabledToBeSet;
+  double                                  m_FanAngleToBeSet;
+  double                                  m_FanDepthToBeSet;
+  double                                  m_AttenuationCoefficientToBeSet;
+  double                                  m_SpeckleAmountToBeSet;
+
+  /** Fan mask, attenuation and speckle. The first and last column inside
+   *  the fan are kept for every row, together with a per pixel gain in
+   *  8.8 fixed point that is empty when there is no modulation. */
+  bool                                    m_FanMaskEnabled;
+  double                                  m_FanAngle;
+  double                                  m_FanDepth;
+  double                                  m_AttenuationCoefficient;
+  double                                  m_SpeckleAmount;
+  bool                                    m_ModulationModified;
+  std::vector< int >                      m_RowBegin;
+  std::vector< int >                      m_RowEnd;
+  std::vector< unsigned short >           m_Gain;
+
+  /** Sampling of the current slice, shared with the threads. Positions are
+   *  continuous indices in the buffer of the 3D image. */
+  double                                  m_SliceStart[3];
+  double                                  m_ColumnStep[3];
+  double                                  m_RowStep[3];
+  int                                     m_OutputSize[2];
+  int                                     m_ResliceStage;
+  std::vector< float >                    m_Samples;
+  std::vector< float >                    m_ThreadMinimum;
+  std::vector< float >                    m_ThreadMaximum;
+  float                                   m_SliceMinimum;
+  float                                   m_SliceScale;
+
+  unsigned int                            m_NumberOfThreads;
+  itk::MultiThreader::Pointer             m_Threader;
 
   /** Null operation for State Machine transition */
   void NoProcessing();
@@ -175,9 +254,36 @@ private:
   /** Set the transform for the plane */
   void SetTransformProcessing();
 
+  /** Set the intensity mapping */
+  void SetIntensityWindowProcessing();
+  void SetAutomaticIntensityWindowProcessing();
+
+  /** Set the parameters of the modulation */
+  void SetFanMaskProcessing();
+  void SetAttenuationCoefficientProcessing();
+  void SetSpeckleAmountProcessing();
+
+  /** Report an invalid parameter */
+  void ReportInvalidRequestProcessing();
+
   /** Reslice processing */
   void ResliceProcessing ();
 
+  /** Allocate the output image if its geometry has changed */
+  void AllocateOutputImage();
+
+  /** Compute the fan rows and the gains of the modulation */
+  void ComputeModulation();
+
+  /** Sample rows [firstRow,lastRow) of the slice */
+  void SampleRows( int firstRow, int lastRow, unsigned int threadId );
+
+  /** Map the samples of rows [firstRow,lastRow) to the output image */
+  void MapRows( int firstRow, int lastRow );
+
+  /** Thread callback splitting the rows of the slice */
+  static ITK_THREAD_RETURN_TYPE ResliceThreaderCallback( void * arg );
+
   /** Sets the vtkImageData from the spatial object. This method MUST be
    * private in order to prevent unsafe access from the VTK image layer. */
   void SetImage( const vtkImageData * image );
@@ -205,6 +311,15 @@ private:
   igstkDeclareInputMacro( Reslice );
   igstkDeclareInputMacro( GetImage );
 
+  igstkDeclareInputMacro( ValidIntensityWindow );
+  igstkDeclareInputMacro( InvalidIntensityWindow );
+  igstkDeclareInputMacro( AutomaticIntensityWindow );
+  igstkDeclareInputMacro( FanMask );
+  igstkDeclareInputMacro( ValidAttenuationCoefficient );
+  igstkDeclareInputMacro( InvalidAttenuationCoefficient );
+  igstkDeclareInputMacro( ValidSpeckleAmount );
+  igstkDeclareInputMacro( InvalidSpeckleAmount );
+
   /** States for the State Machine */
   igstkDeclareStateMacro( NullImageSpatialObject );
   igstkDeclareStateMacro( ValidImageSpatialObject );
@@ -20,8 +20,19 @@
 #include "igstkUltrasoundImageSimulator.h"
 
 #include "vtkImageData.h"
-#include "itkRescaleIntensityImageFilter.h"
-#include "itkCastImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vnl/vnl_math.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The instructions are selected when compiling, from the flags given to
+// the compiler, as for the kernels of TransformBatch
+#if defined(__SSE2__) || defined(_M_X64) || \
+    ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define IGSTK_ULTRASOUND_SIMULATOR_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace igstk
 {
@@ -38,17 +49,38 @@ UltrasoundImageSimulator< TImageGeometricModel >
 
   // Create classes for displaying images
   m_ImageData  = NULL;
-  m_ReslicedImageData  = NULL;
-  m_VTKImageImporter = VTKImageImporterType::New();
 
-  // Image reslice
-  m_ImageReslice = vtkImageReslice::New();
-  
   m_VTKImageObserver = VTKImageObserver::New();
 
   m_USImage = USImageObject::New();
 
-  m_VTKExporter = vtkImageExport::New();
+  m_AutomaticIntensityWindow = true;
+  m_IntensityMinimum = 0.0;
+  m_IntensityMaximum = 255.0;
+
+  m_FanMaskEnabled = false;
+  m_FanAngle = 60.0;
+  m_FanDepth = 0.0;
+  m_AttenuationCoefficient = 0.0;
+  m_SpeckleAmount = 0.0;
+  m_ModulationModified = true;
+
+  m_IntensityMinimumToBeSet = m_IntensityMinimum;
+  m_IntensityMaximumToBeSet = m_IntensityMaximum;
+  m_FanMaskEnabledToBeSet = m_FanMaskEnabled;
+  m_FanAngleToBeSet = m_FanAngle;
+  m_FanDepthToBeSet = m_FanDepth;
+  m_AttenuationCoefficientToBeSet = m_AttenuationCoefficient;
+  m_SpeckleAmountToBeSet = m_SpeckleAmount;
+
+  m_OutputSize[0] = 0;
+  m_OutputSize[1] = 0;
+  m_ResliceStage = 0;
+  m_SliceMinimum = 0.0;
+  m_SliceScale = 0.0;
+
+  m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_Threader = itk::MultiThreader::New();
 
 
   igstkAddInputMacro( ValidImageSpatialObject );
@@ -63,6 +95,15 @@ UltrasoundImageSimulator< TImageGeometricModel >
   igstkAddInputMacro( Reslice );
   igstkAddInputMacro( GetImage );
 
+  igstkAddInputMacro( ValidIntensityWindow );
+  igstkAddInputMacro( InvalidIntensityWindow );
+  igstkAddInputMacro( AutomaticIntensityWindow );
+  igstkAddInputMacro( FanMask );
+  igstkAddInputMacro( ValidAttenuationCoefficient );
+  igstkAddInputMacro( InvalidAttenuationCoefficient );
+  igstkAddInputMacro( ValidSpeckleAmount );
+  igstkAddInputMacro( InvalidSpeckleAmount );
+
   igstkAddStateMacro( NullImageSpatialObject );
   igstkAddStateMacro( ValidImageSpatialObject );
 
@@ -94,6 +135,49 @@ UltrasoundImageSimulator< TImageGeometricModel >
                            ValidImageSpatialObject,
                            ReportImage );
 
+  // The simulation parameters can be set with or without an image
+  igstkAddTransitionMacro( NullImageSpatialObject, ValidIntensityWindow,
+                           NullImageSpatialObject, SetIntensityWindow );
+  igstkAddTransitionMacro( NullImageSpatialObject, InvalidIntensityWindow,
+                           NullImageSpatialObject, ReportInvalidRequest );
+  igstkAddTransitionMacro( NullImageSpatialObject, AutomaticIntensityWindow,
+                           NullImageSpatialObject,
+                           SetAutomaticIntensityWindow );
+  igstkAddTransitionMacro( NullImageSpatialObject, FanMask,
+                           NullImageSpatialObject, SetFanMask );
+  igstkAddTransitionMacro( NullImageSpatialObject,
+                           ValidAttenuationCoefficient,
+                           NullImageSpatialObject,
+                           SetAttenuationCoefficient );
+  igstkAddTransitionMacro( NullImageSpatialObject,
+                           InvalidAttenuationCoefficient,
+                           NullImageSpatialObject, ReportInvalidRequest );
+  igstkAddTransitionMacro( NullImageSpatialObject, ValidSpeckleAmount,
+                           NullImageSpatialObject, SetSpeckleAmount );
+  igstkAddTransitionMacro( NullImageSpatialObject, InvalidSpeckleAmount,
+                           NullImageSpatialObject, ReportInvalidRequest );
+
+  igstkAddTransitionMacro( ValidImageSpatialObject, ValidIntensityWindow,
+                           ValidImageSpatialObject, SetIntensityWindow );
+  igstkAddTransitionMacro( ValidImageSpatialObject, InvalidIntensityWindow,
+                           ValidImageSpatialObject, ReportInvalidRequest );
+  igstkAddTransitionMacro( ValidImageSpatialObject, AutomaticIntensityWindow,
+                           ValidImageSpatialObject,
+                           SetAutomaticIntensityWindow );
+  igstkAddTransitionMacro( ValidImageSpatialObject, FanMask,
+                           ValidImageSpatialObject, SetFanMask );
+  igstkAddTransitionMacro( ValidImageSpatialObject,
+                           ValidAttenuationCoefficient,
+                           ValidImageSpatialObject,
+                           SetAttenuationCoefficient );
+  igstkAddTransitionMacro( ValidImageSpatialObject,
+                           InvalidAttenuationCoefficient,
+                           ValidImageSpatialObject, ReportInvalidRequest );
+  igstkAddTransitionMacro( ValidImageSpatialObject, ValidSpeckleAmount,
+                           ValidImageSpatialObject, SetSpeckleAmount );
+  igstkAddTransitionMacro( ValidImageSpatialObject, InvalidSpeckleAmount,
+                           ValidImageSpatialObject, ReportInvalidRequest );
+
   igstkSetInitialStateMacro( NullImageSpatialObject );
 
   m_StateMachine.SetReadyToRun();
@@ -107,13 +191,6 @@ template < class TImageGeometricModel >
 UltrasoundImageSimulator< TImageGeometricModel >
 ::~UltrasoundImageSimulator()  
 {
-  if( m_ImageReslice )
-    {
-    m_ImageReslice->Delete();
-    m_ImageReslice = NULL;
-    }
-
-  m_VTKExporter->Delete();
 }
  
 /** Set the Image Spatial Object */
@@ -219,6 +296,170 @@ UltrasoundImageSimulator< TImageGeometricModel >
   m_StateMachine.ProcessInputs();
 }
 
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::RequestSetIntensityWindow( double minimum, double maximum )
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::RequestSetIntensityWindow called...\n");
+
+  m_IntensityMinimumToBeSet = minimum;
+  m_IntensityMaximumToBeSet = maximum;
+
+  if( minimum < maximum )
+    {
+    igstkPushInputMacro( ValidIntensityWindow );
+    }
+  else
+    {
+    igstkPushInputMacro( InvalidIntensityWindow );
+    }
+  m_StateMachine.ProcessInputs();
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SetIntensityWindowProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::SetIntensityWindowProcessing called...\n");
+
+  m_AutomaticIntensityWindow = false;
+  m_IntensityMinimum = m_IntensityMinimumToBeSet;
+  m_IntensityMaximum = m_IntensityMaximumToBeSet;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::RequestSetAutomaticIntensityWindow()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::RequestSetAutomaticIntensityWindow called...\n");
+
+  igstkPushInputMacro( AutomaticIntensityWindow );
+  m_StateMachine.ProcessInputs();
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SetAutomaticIntensityWindowProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                ::SetAutomaticIntensityWindowProcessing called...\n");
+
+  m_AutomaticIntensityWindow = true;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::RequestSetFanMask( bool enabled, double angle, double depth )
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::RequestSetFanMask called...\n");
+
+  m_FanMaskEnabledToBeSet = enabled;
+  m_FanAngleToBeSet = angle;
+  m_FanDepthToBeSet = depth;
+
+  igstkPushInputMacro( FanMask );
+  m_StateMachine.ProcessInputs();
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SetFanMaskProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::SetFanMaskProcessing called...\n");
+
+  m_FanMaskEnabled = m_FanMaskEnabledToBeSet;
+  m_FanAngle = m_FanAngleToBeSet;
+  m_FanDepth = m_FanDepthToBeSet;
+  m_ModulationModified = true;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::RequestSetAttenuationCoefficient( double coefficient )
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::RequestSetAttenuationCoefficient called...\n");
+
+  m_AttenuationCoefficientToBeSet = coefficient;
+
+  if( coefficient >= 0.0 )
+    {
+    igstkPushInputMacro( ValidAttenuationCoefficient );
+    }
+  else
+    {
+    igstkPushInputMacro( InvalidAttenuationCoefficient );
+    }
+  m_StateMachine.ProcessInputs();
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SetAttenuationCoefficientProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::SetAttenuationCoefficientProcessing called...\n");
+
+  m_AttenuationCoefficient = m_AttenuationCoefficientToBeSet;
+  m_ModulationModified = true;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::RequestSetSpeckleAmount( double amount )
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::RequestSetSpeckleAmount called...\n");
+
+  m_SpeckleAmountToBeSet = amount;
+
+  if( amount >= 0.0 && amount <= 1.0 )
+    {
+    igstkPushInputMacro( ValidSpeckleAmount );
+    }
+  else
+    {
+    igstkPushInputMacro( InvalidSpeckleAmount );
+    }
+  m_StateMachine.ProcessInputs();
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SetSpeckleAmountProcessing()
+{
+  igstkLogMacro( DEBUG, "igstk::UltrasoundImageSimulator\
+                         ::SetSpeckleAmountProcessing called...\n");
+
+  m_SpeckleAmount = m_SpeckleAmountToBeSet;
+  m_ModulationModified = true;
+}
+
+/** Report an invalid simulation parameter */
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::ReportInvalidRequestProcessing()
+{
+  igstkLogMacro( WARNING, "igstk::UltrasoundImageSimulator\
+                         ::ReportInvalidRequestProcessing called...\n");
+}
+
 template < class TImageGeometricModel >
 void 
 UltrasoundImageSimulator< TImageGeometricModel >
@@ -228,6 +469,11 @@ UltrasoundImageSimulator< TImageGeometricModel >
            "igstk::UltrasoundImageSimulator\
            ::ResliceProcessing called...\n");
 
+  if( !m_ImageData || !m_ImageData->GetScalarPointer() )
+    {
+    return;
+    }
+
   typedef TransformType::VectorType   VectorType;
   VectorType                position;
   position = m_Transform.GetTranslation();
@@ -243,15 +489,6 @@ UltrasoundImageSimulator< TImageGeometricModel >
   v2[2] = 0;
   v2 = m_Transform.GetRotation().Transform(v2);
  
-  m_ImageReslice->SetInput(m_ImageData);
-
-  double origin[3];
-  m_ImageData->GetOrigin( origin );
-
-  // Set the reslice axes origin
-  m_ImageReslice->SetResliceAxesOrigin(position[0],
-                                       position[1],
-                                       position[2]);
   VectorType v3;  
    
   // Check if vector v1 and v2 are orthogonal
@@ -274,76 +511,598 @@ UltrasoundImageSimulator< TImageGeometricModel >
   v2Normalized = v2/v2.GetNorm();
   v3Normalized = v3/v3.GetNorm();
 
-  // set the reslice axes 
-  m_ImageReslice->SetResliceAxesDirectionCosines( 
-                 v1Normalized[0], v1Normalized[1], v1Normalized[2],
-                 v2Normalized[0], v2Normalized[1], v2Normalized[2],
-                 v3Normalized[0], v3Normalized[1], v3Normalized[2]);
+  this->AllocateOutputImage();
 
-  // set the output dimensionality to 3
-  m_ImageReslice->SetOutputDimensionality(3);
+  if( m_ModulationModified )
+    {
+    this->ComputeModulation();
+    m_ModulationModified = false;
+    }
 
-  // Set the output spacing 
+  // The slice has the extent, spacing and origin of the x-y plane of the 3D
+  // image, and is placed along the reslice axes going through the position
+  // of the transform. Sample positions are expressed as continuous indices
+  // in the buffer of the 3D image, so that moving by one pixel in the slice
+  // is a constant increment.
+  double origin[3];
   double spacing[3];
+  int    ext[6];
+  m_ImageData->GetOrigin( origin );
   m_ImageData->GetSpacing( spacing );
-  m_ImageReslice->SetOutputSpacing( spacing[0],spacing[1], 1 );
-
-  // Set the output extent
-  int ext[6];
   m_ImageData->GetExtent( ext );
-  m_ImageReslice->SetOutputExtent( ext[0], ext[1], ext[2], 
-                                   ext[3], 0, 0);
 
-  m_ImageReslice->SetOutputOrigin(origin);
-  m_ImageReslice->SetInterpolationModeToLinear();
-  m_ImageReslice->Update();
-  
-  m_VTKExporter->SetInput(m_ReslicedImageData);
-
-  m_VTKImageImporter->SetUpdateInformationCallback( 
-                               m_VTKExporter->GetUpdateInformationCallback());
-  m_VTKImageImporter->SetPipelineModifiedCallback(
-                                m_VTKExporter->GetPipelineModifiedCallback());
-  m_VTKImageImporter->SetWholeExtentCallback( 
-                                     m_VTKExporter->GetWholeExtentCallback());
-  m_VTKImageImporter->SetSpacingCallback(m_VTKExporter->GetSpacingCallback());
-  m_VTKImageImporter->SetOriginCallback( m_VTKExporter->GetOriginCallback() );
-  m_VTKImageImporter->SetScalarTypeCallback( 
-                                      m_VTKExporter->GetScalarTypeCallback());
-  m_VTKImageImporter->SetNumberOfComponentsCallback( 
-                              m_VTKExporter->GetNumberOfComponentsCallback());
-  m_VTKImageImporter->SetPropagateUpdateExtentCallback( 
-                           m_VTKExporter->GetPropagateUpdateExtentCallback());
-  m_VTKImageImporter->SetUpdateDataCallback( 
-                                      m_VTKExporter->GetUpdateDataCallback());
-  m_VTKImageImporter->SetDataExtentCallback( 
-                                      m_VTKExporter->GetDataExtentCallback());
-  m_VTKImageImporter->SetBufferPointerCallback( 
-                                   m_VTKExporter->GetBufferPointerCallback());
-  m_VTKImageImporter->SetCallbackUserData( 
-                                        m_VTKExporter->GetCallbackUserData());
-
-  // Do the actual rescaling and casting of the US image
-  typedef itk::RescaleIntensityImageFilter<MRImageType> RescaleFilterType;
-  typename RescaleFilterType::Pointer rescaler = RescaleFilterType::New();
-  rescaler->SetInput(m_VTKImageImporter->GetOutput());
-  rescaler->SetOutputMinimum(0);
-  rescaler->SetOutputMaximum(255);
-  rescaler->Update();
-
-  typedef itk::CastImageFilter<MRImageType,USImageType> CastFilterType;
-  typename CastFilterType::Pointer caster = CastFilterType::New();
-  caster->SetInput(rescaler->GetOutput());
-  caster->Update();
-  
-  m_RescaledUSImage = caster->GetOutput();
+  const double u = origin[0] + ext[0] * spacing[0];
+  const double v = origin[1] + ext[2] * spacing[1];
+  const double w = origin[2];
 
+  for( unsigned int d = 0; d < 3; d++ )
+    {
+    const double first = position[d] + u * v1Normalized[d]
+                                     + v * v2Normalized[d]
+                                     + w * v3Normalized[d];
+    m_SliceStart[d] = ( first - origin[d] ) / spacing[d] - ext[2*d];
+    m_ColumnStep[d] = spacing[0] * v1Normalized[d] / spacing[d];
+    m_RowStep[d]    = spacing[1] * v2Normalized[d] / spacing[d];
+    }
+
+  m_Threader->SetNumberOfThreads( m_NumberOfThreads );
+  const unsigned int numberOfThreads = m_Threader->GetNumberOfThreads();
+  m_ThreadMinimum.resize( numberOfThreads );
+  m_ThreadMaximum.resize( numberOfThreads );
+
+  if( m_AutomaticIntensityWindow )
+    {
+    m_Samples.resize( m_OutputSize[0] * m_OutputSize[1] );
+    }
+
+  m_ResliceStage = 0;
+  m_Threader->SetSingleMethod( ResliceThreaderCallback, this );
+  m_Threader->SingleMethodExecute();
+
+  if( m_AutomaticIntensityWindow )
+    {
+    // Rescale the slice to [0,255] in a second pass, as the rescale
+    // intensity filter would.
+    float minimum = m_ThreadMinimum[0];
+    float maximum = m_ThreadMaximum[0];
+    for( unsigned int t = 1; t < numberOfThreads; t++ )
+      {
+      minimum = std::min( minimum, m_ThreadMinimum[t] );
+      maximum = std::max( maximum, m_ThreadMaximum[t] );
+      }
+
+    m_SliceMinimum = minimum;
+    m_SliceScale = ( maximum > minimum ) ? 255.0f / ( maximum - minimum )
+                                         : 0.0f;
+
+    m_ResliceStage = 1;
+    m_Threader->SingleMethodExecute();
+    }
+
+  m_RescaledUSImage->Modified();
 
   typedef Friends::UltrasoundImageSimulatorToImageSpatialObject  HelperType;
   HelperType::SetITKImage( this, m_USImage.GetPointer() );
 
 }
 
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::AllocateOutputImage()
+{
+  double spacing[3];
+  double origin[3];
+  int    ext[6];
+  m_ImageData->GetSpacing( spacing );
+  m_ImageData->GetOrigin( origin );
+  m_ImageData->GetExtent( ext );
+
+  typename USImageType::RegionType  region;
+  typename USImageType::SpacingType outputSpacing;
+  typename USImageType::PointType   outputOrigin;
+
+  region.SetIndex( 0, ext[0] );
+  region.SetIndex( 1, ext[2] );
+  region.SetIndex( 2, 0 );
+  region.SetSize( 0, ext[1] - ext[0] + 1 );
+  region.SetSize( 1, ext[3] - ext[2] + 1 );
+  region.SetSize( 2, 1 );
+
+  outputSpacing[0] = spacing[0];
+  outputSpacing[1] = spacing[1];
+  outputSpacing[2] = 1.0;
+
+  for( unsigned int d = 0; d < 3; d++ )
+    {
+    outputOrigin[d] = origin[d];
+    }
+
+  if( m_RescaledUSImage.IsNotNull() &&
+      m_RescaledUSImage->GetBufferedRegion() == region &&
+      m_RescaledUSImage->GetSpacing() == outputSpacing &&
+      m_RescaledUSImage->GetOrigin() == outputOrigin )
+    {
+    return;
+    }
+
+  m_RescaledUSImage = USImageType::New();
+  m_RescaledUSImage->SetRegions( region );
+  m_RescaledUSImage->SetSpacing( outputSpacing );
+  m_RescaledUSImage->SetOrigin( outputOrigin );
+  m_RescaledUSImage->Allocate();
+  m_RescaledUSImage->FillBuffer( 0 );
+
+  m_OutputSize[0] = static_cast< int >( region.GetSize( 0 ) );
+  m_OutputSize[1] = static_cast< int >( region.GetSize( 1 ) );
+
+  m_ModulationModified = true;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::ComputeModulation()
+{
+  const int width  = m_OutputSize[0];
+  const int height = m_OutputSize[1];
+
+  const typename USImageType::SpacingType & spacing =
+                                           m_RescaledUSImage->GetSpacing();
+
+  m_RowBegin.assign( height, 0 );
+  m_RowEnd.assign( height, width );
+  m_Gain.clear();
+
+  const double center = 0.5 * ( width - 1 );
+
+  if( m_FanMaskEnabled )
+    {
+    const double depth = ( m_FanDepth > 0.0 ) ? m_FanDepth
+                                              : ( height - 1 ) * spacing[1];
+    const double slope = tan( 0.5 * m_FanAngle * vnl_math::pi / 180.0 );
+
+    for( int j = 0; j < height; j++ )
+      {
+      const double y = j * spacing[1];
+      if( y > depth )
+        {
+        m_RowBegin[j] = 0;
+        m_RowEnd[j] = 0;
+        continue;
+        }
+      const double halfWidth =
+                   std::min( y * slope, sqrt( depth * depth - y * y ) );
+      const int begin = static_cast< int >(
+                          ceil( center - halfWidth / spacing[0] ) );
+      const int end = static_cast< int >(
+                          floor( center + halfWidth / spacing[0] ) ) + 1;
+      m_RowBegin[j] = std::max( begin, 0 );
+      m_RowEnd[j] = std::max( std::min( end, width ), m_RowBegin[j] );
+      }
+    }
+
+  if( m_AttenuationCoefficient == 0.0 && m_SpeckleAmount == 0.0 )
+    {
+    return;
+    }
+
+  // The speckle pattern is drawn once from a Rayleigh distribution of unit
+  // mean, with a fixed seed so that the simulation is reproducible.
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator
+                                                           GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  const double sigma = sqrt( 2.0 / vnl_math::pi );
+
+  m_Gain.resize( width * height );
+
+  for( int j = 0; j < height; j++ )
+    {
+    const double y = j * spacing[1];
+    for( int i = 0; i < width; i++ )
+      {
+      double depth = y;
+      if( m_FanMaskEnabled )
+        {
+        const double x = ( i - center ) * spacing[0];
+        depth = sqrt( x * x + y * y );
+        }
+
+      double gain = exp( -m_AttenuationCoefficient * depth );
+
+      if( m_SpeckleAmount != 0.0 )
+        {
+        const double uniform = 1.0 - generator->GetVariateWithOpenUpperRange();
+        const double rayleigh = sigma * sqrt( -2.0 * log( uniform ) );
+        gain *= ( 1.0 - m_SpeckleAmount ) + m_SpeckleAmount * rayleigh;
+        }
+
+      gain = std::max( 0.0, std::min( gain, 255.0 ) );
+      m_Gain[ j * width + i ] =
+                   static_cast< unsigned short >( gain * 256.0 + 0.5 );
+      }
+    }
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::SampleRows( int firstRow, int lastRow, unsigned int threadId )
+{
+  const MRPixelType * data =
+             static_cast< const MRPixelType * >( m_ImageData->GetScalarPointer() );
+
+  int dims[3];
+  m_ImageData->GetDimensions( dims );
+
+  // Trilinear interpolation reads the voxel at the index and its successor
+  // along every axis. The last valid index is clamped one voxel before the
+  // border, and a flat axis does not move.
+  const long stride[3] = { 1, dims[0], 
+                           static_cast< long >( dims[0] ) * dims[1] };
+  double upper[3];
+  int    lastIndex[3];
+  long   step[3];
+  double columnStep[3];
+  for( unsigned int d = 0; d < 3; d++ )
+    {
+    columnStep[d] = m_ColumnStep[d];
+    upper[d] = dims[d] - 1;
+    lastIndex[d] = std::max( dims[d] - 2, 0 );
+    step[d] = ( dims[d] > 1 ) ? stride[d] : 0;
+    }
+
+  // Offsets of the eight corners, the bit d of a corner selects the
+  // successor along the axis d
+  long corner[8];
+  for( unsigned int c = 0; c < 8; c++ )
+    {
+    corner[c] = ( ( c & 1 ) ? step[0] : 0 ) + ( ( c & 2 ) ? step[1] : 0 )
+              + ( ( c & 4 ) ? step[2] : 0 );
+    }
+
+  const int width = m_OutputSize[0];
+  unsigned char * output = m_RescaledUSImage->GetBufferPointer();
+
+  // The fixed intensity window is a single scale and clamp to [0,255]
+  const bool automatic = m_AutomaticIntensityWindow;
+  const bool modulated = !m_Gain.empty();
+  const double range = m_IntensityMaximum - m_IntensityMinimum;
+  const float windowMinimum = static_cast< float >( m_IntensityMinimum );
+  const float windowScale =
+               ( range > 0.0 ) ? static_cast< float >( 255.0 / range ) : 0.0f;
+
+  float minimum = itk::NumericTraits< float >::max();
+  float maximum = itk::NumericTraits< float >::NonpositiveMin();
+
+#if defined(IGSTK_ULTRASOUND_SIMULATOR_SSE2)
+  const bool smallIntegers = itk::NumericTraits< MRPixelType >::is_integer &&
+                             sizeof( MRPixelType ) <= 2;
+  __m128 groupMinimum = _mm_set1_ps( minimum );
+  __m128 groupMaximum = _mm_set1_ps( maximum );
+#endif
+
+  for( int j = firstRow; j < lastRow; j++ )
+    {
+    const int begin = m_RowBegin[j];
+    const int end   = m_RowEnd[j];
+
+    unsigned char * out = output + j * width;
+    float * samples = automatic ? &m_Samples[ j * width ] : NULL;
+    const unsigned short * gain = modulated ? &m_Gain[ j * width ] : NULL;
+
+    // Pixels outside of the fan are background
+    if( begin > 0 || end < width )
+      {
+      for( int i = 0; i < begin; i++ )
+        {
+        out[i] = 0;
+        }
+      for( int i = end; i < width; i++ )
+        {
+        out[i] = 0;
+        }
+      if( automatic )
+        {
+        for( int i = 0; i < begin; i++ )
+          {
+          samples[i] = 0.0f;
+          }
+        for( int i = end; i < width; i++ )
+          {
+          samples[i] = 0.0f;
+          }
+        minimum = std::min( minimum, 0.0f );
+        maximum = std::max( maximum, 0.0f );
+        }
+      }
+
+    // The position of the column i is computed from the start of the row,
+    // the same way by the vector and the scalar loops.
+    double rowStart[3];
+    for( unsigned int d = 0; d < 3; d++ )
+      {
+      rowStart[d] = m_SliceStart[d] + j * m_RowStep[d];
+      }
+
+    int i = begin;
+
+#if defined(IGSTK_ULTRASOUND_SIMULATOR_SSE2)
+    // Four columns at a time. The positions, bounds and weights are
+    // computed in double precision like the scalar loop, two columns per
+    // register, and the corners are gathered one column at a time. A
+    // column outside of the image is clamped to it, then masked to zero.
+    for( ; i + 4 <= end; i += 4 )
+      {
+      const __m128d columns01 = _mm_set_pd( i + 1, i );
+      const __m128d columns23 = _mm_set_pd( i + 3, i + 2 );
+
+      __m128  inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+      __m128  fraction[3];
+      int     index[3][4];
+
+      for( unsigned int d = 0; d < 3; d++ )
+        {
+        const __m128d start = _mm_set1_pd( rowStart[d] );
+        const __m128d increment = _mm_set1_pd( columnStep[d] );
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d top = _mm_set1_pd( upper[d] );
+        const __m128d last = _mm_set1_pd( lastIndex[d] );
+
+        const __m128d position01 =
+                   _mm_add_pd( start, _mm_mul_pd( columns01, increment ) );
+        const __m128d position23 =
+                   _mm_add_pd( start, _mm_mul_pd( columns23, increment ) );
+
+        const __m128d inside01 = _mm_and_pd(
+                                   _mm_cmpge_pd( position01, zero ),
+                                   _mm_cmple_pd( position01, top ) );
+        const __m128d inside23 = _mm_and_pd(
+                                   _mm_cmpge_pd( position23, zero ),
+                                   _mm_cmple_pd( position23, top ) );
+        inside = _mm_and_ps( inside,
+                   _mm_shuffle_ps( _mm_castpd_ps( inside01 ),
+                                   _mm_castpd_ps( inside23 ),
+                                   _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+
+        const __m128d clamped01 =
+                   _mm_min_pd( _mm_max_pd( position01, zero ), top );
+        const __m128d clamped23 =
+                   _mm_min_pd( _mm_max_pd( position23, zero ), top );
+        const __m128d floor01 = _mm_min_pd(
+                   _mm_cvtepi32_pd( _mm_cvttpd_epi32( clamped01 ) ), last );
+        const __m128d floor23 = _mm_min_pd(
+                   _mm_cvtepi32_pd( _mm_cvttpd_epi32( clamped23 ) ), last );
+
+        fraction[d] = _mm_movelh_ps(
+                   _mm_cvtpd_ps( _mm_sub_pd( clamped01, floor01 ) ),
+                   _mm_cvtpd_ps( _mm_sub_pd( clamped23, floor23 ) ) );
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( index[d] ),
+                          _mm_unpacklo_epi64( _mm_cvttpd_epi32( floor01 ),
+                                              _mm_cvttpd_epi32( floor23 ) ) );
+        }
+
+      // Nothing to gather when the four columns are outside of the image
+      __m128 value = _mm_setzero_ps();
+
+      if( _mm_movemask_ps( inside ) != 0 )
+        {
+        const MRPixelType * p[4];
+        for( unsigned int k = 0; k < 4; k++ )
+          {
+          p[k] = data + index[0][k] * stride[0] + index[1][k] * stride[1]
+                      + index[2][k] * stride[2];
+          }
+
+        // Voxels of 8 or 16 bits are gathered as integers and converted
+        // four at a time
+        __m128 v[8];
+        for( unsigned int c = 0; c < 8; c++ )
+          {
+          if( smallIntegers )
+            {
+            v[c] = _mm_cvtepi32_ps( _mm_setr_epi32(
+                                 static_cast< int >( p[0][ corner[c] ] ),
+                                 static_cast< int >( p[1][ corner[c] ] ),
+                                 static_cast< int >( p[2][ corner[c] ] ),
+                                 static_cast< int >( p[3][ corner[c] ] ) ) );
+            }
+          else
+            {
+            v[c] = _mm_setr_ps( static_cast< float >( p[0][ corner[c] ] ),
+                                static_cast< float >( p[1][ corner[c] ] ),
+                                static_cast< float >( p[2][ corner[c] ] ),
+                                static_cast< float >( p[3][ corner[c] ] ) );
+            }
+          }
+
+        const __m128 c00 = _mm_add_ps( v[0],
+                     _mm_mul_ps( fraction[0], _mm_sub_ps( v[1], v[0] ) ) );
+        const __m128 c10 = _mm_add_ps( v[2],
+                     _mm_mul_ps( fraction[0], _mm_sub_ps( v[3], v[2] ) ) );
+        const __m128 c01 = _mm_add_ps( v[4],
+                     _mm_mul_ps( fraction[0], _mm_sub_ps( v[5], v[4] ) ) );
+        const __m128 c11 = _mm_add_ps( v[6],
+                     _mm_mul_ps( fraction[0], _mm_sub_ps( v[7], v[6] ) ) );
+        const __m128 c0 = _mm_add_ps( c00,
+                     _mm_mul_ps( fraction[1], _mm_sub_ps( c10, c00 ) ) );
+        const __m128 c1 = _mm_add_ps( c01,
+                     _mm_mul_ps( fraction[1], _mm_sub_ps( c11, c01 ) ) );
+        value = _mm_and_ps( inside, _mm_add_ps( c0,
+                     _mm_mul_ps( fraction[2], _mm_sub_ps( c1, c0 ) ) ) );
+        }
+
+      if( automatic )
+        {
+        _mm_storeu_ps( samples + i, value );
+        groupMinimum = _mm_min_ps( groupMinimum, value );
+        groupMaximum = _mm_max_ps( groupMaximum, value );
+        continue;
+        }
+
+      const __m128 white = _mm_set1_ps( 255.0f );
+      __m128 level = _mm_add_ps( _mm_mul_ps(
+                       _mm_sub_ps( value, _mm_set1_ps( windowMinimum ) ),
+                       _mm_set1_ps( windowScale ) ), _mm_set1_ps( 0.5f ) );
+      level = _mm_min_ps( _mm_max_ps( level, _mm_setzero_ps() ), white );
+      __m128i levels = _mm_cvttps_epi32( level );
+
+      if( modulated )
+        {
+        // The product of a level and a gain is below 2^24, exact in single
+        // precision, and the division by 256 is exact as well.
+        const __m128i * gains4 =
+                           reinterpret_cast< const __m128i * >( gain + i );
+        const __m128i gains = _mm_unpacklo_epi16( _mm_loadl_epi64( gains4 ),
+                                                  _mm_setzero_si128() );
+        const __m128 product = _mm_mul_ps( _mm_cvtepi32_ps( levels ),
+                                           _mm_cvtepi32_ps( gains ) );
+        const __m128 shifted =
+                   _mm_mul_ps( product, _mm_set1_ps( 1.0f / 256.0f ) );
+        levels = _mm_cvttps_epi32( _mm_min_ps( shifted, white ) );
+        }
+
+      levels = _mm_packs_epi32( levels, levels );
+      levels = _mm_packus_epi16( levels, levels );
+      const int packed = _mm_cvtsi128_si32( levels );
+      std::memcpy( out + i, &packed, 4 );
+      }
+#endif
+
+    for( ; i < end; i++ )
+      {
+      const double x = rowStart[0] + i * columnStep[0];
+      const double y = rowStart[1] + i * columnStep[1];
+      const double z = rowStart[2] + i * columnStep[2];
+
+      float value = 0.0f;
+
+      if( x >= 0.0 && y >= 0.0 && z >= 0.0 &&
+          x <= upper[0] && y <= upper[1] && z <= upper[2] )
+        {
+        const int ix = std::min( static_cast< int >( x ), lastIndex[0] );
+        const int iy = std::min( static_cast< int >( y ), lastIndex[1] );
+        const int iz = std::min( static_cast< int >( z ), lastIndex[2] );
+        const float fx = static_cast< float >( x - ix );
+        const float fy = static_cast< float >( y - iy );
+        const float fz = static_cast< float >( z - iz );
+
+        const MRPixelType * p = data + ix * stride[0] + iy * stride[1]
+                                     + iz * stride[2];
+
+        float v[8];
+        for( unsigned int c = 0; c < 8; c++ )
+          {
+          v[c] = static_cast< float >( p[ corner[c] ] );
+          }
+
+        const float c00 = v[0] + fx * ( v[1] - v[0] );
+        const float c10 = v[2] + fx * ( v[3] - v[2] );
+        const float c01 = v[4] + fx * ( v[5] - v[4] );
+        const float c11 = v[6] + fx * ( v[7] - v[6] );
+        const float c0  = c00 + fy * ( c10 - c00 );
+        const float c1  = c01 + fy * ( c11 - c01 );
+
+        value = c0 + fz * ( c1 - c0 );
+        }
+
+      if( automatic )
+        {
+        samples[i] = value;
+        minimum = std::min( minimum, value );
+        maximum = std::max( maximum, value );
+        }
+      else
+        {
+        float level = ( value - windowMinimum ) * windowScale + 0.5f;
+        level = std::max( 0.0f, std::min( level, 255.0f ) );
+        unsigned int intensity = static_cast< unsigned int >( level );
+        if( modulated )
+          {
+          intensity = std::min( 255u, ( intensity * gain[i] ) >> 8 );
+          }
+        out[i] = static_cast< unsigned char >( intensity );
+        }
+      }
+    }
+
+#if defined(IGSTK_ULTRASOUND_SIMULATOR_SSE2)
+  float lanes[4];
+  _mm_storeu_ps( lanes, groupMinimum );
+  minimum = std::min( std::min( minimum, lanes[0] ),
+                      std::min( std::min( lanes[1], lanes[2] ), lanes[3] ) );
+  _mm_storeu_ps( lanes, groupMaximum );
+  maximum = std::max( std::max( maximum, lanes[0] ),
+                      std::max( std::max( lanes[1], lanes[2] ), lanes[3] ) );
+#endif
+
+  m_ThreadMinimum[threadId] = minimum;
+  m_ThreadMaximum[threadId] = maximum;
+}
+
+template < class TImageGeometricModel >
+void 
+UltrasoundImageSimulator< TImageGeometricModel >
+::MapRows( int firstRow, int lastRow )
+{
+  const int width = m_OutputSize[0];
+  const bool modulated = !m_Gain.empty();
+  const float minimum = m_SliceMinimum;
+  const float scale = m_SliceScale;
+
+  const float * samples = &m_Samples[ firstRow * width ];
+  unsigned char * out = m_RescaledUSImage->GetBufferPointer()
+                                                      + firstRow * width;
+  const unsigned int count = ( lastRow - firstRow ) * width;
+
+  if( modulated )
+    {
+    const unsigned short * gain = &m_Gain[ firstRow * width ];
+    for( unsigned int k = 0; k < count; k++ )
+      {
+      const unsigned int level =
+        static_cast< unsigned int >( ( samples[k] - minimum ) * scale + 0.5f );
+      out[k] = static_cast< unsigned char >(
+                                 std::min( 255u, ( level * gain[k] ) >> 8 ) );
+      }
+    }
+  else
+    {
+    for( unsigned int k = 0; k < count; k++ )
+      {
+      out[k] = static_cast< unsigned char >(
+                                 ( samples[k] - minimum ) * scale + 0.5f );
+      }
+    }
+}
+
+template < class TImageGeometricModel >
+ITK_THREAD_RETURN_TYPE
+UltrasoundImageSimulator< TImageGeometricModel >
+::ResliceThreaderCallback( void * arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct  ThreadInfoType;
+  ThreadInfoType * info = static_cast< ThreadInfoType * >( arg );
+  Self * self = static_cast< Self * >( info->UserData );
+
+  const int rows = self->m_OutputSize[1];
+  const int firstRow = rows * info->ThreadID / info->NumberOfThreads;
+  const int lastRow = rows * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  if( self->m_ResliceStage == 0 )
+    {
+    self->SampleRows( firstRow, lastRow, info->ThreadID );
+    }
+  else
+    {
+    self->MapRows( firstRow, lastRow );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 
 /** Null Operation for a State Machine Transition */
 template < class TImageGeometricModel >
@@ -388,9 +1147,6 @@ UltrasoundImageSimulator< TImageGeometricModel >
       }
     }
 
-
-  m_ImageReslice->SetInput ( m_ImageData );
-  m_ReslicedImageData = m_ImageReslice->GetOutput();
 }
 
 
@@ -407,6 +1163,17 @@ UltrasoundImageSimulator< TImageGeometricModel >
   os << indent << this->m_USImage.GetPointer() << std::endl;
   os << indent << "RescaledUSImage";
   os << indent << this->m_RescaledUSImage.GetPointer() << std::endl;
+  os << indent << "AutomaticIntensityWindow: "
+     << this->m_AutomaticIntensityWindow << std::endl;
+  os << indent << "IntensityMinimum: " << this->m_IntensityMinimum << std::endl;
+  os << indent << "IntensityMaximum: " << this->m_IntensityMaximum << std::endl;
+  os << indent << "FanMaskEnabled: " << this->m_FanMaskEnabled << std::endl;
+  os << indent << "FanAngle: " << this->m_FanAngle << std::endl;
+  os << indent << "FanDepth: " << this->m_FanDepth << std::endl;
+  os << indent << "AttenuationCoefficient: "
+     << this->m_AttenuationCoefficient << std::endl;
+  os << indent << "SpeckleAmount: " << this->m_SpeckleAmount << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
 }
   
 template < class TImageGeometricModel >
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkVesselTreeLODActor.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkVesselTreeLODActor.h"
+#include "vtkObjectFactory.h"
+#include "vtkRenderer.h"
+#include "vtkCamera.h"
+#include "vtkMapper.h"
+#include "vtkMatrix4x4.h"
+#include "vtkProperty.h"
+
+#include <cmath>
+
+
+namespace igstk {
+
+vtkCxxRevisionMacro (VesselTreeLODActor, "1.1");
+vtkStandardNewMacro (VesselTreeLODActor);
+
+
+VesselTreeLODActor
+::VesselTreeLODActor()
+{
+  // vtkActor::New() returns the actor of the rendering backend
+  m_Device = vtkActor::New();
+  vtkMatrix4x4 * matrix = vtkMatrix4x4::New();
+  m_Device->SetUserMatrix( matrix );
+  matrix->Delete();
+
+  m_RenderedLevelOfDetail = 0;
+}
+
+VesselTreeLODActor
+::~VesselTreeLODActor()
+{
+  this->RemoveLevelsOfDetail();
+  m_Device->Delete();
+}
+
+void
+VesselTreeLODActor
+::AddLevelOfDetail( vtkMapper * mapper, double distance )
+{
+  if( !mapper )
+    {
+    return;
+    }
+  mapper->Register( this );
+  m_Mappers.push_back( mapper );
+  m_Distances.push_back( distance );
+  this->Modified();
+}
+
+void
+VesselTreeLODActor
+::RemoveLevelsOfDetail()
+{
+  for( unsigned int i = 0; i < m_Mappers.size(); i++ )
+    {
+    m_Mappers[i]->UnRegister( this );
+    }
+  m_Mappers.clear();
+  m_Distances.clear();
+  m_RenderedLevelOfDetail = 0;
+  this->Modified();
+}
+
+unsigned int
+VesselTreeLODActor
+::GetNumberOfLevelsOfDetail() const
+{
+  return static_cast< unsigned int >( m_Mappers.size() ) + 1;
+}
+
+unsigned int
+VesselTreeLODActor
+::GetRenderedLevelOfDetail() const
+{
+  return m_RenderedLevelOfDetail;
+}
+
+unsigned int
+VesselTreeLODActor
+::SelectLevelOfDetail( const double cameraPosition[3] )
+{
+  if( m_Mappers.empty() || !this->Mapper )
+    {
+    return 0;
+    }
+
+  const double * center = this->GetCenter();
+
+  double distance = 0.0;
+  for( unsigned int axis = 0; axis < 3; axis++ )
+    {
+    const double difference = cameraPosition[axis] - center[axis];
+    distance += difference * difference;
+    }
+  distance = sqrt( distance );
+
+  unsigned int level = 0;
+  while( level < m_Distances.size() && distance > m_Distances[level] )
+    {
+    level++;
+    }
+  return level;
+}
+
+void
+VesselTreeLODActor
+::Render( vtkRenderer * renderer, vtkMapper * mapper )
+{
+  vtkMapper * selectedMapper = mapper;
+
+  m_RenderedLevelOfDetail = 0;
+  vtkCamera * camera = renderer->GetActiveCamera();
+  if( camera && mapper == this->Mapper )
+    {
+    m_RenderedLevelOfDetail = this->SelectLevelOfDetail(
+                                                    camera->GetPosition() );
+    if( m_RenderedLevelOfDetail > 0 )
+      {
+      selectedMapper = m_Mappers[ m_RenderedLevelOfDetail - 1 ];
+      }
+    }
+
+  // The property and the texture were already rendered by
+  // RenderOpaqueGeometry(). The device only shares them.
+  m_Device->SetProperty( this->GetProperty() );
+  if( this->BackfaceProperty )
+    {
+    m_Device->SetBackfaceProperty( this->BackfaceProperty );
+    }
+  this->GetMatrix( m_Device->GetUserMatrix() );
+
+  m_Device->Render( renderer, selectedMapper );
+  this->EstimatedRenderTime = selectedMapper->GetTimeToDraw();
+}
+
+void
+VesselTreeLODActor
+::ReleaseGraphicsResources( vtkWindow * window )
+{
+  this->Superclass::ReleaseGraphicsResources( window );
+  m_Device->ReleaseGraphicsResources( window );
+  for( unsigned int i = 0; i < m_Mappers.size(); i++ )
+    {
+    m_Mappers[i]->ReleaseGraphicsResources( window );
+    }
+}
+
+void
+VesselTreeLODActor
+::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf( os, indent );
+  os << indent << "Number of levels of detail: "
+     << this->GetNumberOfLevelsOfDetail() << endl;
+  for( unsigned int i = 0; i < m_Distances.size(); i++ )
+    {
+    os << indent << "Level " << i + 1 << " beyond: " << m_Distances[i]
+       << endl;
+    }
+  os << indent << "Rendered level of detail: " << m_RenderedLevelOfDetail
+     << endl;
+}
+
+
+} // end of IGSTK namespace
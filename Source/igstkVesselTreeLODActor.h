@@ -0,0 +1,98 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkVesselTreeLODActor.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __igstkVesselTreeLODActor_h
+#define __igstkVesselTreeLODActor_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4018 )
+//Warning about: identifier was truncated to '255' characters in the debug
+//information (MVC6.0 Debug)
+#pragma warning( disable : 4284 )
+#endif
+
+#include "vtkActor.h"
+
+#include <vector>
+
+namespace igstk
+{
+
+/** \class VesselTreeLODActor
+ * \brief Actor that renders coarser mappers as the camera moves away.
+ *
+ * The mapper of the actor is the finest level of detail. It defines the
+ * bounds of the actor and is the one used by the pickers. Coarser levels
+ * are added with the distance from the camera to the center of the actor
+ * beyond which they are rendered. Unlike vtkLODActor, the level does not
+ * depend on the time allocated to the render, so that a view shows the same
+ * geometry from one frame to the next.
+ *
+ * \ingroup ObjectRepresentation
+ */
+class VesselTreeLODActor : public vtkActor
+{
+public:
+
+  static VesselTreeLODActor * New();
+
+  vtkTypeRevisionMacro(VesselTreeLODActor,vtkActor);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /** Add a coarser level, rendered when the camera is farther than the
+   *  given distance. Levels are added from the finest to the coarsest. */
+  void AddLevelOfDetail( vtkMapper * mapper, double distance );
+
+  /** Remove the levels added to the mapper of the actor */
+  void RemoveLevelsOfDetail();
+
+  /** Number of levels, including the mapper of the actor */
+  unsigned int GetNumberOfLevelsOfDetail() const;
+
+  /** Level to render for a camera at the given position. The mapper of the
+   *  actor is level 0. */
+  unsigned int SelectLevelOfDetail( const double cameraPosition[3] );
+
+  /** Level used by the last render */
+  unsigned int GetRenderedLevelOfDetail() const;
+
+  /** Render the level selected by the active camera of the renderer */
+  virtual void Render( vtkRenderer * renderer, vtkMapper * mapper );
+
+  virtual void ReleaseGraphicsResources( vtkWindow * window );
+
+protected:
+  VesselTreeLODActor();
+  virtual ~VesselTreeLODActor();
+
+private:
+  VesselTreeLODActor(const VesselTreeLODActor&);  // Not implemented.
+  void operator=(const VesselTreeLODActor&);  // Not implemented.
+
+  /** Actor of the rendering backend that draws the selected mapper */
+  vtkActor *                  m_Device;
+
+  std::vector< vtkMapper * >  m_Mappers;
+  std::vector< double >       m_Distances;
+
+  unsigned int                m_RenderedLevelOfDetail;
+};
+
+
+} // end namespace igstk
+
+
+#endif
@@ -0,0 +1,560 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkVesselTreeObjectRepresentation.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "igstkVesselTreeObjectRepresentation.h"
+#include "igstkVesselTreeLODActor.h"
+#include "igstkTransformObserver.h"
+#include "igstkEvents.h"
+#include "vnl/vnl_math.h"
+
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkFloatArray.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace igstk
+{
+
+namespace
+{
+
+/** Normalize a vector. Returns false for a null vector. */
+bool VesselTreeNormalize( double vector[3] )
+{
+  const double norm = sqrt( vector[0] * vector[0] + vector[1] * vector[1] +
+                            vector[2] * vector[2] );
+  if( norm < 1e-12 )
+    {
+    return false;
+    }
+  vector[0] /= norm;
+  vector[1] /= norm;
+  vector[2] /= norm;
+  return true;
+}
+
+/** Normal to a tangent, from the axis least aligned with it */
+void VesselTreeInitialNormal( const double tangent[3], double normal[3] )
+{
+  unsigned int axis = 0;
+  for( unsigned int i = 1; i < 3; i++ )
+    {
+    if( fabs( tangent[i] ) < fabs( tangent[axis] ) )
+      {
+      axis = i;
+      }
+    }
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    normal[i] = -tangent[axis] * tangent[i];
+    }
+  normal[axis] += 1.0;
+  VesselTreeNormalize( normal );
+}
+
+}
+
+/** Constructor */
+VesselTreeObjectRepresentation::VesselTreeObjectRepresentation():
+  m_StateMachine(this)
+{
+  m_GroupObject = NULL;
+  this->RequestSetSpatialObject( m_GroupObject );
+
+  m_NumberOfSides = 8;
+  m_LevelOfDetailFactor = 1.5;
+
+  igstkAddInputMacro( ValidGroupObject );
+  igstkAddInputMacro( NullGroupObject  );
+
+  igstkAddStateMacro( NullGroupObject     );
+  igstkAddStateMacro( ValidGroupObject    );
+
+  igstkAddTransitionMacro( NullGroupObject, NullGroupObject,
+                           NullGroupObject,  No );
+  igstkAddTransitionMacro( NullGroupObject, ValidGroupObject,
+                           ValidGroupObject,  SetGroupObject );
+  igstkAddTransitionMacro( ValidGroupObject, NullGroupObject,
+                           NullGroupObject,  No );
+  igstkAddTransitionMacro( ValidGroupObject, ValidGroupObject,
+                           ValidGroupObject,  No );
+
+  igstkSetInitialStateMacro( NullGroupObject );
+
+  m_StateMachine.SetReadyToRun();
+}
+
+/** Destructor */
+VesselTreeObjectRepresentation::~VesselTreeObjectRepresentation()
+{
+  // This must be called in order to avoid Memory Leaks.
+  this->DeleteActors();
+}
+
+/** Set the group of tubes */
+void VesselTreeObjectRepresentation
+::RequestSetGroupObject( const GroupObjectType * group )
+{
+  m_GroupObjectToAdd = group;
+  if( !m_GroupObjectToAdd )
+    {
+    igstkPushInputMacro( NullGroupObject );
+    m_StateMachine.ProcessInputs();
+    }
+  else
+    {
+    igstkPushInputMacro( ValidGroupObject );
+    m_StateMachine.ProcessInputs();
+    }
+}
+
+/** Null operation for a State Machine transition */
+void VesselTreeObjectRepresentation::NoProcessing()
+{
+}
+
+/** Set the group of tubes */
+void VesselTreeObjectRepresentation::SetGroupObjectProcessing()
+{
+  m_GroupObject = m_GroupObjectToAdd;
+  this->RequestSetSpatialObject( m_GroupObject );
+}
+
+/** Set the number of sides around the tubes */
+void VesselTreeObjectRepresentation
+::SetNumberOfSides( unsigned int numberOfSides )
+{
+  m_NumberOfSides = std::max( numberOfSides, 3u );
+}
+
+/** Set the distance factor of the levels of detail */
+void VesselTreeObjectRepresentation::SetLevelOfDetailFactor( double factor )
+{
+  if( factor > 0.0 )
+    {
+    m_LevelOfDetailFactor = factor;
+    }
+}
+
+/** Number of tubes merged by the last call to CreateActors() */
+unsigned int VesselTreeObjectRepresentation::GetNumberOfTubes() const
+{
+  return static_cast< unsigned int >( m_Tubes.size() );
+}
+
+/** Return a merged tube */
+const VesselTreeObjectRepresentation::TubeObjectType *
+VesselTreeObjectRepresentation::GetTube( unsigned int tubeIndex ) const
+{
+  if( tubeIndex >= m_Tubes.size() )
+    {
+    return NULL;
+    }
+  return m_Tubes[tubeIndex];
+}
+
+/** Return the tube of a cell of the finest level */
+int VesselTreeObjectRepresentation::GetTubeIndex( vtkIdType cellId ) const
+{
+  if( m_FirstCellOfTubes.empty() || cellId < 0 ||
+      cellId >= m_FirstCellOfTubes.back() )
+    {
+    return -1;
+    }
+  std::vector< vtkIdType >::const_iterator next =
+    std::upper_bound( m_FirstCellOfTubes.begin(), m_FirstCellOfTubes.end(),
+                      cellId );
+  return static_cast< int >( next - m_FirstCellOfTubes.begin() ) - 1;
+}
+
+/** Print Self function */
+void VesselTreeObjectRepresentation
+::PrintSelf( std::ostream& os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfSides: " << m_NumberOfSides << std::endl;
+  os << indent << "LevelOfDetailFactor: " << m_LevelOfDetailFactor
+     << std::endl;
+  os << indent << "NumberOfTubes: " << m_Tubes.size() << std::endl;
+}
+
+/** Update the visual representation in response to changes in the geometric
+ * object */
+void VesselTreeObjectRepresentation::UpdateRepresentationProcessing()
+{
+  igstkLogMacro( DEBUG, "UpdateRepresentationProcessing called ....\n");
+}
+
+/** Collect the tubes of a group and of its sub-groups */
+void VesselTreeObjectRepresentation
+::CollectTubes( const GroupObjectType * group, const Transform & groupToTree )
+{
+  // This const_cast is needed because the children of a group are only
+  // returned through events, in response to a request.
+  GroupObjectType * requestedGroup = const_cast< GroupObjectType * >( group );
+
+  ChildObserver::Pointer childObserver = ChildObserver::New();
+  const unsigned long childObserverID =
+    requestedGroup->AddObserver( SpatialObjectModifiedEvent(), childObserver );
+
+  TransformObserver::Pointer transformObserver = TransformObserver::New();
+
+  const unsigned long numberOfChildren = group->GetNumberOfChildren();
+  for( unsigned long childId = 0; childId < numberOfChildren; childId++ )
+    {
+    childObserver->Reset();
+    requestedGroup->RequestGetChild( childId );
+    if( !childObserver->GotChild() )
+      {
+      continue;
+      }
+    SpatialObject::Pointer child = childObserver->GetChild();
+
+    transformObserver->Clear();
+    const unsigned long transformObserverID = child->AddObserver(
+      TransformObserver::PositiveEventType(), transformObserver );
+    child->RequestGetTransformToParent();
+    child->RemoveObserver( transformObserverID );
+
+    Transform childToTree = groupToTree;
+    if( transformObserver->GotTransform() )
+      {
+      childToTree = Transform::TransformCompose( groupToTree,
+                                           transformObserver->GetTransform() );
+      }
+
+    const TubeObjectType * tube =
+      dynamic_cast< const TubeObjectType * >( child.GetPointer() );
+    if( tube )
+      {
+      m_Tubes.push_back( tube );
+      m_TubeTransforms.push_back( childToTree );
+      continue;
+      }
+
+    const GroupObjectType * subGroup =
+      dynamic_cast< const GroupObjectType * >( child.GetPointer() );
+    if( subGroup )
+      {
+      this->CollectTubes( subGroup, childToTree );
+      }
+    }
+
+  requestedGroup->RemoveObserver( childObserverID );
+}
+
+/** Sweep the surfaces of all the tubes into a single polydata */
+vtkPolyData * VesselTreeObjectRepresentation
+::CreateSurface( unsigned int numberOfSides, unsigned int samplingStep,
+                 bool keepCellOffsets )
+{
+  typedef TubeObjectType::PointType            TubePointType;
+  typedef TubePointType::PointType             PositionType;
+
+  // Directions of the sides in the frame of the centerline
+  std::vector< double > cosines( numberOfSides );
+  std::vector< double > sines( numberOfSides );
+  const double angleStep = 2.0 * vnl_math::pi / numberOfSides;
+  for( unsigned int side = 0; side < numberOfSides; side++ )
+    {
+    cosines[side] = cos( side * angleStep );
+    sines[side] = sin( side * angleStep );
+    }
+
+  unsigned long numberOfSamples = 0;
+  for( unsigned int t = 0; t < m_Tubes.size(); t++ )
+    {
+    numberOfSamples += m_Tubes[t]->GetNumberOfPoints() / samplingStep + 2;
+    }
+
+  vtkPoints * points = vtkPoints::New();
+  points->Allocate( ( numberOfSamples + 2 * m_Tubes.size() ) *
+                    numberOfSides );
+  vtkFloatArray * normals = vtkFloatArray::New();
+  normals->SetNumberOfComponents( 3 );
+  normals->Allocate( 3 * ( numberOfSamples + 2 * m_Tubes.size() ) *
+                     numberOfSides );
+  vtkCellArray * polys = vtkCellArray::New();
+  polys->Allocate( polys->EstimateSize( numberOfSamples * numberOfSides, 4 ) );
+
+  if( keepCellOffsets )
+    {
+    m_FirstCellOfTubes.assign( 1, 0 );
+    }
+
+  std::vector< double >     centers;
+  std::vector< double >     radii;
+  std::vector< double >     frames;
+  std::vector< vtkIdType >  cap( numberOfSides );
+  vtkIdType                 numberOfCells = 0;
+
+  for( unsigned int t = 0; t < m_Tubes.size(); t++ )
+    {
+    const TubeObjectType * tube = m_Tubes[t];
+    const Transform & transform = m_TubeTransforms[t];
+    const unsigned int numberOfPoints = tube->GetNumberOfPoints();
+
+    // Sample the centerline in the coordinate system of the tree, without
+    // the duplicated points
+    centers.clear();
+    radii.clear();
+    for( unsigned int i = 0; i < numberOfPoints; i++ )
+      {
+      if( i % samplingStep != 0 && i != numberOfPoints - 1 )
+        {
+        continue;
+        }
+      const TubePointType * point = tube->GetPoint( i );
+      PositionType position =
+        transform.GetRotation().Transform( point->GetPosition() ) +
+        transform.GetTranslation();
+
+      const unsigned int last = static_cast<unsigned int>( centers.size() );
+      if( last > 0 &&
+          fabs( position[0] - centers[ last - 3 ] ) +
+          fabs( position[1] - centers[ last - 2 ] ) +
+          fabs( position[2] - centers[ last - 1 ] ) < 1e-6 )
+        {
+        continue;
+        }
+      centers.push_back( position[0] );
+      centers.push_back( position[1] );
+      centers.push_back( position[2] );
+      radii.push_back( std::max( point->GetRadius() * 0.95, 0.0001 ) );
+      }
+
+    const unsigned int numberOfRings =
+      static_cast< unsigned int >( radii.size() );
+    if( numberOfRings < 2 )
+      {
+      if( keepCellOffsets )
+        {
+        m_FirstCellOfTubes.push_back( numberOfCells );
+        }
+      continue;
+      }
+
+    // Frames transported along the centerline: tangent, normal, binormal
+    frames.resize( 9 * numberOfRings );
+    for( unsigned int ring = 0; ring < numberOfRings; ring++ )
+      {
+      const unsigned int previous = ( ring > 0 ) ? ring - 1 : 0;
+      const unsigned int next = std::min( ring + 1, numberOfRings - 1 );
+      double * tangent = &frames[ 9 * ring ];
+      double * normal = tangent + 3;
+      double * binormal = tangent + 6;
+      for( unsigned int axis = 0; axis < 3; axis++ )
+        {
+        tangent[axis] = centers[ 3 * next + axis ] -
+                        centers[ 3 * previous + axis ];
+        }
+      VesselTreeNormalize( tangent );
+
+      bool transported = false;
+      if( ring > 0 )
+        {
+        const double * previousNormal = &frames[ 9 * ( ring - 1 ) + 3 ];
+        const double dot = previousNormal[0] * tangent[0] +
+                           previousNormal[1] * tangent[1] +
+                           previousNormal[2] * tangent[2];
+        for( unsigned int axis = 0; axis < 3; axis++ )
+          {
+          normal[axis] = previousNormal[axis] - dot * tangent[axis];
+          }
+        transported = VesselTreeNormalize( normal );
+        }
+      if( !transported )
+        {
+        VesselTreeInitialNormal( tangent, normal );
+        }
+
+      binormal[0] = tangent[1] * normal[2] - tangent[2] * normal[1];
+      binormal[1] = tangent[2] * normal[0] - tangent[0] * normal[2];
+      binormal[2] = tangent[0] * normal[1] - tangent[1] * normal[0];
+      }
+
+    // Rings of points around the centerline, then the points of the caps
+    // with the normals of the ends
+    const vtkIdType firstPoint = points->GetNumberOfPoints();
+    for( unsigned int ring = 0; ring < numberOfRings + 2; ring++ )
+      {
+      const unsigned int sample = ( ring < numberOfRings ) ? ring :
+        ( ring - numberOfRings ) * ( numberOfRings - 1 );
+      const double * center = &centers[ 3 * sample ];
+      const double * tangent = &frames[ 9 * sample ];
+      const double * normal = tangent + 3;
+      const double * binormal = tangent + 6;
+      const double capSign = ( sample == 0 ) ? -1.0 : 1.0;
+
+      for( unsigned int side = 0; side < numberOfSides; side++ )
+        {
+        double direction[3];
+        for( unsigned int axis = 0; axis < 3; axis++ )
+          {
+          direction[axis] = cosines[side] * normal[axis] +
+                            sines[side] * binormal[axis];
+          }
+        points->InsertNextPoint(
+          center[0] + radii[sample] * direction[0],
+          center[1] + radii[sample] * direction[1],
+          center[2] + radii[sample] * direction[2] );
+        if( ring < numberOfRings )
+          {
+          normals->InsertNextTuple( direction );
+          }
+        else
+          {
+          normals->InsertNextTuple3( capSign * tangent[0],
+                                     capSign * tangent[1],
+                                     capSign * tangent[2] );
+          }
+        }
+      }
+
+    // Quadrilaterals between consecutive rings
+    for( unsigned int ring = 0; ring + 1 < numberOfRings; ring++ )
+      {
+      const vtkIdType first = firstPoint + ring * numberOfSides;
+      for( unsigned int side = 0; side < numberOfSides; side++ )
+        {
+        const unsigned int nextSide = ( side + 1 ) % numberOfSides;
+        vtkIdType quad[4];
+        quad[0] = first + side;
+        quad[1] = first + nextSide;
+        quad[2] = first + numberOfSides + nextSide;
+        quad[3] = first + numberOfSides + side;
+        polys->InsertNextCell( 4, quad );
+        }
+      }
+
+    // Caps, facing away from the tube
+    const vtkIdType firstCap = firstPoint + numberOfRings * numberOfSides;
+    for( unsigned int side = 0; side < numberOfSides; side++ )
+      {
+      cap[side] = firstCap + numberOfSides - 1 - side;
+      }
+    polys->InsertNextCell( numberOfSides, &cap[0] );
+    for( unsigned int side = 0; side < numberOfSides; side++ )
+      {
+      cap[side] = firstCap + numberOfSides + side;
+      }
+    polys->InsertNextCell( numberOfSides, &cap[0] );
+
+    numberOfCells += ( numberOfRings - 1 ) * numberOfSides + 2;
+    if( keepCellOffsets )
+      {
+      m_FirstCellOfTubes.push_back( numberOfCells );
+      }
+    }
+
+  vtkPolyData * surface = vtkPolyData::New();
+  surface->SetPoints( points );
+  surface->SetPolys( polys );
+  surface->GetPointData()->SetNormals( normals );
+
+  points->Delete();
+  normals->Delete();
+  polys->Delete();
+
+  return surface;
+}
+
+/** Create the vtk Actors */
+void VesselTreeObjectRepresentation::CreateActors()
+{
+  // to avoid duplicates we clean the previous actors
+  this->DeleteActors();
+
+  m_Tubes.clear();
+  m_TubeTransforms.clear();
+  m_FirstCellOfTubes.clear();
+
+  if( !m_GroupObject )
+    {
+    return;
+    }
+
+  Transform identity;
+  this->CollectTubes( m_GroupObject, identity );
+
+  vtkPolyData * surface = this->CreateSurface( m_NumberOfSides, 1, true );
+  if( surface->GetNumberOfCells() == 0 )
+    {
+    igstkLogMacro( CRITICAL, "Not enough points to render the tubes.\n" );
+    surface->Delete();
+    return;
+    }
+
+  VesselTreeLODActor * treeActor = VesselTreeLODActor::New();
+
+  vtkPolyDataMapper * mapper = vtkPolyDataMapper::New();
+  mapper->SetInput( surface );
+  mapper->ScalarVisibilityOff();
+  treeActor->SetMapper( mapper );
+  mapper->Delete();
+
+  // The coarser levels skip centerline points and sides
+  double distance = m_LevelOfDetailFactor * surface->GetLength();
+  surface->Delete();
+
+  const unsigned int coarseSides[2] = { std::max( m_NumberOfSides / 2, 3u ),
+                                        3 };
+  const unsigned int samplingSteps[2] = { 2, 4 };
+
+  for( unsigned int level = 0; level < 2; level++ )
+    {
+    vtkPolyData * coarseSurface =
+      this->CreateSurface( coarseSides[level], samplingSteps[level], false );
+    vtkPolyDataMapper * coarseMapper = vtkPolyDataMapper::New();
+    coarseMapper->SetInput( coarseSurface );
+    coarseMapper->ScalarVisibilityOff();
+    treeActor->AddLevelOfDetail( coarseMapper, distance );
+    coarseMapper->Delete();
+    coarseSurface->Delete();
+    distance *= 4.0;
+    }
+
+  treeActor->GetProperty()->SetColor(this->GetRed(),
+                                     this->GetGreen(),
+                                     this->GetBlue());
+  treeActor->GetProperty()->SetOpacity( this->GetOpacity() );
+
+  this->AddActor( treeActor );
+}
+
+/** Create a copy of the current object representation */
+VesselTreeObjectRepresentation::Pointer
+VesselTreeObjectRepresentation::Copy() const
+{
+  Pointer newOR = VesselTreeObjectRepresentation::New();
+  newOR->SetColor(this->GetRed(),this->GetGreen(),this->GetBlue());
+  newOR->SetOpacity(this->GetOpacity());
+  newOR->SetNumberOfSides(this->GetNumberOfSides());
+  newOR->SetLevelOfDetailFactor(this->GetLevelOfDetailFactor());
+  newOR->RequestSetGroupObject(m_GroupObject);
+
+  return newOR;
+}
+
+
+} // end namespace igstk
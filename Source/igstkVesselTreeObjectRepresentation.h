@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkVesselTreeObjectRepresentation.h
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#ifndef __igstkVesselTreeObjectRepresentation_h
+#define __igstkVesselTreeObjectRepresentation_h
+
+#include "igstkMacros.h"
+#include "igstkObjectRepresentation.h"
+#include "igstkGroupObject.h"
+#include "igstkTubeObject.h"
+#include "igstkStateMachine.h"
+
+#include <vtkType.h>
+
+#include <vector>
+
+class vtkPolyData;
+
+namespace igstk
+{
+
+/** \class VesselTreeObjectRepresentation
+ *
+ * \brief This class implements the representation of a tree of vessels
+ * stored as the TubeObjects of a GroupObject.
+ *
+ * TubeObjectRepresentation creates several actors per tube, which does not
+ * scale to segmented vascular trees of thousands of branches. This class
+ * merges the surfaces of all the tubes of the group, and of its sub-groups,
+ * into a single polydata rendered by a single actor. The surfaces are swept
+ * directly along the centerlines, with flat caps at the ends.
+ *
+ * Three levels of detail of the merged surface are built. The finest one
+ * uses every centerline point; the coarser ones skip centerline points and
+ * use fewer sides around the tubes. The actor switches to a coarser level
+ * when the distance from the camera to the center of the tree exceeds the
+ * level of detail factor times the size of the tree, and to the coarsest
+ * beyond four times that distance.
+ *
+ * Picking is done on the finest level. The cells of each tube are
+ * contiguous, and GetTubeIndex() returns the tube that a picked cell
+ * belongs to.
+ *
+ * The tubes are collected when the actors are created, so the tubes added
+ * to the group afterwards are displayed by the copies made for the views
+ * added later, or when the representation is added to a view again.
+ *
+ * \ingroup ObjectRepresentation
+ */
+
+class VesselTreeObjectRepresentation
+: public ObjectRepresentation
+{
+
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( VesselTreeObjectRepresentation,
+                                 ObjectRepresentation )
+
+public:
+
+  typedef GroupObject                    GroupObjectType;
+  typedef TubeObject                     TubeObjectType;
+
+  /** Return a copy of the current object representation */
+  Pointer Copy() const;
+
+  /** Connect this representation class to the group of tubes */
+  void RequestSetGroupObject( const GroupObjectType * group );
+
+  /** Set/Get the number of sides around the tubes at the finest level of
+   *  detail. The default is 8 */
+  void SetNumberOfSides( unsigned int numberOfSides );
+  igstkGetMacro( NumberOfSides, unsigned int );
+
+  /** Set/Get the distance from the camera, in multiples of the diagonal of
+   *  the tree, beyond which a coarser level is rendered. The default
+   *  is 1.5 */
+  void SetLevelOfDetailFactor( double factor );
+  igstkGetMacro( LevelOfDetailFactor, double );
+
+  /** Number of tubes merged by the last call to CreateActors() */
+  unsigned int GetNumberOfTubes() const;
+
+  /** Return a tube merged by the last call to CreateActors() */
+  const TubeObjectType * GetTube( unsigned int tubeIndex ) const;
+
+  /** Return the index of the tube a cell of the finest level belongs to,
+   *  for instance a cell returned by a vtkCellPicker. Returns -1 for an
+   *  invalid cell. */
+  int GetTubeIndex( vtkIdType cellId ) const;
+
+protected:
+
+  /** Constructor */
+  VesselTreeObjectRepresentation( void );
+
+  /** Destructor */
+  ~VesselTreeObjectRepresentation( void );
+
+  /** Print object information */
+  virtual void PrintSelf( std::ostream& os, itk::Indent indent ) const;
+
+  /** Create the VTK actors */
+  void CreateActors();
+
+private:
+
+  /** Collect the tubes of a group and of its sub-groups, with their
+   *  transforms to the coordinate system of the tree */
+  void CollectTubes( const GroupObjectType * group,
+                     const Transform & groupToTree );
+
+  /** Sweep the surfaces of all the tubes. The centerlines are sampled
+   *  every samplingStep points. */
+  vtkPolyData * CreateSurface( unsigned int numberOfSides,
+                               unsigned int samplingStep,
+                               bool keepCellOffsets );
+
+  /** Internal GroupObject */
+  GroupObjectType::ConstPointer   m_GroupObject;
+
+  /** Tubes collected from the group, and their transforms to the tree */
+  std::vector< TubeObjectType::ConstPointer >   m_Tubes;
+  std::vector< Transform >                      m_TubeTransforms;
+
+  /** First cell of each tube in the finest level, followed by the number
+   *  of cells */
+  std::vector< vtkIdType >        m_FirstCellOfTubes;
+
+  unsigned int                    m_NumberOfSides;
+  double                          m_LevelOfDetailFactor;
+
+  /** update the visual representation with changes in the geometry */
+  virtual void UpdateRepresentationProcessing();
+
+  /** Connect this representation class to the spatial object. Only to be
+   * called by the State Machine. */
+  void SetGroupObjectProcessing();
+
+  /** Null operation for a State Machine transition */
+  void NoProcessing();
+
+  /** Observer of the children returned by the groups */
+  igstkObserverObjectMacro( Child, SpatialObjectModifiedEvent, SpatialObject );
+
+private:
+
+  /** Inputs to the State Machine */
+  igstkDeclareInputMacro( ValidGroupObject );
+  igstkDeclareInputMacro( NullGroupObject );
+
+  /** States for the State Machine */
+  igstkDeclareStateMacro( NullGroupObject );
+  igstkDeclareStateMacro( ValidGroupObject );
+
+  GroupObjectType::ConstPointer m_GroupObjectToAdd;
+
+};
+
+
+} // end namespace igstk
+
+#endif // __igstkVesselTreeObjectRepresentation_h
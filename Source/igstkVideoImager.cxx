@@ -22,6 +22,7 @@
 #endif
 
 #include "igstkVideoImager.h"
+#include "igstkRealTimeClock.h"
 
 namespace igstk
 {
@@ -298,6 +299,9 @@ VideoImager::VideoImager(void) :  m_StateMachine( this )
   const double DEFAULT_REFRESH_RATE = 25.0;
   m_PulseGenerator->RequestSetFrequency( DEFAULT_REFRESH_RATE );
 
+  m_Telemetry = DeviceTelemetry::New();
+  m_Telemetry->SetNominalFrequency( DEFAULT_REFRESH_RATE );
+
   // This is the time period for which transformation should be
   // considered valid.  After this time, they expire.  This time
   // is in milliseconds. The default validity time is computed
@@ -523,6 +527,8 @@ void VideoImager::StartImagingSuccessProcessing( void )
     }
 
 
+  m_Telemetry->Reset();
+
   // going from AttemptingToImagingState to ImagingState
   this->EnterImagingStateProcessing();
 
@@ -557,6 +563,7 @@ void VideoImager::AttachingVideoImagerToolSuccessProcessing( void )
   // Add the VideoImager tool to the internal data containers
   this->AddVideoImagerToolToInternalDataContainers(
                                                 m_VideoImagerToolToBeAttached );
+  this->AddTelemetryTool( m_VideoImagerToolToBeAttached );
 
   //connect the VideoImager tool coordinate system to the VideoImager
   //system. By default, make the VideoImager coordinate system to
@@ -705,7 +712,9 @@ void VideoImager::AttemptToUpdateStatusProcessing( void )
     }
   else
     {
-    this->InternalThreadedUpdateStatus();
+    ResultType deviceResult = this->InternalThreadedUpdateStatus();
+    m_Telemetry->RecordDeviceSample( RealTimeClock::GetTimeStamp(),
+                                     deviceResult == SUCCESS );
     }
 
   ResultType result = this->InternalUpdateStatus();
@@ -747,6 +756,23 @@ void VideoImager::UpdateStatusSuccessProcessing( void )
     }
 
   this->InvokeEvent( VideoImagerUpdateStatusEvent() );
+
+  // The latency includes the observers of the frames
+  const TimePeriodType updateTime = RealTimeClock::GetTimeStamp();
+  m_Telemetry->RecordUpdate( updateTime, true );
+
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_TelemetryTools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    m_TelemetryToolUpdated[i] = m_TelemetryTools[i]->GetUpdated();
+    }
+  if( numberOfTools > 0 )
+    {
+    m_Telemetry->RecordToolUpdates( &m_TelemetryToolUpdated[0],
+                                    numberOfTools );
+    }
+  this->ReportTelemetry( updateTime );
 }
 
 /** This method is called when a UpdateStatus failed */
@@ -756,6 +782,58 @@ void VideoImager::UpdateStatusFailureProcessing( void )
                  "called ...\n");
 
   this->InvokeEvent( VideoImagerUpdateStatusErrorEvent() );
+
+  const TimePeriodType updateTime = RealTimeClock::GetTimeStamp();
+  m_Telemetry->RecordUpdate( updateTime, false );
+  this->ReportTelemetry( updateTime );
+}
+
+/** Invoke a telemetry event at the period of the telemetry */
+void VideoImager::ReportTelemetry( TimePeriodType time )
+{
+  if( m_Telemetry->IsReportDue( time ) )
+    {
+    DeviceTelemetryReport report;
+    m_Telemetry->GetReport( report );
+
+    DeviceTelemetryEvent event;
+    event.SetReference( report );
+    this->InvokeEvent( event );
+    }
+}
+
+DeviceTelemetry * VideoImager::GetTelemetry() const
+{
+  return m_Telemetry;
+}
+
+/** Add a tool to the telemetry */
+void
+VideoImager::AddTelemetryTool( VideoImagerToolType * videoImagerTool )
+{
+  m_TelemetryTools.push_back( videoImagerTool );
+  m_TelemetryToolUpdated.push_back( 0 );
+  m_Telemetry->AddTool( videoImagerTool->GetVideoImagerToolIdentifier() );
+}
+
+/** Remove a tool from the telemetry, as the telemetry does: the last tool
+ *  takes its place */
+void
+VideoImager::RemoveTelemetryTool( VideoImagerToolType * videoImagerTool )
+{
+  const unsigned int numberOfTools =
+    static_cast< unsigned int >( m_TelemetryTools.size() );
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    if( m_TelemetryTools[i] == videoImagerTool )
+      {
+      m_TelemetryTools[i] = m_TelemetryTools.back();
+      m_TelemetryTools.pop_back();
+      m_TelemetryToolUpdated.pop_back();
+      m_Telemetry->RemoveTool( i );
+      return;
+      }
+    }
 }
 
 /** The "CloseFromImagingStateProcessing" method closes VideoImager in
@@ -801,6 +879,7 @@ void VideoImager::DetachAllVideoImagerToolsFromVideoImager()
   while( inputItr != inputEnd )
     {
     this->RemoveVideoImagerToolFromInternalDataContainers( inputItr->second );
+    this->RemoveTelemetryTool( inputItr->second );
     ++inputItr;
     }
 
@@ -865,6 +944,8 @@ void VideoImager::PrintSelf( std::ostream& os, itk::Indent indent ) const
     }
 
   os << indent << "ValidityTime: " << this->m_ValidityTime << std::endl;
+  os << indent << "Telemetry: " << std::endl;
+  this->m_Telemetry->Print( os, indent.GetNextIndent() );
   os << indent << "CoordinateSystemDelegator: ";
   this->m_CoordinateSystemDelegator->PrintSelf( os, indent );
 }
@@ -878,6 +959,7 @@ void VideoImager::SetFrequencyProcessing( void )
                  "igstk::VideoImager::SetFrequencyProcessing called ...\n");
 
   this->m_PulseGenerator->RequestSetFrequency( this->m_FrequencyToBeSet );
+  this->m_Telemetry->SetNominalFrequency( this->m_FrequencyToBeSet );
 
   //Set the validity time of the frames based on the VideoImager frequency
   //Add a constant to avoid any flickering effect
@@ -926,6 +1008,7 @@ RequestRemoveTool( VideoImagerToolType * VideoImagerTool )
   this->m_VideoImagerTools.erase(
                               VideoImagerTool->GetVideoImagerToolIdentifier() );
   this->RemoveVideoImagerToolFromInternalDataContainers( VideoImagerTool );
+  this->RemoveTelemetryTool( VideoImagerTool );
   return SUCCESS;
 }
 
@@ -961,6 +1044,8 @@ ITK_THREAD_RETURN_TYPE VideoImager::ImagingThreadFunction(void* pInfoStruct)
   while ( activeFlag )
     {
     ResultType result = pVideoImager->InternalThreadedUpdateStatus();
+    pVideoImager->m_Telemetry->RecordDeviceSample(
+      RealTimeClock::GetTimeStamp(), result == SUCCESS );
     pVideoImager->m_ConditionNextFrameReceived->Signal();
 
     totalCount++;
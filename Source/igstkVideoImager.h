@@ -30,6 +30,7 @@
 #include "igstkTransform.h"
 #include "igstkFrame.h"
 #include "igstkPulseGenerator.h"
+#include "igstkDeviceTelemetry.h"
 #include "igstkVideoImagerTool.h"
 
 #include "igstkCoordinateSystemInterfaceMacros.h"
@@ -123,6 +124,11 @@ public:
    * to follow, then you will start receiving similar frames. */
   void RequestSetFrequency( double frequencyInHz );
 
+  /** Telemetry of the VideoImager: rates, errors, jitter, latency and
+   *  visibility of the tools. While imaging, the VideoImager invokes a
+   *  DeviceTelemetryEvent every report period of the telemetry. */
+  DeviceTelemetry * GetTelemetry() const;
+
 protected:
 
   VideoImager(void);
@@ -330,6 +336,19 @@ private:
   /** Thread function for imaging */
   static ITK_THREAD_RETURN_TYPE ImagingThreadFunction(void* pInfoStruct);
 
+  /** Health and throughput of the imaging. The tools are known to the
+   *  telemetry in the order of m_TelemetryTools. */
+  DeviceTelemetry::Pointer               m_Telemetry;
+  std::vector< VideoImagerToolType * >   m_TelemetryTools;
+  std::vector< unsigned char >           m_TelemetryToolUpdated;
+
+  /** Add and remove a tool from the telemetry */
+  void AddTelemetryTool( VideoImagerToolType * videoImagerTool );
+  void RemoveTelemetryTool( VideoImagerToolType * videoImagerTool );
+
+  /** Invoke a DeviceTelemetryEvent if one is due */
+  void ReportTelemetry( TimePeriodType time );
+
   /** The "UpdateStatus" method is used for updating the status of
       tools when the VideoImager is in imaging state. It is a callback
       method that gets invoked when a pulse event is observed */
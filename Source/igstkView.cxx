@@ -30,6 +30,9 @@
 #include "vtkInteractorStyle.h"
 #include "vtkRenderer.h"
 #include "vtkWorldPointPicker.h"
+#include "vtkPropCollection.h"
+#include "vtkImageActor.h"
+#include "vtkImageData.h"
 
 #if defined(__APPLE__) && defined(VTK_USE_CARBON)
 #include "vtkCarbonRenderWindow.h"
@@ -37,9 +40,12 @@
 
 //igstk include files
 #include "igstkView.h"
+#include "igstkRealTimeClock.h"
 
 #include "itksys/SystemTools.hxx"
 
+#include <sstream>
+
 namespace igstk
 {
 
@@ -250,6 +256,30 @@ m_StateMachine(this)
 
   this->m_PulseGenerator->AddObserver( PulseEvent(), this->m_PulseObserver );
 
+  this->m_RefreshMode = FixedRateRefresh;
+  this->m_MinimumRefreshRate = 5.0;
+  this->m_MaximumSkipPeriod = 1000.0;
+  this->m_LastRenderedModifiedTime = 0;
+  this->m_LastRenderTime = 0.0;
+  this->m_RenderOnNextPulse = true;
+  this->m_NumberOfRenderedFrames = 0;
+  this->m_NumberOfSkippedFrames = 0;
+  this->m_AdaptivePeriodStartTime = 0.0;
+  this->m_AdaptivePeriodPulses = 0;
+  this->m_AdaptivePeriodRenders = 0;
+
+  this->m_FrameTimingEnabled = false;
+  this->m_LastDisplayedTransformTime = 0.0;
+  this->m_FrameTimingAnnotationCorner = 0;
+  this->m_TimingPeriodStartTime = 0.0;
+  this->m_TimingPeriodPulses = 0;
+  this->m_TimingPeriodRenders = 0;
+  this->m_TimingPeriodLatencySamples = 0;
+  this->m_TimingPeriodUpdateTime = 0.0;
+  this->m_TimingPeriodRenderTime = 0.0;
+  this->m_TimingPeriodLatency = 0.0;
+  this->m_TimingPeriodMaximumLateness = 0.0;
+
   this->SetRefreshRate( 30 ); // 30 Hz is rather low frequency for video.
 
   this->m_PickerCoordinateSystem = CoordinateSystem::New();
@@ -593,16 +623,254 @@ SetCameraZoomFactor( double factor )
 void View::SetRefreshRate( double frequencyHz )
 {
   igstkLogMacro( DEBUG, "igstkView::SetRefreshRate() called ...\n");
+  // In AdaptiveRefresh mode this is the highest frequency that will be used
+  this->m_MaximumRefreshRate = frequencyHz;
+  this->m_AdaptivePeriodPulses = 0;
+  this->m_AdaptivePeriodRenders = 0;
   // Let the state machine of the pulse generator manage this request
   this->m_PulseGenerator->RequestSetFrequency( frequencyHz );
 }
 
+/** Select the policy for rendering on the pulses */
+void View::SetRefreshMode( RefreshModeType mode )
+{
+  igstkLogMacro( DEBUG, "igstkView::SetRefreshMode() called ...\n");
+
+  if( this->m_RefreshMode == mode )
+    {
+    return;
+    }
+
+  // Leaving the adaptive mode restores the requested refresh rate
+  if( this->m_RefreshMode == AdaptiveRefresh )
+    {
+    this->m_PulseGenerator->RequestSetFrequency( this->m_MaximumRefreshRate );
+    }
+
+  this->m_RefreshMode = mode;
+  this->m_RenderOnNextPulse = true;
+  this->m_AdaptivePeriodPulses = 0;
+  this->m_AdaptivePeriodRenders = 0;
+}
+
+/** Force the rendering of the next pulse */
+void View::RequestRenderOnNextPulse()
+{
+  igstkLogMacro( DEBUG, "igstkView::RequestRenderOnNextPulse() called ...\n");
+  this->m_RenderOnNextPulse = true;
+}
+
+/** Latest modification time among everything that affects the rendered
+ *  image. */
+unsigned long View::ComputeSceneModifiedTime() const
+{
+  unsigned long sceneTime = this->m_Renderer->GetMTime();
+
+  unsigned long time = this->m_Camera->GetMTime();
+  sceneTime = ( time > sceneTime ) ? time : sceneTime;
+
+  time = this->m_RenderWindow->GetMTime();
+  sceneTime = ( time > sceneTime ) ? time : sceneTime;
+
+  // The props cover the actors of the object representations and of the
+  // annotations. The redraw time includes properties, user matrices,
+  // visibility and the mappers.
+  vtkPropCollection * props = this->m_Renderer->GetViewProps();
+  vtkCollectionSimpleIterator cookie;
+  props->InitTraversal( cookie );
+  vtkProp * prop;
+  while( ( prop = props->GetNextProp( cookie ) ) != NULL )
+    {
+    time = prop->GetRedrawMTime();
+    sceneTime = ( time > sceneTime ) ? time : sceneTime;
+
+    // Image actors are fed by reslicing and color mapping pipelines whose
+    // parameters (slice, window/level) are not reflected in the actor.
+    vtkImageActor * imageActor = vtkImageActor::SafeDownCast( prop );
+    if( imageActor && imageActor->GetVisibility() && imageActor->GetInput() )
+      {
+      imageActor->GetInput()->UpdateInformation();
+      time = imageActor->GetInput()->GetPipelineMTime();
+      sceneTime = ( time > sceneTime ) ? time : sceneTime;
+      }
+    }
+
+  return sceneTime;
+}
+
+/** Display the frame timing in an annotation */
+void View::SetFrameTimingAnnotation( Annotation2D * annotation, int corner )
+{
+  igstkLogMacro( DEBUG, "igstkView::SetFrameTimingAnnotation() called ...\n");
+
+  this->m_FrameTimingAnnotation = annotation;
+  this->m_FrameTimingAnnotationCorner = corner;
+  this->m_TimingPeriodPulses = 0;
+
+  if( annotation )
+    {
+    this->m_FrameTimingEnabled = true;
+    }
+}
+
+/** Notify the observers of the frame timing, and accumulate it for the
+ * annotation. The annotation is only refreshed every half second so that it
+ * stays readable and does not force the rendering of every frame. */
+void View::ReportFrameTiming( const ViewFrameTimingType & timing )
+{
+  ViewFrameTimingEvent event;
+  event.Set( timing );
+  this->InvokeEvent( event );
+
+  if( this->m_FrameTimingAnnotation.IsNull() )
+    {
+    return;
+    }
+
+  if( this->m_TimingPeriodPulses == 0 )
+    {
+    this->m_TimingPeriodStartTime = timing.PulseTime;
+    this->m_TimingPeriodRenders = 0;
+    this->m_TimingPeriodLatencySamples = 0;
+    this->m_TimingPeriodUpdateTime = 0.0;
+    this->m_TimingPeriodRenderTime = 0.0;
+    this->m_TimingPeriodLatency = 0.0;
+    this->m_TimingPeriodMaximumLateness = 0.0;
+    }
+
+  this->m_TimingPeriodPulses++;
+  this->m_TimingPeriodUpdateTime += timing.UpdateTime;
+
+  if( timing.Rendered )
+    {
+    this->m_TimingPeriodRenders++;
+    this->m_TimingPeriodRenderTime += timing.RenderTime;
+    }
+
+  if( timing.TransformToDisplayLatency >= 0.0 )
+    {
+    this->m_TimingPeriodLatencySamples++;
+    this->m_TimingPeriodLatency += timing.TransformToDisplayLatency;
+    }
+
+  if( timing.PulseLateness > this->m_TimingPeriodMaximumLateness )
+    {
+    this->m_TimingPeriodMaximumLateness = timing.PulseLateness;
+    }
+
+  const double elapsed = timing.PulseTime - this->m_TimingPeriodStartTime;
+
+  if( elapsed < 500.0 )
+    {
+    return;
+    }
+
+  std::ostringstream text;
+  text.setf( std::ios::fixed );
+  text.precision( 1 );
+  text << "Frames: " << this->m_TimingPeriodRenders * 1000.0 / elapsed
+       << " fps\n";
+  text << "Update: " 
+       << this->m_TimingPeriodUpdateTime / this->m_TimingPeriodPulses 
+       << " ms\n";
+  text << "Render: ";
+  if( this->m_TimingPeriodRenders > 0 )
+    {
+    text << this->m_TimingPeriodRenderTime / this->m_TimingPeriodRenders 
+         << " ms\n";
+    }
+  else
+    {
+    text << "-\n";
+    }
+  text << "Late: " << this->m_TimingPeriodMaximumLateness << " ms\n";
+  text << "Latency: ";
+  if( this->m_TimingPeriodLatencySamples > 0 )
+    {
+    text << this->m_TimingPeriodLatency / this->m_TimingPeriodLatencySamples
+         << " ms";
+    }
+  else
+    {
+    text << "-";
+    }
+
+  this->m_FrameTimingAnnotation->RequestSetAnnotationText(
+    this->m_FrameTimingAnnotationCorner, text.str() );
+
+  this->m_TimingPeriodPulses = 0;
+}
+
+/** Adjust the frequency of the pulse generator to the rate of the changes in
+ * the scene. The rendered frames are counted over periods of one second. */
+void View::AdaptRefreshRate( bool rendered )
+{
+  const double now = RealTimeClock::GetTimeStamp();
+
+  if( this->m_AdaptivePeriodPulses == 0 )
+    {
+    this->m_AdaptivePeriodStartTime = now;
+    }
+
+  this->m_AdaptivePeriodPulses++;
+  if( rendered )
+    {
+    this->m_AdaptivePeriodRenders++;
+    }
+
+  const double elapsed = now - this->m_AdaptivePeriodStartTime;
+
+  if( elapsed < 1000.0 || this->m_AdaptivePeriodPulses < 2 )
+    {
+    return;
+    }
+
+  const double currentRate = this->m_PulseGenerator->GetFrequency();
+  double newRate;
+
+  if( this->m_AdaptivePeriodRenders * 10 >= this->m_AdaptivePeriodPulses * 9 )
+    {
+    // Nearly every pulse found a change: the scene may be changing faster
+    // than we are sampling it.
+    newRate = currentRate * 2.0;
+    }
+  else
+    {
+    // Sample the changes with some margin over their measured rate
+    const double changeRate =
+      this->m_AdaptivePeriodRenders * 1000.0 / elapsed;
+    newRate = changeRate * 1.5;
+    }
+
+  if( newRate > this->m_MaximumRefreshRate )
+    {
+    newRate = this->m_MaximumRefreshRate;
+    }
+  if( newRate < this->m_MinimumRefreshRate )
+    {
+    newRate = this->m_MinimumRefreshRate;
+    }
+
+  // Avoid reprogramming the timer for small variations
+  if( vnl_math_abs( newRate - currentRate ) > 0.1 * currentRate )
+    {
+    igstkLogMacro( DEBUG, "igstkView::AdaptRefreshRate() new rate "
+                          << newRate << " Hz\n");
+    this->m_PulseGenerator->RequestSetFrequency( newRate );
+    }
+
+  this->m_AdaptivePeriodPulses = 0;
+  this->m_AdaptivePeriodRenders = 0;
+}
+
 /** Refresh the rendering. This function is called in response to pulses from
  * the pulse generator. */
 void View::RefreshRender()
 {
   igstkLogMacro( DEBUG, "igstkView::RefreshRender() called ...\n");
 
+  const double pulseTime = RealTimeClock::GetTimeStamp();
+
   // First, compute the time at which we
   // estimate that the scene will be rendered
   TimeStamp renderTime;
@@ -620,14 +888,83 @@ void View::RefreshRender()
   const CoordinateSystem* thisCS = 
      CoordinateSystemHelperType::GetCoordinateSystem( this );  
 
+  // Start time of the newest transform used in this frame
+  TimeStamp::TimePeriodType newestTransformTime = 0.0;
+
   while( itr != endItr )
     {
     (*itr)->RequestUpdateRepresentation( renderTime, thisCS );
+    if( this->m_FrameTimingEnabled &&
+        (*itr)->GetTransformStartTime() > newestTransformTime )
+      {
+      newestTransformTime = (*itr)->GetTransformStartTime();
+      }
     ++itr;
     }
 
-  //Third, trigger VTK rendering
-  this->m_RenderWindowInteractor->Render();
+  const double updateEndTime = RealTimeClock::GetTimeStamp();
+
+  //Third, trigger VTK rendering, unless the scene did not change since the
+  //last rendering.
+  bool render = true;
+
+  if( this->m_RefreshMode != FixedRateRefresh )
+    {
+    const unsigned long sceneTime = this->ComputeSceneModifiedTime();
+    const double now = RealTimeClock::GetTimeStamp();
+
+    render = this->m_RenderOnNextPulse ||
+             sceneTime > this->m_LastRenderedModifiedTime ||
+             now - this->m_LastRenderTime > this->m_MaximumSkipPeriod;
+
+    if( render )
+      {
+      this->m_LastRenderTime = now;
+      }
+    }
+
+  if( render )
+    {
+    this->m_RenderWindowInteractor->Render();
+    this->m_RenderOnNextPulse = false;
+    this->m_NumberOfRenderedFrames++;
+
+    // Rendering updates the pipelines, so the reference time is taken after.
+    if( this->m_RefreshMode != FixedRateRefresh )
+      {
+      this->m_LastRenderedModifiedTime = this->ComputeSceneModifiedTime();
+      }
+    }
+  else
+    {
+    this->m_NumberOfSkippedFrames++;
+    }
+
+  if( this->m_RefreshMode == AdaptiveRefresh )
+    {
+    this->AdaptRefreshRate( render );
+    }
+
+  if( this->m_FrameTimingEnabled )
+    {
+    const double renderEndTime = RealTimeClock::GetTimeStamp();
+
+    ViewFrameTimingType timing;
+    timing.PulseTime = pulseTime;
+    timing.PulseLateness = this->m_PulseGenerator->GetPulseLateness();
+    timing.UpdateTime = updateEndTime - pulseTime;
+    timing.RenderTime = render ? renderEndTime - updateEndTime : 0.0;
+    timing.TransformToDisplayLatency = -1.0;
+    timing.Rendered = render;
+
+    if( render && newestTransformTime > this->m_LastDisplayedTransformTime )
+      {
+      timing.TransformToDisplayLatency = renderEndTime - newestTransformTime;
+      this->m_LastDisplayedTransformTime = newestTransformTime;
+      }
+
+    this->ReportFrameTiming( timing );
+    }
 
   // Last, report to observers that a refresh event took place.
   this->InvokeEvent( RefreshEvent() );
@@ -973,6 +1310,18 @@ void View::PrintSelf( std::ostream& os, itk::Indent indent ) const
     this->m_PulseObserver->Print(os);
     }
 
+  os << indent << "RefreshMode: " << this->m_RefreshMode << std::endl;
+  os << indent << "MinimumRefreshRate: " << this->m_MinimumRefreshRate;
+  os << std::endl;
+  os << indent << "MaximumSkipPeriod: " << this->m_MaximumSkipPeriod;
+  os << std::endl;
+  os << indent << "NumberOfRenderedFrames: " 
+               << this->m_NumberOfRenderedFrames << std::endl;
+  os << indent << "NumberOfSkippedFrames: " 
+               << this->m_NumberOfSkippedFrames << std::endl;
+  os << indent << "FrameTimingEnabled: " 
+               << this->m_FrameTimingEnabled << std::endl;
+
   ObjectListConstIterator itr;
 
   for( itr = this->m_Objects.begin(); itr != this->m_Objects.end(); ++itr )
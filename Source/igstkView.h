@@ -51,6 +51,33 @@ class vtkWorldPointPicker;
 
 namespace igstk {
 
+/** Timing measurements of one refresh of a View. All the values are in
+ *  milliseconds. */
+struct ViewFrameTimingType
+{
+  /** Time at which the refresh started, as given by RealTimeClock */
+  double PulseTime;
+
+  /** Delay between the scheduled and the actual time of the pulse */
+  double PulseLateness;
+
+  /** Time spent updating the object representations */
+  double UpdateTime;
+
+  /** Time spent in the VTK rendering. Zero when the frame was skipped. */
+  double RenderTime;
+
+  /** Time between the start time of the newest transform displayed and the
+   *  end of the rendering. Negative when the frame did not display a newer
+   *  transform than the previous one. */
+  double TransformToDisplayLatency;
+
+  /** Whether the scene was rendered in this refresh */
+  bool   Rendered;
+};
+
+igstkLoadedEventMacro( ViewFrameTimingEvent, IGSTKEvent, ViewFrameTimingType );
+
 /** \class View
  *  
  *  \brief Display graphical representations of surgical scenes.
@@ -82,6 +109,63 @@ public:
    * attempt to go faster than your monitor, nor more than double than your
    * trackers */
   void SetRefreshRate( double frequency );
+
+  /** Policies for turning the pulses of the refresh timer into renderings.
+   *
+   *  FixedRateRefresh renders the scene on every pulse. This is the default.
+   *
+   *  SkipUnchangedRefresh still updates the representations on every pulse,
+   *  but only renders when something visible changed since the last
+   *  rendering: an actor was moved, hidden or modified (this includes
+   *  transforms that expired), the camera moved or the window was resized.
+   *
+   *  AdaptiveRefresh skips unchanged frames as well, and additionally adjusts
+   *  the pulse frequency to the rate at which the scene actually changes,
+   *  typically the rate of the tracker. The frequency stays between
+   *  MinimumRefreshRate and the rate given to SetRefreshRate(). */
+  typedef enum
+    {
+    FixedRateRefresh = 0,
+    SkipUnchangedRefresh,
+    AdaptiveRefresh
+    } RefreshModeType;
+
+  /** Set/Get the refresh policy */
+  void SetRefreshMode( RefreshModeType mode );
+  igstkGetMacro( RefreshMode, RefreshModeType );
+
+  /** Lowest pulse frequency used by AdaptiveRefresh. Default is 5 Hz. */
+  igstkSetMacro( MinimumRefreshRate, double );
+  igstkGetMacro( MinimumRefreshRate, double );
+
+  /** Longest time, in milliseconds, for which rendering may be skipped.
+   *  Changes that do not modify any actor (for example a parameter of a VTK
+   *  filter upstream of a mapper) are picked up at the latest after this
+   *  period. Default is 1000 ms. */
+  igstkSetMacro( MaximumSkipPeriod, double );
+  igstkGetMacro( MaximumSkipPeriod, double );
+
+  /** Force the scene to be rendered on the next pulse, even if no change was
+   *  detected. */
+  void RequestRenderOnNextPulse();
+
+  /** Number of pulses that rendered the scene */
+  igstkGetMacro( NumberOfRenderedFrames, unsigned long );
+
+  /** Number of pulses for which rendering was skipped */
+  igstkGetMacro( NumberOfSkippedFrames, unsigned long );
+
+  /** Enable the measurement of the time spent in every refresh. When enabled,
+   *  a ViewFrameTimingEvent is invoked after each pulse. Disabled by
+   *  default. */
+  igstkSetMacro( FrameTimingEnabled, bool );
+  igstkGetMacro( FrameTimingEnabled, bool );
+
+  /** Display the frame timing, averaged over half a second, in one corner of
+   *  an annotation. The annotation must also be added to this view with
+   *  RequestAddAnnotation2D(). This enables the frame timing. Passing a NULL
+   *  annotation stops the display. */
+  void SetFrameTimingAnnotation( Annotation2D * annotation, int corner );
  
   /** Add an object representation to the list of children and associate it
    * with a specific view. */ 
@@ -188,6 +272,17 @@ private:
   /** Method that will refresh the view.. and the GUI */
   void RefreshRender();
 
+  /** Latest modification time of the props, camera and window. Used for
+   *  detecting whether the scene changed since the last rendering. */
+  unsigned long ComputeSceneModifiedTime() const;
+
+  /** Adjust the pulse frequency to the rate of rendered frames. Only used by
+   *  AdaptiveRefresh. */
+  void AdaptRefreshRate( bool rendered );
+
+  /** Invoke the ViewFrameTimingEvent and update the timing annotation */
+  void ReportFrameTiming( const ViewFrameTimingType & timing );
+
   /** Request add actor */
   void RequestAddActor( vtkProp * actor );
 
@@ -253,6 +348,38 @@ private:
   PulseGenerator::Pointer   m_PulseGenerator;
   ObserverType::Pointer     m_PulseObserver;
 
+  /** Variables for skipping unchanged frames */
+  RefreshModeType           m_RefreshMode;
+  double                    m_MaximumRefreshRate;
+  double                    m_MinimumRefreshRate;
+  double                    m_MaximumSkipPeriod;
+  unsigned long             m_LastRenderedModifiedTime;
+  double                    m_LastRenderTime;
+  bool                      m_RenderOnNextPulse;
+  unsigned long             m_NumberOfRenderedFrames;
+  unsigned long             m_NumberOfSkippedFrames;
+
+  /** Frames counted over the current AdaptiveRefresh measurement period */
+  double                    m_AdaptivePeriodStartTime;
+  unsigned long             m_AdaptivePeriodPulses;
+  unsigned long             m_AdaptivePeriodRenders;
+
+  /** Variables for the frame timing */
+  bool                      m_FrameTimingEnabled;
+  double                    m_LastDisplayedTransformTime;
+  Annotation2D::Pointer     m_FrameTimingAnnotation;
+  int                       m_FrameTimingAnnotationCorner;
+
+  /** Accumulated frame timing over the current annotation period */
+  double                    m_TimingPeriodStartTime;
+  unsigned long             m_TimingPeriodPulses;
+  unsigned long             m_TimingPeriodRenders;
+  unsigned long             m_TimingPeriodLatencySamples;
+  double                    m_TimingPeriodUpdateTime;
+  double                    m_TimingPeriodRenderTime;
+  double                    m_TimingPeriodLatency;
+  double                    m_TimingPeriodMaximumLateness;
+
   /** Object representation types */
   typedef ObjectRepresentation::Pointer     ObjectPointer;
   typedef std::list< ObjectPointer >        ObjectListType; 
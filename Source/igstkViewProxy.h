@@ -93,6 +93,12 @@ public:
     ViewProxyBase::SetPickedPointCoordinates( view, x, y );
     }
 
+  /** Render the view once */
+  void RefreshRender( View * view ) 
+    {
+    ViewProxyBase::RefreshRender( view );
+    }
+
 
 protected:
 
@@ -53,4 +53,10 @@ ViewProxyBase
   view->SetPickedPointCoordinates( xPickedPoint, yPickedPoint );
 }
 
+void 
+ViewProxyBase::RefreshRender( View * view )
+{
+  view->RefreshRender();
+}
+
 } // end namespace igstk
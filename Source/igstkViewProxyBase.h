@@ -57,6 +57,10 @@ protected:
   void SetPickedPointCoordinates( View * view, 
                                   double xPickedPoint ,
                                   double yPickedPoint );
+
+  /** Update the representations and render the scene once, outside of the
+   *  refresh pulses */
+  void RefreshRender( View * view );
 private:
 
 };
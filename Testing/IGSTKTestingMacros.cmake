@@ -127,6 +127,22 @@ ADD_TEST(igstkLandmark3DRegistrationTest2 ${IGSTK_TESTS} igstkLandmark3DRegistra
 ADD_TEST(igstkLandmark3DRegistrationErrorEstimatorTest ${IGSTK_TESTS} igstkLandmark3DRegistrationErrorEstimatorTest)
 ADD_TEST(igstkMRImageSpatialObjectRepresentationTest ${IGSTK_TESTS} igstkMRImageSpatialObjectRepresentationTest )
 ADD_TEST(igstkMRImageSpatialObjectTest ${IGSTK_TESTS} igstkMRImageSpatialObjectTest )          
+ADD_TEST(igstkImageSliceColorMapperTest ${IGSTK_TESTS}
+igstkImageSliceColorMapperTest)
+ADD_TEST(igstkMemoryMappedImageContainerTest ${IGSTK_TESTS}
+igstkMemoryMappedImageContainerTest ${IGSTK_TEST_OUTPUT_DIR})
+ADD_TEST(igstkResliceCacheTest ${IGSTK_TESTS}
+igstkResliceCacheTest)
+ADD_TEST(igstkMeshSlicerTest ${IGSTK_TESTS}
+igstkMeshSlicerTest)
+ADD_TEST(igstkTimeoutSchedulerTest ${IGSTK_TESTS}
+igstkTimeoutSchedulerTest)
+ADD_TEST(igstkEventLoopTest ${IGSTK_TESTS}
+igstkEventLoopTest)
+ADD_TEST(igstkObjectTest ${IGSTK_TESTS}
+igstkObjectTest)
+ADD_TEST(igstkEventQueueTest ${IGSTK_TESTS}
+igstkEventQueueTest)
 ADD_TEST(igstkMultipleOutputTest ${IGSTK_TESTS} igstkMultipleOutputTest)
 ADD_TEST(igstkObjectRepresentationRemovalTest ${IGSTK_TESTS}
 igstkObjectRepresentationRemovalTest)
@@ -157,6 +173,13 @@ igstkSpatialObjectCoordinateSystemTest3)
 ADD_TEST(igstkSimulatedTrackerTest ${IGSTK_TESTS} igstkSimulatedTrackerTest)
 
 ADD_TEST(igstkTransformTest ${IGSTK_TESTS} igstkTransformTest)
+ADD_TEST(igstkTransformBatchTest ${IGSTK_TESTS}
+igstkTransformBatchTest)
+ADD_TEST(igstkPoseFilterTest ${IGSTK_TESTS} igstkPoseFilterTest)
+ADD_TEST(igstkDeviceTelemetryTest ${IGSTK_TESTS}
+igstkDeviceTelemetryTest)
+ADD_TEST(igstkSyntheticTrackerTest ${IGSTK_TESTS}
+igstkSyntheticTrackerTest)
 ADD_TEST(igstkAffineTransformTest ${IGSTK_TESTS} igstkAffineTransformTest)
 ADD_TEST(igstkPerspectiveTransformTest ${IGSTK_TESTS}
 igstkPerspectiveTransformTest)
@@ -239,6 +262,13 @@ igstkSerialCommunicationSimulatorTest ${IGSTK_TEST_OUTPUT_DIR}
   ADD_TEST( igstkCTImageReaderTest ${IGSTK_TESTS} igstkCTImageReaderTest 
        ${IGSTK_DATA_ROOT}/Input/E000192
        ${IGSTK_DATA_ROOT}/Input/MRLiver)
+  ADD_TEST( igstkDICOMImageReaderCacheTest ${IGSTK_TESTS} 
+       igstkDICOMImageReaderCacheTest 
+       ${IGSTK_DATA_ROOT}/Input/E000192
+       ${IGSTK_TEST_OUTPUT_DIR}/DICOMCache )
+  ADD_TEST( igstkDICOMImageReaderProgressiveTest ${IGSTK_TESTS} 
+       igstkDICOMImageReaderProgressiveTest 
+       ${IGSTK_DATA_ROOT}/Input/E000192 )
   ADD_TEST( igstkMRImageReaderTest ${IGSTK_TESTS} igstkMRImageReaderTest 
        ${IGSTK_DATA_ROOT}/Input/MRLiver
        ${IGSTK_DATA_ROOT}/Input/E000192 )
@@ -373,11 +403,23 @@ IF(${IGSTK_USE_FLTK})
      ${IGSTK_TEST_OUTPUT_DIR}/igstkViewRefreshRateTestLog.txt
      )
 
+  ADD_TEST(igstkViewRefreshModeTest ${IGSTK_TESTS} 
+     igstkViewRefreshModeTest
+     ${IGSTK_TEST_OUTPUT_DIR}/igstkViewRefreshModeTestLog.txt
+     )
+
+  ADD_TEST(igstkOffScreenWidgetTest ${IGSTK_TESTS} 
+     igstkOffScreenWidgetTest
+     ${IGSTK_TEST_OUTPUT_DIR}/igstkOffScreenWidgetTest.png
+     )
+
   ADD_TEST(igstkPulseGeneratorTest ${IGSTK_TESTS} igstkPulseGeneratorTest)
   ADD_TEST(igstkConeObjectTest    ${IGSTK_TESTS} igstkConeObjectTest)
   ADD_TEST(igstkBoxObjectTest     ${IGSTK_TESTS} igstkBoxObjectTest)
   ADD_TEST(igstkAxesObjectTest    ${IGSTK_TESTS} igstkAxesObjectTest)
   ADD_TEST(igstkTubeObjectTest ${IGSTK_TESTS} igstkTubeObjectTest)
+  ADD_TEST(igstkVesselTreeObjectRepresentationTest ${IGSTK_TESTS}
+           igstkVesselTreeObjectRepresentationTest)
   ADD_TEST(igstkMeshObjectTest    ${IGSTK_TESTS} igstkMeshObjectTest )
   ADD_TEST(igstkMouseTrackerTest ${IGSTK_TESTS} igstkMouseTrackerTest)
   ADD_TEST(igstkUltrasoundProbeObjectTest ${IGSTK_TESTS} igstkUltrasoundProbeObjectTest)
@@ -679,6 +721,11 @@ IF(${IGSTK_USE_OpenIGTLink})
       igstkTrackerToolObserverToOpenIGTLinkRelayTest
       localhost 16666 1000 100 10 
       )
+  ADD_TEST( igstkTrackerObserverToOpenIGTLinkBroadcasterTest
+      ${IGSTK_TESTS}
+      igstkTrackerObserverToOpenIGTLinkBroadcasterTest
+      localhost 16667 300 100
+      )
  
   IF (${IGSTK_TEST_AURORA_ATTACHED})
   ADD_TEST( igstkAuroraTrackerToolObserverToOpenIGTLinkRelayTest
@@ -826,6 +873,14 @@ IF(${IGSTK_USE_VideoImager})
       igstkVideoFrameRepresentationTest
       )
 
+  IF(${IGSTK_USE_OpenIGTLink})
+    ADD_TEST( igstkOpenIGTLinkVideoImagerTest
+      ${IGSTK_TESTS}
+      igstkOpenIGTLinkVideoImagerTest
+      16668
+      )
+  ENDIF(${IGSTK_USE_OpenIGTLink})
+
 ENDIF(${IGSTK_USE_VideoImager})
  
 
@@ -845,6 +900,14 @@ SET(BasicTests_SRCS
   igstkLandmark3DRegistrationErrorEstimatorTest.cxx
   igstkMRImageSpatialObjectRepresentationTest.cxx
   igstkMRImageSpatialObjectTest.cxx
+  igstkImageSliceColorMapperTest.cxx
+  igstkMemoryMappedImageContainerTest.cxx
+  igstkResliceCacheTest.cxx
+  igstkMeshSlicerTest.cxx
+  igstkTimeoutSchedulerTest.cxx
+  igstkEventLoopTest.cxx
+  igstkObjectTest.cxx
+  igstkEventQueueTest.cxx
   igstkMultipleOutputTest.cxx    
 
   igstkObjectRepresentationRemovalTest.cxx
@@ -863,6 +926,10 @@ SET(BasicTests_SRCS
   igstkTrackerToolTest.cxx
   igstkTrackerTest.cxx
   igstkTransformTest.cxx  
+  igstkTransformBatchTest.cxx
+  igstkPoseFilterTest.cxx
+  igstkDeviceTelemetryTest.cxx
+  igstkSyntheticTrackerTest.cxx
   igstkVTKLoggerOutputTest.cxx
   igstkSpatialObjectCoordinateSystemTest.cxx
   igstkCoordinateSystemTest.cxx
@@ -940,7 +1007,9 @@ IF(IGSTK_DATA_ROOT)
     igstkMR3DImageToUS3DImageRegistrationTest.cxx 
     igstkCTImageReaderTest.cxx
     igstkCTImageSpatialObjectRepresentationTest.cxx
+    igstkDICOMImageReaderCacheTest.cxx
     igstkDICOMImageReaderErrorsTest.cxx
+    igstkDICOMImageReaderProgressiveTest.cxx
     igstkDICOMImageReaderTest.cxx
     igstkMeshReaderTest.cxx 
     igstkMRImageReaderTest.cxx
@@ -987,9 +1056,12 @@ IF(${IGSTK_USE_FLTK})
     igstkFLTKTextLogOutputTest.cxx
     igstkPulseGeneratorTest.cxx
     igstkTubeObjectTest.cxx
+    igstkVesselTreeObjectRepresentationTest.cxx
     igstkUltrasoundImageSimulatorTest.cxx
     igstkViewTest.cxx
     igstkViewRefreshRateTest.cxx
+    igstkViewRefreshModeTest.cxx
+    igstkOffScreenWidgetTest.cxx
     igstkMeshObjectTest.cxx
     igstkMouseTrackerTest.cxx
     igstkUltrasoundProbeObjectTest.cxx
@@ -1080,6 +1152,7 @@ IF(${IGSTK_USE_OpenIGTLink})
     SET(BasicTests_SRCS
       ${BasicTests_SRCS}
       igstkTrackerToolObserverToOpenIGTLinkRelayTest.cxx
+      igstkTrackerObserverToOpenIGTLinkBroadcasterTest.cxx
       )
 
     SET(BasicTests_SRCS
@@ -1118,6 +1191,12 @@ IF(${IGSTK_USE_VideoImager})
       ${BasicTests_SRCS}
       igstkVideoFrameRepresentationTest.cxx
       )
+  IF(${IGSTK_USE_OpenIGTLink})
+    SET(BasicTests_SRCS
+      ${BasicTests_SRCS}
+      igstkOpenIGTLinkVideoImagerTest.cxx
+      )
+  ENDIF(${IGSTK_USE_OpenIGTLink})
 ENDIF(${IGSTK_USE_VideoImager})
  
 IF(${SANDBOX_BUILD})
@@ -1150,6 +1229,10 @@ ELSE(${SANDBOX_BUILD})
   ADD_EXECUTABLE(igstkStateMachineExportTest igstkStateMachineExportTest.cxx)
   ADD_TEST(igstkStateMachineExportTest ${EXECUTABLE_OUTPUT_PATH}/igstkStateMachineExportTest ${IGSTK_STATE_MACHINE_DIAGRAMS_OUTPUT_DIR})
   TARGET_LINK_LIBRARIES(igstkStateMachineExportTest ${LIBRARY_NAME})
+
+  ADD_EXECUTABLE(igstkPipelineBenchmark igstkPipelineBenchmark.cxx)
+  ADD_TEST(igstkPipelineBenchmark ${EXECUTABLE_OUTPUT_PATH}/igstkPipelineBenchmark -quick -directory ${IGSTK_TEST_OUTPUT_DIR} -csv ${IGSTK_TEST_OUTPUT_DIR}/igstkPipelineBenchmark.csv)
+  TARGET_LINK_LIBRARIES(igstkPipelineBenchmark ${LIBRARY_NAME})
 ENDIF(${SANDBOX_BUILD})
 
 TARGET_LINK_LIBRARIES(${EXECUTABLE_NAME} ${LIBRARY_NAME})
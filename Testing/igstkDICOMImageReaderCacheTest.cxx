@@ -0,0 +1,190 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkDICOMImageReaderCacheTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkCTImageReader.h"
+#include "igstkRealTimeClock.h"
+
+#include "itksys/SystemTools.hxx"
+
+namespace DICOMImageReaderCacheTest
+{
+igstkObserverObjectMacro(CTImage,
+    ::igstk::CTImageReader::ImageModifiedEvent,::igstk::CTImageSpatialObject)
+
+typedef igstk::CTImageReader         ReaderType;
+
+/** Read the series in directory and return the image, or NULL on failure */
+igstk::CTImageSpatialObject::Pointer ReadImage( ReaderType * reader,
+                                                const char * directory )
+{
+  CTImageObserver::Pointer observer = CTImageObserver::New();
+  reader->AddObserver( ReaderType::ImageModifiedEvent(), observer );
+
+  reader->RequestSetDirectory( directory );
+  reader->RequestReadImage();
+  reader->RequestGetImage();
+
+  if( !observer->GotCTImage() || !reader->FileSuccessfullyRead() )
+    {
+    return NULL;
+    }
+
+  return observer->GetCTImage();
+}
+
+/** Compare the extent of two images by sampling points around them */
+bool SameExtent( const igstk::CTImageSpatialObject * image1,
+                 const igstk::CTImageSpatialObject * image2 )
+{
+  igstk::CTImageSpatialObject::PointType point;
+  for( int i = -300; i <= 300; i += 15 )
+    {
+    for( int j = -300; j <= 300; j += 15 )
+      {
+      for( int k = -300; k <= 300; k += 15 )
+        {
+        point[0] = i;
+        point[1] = j;
+        point[2] = k;
+        if( image1->IsInside( point ) != image2->IsInside( point ) )
+          {
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+}
+
+
+int igstkDICOMImageReaderCacheTest( int argc, char* argv[] )
+{
+
+  igstk::RealTimeClock::Initialize();
+
+  if( argc < 3 )
+    {
+    std::cerr << "Usage: " << argv[0] << "  CTImage  CacheDirectory"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef DICOMImageReaderCacheTest::ReaderType  ReaderType;
+
+  // Start from an empty cache
+  itksys::SystemTools::RemoveADirectory( argv[2] );
+
+  // Sequential read, without cache
+  ReaderType::Pointer sequentialReader = ReaderType::New();
+  sequentialReader->SetNumberOfThreads( 1 );
+
+  igstk::CTImageSpatialObject::Pointer sequentialImage =
+    DICOMImageReaderCacheTest::ReadImage( sequentialReader, argv[1] );
+
+  if( !sequentialImage )
+    {
+    std::cerr << "Sequential read failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Threaded read, filling the cache
+  ReaderType::Pointer threadedReader = ReaderType::New();
+  threadedReader->SetNumberOfThreads( 4 );
+  threadedReader->SetCacheDirectory( argv[2] );
+
+  igstk::CTImageSpatialObject::Pointer threadedImage =
+    DICOMImageReaderCacheTest::ReadImage( threadedReader, argv[1] );
+
+  if( !threadedImage || threadedReader->ImageLoadedFromCache() )
+    {
+    std::cerr << "Threaded read failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( !DICOMImageReaderCacheTest::SameExtent( sequentialImage,
+                                              threadedImage ) )
+    {
+    std::cerr << "Sequential and threaded reads differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Second read, from the cache
+  ReaderType::Pointer cachedReader = ReaderType::New();
+  cachedReader->SetCacheDirectory( argv[2] );
+
+  igstk::CTImageSpatialObject::Pointer cachedImage =
+    DICOMImageReaderCacheTest::ReadImage( cachedReader, argv[1] );
+
+  if( !cachedImage || !cachedReader->ImageLoadedFromCache() )
+    {
+    std::cerr << "The image was not loaded from the cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( !DICOMImageReaderCacheTest::SameExtent( sequentialImage, cachedImage ) )
+    {
+    std::cerr << "Cached and read images differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( cachedReader->GetModality() != sequentialReader->GetModality() ||
+      cachedReader->GetPatientName() != sequentialReader->GetPatientName() ||
+      cachedReader->GetPatientID() != sequentialReader->GetPatientID() )
+    {
+    std::cerr << "Cached tags differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Read decoded into a memory mapped cache, then mapped from the cache
+  const std::string mappedCacheDirectory = std::string( argv[2] ) + "/Mapped";
+
+  ReaderType::Pointer mappingReader = ReaderType::New();
+  mappingReader->SetCacheDirectory( mappedCacheDirectory );
+  mappingReader->SetMemoryMappedCache( true );
+
+  igstk::CTImageSpatialObject::Pointer mappingImage =
+    DICOMImageReaderCacheTest::ReadImage( mappingReader, argv[1] );
+
+  ReaderType::Pointer mappedReader = ReaderType::New();
+  mappedReader->SetCacheDirectory( mappedCacheDirectory );
+  mappedReader->SetMemoryMappedCache( true );
+
+  igstk::CTImageSpatialObject::Pointer mappedImage =
+    DICOMImageReaderCacheTest::ReadImage( mappedReader, argv[1] );
+
+  if( !mappingImage || !mappedImage || 
+      !mappedReader->ImageLoadedFromCache() ||
+      !DICOMImageReaderCacheTest::SameExtent( sequentialImage, 
+                                              mappingImage ) ||
+      !DICOMImageReaderCacheTest::SameExtent( sequentialImage, mappedImage ) )
+    {
+    std::cerr << "Memory mapped reads failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  cachedReader->Print( std::cout );
+  mappedReader->Print( std::cout );
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
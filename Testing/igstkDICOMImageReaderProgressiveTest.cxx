@@ -0,0 +1,176 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkDICOMImageReaderProgressiveTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkCTImageReader.h"
+#include "igstkRealTimeClock.h"
+#include "igstkPulseGenerator.h"
+
+namespace DICOMImageReaderProgressiveTest
+{
+igstkObserverObjectMacro(CTImage,
+    ::igstk::CTImageReader::ImageModifiedEvent,::igstk::CTImageSpatialObject)
+
+/** Count the refinements and record the completion of the loading */
+class LoadingObserver : public ::itk::Command
+{
+public:
+  typedef LoadingObserver                Self;
+  typedef ::itk::Command                 Superclass;
+  typedef ::itk::SmartPointer< Self >    Pointer;
+  itkNewMacro( Self );
+
+  void Execute( const itk::Object * itkNotUsed(caller),
+                const itk::EventObject & event )
+    {
+    if( igstk::DICOMImageRefinedEvent().CheckEvent( &event ) )
+      {
+      const igstk::DICOMImageRefinedEvent * refinedEvent =
+        dynamic_cast< const igstk::DICOMImageRefinedEvent * >( &event );
+      std::cout << "Refined: " << refinedEvent->Get() << std::endl;
+      if( refinedEvent->Get() < m_LastFraction )
+        {
+        m_Decreasing = true;
+        }
+      m_LastFraction = refinedEvent->Get();
+      m_NumberOfRefinements++;
+      }
+    else if( igstk::DICOMImageLoadingCompletedEvent().CheckEvent( &event ) )
+      {
+      m_Completed = true;
+      }
+    else if( igstk::DICOMImageReadingErrorEvent().CheckEvent( &event ) )
+      {
+      m_Failed = true;
+      }
+    }
+
+  void Execute( itk::Object * caller, const itk::EventObject & event )
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+
+  unsigned int  m_NumberOfRefinements;
+  double        m_LastFraction;
+  bool          m_Decreasing;
+  bool          m_Completed;
+  bool          m_Failed;
+
+protected:
+  LoadingObserver()
+    {
+    m_NumberOfRefinements = 0;
+    m_LastFraction = 0.0;
+    m_Decreasing = false;
+    m_Completed = false;
+    m_Failed = false;
+    }
+};
+}
+
+
+int igstkDICOMImageReaderProgressiveTest( int argc, char* argv[] )
+{
+
+  igstk::RealTimeClock::Initialize();
+
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << "  CTImage" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef igstk::CTImageReader         ReaderType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetProgressiveLoading( true );
+  reader->SetPreviewSliceStride( 4 );
+  reader->SetNumberOfThreads( 2 );
+
+  DICOMImageReaderProgressiveTest::LoadingObserver::Pointer loadingObserver =
+    DICOMImageReaderProgressiveTest::LoadingObserver::New();
+  reader->AddObserver( igstk::DICOMImageRefinedEvent(), loadingObserver );
+  reader->AddObserver( igstk::DICOMImageLoadingCompletedEvent(),
+                       loadingObserver );
+  reader->AddObserver( igstk::DICOMImageReadingErrorEvent(),
+                       loadingObserver );
+
+  typedef DICOMImageReaderProgressiveTest::CTImageObserver CTImageObserverType;
+  CTImageObserverType::Pointer ctImageObserver = CTImageObserverType::New();
+  reader->AddObserver( ReaderType::ImageModifiedEvent(), ctImageObserver );
+
+  reader->RequestSetDirectory( argv[1] );
+  reader->RequestReadImage();
+
+  // The preview is available before the loading completes
+  reader->RequestGetImage();
+
+  if( !ctImageObserver->GotCTImage() || !reader->FileSuccessfullyRead() )
+    {
+    std::cerr << "The preview image was not published" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  igstk::CTImageSpatialObject::Pointer ctImage = ctImageObserver->GetCTImage();
+
+  const bool refining = reader->ImageRefinementInProgress();
+
+  // Publish the refinements until the loading completes
+  for( unsigned int i = 0; i < 3000 && reader->ImageRefinementInProgress();
+       i++ )
+    {
+    igstk::PulseGenerator::Sleep( 10 );
+    igstk::PulseGenerator::CheckTimeouts();
+    }
+
+  if( reader->ImageRefinementInProgress() )
+    {
+    std::cerr << "The loading did not complete" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( loadingObserver->m_Failed || loadingObserver->m_Decreasing )
+    {
+    std::cerr << "The refinements failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( refining && ( !loadingObserver->m_Completed ||
+                    loadingObserver->m_NumberOfRefinements == 0 ||
+                    loadingObserver->m_LastFraction != 1.0 ) )
+    {
+    std::cerr << "The image was not refined" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Destroying a reader while it is refining must be safe
+  ReaderType::Pointer interruptedReader = ReaderType::New();
+  interruptedReader->SetProgressiveLoading( true );
+  interruptedReader->RequestSetDirectory( argv[1] );
+  interruptedReader->RequestReadImage();
+  interruptedReader = NULL;
+
+  reader->Print( std::cout );
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
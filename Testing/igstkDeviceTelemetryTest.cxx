@@ -0,0 +1,175 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkDeviceTelemetryTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkDeviceTelemetry.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+int igstkDeviceTelemetryTest( int, char * [] )
+{
+  typedef igstk::DeviceTelemetry        TelemetryType;
+  typedef TelemetryType::ReportType     ReportType;
+
+  TelemetryType::Pointer telemetry = TelemetryType::New();
+  telemetry->SetNominalFrequency( 50.0 );
+  telemetry->SetJitterBinWidth( 1.0 );
+  telemetry->SetReportPeriod( 1000.0 );
+  telemetry->AddTool( "tool0" );
+  telemetry->AddTool( "tool1" );
+  telemetry->AddTool( "tool2" );
+  telemetry->Reset();
+
+  // Two seconds at 50 Hz: the device is read 2 ms before each update,
+  // one update of four is 3 ms late and the 60th update is missing. The
+  // tool 1 is only seen in one update of two, the tool 2 never.
+  unsigned int numberOfReports = 0;
+  unsigned long numberOfUpdates = 0;
+  for( unsigned int i = 0; i < 100; i++ )
+    {
+    if( i == 60 )
+      {
+      continue;
+      }
+    const double time = 1000.0 + i * 20.0 + ( ( i % 4 == 1 ) ? 3.0 : 0.0 );
+    telemetry->RecordDeviceSample( time - 2.0, i != 10 );
+
+    const bool success = ( i != 20 );
+    telemetry->RecordUpdate( time, success );
+    numberOfUpdates++;
+    if( success )
+      {
+      unsigned char updated[3];
+      updated[0] = 1;
+      updated[1] = static_cast< unsigned char >( i % 2 );
+      updated[2] = 0;
+      telemetry->RecordToolUpdates( updated, 3 );
+      }
+
+    if( telemetry->IsReportDue( time ) )
+      {
+      numberOfReports++;
+      }
+    }
+
+  // Remove the tool 0, replaced by the tool 2
+  telemetry->RemoveTool( 0 );
+
+  ReportType report;
+  telemetry->GetReport( report );
+  telemetry->Print( std::cout );
+  std::cout << report;
+
+  if( report.m_NumberOfDeviceSamples != numberOfUpdates ||
+      report.m_NumberOfDeviceErrors != 1 ||
+      report.m_NumberOfUpdates != numberOfUpdates ||
+      report.m_NumberOfUpdateErrors != 1 )
+    {
+    std::cerr << "Wrong counters" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( report.m_NumberOfMissedUpdates != 1 )
+    {
+    std::cerr << "Wrong number of missed updates: "
+              << report.m_NumberOfMissedUpdates << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The rates are averaged over the last intervals
+  if( std::fabs( report.m_UpdateRate - 50.0 ) > 2.0 ||
+      std::fabs( report.m_DeviceRate - 50.0 ) > 2.0 )
+    {
+    std::cerr << "Wrong rates: " << report.m_UpdateRate << " "
+              << report.m_DeviceRate << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Each interval is on time or 3 ms late or early, except the one of
+  // the missing update, 20 ms late
+  unsigned long numberOfIntervals = 0;
+  for( unsigned int i = 0; i < ReportType::NumberOfJitterBins; i++ )
+    {
+    numberOfIntervals += report.m_JitterHistogram[i];
+    if( report.m_JitterHistogram[i] != 0 && i != 0 && i != 3 &&
+        i != ReportType::NumberOfJitterBins - 1 )
+      {
+      std::cerr << "Unexpected jitter in the bin " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if( numberOfIntervals != numberOfUpdates - 1 ||
+      report.m_JitterHistogram[ ReportType::NumberOfJitterBins - 1 ] != 1 ||
+      report.m_JitterHistogram[3] == 0 )
+    {
+    std::cerr << "Wrong jitter histogram" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( report.m_LastLatency != 2.0 ||
+      std::fabs( report.m_MeanLatency - 2.0 ) > 1e-9 ||
+      report.m_MaximumLatency != 2.0 )
+    {
+    std::cerr << "Wrong latency" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( report.m_ToolIdentifiers.size() != 2 ||
+      report.m_ToolIdentifiers[0] != "tool2" ||
+      report.m_ToolIdentifiers[1] != "tool1" ||
+      report.m_ToolVisibilityRatios[0] != 0.0 ||
+      std::fabs( report.m_ToolVisibilityRatios[1] - 0.5 ) > 0.02 )
+    {
+    std::cerr << "Wrong visibility of the tools" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( numberOfReports != 1 )
+    {
+    std::cerr << "Wrong number of reports: " << numberOfReports << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The loaded event carries a copy of the report
+  igstk::DeviceTelemetryEvent event;
+  event.Set( report );
+  if( event.Get().m_NumberOfUpdates != numberOfUpdates )
+    {
+    std::cerr << "Wrong report in the event" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Everything but the tools is cleared by a reset
+  telemetry->Reset();
+  telemetry->GetReport( report );
+  if( report.m_NumberOfUpdates != 0 || report.m_UpdateRate != 0.0 ||
+      report.m_ToolIdentifiers.size() != 2 ||
+      report.m_ToolVisibilityRatios[1] != 0.0 )
+    {
+    std::cerr << "The telemetry was not reset" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,231 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventLoopTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkEventLoop.h"
+#include "igstkPulseGenerator.h"
+#include "igstkEvents.h"
+#include "igstkRealTimeClock.h"
+#include "itkCommand.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+namespace EventLoopTest
+{
+
+/** Counts the pulses. The count is read under the lock of the loop. */
+class PulseCounter : public ::itk::Command
+{
+public:
+  typedef  PulseCounter               Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+
+  itkNewMacro( Self );
+
+  unsigned int GetCount() const
+    {
+    return m_Count;
+    }
+
+  void Execute( const itk::Object *, const itk::EventObject & event )
+    {
+    if( ::igstk::PulseEvent().CheckEvent( &event ) )
+      {
+      m_Count++;
+      }
+    }
+
+  void Execute( itk::Object * caller, const itk::EventObject & event )
+    {
+    this->Execute( (const itk::Object *)caller, event );
+    }
+
+protected:
+  PulseCounter()
+    {
+    m_Count = 0;
+    }
+
+private:
+  unsigned int m_Count;
+};
+
+/** Records the order of the posted calls */
+struct Call
+{
+  int                   m_Id;
+  std::vector< int > *  m_Calls;
+};
+
+void RecordCall( void * data )
+{
+  Call * call = static_cast< Call * >( data );
+  call->m_Calls->push_back( call->m_Id );
+}
+
+/** Number of pulses counted, read while the loop is locked */
+unsigned int CountPulses( igstk::EventLoop * eventLoop,
+                          const PulseCounter * counter )
+{
+  eventLoop->Lock();
+  const unsigned int count = counter->GetCount();
+  eventLoop->Unlock();
+  return count;
+}
+
+}
+
+int igstkEventLoopTest( int , char* [] )
+{
+  typedef igstk::EventLoop                  EventLoopType;
+  typedef igstk::PulseGenerator             PulseGeneratorType;
+  typedef EventLoopTest::PulseCounter       CounterType;
+
+  igstk::RealTimeClock::Initialize();
+
+  EventLoopType::Pointer trackingLoop = EventLoopType::New();
+  trackingLoop->StartThread();
+  trackingLoop->Print( std::cout );
+
+  PulseGeneratorType::Pointer pulseGenerator = PulseGeneratorType::New();
+  CounterType::Pointer counter = CounterType::New();
+  pulseGenerator->AddObserver( igstk::PulseEvent(), counter );
+
+  if( pulseGenerator->GetEventLoop() != EventLoopType::GetMainLoop() )
+    {
+    std::cerr << "Pulse generators must use the main loop by default"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The pulses of a generator bound to the loop thread are emitted while
+  // this thread does not process any event
+  pulseGenerator->RequestSetFrequency( 100.0 );
+  pulseGenerator->RequestSetEventLoop( trackingLoop );
+  pulseGenerator->RequestStart();
+  PulseGeneratorType::Sleep( 200 );
+
+  const unsigned int threadPulses =
+    EventLoopTest::CountPulses( trackingLoop, counter );
+  std::cout << "Pulses emitted by the loop thread: " << threadPulses
+            << std::endl;
+  if( threadPulses < 5 )
+    {
+    std::cerr << "The loop thread did not emit the pulses" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Calls posted from this thread are invoked in order by the loop thread
+  std::vector< int > calls;
+  std::vector< EventLoopTest::Call > posted( 10 );
+  for( unsigned int i = 0; i < posted.size(); i++ )
+    {
+    posted[i].m_Id = i;
+    posted[i].m_Calls = &calls;
+    trackingLoop->PostCall( EventLoopTest::RecordCall, &posted[i] );
+    }
+  PulseGeneratorType::Sleep( 50 );
+
+  trackingLoop->Lock();
+  bool orderedCalls = ( calls.size() == posted.size() );
+  for( unsigned int i = 0; orderedCalls && i < calls.size(); i++ )
+    {
+    orderedCalls = ( calls[i] == static_cast< int >( i ) );
+    }
+  trackingLoop->Unlock();
+  if( !orderedCalls )
+    {
+    std::cerr << "Posted calls were not invoked in order" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Stopping from this thread waits for the pulse being emitted
+  pulseGenerator->RequestStop();
+  const unsigned int stoppedPulses =
+    EventLoopTest::CountPulses( trackingLoop, counter );
+  PulseGeneratorType::Sleep( 50 );
+  if( EventLoopTest::CountPulses( trackingLoop, counter ) != stoppedPulses )
+    {
+    std::cerr << "Pulses emitted after RequestStop()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Moving a running generator back to the main loop
+  pulseGenerator->RequestStart();
+  pulseGenerator->RequestSetEventLoop( EventLoopType::GetMainLoop() );
+  pulseGenerator->RequestSetEventLoop( NULL );
+  if( pulseGenerator->GetEventLoop() != EventLoopType::GetMainLoop() )
+    {
+    std::cerr << "The generator was not moved to the main loop"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const double start = igstk::RealTimeClock::GetTimeStamp();
+  while( igstk::RealTimeClock::GetTimeStamp() - start < 200.0 )
+    {
+    PulseGeneratorType::WaitForPulses( 10.0 );
+    }
+  pulseGenerator->RequestStop();
+
+  const unsigned int mainPulses = counter->GetCount() - stoppedPulses;
+  std::cout << "Pulses emitted by the main loop: " << mainPulses
+            << std::endl;
+  if( mainPulses < 5 || trackingLoop->ProcessEvents() != 0 )
+    {
+    std::cerr << "The main loop did not emit the pulses" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // After a stall of several periods a single late pulse is emitted, and
+  // the next one is a full period later
+  pulseGenerator->RequestSetFrequency( 20.0 );
+  pulseGenerator->RequestStart();
+  PulseGeneratorType::Sleep( 200 );
+
+  const unsigned int stalledPulses = counter->GetCount();
+  PulseGeneratorType::CheckTimeouts();
+  PulseGeneratorType::CheckTimeouts();
+  const unsigned int latePulses = counter->GetCount() - stalledPulses;
+  const double timeToNextPulse = PulseGeneratorType::GetTimeToNextPulse();
+  pulseGenerator->RequestStop();
+
+  std::cout << "Pulses emitted after a stall: " << latePulses
+            << ", next pulse in " << timeToNextPulse << " ms" << std::endl;
+  if( latePulses != 1 || timeToNextPulse < 25.0 )
+    {
+    std::cerr << "The missed pulses were caught up" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  trackingLoop->StopThread();
+  if( trackingLoop->GetRunningInThread() )
+    {
+    std::cerr << "The loop thread was not stopped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkEventQueueTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkEventQueue.h"
+#include "igstkEventLoop.h"
+#include "igstkObject.h"
+#include "igstkEvents.h"
+#include "igstkPulseGenerator.h"
+#include "igstkRealTimeClock.h"
+#include "itkCommand.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+namespace EventQueueTest
+{
+
+igstkLoadedEventMacro( CountEvent, igstk::IGSTKEvent, unsigned int );
+
+/** Records the payloads of the events, optionally taking some time for
+ *  each of them like an observer writing to a file */
+class Recorder : public ::itk::Command
+{
+public:
+  typedef  Recorder                   Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+
+  itkNewMacro( Self );
+
+  void SetDelay( unsigned int milliseconds )
+    {
+    m_Delay = milliseconds;
+    }
+
+  void SetExpectedCaller( const itk::Object * caller )
+    {
+    m_ExpectedCaller = caller;
+    }
+
+  const std::vector< unsigned int > & GetPayloads() const
+    {
+    return m_Payloads;
+    }
+
+  bool GetWrongCaller() const
+    {
+    return m_WrongCaller;
+    }
+
+  void Execute( const itk::Object * caller, const itk::EventObject & event )
+    {
+    const CountEvent * countEvent =
+      dynamic_cast< const CountEvent * >( &event );
+    if( countEvent )
+      {
+      m_Payloads.push_back( countEvent->Get() );
+      }
+    if( caller != m_ExpectedCaller )
+      {
+      m_WrongCaller = true;
+      }
+    if( m_Delay > 0 )
+      {
+      igstk::PulseGenerator::Sleep( m_Delay );
+      }
+    }
+
+  void Execute( itk::Object * caller, const itk::EventObject & event )
+    {
+    this->Execute( (const itk::Object *)caller, event );
+    }
+
+protected:
+  Recorder()
+    {
+    m_Delay = 0;
+    m_ExpectedCaller = NULL;
+    m_WrongCaller = false;
+    }
+
+private:
+  unsigned int                  m_Delay;
+  const itk::Object *           m_ExpectedCaller;
+  bool                          m_WrongCaller;
+  std::vector< unsigned int >   m_Payloads;
+};
+
+void InvokeCounts( igstk::Object * source, unsigned int first,
+                   unsigned int last, unsigned int interval )
+{
+  for( unsigned int i = first; i <= last; i++ )
+    {
+    CountEvent event;
+    event.Set( i );
+    source->InvokeEvent( event );
+    if( interval > 0 )
+      {
+      igstk::PulseGenerator::Sleep( interval );
+      }
+    }
+}
+
+/** Payloads received so far, read while the loop is locked */
+std::vector< unsigned int > GetPayloads( igstk::EventLoop * eventLoop,
+                                         const Recorder * recorder )
+{
+  eventLoop->Lock();
+  const std::vector< unsigned int > payloads = recorder->GetPayloads();
+  eventLoop->Unlock();
+  return payloads;
+}
+
+/** Invokes events from the thread of an event loop until it is stopped */
+struct LoopInvoker
+{
+  igstk::EventLoop *   m_EventLoop;
+  igstk::Object *      m_Source;
+  volatile bool        m_Running;
+  unsigned int         m_NumberOfEvents;
+};
+
+void InvokeFromLoop( void * data )
+{
+  LoopInvoker * invoker = static_cast< LoopInvoker * >( data );
+  CountEvent event;
+  event.Set( ++invoker->m_NumberOfEvents );
+  invoker->m_Source->InvokeEvent( event );
+  if( invoker->m_Running )
+    {
+    invoker->m_EventLoop->AddTimeout(
+      igstk::RealTimeClock::GetTimeStamp() + 0.1, InvokeFromLoop, data );
+    }
+}
+
+bool IsIncreasing( const std::vector< unsigned int > & payloads )
+{
+  for( unsigned int i = 1; i < payloads.size(); i++ )
+    {
+    if( payloads[i] <= payloads[i - 1] )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+int igstkEventQueueTest( int , char* [] )
+{
+  typedef igstk::EventQueue                 QueueType;
+  typedef igstk::EventLoop                  EventLoopType;
+  typedef EventQueueTest::Recorder          RecorderType;
+  typedef EventQueueTest::CountEvent        CountEventType;
+
+  igstk::RealTimeClock::Initialize();
+
+  igstk::Object::Pointer tool = igstk::Object::New();
+  igstk::Object::Pointer tracker = igstk::Object::New();
+
+  // A slow observer in its own thread, receiving only the newest event
+  EventLoopType::Pointer loggerLoop = EventLoopType::New();
+  loggerLoop->StartThread();
+
+  QueueType::Pointer loggerQueue = QueueType::New();
+  loggerQueue->SetEventLoop( loggerLoop );
+
+  RecorderType::Pointer logger = RecorderType::New();
+  logger->SetDelay( 20 );
+  logger->SetExpectedCaller( tool );
+  loggerQueue->AddLoadedEventObserver( tool, CountEventType(), logger, true );
+
+  const double start = igstk::RealTimeClock::GetTimeStamp();
+  EventQueueTest::InvokeCounts( tool, 1, 100, 2 );
+  const double invocationTime = igstk::RealTimeClock::GetTimeStamp() - start;
+
+  std::cout << "Invoked 100 events in " << invocationTime
+            << " ms for an observer taking 20 ms per event" << std::endl;
+  if( invocationTime > 1000.0 )
+    {
+    std::cerr << "The invocation waited for the slow observer" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector< unsigned int > payloads;
+  while( igstk::RealTimeClock::GetTimeStamp() - start < 5000.0 )
+    {
+    payloads = EventQueueTest::GetPayloads( loggerLoop, logger );
+    if( !payloads.empty() && payloads.back() == 100 )
+      {
+      break;
+      }
+    igstk::PulseGenerator::Sleep( 10 );
+    }
+
+  std::cout << "The slow observer received " << payloads.size()
+            << " events" << std::endl;
+  if( payloads.empty() || payloads.back() != 100 ||
+      payloads.size() >= 100 ||
+      !EventQueueTest::IsIncreasing( payloads ) ||
+      loggerQueue->GetNumberOfCoalescedEvents() +
+        loggerQueue->GetNumberOfDeliveredEvents() != 100 )
+    {
+    std::cerr << "Wrong coalescing of the events" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( logger->GetWrongCaller() )
+    {
+    std::cerr << "The observer was not called with the source"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Events queued for the main loop, without coalescing, are delivered in
+  // order when the main loop processes its events
+  QueueType::Pointer mainQueue = QueueType::New();
+  mainQueue->SetMaximumQueueSize( 10 );
+  RecorderType::Pointer display = RecorderType::New();
+  display->SetExpectedCaller( tracker );
+  const unsigned long tag =
+    mainQueue->AddLoadedEventObserver( tracker, CountEventType(), display,
+                                       false );
+
+  EventQueueTest::InvokeCounts( tracker, 1, 15, 0 );
+  if( !display->GetPayloads().empty() )
+    {
+    std::cerr << "Events delivered before the processing of the loop"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  EventLoopType::GetMainLoop()->ProcessEvents();
+  const std::vector< unsigned int > & displayed = display->GetPayloads();
+  if( displayed.size() != 10 || displayed.back() != 10 ||
+      !EventQueueTest::IsIncreasing( displayed ) ||
+      mainQueue->GetNumberOfDroppedEvents() != 5 )
+    {
+    std::cerr << "Wrong delivery of the queued events" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Events queued for a removed observer are not delivered
+  EventQueueTest::InvokeCounts( tracker, 16, 20, 0 );
+  mainQueue->RemoveEventObserver( tag );
+  EventQueueTest::InvokeCounts( tracker, 21, 25, 0 );
+  EventLoopType::GetMainLoop()->ProcessEvents();
+  if( display->GetPayloads().size() != 10 ||
+      tracker->HasObserver( CountEventType() ) )
+    {
+    std::cerr << "Events delivered after the removal of the observer"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Observers added and removed by this thread while the source invokes
+  // its events from the thread of another loop
+  EventLoopType::Pointer sourceLoop = EventLoopType::New();
+  sourceLoop->StartThread();
+
+  igstk::Object::Pointer threadedSource = igstk::Object::New();
+  EventQueueTest::LoopInvoker invoker;
+  invoker.m_EventLoop = sourceLoop;
+  invoker.m_Source = threadedSource;
+  invoker.m_Running = true;
+  invoker.m_NumberOfEvents = 0;
+  sourceLoop->PostCall( EventQueueTest::InvokeFromLoop, &invoker );
+
+  QueueType::Pointer threadedQueue = QueueType::New();
+  threadedQueue->SetSourceEventLoop( sourceLoop );
+  RecorderType::Pointer threadedDisplay = RecorderType::New();
+  threadedDisplay->SetExpectedCaller( threadedSource );
+  for( unsigned int i = 0; i < 200; i++ )
+    {
+    const unsigned long threadedTag =
+      threadedQueue->AddLoadedEventObserver( threadedSource,
+                                             CountEventType(),
+                                             threadedDisplay, i % 2 == 0 );
+    igstk::PulseGenerator::Sleep( 1 );
+    EventLoopType::GetMainLoop()->ProcessEvents();
+    threadedQueue->RemoveEventObserver( threadedTag );
+    }
+
+  invoker.m_Running = false;
+  sourceLoop->RemoveTimeout( EventQueueTest::InvokeFromLoop, &invoker );
+  sourceLoop->StopThread();
+
+  std::cout << "The source invoked " << invoker.m_NumberOfEvents
+            << " events, " << threadedDisplay->GetPayloads().size()
+            << " delivered" << std::endl;
+  if( threadedQueue->GetSourceEventLoop() != sourceLoop ||
+      threadedSource->HasObserver( CountEventType() ) ||
+      threadedDisplay->GetWrongCaller() ||
+      !EventQueueTest::IsIncreasing( threadedDisplay->GetPayloads() ) )
+    {
+    std::cerr << "Wrong observers of a source invoking events from another "
+              << "thread" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  mainQueue->Print( std::cout );
+  loggerQueue->Print( std::cout );
+
+  // Destroying the queue removes its observers from the sources
+  loggerQueue = NULL;
+  if( tool->HasObserver( CountEventType() ) )
+    {
+    std::cerr << "Observers left after the destruction of the queue"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  loggerLoop->StopThread();
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkImageSliceColorMapperTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkImageSliceColorMapper.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace ImageSliceColorMapperTest
+{
+
+/** Map every slice of a small volume and compare with the expected ramp */
+template < class TPixelType >
+bool TestMapper( const char * name )
+{
+  typedef igstk::ImageSliceColorMapper< TPixelType >  MapperType;
+
+  const int dimensions[3] = { 7, 5, 4 };
+  const unsigned int numberOfPixels = 7 * 5 * 4;
+
+  std::vector< TPixelType > volume( numberOfPixels );
+  for( unsigned int i = 0; i < numberOfPixels; i++ )
+    {
+    volume[i] = static_cast< TPixelType >( 3 * i );
+    }
+
+  const double window = 200.0;
+  const double level = 150.0;
+
+  MapperType mapper;
+  mapper.SetVolume( &volume[0], dimensions );
+  mapper.SetWindowLevel( window, level );
+  mapper.SetColor( 1.0, 0.5, 0.0, 0.5 );
+  mapper.SetCacheSize( 2 );
+
+  std::vector< unsigned char > rgba( 4 * 7 * 5 );
+
+  for( int axis = 0; axis < 3; axis++ )
+    {
+    const typename MapperType::AxisType sliceAxis = 
+                    static_cast< typename MapperType::AxisType >( axis );
+
+    int width;
+    int height;
+    mapper.GetSliceSize( sliceAxis, width, height );
+
+    for( int slice = 0; slice < dimensions[axis]; slice++ )
+      {
+      if( !mapper.MapSlice( sliceAxis, slice, &rgba[0] ) )
+        {
+        std::cerr << name << ": failed to map slice " << slice 
+                  << " of axis " << axis << std::endl;
+        return false;
+        }
+
+      for( int v = 0; v < height; v++ )
+        {
+        for( int u = 0; u < width; u++ )
+          {
+          int index[3];
+          index[axis] = slice;
+          index[ axis == 0 ? 1 : 0 ] = u;
+          index[ axis == 2 ? 1 : 2 ] = v;
+
+          const double value = volume[ ( index[2] * dimensions[1] + 
+                                index[1] ) * dimensions[0] + index[0] ];
+          double intensity = ( value - ( level - window / 2.0 ) ) / window;
+          intensity = intensity < 0.0 ? 0.0 : 
+                                   ( intensity > 1.0 ? 1.0 : intensity );
+
+          const unsigned char * pixel = &rgba[ 4 * ( v * width + u ) ];
+          if( std::fabs( pixel[0] - 255.0 * intensity ) > 2.0 ||
+              std::fabs( pixel[1] - 127.5 * intensity ) > 2.0 ||
+              pixel[2] != 0 || pixel[3] != 128 )
+            {
+            std::cerr << name << ": wrong color for value " << value
+                      << " on axis " << axis << std::endl;
+            return false;
+            }
+          }
+        }
+      }
+    }
+
+  // Going back to a cached slice does not read the volume again
+  const unsigned long misses = mapper.GetNumberOfCacheMisses();
+  mapper.SetWindowLevel( 100.0, 50.0 );
+  mapper.MapSlice( MapperType::Coronal, dimensions[1] - 1, &rgba[0] );
+  if( mapper.GetNumberOfCacheMisses() != misses || 
+      mapper.GetNumberOfCacheHits() == 0 )
+    {
+    std::cerr << name << ": the slice was not cached" << std::endl;
+    return false;
+    }
+
+  if( mapper.MapSlice( MapperType::Axial, dimensions[2], &rgba[0] ) ||
+      mapper.MapSlice( MapperType::Sagittal, -1, &rgba[0] ) )
+    {
+    std::cerr << name << ": mapped a slice out of range" << std::endl;
+    return false;
+    }
+
+  return true;
+}
+}
+
+
+int igstkImageSliceColorMapperTest( int , char* [] )
+{
+
+  if( !ImageSliceColorMapperTest::TestMapper< signed short >( "short" ) ||
+      !ImageSliceColorMapperTest::TestMapper< unsigned short >( "ushort" ) ||
+      !ImageSliceColorMapperTest::TestMapper< unsigned char >( "uchar" ) ||
+      !ImageSliceColorMapperTest::TestMapper< float >( "float" ) )
+    {
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
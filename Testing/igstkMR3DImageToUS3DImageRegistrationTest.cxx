@@ -31,6 +31,8 @@
 #include "igstkMR3DImageToUS3DImageRegistration.h"
 #include "igstkUltrasoundImageSimulator.h"
 #include "igstkTransformObserver.h"
+#include "igstkRealTimeClock.h"
+#include "igstkUltrasoundProbeObject.h"
 
 namespace MR3DImageToUS3DImageRegistrationTest
 {
@@ -49,6 +51,68 @@ igstkObserverObjectMacro(SimulatedUSImage,
                          USImageModifiedEventType,
                          igstk::USImageObject)
 
+// Record the events that signal the progress and the end of an
+// asynchronous registration
+class RegistrationEventObserver : public ::itk::Command 
+{
+public:
+  typedef  RegistrationEventObserver  Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+  itkNewMacro( Self );
+
+protected:
+  RegistrationEventObserver() 
+    {
+    this->Reset();
+    }
+  ~RegistrationEventObserver() {}
+
+public:
+  void Reset()
+    {
+    m_NumberOfProgressEvents = 0;
+    m_Completed = false;
+    m_Failed = false;
+    }
+  void Execute(itk::Object *caller, const itk::EventObject & event)
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+  void Execute(const itk::Object *, const itk::EventObject & event)
+    {
+    if( igstk::ImageRegistrationProgressEvent().CheckEvent( &event ) )
+      {
+      m_NumberOfProgressEvents++;
+      }
+    else if( igstk::CompletedEvent().CheckEvent( &event ) )
+      {
+      m_Completed = true;
+      }
+    else if( igstk::ImageRegistrationFailureEvent().CheckEvent( &event ) )
+      {
+      m_Failed = true;
+      }
+    }
+
+  unsigned int  m_NumberOfProgressEvents;
+  bool          m_Completed;
+  bool          m_Failed;
+};
+
+// Process the pulses until the registration ends or the time runs out
+bool WaitForRegistration( RegistrationEventObserver * observer )
+{
+  const double startTime = igstk::RealTimeClock::GetTimeStamp();
+  while( !observer->m_Completed && !observer->m_Failed &&
+         igstk::RealTimeClock::GetTimeStamp() - startTime < 120000.0 )
+    {
+    igstk::PulseGenerator::Sleep( 10 );
+    igstk::PulseGenerator::CheckTimeouts();
+    }
+  return observer->m_Completed || observer->m_Failed;
+}
 
 }
 
@@ -61,6 +125,8 @@ int igstkMR3DImageToUS3DImageRegistrationTest( int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  igstk::RealTimeClock::Initialize();
+
   igstk::MRImageReader::Pointer MRReader = igstk::MRImageReader::New();
   MRReader->RequestSetDirectory(argv[1]);
   MRReader->RequestReadImage();
@@ -187,6 +253,155 @@ int igstkMR3DImageToUS3DImageRegistrationTest( int argc, char * argv[] )
     std::cout << "[FAILED]" << std::endl;
     return EXIT_FAILURE;
     }
+
+  // Same registration with stratified sampling, in a separate thread
+  typedef MR3DImageToUS3DImageRegistrationTest::RegistrationEventObserver
+                                                RegistrationEventObserverType;
+  RegistrationEventObserverType::Pointer eventObserver = 
+                                         RegistrationEventObserverType::New();
+  registration->AddObserver( igstk::IGSTKEvent(), eventObserver );
+
+  registration->SetSamplingStrategy( 
+      igstk::MR3DImageToUS3DImageRegistration::StratifiedSampling );
+  registration->SetNumberOfThreads( 2 );
+
+  // The probe holding the transducer does not move during the test
+  igstk::UltrasoundProbeObject::Pointer probe = 
+                                      igstk::UltrasoundProbeObject::New();
+  igstk::Transform identity;
+  identity.SetToIdentity( igstk::TimeStamp::GetLongestPossibleTime() );
+  probe->RequestSetTransformAndParent( identity, 
+                                       mrImageObserver->GetMRImage() );
+  registration->SetUltrasoundProbe( probe );
+
+  registration->RequestStartRegistration();
+
+  // Requests that are not valid while registering
+  registration->RequestCalculateRegistration();
+  registration->RequestGetRegistrationTransform();
+
+  if( !MR3DImageToUS3DImageRegistrationTest::WaitForRegistration( 
+                                                         eventObserver ) )
+    {
+    std::cout << "The asynchronous registration did not end" << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( !eventObserver->m_Completed || 
+      eventObserver->m_NumberOfProgressEvents == 0 )
+    {
+    std::cout << "The asynchronous registration failed" << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  registrationTransformObserver->Clear();
+  registration->RequestGetRegistrationTransform();
+
+  if( !registrationTransformObserver->GotTransform() )
+    {
+    std::cout << "No Transform from the asynchronous registration!" 
+              << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  VectorType asyncT = 
+                registrationTransformObserver->GetTransform().GetTranslation();
+  asyncT += initialTransform.GetTranslation();
+  VectorType asyncError = asyncT - translation;
+
+  if(fabs(asyncError[0])>1 || fabs(asyncError[1])>1 || 
+     fabs(asyncError[2])>1)
+    {
+    std::cout << "[FAILED] : " << std::endl;
+    std::cout << "Final asynchronous transform = " << asyncT << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Tracking updates start from the previous solution and must stay there
+  registration->SetTrackingNumberOfIterations( 10 );
+  registration->SetTrackingSearchRadius( 2.0 );
+
+  for( unsigned int update = 0; update < 2; update++ )
+    {
+    eventObserver->Reset();
+    if( update == 0 )
+      {
+      registration->RequestUpdateRegistration();
+      }
+    else
+      {
+      registration->RequestStartRegistrationUpdate();
+      MR3DImageToUS3DImageRegistrationTest::WaitForRegistration( 
+                                                         eventObserver );
+      }
+
+    if( eventObserver->m_Failed || 
+        !registration->GetValidMR3DImageToUS3DImageRegistration() )
+      {
+      std::cout << "The tracking update failed" << std::endl;
+      std::cout << "[FAILED]" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    registrationTransformObserver->Clear();
+    registration->RequestGetRegistrationTransform();
+
+    VectorType updateT = 
+                registrationTransformObserver->GetTransform().GetTranslation();
+    updateT += initialTransform.GetTranslation();
+    VectorType updateError = updateT - translation;
+
+    if(fabs(updateError[0])>1 || fabs(updateError[1])>1 || 
+       fabs(updateError[2])>1)
+      {
+      std::cout << "[FAILED] : " << std::endl;
+      std::cout << "Tracking update transform = " << updateT << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A registration that is stopped must not produce a transform
+  eventObserver->Reset();
+  registration->RequestStartRegistration();
+  registration->RequestStopRegistration();
+
+  if( !MR3DImageToUS3DImageRegistrationTest::WaitForRegistration( 
+                                                         eventObserver ) ||
+      !eventObserver->m_Failed )
+    {
+    std::cout << "The registration was not stopped" << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( registration->GetValidMR3DImageToUS3DImageRegistration() )
+    {
+    std::cout << "A stopped registration is reported as valid" << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A moving image without data makes the registration fail
+  igstk::MRImageSpatialObject::Pointer emptyMRImage = 
+                                       igstk::MRImageSpatialObject::New();
+  registration->RequestSetMovingMR3D( emptyMRImage );
+
+  eventObserver->Reset();
+  registration->RequestCalculateRegistration();
+
+  if( !eventObserver->m_Failed ||
+      registration->GetValidMR3DImageToUS3DImageRegistration() )
+    {
+    std::cout << "A registration without MR image did not fail" << std::endl;
+    std::cout << "[FAILED]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  registration->Print( std::cout ); 
+
   std::cout << "[PASSED]" << std::endl;
 
   return EXIT_SUCCESS;
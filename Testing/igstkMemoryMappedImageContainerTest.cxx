@@ -0,0 +1,144 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMemoryMappedImageContainerTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkMemoryMappedImageContainer.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+
+int igstkMemoryMappedImageContainerTest( int argc, char* argv[] )
+{
+
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << "  OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const std::string fileName = 
+                     std::string( argv[1] ) + "/MemoryMappedImage.raw";
+
+  typedef signed short                             PixelType;
+  typedef itk::Image< PixelType, 3 >               ImageType;
+  typedef igstk::MemoryMappedImageContainer< 
+    ImageType::PixelContainer::ElementIdentifier, 
+    PixelType >                                    ContainerType;
+
+  ImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 48;
+  size[2] = 10;
+
+  ImageType::RegionType region;
+  region.SetSize( size );
+
+  // Write an image through a shared mapping
+  ContainerType::Pointer container = ContainerType::New();
+  if( !container->CreateFile( fileName, region.GetNumberOfPixels() ) )
+    {
+    std::cerr << "Failed to create " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetPixelContainer( container );
+
+  typedef itk::ImageRegionIterator< ImageType >  IteratorType;
+
+  PixelType value = 0;
+  IteratorType it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( value++ );
+    }
+
+  if( !container->Flush() )
+    {
+    std::cerr << "Failed to flush the mapping" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  container->Print( std::cout );
+
+  image = NULL;
+  container = NULL;
+
+  // Map it again copy-on-write and check the pixels
+  ContainerType::Pointer copyContainer = ContainerType::New();
+  if( !copyContainer->MapFile( fileName, true ) ||
+      copyContainer->Size() != region.GetNumberOfPixels() ||
+      copyContainer->IsFileShared() )
+    {
+    std::cerr << "Failed to map " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer copyImage = ImageType::New();
+  copyImage->SetRegions( region );
+  copyImage->SetPixelContainer( copyContainer );
+
+  ImageType::IndexType index;
+  index[0] = 5;
+  index[1] = 7;
+  index[2] = 3;
+
+  const PixelType expected = static_cast< PixelType >( 
+               ( index[2] * size[1] + index[1] ) * size[0] + index[0] );
+
+  if( copyImage->GetPixel( index ) != expected )
+    {
+    std::cerr << "Wrong pixel value " << copyImage->GetPixel( index ) 
+              << " instead of " << expected << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Writes to a copy-on-write mapping do not reach the file
+  copyImage->SetPixel( index, -1 );
+
+  ContainerType::Pointer sharedContainer = ContainerType::New();
+  if( !sharedContainer->MapFile( fileName, false ) ||
+      !sharedContainer->IsFileShared() )
+    {
+    std::cerr << "Failed to map " << fileName << " shared" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::OffsetValueType offset = 
+                                  copyImage->ComputeOffset( index );
+  if( sharedContainer->GetBufferPointer()[offset] != expected )
+    {
+    std::cerr << "The copy-on-write mapping modified the file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A file that does not exist can not be mapped
+  ContainerType::Pointer missingContainer = ContainerType::New();
+  if( missingContainer->MapFile( fileName + ".missing", true ) )
+    {
+    std::cerr << "Mapped a missing file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkMeshSlicerTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkMeshSlicer.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace MeshSlicerTest
+{
+
+typedef igstk::MeshSlicer      SlicerType;
+typedef SlicerType::IdType     IdType;
+
+const unsigned int Size = 12;
+
+/** Point id of a corner of the grid */
+IdType PointId( unsigned int i, unsigned int j, unsigned int k )
+{
+  return i + ( Size + 1 ) * ( j + ( Size + 1 ) * k );
+}
+
+/** Fill a cube of Size^3 cells, each cell split in six tetrahedra */
+void CreateCube( SlicerType & slicer, std::vector< IdType > & tetrahedra )
+{
+  std::vector< double > coordinates;
+  for( unsigned int k = 0; k <= Size; k++ )
+    {
+    for( unsigned int j = 0; j <= Size; j++ )
+      {
+      for( unsigned int i = 0; i <= Size; i++ )
+        {
+        coordinates.push_back( i );
+        coordinates.push_back( j );
+        coordinates.push_back( k );
+        }
+      }
+    }
+  slicer.SetPoints( &coordinates[0], PointId( Size, Size, Size ) + 1 );
+
+  // The six paths from the lowest corner to the highest one
+  const unsigned int paths[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 },
+                                     { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+  for( unsigned int k = 0; k < Size; k++ )
+    {
+    for( unsigned int j = 0; j < Size; j++ )
+      {
+      for( unsigned int i = 0; i < Size; i++ )
+        {
+        for( unsigned int p = 0; p < 6; p++ )
+          {
+          unsigned int corner[3] = { i, j, k };
+          IdType ids[4];
+          ids[0] = PointId( corner[0], corner[1], corner[2] );
+          for( unsigned int step = 0; step < 3; step++ )
+            {
+            corner[ paths[p][step] ]++;
+            ids[ step + 1 ] = PointId( corner[0], corner[1], corner[2] );
+            }
+          slicer.AddCell( ids, 4 );
+          tetrahedra.insert( tetrahedra.end(), ids, ids + 4 );
+          }
+        }
+      }
+    }
+}
+
+/** Number of segments expected from cutting every tetrahedron */
+IdType CountSegments( const std::vector< IdType > & tetrahedra,
+                      const double center[3], const double normal[3] )
+{
+  IdType segments = 0;
+  for( unsigned int t = 0; t < tetrahedra.size(); t += 4 )
+    {
+    unsigned int above = 0;
+    for( unsigned int v = 0; v < 4; v++ )
+      {
+      const IdType id = tetrahedra[ t + v ];
+      const double point[3] = { static_cast<double>( id % ( Size + 1 ) ),
+        static_cast<double>( ( id / ( Size + 1 ) ) % ( Size + 1 ) ),
+        static_cast<double>( id / ( ( Size + 1 ) * ( Size + 1 ) ) ) };
+      double distance = 0.0;
+      for( unsigned int axis = 0; axis < 3; axis++ )
+        {
+        distance += normal[axis] * ( point[axis] - center[axis] );
+        }
+      if( distance >= 0.0 )
+        {
+        above++;
+        }
+      }
+    if( above == 1 || above == 3 )
+      {
+      segments += 3;
+      }
+    else if( above == 2 )
+      {
+      segments += 4;
+      }
+    }
+  return segments;
+}
+
+/** Check that the contour lies in the plane and in the cube */
+bool CheckContour( const SlicerType & slicer, const double center[3],
+                   const double normal[3] )
+{
+  const std::vector< double > & points = slicer.GetContourPoints();
+  for( unsigned int p = 0; p < points.size(); p += 3 )
+    {
+    double distance = 0.0;
+    for( unsigned int axis = 0; axis < 3; axis++ )
+      {
+      distance += normal[axis] * ( points[ p + axis ] - center[axis] );
+      if( points[ p + axis ] < -1e-9 || points[ p + axis ] > Size + 1e-9 )
+        {
+        return false;
+        }
+      }
+    if( fabs( distance ) > 1e-9 )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+int igstkMeshSlicerTest( int , char* [] )
+{
+  typedef MeshSlicerTest::SlicerType  SlicerType;
+  typedef MeshSlicerTest::IdType      IdType;
+
+  SlicerType slicer;
+  std::vector< IdType > tetrahedra;
+
+  MeshSlicerTest::CreateCube( slicer, tetrahedra );
+
+  const IdType invalidIds[4] = { 0, 1, 2, 100000 };
+  if( slicer.AddCell( invalidIds, 4 ) || slicer.AddCell( invalidIds, 5 ) )
+    {
+    std::cerr << "Invalid cells were accepted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  slicer.Build();
+
+  const double centers[3][3] = { { 6.3, 5.1, 4.7 },
+                                 { 2.0, 2.0, 2.55 },
+                                 { 6.0, 6.0, 6.0 } };
+  const double normals[3][3] = { { 0.0, 0.0, 1.0 },
+                                 { 0.48, 0.6, 0.64 },
+                                 { 1.0, 0.0, 0.0 } };
+
+  for( unsigned int plane = 0; plane < 3; plane++ )
+    {
+    const IdType expected = MeshSlicerTest::CountSegments( tetrahedra,
+                                                           centers[plane],
+                                                           normals[plane] );
+
+    // Cut twice to exercise the reused buffers
+    slicer.Cut( centers[plane], normals[plane] );
+    const IdType segments = slicer.Cut( centers[plane], normals[plane] );
+
+    std::cout << "Plane " << plane << ": " << segments << " segments, "
+              << slicer.GetNumberOfVisitedCells() << " of "
+              << slicer.GetNumberOfCells() << " cells visited" << std::endl;
+
+    if( segments != expected || segments == 0 )
+      {
+      std::cerr << "Expected " << expected << " segments" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if( !MeshSlicerTest::CheckContour( slicer, centers[plane],
+                                       normals[plane] ) )
+      {
+      std::cerr << "The contour is not in the plane" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if( slicer.GetNumberOfVisitedCells() >= slicer.GetNumberOfCells() / 2 )
+      {
+      std::cerr << "Too many cells visited" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A plane outside of the mesh visits nothing
+  const double outside[3] = { 0.0, 0.0, 20.0 };
+  if( slicer.Cut( outside, normals[0] ) != 0 ||
+      slicer.GetNumberOfVisitedCells() != 0 )
+    {
+    std::cerr << "Cells visited outside of the mesh" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A triangle contributes one segment
+  SlicerType triangleSlicer;
+  const double triangle[9] = { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 1.0 };
+  const IdType triangleIds[3] = { 0, 1, 2 };
+  triangleSlicer.SetPoints( triangle, 3 );
+  triangleSlicer.AddCell( triangleIds, 3 );
+  triangleSlicer.Build();
+
+  const double triangleCenter[3] = { 0.0, 0.0, 0.5 };
+  if( triangleSlicer.Cut( triangleCenter, normals[0] ) != 1 )
+    {
+    std::cerr << "Wrong triangle contour" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A line crossing the plane contributes a vertex, not a segment, and a
+  // line parallel to the plane contributes nothing
+  SlicerType lineSlicer;
+  const double line[12] = { 0.0, 0.0, 0.0, 2.0, 4.0, 1.0,
+                            0.0, 1.0, 0.0, 1.0, 1.0, 0.0 };
+  const IdType crossingIds[2] = { 0, 1 };
+  const IdType parallelIds[2] = { 2, 3 };
+  lineSlicer.SetPoints( line, 4 );
+  lineSlicer.AddCell( crossingIds, 2 );
+  lineSlicer.AddCell( parallelIds, 2 );
+  lineSlicer.Build();
+
+  if( lineSlicer.Cut( triangleCenter, normals[0] ) != 0 ||
+      lineSlicer.GetNumberOfVertices() != 1 ||
+      fabs( lineSlicer.GetVertexPoints()[0] - 1.0 ) > 1e-9 ||
+      fabs( lineSlicer.GetVertexPoints()[1] - 2.0 ) > 1e-9 ||
+      fabs( lineSlicer.GetVertexPoints()[2] - 0.5 ) > 1e-9 )
+    {
+    std::cerr << "Wrong vertex of the line" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( lineSlicer.Cut( outside, normals[0] ) != 0 ||
+      lineSlicer.GetNumberOfVertices() != 0 )
+    {
+    std::cerr << "Vertex of a previous cut kept" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
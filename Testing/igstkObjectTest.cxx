@@ -0,0 +1,338 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkObjectTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkObject.h"
+#include "igstkEvents.h"
+#include "itkCommand.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+namespace ObjectTest
+{
+
+igstkLoadedEventMacro( TestTransformEvent, igstk::IGSTKEvent,
+                       igstk::Transform );
+
+/** Records its identifier when called. A negative identifier is recorded
+ *  for the calls on a const object. */
+class Recorder : public ::itk::Command
+{
+public:
+  typedef  Recorder                   Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+
+  itkNewMacro( Self );
+
+  void Setup( int id, std::vector< int > * calls )
+    {
+    m_Id = id;
+    m_Calls = calls;
+    }
+
+  /** Observers to remove from, or add to, the caller at the first call */
+  void SetObserverToRemove( unsigned long tag )
+    {
+    m_TagToRemove = tag;
+    m_RemoveObserver = true;
+    }
+  void SetObserverToAdd( ::itk::Command * command )
+    {
+    m_CommandToAdd = command;
+    }
+
+  void Execute( itk::Object * caller, const itk::EventObject & )
+    {
+    m_Calls->push_back( m_Id );
+    igstk::Object * object = dynamic_cast< igstk::Object * >( caller );
+    if( m_RemoveObserver )
+      {
+      object->RemoveObserver( m_TagToRemove );
+      m_RemoveObserver = false;
+      }
+    if( m_CommandToAdd )
+      {
+      object->AddObserver( igstk::PulseEvent(), m_CommandToAdd );
+      m_CommandToAdd = NULL;
+      }
+    }
+
+  void Execute( const itk::Object *, const itk::EventObject & )
+    {
+    m_Calls->push_back( -m_Id );
+    }
+
+protected:
+  Recorder()
+    {
+    m_Id = 0;
+    m_Calls = NULL;
+    m_TagToRemove = 0;
+    m_RemoveObserver = false;
+    }
+
+private:
+  int                      m_Id;
+  std::vector< int > *     m_Calls;
+  unsigned long            m_TagToRemove;
+  bool                     m_RemoveObserver;
+  ::itk::Command::Pointer  m_CommandToAdd;
+};
+
+/** Counts its calls, from any thread */
+class Counter : public ::itk::Command
+{
+public:
+  typedef  Counter                    Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+
+  itkNewMacro( Self );
+
+  void Execute( itk::Object *, const itk::EventObject & )
+    {
+    m_Lock.Lock();
+    m_Count++;
+    m_Lock.Unlock();
+    }
+
+  void Execute( const itk::Object *, const itk::EventObject & )
+    {
+    m_Lock.Lock();
+    m_Count++;
+    m_Lock.Unlock();
+    }
+
+  unsigned long GetCount()
+    {
+    m_Lock.Lock();
+    const unsigned long count = m_Count;
+    m_Lock.Unlock();
+    return count;
+    }
+
+protected:
+  Counter()
+    {
+    m_Count = 0;
+    }
+
+private:
+  ::itk::SimpleMutexLock   m_Lock;
+  unsigned long            m_Count;
+};
+
+/** Object shared by the threads of the test, and its observers */
+static const unsigned int NumberOfInvocations = 20000;
+static igstk::Object *   SharedObject;
+static Counter *         PermanentCounter;
+static Counter *         TransientCounter;
+
+/** Invoke events on the shared object */
+ITK_THREAD_RETURN_TYPE InvokerThreadFunction( void * )
+{
+  for( unsigned int i = 0; i < NumberOfInvocations; i++ )
+    {
+    SharedObject->InvokeEvent( igstk::PulseEvent() );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Add and remove an observer of the shared object */
+ITK_THREAD_RETURN_TYPE ObserverThreadFunction( void * )
+{
+  for( unsigned int i = 0; i < NumberOfInvocations / 20; i++ )
+    {
+    const unsigned long tag =
+      SharedObject->AddObserver( igstk::IGSTKEvent(), TransientCounter );
+    SharedObject->RemoveObserver( tag );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool CheckCalls( const std::vector< int > & calls,
+                 const int * expected, unsigned int size,
+                 const char * message )
+{
+  bool ok = ( calls.size() == size );
+  for( unsigned int i = 0; ok && i < size; i++ )
+    {
+    ok = ( calls[i] == expected[i] );
+    }
+  if( !ok )
+    {
+    std::cerr << message << ":";
+    for( unsigned int i = 0; i < calls.size(); i++ )
+      {
+      std::cerr << " " << calls[i];
+      }
+    std::cerr << std::endl;
+    }
+  return ok;
+}
+
+}
+
+int igstkObjectTest( int , char* [] )
+{
+  typedef igstk::Object             ObjectType;
+  typedef ObjectTest::Recorder      RecorderType;
+
+  std::vector< int > calls;
+  std::vector< RecorderType::Pointer > recorders;
+  for( int i = 0; i < 5; i++ )
+    {
+    recorders.push_back( RecorderType::New() );
+    recorders[i]->Setup( i + 1, &calls );
+    }
+
+  ObjectType::Pointer object = ObjectType::New();
+  object->Print( std::cout );
+
+  // Observers of a superclass of the event are called, in order of addition
+  object->AddObserver( igstk::PulseEvent(), recorders[0] );
+  object->AddObserver( igstk::IGSTKEvent(), recorders[1] );
+  const unsigned long refreshTag =
+    object->AddObserver( igstk::RefreshEvent(), recorders[2] );
+  object->AddObserver( igstk::PulseEvent(), recorders[3] );
+
+  for( unsigned int i = 0; i < 2; i++ )
+    {
+    calls.clear();
+    object->InvokeEvent( igstk::PulseEvent() );
+    const int expected[] = { 1, 2, 4 };
+    if( !ObjectTest::CheckCalls( calls, expected, 3, "PulseEvent" ) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  calls.clear();
+  object->InvokeEvent( igstk::RefreshEvent() );
+  const ObjectType * constObject = object;
+  constObject->InvokeEvent( igstk::RefreshEvent() );
+  const int expectedRefresh[] = { 2, 3, -2, -3 };
+  if( !ObjectTest::CheckCalls( calls, expectedRefresh, 4, "RefreshEvent" ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  object->RemoveObserver( refreshTag );
+
+#if defined(IGSTK_USE_FastEventDispatch)
+  // An observer removed by a previous one is not called, and an observer
+  // added during the invocation is only called by the next one
+  const unsigned long tag =
+    object->AddObserver( igstk::PulseEvent(), recorders[4] );
+  recorders[0]->SetObserverToRemove( tag );
+  recorders[1]->SetObserverToAdd( recorders[2] );
+
+  calls.clear();
+  object->InvokeEvent( igstk::PulseEvent() );
+  object->InvokeEvent( igstk::PulseEvent() );
+  const int expectedModified[] = { 1, 2, 4, 1, 2, 4, 3 };
+  if( !ObjectTest::CheckCalls( calls, expectedModified, 7,
+                               "Observers modified during invocation" ) )
+    {
+    return EXIT_FAILURE;
+    }
+#endif
+
+#if defined(IGSTK_USE_FastEventDispatch)
+  // Events invoked by two threads, while a third one adds and removes
+  // observers, reach every observer that stays registered
+  ObjectType::Pointer sharedObject = ObjectType::New();
+  ObjectTest::Counter::Pointer permanentCounter = ObjectTest::Counter::New();
+  ObjectTest::Counter::Pointer transientCounter = ObjectTest::Counter::New();
+  ObjectTest::SharedObject = sharedObject;
+  ObjectTest::PermanentCounter = permanentCounter;
+  ObjectTest::TransientCounter = transientCounter;
+  sharedObject->AddObserver( igstk::PulseEvent(), permanentCounter );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( 3 );
+  threader->SetMultipleMethod( 0, ObjectTest::InvokerThreadFunction, NULL );
+  threader->SetMultipleMethod( 1, ObjectTest::InvokerThreadFunction, NULL );
+  threader->SetMultipleMethod( 2, ObjectTest::ObserverThreadFunction, NULL );
+  threader->MultipleMethodExecute();
+
+  if( permanentCounter->GetCount() != 2 * ObjectTest::NumberOfInvocations )
+    {
+    std::cerr << "Events lost by concurrent invocations: "
+              << permanentCounter->GetCount() << " calls instead of "
+              << 2 * ObjectTest::NumberOfInvocations << std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned long transientCount = transientCounter->GetCount();
+  sharedObject->InvokeEvent( igstk::PulseEvent() );
+  if( permanentCounter->GetCount() != 2 * ObjectTest::NumberOfInvocations + 1
+      || transientCounter->GetCount() != transientCount )
+    {
+    std::cerr << "Wrong observers after concurrent invocations" << std::endl;
+    return EXIT_FAILURE;
+    }
+#endif
+
+  calls.clear();
+  object->RemoveAllObservers();
+  object->InvokeEvent( igstk::PulseEvent() );
+  if( !calls.empty() || object->HasObserver( igstk::PulseEvent() ) )
+    {
+    std::cerr << "Observers left after RemoveAllObservers()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The events invoked by itk::Object reach the observers. DeleteEvent is
+  // invoked on a const object.
+  object->AddObserver( itk::DeleteEvent(), recorders[0] );
+  calls.clear();
+  object = NULL;
+  if( calls.size() != 1 || ( calls[0] != 1 && calls[0] != -1 ) )
+    {
+    std::cerr << "DeleteEvent was not received" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Payloads passed by reference are not copied
+  igstk::Transform transform;
+  transform.SetToIdentity( 10.0 );
+  ObjectTest::TestTransformEvent event;
+  event.SetReference( transform );
+  if( &event.Get() != &transform )
+    {
+    std::cerr << "The payload passed by reference was copied" << std::endl;
+    return EXIT_FAILURE;
+    }
+  event.Set( transform );
+  if( &event.Get() == &transform )
+    {
+    std::cerr << "The payload set by value was not copied" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
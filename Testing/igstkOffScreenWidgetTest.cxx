@@ -0,0 +1,153 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOffScreenWidgetTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// 
+//  The purpose of this test is to verify that a view can be rendered without
+//  an on-screen window, both synchronously and from its pulse generator.
+//
+
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug 
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include <iostream>
+
+#include "igstkRealTimeClock.h"
+#include "igstkView3D.h"
+#include "igstkOffScreenWidget.h"
+#include "igstkEllipsoidObject.h"
+#include "igstkEllipsoidObjectRepresentation.h"
+#include "igstkAxesObject.h"
+#include "igstkVTKLoggerOutput.h"
+#include "igstkLogger.h"
+#include "itkStdStreamLogOutput.h"
+
+int igstkOffScreenWidgetTest( int argc, char *argv [] )
+{
+  igstk::RealTimeClock::Initialize();
+
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " screenshot.png" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef igstk::Object::LoggerType   LoggerType;
+  typedef itk::StdStreamLogOutput     LogOutputType;
+
+  LoggerType::Pointer   logger = LoggerType::New();
+  LogOutputType::Pointer logOutput = LogOutputType::New();
+  logOutput->SetStream( std::cout );
+  logger->AddLogOutput( logOutput );
+  logger->SetPriorityLevel( itk::Logger::CRITICAL );
+
+  igstk::VTKLoggerOutput::Pointer vtkLoggerOutput = 
+                                              igstk::VTKLoggerOutput::New();
+  vtkLoggerOutput->OverrideVTKWindow();
+  vtkLoggerOutput->SetLogger(logger);
+
+  igstk::AxesObject::Pointer worldReference = igstk::AxesObject::New();
+
+  igstk::EllipsoidObject::Pointer ellipsoid = igstk::EllipsoidObject::New();
+  ellipsoid->SetRadius( 10.0, 20.0, 30.0 );
+
+  igstk::EllipsoidObjectRepresentation::Pointer ellipsoidRepresentation =
+                              igstk::EllipsoidObjectRepresentation::New();
+  ellipsoidRepresentation->RequestSetEllipsoidObject( ellipsoid );
+  ellipsoidRepresentation->SetColor( 0.0, 1.0, 0.0 );
+
+  igstk::Transform identity;
+  identity.SetToIdentity( igstk::TimeStamp::GetLongestPossibleTime() );
+
+  ellipsoid->RequestSetTransformAndParent( identity, worldReference );
+
+  typedef igstk::View3D  View3DType;
+  View3DType::Pointer view3D = View3DType::New();
+  view3D->SetLogger( logger );
+  view3D->RequestSetTransformAndParent( identity, worldReference );
+
+  igstk::OffScreenWidget::Pointer widget = igstk::OffScreenWidget::New();
+  widget->SetLogger( logger );
+
+  // Exercise the invalid requests before connecting a view
+  widget->RequestRender();
+  widget->RequestSetSize( 0, 100 );
+  widget->RequestSetView( NULL );
+
+  widget->RequestSetSize( 320, 240 );
+  widget->RequestSetView( view3D );
+
+  // The size cannot be changed once the view is connected
+  widget->RequestSetSize( 640, 480 );
+
+  view3D->RequestAddObject( ellipsoidRepresentation );
+  view3D->RequestResetCamera();
+
+  //
+  // Synchronous rendering
+  //
+  const unsigned long numberOfFrames = 20;
+
+  for( unsigned int i = 0; i < numberOfFrames; i++ )
+    {
+    widget->RequestRender();
+    }
+
+  if( view3D->GetNumberOfRenderedFrames() != numberOfFrames )
+    {
+    std::cerr << "Expected " << numberOfFrames << " rendered frames but got "
+              << view3D->GetNumberOfRenderedFrames() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Rendering driven by the pulse generator
+  //
+  view3D->SetRefreshRate( 50 );
+  view3D->RequestStart();
+
+  const double startTime = igstk::RealTimeClock::GetTimeStamp();
+  while( igstk::RealTimeClock::GetTimeStamp() - startTime < 500.0 )
+    {
+    igstk::PulseGenerator::Sleep( 5 );
+    igstk::PulseGenerator::CheckTimeouts();
+    }
+
+  view3D->RequestStop();
+
+  if( view3D->GetNumberOfRenderedFrames() <= numberOfFrames )
+    {
+    std::cerr << "The pulse generator did not render any frame" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  view3D->RequestSaveScreenShot( argv[1] );
+
+  //purely for code coverage.
+  widget->Print( std::cout );
+
+  if( vtkLoggerOutput->GetNumberOfErrorMessages()  > 0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkOpenIGTLinkVideoImagerTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters
+// in the debug information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#include "itkMultiThreader.h"
+#include "igstkRealTimeClock.h"
+#include "igstkPulseGenerator.h"
+#include "igstkOpenIGTLinkVideoImager.h"
+#include "igstkOpenIGTLinkVideoImagerTool.h"
+
+#include "igtlServerSocket.h"
+#include "igtlClientSocket.h"
+#include "igtlImageMessage.h"
+#include "igtl_header.h"
+#include "igtl_image.h"
+
+static ITK_THREAD_RETURN_TYPE ImagerThreadFunction(void*);
+static ITK_THREAD_RETURN_TYPE SenderThreadFunction(void*);
+
+/** Frame size and receive timeout of the imager */
+static const int          m_FrameSize = 16;
+static const unsigned int m_ReceiveTimeout = 50;
+
+static int                          m_Port;
+static bool                         m_CRCCheck;
+static igtl::ServerSocket::Pointer  m_ServerSocket;
+static volatile bool                m_SenderDone;
+
+/** Pixel values of the frames received by the imager, 0 for a frame whose
+ *  pixels are not all equal */
+static std::set< int >              m_ReceivedValues;
+static int                          m_LastValue;
+
+int igstkOpenIGTLinkVideoImagerTest( int argc, char * argv [] )
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " portnumber" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  igstk::RealTimeClock::Initialize();
+
+  m_Port = atoi( argv[1] );
+  m_ServerSocket = igtl::ServerSocket::New();
+  if( m_ServerSocket->CreateServer( m_Port ) < 0 )
+    {
+    std::cerr << "Could not create a server on port " << m_Port << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The sender interrupts a message body and a message header for longer
+  // than the receive timeout. The interrupted body must be dropped and the
+  // interrupted header completed, with the pixel data received through the
+  // message buffer and directly into the frame buffer.
+  for( unsigned int mode = 0; mode < 2; mode++ )
+    {
+    m_CRCCheck = ( mode == 0 );
+    m_SenderDone = false;
+    m_ReceivedValues.clear();
+    m_LastValue = -1;
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( 2 );
+    threader->SetMultipleMethod( 0, ImagerThreadFunction, NULL );
+    threader->SetMultipleMethod( 1, SenderThreadFunction, NULL );
+    threader->MultipleMethodExecute();
+
+    std::cout << "CRC check " << m_CRCCheck << ", frames received:";
+    std::set< int >::const_iterator itr = m_ReceivedValues.begin();
+    while( itr != m_ReceivedValues.end() )
+      {
+      std::cout << " " << *itr;
+      ++itr;
+      }
+    std::cout << std::endl;
+
+    std::set< int > expected;
+    expected.insert( 1 );
+    expected.insert( 3 );
+    expected.insert( 4 );
+    expected.insert( 5 );
+    if( m_ReceivedValues != expected || m_LastValue != 5 )
+      {
+      std::cerr << "The imager did not resynchronize on the stream"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  m_ServerSocket->CloseSocket();
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+/** Thread function running the imager and recording its frames */
+ITK_THREAD_RETURN_TYPE ImagerThreadFunction(void* itkNotUsed(pInfo))
+{
+  typedef igstk::OpenIGTLinkVideoImager       ImagerType;
+  typedef igstk::OpenIGTLinkVideoImagerTool   ImagerToolType;
+
+  ImagerType::Pointer imager = ImagerType::New();
+  imager->SetCommunication( m_ServerSocket );
+  imager->SetCRCCheck( m_CRCCheck );
+  imager->SetReceiveTimeout( m_ReceiveTimeout );
+  imager->RequestSetFrequency( 30 );
+  imager->RequestOpen();
+
+  ImagerToolType::Pointer imagerTool = ImagerToolType::New();
+  unsigned int dims[3] = { m_FrameSize, m_FrameSize, 1 };
+  imagerTool->SetFrameDimensions( dims );
+  imagerTool->SetPixelDepth( 8 );
+  // The temporal calibrated frame is the last frame received
+  imagerTool->SetDelay( 1 );
+  imagerTool->RequestSetVideoImagerToolName( "Camera" );
+  imagerTool->RequestConfigure();
+  imagerTool->RequestAttachToVideoImager( imager );
+
+  // Waits for the sender to connect
+  imager->RequestStartImaging();
+
+  const unsigned int numberOfPixels = m_FrameSize * m_FrameSize;
+  unsigned int pulsesAfterSender = 0;
+  while( pulsesAfterSender < 20 )
+    {
+    if( m_SenderDone )
+      {
+      pulsesAfterSender++;
+      }
+    igstk::PulseGenerator::Sleep( 5 );
+    igstk::PulseGenerator::CheckTimeouts();
+
+    if( !imagerTool->GetUpdated() )
+      {
+      continue;
+      }
+
+    const unsigned char * pixels = static_cast< const unsigned char * >(
+      imagerTool->GetTemporalCalibratedFrame()->GetImagePtr() );
+    int value = pixels[0];
+    for( unsigned int i = 1; i < numberOfPixels; i++ )
+      {
+      if( pixels[i] != pixels[0] )
+        {
+        value = 0;
+        }
+      }
+    m_ReceivedValues.insert( value );
+    m_LastValue = value;
+    }
+
+  imager->RequestStopImaging();
+  imager->RequestClose();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Send an IMAGE message with all its pixels set to value. When firstPart
+ *  is not zero, the message is sent in two parts with a pause longer than
+ *  the receive timeout after its first firstPart bytes. */
+static void SendImage( igtl::Socket * socket, unsigned char value,
+                       int firstPart )
+{
+  igtl::ImageMessage::Pointer message = igtl::ImageMessage::New();
+  int size[3] = { m_FrameSize, m_FrameSize, 1 };
+  message->SetDimensions( size );
+  message->SetScalarType( igtl::ImageMessage::TYPE_UINT8 );
+  message->SetDeviceName( "Camera" );
+  message->AllocateScalars();
+  memset( message->GetScalarPointer(), value, message->GetImageSize() );
+  message->Pack();
+
+  const char * pack = static_cast< const char * >( message->GetPackPointer() );
+  const int packSize = static_cast< int >( message->GetPackSize() );
+
+  if( firstPart > 0 )
+    {
+    socket->Send( pack, firstPart );
+    igstk::PulseGenerator::Sleep( 4 * m_ReceiveTimeout );
+    socket->Send( pack + firstPart, packSize - firstPart );
+    }
+  else
+    {
+    socket->Send( pack, packSize );
+    }
+
+  // Leave the imager time to report the frame
+  igstk::PulseGenerator::Sleep( 200 );
+}
+
+/** Thread function sending the frames, some of them interrupted */
+ITK_THREAD_RETURN_TYPE SenderThreadFunction(void* itkNotUsed(pInfo))
+{
+  igtl::ClientSocket::Pointer socket = igtl::ClientSocket::New();
+
+  // Give the imager time to wait for the connection
+  igstk::PulseGenerator::Sleep( 500 );
+  unsigned int tries = 0;
+  while( socket->ConnectToServer( "localhost", m_Port ) != 0 )
+    {
+    if( ++tries == 40 )
+      {
+      std::cerr << "Could not connect to the imager" << std::endl;
+      m_SenderDone = true;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    igstk::PulseGenerator::Sleep( 250 );
+    }
+  igstk::PulseGenerator::Sleep( 200 );
+
+  // Complete frame
+  SendImage( socket, 1, 0 );
+
+  // Frame interrupted in its body, dropped
+  const int bodyPart = IGTL_HEADER_SIZE + IGTL_IMAGE_HEADER_SIZE +
+                       m_FrameSize * m_FrameSize / 2;
+  SendImage( socket, 2, bodyPart );
+
+  // Complete frame following the dropped one
+  SendImage( socket, 3, 0 );
+
+  // Frame interrupted in its header, completed
+  SendImage( socket, 4, IGTL_HEADER_SIZE / 2 );
+
+  SendImage( socket, 5, 0 );
+
+  socket->CloseSocket();
+  m_SenderDone = true;
+
+  return ITK_THREAD_RETURN_VALUE;
+}
@@ -0,0 +1,912 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkPipelineBenchmark.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+//
+//  Measure the cost of the steps of the tracking-to-render pipeline:
+//
+//    StateMachineProcessInput   one input processed by a state machine
+//    TransformCompose           Transform::TransformCompose()
+//    TransformBatchCompose      TransformBatch::Compose() of N poses
+//    ComputeTransformTo         CoordinateSystem::RequestComputeTransformTo()
+//                               through a chain of N coordinate systems
+//    TrackerUpdate              one update of a tracker with N tools
+//    NDIReplyParsing            an NDI TX command with N port handles,
+//                               written, read and parsed without delay
+//    SerialSimulatorRead        a write and a read of an N bytes reply
+//                               through SerialCommunicationSimulator,
+//                               without delay
+//    ViewRefreshRender          View::RefreshRender() of N objects rendered
+//                               offscreen
+//
+//  Each measurement repeats its operation until it lasts at least the
+//  minimum time, and reports the time per iteration. The results are
+//  printed as a table and as DartMeasurement tags, which the dashboard
+//  records for every build, and can be written to a CSV file with one line
+//  per measurement.
+//
+//  Usage:
+//    igstkPipelineBenchmark [-quick] [-time milliseconds] [-csv file]
+//                           [-directory temporaryFilesDirectory]
+//                           [-norender]
+//
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+// Warning about: constructor of the state machine receiving a pointer to this
+// from a constructor. This is not a problem in this case, since the state
+// machine constructor is not using the pointer, just storing it internally.
+#pragma warning( disable : 4355 )
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "igstkRealTimeClock.h"
+#include "igstkStateMachine.h"
+#include "igstkMacros.h"
+#include "igstkTransform.h"
+#include "igstkTransformBatch.h"
+#include "igstkCoordinateSystem.h"
+#include "igstkTransformObserver.h"
+#include "igstkSyntheticTracker.h"
+#include "igstkSimulatedTrackerTool.h"
+#include "igstkNDICommandInterpreter.h"
+#include "igstkSerialCommunicationSimulator.h"
+#include "igstkBinaryData.h"
+#include "igstkAxesObject.h"
+#include "igstkEllipsoidObject.h"
+#include "igstkEllipsoidObjectRepresentation.h"
+#include "igstkView3D.h"
+#include "igstkOffScreenWidget.h"
+
+
+namespace igstk
+{
+
+namespace PipelineBenchmark
+{
+
+/** Time spent in a number of iterations of an operation */
+struct Result
+{
+  std::string     m_Name;
+  unsigned int    m_Parameter;
+  unsigned long   m_Iterations;
+  double          m_Time;
+};
+
+
+/** An operation to measure */
+class Operation
+{
+public:
+  virtual ~Operation() {}
+
+  /** Perform the operation a number of times */
+  virtual void Run( unsigned long iterations ) = 0;
+};
+
+
+/** Repeat an operation, with a number of iterations growing until the run
+ *  lasts at least minimumTime milliseconds */
+Result Measure( const std::string & name, unsigned int parameter,
+                Operation & operation, double minimumTime )
+{
+  const unsigned long maximumIterations = 100000000;
+
+  // Warm up the caches and any lazy initialization
+  operation.Run( 1 );
+
+  unsigned long iterations = 1;
+  double elapsed = 0.0;
+  while( true )
+    {
+    const double start = RealTimeClock::GetTimeStamp();
+    operation.Run( iterations );
+    elapsed = RealTimeClock::GetTimeStamp() - start;
+
+    if( elapsed >= minimumTime || iterations >= maximumIterations )
+      {
+      break;
+      }
+
+    // Aim past the minimum time, growing by a factor from 2 to 100
+    double factor = 100.0;
+    if( elapsed > 0.0 )
+      {
+      factor = 1.2 * minimumTime / elapsed;
+      if( factor < 2.0 )
+        {
+        factor = 2.0;
+        }
+      else if( factor > 100.0 )
+        {
+        factor = 100.0;
+        }
+      }
+    iterations = static_cast< unsigned long >( iterations * factor );
+    if( iterations > maximumIterations )
+      {
+      iterations = maximumIterations;
+      }
+    }
+
+  Result result;
+  result.m_Name = name;
+  result.m_Parameter = parameter;
+  result.m_Iterations = iterations;
+  result.m_Time = elapsed;
+  return result;
+}
+
+
+/** Collect the results and write them in the formats for humans, for the
+ *  dashboard and for scripts */
+class Reporter
+{
+public:
+
+  void Add( const Result & result )
+    {
+    m_Results.push_back( result );
+
+    const double microseconds = 1000.0 * result.m_Time / result.m_Iterations;
+
+    std::cout << std::setw(26) << result.m_Name
+              << std::setw(10) << result.m_Parameter
+              << std::setw(12) << result.m_Iterations
+              << std::setw(16) << microseconds << std::endl;
+
+    std::cout << "<DartMeasurement name=\"" << result.m_Name;
+    if( result.m_Parameter > 0 )
+      {
+      std::cout << "_" << result.m_Parameter;
+      }
+    std::cout << "\" type=\"numeric/double\">" << microseconds
+              << "</DartMeasurement>" << std::endl;
+    }
+
+  void PrintHeader() const
+    {
+    std::cout << std::setw(26) << "Benchmark"
+              << std::setw(10) << "N"
+              << std::setw(12) << "Iterations"
+              << std::setw(16) << "us/iteration" << std::endl;
+    }
+
+  bool WriteCSV( const std::string & fileName ) const
+    {
+    std::ofstream file( fileName.c_str() );
+    if( !file )
+      {
+      return false;
+      }
+
+    file << "benchmark,parameter,iterations,total_ms,"
+         << "us_per_iteration,iterations_per_second" << std::endl;
+    file.precision( 10 );
+    for( unsigned int i = 0; i < m_Results.size(); i++ )
+      {
+      const Result & result = m_Results[i];
+      file << result.m_Name << ","
+           << result.m_Parameter << ","
+           << result.m_Iterations << ","
+           << result.m_Time << ","
+           << 1000.0 * result.m_Time / result.m_Iterations << ","
+           << ( result.m_Time > 0.0 ?
+                1000.0 * result.m_Iterations / result.m_Time : 0.0 )
+           << std::endl;
+      }
+    return file.good();
+    }
+
+private:
+  std::vector< Result >  m_Results;
+};
+
+
+/** State machine switching between two states, with an action on every
+ *  transition */
+class Switch
+{
+public:
+
+  typedef StateMachine< Switch >                          StateMachineType;
+  typedef StateMachineType::TMemberFunctionPointer        ActionType;
+  typedef StateMachineType::StateType                     StateType;
+  typedef StateMachineType::InputType                     InputType;
+
+  igstkFriendClassMacro( StateMachine< Switch > );
+
+  igstkTypeMacro( Switch, None );
+
+  Switch():m_StateMachine(this)
+    {
+    m_NumberOfToggles = 0;
+
+    m_StateMachine.AddState( m_OffState, "OffState" );
+    m_StateMachine.AddState( m_OnState, "OnState" );
+
+    m_StateMachine.AddInput( m_ToggleInput, "ToggleInput" );
+    m_StateMachine.AddInput( m_ResetInput, "ResetInput" );
+
+    m_StateMachine.AddTransition( m_OffState, m_ToggleInput,
+                                  m_OnState, & Switch::CountToggle );
+    m_StateMachine.AddTransition( m_OnState, m_ToggleInput,
+                                  m_OffState, & Switch::CountToggle );
+    m_StateMachine.AddTransition( m_OffState, m_ResetInput,
+                                  m_OffState, & Switch::CountToggle );
+    m_StateMachine.AddTransition( m_OnState, m_ResetInput,
+                                  m_OffState, & Switch::CountToggle );
+
+    m_StateMachine.SelectInitialState( m_OffState );
+    m_StateMachine.SetReadyToRun();
+    }
+
+  virtual ~Switch() {}
+
+  void Toggle()
+    {
+    m_StateMachine.PushInput( m_ToggleInput );
+    m_StateMachine.ProcessInputs();
+    }
+
+  unsigned long GetNumberOfToggles() const
+    {
+    return m_NumberOfToggles;
+    }
+
+  /** Declarations needed for the Logging */
+  igstkLoggerMacro();
+
+protected:
+
+  void CountToggle()
+    {
+    m_NumberOfToggles++;
+    }
+
+private:
+
+  StateMachineType   m_StateMachine;
+
+  StateType          m_OffState;
+  StateType          m_OnState;
+
+  InputType          m_ToggleInput;
+  InputType          m_ResetInput;
+
+  unsigned long      m_NumberOfToggles;
+};
+
+
+class StateMachineOperation : public Operation
+{
+public:
+  void Run( unsigned long iterations )
+    {
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Switch.Toggle();
+      }
+    }
+
+  Switch  m_Switch;
+};
+
+
+/** Transform with a translation and a rotation, valid for ever */
+Transform CreateTransform( double x, double y, double z, double angle )
+{
+  Transform::VectorType translation;
+  translation[0] = x;
+  translation[1] = y;
+  translation[2] = z;
+  Transform::VersorType rotation;
+  rotation.SetRotationAroundZ( angle );
+
+  Transform transform;
+  transform.SetTranslationAndRotation( translation, rotation, 0.1,
+    TimeStamp::GetLongestPossibleTime() );
+  return transform;
+}
+
+
+class TransformComposeOperation : public Operation
+{
+public:
+  TransformComposeOperation()
+    {
+    m_Left = CreateTransform( 1.0, 2.0, 3.0, 0.1 );
+    m_Right = CreateTransform( -4.0, 5.0, 6.0, 0.2 );
+    }
+
+  void Run( unsigned long iterations )
+    {
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Result = Transform::TransformCompose( m_Left, m_Right );
+      }
+    }
+
+  Transform  m_Left;
+  Transform  m_Right;
+  Transform  m_Result;
+};
+
+
+class TransformBatchOperation : public Operation
+{
+public:
+  explicit TransformBatchOperation( unsigned int numberOfPoses )
+    {
+    Pose pose;
+    TransformBatch::ExportPose( CreateTransform( 1.0, 2.0, 3.0, 0.1 ), pose );
+    m_Left.resize( numberOfPoses, pose );
+    TransformBatch::ExportPose( CreateTransform( 4.0, 5.0, 6.0, 0.2 ), pose );
+    m_Right.resize( numberOfPoses, pose );
+    m_Result.resize( numberOfPoses );
+    }
+
+  void Run( unsigned long iterations )
+    {
+    const unsigned int numberOfPoses =
+      static_cast< unsigned int >( m_Result.size() );
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      TransformBatch::Compose( &m_Left[0], &m_Right[0], &m_Result[0],
+                               numberOfPoses );
+      }
+    }
+
+  std::vector< Pose >  m_Left;
+  std::vector< Pose >  m_Right;
+  std::vector< Pose >  m_Result;
+};
+
+
+/** Chain of coordinate systems, the transform being computed from the
+ *  deepest one to the root */
+class ComputeTransformToOperation : public Operation
+{
+public:
+  explicit ComputeTransformToOperation( unsigned int depth )
+    {
+    m_Root = CoordinateSystem::New();
+    CoordinateSystem::Pointer parent = m_Root;
+    for( unsigned int i = 0; i < depth; i++ )
+      {
+      CoordinateSystem::Pointer child = CoordinateSystem::New();
+      child->RequestSetTransformAndParent(
+        CreateTransform( 1.0, 0.0, 0.0, 0.01 ), parent );
+      m_Chain.push_back( child );
+      parent = child;
+      }
+    m_Observer = TransformObserver::New();
+    m_Observer->ObserveTransformEventsFrom( parent );
+    }
+
+  void Run( unsigned long iterations )
+    {
+    CoordinateSystem * leaf = m_Chain.back();
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      leaf->RequestComputeTransformTo( m_Root );
+      }
+    }
+
+  bool GotTransform() const
+    {
+    return m_Observer->GotTransform();
+    }
+
+  CoordinateSystem::Pointer                 m_Root;
+  std::vector< CoordinateSystem::Pointer >  m_Chain;
+  TransformObserver::Pointer                m_Observer;
+};
+
+
+/** Synthetic tracker updated on request, without tracking thread */
+class BenchmarkTracker : public SyntheticTracker
+{
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( BenchmarkTracker, SyntheticTracker )
+
+  void Update()
+    {
+    this->RequestUpdateStatus();
+    }
+
+protected:
+
+  BenchmarkTracker():m_StateMachine(this)
+    {
+    this->SetThreadingEnabled( false );
+    }
+
+  ~BenchmarkTracker()
+    {
+    }
+};
+
+
+class TrackerUpdateOperation : public Operation
+{
+public:
+  explicit TrackerUpdateOperation( unsigned int numberOfTools )
+    {
+    m_Tracker = BenchmarkTracker::New();
+    m_Tracker->RequestOpen();
+    m_Tracker->RequestSetFrequency( 100.0 );
+    for( unsigned int i = 0; i < numberOfTools; i++ )
+      {
+      SimulatedTrackerTool::Pointer tool = SimulatedTrackerTool::New();
+      std::ostringstream identifier;
+      identifier << "tool" << i;
+      tool->RequestSetName( identifier.str() );
+      tool->RequestConfigure();
+      tool->RequestAttachToTracker( m_Tracker );
+      m_Tools.push_back( tool );
+      }
+    m_Tracker->RequestStartTracking();
+    }
+
+  ~TrackerUpdateOperation()
+    {
+    m_Tracker->RequestStopTracking();
+    m_Tracker->RequestClose();
+    }
+
+  void Run( unsigned long iterations )
+    {
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Tracker->Update();
+      }
+    }
+
+  unsigned long GetNumberOfUpdates() const
+    {
+    DeviceTelemetryReport report;
+    m_Tracker->GetTelemetry()->GetReport( report );
+    return report.m_NumberOfUpdates - report.m_NumberOfUpdateErrors;
+    }
+
+  BenchmarkTracker::Pointer                     m_Tracker;
+  std::vector< SimulatedTrackerTool::Pointer >  m_Tools;
+};
+
+
+/** CRC of the NDI devices, as computed by NDICommandInterpreter */
+unsigned int ComputeNDICRC( const std::string & text )
+{
+  static const int oddParity[16] = { 0, 1, 1, 0, 1, 0, 0, 1,
+                                     1, 0, 0, 1, 0, 1, 1, 0 };
+  unsigned int crc = 0;
+  for( std::string::size_type i = 0; i < text.size(); i++ )
+    {
+    int data = ( static_cast< unsigned char >( text[i] ) ^ ( crc & 0xff ) )
+               & 0xff;
+    crc >>= 8;
+    if( oddParity[data & 0x0f] ^ oddParity[data >> 4] )
+      {
+      crc ^= 0xc001;
+      }
+    data <<= 6;
+    crc ^= data;
+    data <<= 1;
+    crc ^= data;
+    }
+  return crc;
+}
+
+
+/** Append the CRC of a text and a carriage return */
+std::string AppendNDICRC( const std::string & text )
+{
+  std::ostringstream output;
+  output << text << std::uppercase << std::hex << std::setfill('0')
+         << std::setw(4) << ComputeNDICRC( text ) << "\r";
+  return output.str();
+}
+
+
+/** Write a simulation file in which the device replies to "TX:0001" with
+ *  the transforms of numberOfHandles port handles. Returns the command and
+ *  the reply. */
+bool WriteTXSimulationFile( const std::string & fileName,
+                            unsigned int numberOfHandles,
+                            std::string & command, std::string & reply )
+{
+  std::ostringstream text;
+  text << std::uppercase << std::hex << std::setfill('0');
+  text << std::setw(2) << numberOfHandles;
+  for( unsigned int handle = 1; handle <= numberOfHandles; handle++ )
+    {
+    text << std::setw(2) << handle
+         << "+10000+00000+00000+00000"   // rotation
+         << "+001000-002000+003000"      // translation, 1/100 mm
+         << "+00010"                     // error
+         << "00000031"                   // port status
+         << std::setw(8) << 1000 + handle  // frame number
+         << "\n";
+    }
+  text << "0000";                        // system status
+
+  command = AppendNDICRC( "TX:0001" );
+  reply = AppendNDICRC( text.str() );
+
+  std::string encodedCommand;
+  BinaryData::Encode( encodedCommand,
+    reinterpret_cast< const unsigned char * >( command.c_str() ),
+    command.size() );
+  std::string encodedReply;
+  BinaryData::Encode( encodedReply,
+    reinterpret_cast< const unsigned char * >( reply.c_str() ),
+    reply.size() );
+
+  // The format of the logs of SerialCommunication
+  std::ofstream file( fileName.c_str() );
+  file << "0.000000 : (INFO) 1. command[" << command.size() << "] "
+       << encodedCommand << std::endl;
+  file << "0.000100 : (INFO) 1. receive[" << reply.size() << "] "
+       << encodedReply << std::endl;
+  return file.good();
+}
+
+
+/** Simulator answering immediately, to measure the reads and the parsing
+ *  rather than the simulated delays of the device */
+class ImmediateSerialCommunicationSimulator :
+  public SerialCommunicationSimulator
+{
+public:
+
+  /** Macro with standard traits declarations. */
+  igstkStandardClassTraitsMacro( ImmediateSerialCommunicationSimulator,
+                                 SerialCommunicationSimulator )
+
+protected:
+
+  ImmediateSerialCommunicationSimulator():m_StateMachine(this)
+    {
+    }
+
+  ~ImmediateSerialCommunicationSimulator()
+    {
+    }
+
+  virtual void InternalSleep( unsigned int itkNotUsed(milliseconds) )
+    {
+    }
+};
+
+
+class NDIReplyParsingOperation : public Operation
+{
+public:
+  NDIReplyParsingOperation( const std::string & fileName )
+    {
+    m_Communication = ImmediateSerialCommunicationSimulator::New();
+    m_Communication->SetFileName( fileName.c_str() );
+    m_Communication->OpenCommunication();
+
+    m_Interpreter = NDICommandInterpreter::New();
+    m_Interpreter->SetCommunication( m_Communication );
+    }
+
+  ~NDIReplyParsingOperation()
+    {
+    m_Communication->CloseCommunication();
+    }
+
+  void Run( unsigned long iterations )
+    {
+    double transform[8];
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Interpreter->TX( NDICommandInterpreter::NDI_XFORMS_AND_STATUS );
+      m_Interpreter->GetTXTransform( 1, transform );
+      }
+    }
+
+  bool IsValid() const
+    {
+    double transform[8];
+    return m_Interpreter->GetError() == 0 &&
+           m_Interpreter->GetTXTransform( 1, transform ) ==
+             NDICommandInterpreter::NDI_VALID &&
+           std::fabs( transform[4] - 10.0 ) < 1e-6;
+    }
+
+  ImmediateSerialCommunicationSimulator::Pointer  m_Communication;
+  NDICommandInterpreter::Pointer                  m_Interpreter;
+};
+
+
+class SerialSimulatorOperation : public Operation
+{
+public:
+  SerialSimulatorOperation( const std::string & fileName,
+                            const std::string & command,
+                            unsigned int replySize )
+    : m_Command( command ), m_Buffer( replySize + 1 )
+    {
+    m_Communication = ImmediateSerialCommunicationSimulator::New();
+    m_Communication->SetFileName( fileName.c_str() );
+    m_Communication->OpenCommunication();
+    m_Communication->SetReadTerminationCharacter( '\r' );
+    m_Communication->SetUseReadTerminationCharacter( true );
+    m_BytesRead = 0;
+    }
+
+  ~SerialSimulatorOperation()
+    {
+    m_Communication->CloseCommunication();
+    }
+
+  void Run( unsigned long iterations )
+    {
+    const unsigned int bufferSize =
+      static_cast< unsigned int >( m_Buffer.size() );
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Communication->Write( m_Command.c_str(),
+        static_cast< unsigned int >( m_Command.size() ) );
+      m_Communication->Read( &m_Buffer[0], bufferSize, m_BytesRead );
+      }
+    }
+
+  ImmediateSerialCommunicationSimulator::Pointer  m_Communication;
+  std::string                                     m_Command;
+  std::vector< char >                             m_Buffer;
+  unsigned int                                    m_BytesRead;
+};
+
+
+class ViewRefreshRenderOperation : public Operation
+{
+public:
+  explicit ViewRefreshRenderOperation( unsigned int numberOfObjects )
+    {
+    Transform identity;
+    identity.SetToIdentity( TimeStamp::GetLongestPossibleTime() );
+
+    m_World = AxesObject::New();
+
+    m_View = View3D::New();
+    m_View->SetRefreshMode( View::FixedRateRefresh );
+    m_View->RequestSetTransformAndParent( identity, m_World );
+
+    m_Widget = OffScreenWidget::New();
+    m_Widget->RequestSetSize( 320, 240 );
+    m_Widget->RequestSetView( m_View );
+
+    // Ellipsoids on a grid
+    for( unsigned int i = 0; i < numberOfObjects; i++ )
+      {
+      EllipsoidObject::Pointer ellipsoid = EllipsoidObject::New();
+      ellipsoid->SetRadius( 2.0, 3.0, 4.0 );
+      ellipsoid->RequestSetTransformAndParent(
+        CreateTransform( 10.0 * ( i % 10 ), 10.0 * ( i / 10 ), 0.0, 0.0 ),
+        m_World );
+
+      EllipsoidObjectRepresentation::Pointer representation =
+        EllipsoidObjectRepresentation::New();
+      representation->RequestSetEllipsoidObject( ellipsoid );
+      m_View->RequestAddObject( representation );
+
+      m_Objects.push_back( ellipsoid );
+      m_Representations.push_back( representation );
+      }
+
+    m_View->RequestResetCamera();
+    }
+
+  void Run( unsigned long iterations )
+    {
+    for( unsigned long i = 0; i < iterations; i++ )
+      {
+      m_Widget->RequestRender();
+      }
+    }
+
+  AxesObject::Pointer                                m_World;
+  View3D::Pointer                                    m_View;
+  OffScreenWidget::Pointer                           m_Widget;
+  std::vector< EllipsoidObject::Pointer >            m_Objects;
+  std::vector< EllipsoidObjectRepresentation::Pointer >
+                                                     m_Representations;
+};
+
+} // end namespace PipelineBenchmark
+
+} // end namespace igstk
+
+
+int main( int argc, char * argv[] )
+{
+  namespace Benchmark = igstk::PipelineBenchmark;
+
+  double        minimumTime = 500.0;
+  std::string   csvFileName;
+  std::string   directory = ".";
+  bool          render = true;
+
+  for( int i = 1; i < argc; i++ )
+    {
+    if( !strcmp( argv[i], "-quick" ) )
+      {
+      minimumTime = 20.0;
+      }
+    else if( !strcmp( argv[i], "-time" ) && i + 1 < argc )
+      {
+      minimumTime = atof( argv[++i] );
+      }
+    else if( !strcmp( argv[i], "-csv" ) && i + 1 < argc )
+      {
+      csvFileName = argv[++i];
+      }
+    else if( !strcmp( argv[i], "-directory" ) && i + 1 < argc )
+      {
+      directory = argv[++i];
+      }
+    else if( !strcmp( argv[i], "-norender" ) )
+      {
+      render = false;
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0]
+                << " [-quick] [-time milliseconds] [-csv file]"
+                << " [-directory temporaryFilesDirectory] [-norender]"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  igstk::RealTimeClock::Initialize();
+
+  int status = EXIT_SUCCESS;
+
+  Benchmark::Reporter reporter;
+  reporter.PrintHeader();
+
+  {
+  Benchmark::StateMachineOperation operation;
+  reporter.Add( Benchmark::Measure( "StateMachineProcessInput", 0,
+                                    operation, minimumTime ) );
+  }
+
+  {
+  Benchmark::TransformComposeOperation operation;
+  reporter.Add( Benchmark::Measure( "TransformCompose", 0,
+                                    operation, minimumTime ) );
+  }
+
+  {
+  Benchmark::TransformBatchOperation operation( 1000 );
+  reporter.Add( Benchmark::Measure( "TransformBatchCompose", 1000,
+                                    operation, minimumTime ) );
+  }
+
+  const unsigned int depths[] = { 1, 4, 16, 64 };
+  for( unsigned int i = 0; i < sizeof( depths ) / sizeof( depths[0] ); i++ )
+    {
+    Benchmark::ComputeTransformToOperation operation( depths[i] );
+    reporter.Add( Benchmark::Measure( "ComputeTransformTo", depths[i],
+                                      operation, minimumTime ) );
+    if( !operation.GotTransform() )
+      {
+      std::cerr << "No transform through " << depths[i]
+                << " coordinate systems" << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+
+  const unsigned int numbersOfTools[] = { 1, 10, 100, 500 };
+  for( unsigned int i = 0;
+       i < sizeof( numbersOfTools ) / sizeof( numbersOfTools[0] ); i++ )
+    {
+    Benchmark::TrackerUpdateOperation operation( numbersOfTools[i] );
+    Benchmark::Result result = Benchmark::Measure( "TrackerUpdate",
+      numbersOfTools[i], operation, minimumTime );
+    reporter.Add( result );
+    if( operation.GetNumberOfUpdates() <= result.m_Iterations )
+      {
+      std::cerr << "The tracker with " << numbersOfTools[i]
+                << " tools was not updated" << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+
+  const unsigned int numbersOfHandles[] = { 1, 8, 24 };
+  for( unsigned int i = 0;
+       i < sizeof( numbersOfHandles ) / sizeof( numbersOfHandles[0] ); i++ )
+    {
+    std::ostringstream fileName;
+    fileName << directory << "/igstkPipelineBenchmarkTX"
+             << numbersOfHandles[i] << ".txt";
+    std::string command;
+    std::string reply;
+    if( !Benchmark::WriteTXSimulationFile( fileName.str(),
+                                           numbersOfHandles[i],
+                                           command, reply ) )
+      {
+      std::cerr << "Could not write " << fileName.str() << std::endl;
+      status = EXIT_FAILURE;
+      break;
+      }
+
+    {
+    Benchmark::NDIReplyParsingOperation operation( fileName.str() );
+    reporter.Add( Benchmark::Measure( "NDIReplyParsing",
+      numbersOfHandles[i], operation, minimumTime ) );
+    if( !operation.IsValid() )
+      {
+      std::cerr << "The TX reply with " << numbersOfHandles[i]
+                << " handles was not parsed" << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+
+    {
+    const unsigned int replySize =
+      static_cast< unsigned int >( reply.size() );
+    Benchmark::SerialSimulatorOperation operation( fileName.str(), command,
+                                                   replySize );
+    reporter.Add( Benchmark::Measure( "SerialSimulatorRead", replySize,
+                                      operation, minimumTime ) );
+    if( operation.m_BytesRead != replySize )
+      {
+      std::cerr << "The simulator replied " << operation.m_BytesRead
+                << " bytes instead of " << replySize << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+    }
+
+  if( render )
+    {
+    const unsigned int numbersOfObjects[] = { 1, 10, 100 };
+    for( unsigned int i = 0;
+         i < sizeof( numbersOfObjects ) / sizeof( numbersOfObjects[0] ); i++ )
+      {
+      Benchmark::ViewRefreshRenderOperation operation( numbersOfObjects[i] );
+      reporter.Add( Benchmark::Measure( "ViewRefreshRender",
+        numbersOfObjects[i], operation, minimumTime ) );
+      }
+    }
+
+  if( !csvFileName.empty() && !reporter.WriteCSV( csvFileName ) )
+    {
+    std::cerr << "Could not write " << csvFileName << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  return status;
+}
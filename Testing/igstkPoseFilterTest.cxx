@@ -0,0 +1,301 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkPoseFilterTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkOneEuroPoseFilter.h"
+#include "igstkKalmanPoseFilter.h"
+#include "igstkMedianPoseFilter.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+namespace PoseFilterTest
+{
+
+/** Deterministic noise, uniform in [-amplitude, amplitude] */
+class Noise
+{
+public:
+  Noise() : m_State( 12345 ) {}
+  double operator()( double amplitude )
+    {
+    m_State = m_State * 1103515245u + 12345u;
+    const double uniform = ( ( m_State >> 8 ) & 0xFFFF ) / 65535.0;
+    return amplitude * ( 2.0 * uniform - 1.0 );
+    }
+private:
+  unsigned int m_State;
+};
+
+/** Pose of the given translation, rotated by angle around Z */
+igstk::Pose MakePose( double x, double y, double z, double angle )
+{
+  igstk::Pose pose;
+  pose.m_Rotation[0] = 0.0;
+  pose.m_Rotation[1] = 0.0;
+  pose.m_Rotation[2] = std::sin( 0.5 * angle );
+  pose.m_Rotation[3] = std::cos( 0.5 * angle );
+  pose.m_Translation[0] = x;
+  pose.m_Translation[1] = y;
+  pose.m_Translation[2] = z;
+  return pose;
+}
+
+/** Distance between the translations of two poses */
+double Distance( const igstk::Pose & first, const igstk::Pose & second )
+{
+  double squaredDistance = 0.0;
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    const double difference =
+      first.m_Translation[k] - second.m_Translation[k];
+    squaredDistance += difference * difference;
+    }
+  return std::sqrt( squaredDistance );
+}
+
+/** Angle of the rotation between two poses */
+double Angle( const igstk::Pose & first, const igstk::Pose & second )
+{
+  const double * a = first.m_Rotation;
+  const double * b = second.m_Rotation;
+  const double x = a[3] * b[0] - a[0] * b[3] - a[1] * b[2] + a[2] * b[1];
+  const double y = a[3] * b[1] - a[1] * b[3] - a[2] * b[0] + a[0] * b[2];
+  const double z = a[3] * b[2] - a[2] * b[3] - a[0] * b[1] + a[1] * b[0];
+  const double w = a[3] * b[3] + a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  return 2.0 * std::atan2( std::sqrt( x * x + y * y + z * z ),
+                           std::fabs( w ) );
+}
+
+/** Check that a filter reduces the jitter of a tool at rest */
+bool TestJitter( igstk::PoseFilter * filter, const char * name )
+{
+  const igstk::Pose truth = MakePose( 10.0, 20.0, -30.0, 0.3 );
+  Noise noise;
+
+  double rawError = 0.0;
+  double rawAngle = 0.0;
+  double filteredError = 0.0;
+  double filteredAngle = 0.0;
+  for( unsigned int i = 0; i < 300; i++ )
+    {
+    igstk::Pose pose = truth;
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      pose.m_Translation[k] += noise( 0.5 );
+      }
+    igstk::Pose noisyRotation = MakePose( 0.0, 0.0, 0.0, noise( 0.005 ) );
+    const double w = noisyRotation.m_Rotation[3];
+    const double z = noisyRotation.m_Rotation[2];
+    pose.m_Rotation[2] = truth.m_Rotation[2] * w + truth.m_Rotation[3] * z;
+    pose.m_Rotation[3] = truth.m_Rotation[3] * w - truth.m_Rotation[2] * z;
+
+    const igstk::Pose measured = pose;
+    filter->FilterPose( pose, 1000.0 + i * 1000.0 / 60.0 );
+
+    // After the filters settled
+    if( i >= 100 )
+      {
+      rawError += Distance( measured, truth );
+      rawAngle += Angle( measured, truth );
+      filteredError += Distance( pose, truth );
+      filteredAngle += Angle( pose, truth );
+      }
+    }
+
+  std::cout << name << ": mean error " << rawError / 200.0 << " mm, "
+            << rawAngle / 200.0 << " rad measured, "
+            << filteredError / 200.0 << " mm, "
+            << filteredAngle / 200.0 << " rad filtered" << std::endl;
+
+  if( filteredError >= rawError || filteredAngle >= rawAngle )
+    {
+    std::cerr << name << " does not reduce the jitter" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int igstkPoseFilterTest( int, char * [] )
+{
+  typedef igstk::OneEuroPoseFilter   OneEuroFilterType;
+  typedef igstk::KalmanPoseFilter    KalmanFilterType;
+  typedef igstk::MedianPoseFilter    MedianFilterType;
+
+  OneEuroFilterType::Pointer oneEuroFilter = OneEuroFilterType::New();
+  KalmanFilterType::Pointer kalmanFilter = KalmanFilterType::New();
+  MedianFilterType::Pointer medianFilter = MedianFilterType::New();
+
+  oneEuroFilter->Print( std::cout );
+  kalmanFilter->Print( std::cout );
+  medianFilter->Print( std::cout );
+
+  // Jitter of a tool at rest
+  if( !PoseFilterTest::TestJitter( oneEuroFilter, "OneEuroPoseFilter" ) ||
+      !PoseFilterTest::TestJitter( kalmanFilter, "KalmanPoseFilter" ) ||
+      !PoseFilterTest::TestJitter( medianFilter, "MedianPoseFilter" ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The first pose after a reset is output as it is
+  oneEuroFilter->Reset();
+  igstk::Pose pose = PoseFilterTest::MakePose( 1.0, 2.0, 3.0, 0.1 );
+  const igstk::Pose start = pose;
+  oneEuroFilter->FilterPose( pose, 0.0 );
+  if( PoseFilterTest::Distance( pose, start ) != 0.0 ||
+      PoseFilterTest::Angle( pose, start ) != 0.0 )
+    {
+    std::cerr << "The first pose after a reset was modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Jumps are rejected, until the tool stays away
+  oneEuroFilter->SetMaximumTranslationJump( 5.0 );
+  oneEuroFilter->SetMaximumRotationJump( 0.2 );
+  oneEuroFilter->SetMaximumNumberOfRejectedPoses( 3 );
+  for( unsigned int i = 1; i < 10; i++ )
+    {
+    pose = start;
+    oneEuroFilter->FilterPose( pose, i * 10.0 );
+    }
+
+  pose = PoseFilterTest::MakePose( 1.0, 2.0, 3.0, 0.6 );
+  if( oneEuroFilter->FilterPose( pose, 100.0 ) ||
+      PoseFilterTest::Angle( pose, start ) > 1e-9 )
+    {
+    std::cerr << "A rotation jump was not rejected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const igstk::Pose moved = PoseFilterTest::MakePose( 50.0, 2.0, 3.0, 0.1 );
+  for( unsigned int i = 0; i < 2; i++ )
+    {
+    pose = moved;
+    if( oneEuroFilter->FilterPose( pose, 110.0 + i * 10.0 ) ||
+        PoseFilterTest::Distance( pose, start ) > 1e-9 )
+      {
+      std::cerr << "A translation jump was not rejected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  pose = moved;
+  if( !oneEuroFilter->FilterPose( pose, 130.0 ) ||
+      PoseFilterTest::Distance( pose, moved ) != 0.0 )
+    {
+    std::cerr << "The filter did not restart from the new pose" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( oneEuroFilter->GetNumberOfRejectedPoses() != 3 )
+    {
+    std::cerr << "Wrong number of rejected poses: "
+              << oneEuroFilter->GetNumberOfRejectedPoses() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The median discards an isolated outlier
+  medianFilter->SetWindowSize( 100 );
+  if( medianFilter->GetWindowSize() != MedianFilterType::MaximumWindowSize )
+    {
+    std::cerr << "The window size was not limited" << std::endl;
+    return EXIT_FAILURE;
+    }
+  medianFilter->SetWindowSize( 5 );
+  medianFilter->Reset();
+  for( unsigned int i = 0; i < 8; i++ )
+    {
+    pose = ( i == 5 ) ? PoseFilterTest::MakePose( 80.0, 2.0, 3.0, 1.5 )
+                      : start;
+    medianFilter->FilterPose( pose, i * 10.0 );
+    if( PoseFilterTest::Distance( pose, start ) != 0.0 ||
+        PoseFilterTest::Angle( pose, start ) != 0.0 )
+      {
+      std::cerr << "The median did not discard an outlier" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Resizing the window keeps the last poses: the median is then the one
+  // of the poses received since the reset, up to the window size
+  medianFilter->SetWindowSize( 3 );
+  medianFilter->Reset();
+  unsigned int windowSize = 3;
+  unsigned int numberOfPoses = 0;
+  double positions[20];
+  for( unsigned int i = 0; i < 20; i++ )
+    {
+    if( i == 8 || i == 16 )
+      {
+      // Grow the window after the circular buffer wrapped, then shrink it
+      windowSize = ( i == 8 ) ? 7 : 3;
+      medianFilter->SetWindowSize( windowSize );
+      numberOfPoses = std::min( numberOfPoses, windowSize );
+      }
+    numberOfPoses = std::min( numberOfPoses + 1, windowSize );
+
+    positions[i] = ( i * 7 ) % 11;
+    pose = PoseFilterTest::MakePose( positions[i], 2.0, 3.0, 0.1 );
+    medianFilter->FilterPose( pose, 200.0 + i * 10.0 );
+
+    double window[20];
+    std::copy( positions + i + 1 - numberOfPoses, positions + i + 1,
+               window );
+    std::sort( window, window + numberOfPoses );
+    const double expected = 0.5 * ( window[ ( numberOfPoses - 1 ) / 2 ] +
+                                    window[ numberOfPoses / 2 ] );
+    if( std::fabs( pose.m_Translation[0] - expected ) > 1e-9 ||
+        PoseFilterTest::Angle( pose, start ) > 1e-9 )
+      {
+      std::cerr << "Wrong median after resizing the window, pose " << i
+                << ": " << pose.m_Translation[0] << " instead of "
+                << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The Kalman filter follows a tool moving at constant velocity
+  kalmanFilter->Reset();
+  for( unsigned int i = 0; i <= 200; i++ )
+    {
+    const double time = i * 10.0;
+    const igstk::Pose expected = PoseFilterTest::MakePose(
+      0.1 * time, 2.0, 3.0, 0.0005 * time );
+    pose = expected;
+    kalmanFilter->FilterPose( pose, time );
+    if( i == 200 &&
+        ( PoseFilterTest::Distance( pose, expected ) > 0.01 ||
+          PoseFilterTest::Angle( pose, expected ) > 1e-4 ) )
+      {
+      std::cerr << "The Kalman filter lags behind the tool: "
+                << PoseFilterTest::Distance( pose, expected ) << " mm, "
+                << PoseFilterTest::Angle( pose, expected ) << " rad"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
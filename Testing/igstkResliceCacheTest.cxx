@@ -0,0 +1,306 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkResliceCacheTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkResliceCache.h"
+
+#include <vtkImageData.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkMatrix4x4.h>
+#include <vtkCellType.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+int igstkResliceCacheTest( int , char* [] )
+{
+  typedef igstk::ResliceCache   CacheType;
+
+  // Image whose voxels hold their slice number
+  vtkImageData * image = vtkImageData::New();
+  image->SetDimensions( 10, 10, 10 );
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents( 1 );
+  image->AllocateScalars();
+
+  short * voxel = static_cast< short * >( image->GetScalarPointer() );
+  for( int z = 0; z < 10; z++ )
+    {
+    for( int i = 0; i < 100; i++ )
+      {
+      *voxel++ = static_cast< short >( z );
+      }
+    }
+
+  const double axialCenter[3] = { 4.5, 4.5, 3.0 };
+  const double axialNormal[3] = { 0.0, 0.0, 1.0 };
+  const double obliqueNormal[3] = { 0.0, 0.6, 0.8 };
+
+  vtkMatrix4x4 * sliceAxes = vtkMatrix4x4::New();
+
+  // The representations are told apart by their address
+  int client1 = 0;
+  int client2 = 0;
+  int client3 = 0;
+
+  // Nothing is computed for an image without subscriber
+  if( CacheType::GetSlice( image, axialCenter, axialNormal, 0, sliceAxes,
+                           &client1 ) )
+    {
+    std::cerr << "Slice of an image without subscriber" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Two representations of the same image on the same plane
+  CacheType::Subscribe( image );
+  CacheType::Subscribe( image );
+
+  const unsigned long computations = CacheType::GetNumberOfComputations();
+
+  vtkImageData * slice1 = CacheType::GetSlice( image, axialCenter,
+                                               axialNormal, 0, sliceAxes,
+                                               &client1 );
+  vtkImageData * slice2 = CacheType::GetSlice( image, axialCenter,
+                                               axialNormal, 0, sliceAxes,
+                                               &client2 );
+
+  if( !slice1 || slice1 != slice2 ||
+      CacheType::GetNumberOfComputations() != computations + 1 )
+    {
+    std::cerr << "The slice was not shared" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( slice1->GetScalarComponentAsDouble( 0, 0, 0, 0 ) != 3.0 ||
+      sliceAxes->GetElement( 2, 3 ) != 3.0 ||
+      sliceAxes->GetElement( 2, 2 ) != 1.0 )
+    {
+    std::cerr << "Wrong axial slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Another plane is computed separately, and the first one is kept
+  vtkImageData * obliqueSlice = CacheType::GetSlice( image, axialCenter,
+                                                     obliqueNormal, 1,
+                                                     sliceAxes, &client2 );
+  if( !obliqueSlice || obliqueSlice == slice1 ||
+      CacheType::GetNumberOfComputations() != computations + 2 ||
+      CacheType::GetSlice( image, axialCenter, axialNormal, 0, sliceAxes,
+                           &client1 ) != slice1 ||
+      CacheType::GetNumberOfComputations() != computations + 2 )
+    {
+    std::cerr << "Planes were not cached separately" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A new version of the image is resliced again
+  image->Modified();
+  CacheType::GetSlice( image, axialCenter, axialNormal, 0, sliceAxes,
+                       &client1 );
+  if( CacheType::GetNumberOfComputations() != computations + 3 )
+    {
+    std::cerr << "The modified image was not resliced" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // With room for two planes, the slice displayed by the first client is
+  // kept while the second one moves through the image, and the cache grows
+  // when a third client displays yet another plane
+  CacheType::SetNumberOfPlanesPerInput( 2 );
+  CacheType::Subscribe( image );
+
+  vtkImageData * movingSlice = NULL;
+  for( unsigned int z = 5; z < 8; z++ )
+    {
+    const double movingCenter[3] = { 4.5, 4.5, static_cast< double >( z ) };
+    movingSlice = CacheType::GetSlice( image, movingCenter, axialNormal, 0,
+                                       sliceAxes, &client2 );
+    if( !movingSlice || movingSlice == slice1 ||
+        movingSlice->GetScalarComponentAsDouble( 0, 0, 0, 0 ) != z )
+      {
+      std::cerr << "Wrong slice " << z << " of the second client"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  const double thirdCenter[3] = { 4.5, 4.5, 8.0 };
+  vtkImageData * thirdSlice = CacheType::GetSlice( image, thirdCenter,
+                                                   axialNormal, 0, sliceAxes,
+                                                   &client3 );
+  if( !thirdSlice || thirdSlice == slice1 || thirdSlice == movingSlice ||
+      movingSlice->GetScalarComponentAsDouble( 0, 0, 0, 0 ) != 7.0 ||
+      slice1->GetScalarComponentAsDouble( 0, 0, 0, 0 ) != 3.0 ||
+      CacheType::GetSlice( image, axialCenter, axialNormal, 0, sliceAxes,
+                           &client1 ) != slice1 ||
+      CacheType::GetNumberOfComputations() != computations + 7 )
+    {
+    std::cerr << "A displayed slice was recycled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  CacheType::Unsubscribe( image, &client3 );
+  CacheType::SetNumberOfPlanesPerInput( 8 );
+
+  // Cut of a tetrahedron shared by two representations: the edges of a
+  // triangle
+  vtkPoints * points = vtkPoints::New();
+  points->InsertNextPoint( 0.0, 0.0, 0.0 );
+  points->InsertNextPoint( 1.0, 0.0, 0.0 );
+  points->InsertNextPoint( 0.0, 1.0, 0.0 );
+  points->InsertNextPoint( 0.0, 0.0, 1.0 );
+
+  vtkUnstructuredGrid * mesh = vtkUnstructuredGrid::New();
+  mesh->SetPoints( points );
+  vtkIdType ids[4] = { 0, 1, 2, 3 };
+  mesh->InsertNextCell( VTK_TETRA, 4, ids );
+  points->Delete();
+
+  const double cutCenter[3] = { 0.0, 0.0, 0.25 };
+
+  CacheType::Subscribe( mesh );
+  CacheType::Subscribe( mesh );
+
+  vtkPolyData * cut1 =
+    CacheType::GetCut( mesh, cutCenter, axialNormal, &client1 );
+  vtkPolyData * cut2 =
+    CacheType::GetCut( mesh, cutCenter, axialNormal, &client2 );
+
+  if( !cut1 || cut1 != cut2 || cut1->GetNumberOfLines() != 3 ||
+      CacheType::GetNumberOfComputations() != computations + 8 )
+    {
+    std::cerr << "The cut was not shared" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Moving through more planes than are kept recycles the cuts, while the
+  // number of segments changes with the plane: the triangle cut below the
+  // apex, the quadrilateral cut between two pairs of vertices, and nothing
+  // beyond the apex
+  const double slantedNormal[3] = { 1.0, 1.0, 0.0 };
+  for( unsigned int plane = 0; plane < 12; plane++ )
+    {
+    double center[3] = { 0.0, 0.0, 0.0 };
+    const double * normal = axialNormal;
+    int numberOfLines = 0;
+    switch( plane % 3 )
+      {
+      case 0:
+        center[2] = 0.12 + 0.05 * plane;
+        numberOfLines = 3;
+        break;
+      case 1:
+        center[0] = 0.25 + 0.01 * plane;
+        center[1] = 0.25;
+        normal = slantedNormal;
+        numberOfLines = 4;
+        break;
+      default:
+        center[2] = 1.5 + plane;
+        break;
+      }
+
+    vtkPolyData * cut = CacheType::GetCut( mesh, center, normal, &client1 );
+    if( !cut || cut == cut2 ||
+        cut->GetNumberOfLines() != numberOfLines ||
+        cut->GetNumberOfPoints() != 2 * numberOfLines )
+      {
+      std::cerr << "Wrong cut by plane " << plane << ": "
+                << ( cut ? cut->GetNumberOfLines() : -1 ) << " lines instead"
+                << " of " << numberOfLines << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The cut of a modified mesh is recomputed in place: lowering the apex
+  // below the plane empties it
+  mesh->GetPoints()->SetPoint( 3, 0.0, 0.0, 0.2 );
+  mesh->GetPoints()->Modified();
+  mesh->Modified();
+  if( CacheType::GetCut( mesh, cutCenter, axialNormal, &client2 ) != cut2 ||
+      cut2->GetNumberOfLines() != 0 )
+    {
+    std::cerr << "The cut of the modified mesh was not updated"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A line through the plane is cut to a vertex, as by vtkCutter
+  const vtkIdType top = mesh->GetPoints()->InsertNextPoint( 0.5, 0.5, 1.0 );
+  vtkIdType lineIds[2] = { 0, top };
+  mesh->InsertNextCell( VTK_LINE, 2, lineIds );
+  mesh->GetPoints()->Modified();
+  mesh->Modified();
+
+  double vertex[3] = { 0.0, 0.0, 0.0 };
+  if( CacheType::GetCut( mesh, cutCenter, axialNormal, &client2 ) != cut2 ||
+      cut2->GetNumberOfLines() != 0 || cut2->GetNumberOfVerts() != 1 ||
+      cut2->GetNumberOfPoints() != 1 )
+    {
+    std::cerr << "The line was not cut to a vertex" << std::endl;
+    return EXIT_FAILURE;
+    }
+  cut2->GetPoint( 0, vertex );
+  if( fabs( vertex[0] - 0.125 ) > 1e-9 || fabs( vertex[1] - 0.125 ) > 1e-9 ||
+      fabs( vertex[2] - 0.25 ) > 1e-9 )
+    {
+    std::cerr << "Wrong vertex of the line" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( CacheType::GetNumberOfInputs() != 2 )
+    {
+    std::cerr << "Wrong number of inputs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The outputs are released with the last subscriber
+  CacheType::Unsubscribe( image, &client2 );
+  CacheType::Unsubscribe( mesh, &client2 );
+  if( CacheType::GetNumberOfInputs() != 2 )
+    {
+    std::cerr << "Outputs released while subscribed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  CacheType::Unsubscribe( image, &client1 );
+  CacheType::Unsubscribe( mesh, &client1 );
+  if( CacheType::GetNumberOfInputs() != 0 ||
+      CacheType::GetCut( mesh, cutCenter, axialNormal, &client1 ) )
+    {
+    std::cerr << "Outputs not released" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Requests: " << CacheType::GetNumberOfRequests()
+            << " Computations: " << CacheType::GetNumberOfComputations()
+            << std::endl;
+
+  sliceAxes->Delete();
+  mesh->Delete();
+  image->Delete();
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
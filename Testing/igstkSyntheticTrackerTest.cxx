@@ -0,0 +1,322 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkSyntheticTrackerTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkSyntheticTracker.h"
+#include "igstkSimulatedTrackerTool.h"
+#include "igstkDeviceTelemetry.h"
+#include "igstkPulseGenerator.h"
+#include "igstkRealTimeClock.h"
+#include "igstkTransformObserver.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+namespace SyntheticTrackerTest
+{
+
+bool SamePose( const igstk::Pose & first, const igstk::Pose & second,
+               double tolerance )
+{
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    if( std::fabs( first.m_Translation[k] - second.m_Translation[k] ) >
+        tolerance )
+      {
+      return false;
+      }
+    }
+  // The versors q and -q are the same rotation
+  bool sameRotation = true;
+  bool oppositeRotation = true;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    if( std::fabs( first.m_Rotation[k] - second.m_Rotation[k] ) >
+        tolerance )
+      {
+      sameRotation = false;
+      }
+    if( std::fabs( first.m_Rotation[k] + second.m_Rotation[k] ) >
+        tolerance )
+      {
+      oppositeRotation = false;
+      }
+    }
+  return sameRotation || oppositeRotation;
+}
+
+}
+
+int igstkSyntheticTrackerTest( int, char * [] )
+{
+  igstk::RealTimeClock::Initialize();
+
+  typedef igstk::SyntheticTracker          TrackerType;
+  typedef igstk::SimulatedTrackerTool      ToolType;
+  typedef igstk::DeviceTelemetryReport     ReportType;
+
+  TrackerType::Pointer tracker = TrackerType::New();
+  TrackerType::Pointer other = TrackerType::New();
+
+  // The samples only depend on the seed, the tool and the sample index
+  tracker->SetTranslationNoise( 0.5 );
+  tracker->SetRotationNoise( 0.01 );
+  tracker->SetSeed( 7 );
+  other->SetTranslationNoise( 0.5 );
+  other->SetRotationNoise( 0.01 );
+  other->SetSeed( 7 );
+  for( unsigned long i = 0; i < 1000; i += 37 )
+    {
+    igstk::Pose first;
+    igstk::Pose second;
+    tracker->ComputeToolPose( "tool", i, first );
+    other->ComputeToolPose( "tool", i, second );
+    if( !SyntheticTrackerTest::SamePose( first, second, 0.0 ) )
+      {
+      std::cerr << "The samples are not deterministic" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  other->SetSeed( 8 );
+  igstk::Pose first;
+  igstk::Pose second;
+  tracker->ComputeToolPose( "tool", 10, first );
+  other->ComputeToolPose( "tool", 10, second );
+  if( SyntheticTrackerTest::SamePose( first, second, 1e-6 ) )
+    {
+    std::cerr << "The seed does not change the noise" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The noise has the requested standard deviation
+  other->SetTranslationNoise( 0.0 );
+  other->SetRotationNoise( 0.0 );
+  double sumOfSquares = 0.0;
+  const unsigned long numberOfSamples = 20000;
+  for( unsigned long i = 0; i < numberOfSamples; i++ )
+    {
+    tracker->ComputeToolPose( "tool", i, first );
+    other->ComputeToolPose( "tool", i, second );
+    const double difference =
+      first.m_Translation[0] - second.m_Translation[0];
+    sumOfSquares += difference * difference;
+    }
+  const double deviation = std::sqrt( sumOfSquares / numberOfSamples );
+  if( std::fabs( deviation - 0.5 ) > 0.02 )
+    {
+    std::cerr << "Wrong noise: " << deviation << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The dropouts come in blocks and have the requested rate
+  tracker->SetDropoutRate( 0.2 );
+  tracker->SetDropoutLength( 10 );
+  unsigned long numberOfDropouts = 0;
+  for( unsigned long i = 0; i < 100000; i++ )
+    {
+    const bool visible = tracker->ComputeToolPose( "tool", i, first );
+    if( i % 10 != 0 &&
+        visible != tracker->ComputeToolPose( "tool", i - 1, second ) )
+      {
+      std::cerr << "A dropout is shorter than its length" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( !visible )
+      {
+      numberOfDropouts++;
+      }
+    }
+  if( std::fabs( numberOfDropouts / 100000.0 - 0.2 ) > 0.02 )
+    {
+    std::cerr << "Wrong dropout rate: " << numberOfDropouts / 100000.0
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Recorded trajectory, played in a loop and interpolated
+  std::istringstream recording(
+    "# time x y z qx qy qz qw\n"
+    "0 0 0 0 0 0 0 1\n"
+    "\n"
+    "100 10 20 30 0 0 0.7071067811865476 0.7071067811865476\n"
+    "200 0 0 0 0 0 0 1\n" );
+  std::vector< TrackerType::TimePeriodType > times;
+  std::vector< igstk::Pose > poses;
+  if( !TrackerType::ReadRecordedTrajectory( recording, times, poses ) ||
+      poses.size() != 3 )
+    {
+    std::cerr << "The recorded trajectory was not read" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::istringstream malformed( "0 1 2 three\n" );
+  if( TrackerType::ReadRecordedTrajectory( malformed, times, poses ) )
+    {
+    std::cerr << "A malformed trajectory was read" << std::endl;
+    return EXIT_FAILURE;
+    }
+  recording.clear();
+  recording.seekg( 0 );
+  TrackerType::ReadRecordedTrajectory( recording, times, poses );
+
+  other->SetSampleRate( 1000.0 );
+  other->SetToolRecordedTrajectory( "recorded", times, poses );
+
+  // Half way to the second pose, a rotation of 45 degrees around Z
+  igstk::Pose expected;
+  expected.m_Translation[0] = 5.0;
+  expected.m_Translation[1] = 10.0;
+  expected.m_Translation[2] = 15.0;
+  expected.m_Rotation[0] = 0.0;
+  expected.m_Rotation[1] = 0.0;
+  expected.m_Rotation[2] = std::sin( 3.141592653589793 / 8.0 );
+  expected.m_Rotation[3] = std::cos( 3.141592653589793 / 8.0 );
+  igstk::Pose pose;
+  if( !other->ComputeToolPose( "recorded", 50, pose ) ||
+      !SyntheticTrackerTest::SamePose( pose, expected, 1e-9 ) ||
+      !other->ComputeToolPose( "recorded", 250, pose ) ||
+      !SyntheticTrackerTest::SamePose( pose, expected, 1e-9 ) )
+    {
+    std::cerr << "Wrong pose on the recorded trajectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The latency delays the trajectory
+  other->SetLatency( 10.0 );
+  if( !other->ComputeToolPose( "recorded", 60, pose ) ||
+      !SyntheticTrackerTest::SamePose( pose, expected, 1e-9 ) )
+    {
+    std::cerr << "Wrong pose with latency" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Many tools sampled at 1 kHz through the tracking thread, updated at
+  // 100 Hz
+  tracker->SetDropoutRate( 0.0 );
+  tracker->SetSampleRate( 1000.0 );
+  tracker->RequestOpen();
+  tracker->RequestSetFrequency( 100.0 );
+
+  const unsigned int numberOfTools = 50;
+  std::vector< ToolType::Pointer > tools;
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    ToolType::Pointer tool = ToolType::New();
+    std::ostringstream identifier;
+    identifier << "tool" << i;
+    tool->RequestSetName( identifier.str() );
+    tool->RequestConfigure();
+    tool->RequestAttachToTracker( tracker );
+    tools.push_back( tool );
+    }
+  tracker->SetToolRecordedTrajectory( "tool0", times, poses );
+
+  tracker->RequestStartTracking();
+  const double start = igstk::RealTimeClock::GetTimeStamp();
+  while( igstk::RealTimeClock::GetTimeStamp() - start < 300.0 )
+    {
+    igstk::PulseGenerator::WaitForPulses( 10.0 );
+    }
+  tracker->RequestStopTracking();
+
+  ReportType report;
+  tracker->GetTelemetry()->GetReport( report );
+  std::cout << report;
+
+  if( tracker->GetNumberOfSamples() < 200 ||
+      report.m_NumberOfUpdates == 0 ||
+      report.m_NumberOfDeviceSamples <= report.m_NumberOfUpdates )
+    {
+    std::cerr << "The tracker was not sampled faster than updated: "
+              << tracker->GetNumberOfSamples() << " samples, "
+              << report.m_NumberOfDeviceSamples << " read, "
+              << report.m_NumberOfUpdates << " updates" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( report.m_ToolIdentifiers.size() != numberOfTools )
+    {
+    std::cerr << "Wrong number of tools in the telemetry" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( unsigned int i = 0; i < numberOfTools; i++ )
+    {
+    if( report.m_ToolVisibilityRatios[i] != 1.0 )
+      {
+      std::cerr << "The tool " << report.m_ToolIdentifiers[i]
+                << " was not always visible" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The last transform of a tool to the tracker, with the identity
+  // calibration, is one of its samples
+  igstk::TransformObserver::Pointer transformObserver =
+    igstk::TransformObserver::New();
+  transformObserver->ObserveTransformEventsFrom( tools[0] );
+  tools[0]->RequestGetTransformToParent();
+  if( !transformObserver->GotTransform() )
+    {
+    std::cerr << "No transform of the tool to the tracker" << std::endl;
+    return EXIT_FAILURE;
+    }
+  igstk::Pose rawPose;
+  igstk::TransformBatch::ExportPose( transformObserver->GetTransform(),
+                                     rawPose );
+  bool found = false;
+  const unsigned long lastSample = tracker->GetNumberOfSamples();
+  for( unsigned long i = 0; i < lastSample && !found; i++ )
+    {
+    tracker->ComputeToolPose( "tool0", i, pose );
+    found = SyntheticTrackerTest::SamePose( pose, rawPose, 1e-6 );
+    }
+  if( !found )
+    {
+    std::cerr << "The transform is not a sample of the tool"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removing a tool moves the last one to its place
+  tools[3]->RequestDetachFromTracker();
+  tracker->RequestStartTracking();
+  const double restart = igstk::RealTimeClock::GetTimeStamp();
+  while( igstk::RealTimeClock::GetTimeStamp() - restart < 100.0 )
+    {
+    igstk::PulseGenerator::WaitForPulses( 10.0 );
+    }
+  tracker->RequestStopTracking();
+  tracker->GetTelemetry()->GetReport( report );
+  if( report.m_ToolIdentifiers.size() != numberOfTools - 1 ||
+      report.m_NumberOfUpdates == 0 )
+    {
+    std::cerr << "Wrong telemetry after removing a tool" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  tracker->RequestClose();
+
+  std::cout << tracker << std::endl;
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -43,6 +43,14 @@ void RegisterTests()
   REGISTER_TEST(igstkLandmark3DRegistrationErrorEstimatorTest);
   REGISTER_TEST(igstkMRImageSpatialObjectRepresentationTest);
   REGISTER_TEST(igstkMRImageSpatialObjectTest);
+  REGISTER_TEST(igstkImageSliceColorMapperTest);
+  REGISTER_TEST(igstkMemoryMappedImageContainerTest);
+  REGISTER_TEST(igstkResliceCacheTest);
+  REGISTER_TEST(igstkMeshSlicerTest);
+  REGISTER_TEST(igstkTimeoutSchedulerTest);
+  REGISTER_TEST(igstkEventLoopTest);
+  REGISTER_TEST(igstkObjectTest);
+  REGISTER_TEST(igstkEventQueueTest);
   REGISTER_TEST(igstkMultipleOutputTest);  
 
   REGISTER_TEST(igstkObjectRepresentationRemovalTest);
@@ -58,6 +66,10 @@ void RegisterTests()
   REGISTER_TEST(igstkTrackerTest);
   REGISTER_TEST(igstkTrackerToolTest);
   REGISTER_TEST(igstkTransformTest);  
+  REGISTER_TEST(igstkTransformBatchTest);
+  REGISTER_TEST(igstkPoseFilterTest);
+  REGISTER_TEST(igstkDeviceTelemetryTest);
+  REGISTER_TEST(igstkSyntheticTrackerTest);
   REGISTER_TEST(igstkVTKLoggerOutputTest);
 
   REGISTER_TEST(igstkTrackerToolReferenceTest);
@@ -138,7 +150,9 @@ void RegisterTests()
   REGISTER_TEST(igstkAuroraTrackerSimulatedTest);
   REGISTER_TEST(igstkCTImageReaderTest);
   REGISTER_TEST(igstkCTImageSpatialObjectRepresentationTest);
+  REGISTER_TEST(igstkDICOMImageReaderCacheTest);
   REGISTER_TEST(igstkDICOMImageReaderErrorsTest);
+  REGISTER_TEST(igstkDICOMImageReaderProgressiveTest);
   REGISTER_TEST(igstkDICOMImageReaderTest);
   REGISTER_TEST(igstkMeshReaderTest);
   REGISTER_TEST(igstkMRImageReaderTest);
@@ -176,9 +190,12 @@ void RegisterTests()
   REGISTER_TEST(igstkMeshObjectTest2);
   REGISTER_TEST(igstkPulseGeneratorTest);
   REGISTER_TEST(igstkTubeObjectTest);
+  REGISTER_TEST(igstkVesselTreeObjectRepresentationTest);
   REGISTER_TEST(igstkMouseTrackerTest);
   REGISTER_TEST(igstkViewTest);
   REGISTER_TEST(igstkViewRefreshRateTest);
+  REGISTER_TEST(igstkViewRefreshModeTest);
+  REGISTER_TEST(igstkOffScreenWidgetTest);
   REGISTER_TEST(igstkUltrasoundProbeObjectTest);
   REGISTER_TEST(igstkSpatialObjectRepresentationVisibilityTest);
   REGISTER_TEST(igstkFLTKWidgetTest);
@@ -225,6 +242,7 @@ void RegisterTests()
 
 #ifdef IGSTK_USE_OpenIGTLink
   REGISTER_TEST( igstkTrackerToolObserverToOpenIGTLinkRelayTest );
+  REGISTER_TEST( igstkTrackerObserverToOpenIGTLinkBroadcasterTest );
   REGISTER_TEST( igstkAuroraTrackerToolObserverToOpenIGTLinkRelayTest );
 #ifdef IGSTK_TEST_MicronTracker_ATTACHED
   REGISTER_TEST( igstkMicronTrackerToolObserverToOpenIGTLinkRelayTest );
@@ -237,6 +255,9 @@ void RegisterTests()
   REGISTER_TEST( igstkFrameTest );
   REGISTER_TEST( igstkVideoFrameSpatialObjectTest );
   REGISTER_TEST( igstkVideoFrameRepresentationTest );
+#ifdef IGSTK_USE_OpenIGTLink
+  REGISTER_TEST( igstkOpenIGTLinkVideoImagerTest );
+#endif
 #endif
   
 }
@@ -0,0 +1,170 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTimeoutSchedulerTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkTimeoutScheduler.h"
+#include "igstkRealTimeClock.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+namespace TimeoutSchedulerTest
+{
+
+typedef igstk::TimeoutScheduler   SchedulerType;
+
+/** Records the order of the calls */
+struct Recorder
+{
+  std::vector< int >    m_Calls;
+  SchedulerType *       m_Scheduler;
+};
+
+struct Caller
+{
+  int         m_Id;
+  Recorder *  m_Recorder;
+};
+
+void Record( void * data )
+{
+  Caller * caller = static_cast< Caller * >( data );
+  caller->m_Recorder->m_Calls.push_back( caller->m_Id );
+}
+
+/** Reschedules itself, and tries to invoke the scheduler again */
+void Repeat( void * data )
+{
+  Caller * caller = static_cast< Caller * >( data );
+  caller->m_Recorder->m_Calls.push_back( caller->m_Id );
+  caller->m_Recorder->m_Scheduler->AddTimeout( 0.0, Repeat, data );
+  if( caller->m_Recorder->m_Scheduler->InvokeTimeouts( 1e9 ) != 0 )
+    {
+    caller->m_Recorder->m_Calls.push_back( -1 );
+    }
+}
+
+}
+
+int igstkTimeoutSchedulerTest( int , char* [] )
+{
+  typedef TimeoutSchedulerTest::SchedulerType  SchedulerType;
+  typedef TimeoutSchedulerTest::Caller         CallerType;
+
+  igstk::RealTimeClock::Initialize();
+
+  SchedulerType scheduler;
+  TimeoutSchedulerTest::Recorder recorder;
+  recorder.m_Scheduler = &scheduler;
+
+  // Timeouts are invoked in order of deadline
+  const unsigned int numberOfCallers = 100;
+  std::vector< CallerType > callers( numberOfCallers );
+  for( unsigned int i = 0; i < numberOfCallers; i++ )
+    {
+    callers[i].m_Id = ( i * 37 ) % numberOfCallers;
+    callers[i].m_Recorder = &recorder;
+    scheduler.AddTimeout( 1000.0 + callers[i].m_Id,
+                          TimeoutSchedulerTest::Record, &callers[i] );
+    }
+
+  if( scheduler.GetNumberOfTimeouts() != numberOfCallers ||
+      scheduler.GetNextDeadline() != 1000.0 ||
+      scheduler.GetTimeToNextTimeout( 990.0 ) != 10.0 )
+    {
+    std::cerr << "Wrong next deadline" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Remove the timeouts of the odd callers
+  for( unsigned int i = 0; i < numberOfCallers; i++ )
+    {
+    if( callers[i].m_Id % 2 )
+      {
+      scheduler.RemoveTimeout( TimeoutSchedulerTest::Record, &callers[i] );
+      }
+    }
+
+  if( scheduler.InvokeTimeouts( 999.0 ) != 0 ||
+      scheduler.InvokeTimeouts( 1049.5 ) != 25 ||
+      scheduler.InvokeTimeouts( 2000.0 ) != 25 )
+    {
+    std::cerr << "Wrong number of invocations" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for( unsigned int i = 0; i < recorder.m_Calls.size(); i++ )
+    {
+    if( recorder.m_Calls[i] != static_cast< int >( 2 * i ) )
+      {
+      std::cerr << "Timeouts invoked out of order" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if( scheduler.GetNumberOfTimeouts() != 0 ||
+      scheduler.GetTimeToNextTimeout( 0.0 ) >= 0.0 )
+    {
+    std::cerr << "Timeouts left after their invocation" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A timeout added by a handler waits for the next invocation, and the
+  // handlers cannot invoke the scheduler
+  recorder.m_Calls.clear();
+  CallerType repeater;
+  repeater.m_Id = 7;
+  repeater.m_Recorder = &recorder;
+  scheduler.AddTimeout( 0.0, TimeoutSchedulerTest::Repeat, &repeater );
+  scheduler.InvokeTimeouts( 1.0 );
+  scheduler.InvokeTimeouts( 1.0 );
+  if( recorder.m_Calls.size() != 2 || recorder.m_Calls[0] != 7 ||
+      scheduler.GetNumberOfTimeouts() != 1 )
+    {
+    std::cerr << "Wrong invocation of the handlers" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scheduler.RemoveTimeout( TimeoutSchedulerTest::Repeat, NULL );
+
+  // Waiting blocks until the next deadline, not until the maximum delay
+  CallerType waiter;
+  waiter.m_Id = 3;
+  waiter.m_Recorder = &recorder;
+  const double start = igstk::RealTimeClock::GetTimeStamp();
+  scheduler.AddTimeout( start + 20.0, TimeoutSchedulerTest::Record, &waiter );
+  scheduler.WaitForTimeouts( 5000.0 );
+  const double waited = igstk::RealTimeClock::GetTimeStamp() - start;
+
+  std::cout << "Waited " << waited << " ms for a 20 ms timeout, "
+            << "timer descriptor " << scheduler.GetFileDescriptor()
+            << std::endl;
+
+  if( waited < 19.0 || waited > 1000.0 ||
+      scheduler.InvokeTimeouts() != 1 )
+    {
+    std::cerr << "Wrong wait for the next timeout" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTrackerObserverToOpenIGTLinkBroadcasterTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters
+// in the debug information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include <iostream>
+#include <math.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "itkMultiThreader.h"
+#include "igstkRealTimeClock.h"
+#include "igstkCircularSimulatedTracker.h"
+#include "igstkSimulatedTrackerTool.h"
+#include "igstkTrackerObserverToOpenIGTLinkBroadcaster.h"
+
+#include "igtlOSUtil.h"
+#include "igtlMessageHeader.h"
+#include "igtlTrackingDataMessage.h"
+#include "igtlServerSocket.h"
+
+static ITK_THREAD_RETURN_TYPE BroadcastReceiverThreadFunction(void*);
+static ITK_THREAD_RETURN_TYPE BroadcasterThreadFunction(void*);
+
+static char **m_BroadcastArgv;
+
+/** Number of TDATA messages received that carried all the tools */
+static unsigned int m_CompleteBatches = 0;
+
+int igstkTrackerObserverToOpenIGTLinkBroadcasterTest( int argc, char * argv [] )
+{
+
+  if( argc < 5 )
+    {
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] <<
+    " hostname portnumber numberOfPulses trackerFrequency(Hz)" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  m_BroadcastArgv = argv;
+
+  igstk::RealTimeClock::Initialize();
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( 2 );
+
+  threader->SetMultipleMethod( 1, BroadcastReceiverThreadFunction, NULL );
+  threader->SetMultipleMethod( 0, BroadcasterThreadFunction, NULL );
+  threader->MultipleMethodExecute();
+
+  if( m_CompleteBatches == 0 )
+    {
+    std::cerr << "No TDATA message with all the tools was received"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << m_CompleteBatches << " complete batches received" << std::endl;
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+/** Thread function running the tracker and the broadcaster */
+ITK_THREAD_RETURN_TYPE BroadcasterThreadFunction(void* itkNotUsed(pInfo))
+{
+  typedef igstk::CircularSimulatedTracker                 TrackerType;
+  typedef igstk::SimulatedTrackerTool                     TrackerToolType;
+  typedef igstk::TrackerObserverToOpenIGTLinkBroadcaster  BroadcasterType;
+
+  TrackerType::Pointer      tracker      = TrackerType::New();
+  TrackerToolType::Pointer  trackerTool1 = TrackerToolType::New();
+  TrackerToolType::Pointer  trackerTool2 = TrackerToolType::New();
+  BroadcasterType::Pointer  broadcaster  = BroadcasterType::New();
+
+  // Give the receiver time to create the server socket
+  igstk::PulseGenerator::Sleep(500);
+
+  tracker->RequestOpen();
+  tracker->SetRadius( 10.0 );
+  tracker->SetAngularSpeed( 30.0 );
+  tracker->RequestSetFrequency( atof( m_BroadcastArgv[4] ) );
+
+  trackerTool1->RequestSetName("Tool_1");
+  trackerTool1->RequestConfigure();
+  trackerTool1->RequestAttachToTracker( tracker );
+
+  trackerTool2->RequestSetName("Tool_2");
+  trackerTool2->RequestConfigure();
+  trackerTool2->RequestAttachToTracker( tracker );
+
+  broadcaster->RequestSetTracker( tracker );
+  broadcaster->RequestAddTrackerTool( trackerTool1, "Tool_1" );
+  broadcaster->RequestAddTrackerTool( trackerTool2, "Tool_2" );
+  broadcaster->RequestAddSubscriber( m_BroadcastArgv[1],
+                                     atoi( m_BroadcastArgv[2] ) );
+  broadcaster->SetMaximumQueueSize( 4 );
+  broadcaster->SetDropPolicy( BroadcasterType::DropOldest );
+
+  broadcaster->RequestStart();
+
+  tracker->RequestStartTracking();
+
+  const unsigned int numberOfPulses = atoi( m_BroadcastArgv[3] );
+
+  for( unsigned int i = 0; i < numberOfPulses; i++ )
+    {
+    igstk::PulseGenerator::Sleep(10);
+    igstk::PulseGenerator::CheckTimeouts();
+    }
+
+  tracker->RequestStopTracking();
+  tracker->RequestReset();
+  tracker->RequestClose();
+
+  broadcaster->RequestStop();
+
+  std::cout << "Sent: " << broadcaster->GetNumberOfSentBatches()
+            << " Dropped: " << broadcaster->GetNumberOfDroppedBatches()
+            << std::endl;
+
+  //purely for code coverage.
+  broadcaster->Print( std::cout );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Thread function receiving the TDATA messages */
+ITK_THREAD_RETURN_TYPE BroadcastReceiverThreadFunction(void* itkNotUsed(pInfo))
+{
+  int port = atoi( m_BroadcastArgv[2] );
+
+  igtl::ServerSocket::Pointer serverSocket = igtl::ServerSocket::New();
+  serverSocket->CreateServer( port );
+
+  igtl::Socket::Pointer socket = serverSocket->WaitForConnection(10000);
+
+  if( socket.IsNull() )
+    {
+    std::cerr << "The broadcaster did not connect" << std::endl;
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  igtl::MessageHeader::Pointer headerMsg = igtl::MessageHeader::New();
+  igtl::TrackingDataMessage::Pointer trackingDataMsg =
+                                             igtl::TrackingDataMessage::New();
+
+  while( true )
+    {
+    headerMsg->InitPack();
+
+    int r = socket->Receive( headerMsg->GetPackPointer(),
+                             headerMsg->GetPackSize() );
+    if( r != headerMsg->GetPackSize() )
+      {
+      // The broadcaster closed the connection
+      break;
+      }
+
+    headerMsg->Unpack();
+
+    if( strcmp( headerMsg->GetDeviceType(), "TDATA" ) != 0 )
+      {
+      socket->Skip( headerMsg->GetBodySizeToRead(), 0 );
+      continue;
+      }
+
+    trackingDataMsg->SetMessageHeader( headerMsg );
+    trackingDataMsg->AllocatePack();
+
+    socket->Receive( trackingDataMsg->GetPackBodyPointer(),
+                     trackingDataMsg->GetPackBodySize() );
+
+    int c = trackingDataMsg->Unpack(1);
+
+    if( ( c & igtl::MessageHeader::UNPACK_BODY ) &&
+        trackingDataMsg->GetNumberOfTrackingDataElements() == 2 )
+      {
+      ++m_CompleteBatches;
+      }
+    }
+
+  socket->CloseSocket();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
@@ -23,6 +23,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 #include "igstkTracker.h"
 #include "igstkTrackerTool.h"
@@ -84,6 +86,12 @@ public:
    * the tracker tool to a tracker. */
   virtual void RequestAttachToTracker( DummyTracker * );
 
+  /** Tools attached with different identifiers are tracked together */
+  void SetIdentifier( const std::string & identifier )
+    {
+    this->SetTrackerToolIdentifier( identifier );
+    }
+
 protected:
   DummyTrackerTool():m_StateMachine(this)
     {
@@ -245,6 +253,170 @@ void DummyTrackerTool::RequestAttachToTracker( DummyTracker *  tracker )
 }
 
 
+/** Records the last calibrated transform reported by a tracker tool */
+class CalibratedTransformObserver : public ::itk::Command
+{
+public:
+  typedef  CalibratedTransformObserver  Self;
+  typedef  ::itk::Command               Superclass;
+  typedef  ::itk::SmartPointer<Self>    Pointer;
+  itkNewMacro( Self );
+
+  void Execute( itk::Object *caller, const itk::EventObject & event )
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+
+  void Execute( const itk::Object *itkNotUsed(caller),
+                const itk::EventObject & event )
+    {
+    const CoordinateSystemTransformToEvent * transformEvent =
+      dynamic_cast< const CoordinateSystemTransformToEvent * >( &event );
+    if( transformEvent )
+      {
+      m_Transform = transformEvent->Get().GetTransform();
+      m_NumberOfTransforms++;
+      }
+    }
+
+  const Transform & GetTransform() const
+    {
+    return m_Transform;
+    }
+
+  unsigned int GetNumberOfTransforms() const
+    {
+    return m_NumberOfTransforms;
+    }
+
+protected:
+  CalibratedTransformObserver()
+    {
+    m_NumberOfTransforms = 0;
+    }
+
+private:
+  Transform      m_Transform;
+  unsigned int   m_NumberOfTransforms;
+};
+
+/** Check that the calibrated transforms last reported by the tools are
+ *  their calibration transforms composed with the same raw transform,
+ *  which is a translation */
+bool CheckCalibratedTransforms(
+  const std::vector< DummyTrackerTool::Pointer > & tools,
+  const std::vector< CalibratedTransformObserver::Pointer > & observers )
+{
+  Transform::VectorType rawTranslation;
+  for( unsigned int i = 0; i < tools.size(); i++ )
+    {
+    const Transform & calibration = tools[i]->GetCalibrationTransform();
+    const Transform & calibrated = observers[i]->GetTransform();
+    if( observers[i]->GetNumberOfTransforms() == 0 )
+      {
+      std::cerr << "Tool " << i << " was not updated" << std::endl;
+      return false;
+      }
+    const Transform::VectorType translation =
+      calibrated.GetTranslation() - calibration.GetTranslation();
+    if( i == 0 )
+      {
+      rawTranslation = translation;
+      }
+    const Transform::VersorType rotation =
+      calibrated.GetRotation() * calibration.GetRotation().GetReciprocal();
+    if( ( translation - rawTranslation ).GetNorm() > 1e-6 ||
+        rotation.GetAngle() > 1e-6 ||
+        fabs( calibrated.GetError() - calibration.GetError() - 0.5 ) > 1e-6 )
+      {
+      std::cerr << "Wrong calibrated transform for tool " << i << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+/** Counts the events it observes */
+class EventCounter : public ::itk::Command
+{
+public:
+  typedef  EventCounter                 Self;
+  typedef  ::itk::Command               Superclass;
+  typedef  ::itk::SmartPointer<Self>    Pointer;
+  itkNewMacro( Self );
+
+  void Execute( itk::Object *caller, const itk::EventObject & event )
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+
+  void Execute( const itk::Object *itkNotUsed(caller),
+                const itk::EventObject & itkNotUsed(event) )
+    {
+    m_NumberOfEvents++;
+    }
+
+  unsigned int GetNumberOfEvents() const
+    {
+    return m_NumberOfEvents;
+    }
+
+protected:
+  EventCounter()
+    {
+    m_NumberOfEvents = 0;
+    }
+
+private:
+  unsigned int   m_NumberOfEvents;
+};
+
+/** Stops the tracking and detaches a tool the first time it is called */
+class ToolRemover : public ::itk::Command
+{
+public:
+  typedef  ToolRemover                  Self;
+  typedef  ::itk::Command               Superclass;
+  typedef  ::itk::SmartPointer<Self>    Pointer;
+  itkNewMacro( Self );
+
+  void SetTool( DummyTracker * tracker, DummyTrackerTool * tool )
+    {
+    m_Tracker = tracker;
+    m_Tool = tool;
+    }
+
+  void Execute( itk::Object *caller, const itk::EventObject & event )
+    {
+    const itk::Object * constCaller = caller;
+    this->Execute( constCaller, event );
+    }
+
+  void Execute( const itk::Object *itkNotUsed(caller),
+                const itk::EventObject & itkNotUsed(event) )
+    {
+    if( m_Tool )
+      {
+      m_Tracker->RequestStopTracking();
+      m_Tool->RequestDetachFromTracker();
+      m_Tool = NULL;
+      }
+    }
+
+protected:
+  ToolRemover()
+    {
+    m_Tracker = NULL;
+    m_Tool = NULL;
+    }
+
+private:
+  DummyTracker *       m_Tracker;
+  DummyTrackerTool *   m_Tool;
+};
+
 }
 
 }
@@ -304,6 +476,90 @@ int igstkTrackerTest( int, char * [] )
 
   trackerTool->RequestAttachToTracker( tracker );
 
+  // Several tools, with their own calibrations, updated together
+  typedef igstk::TrackerTest::CalibratedTransformObserver  ObserverType;
+  std::vector< TrackerToolType::Pointer > tools;
+  std::vector< ObserverType::Pointer > observers;
+  for( unsigned int i = 0; i < 4; i++ )
+    {
+    TrackerToolType::Pointer tool = TrackerToolType::New();
+    std::ostringstream identifier;
+    identifier << "tool" << i;
+    tool->SetIdentifier( identifier.str() );
+    tool->RequestConfigure();
+    tool->RequestAttachToTracker( tracker );
+
+    TransformType::VectorType translation;
+    translation[0] = 10.0 * i;
+    translation[1] = -5.0 * i;
+    translation[2] = 1.0;
+    TransformType::VersorType rotation;
+    rotation.SetRotationAroundZ( 0.1 * i );
+    TransformType calibration;
+    calibration.SetTranslationAndRotation( translation, rotation, 0.1 * i,
+      igstk::TimeStamp::GetLongestPossibleTime() );
+    tool->SetCalibrationTransform( calibration );
+
+    ObserverType::Pointer observer = ObserverType::New();
+    tool->AddObserver( igstk::CoordinateSystemTransformToEvent(), observer );
+
+    tools.push_back( tool );
+    observers.push_back( observer );
+    }
+
+  // Detaching a tool moves another one to its slot
+  for( unsigned int step = 0; step < 2; step++ )
+    {
+    tracker->RequestStartTracking();
+    const double start = igstk::RealTimeClock::GetTimeStamp();
+    while( igstk::RealTimeClock::GetTimeStamp() - start < 200.0 )
+      {
+      igstk::PulseGenerator::WaitForPulses( 10.0 );
+      }
+    tracker->RequestStopTracking();
+
+    if( !igstk::TrackerTest::CheckCalibratedTransforms( tools, observers ) )
+      {
+      return EXIT_FAILURE;
+      }
+    tools[1]->RequestDetachFromTracker();
+    tools.erase( tools.begin() + 1 );
+    observers.erase( observers.begin() + 1 );
+    }
+
+  // An observer of a tool stops the tracking and detaches the first tool,
+  // whose slot the last tool takes, while the transforms are reported.
+  // The last tool is still reported by that update.
+  typedef igstk::TrackerTest::EventCounter   CounterType;
+  typedef igstk::TrackerTest::ToolRemover    RemoverType;
+  CounterType::Pointer updateCounter = CounterType::New();
+  tracker->AddObserver( igstk::TrackerUpdateStatusEvent(), updateCounter );
+  RemoverType::Pointer remover = RemoverType::New();
+  remover->SetTool( tracker, trackerTool );
+  tools[0]->AddObserver( igstk::TrackerToolTransformUpdateEvent(), remover );
+
+  const unsigned int lastToolTransforms =
+    observers.back()->GetNumberOfTransforms();
+  tracker->RequestStartTracking();
+  const double removalStart = igstk::RealTimeClock::GetTimeStamp();
+  while( igstk::RealTimeClock::GetTimeStamp() - removalStart < 200.0 )
+    {
+    igstk::PulseGenerator::WaitForPulses( 10.0 );
+    }
+  tracker->RequestStopTracking();
+
+  if( updateCounter->GetNumberOfEvents() != 1 ||
+      observers.back()->GetNumberOfTransforms() != lastToolTransforms + 1 )
+    {
+    std::cerr << "A tool was skipped after the removal of another one"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !igstk::TrackerTest::CheckCalibratedTransforms( tools, observers ) )
+    {
+    return EXIT_FAILURE;
+    }
+
   tracker->RequestStartTracking();
   tracker->RequestStopTracking();
   tracker->RequestClose();
@@ -0,0 +1,194 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkTransformBatchTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "igstkTransformBatch.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace TransformBatchTest
+{
+
+typedef igstk::Transform              TransformType;
+typedef TransformType::VectorType     VectorType;
+typedef TransformType::VersorType     VersorType;
+
+/** Transforms spread over the rotations and translations */
+TransformType MakeTransform( unsigned int i )
+{
+  VectorType axis;
+  axis[0] = std::cos( 0.7 * i );
+  axis[1] = std::sin( 1.3 * i );
+  axis[2] = 0.5 + 0.1 * i;
+  axis.Normalize();
+
+  VersorType rotation;
+  rotation.Set( axis, 0.37 * i - 3.0 );
+
+  VectorType translation;
+  translation[0] = 10.0 * std::sin( 0.5 * i );
+  translation[1] = -3.0 * i;
+  translation[2] = 100.0 + i;
+
+  TransformType transform;
+  transform.SetTranslationAndRotation( translation, rotation, 0.1,
+    igstk::TimeStamp::GetLongestPossibleTime() );
+  return transform;
+}
+
+/** Largest difference between the components of a pose and a transform */
+double Difference( const igstk::Pose & pose, const TransformType & transform )
+{
+  igstk::Pose expected;
+  igstk::TransformBatch::ExportPose( transform, expected );
+  double difference = 0.0;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    difference = std::max( difference,
+      std::fabs( pose.m_Rotation[k] - expected.m_Rotation[k] ) );
+    }
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    difference = std::max( difference,
+      std::fabs( pose.m_Translation[k] - expected.m_Translation[k] ) );
+    }
+  return difference;
+}
+
+}
+
+int igstkTransformBatchTest( int , char* [] )
+{
+  typedef igstk::TransformBatch                   BatchType;
+  typedef TransformBatchTest::TransformType       TransformType;
+  typedef TransformType::VectorType               VectorType;
+
+  igstk::RealTimeClock::Initialize();
+
+  std::cout << "Instruction set: " << BatchType::GetInstructionSet()
+            << std::endl;
+
+  // A number of poses that is not a multiple of the vector sizes
+  const unsigned int numberOfPoses = 37;
+  const double tolerance = 1e-12;
+
+  std::vector< TransformType > left;
+  std::vector< TransformType > right;
+  std::vector< igstk::Pose > leftPoses( numberOfPoses );
+  std::vector< igstk::Pose > rightPoses( numberOfPoses );
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    left.push_back( TransformBatchTest::MakeTransform( i ) );
+    right.push_back( TransformBatchTest::MakeTransform( 2 * i + 1 ) );
+    BatchType::ExportPose( left[i], leftPoses[i] );
+    BatchType::ExportPose( right[i], rightPoses[i] );
+    }
+
+  // Composition of the pairs, in place of the right poses
+  std::vector< igstk::Pose > composed = rightPoses;
+  BatchType::Compose( &leftPoses[0], &composed[0], &composed[0],
+                      numberOfPoses );
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    const TransformType expected =
+      TransformType::TransformCompose( left[i], right[i] );
+    if( TransformBatchTest::Difference( composed[i], expected ) > tolerance )
+      {
+      std::cerr << "Wrong composition of the poses " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Composition with the same left pose
+  BatchType::Compose( leftPoses[5], &rightPoses[0], &composed[0],
+                      numberOfPoses );
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    const TransformType expected =
+      TransformType::TransformCompose( left[5], right[i] );
+    if( TransformBatchTest::Difference( composed[i], expected ) > tolerance )
+      {
+      std::cerr << "Wrong composition with the same pose " << i
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Inversion
+  std::vector< igstk::Pose > inverted( numberOfPoses );
+  BatchType::Invert( &leftPoses[0], &inverted[0], numberOfPoses );
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    if( TransformBatchTest::Difference( inverted[i],
+                                        left[i].GetInverse() ) > tolerance )
+      {
+      std::cerr << "Wrong inversion of the pose " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Points, transformed in place
+  std::vector< double > points( 3 * numberOfPoses );
+  for( unsigned int i = 0; i < points.size(); i++ )
+    {
+    points[i] = 0.5 * i - 20.0;
+    }
+  std::vector< double > transformed = points;
+  BatchType::TransformPoints( leftPoses[7], &transformed[0],
+                              &transformed[0], numberOfPoses );
+  for( unsigned int i = 0; i < numberOfPoses; i++ )
+    {
+    VectorType point;
+    point[0] = points[3 * i];
+    point[1] = points[3 * i + 1];
+    point[2] = points[3 * i + 2];
+    const VectorType expected =
+      left[7].GetRotation().Transform( point ) + left[7].GetTranslation();
+    for( unsigned int k = 0; k < 3; k++ )
+      {
+      if( std::fabs( transformed[3 * i + k] - expected[k] ) > tolerance )
+        {
+        std::cerr << "Wrong transformation of the point " << i << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Back to a transform, with the given error and time stamp
+  TransformType imported;
+  BatchType::ImportPose( leftPoses[3], 0.25, right[3].GetTimeStamp(),
+                         imported );
+  if( TransformBatchTest::Difference( leftPoses[3], imported ) != 0.0 ||
+      imported.GetError() != 0.25 ||
+      imported.GetStartTime() != right[3].GetStartTime() ||
+      imported.GetExpirationTime() != right[3].GetExpirationTime() )
+    {
+    std::cerr << "Wrong import of a pose" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "[PASSED]" << std::endl;
+
+  return EXIT_SUCCESS;
+}
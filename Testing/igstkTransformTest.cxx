@@ -118,6 +118,20 @@ int igstkTransformTest( int, char * [] )
       }
 
 
+    // Set with the validity period of a time stamp
+    igstk::TimeStamp timeStamp;
+    timeStamp.SetStartTimeAndExpireAfter( 1000.0, validityPeriod );
+    t1.SetTranslationAndRotation( translation, rotation, errorValue,
+                                  timeStamp );
+    if( t1.GetStartTime() != 1000.0 ||
+        t1.GetExpirationTime() != 1000.0 + validityPeriod ||
+        t1.GetError() != errorValue )
+      {
+      std::cerr << "Pair : SetTranslationAndRotation() with a time stamp "
+                << "failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+
     t1.SetRotation( rotation, errorValue, validityPeriod );
 
     translationSet = t1.GetTranslation();
@@ -91,6 +91,38 @@ int igstkUltrasoundImageSimulatorTest( int argc, char * argv[] )
   translation[2] = 1;
   usTransform.SetTranslation( translation, 0, 10000 );
 
+  usSimulator->RequestSetTransform(usTransform);
+
+  // Exercise the fixed intensity window, the fan mask, the attenuation and
+  // the speckle on a few slices
+  usSimulator->RequestSetIntensityWindow( 0.0, 1000.0 );
+  usSimulator->RequestSetFanMask( true, 60.0, 0.0 );
+  usSimulator->RequestSetAttenuationCoefficient( 0.01 );
+  usSimulator->RequestSetSpeckleAmount( 0.5 );
+  usSimulator->SetNumberOfThreads( 2 );
+
+  for( unsigned int i = 0; i < 5; i++ )
+    {
+    translation[2] = 1 + i;
+    usTransform.SetTranslation( translation, 0, 10000 );
+    usSimulator->RequestSetTransform(usTransform);
+    usSimulator->RequestReslice();
+    }
+
+  // Invalid parameters are ignored
+  usSimulator->RequestSetIntensityWindow( 1000.0, 0.0 );
+  usSimulator->RequestSetAttenuationCoefficient( -1.0 );
+  usSimulator->RequestSetSpeckleAmount( 2.0 );
+  usSimulator->RequestReslice();
+
+  // Back to the default simulation for the display
+  usSimulator->RequestSetAutomaticIntensityWindow();
+  usSimulator->RequestSetFanMask( false, 60.0, 0.0 );
+  usSimulator->RequestSetAttenuationCoefficient( 0.0 );
+  usSimulator->RequestSetSpeckleAmount( 0.0 );
+
+  translation[2] = 1;
+  usTransform.SetTranslation( translation, 0, 10000 );
   usSimulator->RequestSetTransform(usTransform);
   usSimulator->RequestReslice();
 
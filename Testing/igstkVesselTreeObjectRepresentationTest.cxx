@@ -0,0 +1,219 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkVesselTreeObjectRepresentationTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#if defined(_MSC_VER)
+//Warning about: identifier was truncated to '255' characters in the
+//debug information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#ifdef ConnectObjectToRepresentationMacro
+#undef ConnectObjectToRepresentationMacro
+#endif
+
+#define ConnectObjectToRepresentationMacro( object, representation ) \
+  representation->RequestSetGroupObject( object );
+
+
+#include "igstkGroupObject.h"
+#include "igstkTubeObject.h"
+#include "igstkVesselTreeObjectRepresentation.h"
+#include "igstkVesselTreeLODActor.h"
+#include "igstkSpatialObjectTestHelper.h"
+
+#include <vtkPolyDataMapper.h>
+#include <vtkPolyData.h>
+
+
+int igstkVesselTreeObjectRepresentationTest( int, char * [] )
+{
+
+  typedef igstk::GroupObject                         ObjectType;
+  typedef igstk::VesselTreeObjectRepresentation      RepresentationType;
+  typedef igstk::TubeObject                          TubeType;
+
+  typedef igstk::SpatialObjectTestHelper<
+    ObjectType, RepresentationType > TestHelperType;
+
+  TestHelperType  testHelper;
+
+  ObjectType         * object         = testHelper.GetSpatialObject();
+  RepresentationType * representation = testHelper.GetRepresentation();
+
+  //
+  // A tree of 20 branches of 11 points, the last ten branches in a
+  // sub-group translated along z
+  //
+  const unsigned int numberOfBranches = 20;
+  const unsigned int numberOfPoints = 11;
+
+  igstk::Transform identity;
+  igstk::Transform shift;
+  igstk::Transform::VectorType translation;
+  translation[0] = 0.0;
+  translation[1] = 0.0;
+  translation[2] = 50.0;
+  shift.SetTranslation( translation, 0.1,
+                        igstk::TimeStamp::GetLongestPossibleTime() );
+
+  ObjectType::Pointer subGroup = ObjectType::New();
+
+  std::vector< TubeType::Pointer > branches;
+  for( unsigned int b = 0; b < numberOfBranches; b++ )
+    {
+    TubeType::Pointer branch = TubeType::New();
+    for( unsigned int i = 0; i < numberOfPoints; i++ )
+      {
+      TubeType::PointType point;
+      point.SetPosition( b * 5.0, i * 2.0, 0.1 * i * i );
+      point.SetRadius( 1.0 + 0.1 * i );
+      branch->AddPoint( point );
+      }
+    // Duplicated points are ignored
+    TubeType::PointType last = *branch->GetPoint( numberOfPoints - 1 );
+    branch->AddPoint( last );
+
+    if( b < numberOfBranches / 2 )
+      {
+      object->RequestAddChild( identity, branch );
+      }
+    else
+      {
+      subGroup->RequestAddChild( identity, branch );
+      }
+    branches.push_back( branch );
+    }
+  object->RequestAddChild( shift, subGroup );
+
+  // A tube with a single point is not rendered, but keeps its index
+  TubeType::Pointer dot = TubeType::New();
+  TubeType::PointType dotPoint;
+  dotPoint.SetPosition( 0.0, 0.0, 0.0 );
+  dotPoint.SetRadius( 1.0 );
+  dot->AddPoint( dotPoint );
+  object->RequestAddChild( identity, dot );
+
+  representation->SetNumberOfSides( 2 );
+  if( representation->GetNumberOfSides() != 3 )
+    {
+    std::cerr << "SetNumberOfSides() accepted less than 3 sides"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  representation->SetNumberOfSides( 8 );
+
+  testHelper.TestRepresentationProperties();
+  testHelper.ExercisePrintSelf();
+  testHelper.TestTransform();
+
+  // This creates the actors
+  testHelper.ExerciseDisplay();
+
+  std::cout << "Testing the merged actor: ";
+  RepresentationType::ActorsListType actors = representation->GetActors();
+  if( actors.size() != 1 )
+    {
+    std::cerr << "Expected a single actor, got " << actors.size()
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  igstk::VesselTreeLODActor * actor =
+    igstk::VesselTreeLODActor::SafeDownCast( actors[0] );
+  if( !actor || actor->GetNumberOfLevelsOfDetail() != 3 )
+    {
+    std::cerr << "Expected an actor with three levels of detail"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( representation->GetNumberOfTubes() != numberOfBranches + 1 )
+    {
+    std::cerr << "Wrong number of tubes: "
+              << representation->GetNumberOfTubes() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Each branch has 10 rings of quadrilaterals and two caps
+  const vtkIdType cellsPerBranch = ( numberOfPoints - 1 ) * 8 + 2;
+  vtkPolyData * surface = vtkPolyData::SafeDownCast(
+    vtkPolyDataMapper::SafeDownCast( actor->GetMapper() )->GetInput() );
+  if( surface->GetNumberOfCells() != numberOfBranches * cellsPerBranch )
+    {
+    std::cerr << "Wrong number of cells: " << surface->GetNumberOfCells()
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "[PASSED]" << std::endl;
+
+  std::cout << "Testing picking: ";
+  for( unsigned int b = 0; b < numberOfBranches; b++ )
+    {
+    const int first = representation->GetTubeIndex( b * cellsPerBranch );
+    const int last =
+      representation->GetTubeIndex( ( b + 1 ) * cellsPerBranch - 1 );
+    if( first != static_cast< int >( b ) || last != first ||
+        representation->GetTube( first ) != branches[b].GetPointer() )
+      {
+      std::cerr << "Wrong tube for the cells of branch " << b << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if( representation->GetTubeIndex( -1 ) != -1 ||
+      representation->GetTubeIndex( surface->GetNumberOfCells() ) != -1 ||
+      representation->GetTube( numberOfBranches + 1 ) != NULL )
+    {
+    std::cerr << "Invalid cells were assigned a tube" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "[PASSED]" << std::endl;
+
+  std::cout << "Testing the levels of detail: ";
+  double bounds[6];
+  surface->GetBounds( bounds );
+  if( bounds[5] < 50.0 )
+    {
+    std::cerr << "The sub-group was not translated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cameras at 1, 3 and 100 diagonals from the center of the tree
+  const double * center = actor->GetCenter();
+  const double length = surface->GetLength();
+  const double distances[3] = { 1.0, 3.0, 100.0 };
+  for( unsigned int level = 0; level < 3; level++ )
+    {
+    const double camera[3] = { center[0], center[1],
+                               center[2] + distances[level] * length };
+    if( actor->SelectLevelOfDetail( camera ) != level )
+      {
+      std::cerr << "Wrong level of detail selected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::cout << "[PASSED]" << std::endl;
+
+  representation->SetColor( 0.9, 0.1, 0.1 );
+  representation->SetOpacity( 0.8 );
+
+  testHelper.TestRepresentationCopy();
+  testHelper.ExerciseScreenShot();
+
+  std::cout << "Test [DONE]" << std::endl;
+
+  return testHelper.GetFinalTestStatus();
+}
@@ -0,0 +1,329 @@
+/*=========================================================================
+
+  Program:   Image Guided Surgery Software Toolkit
+  Module:    igstkViewRefreshModeTest.cxx
+  Language:  C++
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) ISC  Insight Software Consortium.  All rights reserved.
+  See IGSTKCopyright.txt or http://www.igstk.org/copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// 
+//  The purpose of this test is to verify that a view skips the rendering of
+//  frames when nothing changed in the scene, and that it still renders the
+//  frames in which an object moved. It also exercises the frame timing
+//  report and its annotation.
+//
+//
+
+
+#if defined(_MSC_VER)
+// Warning about: identifier was truncated to '255' characters in the debug 
+// information (MVC6.0 Debug)
+#pragma warning( disable : 4786 )
+#endif
+
+#include <iostream>
+
+#include "igstkRealTimeClock.h"
+
+#include "igstkView3D.h"
+#include "igstkEvents.h"
+#include "igstkEllipsoidObject.h"
+#include "igstkEllipsoidObjectRepresentation.h"
+#include "igstkAxesObject.h"
+#include "igstkAnnotation2D.h"
+#include "igstkVTKLoggerOutput.h"
+#include "igstkLogger.h"
+#include "itkStdStreamLogOutput.h"
+#include "igstkFLTKWidget.h"
+
+namespace ViewRefreshModeTest
+{
+
+igstkObserverMacro( FrameTiming, ::igstk::ViewFrameTimingEvent,
+                    ::igstk::ViewFrameTimingType )
+  
+class ViewObserver : public ::itk::Command 
+{
+public:
+  typedef  ViewObserver               Self;
+  typedef  ::itk::Command             Superclass;
+  typedef  ::itk::SmartPointer<Self>  Pointer;
+  itkNewMacro( Self );
+
+protected:
+  ViewObserver() 
+    {
+    m_PulseCounter = 0;
+    m_NumberOfPulsesToStop = 10;
+    m_PulsesBetweenMotions = 10;
+    m_View = 0;
+    m_Object = 0;
+    m_Parent = 0;
+    m_End = 0;
+    }
+
+public:
+
+  void SetEndFlag( bool * end )
+    {
+    m_End = end;
+    }
+
+  void SetObjects( ::igstk::SpatialObject * object, 
+                   ::igstk::SpatialObject * parent )
+    {
+    m_Object = object;
+    m_Parent = parent;
+    }
+
+  void Execute(const itk::Object * itkNotUsed(caller), 
+               const itk::EventObject & itkNotUsed(event))
+    {
+    std::cerr << "Execute( const * ) should not be called" << std::endl;
+    }
+
+  void SetView( ::igstk::View * view )
+    {
+    m_View = view;
+    if( m_View )
+      {
+      m_View->AddObserver( ::igstk::RefreshEvent(), this );
+      }
+    }
+
+  void SetNumberOfPulsesToStop( unsigned long number )
+    {
+    m_NumberOfPulsesToStop = number;
+    m_PulseCounter = 0;
+    }
+
+  void Execute(itk::Object * itkNotUsed(caller), const itk::EventObject & event)
+    {
+    if( ::igstk::RefreshEvent().CheckEvent( &event ) )
+      {
+      m_PulseCounter++;
+
+      // Move the object every few pulses
+      if( m_PulseCounter % m_PulsesBetweenMotions == 0 )
+        {
+        ::igstk::Transform::VectorType translation;
+        translation[0] = m_PulseCounter % 7;
+        translation[1] = 0;
+        translation[2] = 0;
+
+        ::igstk::Transform transform;
+        transform.SetTranslation( translation, 0.1, 
+                          ::igstk::TimeStamp::GetLongestPossibleTime() );
+
+        m_Object->RequestSetTransformAndParent( transform, m_Parent );
+        }
+
+      if( m_PulseCounter >= m_NumberOfPulsesToStop )
+        {
+        *m_End = true;
+        }
+      }
+    }
+
+private:
+  unsigned long                 m_PulseCounter;
+  unsigned long                 m_NumberOfPulsesToStop;
+  unsigned long                 m_PulsesBetweenMotions;
+  ::igstk::View *               m_View;
+  ::igstk::SpatialObject *      m_Object;
+  ::igstk::SpatialObject *      m_Parent;
+  bool *                        m_End;
+};
+
+}
+
+int igstkViewRefreshModeTest( int argc, char *argv [] )
+{
+  igstk::RealTimeClock::Initialize();
+
+  typedef igstk::Object::LoggerType   LoggerType;
+  typedef itk::StdStreamLogOutput     LogOutputType;
+
+  LoggerType::Pointer   logger = LoggerType::New();
+  logger->SetPriorityLevel( itk::Logger::CRITICAL );
+
+  LogOutputType::Pointer logOutput = LogOutputType::New();
+
+  std::ofstream outputLogFile;
+  if( argc > 1 )
+    {
+    outputLogFile.open( argv[1] );
+    logOutput->SetStream( outputLogFile );
+    logger->AddLogOutput( logOutput );
+    }
+
+  igstk::VTKLoggerOutput::Pointer vtkLoggerOutput = 
+                                              igstk::VTKLoggerOutput::New();
+  vtkLoggerOutput->OverrideVTKWindow();
+  vtkLoggerOutput->SetLogger(logger);
+
+  typedef igstk::View3D  View3DType;
+
+  bool result = true;
+
+  try
+    {
+    igstk::AxesObject::Pointer worldReference = igstk::AxesObject::New();
+
+    igstk::EllipsoidObject::Pointer ellipsoid = igstk::EllipsoidObject::New();
+    ellipsoid->SetRadius(0.1,0.1,0.1);
+    
+    igstk::EllipsoidObjectRepresentation::Pointer ellipsoidRepresentation =
+                                igstk::EllipsoidObjectRepresentation::New();
+    ellipsoidRepresentation->RequestSetEllipsoidObject( ellipsoid );
+    ellipsoidRepresentation->SetColor(0.0,1.0,0.0);
+
+    View3DType::Pointer view3D = View3DType::New();
+    view3D->SetLogger( logger );
+
+    Fl_Window * form = new Fl_Window(301,301,"View Refresh Mode Test");
+    igstk::FLTKWidget * widget3D = 
+                      new igstk::FLTKWidget( 10,10,280,280,"3D View");
+    form->end();
+
+    widget3D->RequestSetView( view3D );
+    form->show();
+   
+    igstk::Transform identity;
+    identity.SetToIdentity( igstk::TimeStamp::GetLongestPossibleTime() );
+
+    ellipsoid->RequestSetTransformAndParent( identity, worldReference );
+    view3D->RequestSetTransformAndParent( identity, worldReference );
+
+    view3D->RequestAddObject( ellipsoidRepresentation );
+    view3D->RequestResetCamera();
+
+    // Display the frame timing in the lower left corner
+    igstk::Annotation2D::Pointer annotation = igstk::Annotation2D::New();
+    view3D->RequestAddAnnotation2D( annotation );
+    view3D->SetFrameTimingAnnotation( annotation, 0 );
+
+    typedef ViewRefreshModeTest::FrameTimingObserver FrameTimingObserverType;
+    FrameTimingObserverType::Pointer timingObserver = 
+                                              FrameTimingObserverType::New();
+    view3D->AddObserver( igstk::ViewFrameTimingEvent(), timingObserver );
+
+    bool bEnd = false;
+
+    typedef ViewRefreshModeTest::ViewObserver ObserverType;
+    ObserverType::Pointer viewObserver = ObserverType::New();
+    viewObserver->SetView( view3D );
+    viewObserver->SetObjects( ellipsoid, worldReference );
+    viewObserver->SetEndFlag( &bEnd );
+
+    const unsigned long numberOfPulses = 100;
+
+    //
+    // The object moves every 10 pulses, so most frames should be skipped,
+    // but at least one frame per motion should be rendered.
+    //
+    view3D->SetRefreshRate( 30 );
+    view3D->SetRefreshMode( View3DType::SkipUnchangedRefresh );
+    viewObserver->SetNumberOfPulsesToStop( numberOfPulses );
+
+    view3D->RequestStart();
+    Fl::check();
+    
+    while( !bEnd )
+      {
+      Fl::wait(0.001);
+      igstk::PulseGenerator::CheckTimeouts();
+      }
+
+    view3D->RequestStop();
+
+    const unsigned long rendered = view3D->GetNumberOfRenderedFrames();
+    const unsigned long skipped  = view3D->GetNumberOfSkippedFrames();
+
+    std::cout << "Rendered frames = " << rendered << std::endl;
+    std::cout << "Skipped  frames = " << skipped  << std::endl;
+
+    if( skipped < numberOfPulses / 2 )
+      {
+      std::cerr << "Too few frames were skipped" << std::endl;
+      result = false;
+      }
+
+    if( rendered < numberOfPulses / 20 )
+      {
+      std::cerr << "Frames with motion were not rendered" << std::endl;
+      result = false;
+      }
+
+    //
+    // Exercise the adaptive mode
+    //
+    bEnd = false;
+    view3D->SetRefreshMode( View3DType::AdaptiveRefresh );
+    view3D->SetMinimumRefreshRate( 10 );
+    viewObserver->SetNumberOfPulsesToStop( numberOfPulses );
+
+    view3D->RequestStart();
+    
+    while( !bEnd )
+      {
+      Fl::wait(0.001);
+      igstk::PulseGenerator::CheckTimeouts();
+      }
+
+    view3D->RequestStop();
+
+    if( view3D->GetNumberOfSkippedFrames() <= skipped )
+      {
+      std::cerr << "No frames were skipped in adaptive mode" << std::endl;
+      result = false;
+      }
+
+    if( !timingObserver->GotFrameTiming() )
+      {
+      std::cerr << "No frame timing was reported" << std::endl;
+      result = false;
+      }
+    else
+      {
+      igstk::ViewFrameTimingType timing = timingObserver->GetFrameTiming();
+      std::cout << "Last update time = " << timing.UpdateTime << std::endl;
+      if( timing.UpdateTime < 0.0 || timing.RenderTime < 0.0 )
+        {
+        std::cerr << "Invalid frame timing" << std::endl;
+        result = false;
+        }
+      }
+
+    //purely for code coverage.
+    view3D->Print( std::cout );
+
+    delete widget3D;
+    delete form;
+    }
+  catch(...)
+    {
+    std::cerr << "Exception catched !!" << std::endl;
+    result = false;
+    }
+
+  if( !result )
+    {
+    return EXIT_FAILURE;
+    }
+
+  if( vtkLoggerOutput->GetNumberOfErrorMessages()  > 0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}